@@ -8,7 +8,6 @@
 #include <World/SceneObject.h>
 #include <World/Body.h>
 #include <World/Terrain.h>
-#include <Common/TimeCounter.h>
 
 using namespace World;
 using namespace Math;
@@ -43,18 +42,23 @@ void Actor::updatePosition()
 	quat dirRotation = quat().fromAxisAngle( vec3::AxisY(), mOrientAroundY );
 
 	vec3 pos = mSceneObject->getLocalPosition();
-	pos.y = World::Terrain::GetMain()->height( pos.x, pos.z );
 
 	vec3 lSize = mSize * 0.94f;//magic number (TODO: make member variable)
 
 	vec3 pos0 = pos - (vec3( lSize.x, 0, lSize.z ) * 0.5f);
-	pos0.y = World::Terrain::GetMain()->height( pos0.x, pos0.z );
-
 	vec3 posX = pos0 + vec3(lSize.x, 0, 0);
 	vec3 posZ = pos0 + vec3(0, 0, lSize.z);
 
-	posX.y = World::Terrain::GetMain()->height( posX.x, posX.z );
-	posZ.y = World::Terrain::GetMain()->height( posZ.x, posZ.z );
+	//sample all heights in one query
+	vec2 points[4] = { vec2(pos.x, pos.z), vec2(pos0.x, pos0.z), vec2(posX.x, posX.z), vec2(posZ.x, posZ.z) };
+	float heights[4];
+
+	World::Terrain::GetMain()->getQuery()->sampleHeights( points, 4, heights );
+
+	pos.y	= heights[0];
+	pos0.y	= heights[1];
+	posX.y	= heights[2];
+	posZ.y	= heights[3];
 	
 	//a la "tangent basis"
 	vec3 dirX = (posX - pos0).normalized();
@@ -69,14 +73,14 @@ void Actor::updatePosition()
 
 void Actor::turn(bool left)
 {
-	float deltaTime = TimeCounter::Instance().getDeltaTime();
+	float deltaTime = getDeltaTime();
 	mTurning = true;
 	mOrientAroundY += deltaTime * (left ? turnSpeed : -turnSpeed);
 }
 
 void Actor::move(bool forward, bool run)
 {
-	float deltaTime = TimeCounter::Instance().getDeltaTime();
+	float deltaTime = getDeltaTime();
 	vec3 pos = mSceneObject->getLocalPosition();
 	mMoving = true;
 	pos += mForwardDirection * deltaTime * (forward ? moveSpeed : -moveSpeed);
@@ -10,6 +10,9 @@ Automated::Automated()
 {
 	SQREFL_SET_CLASS(Automated);
 
+	//far away or unseen AI thinks at 5 Hz
+	mUpdateRate = UpdateRate(0, 300.0f, 0.2f, 0.2f);
+
 }
 
 Automated::~Automated()
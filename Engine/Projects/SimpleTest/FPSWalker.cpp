@@ -6,7 +6,7 @@
 #include <Common/Data.h>
 #include <Common/Input.h>
 #include <World/SceneObject.h>
-#include <World/Terrain.h>
+#include <World/CollisionWorld.h>
 #include <Common/TimeCounter.h>
 
 using namespace Math;
@@ -21,6 +21,7 @@ FPSWalker::FPSWalker()
 	mSpeed			= 5.5f;
 	mMouseSensivity	= 1;
 	mHeight			= 2.0f;
+	mRadius			= 0.4f;
 
 	mVelocity = Math::vec3(0, 0, 0);
 }
@@ -57,6 +58,8 @@ void FPSWalker::update()
 		}
 	}
 
+	vec3 startPos = mCamera->getPosition();
+
 	float step = mSpeed * deltaTime;
 	if(Input::Get()->isKeyPressed( Input::LShift ))
 	{
@@ -92,8 +95,8 @@ void FPSWalker::update()
 		if(mGunSound)
 		{
 			mGunSound->setLocalPosition( vec3(0, -0.2, 0) );
-			if(mGunSound->getSource()->getState() != Audio::ISource::PLAYING)
-				mGunSound->getSource()->play();
+			if(!mGunSound->isPlaying())
+				mGunSound->play();
 		}
 		if(mGunParticles)
 		{
@@ -105,7 +108,7 @@ void FPSWalker::update()
 	else
 	{
 		if(mGunSound)
-			mGunSound->getSource()->stop();
+			mGunSound->stop();
 		if(mGunParticles)
 			mGunParticles->setEmit(false);
 	}
@@ -114,13 +117,22 @@ void FPSWalker::update()
 
 	if(mVelocity.y < -100) mVelocity.y = -100;
 
-	vec3 pos = mCamera->getPosition();
-	pos += mVelocity * deltaTime;
+	//walk by camera movement and fall by velocity, sliding along terrain and bodies
+	vec3 displacement = mCamera->getPosition() + mVelocity * deltaTime - startPos;
+	vec3 pos = startPos + displacement;
+
+	World::CollisionWorld * collisions = mSceneObject->getCollisionWorld();
+	if(collisions != NULL)
+	{
+		World::CollisionCapsule capsule(startPos - vec3(0, mHeight - mRadius, 0), startPos - vec3(0, mRadius, 0), mRadius);
+
+		bool grounded = false;
+		pos = startPos + collisions->moveCapsule(capsule, displacement, mSceneObject, &grounded);
+
+		if(grounded && mVelocity.y < 0)
+			mVelocity.y = 0;
+	}
 
-	//correct y-pos
-	float minHeight = World::Terrain::GetMain()->height( pos.x, pos.z ) + mHeight;
-	if(pos.y < minHeight)
-		pos.y = minHeight;
 	mCamera->setPosition(pos);
 	
 	mSceneObject->setLocalPosition(pos);
@@ -129,6 +141,13 @@ void FPSWalker::update()
 void FPSWalker::awake()
 {
 	mPrevMouse = Input::Get()->getMousePos();
+
+	//capsule hangs under camera which is placed at object position
+	if(World::CollisionWorld::Active() != NULL)
+	{
+		World::COLLIDER_PTR collider(new World::CapsuleCollider(mRadius, mHeight, vec3(0, -mHeight * 0.5f, 0)));
+		World::CollisionWorld::Active()->addObject(mSceneObject, collider);
+	}
 }
 
 void FPSWalker::initGun(const char_t * bulletTexture, const char_t * bulletSound)
@@ -20,7 +20,8 @@ class FPSWalker : public World::Behaviour
 	float mSpeed;
 	float mMouseSensivity;
 
-	float mHeight;
+	float mHeight;//of eyes above feet
+	float mRadius;
 
 	tuple2i mPrevMouse; 
 
@@ -0,0 +1,92 @@
+#include <Resource/AssetCooker.h>
+#include <FileSystem/FileStorageFactory.h>
+#include <Common/Log.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace Squirrel;
+
+//Headless cooking of shaders and images of resources folder:
+//SqAssetCooker <resources folder> <cache folder> [-full] [-nomips] [location ...]
+//Models need render to create buffers, so they are cooked by applications with ModelCooker.
+
+namespace {
+
+const char_t * IMAGE_EXTENSIONS[] = { "jpg", "jpeg", "png", "tga", "tif", "tiff", "bmp", "dds" };
+
+void PrintUsage()
+{
+	printf("Usage: SqAssetCooker <resources folder> <cache folder> [-full] [-nomips] [location ...]\n");
+	printf("  -full      check content hash of every source, not only of modified ones\n");
+	printf("  -nomips    do not build mipmaps of images\n");
+	printf("  location   folder of resources to cook, whole resources folder by default\n");
+}
+
+}//namespace {
+
+int main(int argc, char ** argv)
+{
+	if(argc < 3)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Log::Instance().init("AssetCooker.log", Log::sevInformation);
+
+	bool incremental = true;
+	bool buildMipmaps = true;
+	std::vector<std::string> locations;
+
+	for(int i = 3; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "-full") == 0)
+			incremental = false;
+		else if(strcmp(argv[i], "-nomips") == 0)
+			buildMipmaps = false;
+		else
+			locations.push_back(argv[i]);
+	}
+
+	if(locations.empty())
+		locations.push_back("");
+
+	std::auto_ptr<FileSystem::FileStorage> sourceStorage( FileSystem::FileStorageFactory::GetFolderForPath(argv[1]) );
+
+	Resource::AssetCooker cooker(sourceStorage.get(), argv[2]);
+	cooker.setIncremental(incremental);
+
+	cooker.addCooker("glsl", new Resource::ShaderCooker(sourceStorage.get()));
+
+	for(size_t i = 0; i < sizeof(IMAGE_EXTENSIONS) / sizeof(IMAGE_EXTENSIONS[0]); ++i)
+	{
+		cooker.addCooker(IMAGE_EXTENSIONS[i], new Resource::ImageCooker(buildMipmaps));
+	}
+
+	for(size_t i = 0; i < locations.size(); ++i)
+	{
+		cooker.addSources(locations[i].c_str(), true);
+	}
+
+	Resource::AssetCooker::Report report;
+	bool isOk = cooker.build(report);
+
+	report.log();
+	Log::Instance().finish();
+
+	for(size_t i = 0; i < report.assets.size(); ++i)
+	{
+		const Resource::AssetCooker::AssetReport& asset = report.assets[i];
+
+		if(asset.status == Resource::AssetCooker::asFailed)
+			printf("FAILED   %s: %s\n", asset.sourceFile.c_str(), asset.error.c_str());
+		else if(asset.status == Resource::AssetCooker::asCooked)
+			printf("cooked   %s -> %s (%.2f ms)\n", asset.sourceFile.c_str(), asset.cookedFile.c_str(), asset.ms);
+	}
+
+	printf("%d assets in %.2f ms: %d up to date, %d cache hits, %d cooked, %d failed; hit rate %.1f%%\n",
+		(int)report.assets.size(), report.totalMs, report.upToDateNum, report.cacheHitsNum,
+		report.cookedNum, report.failedNum, report.getHitRate() * 100.0f);
+
+	return isOk ? 0 : 2;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <Common/types.h>
+#include <chrono>
+
+namespace Benchmark {
+
+//wall clock stopwatch with sub millisecond precision
+class Timer
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+public:
+	Timer(): mStart(Clock::now()) {}
+
+	void restart() { mStart = Clock::now(); }
+
+	double getMs() const { return std::chrono::duration<double, std::milli>(Clock::now() - mStart).count(); }
+
+private:
+	Clock::time_point mStart;
+};
+
+//every benchmark prints its own report and returns false if results are wrong
+bool RunParticles();
+bool RunMesh();
+bool RunHeightMap();
+bool RunTerrainQuery();
+bool RunCollision();
+bool RunShadows();
+
+}//namespace Benchmark {
@@ -0,0 +1,232 @@
+#include "Benchmark.h"
+#include <World/CollisionWorld.h>
+#include <World/MeshCollider.h>
+#include <World/SceneObject.h>
+#include <World/Terrain.h>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace Squirrel;
+using namespace Squirrel::World;
+
+//5k spheres and capsules moving over generated terrain between static boxes with mesh colliders:
+//time of collision world update with broadphase pairs and contacts it finds;
+//primitive contacts of last frame are checked against brute force test of all pairs.
+
+namespace Benchmark {
+
+namespace {
+
+const int BODIES_NUM		= 5000;
+const int BOXES_NUM			= 100;
+const int FRAMES_NUM		= 120;
+const float AREA_SIZE		= 120.0f;
+const float FRAME_TIME		= 1.0f / 60.0f;
+
+float RandomRange(float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / (float)RAND_MAX);
+}
+
+struct MovingBody
+{
+	SceneObject *	object;
+	vec3			position;
+	vec3			velocity;
+};
+
+//unit cube triangles shared by all boxes
+COLLIDER_PTR CreateBoxCollider()
+{
+	vec3 corners[8];
+	for(int i = 0; i < 8; ++i)
+		corners[i] = vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+
+	const uint32 indices[36] = {
+		0, 2, 1,  1, 2, 3,//-z
+		4, 5, 6,  5, 7, 6,//+z
+		0, 1, 4,  1, 5, 4,//-y
+		2, 6, 3,  3, 6, 7,//+y
+		0, 4, 2,  2, 4, 6,//-x
+		1, 3, 5,  3, 7, 5,//+x
+	};
+
+	MeshCollider * collider = new MeshCollider();
+	collider->build(corners, 8, indices, 36);
+	return COLLIDER_PTR(collider);
+}
+
+float GroundHeight(Terrain * terrain, float x, float z)
+{
+	float height = 0;
+	terrain->getQuery()->height(x, z, height);
+	return height;
+}
+
+//number of overlapping primitive pairs found by testing every pair
+int CountOverlapsBruteForce(CollisionWorld * collisions, const std::vector<MovingBody>& bodies)
+{
+	std::vector<CollisionCapsule> capsules(bodies.size());
+	for(size_t i = 0; i < bodies.size(); ++i)
+		capsules[i] = collisions->getCollider(bodies[i].object)->getCapsule(bodies[i].object->getTransform());
+
+	int overlapsNum = 0;
+	CollisionContact contact;
+
+	for(size_t i = 0; i < capsules.size(); ++i)
+	{
+		for(size_t j = i + 1; j < capsules.size(); ++j)
+		{
+			if(Collider::CapsuleVsCapsule(capsules[i], capsules[j], contact))
+				++overlapsNum;
+		}
+	}
+
+	return overlapsNum;
+}
+
+}//namespace {
+
+bool RunCollision()
+{
+	srand(1);
+
+	Terrain terrain;
+	terrain.initGenerated(3, 128.0f, 128, vec3(40, 20, 40), 7);
+
+	CollisionWorld collisions;
+	collisions.setTerrain(&terrain);
+
+	TransformHierarchy * transforms = TransformHierarchy::Active();
+
+	//static boxes
+
+	COLLIDER_PTR boxCollider = CreateBoxCollider();
+	std::vector<SceneObject *> boxes(BOXES_NUM);
+
+	for(int i = 0; i < BOXES_NUM; ++i)
+	{
+		float x = RandomRange(-AREA_SIZE * 0.5f, AREA_SIZE * 0.5f);
+		float z = RandomRange(-AREA_SIZE * 0.5f, AREA_SIZE * 0.5f);
+
+		boxes[i] = new SceneObject();
+		boxes[i]->setLocalPosition(vec3(x, GroundHeight(&terrain, x, z) + 1.0f, z));
+		boxes[i]->setLocalScale(vec3(2, 2, 2));
+		collisions.addObject(boxes[i], boxCollider);
+	}
+
+	//moving spheres and capsules above ground
+
+	std::vector<MovingBody> bodies(BODIES_NUM);
+
+	for(int i = 0; i < BODIES_NUM; ++i)
+	{
+		MovingBody& body = bodies[i];
+
+		float x = RandomRange(-AREA_SIZE * 0.5f, AREA_SIZE * 0.5f);
+		float z = RandomRange(-AREA_SIZE * 0.5f, AREA_SIZE * 0.5f);
+
+		body.object		= new SceneObject();
+		body.position	= vec3(x, GroundHeight(&terrain, x, z) + RandomRange(0.0f, 3.0f), z);
+		body.velocity	= vec3(RandomRange(-3.0f, 3.0f), RandomRange(-0.5f, 0.5f), RandomRange(-3.0f, 3.0f));
+
+		Collider * collider = (i % 2) ?
+			(Collider *)new SphereCollider(RandomRange(0.3f, 0.8f)) :
+			(Collider *)new CapsuleCollider(0.4f, RandomRange(1.0f, 2.0f));
+
+		body.object->setLocalPosition(body.position);
+		collisions.addObject(body.object, COLLIDER_PTR(collider));
+	}
+
+	transforms->update();
+
+	printf("Collision: %d moving spheres and capsules, %d static boxes, %d frames over %.0fx%.0f area\n",
+		BODIES_NUM, BOXES_NUM, FRAMES_NUM, AREA_SIZE, AREA_SIZE);
+
+	double updateMs = 0;
+	double maxUpdateMs = 0;
+	int64 pairsNum = 0;
+	int64 contactsNum = 0;
+	int64 movedNum = 0;
+	int64 trianglesNum = 0;
+
+	int primitiveContactsNum = 0;
+	int meshContactsNum = 0;
+	int terrainContactsNum = 0;
+
+	for(int frame = 0; frame < FRAMES_NUM; ++frame)
+	{
+		//bodies move within area staying close to ground
+
+		for(int i = 0; i < BODIES_NUM; ++i)
+		{
+			MovingBody& body = bodies[i];
+			body.position += body.velocity * FRAME_TIME;
+
+			for(int axis = 0; axis < 3; axis += 2)
+			{
+				if(fabsf(body.position[axis]) > AREA_SIZE * 0.5f)
+					body.velocity[axis] = -body.velocity[axis];
+			}
+
+			float height = GroundHeight(&terrain, body.position.x, body.position.z);
+			if(body.position.y < height || body.position.y > height + 3.0f)
+				body.velocity.y = -body.velocity.y;
+
+			body.object->setLocalPosition(body.position);
+		}
+
+		transforms->update();
+
+		Timer timer;
+		collisions.update();
+		double ms = timer.getMs();
+
+		updateMs += ms;
+		maxUpdateMs = Math::maxValue(maxUpdateMs, ms);
+
+		const CollisionWorld::Stats& stats = collisions.getStats();
+		pairsNum		+= stats.mBroadphasePairsNum;
+		contactsNum		+= stats.mContactsNum;
+		movedNum		+= stats.mMovedProxiesNum;
+		trianglesNum	+= stats.mTrianglesTestedNum;
+	}
+
+	//contacts of last frame by kind of second object
+
+	const CollisionWorld::CONTACTS_LIST& contacts = collisions.getContacts();
+	for(size_t i = 0; i < contacts.size(); ++i)
+	{
+		if(contacts[i].objectB == NULL)
+			++terrainContactsNum;
+		else if(collisions.getCollider(contacts[i].objectB)->isPrimitive())
+			++primitiveContactsNum;
+		else
+			++meshContactsNum;
+	}
+
+	Timer timer;
+	int overlapsNum = CountOverlapsBruteForce(&collisions, bodies);
+	double bruteForceMs = timer.getMs();
+
+	printf("  update: %.2f ms average, %.2f ms max\n", updateMs / FRAMES_NUM, maxUpdateMs);
+	printf("  per frame: %d broadphase pairs, %d contacts, %d moved proxies, %d triangles tested\n",
+		(int)(pairsNum / FRAMES_NUM), (int)(contactsNum / FRAMES_NUM), (int)(movedNum / FRAMES_NUM), (int)(trianglesNum / FRAMES_NUM));
+	printf("  last frame contacts: %d primitive, %d mesh, %d terrain\n", primitiveContactsNum, meshContactsNum, terrainContactsNum);
+	printf("  brute force primitive pairs: %d overlaps in %.1f ms\n", overlapsNum, bruteForceMs);
+
+	bool isOk = overlapsNum == primitiveContactsNum && meshContactsNum > 0 && terrainContactsNum > 0;
+
+	printf("  %s\n", isOk ? "results are correct" : "RESULTS ARE WRONG");
+
+	for(int i = 0; i < BODIES_NUM; ++i)
+		DELETE_PTR(bodies[i].object);
+	for(int i = 0; i < BOXES_NUM; ++i)
+		DELETE_PTR(boxes[i]);
+
+	return isOk;
+}
+
+}//namespace Benchmark {
@@ -0,0 +1,169 @@
+#include "Benchmark.h"
+#include <World/HeightMapCodec.h>
+#include <Math/PerlinNoise.h>
+#include <stdio.h>
+#include <math.h>
+
+using namespace Squirrel;
+using namespace Squirrel::World;
+
+//Terrain tiles in raw format (HeightMap::save) against compressed one (HeightMapCodec):
+//size on disk and load time of tiles which are already mapped, both including bounds pyramid
+//as terrain workers build it; raw tiles are timed both copied and mapped in place.
+
+namespace Benchmark {
+
+namespace {
+
+const int TILES_NUM		= 16;
+const int RUNS_NUM		= 5;
+
+//"Cells Per Node" of terrain is 128 by default
+const int TILE_SIZES[]	= { 129, 257 };
+
+void FillTile(HeightMap * hm, int tileIndex, Math::PerlinNoise& noise)
+{
+	tuple2i res = hm->getResolution();
+
+	hm->clear();
+
+	for(int j = 0; j < res.y; ++j)
+	{
+		for(int i = 0; i < res.x; ++i)
+		{
+			float x = (float)(i + tileIndex * (res.x - 1));
+			float z = (float)j;
+			hm->heightRef(i, j) = noise.perlinNoise2D(x / 40.0f, z / 40.0f, 3.1f) * 120.0f + 30.0f * sinf(x * 0.01f);
+		}
+	}
+
+	hm->updateNormals();
+}
+
+bool ArePyramidsEqual(const HeightMapPyramid * a, const HeightMapPyramid * b)
+{
+	if(a->getLevelsNum() != b->getLevelsNum())
+		return false;
+
+	for(int level = 0; level < a->getLevelsNum(); ++level)
+	{
+		tuple2i size = a->getLevelSize(level);
+		if(size.x != b->getLevelSize(level).x || size.y != b->getLevelSize(level).y)
+			return false;
+
+		for(int z = 0; z < size.y; ++z)
+		{
+			for(int x = 0; x < size.x; ++x)
+			{
+				if(a->getMin(level, x, z) != b->getMin(level, x, z) || a->getMax(level, x, z) != b->getMax(level, x, z))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool RunTileSize(int tileSize)
+{
+	Math::PerlinNoise noise;
+
+	size_t rawBytes = 0;
+	size_t compressedBytes = 0;
+	double rawMs = 0;
+	double mappedMs = 0;
+	double compressedMs = 0;
+	float maxError = 0;
+	float maxStep = 0;
+	int wrongPyramidsNum = 0;
+
+	for(int t = 0; t < TILES_NUM; ++t)
+	{
+		HeightMap hm(tileSize, tileSize);
+		FillTile(&hm, t, noise);
+
+		Data * raw = hm.save();
+		Data * compressed = HeightMapCodec::Save(&hm);
+
+		rawBytes += raw->getLength();
+		compressedBytes += compressed->getLength();
+
+		for(int r = 0; r < RUNS_NUM; ++r)
+		{
+			raw->seekAbs(0);
+			Timer timer;
+			HeightMap * rawHM = HeightMap::Load(raw);
+			rawHM->getPyramid();
+			rawMs += timer.getMs();
+
+			raw->seekAbs(0);
+			timer.restart();
+			HeightMap * mappedHM = HeightMap::LoadMapped(raw, false);
+			mappedHM->getPyramid();
+			mappedMs += timer.getMs();
+
+			compressed->seekAbs(0);
+			timer.restart();
+			HeightMap * compressedHM = HeightMapCodec::Load(compressed);
+			compressedHM->getPyramid();
+			compressedMs += timer.getMs();
+
+			if(r == 0)
+			{
+				//quantization is the only loss
+				for(int j = 0; j < tileSize; ++j)
+				{
+					for(int i = 0; i < tileSize; ++i)
+						maxError = Math::maxValue(maxError, fabsf(rawHM->height(i, j) - compressedHM->height(i, j)));
+				}
+
+				compressed->seekAbs(0);
+				CompressedHeightMapHeader header;
+				compressed->readBytes(&header, sizeof(header));
+				maxStep = Math::maxValue(maxStep, header.heightStep);
+
+				//stored levels are the same as ones built from decoded heights
+				HeightMapPyramid built;
+				built.build(compressedHM);
+				if(!ArePyramidsEqual(&built, compressedHM->getPyramid()))
+					++wrongPyramidsNum;
+			}
+
+			DELETE_PTR(rawHM);
+			DELETE_PTR(mappedHM);
+			DELETE_PTR(compressedHM);
+		}
+
+		DELETE_PTR(raw);
+		DELETE_PTR(compressed);
+	}
+
+	const int loadsNum = TILES_NUM * RUNS_NUM;
+
+	printf("  %dx%d tiles:\n", tileSize, tileSize);
+	printf("    raw:        %7.1f KB, load %.3f ms, mapped %.3f ms\n", rawBytes / 1024.0 / TILES_NUM, rawMs / loadsNum, mappedMs / loadsNum);
+	printf("    compressed: %7.1f KB (%.1f%%), load %.3f ms\n", compressedBytes / 1024.0 / TILES_NUM,
+		100.0 * compressedBytes / rawBytes, compressedMs / loadsNum);
+	printf("    max height error %.5f (quantization step %.5f), wrong pyramids %d\n", maxError, maxStep, wrongPyramidsNum);
+
+	return maxError <= maxStep && wrongPyramidsNum == 0;
+}
+
+}//namespace {
+
+bool RunHeightMap()
+{
+	printf("HeightMap: %d Perlin noise tiles of each size, load time is average of %d runs\n", TILES_NUM, RUNS_NUM);
+
+	bool isOk = true;
+	for(size_t i = 0; i < sizeof(TILE_SIZES) / sizeof(TILE_SIZES[0]); ++i)
+	{
+		isOk = RunTileSize(TILE_SIZES[i]) && isOk;
+	}
+
+	printf("  %s\n", isOk ? "results are correct" : "RESULTS ARE WRONG");
+
+	return isOk;
+}
+
+}//namespace Benchmark {
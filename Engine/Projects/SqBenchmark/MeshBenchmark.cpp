@@ -0,0 +1,271 @@
+#include "Benchmark.h"
+#include <Resource/MeshProcessing.h>
+#include <Math/GeometryTools.h>
+#include <Common/TaskPool.h>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+using namespace Squirrel;
+using namespace Squirrel::Resource;
+using namespace Squirrel::Math;
+
+//Normals and tangents generation of 1M triangles grid, serial and parallel,
+//and tangents of 20k triangles grid against per vertex rescan of all faces Mesh used before.
+
+namespace Benchmark {
+
+namespace {
+
+const int BIG_GRID_SIZE		= 708;//999,698 triangles
+const int SMALL_GRID_SIZE	= 101;//20,000 triangles
+const int CHECK_GRID_SIZE	= 64;
+const int RUNS_NUM			= 5;
+const float GRID_STEP		= 0.1f;
+
+const int GRID_VERT_TYPE = VCI2VT(VertexBuffer::vcPosition) | VCI2VT(VertexBuffer::vcNormal) |
+	VCI2VT(VertexBuffer::vcTexcoord) | VCI2VT(VertexBuffer::vcTangentBinormal);
+
+//buffers which live in CPU memory only, no render is needed
+class CPUVertexBuffer:
+	public VertexBuffer
+{
+public:
+	CPUVertexBuffer(int vertType, size_t vertsNum): VertexBuffer(vertType, vertsNum, NULL) {}
+
+	virtual bool map(bool, bool) { return true; }
+	virtual void unmap() {}
+	virtual void update(int, int) {}
+};
+
+class CPUIndexBuffer:
+	public IndexBuffer
+{
+public:
+	CPUIndexBuffer(uint indicesNum, IndexSize indexSize): IndexBuffer(indicesNum, indexSize) {}
+
+	virtual bool map(bool, bool) { return true; }
+	virtual void unmap() {}
+	virtual void update(int, int) {}
+};
+
+float GridHeight(float x, float z)
+{
+	return sinf(x) * cosf(z);
+}
+
+//size x size vertices of height field, texture mapping is mirrored along x optionally
+void CreateGrid(int size, bool mirror, IndexBuffer::IndexSize indexSize, VertexBuffer *& outVB, IndexBuffer *& outIB)
+{
+	outVB = new CPUVertexBuffer(GRID_VERT_TYPE, size * size);
+	outIB = new CPUIndexBuffer((size - 1) * (size - 1) * 6, indexSize);
+
+	for(int z = 0; z < size; ++z)
+	{
+		for(int x = 0; x < size; ++x)
+		{
+			float fx = x * GRID_STEP;
+			float fz = z * GRID_STEP;
+			outVB->setComponent<VertexBuffer::vcPosition>(z * size + x, vec3(fx, GridHeight(fx, fz), fz));
+			outVB->setComponent<VertexBuffer::vcTexcoord>(z * size + x, vec2(mirror ? -fx : fx, fz));
+		}
+	}
+
+	int index = 0;
+	for(int z = 0; z < size - 1; ++z)
+	{
+		for(int x = 0; x < size - 1; ++x)
+		{
+			uint32 a = z * size + x;
+			uint32 b = a + 1;
+			uint32 c = a + size;
+			uint32 d = c + 1;
+			uint32 quad[6] = { a, c, b, b, c, d };
+			for(int i = 0; i < 6; ++i)
+				outIB->setIndex(index++, quad[i]);
+		}
+	}
+}
+
+//tangent basis as Mesh::calcTangentBasis computed it before MeshProcessing
+void CalcTangentsByRescan(IndexBuffer * ib, VertexBuffer * vb)
+{
+	const int facesNum = ib->getIndicesNum() / 3;
+
+	std::vector<vec3> tangents(facesNum);
+	std::vector<vec3> binormals(facesNum);
+
+	for(int i = 0; i < facesNum; ++i)
+	{
+		uint32 i0 = ib->getIndex(i * 3 + 0);
+		uint32 i1 = ib->getIndex(i * 3 + 1);
+		uint32 i2 = ib->getIndex(i * 3 + 2);
+
+		calcTriangleTangentBasis(
+			vb->getComponent<VertexBuffer::vcPosition>(i0), vb->getComponent<VertexBuffer::vcPosition>(i1), vb->getComponent<VertexBuffer::vcPosition>(i2),
+			vb->getComponent<VertexBuffer::vcTexcoord>(i0), vb->getComponent<VertexBuffer::vcTexcoord>(i1), vb->getComponent<VertexBuffer::vcTexcoord>(i2),
+			tangents[i], binormals[i]);
+	}
+
+	for(int i = 0; i < (int)vb->getVertsNum(); ++i)
+	{
+		vec3 tangent(0, 0, 0);
+		vec3 binormal(0, 0, 0);
+
+		for(int j = 0; j < facesNum; ++j)
+		{
+			if(ib->getIndex(j * 3 + 0) == (uint32)i || ib->getIndex(j * 3 + 1) == (uint32)i || ib->getIndex(j * 3 + 2) == (uint32)i)
+			{
+				tangent += tangents[j];
+				binormal += binormals[j];
+			}
+		}
+
+		tangent.safeNormalize();
+		binormal.safeNormalize();
+
+		vec3 normal = vb->getComponent<VertexBuffer::vcNormal>(i);
+		tangent = orthogonalize(normal, tangent);
+		binormal = orthogonalize(normal, binormal);
+
+		vb->setComponent<VertexBuffer::vcTangentBinormal>(i, vec4(tangent, binormal * (normal ^ tangent)));
+	}
+}
+
+//compares generated vectors of inner vertices with analytic ones
+bool CheckGrid(bool mirror, float& outNormalError, float& outTangentError)
+{
+	const int size = CHECK_GRID_SIZE;
+
+	VertexBuffer * vb = NULL;
+	IndexBuffer * ib = NULL;
+	CreateGrid(size, mirror, IndexBuffer::Index16, vb, ib);
+
+	MeshProcessing::CalcNormals(ib, vb);
+	MeshProcessing::CalcTangents(ib, vb);
+
+	int wrongSignsNum = 0;
+
+	for(int z = 1; z < size - 1; ++z)
+	{
+		for(int x = 1; x < size - 1; ++x)
+		{
+			float fx = x * GRID_STEP;
+			float fz = z * GRID_STEP;
+
+			vec3 dx(1, cosf(fx) * cosf(fz), 0);
+			vec3 dz(0, -sinf(fx) * sinf(fz), 1);
+			vec3 normal = (dz ^ dx).normalized();
+			vec3 tangent = (dx - normal * (normal * dx)).normalized();
+			if(mirror)
+				tangent = -tangent;
+
+			vec3 genNormal = vb->getComponent<VertexBuffer::vcNormal>(z * size + x);
+			vec4 genTangent = vb->getComponent<VertexBuffer::vcTangentBinormal>(z * size + x);
+
+			outNormalError = maxValue(outNormalError, (genNormal - normal).len());
+			outTangentError = maxValue(outTangentError, (vec3(genTangent.x, genTangent.y, genTangent.z) - tangent).len());
+
+			if(genTangent.w != (mirror ? 1.0f : -1.0f))
+				++wrongSignsNum;
+		}
+	}
+
+	DELETE_PTR(vb);
+	DELETE_PTR(ib);
+
+	return wrongSignsNum == 0;
+}
+
+}//namespace {
+
+bool RunMesh()
+{
+	bool isOk = true;
+
+	//1M triangles, best of several runs
+	VertexBuffer * vb = NULL;
+	IndexBuffer * ib = NULL;
+	CreateGrid(BIG_GRID_SIZE, false, IndexBuffer::Index32, vb, ib);
+
+	printf("Mesh: %d triangles, %d vertices\n", ib->getIndicesNum() / 3, (int)vb->getVertsNum());
+
+	size_t vertsSize = vb->getVertexSize() * vb->getVertsNum();
+	std::vector<byte> serialVerts;
+
+	for(int parallel = 0; parallel < 2; ++parallel)
+	{
+		double normalsMs = 1e9;
+		double tangentsMs = 1e9;
+
+		for(int i = 0; i < RUNS_NUM; ++i)
+		{
+			Timer timer;
+			MeshProcessing::CalcNormals(ib, vb, MeshProcessing::nwAngle, parallel != 0);
+			normalsMs = minValue(normalsMs, timer.getMs());
+
+			timer.restart();
+			MeshProcessing::CalcTangents(ib, vb, parallel != 0);
+			tangentsMs = minValue(tangentsMs, timer.getMs());
+		}
+
+		if(parallel == 0)
+		{
+			printf("  serial normals:             %8.1f ms\n", normalsMs);
+			printf("  serial tangents:            %8.1f ms\n", tangentsMs);
+			serialVerts.assign(vb->getVerts(), vb->getVerts() + vertsSize);
+		}
+		else
+		{
+			printf("  %2d workers normals:         %8.1f ms\n", TaskPool::Default()->getWorkersNum(), normalsMs);
+			printf("  %2d workers tangents:        %8.1f ms\n", TaskPool::Default()->getWorkersNum(), tangentsMs);
+
+			//corners are gathered in triangle order, so results are the same
+			if(memcmp(&serialVerts[0], vb->getVerts(), vertsSize) != 0)
+			{
+				printf("  parallel results differ from serial ones\n");
+				isOk = false;
+			}
+		}
+	}
+
+	DELETE_PTR(vb);
+	DELETE_PTR(ib);
+
+	//old tangents are quadratic, so they are timed on small grid only
+	CreateGrid(SMALL_GRID_SIZE, false, IndexBuffer::Index32, vb, ib);
+	MeshProcessing::CalcNormals(ib, vb);
+
+	Timer timer;
+	CalcTangentsByRescan(ib, vb);
+	double rescanMs = timer.getMs();
+
+	timer.restart();
+	MeshProcessing::CalcTangents(ib, vb, false);
+	double linearMs = timer.getMs();
+
+	printf("  %d triangles tangents, faces rescan: %.1f ms, linear: %.2f ms\n", ib->getIndicesNum() / 3, rescanMs, linearMs);
+
+	DELETE_PTR(vb);
+	DELETE_PTR(ib);
+
+	//accuracy for both texture mapping directions
+	for(int mirror = 0; mirror < 2; ++mirror)
+	{
+		float normalError = 0;
+		float tangentError = 0;
+		bool signsOk = CheckGrid(mirror != 0, normalError, tangentError);
+
+		printf("  %s mapping: max normal error %.4f, max tangent error %.4f, handedness %s\n",
+			mirror ? "mirrored" : "regular", normalError, tangentError, signsOk ? "correct" : "WRONG");
+
+		isOk = isOk && signsOk && normalError < 0.01f && tangentError < 0.01f;
+	}
+
+	printf("  %s\n", isOk ? "results are correct" : "RESULTS ARE WRONG");
+
+	return isOk;
+}
+
+}//namespace Benchmark {
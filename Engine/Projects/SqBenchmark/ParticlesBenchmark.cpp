@@ -0,0 +1,286 @@
+#include "Benchmark.h"
+#include <World/ParticlePool.h>
+#include <Common/TaskPool.h>
+#include <algorithm>
+#include <list>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+using namespace Squirrel;
+using namespace Squirrel::World;
+
+//Update of 100k particles: SoA pool serial and parallel, std::list of structures
+//as particle system stored them before, back to front radix sort against std::sort.
+
+namespace Benchmark {
+
+namespace {
+
+const int PARTICLES_NUM		= 100000;
+const int FRAMES_NUM		= 100;
+const int SORTS_NUM			= 20;
+const float FRAME_TIME		= 1.0f / 60.0f;
+
+float RandomRange(float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / (float)RAND_MAX);
+}
+
+void EmitParticles(ParticlePool& pool, int count)
+{
+	for(int i = 0; i < count; ++i)
+	{
+		int index = pool.add();
+		if(index < 0)
+			return;
+
+		//life of 1..3 seconds, so pool loses about one percent of particles per frame
+		float energy = RandomRange(1.0f, 3.0f);
+
+		pool.getStream(ParticlePool::sPosX)[index]				= RandomRange(-10.0f, 10.0f);
+		pool.getStream(ParticlePool::sPosY)[index]				= RandomRange(0.0f, 5.0f);
+		pool.getStream(ParticlePool::sPosZ)[index]				= RandomRange(-10.0f, 10.0f);
+		pool.getStream(ParticlePool::sVelocityX)[index]			= RandomRange(-1.0f, 1.0f);
+		pool.getStream(ParticlePool::sVelocityY)[index]			= RandomRange(2.0f, 4.0f);
+		pool.getStream(ParticlePool::sVelocityZ)[index]			= RandomRange(-1.0f, 1.0f);
+		pool.getStream(ParticlePool::sColorR)[index]			= 1.0f;
+		pool.getStream(ParticlePool::sColorG)[index]			= 1.0f;
+		pool.getStream(ParticlePool::sColorB)[index]			= 1.0f;
+		pool.getStream(ParticlePool::sColorA)[index]			= 1.0f;
+		pool.getStream(ParticlePool::sSize)[index]				= RandomRange(0.1f, 0.3f);
+		pool.getStream(ParticlePool::sAngle)[index]				= RandomRange(0.0f, 360.0f);
+		pool.getStream(ParticlePool::sAngularVelocity)[index]	= RandomRange(-90.0f, 90.0f);
+		pool.getStream(ParticlePool::sEnergy)[index]			= energy;
+		pool.getStream(ParticlePool::sInvInitialEnergy)[index]	= 1.0f / energy;
+	}
+}
+
+ParticlePool::UpdateParams MakeParams()
+{
+	ParticlePool::UpdateParams params;
+	params.force			= vec3(0, -9.8f, 0);
+	params.randomForce		= vec3(0.5f, 0.5f, 0.5f);
+	params.damping			= 0.8f;
+	params.sizeGrow			= 0.1f;
+	params.scale			= 1.0f;
+	params.rotation			= true;
+	params.animColorsNum	= 3;
+	params.animColors[0]	= vec4(1.0f, 1.0f, 0.5f, 1.0f);
+	params.animColors[1]	= vec4(1.0f, 0.5f, 0.0f, 0.8f);
+	params.animColors[2]	= vec4(0.2f, 0.2f, 0.2f, 0.0f);
+	params.seed				= 1;
+	return params;
+}
+
+//returns milliseconds per update, dead particles are replaced by new ones between updates
+double RunPoolUpdates(bool allowParallel, int& outDiedNum)
+{
+	srand(1);
+
+	ParticlePool pool;
+	pool.reserve(PARTICLES_NUM);
+	EmitParticles(pool, PARTICLES_NUM);
+
+	ParticlePool::UpdateParams params = MakeParams();
+
+	outDiedNum = 0;
+	double ms = 0;
+
+	for(int i = 0; i < FRAMES_NUM; ++i)
+	{
+		params.seed = i + 1;
+
+		Timer timer;
+		outDiedNum += pool.update(FRAME_TIME, params, allowParallel);
+		ms += timer.getMs();
+
+		EmitParticles(pool, PARTICLES_NUM - pool.getCount());
+	}
+
+	return ms / FRAMES_NUM;
+}
+
+//particle system update as it was before particle pool
+struct ListParticle
+{
+	vec3	pos;
+	vec3	velocity;
+	vec4	color;
+	float	size;
+	float	angle;
+	float	angularVelocity;
+	float	energy;
+	float	initialEnergy;
+};
+
+void EmitListParticles(std::list<ListParticle>& particles, int count)
+{
+	for(int i = 0; i < count; ++i)
+	{
+		ListParticle particle;
+		particle.pos				= vec3(RandomRange(-10.0f, 10.0f), RandomRange(0.0f, 5.0f), RandomRange(-10.0f, 10.0f));
+		particle.velocity			= vec3(RandomRange(-1.0f, 1.0f), RandomRange(2.0f, 4.0f), RandomRange(-1.0f, 1.0f));
+		particle.color				= vec4(1.0f, 1.0f, 1.0f, 1.0f);
+		particle.size				= RandomRange(0.1f, 0.3f);
+		particle.angle				= RandomRange(0.0f, 360.0f);
+		particle.angularVelocity	= RandomRange(-90.0f, 90.0f);
+		particle.energy				= RandomRange(1.0f, 3.0f);
+		particle.initialEnergy		= particle.energy;
+		particles.push_back(particle);
+	}
+}
+
+double RunListUpdates(int& outDiedNum)
+{
+	srand(1);
+
+	std::list<ListParticle> particles;
+	EmitListParticles(particles, PARTICLES_NUM);
+
+	ParticlePool::UpdateParams params = MakeParams();
+
+	outDiedNum = 0;
+	double ms = 0;
+
+	for(int i = 0; i < FRAMES_NUM; ++i)
+	{
+		Timer timer;
+
+		AABB bounds;
+		std::list<ListParticle>::iterator it = particles.begin();
+		while(it != particles.end())
+		{
+			ListParticle& particle = *it;
+
+			particle.velocity.x += (params.force.x + RandomRange(-params.randomForce.x, params.randomForce.x)) * FRAME_TIME;
+			particle.velocity.y += (params.force.y + RandomRange(-params.randomForce.y, params.randomForce.y)) * FRAME_TIME;
+			particle.velocity.z += (params.force.z + RandomRange(-params.randomForce.z, params.randomForce.z)) * FRAME_TIME;
+
+			particle.pos += particle.velocity * params.scale * FRAME_TIME;
+
+			particle.energy -= FRAME_TIME;
+			if(particle.energy <= 0)
+			{
+				it = particles.erase(it);
+				++outDiedNum;
+				continue;
+			}
+
+			float lifeElapsed = (particle.initialEnergy - particle.energy) / particle.initialEnergy;
+
+			particle.size += params.sizeGrow * params.scale * FRAME_TIME;
+
+			float colorFactor = lifeElapsed * params.animColorsNum;
+			int colorIndex = (int)floor(colorFactor);
+			if(colorIndex + 1 < params.animColorsNum)
+				particle.color = lerp(params.animColors[colorIndex], params.animColors[colorIndex + 1], colorFactor - colorIndex);
+			else
+				particle.color = params.animColors[params.animColorsNum - 1];
+
+			particle.angle += particle.angularVelocity * FRAME_TIME;
+
+			bounds.addVertex(particle.pos);
+
+			++it;
+		}
+
+		ms += timer.getMs();
+
+		EmitListParticles(particles, PARTICLES_NUM - (int)particles.size());
+	}
+
+	return ms / FRAMES_NUM;
+}
+
+}//namespace {
+
+bool RunParticles()
+{
+	printf("Particles: %d particles, %d updates\n", PARTICLES_NUM, FRAMES_NUM);
+
+	int poolDiedNum = 0;
+	double serialMs = RunPoolUpdates(false, poolDiedNum);
+
+	int parallelDiedNum = 0;
+	double parallelMs = RunPoolUpdates(true, parallelDiedNum);
+
+	int listDiedNum = 0;
+	double listMs = RunListUpdates(listDiedNum);
+
+	printf("  pool update, serial:        %8.3f ms\n", serialMs);
+	printf("  pool update, %2d workers:    %8.3f ms\n", TaskPool::Default()->getWorkersNum(), parallelMs);
+	printf("  std::list update:           %8.3f ms\n", listMs);
+
+	//sorting of particles after some updates
+	srand(2);
+
+	ParticlePool pool;
+	pool.reserve(PARTICLES_NUM);
+	EmitParticles(pool, PARTICLES_NUM);
+
+	ParticlePool::UpdateParams params = MakeParams();
+	for(int i = 0; i < 10; ++i)
+	{
+		params.seed = i + 1;
+		pool.update(FRAME_TIME, params);
+	}
+
+	vec3 eye(0, 2, -20);
+	vec3 viewDir = vec3(0, -0.1f, 1.0f).normalized();
+
+	Timer timer;
+	for(int i = 0; i < SORTS_NUM; ++i)
+	{
+		pool.sortBackToFront(eye, viewDir);
+	}
+	double radixMs = timer.getMs() / SORTS_NUM;
+
+	std::vector< std::pair<float, uint32> > depths(pool.getCount());
+	timer.restart();
+	for(int i = 0; i < SORTS_NUM; ++i)
+	{
+		for(int j = 0; j < pool.getCount(); ++j)
+		{
+			depths[j].first = -((pool.getPosition(j) - eye) * viewDir);
+			depths[j].second = j;
+		}
+		std::sort(depths.begin(), depths.end());
+	}
+	double stdSortMs = timer.getMs() / SORTS_NUM;
+
+	printf("  back to front radix sort:   %8.3f ms\n", radixMs);
+	printf("  back to front std::sort:    %8.3f ms\n", stdSortMs);
+
+	timer.restart();
+	AABB bounds = pool.calcBounds();
+	printf("  bounds:                     %8.3f ms\n", timer.getMs());
+
+	//checks
+	bool isOk = poolDiedNum == parallelDiedNum && poolDiedNum > 0;
+
+	const std::vector<uint32>& order = pool.sortBackToFront(eye, viewDir);
+	for(size_t i = 1; i < order.size(); ++i)
+	{
+		if((pool.getPosition(order[i - 1]) - eye) * viewDir < (pool.getPosition(order[i]) - eye) * viewDir)
+		{
+			isOk = false;
+			break;
+		}
+	}
+
+	for(int i = 0; i < pool.getCount(); ++i)
+	{
+		if(!bounds.intersects(pool.getPosition(i)))
+		{
+			isOk = false;
+			break;
+		}
+	}
+
+	printf("  died per update: pool %d, list %d; %s\n", poolDiedNum / FRAMES_NUM, listDiedNum / FRAMES_NUM, isOk ? "results are correct" : "RESULTS ARE WRONG");
+
+	return isOk;
+}
+
+}//namespace Benchmark {
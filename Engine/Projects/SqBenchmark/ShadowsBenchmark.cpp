@@ -0,0 +1,345 @@
+#include "Benchmark.h"
+#include <Engine/ShadowCasters.h>
+#include <World/World.h>
+#include <World/Terrain.h>
+#include <Common/Settings.h>
+#include <vector>
+#include <stdio.h>
+#include <math.h>
+
+using namespace Squirrel;
+using namespace Squirrel::World;
+using namespace Squirrel::Engine;
+
+//Shadow casters of 2500 boxes world gathered once per light and binned into 3 splits,
+//against world traversal per split; then decisions of cached static layers on scripted scenario
+//of small world: new, static, moving, deferred and disabled casters, camera changes and terrain edits.
+//Nothing is drawn, layers are "rendered" by counting render calls of boxes.
+
+namespace Benchmark {
+
+namespace {
+
+const int GRID_SIZE			= 50;//2500 boxes
+const float GRID_STEP		= 4.0f;
+const int MOVING_NUM		= 25;
+const int SPLITS_NUM		= 3;
+const int FRAMES_NUM		= 200;
+
+class Box:
+	public SceneObject
+{
+public:
+	Box(): mRendersNum(0) {}
+
+	void hide() { mEnabled = false; }
+
+	int mRendersNum;
+
+protected:
+
+	virtual void calcAABB()
+	{
+		vec3 pos = getTransform().getTranslate();
+		mAABB = AABB(pos + vec3(1, 1, 1), pos - vec3(1, 1, 1));
+	}
+
+	virtual void render(Render::RenderQueue *, Render::Camera *, const RenderInfo&)
+	{
+		++mRendersNum;
+	}
+};
+
+bool Expect(bool condition, const char * what)
+{
+	if(!condition)
+		printf("  WRONG: %s\n", what);
+	return condition;
+}
+
+//light volume over middle of grid, split into slices along x
+AABB SplitBounds(int split)
+{
+	float minX = GRID_SIZE * GRID_STEP * 0.25f;
+	float sizeX = GRID_SIZE * GRID_STEP * 0.5f / SPLITS_NUM;
+	return AABB(vec3(minX + sizeX * (split + 1), 100, GRID_SIZE * GRID_STEP * 0.75f), vec3(minX + sizeX * split, -100, GRID_SIZE * GRID_STEP * 0.25f));
+}
+
+bool RunGather()
+{
+	World::World world;
+
+	std::vector<Box *> boxes;
+	for(int z = 0; z < GRID_SIZE; ++z)
+	{
+		for(int x = 0; x < GRID_SIZE; ++x)
+		{
+			Box * box = new Box();
+			box->setLocalPosition(vec3(x * GRID_STEP, 0, z * GRID_STEP));
+			world.addSceneObject(box);
+			boxes.push_back(box);
+		}
+	}
+
+	AABB splits[SPLITS_NUM];
+	AABB volume = SplitBounds(0);
+	for(int i = 0; i < SPLITS_NUM; ++i)
+	{
+		splits[i] = SplitBounds(i);
+		volume.merge(splits[i]);
+	}
+
+	//expected casters of splits
+	world.updateTransform();
+	int expectedNum = 0;
+	for(size_t i = 0; i < boxes.size(); ++i)
+	{
+		for(int s = 0; s < SPLITS_NUM; ++s)
+		{
+			if(boxes[i]->getAABB().intersects(splits[s]))
+				++expectedNum;
+		}
+	}
+
+	printf("Shadows: %d boxes, %d of them moving outside light volume, %d splits, %d frames\n",
+		(int)boxes.size(), MOVING_NUM, SPLITS_NUM, FRAMES_NUM);
+
+	ShadowCasters casters;
+
+	double traversalMs = 0;
+	double uncachedMs = 0;
+	double cachedMs = 0;
+	int wrongFramesNum = 0;
+
+	for(int frame = 0; frame < FRAMES_NUM; ++frame)
+	{
+		//first row is far from light volume
+		for(int i = 0; i < MOVING_NUM; ++i)
+			boxes[i]->setLocalPosition(vec3(i * GRID_STEP, sinf(frame * 0.1f + i), 0));
+
+		world.updateTransform();
+
+		//world traversal per split, as shadows did before
+		Timer timer;
+		for(int s = 0; s < SPLITS_NUM; ++s)
+		{
+			casters.invalidate();
+			casters.gather(&world, mat4::Identity(), splits[s], vec3(0, 0, 0));
+		}
+		traversalMs += timer.getMs();
+
+		timer.restart();
+		casters.invalidate();
+		casters.gather(&world, mat4::Identity(), volume, volume.getSize() * 0.1f);
+		uncachedMs += timer.getMs();
+
+		//candidates of last gather are valid, so this one reuses them
+		timer.restart();
+		casters.gather(&world, mat4::Identity(), volume, volume.getSize() * 0.1f);
+
+		const ShadowCasters::CASTERS_LIST& candidates = casters.getCandidates();
+		casters.setViewsNum(SPLITS_NUM);
+		for(int c = 0; c < (int)candidates.size(); ++c)
+		{
+			for(int s = 0; s < SPLITS_NUM; ++s)
+			{
+				if(candidates[c].bounds.intersects(splits[s]))
+					casters.addToView(s, c);
+			}
+		}
+		cachedMs += timer.getMs();
+
+		int castersNum = 0;
+		for(int s = 0; s < SPLITS_NUM; ++s)
+			castersNum += (int)casters.getView(s, ShadowCasters::lStatic).size() + (int)casters.getView(s, ShadowCasters::lDynamic).size();
+		if(castersNum != expectedNum)
+			++wrongFramesNum;
+	}
+
+	const ShadowCasters::Stats& stats = casters.getStats();
+
+	printf("  traversal per split:        %8.3f ms per frame\n", traversalMs / FRAMES_NUM);
+	printf("  uncached gather:            %8.3f ms per frame\n", uncachedMs / FRAMES_NUM);
+	printf("  cached gather and binning:  %8.3f ms per frame, %d candidates, %d casters in splits\n",
+		cachedMs / FRAMES_NUM, (int)casters.getCandidates().size(), expectedNum);
+	printf("  gathers: %d, reused: %d\n", stats.framesNum, stats.cachedFramesNum);
+
+	bool isOk = true;
+	isOk = Expect(wrongFramesNum == 0, "casters binned into splits differ from boxes overlapping them") && isOk;
+	isOk = Expect(stats.cachedFramesNum == FRAMES_NUM, "moves outside light volume invalidated candidates") && isOk;
+	return isOk;
+}
+
+//two views of one light: view 1 gets odd candidates and may be not due
+class DecisionsScenario
+{
+public:
+	DecisionsScenario(World::World * world): mWorld(world), mVolume(vec3(100, 10, 100), vec3(0, -10, 0)) {}
+
+	void frame(const mat4& camera0, const mat4& camera1, bool due1)
+	{
+		mWorld->updateTransform();
+		mCasters.gather(mWorld, mat4::Identity(), mVolume, vec3(5, 0, 5));
+		mCasters.setViewsNum(2);
+		for(int i = 0; i < (int)mCasters.getCandidates().size(); ++i)
+		{
+			mCasters.addToView(0, i);
+			if(i % 2)
+				mCasters.addToView(1, i);
+		}
+		mUpdates[0] = mCasters.updateView(0, camera0, true);
+		mUpdates[1] = mCasters.updateView(1, camera1, due1);
+	}
+
+	bool updated(ShadowCasters::ViewUpdate update0, ShadowCasters::ViewUpdate update1) const
+	{
+		return mUpdates[0] == update0 && mUpdates[1] == update1;
+	}
+
+	ShadowCasters::ViewUpdate getUpdate(int view) const { return mUpdates[view]; }
+
+	ShadowCasters& getCasters() { return mCasters; }
+
+private:
+	World::World *				mWorld;
+	AABB						mVolume;
+	ShadowCasters				mCasters;
+	ShadowCasters::ViewUpdate	mUpdates[2];
+};
+
+bool RunDecisions()
+{
+	World::World world;
+
+	std::vector<Box *> boxes;
+	for(int i = 0; i < 10; ++i)
+	{
+		Box * box = new Box();
+		box->setLocalPosition(vec3(i * 10.0f, 0, 50));
+		world.addSceneObject(box);
+		boxes.push_back(box);
+	}
+
+	DecisionsScenario scenario(&world);
+	ShadowCasters& casters = scenario.getCasters();
+
+	mat4 camera0 = mat4::Identity();
+	mat4 camera1 = mat4::Identity();
+	camera1[0].w = 5;
+
+	bool isOk = true;
+
+	//new objects are dynamic until they stay for STATIC_FRAMES
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuAll), "first frame renders all layers") && isOk;
+	isOk = Expect(casters.getStats().dynamicCastersNum == 15, "new casters are dynamic") && isOk;
+
+	scenario.frame(camera0, camera1, false);
+	isOk = Expect(scenario.updated(ShadowCasters::vuDynamic, ShadowCasters::vuNone) && casters.getStats().deferredViewsNum == 1,
+		"dynamic casters are redrawn, view which is not due is deferred") && isOk;
+
+	for(uint32 i = 2; i <= ShadowCasters::STATIC_FRAMES; ++i)
+		scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuAll) && casters.getStats().dynamicCastersNum == 0,
+		"casters turned static render static layer once") && isOk;
+
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuNone, ShadowCasters::vuNone) && casters.getStats().updatedViewsNum == 0,
+		"static world updates nothing") && isOk;
+
+	//moving object leaves static layer once, then only dynamic layer is redrawn
+	boxes[3]->setLocalPosition(vec3(30, 1, 50));
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuAll), "moved caster leaves static layer") && isOk;
+
+	int allNum = 0;
+	int dynamicNum = 0;
+	for(int i = 0; i < 10; ++i)
+	{
+		boxes[3]->setLocalPosition(vec3(30, 1.0f + i, 50));
+		scenario.frame(camera0, camera1, (i % 2) == 0);
+
+		for(int view = 0; view < 2; ++view)
+		{
+			allNum += scenario.getUpdate(view) == ShadowCasters::vuAll;
+			dynamicNum += scenario.getUpdate(view) == ShadowCasters::vuDynamic;
+		}
+	}
+	printf("  moving caster over 10 frames: %d static and %d dynamic layer updates\n", allNum, dynamicNum);
+	isOk = Expect(allNum == 0 && dynamicNum == 15, "moving caster redraws dynamic layer of due views only") && isOk;
+
+	//layers render what they hold
+	for(size_t i = 0; i < boxes.size(); ++i)
+		boxes[i]->mRendersNum = 0;
+
+	RenderInfo info;
+	casters.renderView(0, ShadowCasters::lDynamic, NULL, NULL, info);
+	isOk = Expect(boxes[3]->mRendersNum == 1 && boxes[0]->mRendersNum == 0, "dynamic layer holds moving caster only") && isOk;
+	casters.renderView(0, ShadowCasters::lStatic, NULL, NULL, info);
+	isOk = Expect(boxes[3]->mRendersNum == 1 && boxes[0]->mRendersNum == 1, "static layer holds other casters") && isOk;
+
+	//camera change forces update of view which is not due
+	camera1[1].w = 1;
+	scenario.frame(camera0, camera1, false);
+	isOk = Expect(scenario.updated(ShadowCasters::vuDynamic, ShadowCasters::vuAll), "moved camera updates view which is not due") && isOk;
+
+	//disabled static caster changes static layer once
+	for(uint32 i = 0; i <= ShadowCasters::STATIC_FRAMES; ++i)
+		scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuNone, ShadowCasters::vuNone), "caster stopped moving turns static") && isOk;
+
+	boxes[5]->hide();
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuAll), "hidden caster leaves static layer") && isOk;
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuNone, ShadowCasters::vuNone), "hidden caster is not redrawn") && isOk;
+
+	//terrain is cached in static layer: attached terrain, height edits and recentring render it again
+
+	Terrain terrain;
+	terrain.initGenerated(1, 64.0f, 16, vec3(10, 5, 10), 7);
+
+	world.setTerrain(&terrain);
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuAll), "attached terrain renders static layers") && isOk;
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuNone, ShadowCasters::vuNone), "unchanged terrain keeps static layers") && isOk;
+
+	HeightMap * heightMap = terrain.getNode(0, 0)->getHeightMap();
+	heightMap->heightRef(8, 8) += 3.0f;
+	heightMap->updateNormal(8, 8);
+
+	scenario.frame(camera0, camera1, false);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuNone), "edited heights render static layer of due view") && isOk;
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuNone, ShadowCasters::vuAll), "deferred view catches up with edited heights") && isOk;
+
+	terrain.setCenter(tuple2i(1, 0));
+	scenario.frame(camera0, camera1, true);
+	isOk = Expect(scenario.updated(ShadowCasters::vuAll, ShadowCasters::vuAll), "recentred terrain renders static layers") && isOk;
+
+	world.setTerrain(NULL);
+
+	const ShadowCasters::Stats& stats = casters.getStats();
+	printf("  static layers scenario: %d frames, %d reused candidates\n", stats.framesNum, stats.cachedFramesNum);
+
+	return isOk;
+}
+
+}//namespace {
+
+bool RunShadows()
+{
+	//worlds read their options from default settings, missing file leaves defaults
+	Settings settings("SqBenchmark.ini");
+	settings.setAsDefault();
+
+	bool isOk = RunGather();
+	isOk = RunDecisions() && isOk;
+
+	printf("  %s\n", isOk ? "results are correct" : "RESULTS ARE WRONG");
+
+	return isOk;
+}
+
+}//namespace Benchmark {
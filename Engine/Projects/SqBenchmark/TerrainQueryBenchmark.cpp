@@ -0,0 +1,215 @@
+#include "Benchmark.h"
+#include <World/Terrain.h>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+using namespace Squirrel;
+using namespace Squirrel::World;
+
+//Queries of 5x5 tiles generated terrain: batched height samples, rays cast down at random slopes
+//and spheres swept along surface; sweep results are checked against brute force clearance.
+
+namespace Benchmark {
+
+namespace {
+
+const int NODES_NUM			= 5;
+const float NODE_SIZE		= 128.0f;
+const int CELLS_PER_NODE	= 128;
+const int BATCH_SIZE		= 4096;
+const int SAMPLE_BATCHES_NUM= 256;//1M samples
+const int RAYS_NUM			= 100000;
+const int SWEEPS_NUM		= 100000;
+const int CHECKED_SWEEPS_NUM= 2000;
+const float SWEEP_RADIUS	= 0.5f;
+const float SWEEP_LENGTH	= 4.0f;
+
+float RandomRange(float minValue, float maxValue)
+{
+	return minValue + (maxValue - minValue) * (rand() / (float)RAND_MAX);
+}
+
+//point of inner tiles, so paths around it stay on loaded terrain
+vec2 RandomPoint(const AABB& bounds)
+{
+	float margin = NODE_SIZE;
+	return vec2(RandomRange(bounds.min.x + margin, bounds.max.x - margin), RandomRange(bounds.min.z + margin, bounds.max.z - margin));
+}
+
+//distance from center to surface sampled densely around it
+float SampledClearance(TerrainQuery * query, const vec3& center, float radius, float cellSize)
+{
+	const int STEPS_NUM = 16;
+
+	float clearance = FLT_MAX;
+	float range = radius + cellSize;
+
+	for(int j = -STEPS_NUM; j <= STEPS_NUM; ++j)
+	{
+		for(int i = -STEPS_NUM; i <= STEPS_NUM; ++i)
+		{
+			float x = center.x + range * i / STEPS_NUM;
+			float z = center.z + range * j / STEPS_NUM;
+
+			float height;
+			if(query->height(x, z, height))
+				clearance = Math::minValue(clearance, (center - vec3(x, height, z)).len());
+		}
+	}
+
+	float height;
+	if(query->height(center.x, center.z, height) && center.y < height)
+		clearance = -clearance;
+
+	return clearance;
+}
+
+}//namespace {
+
+bool RunTerrainQuery()
+{
+	srand(1);
+
+	Terrain terrain;
+	terrain.initGenerated(NODES_NUM, NODE_SIZE, CELLS_PER_NODE, vec3(40, 60, 40), 7);
+
+	TerrainQuery * query = terrain.getQuery();
+	AABB bounds = terrain.getBounds();
+
+	printf("TerrainQuery: %dx%d tiles of %d cells, heights %.1f..%.1f\n", NODES_NUM, NODES_NUM, CELLS_PER_NODE, bounds.min.y, bounds.max.y);
+
+	bool isOk = true;
+
+	//batched heights, compared with single queries
+
+	std::vector<vec2> points(BATCH_SIZE);
+	std::vector<float> heights(BATCH_SIZE);
+
+	int hitsNum = 0;
+	int wrongHeightsNum = 0;
+	double samplesMs = 0;
+
+	for(int b = 0; b < SAMPLE_BATCHES_NUM; ++b)
+	{
+		for(int i = 0; i < BATCH_SIZE; ++i)
+			points[i] = vec2(RandomRange(bounds.min.x, bounds.max.x), RandomRange(bounds.min.z, bounds.max.z));
+
+		Timer timer;
+		hitsNum += query->sampleHeights(&points[0], BATCH_SIZE, &heights[0]);
+		samplesMs += timer.getMs();
+
+		for(int i = 0; i < BATCH_SIZE; i += 97)
+		{
+			float height = 0;
+			query->height(points[i].x, points[i].y, height);
+			if(height != heights[i])
+				++wrongHeightsNum;
+		}
+	}
+
+	const int samplesNum = SAMPLE_BATCHES_NUM * BATCH_SIZE;
+
+	printf("  heights: %d samples in batches of %d, %.1f M/s, %d hit tiles, %d differ from single queries\n",
+		samplesNum, BATCH_SIZE, samplesNum / samplesMs / 1000.0, hitsNum, wrongHeightsNum);
+
+	isOk = isOk && wrongHeightsNum == 0 && hitsNum == samplesNum;
+
+	//rays from above down to random points
+
+	std::vector<Ray> rays(RAYS_NUM);
+	for(int i = 0; i < RAYS_NUM; ++i)
+	{
+		vec2 target = RandomPoint(bounds);
+		vec3 dir(RandomRange(-1.0f, 1.0f), -1.0f, RandomRange(-1.0f, 1.0f));
+		rays[i].mOrigin = vec3(target.x, bounds.max.y + 10.0f, target.y);
+		rays[i].mDirection = dir.normalized();
+	}
+
+	query->resetStats();
+
+	int raysHitNum = 0;
+	float maxRayError = 0;
+
+	Timer timer;
+	for(int i = 0; i < RAYS_NUM; ++i)
+	{
+		TerrainHit hit;
+		if(query->raycast(rays[i], 1000.0f, hit))
+		{
+			++raysHitNum;
+
+			float height;
+			if(query->height(hit.position.x, hit.position.z, height))
+				maxRayError = Math::maxValue(maxRayError, fabsf(height - hit.position.y));
+		}
+	}
+	double raysMs = timer.getMs();
+
+	printf("  rays:    %d, %.2f M/s, %d hit, max hit height error %.5f, %.1f boxes and %.1f cells per ray\n",
+		RAYS_NUM, RAYS_NUM / raysMs / 1000.0, raysHitNum, maxRayError,
+		query->getStats().mBoxesTested / (float)RAYS_NUM, query->getStats().mCellsTested / (float)RAYS_NUM);
+
+	isOk = isOk && raysHitNum == RAYS_NUM && maxRayError < 0.01f;
+
+	//spheres moving along surface, starting just above it
+
+	std::vector<vec3> froms(SWEEPS_NUM);
+	std::vector<vec3> tos(SWEEPS_NUM);
+	for(int i = 0; i < SWEEPS_NUM; ++i)
+	{
+		vec2 start = RandomPoint(bounds);
+		float angle = RandomRange(0.0f, 6.2832f);
+		float height = 0;
+		query->height(start.x, start.y, height);
+		froms[i] = vec3(start.x, height + SWEEP_RADIUS * 3.0f, start.y);
+		tos[i] = froms[i] + vec3(cosf(angle), RandomRange(-0.5f, 0.1f), sinf(angle)) * SWEEP_LENGTH;
+	}
+
+	std::vector<TerrainHit> hits(SWEEPS_NUM);
+	std::vector<bool> hit(SWEEPS_NUM);
+
+	timer.restart();
+	for(int i = 0; i < SWEEPS_NUM; ++i)
+	{
+		hit[i] = query->sweepSphere(froms[i], tos[i], SWEEP_RADIUS, hits[i]);
+	}
+	double sweepsMs = timer.getMs();
+
+	//center at contact (or at end of path) must not be inside surface
+
+	int sweepsHitNum = 0;
+	int penetratingNum = 0;
+	float minClearance = FLT_MAX;
+
+	for(int i = 0; i < SWEEPS_NUM; ++i)
+	{
+		if(hit[i])
+			++sweepsHitNum;
+
+		if(i >= CHECKED_SWEEPS_NUM)
+			continue;
+
+		vec3 path = tos[i] - froms[i];
+		vec3 center = hit[i] ? froms[i] + path * (hits[i].distance / path.len()) : tos[i];
+
+		float clearance = SampledClearance(query, center, SWEEP_RADIUS, terrain.getCellSize());
+		minClearance = Math::minValue(minClearance, clearance);
+
+		if(clearance < SWEEP_RADIUS * 0.95f)
+			++penetratingNum;
+	}
+
+	printf("  sweeps:  %d spheres of radius %.1f, %.2f M/s, %d hit, %d of %d checked ones penetrate, min clearance %.3f\n",
+		SWEEPS_NUM, SWEEP_RADIUS, SWEEPS_NUM / sweepsMs / 1000.0, sweepsHitNum, penetratingNum, CHECKED_SWEEPS_NUM, minClearance);
+
+	isOk = isOk && penetratingNum == 0;
+
+	printf("  %s\n", isOk ? "results are correct" : "RESULTS ARE WRONG");
+
+	return isOk;
+}
+
+}//namespace Benchmark {
@@ -0,0 +1,77 @@
+#include "Benchmark.h"
+#include <Common/Log.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace Squirrel;
+
+//CPU benchmarks of engine subsystems, run them in Release configuration:
+//SqBenchmark [name ...]
+
+namespace {
+
+struct BenchmarkEntry
+{
+	const char * name;
+	bool (*run)();
+};
+
+const BenchmarkEntry BENCHMARKS[] = {
+	{ "particles",	&Benchmark::RunParticles },
+	{ "mesh",		&Benchmark::RunMesh },
+	{ "heightmap",	&Benchmark::RunHeightMap },
+	{ "terrainquery",	&Benchmark::RunTerrainQuery },
+	{ "collision",	&Benchmark::RunCollision },
+	{ "shadows",	&Benchmark::RunShadows },
+};
+
+const int BENCHMARKS_NUM = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+void PrintUsage()
+{
+	printf("Usage: SqBenchmark [name ...]\n");
+	printf("  runs all benchmarks if no names are given, available ones:");
+	for(int i = 0; i < BENCHMARKS_NUM; ++i)
+		printf(" %s", BENCHMARKS[i].name);
+	printf("\n");
+}
+
+}//namespace {
+
+int main(int argc, char ** argv)
+{
+	bool selected[BENCHMARKS_NUM];
+	for(int i = 0; i < BENCHMARKS_NUM; ++i)
+		selected[i] = argc < 2;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		int found = -1;
+		for(int j = 0; j < BENCHMARKS_NUM; ++j)
+		{
+			if(strcmp(argv[i], BENCHMARKS[j].name) == 0)
+				found = j;
+		}
+
+		if(found < 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+
+		selected[found] = true;
+	}
+
+	Log::Instance().init("Benchmark.log", Log::sevWarning);
+
+	bool isOk = true;
+	for(int i = 0; i < BENCHMARKS_NUM; ++i)
+	{
+		if(selected[i])
+			isOk = BENCHMARKS[i].run() && isOk;
+	}
+
+	Log::Instance().finish();
+
+	return isOk ? 0 : 2;
+}
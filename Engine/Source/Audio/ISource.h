@@ -47,8 +47,14 @@ public: //methods
 	virtual void pause() = 0;
 	virtual void offset(float seocnds) = 0;
 
+	//NULL detaches buffer and queued buffers
 	virtual void attachBuffer(IBuffer * buffer) = 0;
 
+	//streaming: buffers are played in order they are queued
+	virtual void queueBuffer(IBuffer * buffer) = 0;
+	//returns next buffer which is played already, NULL if there is no such one
+	virtual IBuffer * unqueueBuffer() = 0;
+
 	virtual STATE getState() = 0; 
 };
 
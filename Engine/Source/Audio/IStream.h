@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../common/macros.h"
+#include "../common/types.h"
+
+namespace Squirrel {
+
+namespace Audio { 
+
+//Sequential source of PCM data for streamed sounds, used from decoding thread
+class SQCOMMON_API IStream
+{
+public://ctor/destr
+
+	IStream() {};
+	virtual ~IStream() {};
+
+public: //methods
+
+	virtual int getFrequency() const = 0;
+	virtual int getBitsPerSample() const = 0;
+	virtual int getChannels() const = 0;
+
+	//decodes up to size bytes to dst, returns number of decoded bytes, 0 at the end of stream
+	virtual uint32 read(void * dst, uint32 size) = 0;
+
+	virtual void rewind() = 0;
+};
+
+
+} //namespace Audio {
+
+} //namespace Squirrel {
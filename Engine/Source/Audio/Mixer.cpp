@@ -0,0 +1,703 @@
+#include "Mixer.h"
+#include "../common/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+
+namespace Squirrel {
+namespace Audio {
+
+namespace {
+
+//decoding thread wakes at least that often
+const int DECODE_PERIOD_MS = 20;
+
+//ring is not topped up with smaller pieces
+const uint32 MIN_DECODE_SIZE = 4096;
+
+struct VoiceOrder
+{
+	float realBonus;
+
+	bool operator()(const Mixer::Voice * a, const Mixer::Voice * b) const
+	{
+		if(a->getPriority() != b->getPriority())
+			return a->getPriority() > b->getPriority();
+
+		float audibilityA = a->getAudibility() * (a->isVirtual() ? 1.0f : realBonus);
+		float audibilityB = b->getAudibility() * (b->isVirtual() ? 1.0f : realBonus);
+		return audibilityA > audibilityB;
+	}
+};
+
+}//namespace {
+
+//ring buffer filled by decoding thread (producer) and read by update (consumer);
+//other fields are changed only with streams mutex locked or by consumer
+struct Mixer::StreamState
+{
+	IStream *	stream;
+
+	int			frequency;
+	int			bits;
+	int			channels;
+	uint32		blockAlign;
+	uint32		chunkSize;//bytes per hardware buffer
+
+	std::vector<byte>	ring;
+	std::atomic<uint64>	readPos;
+	std::atomic<uint64>	writePos;
+	std::atomic<bool>	loop;
+	std::atomic<bool>	ended;//decoded to the end, ring keeps the rest
+
+	bool		decodedSinceRewind;//guards looping of empty stream
+
+	std::vector<IBuffer *>	buffers;//hardware buffers, created when voice becomes real first time
+	std::vector<IBuffer *>	freeBuffers;
+	std::vector<byte>		chunk;
+	bool		started;//source was played since voice became real
+};
+
+Mixer * Mixer::sActiveMixer = NULL;
+
+const float Mixer::MIN_AUDIBILITY = 0.001f;
+const float Mixer::REAL_VOICE_BONUS = 1.25f;
+
+//////////////////////////////////////////////////////////////////////////
+// Mixer::Voice
+
+Mixer::Voice::Voice(Mixer * mixer):
+	mMixer(mixer), mPosition(0, 0, 0), mVelocity(0, 0, 0), mDirection(0, 0, 0),
+	mPitch(1), mGain(1), mLoop(false), mMaxRadius(100), mRefRadius(1),
+	mConeOuterAngle(360), mConeInnerAngle(360), mConeOuterGain(1), mPriority(0),
+	mBuffer(NULL), mDuration(0), mStream(NULL), mState(vsStopped), mRestart(false), mPlayTime(0),
+	mDirty(dfAll), mSource(NULL), mAudibility(0)
+{
+}
+
+Mixer::Voice::~Voice()
+{
+}
+
+bool Mixer::Voice::isCone() const
+{
+	return mConeInnerAngle < 360.0f && mConeOuterGain < 1.0f;
+}
+
+void Mixer::Voice::setPosition(vec3 pos)
+{
+	if(mPosition == pos) return;
+	mPosition = pos;
+	mDirty |= dfPosition;
+}
+
+void Mixer::Voice::setVelocity(vec3 v)
+{
+	if(mVelocity == v) return;
+	mVelocity = v;
+	mDirty |= dfVelocity;
+}
+
+void Mixer::Voice::setDirection(vec3 dir)
+{
+	if(mDirection == dir) return;
+	mDirection = dir;
+	mDirty |= dfDirection;
+}
+
+void Mixer::Voice::setPitch(float pitch)
+{
+	if(mPitch == pitch) return;
+	mPitch = pitch;
+	mDirty |= dfPitch;
+}
+
+void Mixer::Voice::setGain(float gain)
+{
+	if(mGain == gain) return;
+	mGain = gain;
+	mDirty |= dfGain;
+}
+
+void Mixer::Voice::setLoop(bool loop)
+{
+	if(mLoop == loop) return;
+	mLoop = loop;
+	mDirty |= dfLoop;
+
+	if(mStream != NULL)
+		mStream->loop.store(loop);
+}
+
+void Mixer::Voice::setRadius(float maxRadius, float refRadius)
+{
+	if(mMaxRadius == maxRadius && mRefRadius == refRadius) return;
+	mMaxRadius = maxRadius;
+	mRefRadius = refRadius;
+	mDirty |= dfRadius;
+}
+
+void Mixer::Voice::setCone(float outerAngle, float innerAngle, float outerGain)
+{
+	if(mConeOuterAngle == outerAngle && mConeInnerAngle == innerAngle && mConeOuterGain == outerGain) return;
+	mConeOuterAngle = outerAngle;
+	mConeInnerAngle = innerAngle;
+	mConeOuterGain = outerGain;
+	mDirty |= dfCone | dfDirection;
+}
+
+void Mixer::Voice::setBuffer(IBuffer * buffer, float duration)
+{
+	//source gets new content when voice becomes real again
+	if(mSource != NULL)
+		mMixer->mFreeSources.push_back( mMixer->makeVirtual(this) );
+
+	if(mStream != NULL)
+	{
+		mMixer->removeStream(mStream);
+		mStream = NULL;
+	}
+
+	mBuffer = buffer;
+	mDuration = duration;
+	mPlayTime = 0;
+}
+
+void Mixer::Voice::setStream(IStream * stream)
+{
+	setBuffer(NULL, 0);
+
+	if(stream == NULL)
+		return;
+
+	StreamState * state = new StreamState();
+	state->stream		= stream;
+	state->frequency	= stream->getFrequency();
+	state->bits			= stream->getBitsPerSample();
+	state->channels		= stream->getChannels();
+	state->blockAlign	= (uint32)std::max(state->bits / 8 * state->channels, 1);
+
+	uint32 bytesPerSecond = (uint32)state->frequency * state->blockAlign;
+
+	state->chunkSize = bytesPerSecond * STREAM_BUFFER_MS / 1000;
+	state->chunkSize -= state->chunkSize % state->blockAlign;
+	state->chunkSize = std::max(state->chunkSize, state->blockAlign);
+
+	uint32 ringSize = bytesPerSecond * STREAM_RING_MS / 1000;
+	ringSize = std::max(ringSize, state->chunkSize * 2);
+	state->ring.resize(ringSize);
+	state->chunk.resize(state->chunkSize);
+
+	state->readPos.store(0);
+	state->writePos.store(0);
+	state->loop.store(mLoop);
+	state->ended.store(false);
+	state->decodedSinceRewind = false;
+	state->started = false;
+
+	mStream = state;
+	mMixer->addStream(state);
+}
+
+void Mixer::Voice::play()
+{
+	if(mState == vsPaused)
+	{
+		mState = vsPlaying;
+		return;
+	}
+
+	mState = vsPlaying;
+	mRestart = true;
+	mPlayTime = 0;
+}
+
+void Mixer::Voice::stop()
+{
+	mState = vsStopped;
+}
+
+void Mixer::Voice::pause()
+{
+	if(mState == vsPlaying)
+		mState = vsPaused;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Mixer
+
+Mixer::Mixer(IAudio * audio, int sourcesNum):
+	mAudio(audio), mListenerPosition(0, 0, 0), mQuit(false)
+{
+	memset(&mStats, 0, sizeof(mStats));
+
+	for(int i = 0; i < sourcesNum; ++i)
+	{
+		ISource * source = mAudio->createSource();
+		if(source == NULL)
+			break;
+
+		mSources.push_back(source);
+	}
+
+	mFreeSources = mSources;
+
+	mDecodeThread = std::thread(&Mixer::decodeLoop, this);
+}
+
+Mixer::~Mixer()
+{
+	if(this == sActiveMixer)
+	{
+		sActiveMixer = NULL;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mStreamsMutex);
+		mQuit = true;
+	}
+	mDecodeWake.notify_all();
+	mDecodeThread.join();
+
+	while(!mVoices.empty())
+	{
+		destroyVoice(mVoices.back());
+	}
+
+	for(size_t i = 0; i < mSources.size(); ++i)
+	{
+		DELETE_PTR(mSources[i]);
+	}
+}
+
+Mixer::Voice * Mixer::createVoice()
+{
+	Voice * voice = new Voice(this);
+	mVoices.push_back(voice);
+	return voice;
+}
+
+void Mixer::destroyVoice(Voice * voice)
+{
+	if(voice == NULL)
+		return;
+
+	//releases source and stream
+	voice->setBuffer(NULL, 0);
+
+	std::vector<Voice *>::iterator it = std::find(mVoices.begin(), mVoices.end(), voice);
+	if(it != mVoices.end())
+	{
+		*it = mVoices.back();
+		mVoices.pop_back();
+	}
+
+	delete voice;
+}
+
+void Mixer::setListener(vec3 pos, vec3 dir, vec3 up)
+{
+	mListenerPosition = pos;
+
+	mAudio->setListenerPosition(pos);
+	mAudio->setListenerOrientation(dir, up);
+}
+
+float Mixer::calcAudibility(const Voice * voice) const
+{
+	float distance = (voice->mPosition - mListenerPosition).len();
+	if(distance >= voice->mMaxRadius)
+		return 0;
+
+	//inverse distance model clamped at reference distance
+	float refRadius = std::max(voice->mRefRadius, 0.0001f);
+	float attenuation = distance <= refRadius ? 1.0f : refRadius / distance;
+
+	return voice->mGain * attenuation;
+}
+
+void Mixer::pushParams(Voice * voice, uint32 flags)
+{
+	ISource * source = voice->mSource;
+
+	if(flags & Voice::dfPosition)
+	{
+		source->setPosition(voice->mPosition);
+		++mStats.paramPushesNum;
+	}
+	if(flags & Voice::dfVelocity)
+	{
+		source->setVelocity(voice->mVelocity);
+		++mStats.paramPushesNum;
+	}
+	if(flags & Voice::dfPitch)
+	{
+		source->setPitch(voice->mPitch);
+		++mStats.paramPushesNum;
+	}
+	if(flags & Voice::dfGain)
+	{
+		source->setGain(voice->mGain);
+		++mStats.paramPushesNum;
+	}
+	if(flags & Voice::dfLoop)
+	{
+		//streams are looped by decoder
+		source->setLoop(voice->mLoop && voice->mStream == NULL);
+		++mStats.paramPushesNum;
+	}
+	if(flags & Voice::dfRadius)
+	{
+		source->setRadius(voice->mMaxRadius, voice->mRefRadius);
+		++mStats.paramPushesNum;
+	}
+	if(flags & Voice::dfCone)
+	{
+		source->setCone(voice->mConeOuterAngle, voice->mConeInnerAngle, voice->mConeOuterGain);
+		++mStats.paramPushesNum;
+	}
+	if((flags & Voice::dfDirection) && voice->isCone())
+	{
+		source->setDirection(voice->mDirection);
+		++mStats.paramPushesNum;
+	}
+}
+
+void Mixer::makeReal(Voice * voice, ISource * source)
+{
+	voice->mSource = source;
+
+	pushParams(voice, Voice::dfAll);
+	voice->mDirty = 0;
+
+	StreamState * stream = voice->mStream;
+	if(stream != NULL)
+	{
+		if(stream->buffers.empty())
+		{
+			for(int i = 0; i < STREAM_BUFFERS_NUM; ++i)
+			{
+				IBuffer * buffer = mAudio->createBuffer();
+				if(buffer != NULL)
+					stream->buffers.push_back(buffer);
+			}
+			stream->freeBuffers = stream->buffers;
+		}
+
+		source->attachBuffer(NULL);
+		stream->started = false;
+
+		feedStream(voice);
+	}
+	else
+	{
+		source->attachBuffer(voice->mBuffer);
+		source->play();
+
+		//continue from where virtual voice is
+		float offset = voice->mPlayTime;
+		if(voice->mLoop && voice->mDuration > 0)
+			offset = fmodf(offset, voice->mDuration);
+
+		if(offset > 0)
+			source->offset(offset);
+	}
+}
+
+ISource * Mixer::makeVirtual(Voice * voice)
+{
+	ISource * source = voice->mSource;
+
+	source->stop();
+
+	//queued but not played data is dropped
+	StreamState * stream = voice->mStream;
+	if(stream != NULL)
+	{
+		IBuffer * buffer = NULL;
+		while((buffer = source->unqueueBuffer()) != NULL)
+		{
+			stream->freeBuffers.push_back(buffer);
+		}
+	}
+
+	source->attachBuffer(NULL);
+
+	voice->mSource = NULL;
+	voice->mDirty = Voice::dfAll;
+
+	return source;
+}
+
+void Mixer::feedStream(Voice * voice)
+{
+	StreamState * stream = voice->mStream;
+	ISource * source = voice->mSource;
+
+	IBuffer * buffer = NULL;
+	while((buffer = source->unqueueBuffer()) != NULL)
+	{
+		stream->freeBuffers.push_back(buffer);
+	}
+
+	bool consumed = false;
+
+	while(!stream->freeBuffers.empty())
+	{
+		uint64 readPos = stream->readPos.load(std::memory_order_relaxed);
+		uint64 available = stream->writePos.load(std::memory_order_acquire) - readPos;
+
+		uint32 size = (uint32)std::min<uint64>(available, stream->chunkSize);
+		size -= size % stream->blockAlign;
+
+		//wait for full buffer unless it is the end of stream
+		if(size == 0 || (size < stream->chunkSize && !stream->ended.load()))
+			break;
+
+		uint32 capacity = (uint32)stream->ring.size();
+		uint32 offset = (uint32)(readPos % capacity);
+		uint32 firstPart = std::min(size, capacity - offset);
+
+		memcpy(&stream->chunk[0], &stream->ring[offset], firstPart);
+		if(firstPart < size)
+			memcpy(&stream->chunk[firstPart], &stream->ring[0], size - firstPart);
+
+		stream->readPos.store(readPos + size, std::memory_order_release);
+
+		buffer = stream->freeBuffers.back();
+		stream->freeBuffers.pop_back();
+
+		buffer->fill(stream->frequency, stream->bits, stream->channels, size, &stream->chunk[0]);
+		source->queueBuffer(buffer);
+
+		consumed = true;
+	}
+
+	if(consumed)
+		mDecodeWake.notify_one();
+
+	bool nothingQueued = stream->freeBuffers.size() == stream->buffers.size();
+
+	if(nothingQueued)
+	{
+		bool drained = stream->writePos.load() - stream->readPos.load() < stream->blockAlign;
+		if(stream->ended.load() && drained)
+		{
+			voice->mState = Voice::vsStopped;
+		}
+		return;
+	}
+
+	//source stops when it plays all queued buffers before next ones are queued
+	if(source->getState() != ISource::PLAYING)
+	{
+		if(stream->started)
+			++mStats.underrunsNum;
+
+		source->play();
+		stream->started = true;
+	}
+}
+
+void Mixer::update(float dtime)
+{
+	SQ_PROFILE_FUNCTION();
+
+	mStats.paramPushesNum	= 0;
+	mStats.promotedNum		= 0;
+	mStats.demotedNum		= 0;
+
+	mCandidates.clear();
+
+	for(size_t i = 0; i < mVoices.size(); ++i)
+	{
+		Voice * voice = mVoices[i];
+
+		if(voice->mRestart)
+		{
+			voice->mRestart = false;
+
+			if(voice->mSource != NULL)
+			{
+				mFreeSources.push_back( makeVirtual(voice) );
+				++mStats.demotedNum;
+			}
+
+			if(voice->mStream != NULL)
+			{
+				StreamState * stream = voice->mStream;
+
+				std::unique_lock<std::mutex> lock(mStreamsMutex);
+				stream->stream->rewind();
+				stream->readPos.store(0);
+				stream->writePos.store(0);
+				stream->ended.store(false);
+				stream->decodedSinceRewind = false;
+			}
+		}
+
+		if(voice->mState == Voice::vsPlaying && voice->mStream == NULL)
+		{
+			voice->mPlayTime += dtime * voice->mPitch;
+
+			bool finished = false;
+			if(!voice->mLoop)
+			{
+				if(voice->mDuration > 0)
+					finished = voice->mPlayTime >= voice->mDuration;
+				else if(voice->mSource != NULL)
+					finished = voice->mSource->getState() == ISource::STOPPED;
+				else
+					finished = voice->mBuffer == NULL;
+			}
+
+			if(finished)
+				voice->mState = Voice::vsStopped;
+		}
+
+		voice->mAudibility = voice->mState == Voice::vsPlaying ? calcAudibility(voice) : 0;
+
+		if(voice->mAudibility >= MIN_AUDIBILITY)
+		{
+			mCandidates.push_back(voice);
+		}
+		else if(voice->mSource != NULL)
+		{
+			mFreeSources.push_back( makeVirtual(voice) );
+			++mStats.demotedNum;
+		}
+	}
+
+	VoiceOrder order;
+	order.realBonus = REAL_VOICE_BONUS;
+	std::sort(mCandidates.begin(), mCandidates.end(), order);
+
+	size_t realNum = std::min(mCandidates.size(), mSources.size());
+
+	//release sources first so they are free for promoted voices
+	for(size_t i = realNum; i < mCandidates.size(); ++i)
+	{
+		Voice * voice = mCandidates[i];
+		if(voice->mSource != NULL)
+		{
+			mFreeSources.push_back( makeVirtual(voice) );
+			++mStats.demotedNum;
+		}
+	}
+
+	for(size_t i = 0; i < realNum; ++i)
+	{
+		Voice * voice = mCandidates[i];
+
+		if(voice->mSource == NULL)
+		{
+			ISource * source = mFreeSources.back();
+			mFreeSources.pop_back();
+
+			makeReal(voice, source);
+			++mStats.promotedNum;
+		}
+		else
+		{
+			if(voice->mDirty != 0)
+			{
+				pushParams(voice, voice->mDirty);
+				voice->mDirty = 0;
+			}
+
+			if(voice->mStream != NULL)
+			{
+				feedStream(voice);
+			}
+		}
+	}
+
+	mStats.voicesNum		= (int)mVoices.size();
+	mStats.realVoicesNum	= (int)(mSources.size() - mFreeSources.size());
+	mStats.virtualVoicesNum	= mStats.voicesNum - mStats.realVoicesNum;
+}
+
+void Mixer::addStream(StreamState * stream)
+{
+	{
+		std::unique_lock<std::mutex> lock(mStreamsMutex);
+		mStreams.push_back(stream);
+	}
+	mDecodeWake.notify_one();
+}
+
+void Mixer::removeStream(StreamState * stream)
+{
+	{
+		std::unique_lock<std::mutex> lock(mStreamsMutex);
+		std::vector<StreamState *>::iterator it = std::find(mStreams.begin(), mStreams.end(), stream);
+		if(it != mStreams.end())
+			mStreams.erase(it);
+	}
+
+	for(size_t i = 0; i < stream->buffers.size(); ++i)
+	{
+		DELETE_PTR(stream->buffers[i]);
+	}
+
+	DELETE_PTR(stream->stream);
+	delete stream;
+}
+
+void Mixer::decodeLoop()
+{
+	Profiler::SetThreadName("Audio decoding");
+
+	std::unique_lock<std::mutex> lock(mStreamsMutex);
+
+	while(!mQuit)
+	{
+		{
+			SQ_PROFILE_ZONE("Mixer::decode");
+
+			for(size_t i = 0; i < mStreams.size(); ++i)
+			{
+				FillRing(mStreams[i]);
+			}
+		}
+
+		mDecodeWake.wait_for(lock, std::chrono::milliseconds(DECODE_PERIOD_MS));
+	}
+}
+
+void Mixer::FillRing(StreamState * stream)
+{
+	uint64 capacity = stream->ring.size();
+
+	while(!stream->ended.load())
+	{
+		uint64 writePos = stream->writePos.load(std::memory_order_relaxed);
+		uint64 freeSize = capacity - (writePos - stream->readPos.load(std::memory_order_acquire));
+
+		if(freeSize < std::min<uint64>(MIN_DECODE_SIZE, capacity))
+			return;
+
+		uint32 offset = (uint32)(writePos % capacity);
+		uint32 size = (uint32)std::min<uint64>(freeSize, capacity - offset);
+
+		uint32 decoded = stream->stream->read(&stream->ring[offset], size);
+		if(decoded == 0)
+		{
+			if(stream->loop.load() && stream->decodedSinceRewind)
+			{
+				stream->stream->rewind();
+				stream->decodedSinceRewind = false;
+				continue;
+			}
+
+			stream->ended.store(true);
+			return;
+		}
+
+		stream->decodedSinceRewind = true;
+		stream->writePos.store(writePos + decoded, std::memory_order_release);
+	}
+}
+
+}//namespace Audio {
+} //namespace Squirrel {
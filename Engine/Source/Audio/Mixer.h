@@ -0,0 +1,219 @@
+#pragma once
+
+#include "IAudio.h"
+#include "IStream.h"
+#include "../common/types.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace Squirrel {
+
+namespace Audio {
+
+//Voice manager above IAudio.
+//Any number of voices is mapped to fixed pool of hardware sources: most important audible
+//voices (by priority, then by gain attenuated with distance) are real, others are virtual and
+//only advance their play time. Voice parameters are pushed to sources once per update and only
+//if they changed. Streamed voices are decoded by separate thread to ring buffers.
+class SQCOMMON_API Mixer
+{
+	static Mixer * sActiveMixer;
+
+	struct StreamState;
+
+public:
+
+	class SQCOMMON_API Voice
+	{
+		friend class Mixer;
+
+		enum DirtyFlags
+		{
+			dfPosition	= 1 << 0,
+			dfVelocity	= 1 << 1,
+			dfDirection	= 1 << 2,
+			dfPitch		= 1 << 3,
+			dfGain		= 1 << 4,
+			dfLoop		= 1 << 5,
+			dfRadius	= 1 << 6,
+			dfCone		= 1 << 7,
+			dfAll		= 0xFF
+		};
+
+		enum State
+		{
+			vsStopped = 0,
+			vsPlaying,
+			vsPaused
+		};
+
+	public:
+
+		void setPosition(vec3 pos);
+		void setVelocity(vec3 v);
+		void setDirection(vec3 dir);
+
+		void setPitch(float pitch);
+		void setGain(float gain);
+		void setLoop(bool loop);
+
+		void setRadius(float maxRadius, float refRadius);
+		void setCone(float outerAngle, float innerAngle, float outerGain);
+
+		//voices with higher priority get sources first regardless of audibility
+		void setPriority(int priority)	{ mPriority = priority; }
+		int getPriority() const			{ return mPriority; }
+
+		//buffer is not owned, duration is used to finish virtual voices, 0 if unknown
+		void setBuffer(IBuffer * buffer, float duration);
+
+		//takes ownership of stream
+		void setStream(IStream * stream);
+
+		void play();
+		void stop();
+		void pause();
+
+		bool isPlaying() const	{ return mState == vsPlaying; }
+		bool isVirtual() const	{ return mSource == NULL; }
+
+		//gain attenuated by distance to listener at last update
+		float getAudibility() const { return mAudibility; }
+
+	private:
+
+		Voice(Mixer * mixer);
+		~Voice();
+
+		bool isCone() const;
+
+	private:
+
+		Mixer * mMixer;
+
+		vec3 mPosition;
+		vec3 mVelocity;
+		vec3 mDirection;
+
+		float mPitch;
+		float mGain;
+		bool mLoop;
+
+		float mMaxRadius;
+		float mRefRadius;
+
+		float mConeOuterAngle;
+		float mConeInnerAngle;
+		float mConeOuterGain;
+
+		int mPriority;
+
+		IBuffer * mBuffer;
+		float mDuration;
+
+		StreamState * mStream;
+
+		State mState;
+		bool mRestart;//play was called since last update
+		float mPlayTime;
+
+		uint32 mDirty;
+
+		ISource * mSource;//NULL for virtual voice
+
+		float mAudibility;
+	};
+
+	struct Stats
+	{
+		int voicesNum;
+		int realVoicesNum;
+		int virtualVoicesNum;
+
+		//last update
+		int paramPushesNum;
+		int promotedNum;//became real
+		int demotedNum;//became virtual
+
+		int underrunsNum;//total, stream source starved
+	};
+
+	static const int DEFAULT_SOURCES_NUM = 32;
+
+	static const int STREAM_BUFFERS_NUM = 3;
+	static const int STREAM_BUFFER_MS = 250;
+	static const int STREAM_RING_MS = 1000;
+
+	//voices quieter than that are not given sources
+	static const float MIN_AUDIBILITY;
+	//real voices are preferred over virtual ones with slightly higher audibility so sources do not flip every frame
+	static const float REAL_VOICE_BONUS;
+
+public:
+
+	//creates sourcesNum hardware sources of audio, fewer if audio runs out of them
+	Mixer(IAudio * audio, int sourcesNum = DEFAULT_SOURCES_NUM);
+	~Mixer();
+
+	static Mixer * Active() { return sActiveMixer; }
+	void setAsActive() { sActiveMixer = this; }
+
+	IAudio * getAudio() { return mAudio; }
+
+	Voice * createVoice();
+	void destroyVoice(Voice * voice);
+
+	void setListener(vec3 pos, vec3 dir, vec3 up);
+
+	//assigns sources to voices, pushes changed parameters and feeds streams
+	void update(float dtime);
+
+	int getSourcesNum() const { return (int)mSources.size(); }
+
+	const Stats& getStats() const { return mStats; }
+
+private:
+
+	float calcAudibility(const Voice * voice) const;
+
+	void makeReal(Voice * voice, ISource * source);
+	ISource * makeVirtual(Voice * voice);
+
+	void pushParams(Voice * voice, uint32 flags);
+
+	void feedStream(Voice * voice);
+
+	void addStream(StreamState * stream);
+	void removeStream(StreamState * stream);
+
+	void decodeLoop();
+	static void FillRing(StreamState * stream);
+
+private:
+
+	IAudio * mAudio;
+
+	std::vector<ISource *> mSources;
+	std::vector<ISource *> mFreeSources;
+
+	std::vector<Voice *> mVoices;
+	std::vector<Voice *> mCandidates;
+
+	vec3 mListenerPosition;
+
+	Stats mStats;
+
+	//decoding thread
+	std::thread mDecodeThread;
+	std::mutex mStreamsMutex;
+	std::condition_variable mDecodeWake;
+	std::vector<StreamState *> mStreams;
+	bool mQuit;
+};
+
+} //namespace Audio {
+
+} //namespace Squirrel {
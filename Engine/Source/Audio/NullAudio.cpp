@@ -0,0 +1,237 @@
+#include "NullAudio.h"
+#include <math.h>
+
+namespace Squirrel {
+namespace Audio {
+
+//////////////////////////////////////////////////////////////////////////
+// NullAudio
+
+NullAudio::NullAudio()
+{
+	resetStats();
+	mStats.sourcesNum = 0;
+	mStats.buffersNum = 0;
+}
+
+NullAudio::~NullAudio()
+{
+	ASSERT(mSources.empty());
+}
+
+bool NullAudio::init()
+{
+	return true;
+}
+
+void NullAudio::resetStats()
+{
+	mStats.paramCallsNum	= 0;
+	mStats.playCallsNum		= 0;
+	mStats.stopCallsNum		= 0;
+	mStats.attachCallsNum	= 0;
+	mStats.queuedBuffersNum	= 0;
+}
+
+void NullAudio::setListenerPosition(vec3 pos)
+{
+	mListenerPosition = pos;
+}
+
+void NullAudio::setListenerOrientation(vec3, vec3)
+{
+}
+
+void NullAudio::setListenerVelocity(vec3)
+{
+}
+
+void NullAudio::setMasterGain(float)
+{
+}
+
+void NullAudio::setDistanceModel(DISTANCE_MODEL)
+{
+}
+
+void NullAudio::setDoplerFactor(float)
+{
+}
+
+void NullAudio::setSpeedOfSound(float)
+{
+}
+
+IBuffer * NullAudio::createBuffer()
+{
+	return new NullBuffer(this);
+}
+
+ISource * NullAudio::createSource()
+{
+	return new NullSource(this);
+}
+
+void NullAudio::update(float dtime)
+{
+	for(std::list<NullSource *>::iterator it = mSources.begin(); it != mSources.end(); ++it)
+	{
+		(*it)->update(dtime);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NullBuffer
+
+NullBuffer::NullBuffer(NullAudio * audio):
+	mAudio(audio), mDuration(0)
+{
+	++mAudio->mStats.buffersNum;
+}
+
+NullBuffer::~NullBuffer()
+{
+	--mAudio->mStats.buffersNum;
+}
+
+bool NullBuffer::fill(int frequency, int bits, int channels, int size, void *)
+{
+	int bytesPerSecond = frequency * (bits / 8) * channels;
+	if(bytesPerSecond <= 0)
+		return false;
+
+	mDuration = (float)size / (float)bytesPerSecond;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NullSource
+
+NullSource::NullSource(NullAudio * audio):
+	mAudio(audio), mState(INITIAL), mPlayTime(0), mPitch(1), mLoop(false), mBuffer(NULL), mProcessedNum(0)
+{
+	mAudio->mSources.push_back(this);
+	++mAudio->mStats.sourcesNum;
+}
+
+NullSource::~NullSource()
+{
+	mAudio->mSources.remove(this);
+	--mAudio->mStats.sourcesNum;
+}
+
+void NullSource::setPosition(vec3)				{ ++mAudio->mStats.paramCallsNum; }
+void NullSource::setDirection(vec3)				{ ++mAudio->mStats.paramCallsNum; }
+void NullSource::setVelocity(vec3)				{ ++mAudio->mStats.paramCallsNum; }
+void NullSource::setGain(float)					{ ++mAudio->mStats.paramCallsNum; }
+void NullSource::setRadius(float, float)		{ ++mAudio->mStats.paramCallsNum; }
+void NullSource::setCone(float, float, float)	{ ++mAudio->mStats.paramCallsNum; }
+
+void NullSource::setPitch(float pitch)
+{
+	++mAudio->mStats.paramCallsNum;
+	mPitch = pitch;
+}
+
+void NullSource::setLoop(bool loop)
+{
+	++mAudio->mStats.paramCallsNum;
+	mLoop = loop;
+}
+
+void NullSource::play()
+{
+	++mAudio->mStats.playCallsNum;
+	if(mState != PAUSED)
+		mPlayTime = 0;
+	mState = PLAYING;
+}
+
+void NullSource::stop()
+{
+	++mAudio->mStats.stopCallsNum;
+	mState = STOPPED;
+	//all queued buffers become processed
+	mProcessedNum = (int)mQueue.size();
+}
+
+void NullSource::pause()
+{
+	if(mState == PLAYING)
+		mState = PAUSED;
+}
+
+void NullSource::offset(float seconds)
+{
+	mPlayTime = seconds;
+}
+
+void NullSource::attachBuffer(IBuffer * buffer)
+{
+	++mAudio->mStats.attachCallsNum;
+	mBuffer = static_cast<NullBuffer *>(buffer);
+	mQueue.clear();
+	mProcessedNum = 0;
+	mState = INITIAL;
+}
+
+void NullSource::queueBuffer(IBuffer * buffer)
+{
+	++mAudio->mStats.queuedBuffersNum;
+	mQueue.push_back(static_cast<NullBuffer *>(buffer));
+}
+
+IBuffer * NullSource::unqueueBuffer()
+{
+	if(mProcessedNum <= 0)
+		return NULL;
+
+	NullBuffer * buffer = mQueue.front();
+	mQueue.pop_front();
+	--mProcessedNum;
+	return buffer;
+}
+
+ISource::STATE NullSource::getState()
+{
+	return mState;
+}
+
+void NullSource::update(float dtime)
+{
+	if(mState != PLAYING)
+		return;
+
+	mPlayTime += dtime * mPitch;
+
+	if(!mQueue.empty())
+	{
+		//consume queued buffers, starved source stops
+		while(mProcessedNum < (int)mQueue.size() && mPlayTime >= mQueue[mProcessedNum]->getDuration())
+		{
+			mPlayTime -= mQueue[mProcessedNum]->getDuration();
+			++mProcessedNum;
+		}
+
+		if(mProcessedNum == (int)mQueue.size())
+		{
+			mState = STOPPED;
+			mPlayTime = 0;
+		}
+	}
+	else if(mBuffer != NULL && mPlayTime >= mBuffer->getDuration())
+	{
+		if(mLoop && mBuffer->getDuration() > 0)
+		{
+			mPlayTime = fmodf(mPlayTime, mBuffer->getDuration());
+		}
+		else
+		{
+			mState = STOPPED;
+			mPlayTime = 0;
+		}
+	}
+}
+
+}//namespace Audio {
+} //namespace Squirrel {
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "IAudio.h"
+#include "../common/types.h"
+#include <deque>
+#include <list>
+
+namespace Squirrel {
+
+namespace Audio {
+
+class NullSource;
+
+//Audio without device: sources only track their state and play time advanced by update,
+//calls are counted so voices scheduling can be measured without sound hardware
+class SQCOMMON_API NullAudio:
+	public IAudio
+{
+public:
+
+	struct Stats
+	{
+		uint64	paramCallsNum;//source parameters setters
+		uint64	playCallsNum;
+		uint64	stopCallsNum;
+		uint64	attachCallsNum;
+		uint64	queuedBuffersNum;
+		int		sourcesNum;
+		int		buffersNum;
+	};
+
+public:
+
+	NullAudio();
+	virtual ~NullAudio();
+
+	virtual bool init();
+
+	virtual void setListenerPosition(vec3 pos);
+	virtual void setListenerOrientation(vec3 dir, vec3 up);
+	virtual void setListenerVelocity(vec3 v);
+
+	virtual void setMasterGain(float gain);
+	virtual void setDistanceModel(DISTANCE_MODEL model);
+	virtual void setDoplerFactor(float factor);
+	virtual void setSpeedOfSound(float speed);
+
+	virtual IBuffer *	createBuffer();
+	virtual ISource *	createSource();
+
+	//advances play time of playing sources
+	void update(float dtime);
+
+	Stats& getStats() { return mStats; }
+	void resetStats();
+
+	vec3 getListenerPosition() const { return mListenerPosition; }
+
+private:
+
+	friend class NullSource;
+	friend class NullBuffer;
+
+	std::list<NullSource *> mSources;
+
+	vec3 mListenerPosition;
+
+	Stats mStats;
+};
+
+class SQCOMMON_API NullBuffer:
+	public IBuffer
+{
+	NullAudio * mAudio;
+	float mDuration;
+
+public:
+	NullBuffer(NullAudio * audio);
+	virtual ~NullBuffer();
+
+	virtual bool fill(int frequency, int bits, int channels, int size, void *data);
+
+	float getDuration() const { return mDuration; }
+};
+
+class SQCOMMON_API NullSource:
+	public ISource
+{
+	NullAudio * mAudio;
+
+	STATE mState;
+	float mPlayTime;
+	float mPitch;
+	bool mLoop;
+
+	NullBuffer * mBuffer;
+	std::deque<NullBuffer *> mQueue;
+	int mProcessedNum;//first buffers of queue which are played
+
+public:
+	NullSource(NullAudio * audio);
+	virtual ~NullSource();
+
+	virtual void setPosition(vec3 pos);
+	virtual void setDirection(vec3 dir);
+	virtual void setVelocity(vec3 v);
+
+	virtual void setPitch(float pitch);
+	virtual void setGain(float gain);
+
+	virtual void setLoop(bool loop);
+
+	virtual void setRadius(float maxRadius, float halfRadius);
+	virtual void setCone(float outerAngle, float innerAngle, float outerGain);
+
+	virtual void play();
+	virtual void stop();
+	virtual void pause();
+	virtual void offset(float seconds);
+
+	virtual void attachBuffer(IBuffer * buffer);
+
+	virtual void queueBuffer(IBuffer * buffer);
+	virtual IBuffer * unqueueBuffer();
+
+	virtual STATE getState();
+
+	void update(float dtime);
+};
+
+} //namespace Audio {
+
+} //namespace Squirrel {
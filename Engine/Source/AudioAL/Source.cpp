@@ -83,14 +83,47 @@ void Source::pause()
 
 void Source::offset(float seconds)
 {
-	//alSourcef(mId, AL_SEC_OFFSET, seconds);
+	alSourcef(mId, AL_SEC_OFFSET, seconds);
 }
 
 void Source::attachBuffer(IBuffer * buffer)
+{
+	mQueue.clear();
+
+	Buffer * alBuffer = static_cast<Buffer *>(buffer);
+	alSourcei(mId, AL_BUFFER, alBuffer != NULL ? alBuffer->getId() : 0);
+	CHECK_AL_ERROR;
+}
+
+void Source::queueBuffer(IBuffer * buffer)
 {
 	Buffer * alBuffer = static_cast<Buffer *>(buffer);
-	alSourcei(mId, AL_BUFFER, alBuffer->getId());
+	ALuint bufferId = alBuffer->getId();
+	alSourceQueueBuffers(mId, 1, &bufferId);
+	if(!CHECK_AL_ERROR)
+	{
+		mQueue.push_back(buffer);
+	}
+}
+
+IBuffer * Source::unqueueBuffer()
+{
+	if(mQueue.empty())
+		return NULL;
+
+	ALint processedNum = 0;
+	alGetSourcei(mId, AL_BUFFERS_PROCESSED, &processedNum);
+	if(processedNum <= 0)
+		return NULL;
+
+	//buffers are unqueued in order they were queued
+	ALuint bufferId = 0;
+	alSourceUnqueueBuffers(mId, 1, &bufferId);
 	CHECK_AL_ERROR;
+
+	IBuffer * buffer = mQueue.front();
+	mQueue.pop_front();
+	return buffer;
 }
 
 Source::STATE Source::getState()
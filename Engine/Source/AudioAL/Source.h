@@ -3,6 +3,7 @@
 #include <Audio/ISource.h>
 #include <common/types.h>
 #include "macros.h"
+#include <deque>
 
 namespace Squirrel {
 
@@ -40,11 +41,16 @@ public: //methods
 
 	virtual void attachBuffer(IBuffer * buffer);
 
+	virtual void queueBuffer(IBuffer * buffer);
+	virtual IBuffer * unqueueBuffer();
+
 	virtual STATE getState(); 
 
 private:
 
 	uint mId;
+
+	std::deque<IBuffer *> mQueue;
 };
 
 
@@ -7,6 +7,8 @@
 #include <Common/Platform.h>
 #include <FileSystem/Path.h>
 #include <FileSystem/FileStorage.h>
+#include <Audio/NullAudio.h>
+#include <Audio/Mixer.h>
 #ifdef _WIN32
 #include <Common/Windows/WindowsWindowManager.h>
 #endif
@@ -153,7 +155,37 @@ Audio::IAudio * Application::initAudio(const char_t * moduleName)
         audioModuleName = moduleName;
     }
 	
-	DynamicLibrary * audioDL = LoadModule(audioModuleName.c_str());
+	Audio::IAudio * audio = NULL;
+
+	if(audioModuleName == NULL_AUDIO_MODULE_NAME)
+	{
+		audio = new Audio::NullAudio();
+		audio->init();
+		audio->setAsActive();
+		mDestructionPool->addObject(audio);
+	}
+	else
+	{
+		audio = initAudioModule(audioModuleName.c_str());
+		if(audio == NULL)
+			return NULL;
+	}
+
+	int sourcesNum = getSettings()->getInt(AUDIO_SETTINGS_SECTION, AUDIO_SOURCES_NUM_SETTING, Audio::Mixer::DEFAULT_SOURCES_NUM);
+	if(sourcesNum > 0)
+	{
+		//destroyed before audio
+		Audio::Mixer * mixer = new Audio::Mixer(audio, sourcesNum);
+		mixer->setAsActive();
+		mDestructionPool->addObject(mixer);
+	}
+
+	return audio;
+}
+
+Audio::IAudio * Application::initAudioModule(const char_t * moduleName)
+{
+	DynamicLibrary * audioDL = LoadModule(moduleName);
 	
 	if(audioDL == NULL)
 		return NULL;
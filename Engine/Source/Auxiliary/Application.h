@@ -17,6 +17,7 @@ namespace Auxiliary {
     
 #define AUDIO_SETTINGS_SECTION      "Audio"
 #define AUDIO_MODULE_NAME_SETTING   "AudioModuleName"
+#define AUDIO_SOURCES_NUM_SETTING   "HardwareSources"
 
 #define GRAPHICS_SETTINGS_SECTION	"Graphics"
 #define RENDER_MODULE_NAME_SETTING	"RenderModuleName"
@@ -31,6 +32,7 @@ namespace Auxiliary {
 #define SWAP_INTERVAL_SETTING		"SwapInterval"
 	
 #define DEFAULT_AUDIO_MODULE_NAME	"SqOpenAL"
+#define NULL_AUDIO_MODULE_NAME		"Null"
 #define DEFAULT_RENDER_MODULE_NAME	"SqOpenGL"
 	
 #ifndef SQ_DEFAULT_WINDOW_TITLE
@@ -82,6 +84,8 @@ protected:
         For Windows it is dll file in the same folder as executable is.
         For Mac OS X it is dylib file in the app bundle libraries folder.
         For iOS this parameter is skipped and default audio system will be initialised (most likely OpenAL).
+        NULL_AUDIO_MODULE_NAME creates audio without device and module.
+     Mixer with AUDIO_SOURCES_NUM_SETTING hardware sources is created and set as active, 0 sources disables it.
      @return Audio system.
      */
     Audio::IAudio * initAudio(const char_t * moduleName = NULL);
@@ -129,6 +133,11 @@ protected:
      */
     Settings * getSettings();
 
+private:
+
+	/** Loads audio module, creates audio with its CreateAudio function and sets it as active. */
+	Audio::IAudio * initAudioModule(const char_t * moduleName);
+
 protected:    
     
     Window * mWindow;
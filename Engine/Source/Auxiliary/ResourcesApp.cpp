@@ -35,13 +35,7 @@ void ResourcesApp::onBecomeActive()
 	if(mResourceManager == NULL)
 		return;
 
-	if(mResourceManager->getProgramStorage() == NULL)
-		return;
-
-	if(Render::IRender::GetActive())
-		Render::IRender::GetActive()->flush(true);
-
-	mResourceManager->getProgramStorage()->checkModifications();
+	mResourceManager->checkModifications();
 }
 
 void ResourcesApp::initResourceManagement(const char_t * rootPath)
@@ -0,0 +1,64 @@
+#include "Allocator.h"
+#include <mutex>
+#include <algorithm>
+
+namespace Squirrel {
+
+namespace {
+
+std::mutex& RegistryMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+std::vector<Allocator *>& Registry()
+{
+	static std::vector<Allocator *> allocators;
+	return allocators;
+}
+
+}//namespace {
+
+Allocator::Allocator(const char * name)
+{
+	memset(&mStats, 0, sizeof(mStats));
+	mStats.name = name;
+
+	std::unique_lock<std::mutex> lock(RegistryMutex());
+	Registry().push_back(this);
+}
+
+Allocator::~Allocator()
+{
+	std::unique_lock<std::mutex> lock(RegistryMutex());
+	std::vector<Allocator *>& allocators = Registry();
+	allocators.erase(std::remove(allocators.begin(), allocators.end(), this), allocators.end());
+}
+
+void Allocator::GetAllStats(std::vector<Stats>& outStats)
+{
+	std::unique_lock<std::mutex> lock(RegistryMutex());
+	const std::vector<Allocator *>& allocators = Registry();
+
+	outStats.clear();
+	for(size_t i = 0; i < allocators.size(); ++i)
+	{
+		outStats.push_back(allocators[i]->mStats);
+	}
+}
+
+uint64 Allocator::GetHeapAllocationsNum()
+{
+	std::unique_lock<std::mutex> lock(RegistryMutex());
+	const std::vector<Allocator *>& allocators = Registry();
+
+	uint64 num = 0;
+	for(size_t i = 0; i < allocators.size(); ++i)
+	{
+		num += allocators[i]->mStats.heapAllocationsNum;
+	}
+	return num;
+}
+
+}//namespace Squirrel {
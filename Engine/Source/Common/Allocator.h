@@ -0,0 +1,61 @@
+#pragma once
+
+#include "macros.h"
+#include "types.h"
+#include <vector>
+
+namespace Squirrel {
+
+//Base of engine allocators, keeps statistics of allocator and registers it
+//so heap allocations of all allocators can be watched per frame
+class SQCOMMON_API Allocator
+{
+public:
+
+	struct Stats
+	{
+		const char *	name;
+
+		uint64	allocationsNum;//served by allocator, total
+		uint64	heapAllocationsNum;//blocks allocator itself took from heap, total
+
+		size_t	bytesUsed;
+		size_t	bytesReserved;
+		size_t	peakBytesUsed;
+	};
+
+	static const size_t DEFAULT_ALIGNMENT = 16;
+
+public:
+
+	Allocator(const char * name);
+	virtual ~Allocator();
+
+	const Stats& getStats() const { return mStats; }
+
+	//statistics of all existing allocators
+	static void GetAllStats(std::vector<Stats>& outStats);
+
+	//sum of heap allocations of all existing allocators, difference between frames shows
+	//whether steady state frame still touches heap
+	static uint64 GetHeapAllocationsNum();
+
+	static inline size_t AlignSize(size_t size, size_t alignment)
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+protected:
+
+	inline void onAllocate(size_t size)
+	{
+		++mStats.allocationsNum;
+		mStats.bytesUsed += size;
+		if(mStats.bytesUsed > mStats.peakBytesUsed)
+			mStats.peakBytesUsed = mStats.bytesUsed;
+	}
+
+	Stats mStats;
+};
+
+}//namespace Squirrel {
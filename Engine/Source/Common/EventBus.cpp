@@ -0,0 +1,310 @@
+#include "EventBus.h"
+#include <algorithm>
+#include <string.h>
+
+namespace Squirrel {
+
+namespace {
+
+const size_t MIN_TABLE_SIZE = 16;
+
+bool IsIdLess(const std::pair<EventId, int>& entry, EventId id)
+{
+	return entry.first < id;
+}
+
+}//namespace {
+
+EventListener::~EventListener()
+{
+	while(!mSubscriptions.empty())
+	{
+		mSubscriptions.back().bus->unsubscribeAll(this);
+	}
+}
+
+EventBus::EventBus():
+	mDispatchDepth(0)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+EventBus::~EventBus()
+{
+	//listeners forget this bus, channels are not touched
+	for(size_t c = 0; c < mChannels.size(); ++c)
+	{
+		std::vector<EventListener *>& listeners = mChannels[c].listeners;
+		for(size_t i = 0; i < listeners.size(); ++i)
+		{
+			if(listeners[i] == NULL)
+				continue;
+
+			std::vector<EventListener::Subscription>& subscriptions = listeners[i]->mSubscriptions;
+			for(size_t j = 0; j < subscriptions.size(); )
+			{
+				if(subscriptions[j].bus == this)
+				{
+					subscriptions[j] = subscriptions.back();
+					subscriptions.pop_back();
+				}
+				else
+				{
+					++j;
+				}
+			}
+		}
+	}
+}
+
+EventBus * EventBus::Default()
+{
+	static EventBus * sDefault = new EventBus();
+	return sDefault;
+}
+
+int EventBus::findChannel(EventId id) const
+{
+	std::vector<std::pair<EventId, int> >::const_iterator it = std::lower_bound(mChannelIndex.begin(), mChannelIndex.end(), id, &IsIdLess);
+	if(it == mChannelIndex.end() || it->first != id)
+		return -1;
+	return it->second;
+}
+
+void EventBus::subscribe(EventId id, EventListener * listener)
+{
+	int channelIndex = findChannel(id);
+	if(channelIndex < 0)
+	{
+		channelIndex = (int)mChannels.size();
+
+		mChannels.push_back(Channel());
+		mChannels.back().id = id;
+		mChannels.back().deadNum = 0;
+
+		std::vector<std::pair<EventId, int> >::iterator it = std::lower_bound(mChannelIndex.begin(), mChannelIndex.end(), id, &IsIdLess);
+		mChannelIndex.insert(it, std::make_pair(id, channelIndex));
+	}
+
+	Channel& channel = mChannels[channelIndex];
+
+	for(size_t i = 0; i < listener->mSubscriptions.size(); ++i)
+	{
+		const EventListener::Subscription& subscription = listener->mSubscriptions[i];
+		if(subscription.bus == this && subscription.channel == channelIndex)
+			return;
+	}
+
+	EventListener::Subscription subscription = { this, channelIndex, (int)channel.listeners.size() };
+	listener->mSubscriptions.push_back(subscription);
+
+	channel.listeners.push_back(listener);
+}
+
+void EventBus::unsubscribe(EventId id, EventListener * listener)
+{
+	int channelIndex = findChannel(id);
+	if(channelIndex < 0)
+		return;
+
+	std::vector<EventListener::Subscription>& subscriptions = listener->mSubscriptions;
+	for(size_t i = 0; i < subscriptions.size(); ++i)
+	{
+		if(subscriptions[i].bus == this && subscriptions[i].channel == channelIndex)
+		{
+			int slot = subscriptions[i].slot;
+			subscriptions[i] = subscriptions.back();
+			subscriptions.pop_back();
+
+			removeSlot(channelIndex, slot);
+			return;
+		}
+	}
+}
+
+void EventBus::unsubscribeAll(EventListener * listener)
+{
+	std::vector<EventListener::Subscription>& subscriptions = listener->mSubscriptions;
+
+	size_t i = 0;
+	while(i < subscriptions.size())
+	{
+		if(subscriptions[i].bus != this)
+		{
+			++i;
+			continue;
+		}
+
+		int channelIndex = subscriptions[i].channel;
+		int slot = subscriptions[i].slot;
+		subscriptions[i] = subscriptions.back();
+		subscriptions.pop_back();
+
+		removeSlot(channelIndex, slot);
+	}
+}
+
+void EventBus::removeSlot(int channelIndex, int slot)
+{
+	Channel& channel = mChannels[channelIndex];
+
+	//slots are kept while they are iterated
+	if(mDispatchDepth > 0)
+	{
+		channel.listeners[slot] = NULL;
+		if(channel.deadNum++ == 0)
+			mDirtyChannels.push_back(channelIndex);
+		return;
+	}
+
+	//move last listener to free slot
+	EventListener * moved = channel.listeners.back();
+	channel.listeners[slot] = moved;
+	channel.listeners.pop_back();
+
+	if(slot < (int)channel.listeners.size() && moved != NULL)
+	{
+		std::vector<EventListener::Subscription>& subscriptions = moved->mSubscriptions;
+		for(size_t i = 0; i < subscriptions.size(); ++i)
+		{
+			if(subscriptions[i].bus == this && subscriptions[i].channel == channelIndex)
+			{
+				subscriptions[i].slot = slot;
+				break;
+			}
+		}
+	}
+}
+
+void EventBus::compact(int channelIndex)
+{
+	Channel& channel = mChannels[channelIndex];
+
+	size_t i = 0;
+	while(i < channel.listeners.size())
+	{
+		if(channel.listeners[i] != NULL)
+			++i;
+		else
+			removeSlot(channelIndex, (int)i);
+	}
+
+	channel.deadNum = 0;
+}
+
+void EventBus::dispatch(int channelIndex, const Event& event)
+{
+	++mDispatchDepth;
+
+	//listeners subscribed by callbacks get next event, channels may be added, so array is accessed by index
+	size_t listenersNum = mChannels[channelIndex].listeners.size();
+	for(size_t i = 0; i < listenersNum; ++i)
+	{
+		EventListener * listener = mChannels[channelIndex].listeners[i];
+		if(listener != NULL)
+			listener->onEvent(event);
+	}
+
+	if(--mDispatchDepth == 0)
+	{
+		for(size_t i = 0; i < mDirtyChannels.size(); ++i)
+		{
+			compact(mDirtyChannels[i]);
+		}
+		mDirtyChannels.clear();
+	}
+}
+
+void EventBus::send(const Event& event)
+{
+	++mStats.dispatchedNum;
+
+	int channelIndex = findChannel(event.id);
+	if(channelIndex >= 0)
+		dispatch(channelIndex, event);
+}
+
+size_t EventBus::HashEvent(const Event& event)
+{
+	size_t hash = event.id;
+	hash = hash * 31 + (size_t)event.sender;
+	hash = hash * 31 + (size_t)event.param;
+	return hash ^ (hash >> 16);
+}
+
+void EventBus::post(const Event& event, Queue queue)
+{
+	std::unique_lock<std::mutex> lock(mQueueMutex);
+
+	++mStats.postedNum;
+
+	PendingQueue& pending = mQueues[queue];
+
+	//table is kept at most half full
+	if((pending.events.size() + 1) * 2 > pending.table.size())
+	{
+		size_t tableSize = std::max(pending.table.size() * 2, MIN_TABLE_SIZE);
+		pending.table.assign(tableSize, 0);
+
+		for(size_t i = 0; i < pending.events.size(); ++i)
+		{
+			size_t pos = HashEvent(pending.events[i]) & (tableSize - 1);
+			while(pending.table[pos] != 0)
+			{
+				pos = (pos + 1) & (tableSize - 1);
+			}
+			pending.table[pos] = (int)i + 1;
+		}
+	}
+
+	size_t mask = pending.table.size() - 1;
+	size_t pos = HashEvent(event) & mask;
+	while(pending.table[pos] != 0)
+	{
+		if(pending.events[pending.table[pos] - 1] == event)
+		{
+			++mStats.coalescedNum;
+			return;
+		}
+		pos = (pos + 1) & mask;
+	}
+
+	pending.table[pos] = (int)pending.events.size() + 1;
+	pending.events.push_back(event);
+}
+
+void EventBus::flush(Queue queue)
+{
+	PendingQueue& pending = mQueues[queue];
+
+	std::vector<Event> events;
+	{
+		std::unique_lock<std::mutex> lock(mQueueMutex);
+		if(pending.events.empty())
+			return;
+
+		events.swap(pending.events);
+		std::fill(pending.table.begin(), pending.table.end(), 0);
+	}
+
+	for(size_t i = 0; i < events.size(); ++i)
+	{
+		send(events[i]);
+	}
+
+	//array is reused by next frame unless events have been posted meanwhile
+	std::unique_lock<std::mutex> lock(mQueueMutex);
+	if(pending.events.empty())
+	{
+		events.clear();
+		pending.events.swap(events);
+	}
+}
+
+EventBus::Stats EventBus::getStats()
+{
+	std::unique_lock<std::mutex> lock(mQueueMutex);
+	return mStats;
+}
+
+}//namespace Squirrel {
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "macros.h"
+#include "types.h"
+#include <vector>
+#include <mutex>
+#include <type_traits>
+
+namespace Squirrel {
+
+typedef uint32 EventId;
+
+//FNV-1a hash of event name
+constexpr EventId HashEventId(const char_t * name, EventId hash = 2166136261u)
+{
+	return *name == 0 ? hash : HashEventId(name + 1, (hash ^ (EventId)(unsigned char)*name) * 16777619u);
+}
+
+//id of event name literal, hashed by compiler
+#define SQ_EVENT_ID(name) (std::integral_constant<Squirrel::EventId, Squirrel::HashEventId(name)>::value)
+
+struct Event
+{
+	Event(): id(0), sender(NULL), param(0) {}
+	Event(EventId eventId, const void * eventSender = NULL, int eventParam = 0): id(eventId), sender(eventSender), param(eventParam) {}
+
+	bool operator == (const Event& other) const { return id == other.id && sender == other.sender && param == other.param; }
+
+	EventId			id;
+	const void *	sender;
+	int				param;
+};
+
+class EventBus;
+
+//Receives events of ids it is subscribed to, unsubscribes from all buses when destroyed.
+class SQCOMMON_API EventListener
+{
+	friend class EventBus;
+
+	struct Subscription
+	{
+		EventBus *	bus;
+		int			channel;
+		int			slot;
+	};
+
+public:
+	EventListener() {}
+	virtual ~EventListener();
+
+	virtual void onEvent(const Event& event) = 0;
+
+private:
+	std::vector<Subscription> mSubscriptions;
+};
+
+//Dispatches events to listeners subscribed to their ids.
+//Listeners of id are kept in contiguous array, arrays are found by binary search of sorted ids.
+//Events are sent immediately or posted to queue which is flushed at defined point of frame,
+//posted event equal to one waiting in the same queue is dropped.
+//Posting is thread safe, everything else is done by main thread.
+class SQCOMMON_API EventBus
+{
+public:
+
+	enum Queue
+	{
+		qUpdate = 0,//before world is updated
+		qFrameEnd,//after frame is rendered
+		qNum
+	};
+
+	struct Stats
+	{
+		int postedNum;
+		int coalescedNum;//dropped as duplicates
+		int dispatchedNum;//sent and flushed events, listeners may be none
+	};
+
+private:
+
+	struct Channel
+	{
+		EventId							id;
+		std::vector<EventListener *>	listeners;
+		int								deadNum;//unsubscribed while dispatching
+	};
+
+	struct PendingQueue
+	{
+		std::vector<Event>	events;
+		std::vector<int>	table;//indices of events + 1 by hash, open addressing
+	};
+
+	EventBus(const EventBus&);
+	const EventBus& operator=(const EventBus&);
+
+public:
+	EventBus();
+	~EventBus();
+
+	//never destroyed, so listeners released at exit stay valid
+	static EventBus * Default();
+
+	void subscribe(EventId id, EventListener * listener);
+	void unsubscribe(EventId id, EventListener * listener);
+	void unsubscribeAll(EventListener * listener);
+
+	//dispatches on calling thread
+	void send(const Event& event);
+
+	//any thread
+	void post(const Event& event, Queue queue = qUpdate);
+
+	//dispatches events of queue in order they were posted, events posted meanwhile wait for next flush
+	void flush(Queue queue);
+
+	Stats getStats();
+
+private:
+
+	int findChannel(EventId id) const;
+	void dispatch(int channelIndex, const Event& event);
+
+	//removes listener from slot keeping slots of others up to date
+	void removeSlot(int channelIndex, int slot);
+	void compact(int channelIndex);
+
+	static size_t HashEvent(const Event& event);
+
+private:
+
+	std::vector<Channel>		mChannels;//never removed, indices are kept by listeners
+	std::vector<std::pair<EventId, int> >	mChannelIndex;//sorted by id
+
+	int							mDispatchDepth;
+	std::vector<int>			mDirtyChannels;
+
+	std::mutex					mQueueMutex;
+	PendingQueue				mQueues[qNum];
+
+	Stats						mStats;
+};
+
+}//namespace Squirrel {
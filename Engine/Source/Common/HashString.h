@@ -40,6 +40,17 @@ public:
 		computeHash();
 	}
 
+	//assigns in place, so string capacity is kept for reused objects
+	inline void setString(const char_t * str, size_t length) { 
+		mString.assign(str, length);
+		computeHash();
+	}
+
+	inline void clear() { 
+		mString.clear();
+		computeHash();
+	}
+
 	inline void computeHash()
 	{
 		mHash = ComputeHash((const unsigned char *)mString.c_str());
@@ -98,10 +98,11 @@ public:
 			if(!map[firstFree])//firstFree cell is empty
 			{
 				//printf("free cell - OK\n");
+				_ID id = firstFree;
 				map[firstFree] = obj;
 				++firstFree;
 				++count;				
-				return firstFree;
+				return id;
 			}
 			else//finding free cell
 			{
@@ -0,0 +1,91 @@
+#include "LinearAllocator.h"
+
+namespace Squirrel {
+
+LinearAllocator::LinearAllocator(const char * name, size_t blockSize):
+	Allocator(name), mBlockSize(blockSize), mCurrent(NULL), mEnd(NULL), mGeneration(0)
+{
+}
+
+LinearAllocator::~LinearAllocator()
+{
+	releaseBlocks();
+}
+
+LinearAllocator& LinearAllocator::Frame()
+{
+	static LinearAllocator allocator("Frame");
+	return allocator;
+}
+
+void * LinearAllocator::allocate(size_t size, size_t alignment)
+{
+	byte * ptr = (byte *)AlignSize((size_t)mCurrent, alignment);
+
+	if(mCurrent == NULL || ptr + size > mEnd)
+	{
+		addBlock(size + alignment);
+		ptr = (byte *)AlignSize((size_t)mCurrent, alignment);
+	}
+
+	size_t usedSize = (ptr + size) - mCurrent;
+	mCurrent = ptr + size;
+
+	onAllocate(usedSize);
+
+	return ptr;
+}
+
+void LinearAllocator::addBlock(size_t minSize)
+{
+	Block block;
+	block.size = minSize > mBlockSize ? minSize : mBlockSize;
+	block.data = new byte[block.size];
+
+	mBlocks.push_back(block);
+
+	mCurrent = block.data;
+	mEnd = block.data + block.size;
+
+	++mStats.heapAllocationsNum;
+	mStats.bytesReserved += block.size;
+}
+
+void LinearAllocator::releaseBlocks()
+{
+	for(size_t i = 0; i < mBlocks.size(); ++i)
+	{
+		delete[] mBlocks[i].data;
+	}
+	mBlocks.clear();
+
+	mStats.bytesReserved = 0;
+	mCurrent = mEnd = NULL;
+}
+
+void LinearAllocator::reset()
+{
+	++mGeneration;
+
+	//several blocks are merged, so the same use fits to one block next time
+	if(mBlocks.size() > 1)
+	{
+		size_t totalSize = 0;
+		for(size_t i = 0; i < mBlocks.size(); ++i)
+		{
+			totalSize += mBlocks[i].size;
+		}
+
+		releaseBlocks();
+		addBlock(totalSize);
+	}
+	else if(!mBlocks.empty())
+	{
+		mCurrent = mBlocks[0].data;
+		mEnd = mBlocks[0].data + mBlocks[0].size;
+	}
+
+	mStats.bytesUsed = 0;
+}
+
+}//namespace Squirrel {
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Allocator.h"
+#include <new>
+
+namespace Squirrel {
+
+//Bump allocator: allocations are not freed one by one, reset frees all at once.
+//Blocks are kept by reset, if previous use did not fit to one block they are replaced with
+//one block of total size, so repeated similar use does not touch heap.
+//Not thread safe.
+class SQCOMMON_API LinearAllocator:
+	public Allocator
+{
+	struct Block
+	{
+		byte *	data;
+		size_t	size;
+	};
+
+public:
+
+	static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+public:
+
+	LinearAllocator(const char * name, size_t blockSize = DEFAULT_BLOCK_SIZE);
+	~LinearAllocator();
+
+	//allocator of main thread, it is reset at the beginning of every frame,
+	//so memory of it must not be kept till next frame
+	static LinearAllocator& Frame();
+
+	void * allocate(size_t size, size_t alignment = DEFAULT_ALIGNMENT);
+
+	template <class T>
+	T * allocateArray(size_t count)
+	{
+		return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	//destructor of object is never called
+	template <class T>
+	T * create()
+	{
+		return new (allocate(sizeof(T), alignof(T))) T();
+	}
+
+	void reset();
+
+	//reset number, lets users check that memory was taken in the same frame
+	uint32 getGeneration() const { return mGeneration; }
+
+private:
+
+	void addBlock(size_t minSize);
+	void releaseBlocks();
+
+private:
+
+	std::vector<Block> mBlocks;
+	size_t mBlockSize;
+
+	byte * mCurrent;
+	byte * mEnd;
+
+	uint32 mGeneration;
+};
+
+}//namespace Squirrel {
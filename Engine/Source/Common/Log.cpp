@@ -5,7 +5,10 @@
 #include "Log.h"
 #include "TimeCounter.h"
 #include "Platform.h"
+#include "Profiler.h"
 #include <cstdio>
+#include <cstring>
+#include <chrono>
 
 #ifdef	_WIN32
 # pragma	warning (disable:4996)
@@ -13,6 +16,26 @@
 
 namespace Squirrel {
 
+namespace {
+
+//queue of calling thread, registered on first record
+thread_local void * sThreadQueue = NULL;
+
+//file buffer of writer, it is flushed after every written batch anyway
+const size_t FILE_BUFFER_SIZE = 1 << 16;
+
+const size_t MAX_MODULE_LENGTH = 256;
+
+//producer gives up and drops record if writer does not free queue in time
+const uint64 MAX_WAIT_FOR_WRITER_NS = 100000000;
+
+inline uint32 AlignRecordSize(uint32 size, uint32 alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+}//namespace {
+
 int ShowMessageBox(const char * title, const char * content, int type)
 {
 	//#ifdef _WIN32
@@ -20,64 +43,131 @@ int ShowMessageBox(const char * title, const char * content, int type)
     return 0;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Log::RateLimit
+
+Log::RateLimit::RateLimit(int maxPerSecond):
+	mMaxPerSecond(maxPerSecond), mWindowStart(0), mCount(0), mSuppressedNum(0)
+{
+}
+
+bool Log::RateLimit::allow(uint32 ticks, uint32& suppressedNum)
+{
+	uint32 windowStart = mWindowStart.load(std::memory_order_relaxed);
+	if(ticks - windowStart >= 1000 &&
+		mWindowStart.compare_exchange_strong(windowStart, ticks, std::memory_order_relaxed))
+	{
+		mCount.store(0, std::memory_order_relaxed);
+	}
+
+	if(mCount.fetch_add(1, std::memory_order_relaxed) >= mMaxPerSecond)
+	{
+		mSuppressedNum.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	suppressedNum = mSuppressedNum.exchange(0, std::memory_order_relaxed);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Log
+
+Log::ThreadQueue::ThreadQueue():
+	head(0), tail(0), droppedNum(0), bytes(CAPACITY), nullStream(NULL), hasPending(false)
+{
+}
+
 Log& Log::Instance()
 {
-	static Log instance;
-	return instance;
+	//never destroyed: records of threads still running at exit are written by finish
+	static Log * instance = new Log();
+	return *instance;
 }
 
 Log::Log():
-	mInitialised(false), mSeverity(sevInformation)
+	mFile(NULL), mSeverity(sevInformation), mInitialised(false), mQuit(false), mWriterRunning(false), mDroppedNum(0)
 {
 	mStartTicks	= TimeCounter::GetTicks();
 }
 
 Log::~Log()
 {
+	stopWriter();
+
+	for(size_t i = 0; i < mQueues.size(); ++i)
+	{
+		DELETE_PTR(mQueues[i]);
+	}
+}
+
+Log::Severity Log::getSeverity()
+{
+	return mSeverity;
+}
+
+void Log::setSeverity(Severity maxSev)
+{
+	mSeverity = maxSev;
 }
 
 void Log::finish()
 {
 	report(NULL, "END LOG_FILE", sevCriticalError);
 	flush();
+	stopWriter();
 }
 
 void Log::init(const char_t * fname, Severity maxSev)
 {
+	stopWriter();
+
 	mFileName	= fname;
 	mSeverity	= maxSev;
 	mStartTicks	= TimeCounter::GetTicks();
 	mInitialised = true;
-	mMessages.clear();
 
-	//create file
-	FILE * file = NULL;
-	file = fopen(fname, "w+");
-	if(file)
+	//file stays opened till finish
+	mFile = fopen(fname, "w+");
+	if(mFile)
 	{
-		fprintf(file,"%s\n\n", "BEGIN LOG_FILE");
-		fclose(file);
+		setvbuf(mFile, NULL, _IOFBF, FILE_BUFFER_SIZE);
+		fprintf(mFile,"%s\n\n", "BEGIN LOG_FILE");
+		fflush(mFile);
 	}
+
+	mQuit = false;
+	mWriterRunning.store(true);
+	mWriter = std::thread(&Log::writerLoop, this);
 }
 
-void Log::flush()
+void Log::stopWriter()
 {
-	if(mInitialised)
+	if(!mWriter.joinable())
+		return;
+
+	mWriterRunning.store(false);
+
 	{
-		FILE * file = NULL;
-		file = fopen(mFileName.c_str(), "a+");
-		if(file)
-		{
-			fprintf(file,"%s", mMessages.str().c_str());
-		
-			fclose(file);
-		}
+		std::unique_lock<std::mutex> lock(mWriterMutex);
+		mQuit = true;
 	}
+	mWriterWake.notify_one();
+	mWriter.join();
 
-	Platform::DebugLog(mMessages.str().c_str());
+	if(mFile)
+	{
+		fclose(mFile);
+		mFile = NULL;
+	}
+}
 
-	mMessages.str(std::string());
-	mDummyStream.str(std::string());
+void Log::flush()
+{
+	if(commit(getThreadQueue()))
+	{
+		mWriterWake.notify_one();
+	}
 }
 
 void Log::report(const char_t * module, const char_t * _report, Severity sev)
@@ -98,49 +188,269 @@ void Log::warning(const char_t * module, const char_t * _report)
 
 std::ostream& Log::stream(Severity sev)
 {
-	return stream(NULL, sev);
+	return beginRecord(rkMessage, NULL, sev, NULL);
 }
 
 std::ostream& Log::stream(const char_t * module, Severity sev)
 {
+	return beginRecord(rkMessage, module, sev, NULL);
+}
+
+std::ostream& Log::streamError(const char_t * module)
+{
+	return beginRecord(rkError, module, sevError, NULL);
+}
+
+std::ostream& Log::streamWarning(const char_t * module)
+{
+	return beginRecord(rkWarning, module, sevWarning, NULL);
+}
+
+std::ostream& Log::stream(const char_t * module, Severity sev, RateLimit& limit)
+{
+	return beginRecord(rkMessage, module, sev, &limit);
+}
+
+std::ostream& Log::streamError(const char_t * module, RateLimit& limit)
+{
+	return beginRecord(rkError, module, sevError, &limit);
+}
+
+std::ostream& Log::streamWarning(const char_t * module, RateLimit& limit)
+{
+	return beginRecord(rkWarning, module, sevWarning, &limit);
+}
+
+Log::ThreadQueue * Log::getThreadQueue()
+{
+	ThreadQueue * queue = static_cast<ThreadQueue *>(sThreadQueue);
+	if(queue == NULL)
+	{
+		queue = new ThreadQueue();
+
+		std::unique_lock<std::mutex> lock(mQueuesMutex);
+		mQueues.push_back(queue);
+
+		sThreadQueue = queue;
+	}
+	return queue;
+}
+
+std::ostream& Log::beginRecord(RecordKind kind, const char_t * module, Severity sev, RateLimit * limit)
+{
+	ThreadQueue * queue = getThreadQueue();
+
+	//previous record of this thread is complete
+	commit(queue);
+
 	if(sev > mSeverity)
 	{
-		return mDummyStream;
+		return queue->nullStream;
 	}
 
 	uint32 ticks = TimeCounter::GetTicks() - mStartTicks;
 
-	mMessages << std::endl << ticks << "\t\t" << (module != NULL ? module : "") << (module != NULL ? " -> " : "");
+	uint32 suppressedNum = 0;
+	if(limit != NULL && !limit->allow(ticks, suppressedNum))
+	{
+		return queue->nullStream;
+	}
+
+	queue->hasPending				= true;
+	queue->pending.ticks			= ticks;
+	queue->pending.kind				= (uint16)kind;
+	queue->pending.suppressedNum	= suppressedNum;
+	queue->pendingModule			= module != NULL ? module : "";
 
-	return mMessages;
+	return queue->message;
 }
 
-std::ostream& Log::streamError(const char_t * module)
+bool Log::commit(ThreadQueue * queue)
 {
-	if(sevError > mSeverity)
+	if(!queue->hasPending)
+		return false;
+
+	queue->hasPending = false;
+
+	const std::string& text = queue->message.str();
+
+	const uint32 headerSize = sizeof(RecordHeader);
+
+	uint32 moduleLength = (uint32)std::min<size_t>(queue->pendingModule.length(), MAX_MODULE_LENGTH);
+	uint32 textLength = (uint32)text.length();
+
+	//long records are cut to keep queue usable
+	const uint32 maxSize = ThreadQueue::CAPACITY / 4;
+	if(headerSize + moduleLength + textLength > maxSize)
+		textLength = maxSize - headerSize - moduleLength;
+
+	uint32 size = AlignRecordSize(headerSize + moduleLength + textLength, headerSize);
+
+	uint32 head = queue->head.load(std::memory_order_relaxed);
+	uint32 tail = queue->tail.load(std::memory_order_acquire);
+
+	uint32 offset = head & (ThreadQueue::CAPACITY - 1);
+	uint32 tillEnd = ThreadQueue::CAPACITY - offset;
+
+	//record is not split, rest of queue is skipped instead
+	uint32 needed = tillEnd < size ? tillEnd + size : size;
+
+	//full queue waits for writer, records are dropped only if there is no writer
+	if(ThreadQueue::CAPACITY - (head - tail) < needed && mWriterRunning.load(std::memory_order_relaxed))
 	{
-		return mDummyStream;
+		SQ_PROFILE_ZONE("Log::waitForWriter");
+
+		uint64 waitEnd = Profiler::Now() + MAX_WAIT_FOR_WRITER_NS;
+		do
+		{
+			mWriterWake.notify_one();
+			std::this_thread::yield();
+			tail = queue->tail.load(std::memory_order_acquire);
+		}
+		while(ThreadQueue::CAPACITY - (head - tail) < needed && Profiler::Now() < waitEnd);
 	}
 
-	uint32 ticks = TimeCounter::GetTicks() - mStartTicks;
+	if(ThreadQueue::CAPACITY - (head - tail) < needed)
+	{
+		queue->droppedNum.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		if(tillEnd < size)
+		{
+			RecordHeader * padding = reinterpret_cast<RecordHeader *>(&queue->bytes[offset]);
+			padding->size = tillEnd;
+			padding->kind = rkPadding;
+
+			head += tillEnd;
+			offset = 0;
+		}
+
+		RecordHeader * header = reinterpret_cast<RecordHeader *>(&queue->bytes[offset]);
+		*header = queue->pending;
+		header->size = size;
+		header->moduleLength = (uint16)moduleLength;
+
+		byte * chars = &queue->bytes[offset + headerSize];
+		memcpy(chars, queue->pendingModule.c_str(), moduleLength);
+		memcpy(chars + moduleLength, text.c_str(), textLength);
+
+		//text length is restored from size by trailing zeros
+		memset(chars + moduleLength + textLength, 0, size - headerSize - moduleLength - textLength);
+
+		queue->head.store(head + size, std::memory_order_release);
+	}
 
-	mMessages << std::endl << ticks << "\tError: " << (module != NULL ? module : "") << (module != NULL ? " -> " : "");
+	queue->message.str(std::string());
+	queue->message.clear();
 
-	return mMessages;
+	return true;
 }
 
-std::ostream& Log::streamWarning(const char_t * module)
+void Log::drain(ThreadQueue * queue, std::string& out)
 {
-	if(sevWarning > mSeverity)
+	uint32 tail = queue->tail.load(std::memory_order_relaxed);
+	uint32 head = queue->head.load(std::memory_order_acquire);
+
+	while(tail != head)
 	{
-		return mDummyStream;
+		uint32 offset = tail & (ThreadQueue::CAPACITY - 1);
+		const RecordHeader * header = reinterpret_cast<const RecordHeader *>(&queue->bytes[offset]);
+
+		if(header->kind != rkPadding)
+		{
+			const char * chars = reinterpret_cast<const char *>(&queue->bytes[offset + sizeof(RecordHeader)]);
+			const char * text = chars + header->moduleLength;
+
+			size_t textLength = header->size - sizeof(RecordHeader) - header->moduleLength;
+			while(textLength > 0 && text[textLength - 1] == 0)
+				--textLength;
+
+			char ticks[16];
+			sprintf(ticks, "%u", header->ticks);
+
+			out += '\n';
+			out += ticks;
+
+			if(header->kind == rkError)
+				out += "\tError: ";
+			else if(header->kind == rkWarning)
+				out += "\tWarning: ";
+			else
+				out += "\t\t";
+
+			if(header->moduleLength > 0)
+			{
+				out.append(chars, header->moduleLength);
+				out += " -> ";
+			}
+
+			out.append(text, textLength);
+
+			if(header->suppressedNum > 0)
+			{
+				char suppressed[64];
+				sprintf(suppressed, " (%u similar records suppressed)", header->suppressedNum);
+				out += suppressed;
+			}
+		}
+
+		tail += header->size;
 	}
 
-	uint32 ticks = TimeCounter::GetTicks() - mStartTicks;
+	queue->tail.store(tail, std::memory_order_release);
+}
 
-	mMessages << std::endl << ticks << "\tWarning: " << (module != NULL ? module : "") << (module != NULL ? " -> " : "");
+void Log::writerLoop()
+{
+	Profiler::SetThreadName("Log writer");
 
-	return mMessages;
+	for(;;)
+	{
+		bool quit = false;
+
+		{
+			std::unique_lock<std::mutex> lock(mWriterMutex);
+			if(!mQuit)
+				mWriterWake.wait_for(lock, std::chrono::milliseconds((uint32)DEFAULT_WRITE_PERIOD_MS));
+			quit = mQuit;
+		}
+
+		mWriteBuffer.clear();
+
+		uint32 droppedNum = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(mQueuesMutex);
+			for(size_t i = 0; i < mQueues.size(); ++i)
+			{
+				drain(mQueues[i], mWriteBuffer);
+				droppedNum += mQueues[i]->droppedNum.load(std::memory_order_relaxed);
+			}
+		}
+
+		if(droppedNum != mDroppedNum)
+		{
+			char dropped[64];
+			sprintf(dropped, "\nLog: %u records dropped, queue is full", droppedNum - mDroppedNum);
+			mWriteBuffer += dropped;
+			mDroppedNum = droppedNum;
+		}
+
+		if(!mWriteBuffer.empty())
+		{
+			if(mFile)
+			{
+				fwrite(mWriteBuffer.c_str(), 1, mWriteBuffer.length(), mFile);
+				fflush(mFile);
+			}
+
+			Platform::DebugLog(mWriteBuffer.c_str());
+		}
+
+		if(quit)
+			break;
+	}
 }
 
-} //namespace Squirrel {
\ No newline at end of file
+} //namespace Squirrel {
@@ -9,10 +9,19 @@
 #include "tuple.h"
 #include "macros.h"
 #include <sstream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 namespace Squirrel {
 
-class SQCOMMON_API Log  
+//Asynchronous log.
+//Every thread streams its records to own stream, record is complete when the same thread starts next one
+//or calls flush. Complete records are put as binary records (time, kind, module and text) to lock-free
+//per-thread queues and formatted and written to file by background writer thread.
+class SQCOMMON_API Log
 {
 public:
 
@@ -27,19 +36,84 @@ public:
 		sevGarbage
 	};
 
+	//Limits number of records of one call site per second, skipped records are counted in next written one.
+	//Keep it static at call site:
+	//	static Log::RateLimit sLimit(5);
+	//	Log::Instance().streamError("Module", sLimit) << ...;
+	class SQCOMMON_API RateLimit
+	{
+	public:
+		RateLimit(int maxPerSecond);
+
+		//suppressedNum gets number of records skipped since previous allowed one
+		bool allow(uint32 ticks, uint32& suppressedNum);
+
+	private:
+		int mMaxPerSecond;
+		std::atomic<uint32> mWindowStart;
+		std::atomic<int> mCount;
+		std::atomic<uint32> mSuppressedNum;
+	};
+
+	static const uint32 DEFAULT_WRITE_PERIOD_MS = 100;
+
+private:
+
+	enum RecordKind
+	{
+		rkMessage = 0,
+		rkError,
+		rkWarning,
+		rkPadding//skips rest of queue till its end
+	};
+
+	//followed by module and text chars, records are aligned to header size
+	struct RecordHeader
+	{
+		uint32	size;
+		uint32	ticks;
+		uint16	kind;
+		uint16	moduleLength;
+		uint32	suppressedNum;
+	};
+
+	//single producer (owner thread), single consumer (writer thread)
+	struct ThreadQueue
+	{
+		static const uint32 CAPACITY = 1 << 16;
+
+		ThreadQueue();
+
+		std::atomic<uint32>	head;
+		std::atomic<uint32>	tail;
+		std::atomic<uint32>	droppedNum;//records lost while queue was full
+		std::vector<byte>	bytes;
+
+		//producer side: record being streamed
+		std::ostringstream	message;
+		std::ostream		nullStream;//for filtered records
+		bool				hasPending;
+		RecordHeader		pending;
+		std::string			pendingModule;
+	};
+
 public:
 	Log();
 	~Log();
 
-	static Log& Instance(); 
+	static Log& Instance();
 
 	Severity getSeverity();
 
 	void setSeverity(Severity maxSev);
 
+	//opens file and starts writer thread
 	void init(const char_t * fname, Severity maxSev = sevMessage);
 
+	//completes record of calling thread and wakes writer, does not wait for writing;
+	//threads which log rarely should call it when they finish piece of work
 	void flush();
+	//writes all complete records, closes file and stops writer thread
 	void finish();
 
 	void report(const char_t * module, const char_t * report, Severity sev);
@@ -51,18 +125,46 @@ public:
 	std::ostream& streamError(const char_t * module = NULL);
 	std::ostream& streamWarning(const char_t * module = NULL);
 
+	//rate limited records
+	std::ostream& stream(const char_t * module, Severity sev, RateLimit& limit);
+	std::ostream& streamError(const char_t * module, RateLimit& limit);
+	std::ostream& streamWarning(const char_t * module, RateLimit& limit);
+
+	uint32 getDroppedRecordsNum() const { return mDroppedNum; }
+
 private:
 
-	std::stringstream mMessages;
-	std::stringstream mDummyStream;
+	ThreadQueue * getThreadQueue();
+
+	std::ostream& beginRecord(RecordKind kind, const char_t * module, Severity sev, RateLimit * limit);
+	bool commit(ThreadQueue * queue);
+
+	void writerLoop();
+	void drain(ThreadQueue * queue, std::string& out);
+	void stopWriter();
+
+private:
+
+	std::mutex					mQueuesMutex;
+	std::vector<ThreadQueue *>	mQueues;
 
 	uint32 mStartTicks;
 
 	std::string mFileName;
+	FILE * mFile;
 
 	Severity mSeverity;
-	
+
 	bool mInitialised;
+
+	//writer thread
+	std::thread					mWriter;
+	std::mutex					mWriterMutex;
+	std::condition_variable		mWriterWake;
+	bool						mQuit;
+	std::atomic<bool>			mWriterRunning;
+	std::string					mWriteBuffer;
+	uint32						mDroppedNum;
 };
 
-} //namespace Squirrel {
\ No newline at end of file
+} //namespace Squirrel {
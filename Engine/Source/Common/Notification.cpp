@@ -19,9 +19,16 @@ void ObjectNotify::addToRecipients(const std::string& notification)
 
 void ObjectNotify::delFromRecipients()
 {
-	NotificationCenter::Instance().deleteRecipient(this);
+	EventBus::Default()->unsubscribeAll(this);
 }
 
+void ObjectNotify::onEvent(const Event& event)
+{
+	std::map<EventId, std::string>& names = NotificationCenter::Instance().mNames;
+	std::map<EventId, std::string>::const_iterator it = names.find(event.id);
+	if(it != names.end())
+		notify(it->second);
+}
 
 NotificationCenter::NotificationCenter()
 {
@@ -30,49 +37,25 @@ NotificationCenter::NotificationCenter()
 
 NotificationCenter::~NotificationCenter()
 {
-	recipients.clear();
-}
-
-void NotificationCenter::deleteRecipient(ObjectNotify * recipient)
-{
-	if(!recipient) return;
-
-	std::map<std::string, ObjectNotifyPtrArr>::iterator it = recipients.begin();
-
-	while(it != recipients.end ())
-	{
-		for(int i = 0; i < (int)it->second.size(); ++i) 
-			if(it->second[i])
-				if(it->second[i]==recipient)
-					it->second.erase( it->second.begin() + i );
-		it++;
-	}
+	mNames.clear();
 }
 
 void NotificationCenter::addRecipient(const std::string& notification, ObjectNotify * recipient)
 {
-	std::map<std::string, ObjectNotifyPtrArr>::iterator it = recipients.find ( notification );
-
-	if(it==recipients.end())
-	{
-		recipients[notification] = ObjectNotifyPtrArr();
-		it = recipients.find ( notification );
-	}
+	EventId id = HashEventId(notification.c_str());
 
-	it->second.push_back(recipient);
+	std::map<EventId, std::string>::iterator it = mNames.find(id);
+	if(it == mNames.end())
+		mNames[id] = notification;
+	else
+		ASSERT(it->second == notification);//hash collision
 
+	EventBus::Default()->subscribe(id, recipient);
 }
+
 void NotificationCenter::notify(const std::string& notification)
 {
-	std::map<std::string, ObjectNotifyPtrArr>::iterator it = recipients.find ( notification );
-
-	while(it != recipients.end ())
-	{
-		for(int i = 0; i < (int)it->second.size(); ++i) 
-			if(it->second[i])
-				it->second[i]->notify(notification);
-		it++;
-	}
+	EventBus::Default()->send(Event(HashEventId(notification.c_str())));
 }
 
 NotificationCenter& NotificationCenter::Instance()
@@ -81,4 +64,4 @@ NotificationCenter& NotificationCenter::Instance()
 	return instance;
 }
 
-}//namespace Squirrel {
\ No newline at end of file
+}//namespace Squirrel {
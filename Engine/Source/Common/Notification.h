@@ -1,13 +1,15 @@
 #pragma once
 
 #include <string>
-#include <vector>
 #include <map>
 #include "macros.h"
+#include "EventBus.h"
 
 namespace Squirrel {
 
-class SQCOMMON_API ObjectNotify
+//Recipient of named notifications, kept for string based code on top of EventBus.
+class SQCOMMON_API ObjectNotify:
+	public EventListener
 {
 public:
 
@@ -19,20 +21,19 @@ public:
 
 	virtual void notify(const std::string& notification) = 0;
 
+	virtual void onEvent(const Event& event);
 };
 
-//OPTIMIZE: list
-typedef std::vector<ObjectNotify *> ObjectNotifyPtrArr;
-
+//Sends named notifications synchronously through default EventBus,
+//names are hashed to event ids, so new code may subscribe to SQ_EVENT_ID(name) directly.
 class SQCOMMON_API NotificationCenter
 {
 	friend class ObjectNotify;
 
 private:
 
-	std::map<std::string, ObjectNotifyPtrArr> recipients;
-
-	void deleteRecipient(ObjectNotify * recipient);
+	//names of hashed ids for recipients
+	std::map<EventId, std::string> mNames;
 
 	NotificationCenter(void);
 
@@ -48,4 +49,4 @@ public:
 
 };
 
-}//namespace Squirrel {
\ No newline at end of file
+}//namespace Squirrel {
@@ -1,48 +1,74 @@
 #pragma once
 
-#include <stack>
+#include "Allocator.h"
+#include <vector>
 
 namespace Squirrel {
 
-template <class T>
-class ObjectsPool
+//Objects are constructed by contiguous chunks and stay constructed while pool lives,
+//so returned objects keep their state (e.g. capacity of containers) for next use.
+//Objects given out are destroyed with pool as well. Not thread safe.
+template <class T, int CHUNK_SIZE = 32>
+class ObjectsPool:
+	public Allocator
 {
-	typedef std::stack<T *>	OBJ_PTRS_POOL;
-
-	OBJ_PTRS_POOL mPool;
+	std::vector<T *> mChunks;
+	std::vector<T *> mFreeObjects;
 
 public:
-	ObjectsPool()	{}
+	ObjectsPool(const char * name = "Objects pool"):
+		Allocator(name)
+	{
+	}
+
 	~ObjectsPool()
 	{
-		while(!mPool.empty())
+		for(size_t i = 0; i < mChunks.size(); ++i)
 		{
-			T * obj = mPool.top();
-			if(obj != NULL)
-				delete obj;
-			mPool.pop();
+			delete[] mChunks[i];
 		}
 	}
 
 	T * getObj()
 	{
-		if(!mPool.empty())
-		{
-			T * obj = mPool.top();
-			mPool.pop();
-			return obj;
-		}
-		else
+		if(mFreeObjects.empty())
 		{
-			return new T();
+			addChunk();
 		}
+
+		T * obj = mFreeObjects.back();
+		mFreeObjects.pop_back();
+
+		onAllocate(sizeof(T));
+
+		return obj;
 	}
 
 	void putObj(T * obj)
 	{
-		mPool.push(obj);
+		mFreeObjects.push_back(obj);
+
+		mStats.bytesUsed -= sizeof(T);
 	}
 
+private:
+
+	void addChunk()
+	{
+		T * chunk = new T[CHUNK_SIZE];
+		mChunks.push_back(chunk);
+
+		//free list never grows beyond number of objects
+		mFreeObjects.reserve(mChunks.size() * CHUNK_SIZE);
+
+		for(int i = CHUNK_SIZE - 1; i >= 0; --i)
+		{
+			mFreeObjects.push_back(chunk + i);
+		}
+
+		++mStats.heapAllocationsNum;
+		mStats.bytesReserved += sizeof(T) * CHUNK_SIZE;
+	}
 };
-	
-}//namespace Squirrel {
\ No newline at end of file
+
+}//namespace Squirrel {
@@ -0,0 +1,136 @@
+#include "PoolAllocator.h"
+#include <new>
+
+namespace Squirrel {
+
+namespace {
+
+const size_t SIZE_CLASSES[NodePool::SIZE_CLASSES_NUM] = { 16, 32, 48, 64, 96, 128, 192, NodePool::MAX_BLOCK_SIZE };
+
+const char * SIZE_CLASS_NAMES[NodePool::SIZE_CLASSES_NUM] = {
+	"Nodes 16", "Nodes 32", "Nodes 48", "Nodes 64", "Nodes 96", "Nodes 128", "Nodes 192", "Nodes 256" };
+
+}//namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// FixedSizePool
+
+FixedSizePool::FixedSizePool(const char * name, size_t blockSize, size_t chunkSize):
+	Allocator(name), mFreeList(NULL)
+{
+	mBlockSize = AlignSize(blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize, sizeof(void *));
+	mBlocksPerChunk = chunkSize / mBlockSize;
+	if(mBlocksPerChunk < 1)
+		mBlocksPerChunk = 1;
+}
+
+FixedSizePool::~FixedSizePool()
+{
+	for(size_t i = 0; i < mChunks.size(); ++i)
+	{
+		::operator delete(mChunks[i]);
+	}
+}
+
+void FixedSizePool::addChunk()
+{
+	byte * chunk = static_cast<byte *>(::operator new(mBlockSize * mBlocksPerChunk));
+	mChunks.push_back(chunk);
+
+	//blocks are put so they are given in address order
+	for(size_t i = mBlocksPerChunk; i > 0; --i)
+	{
+		FreeBlock * block = reinterpret_cast<FreeBlock *>(chunk + (i - 1) * mBlockSize);
+		block->next = mFreeList;
+		mFreeList = block;
+	}
+
+	++mStats.heapAllocationsNum;
+	mStats.bytesReserved += mBlockSize * mBlocksPerChunk;
+}
+
+void * FixedSizePool::allocate()
+{
+	if(mFreeList == NULL)
+		addChunk();
+
+	FreeBlock * block = mFreeList;
+	mFreeList = block->next;
+
+	onAllocate(mBlockSize);
+
+	return block;
+}
+
+void FixedSizePool::deallocate(void * ptr)
+{
+	if(ptr == NULL)
+		return;
+
+	FreeBlock * block = static_cast<FreeBlock *>(ptr);
+	block->next = mFreeList;
+	mFreeList = block;
+
+	mStats.bytesUsed -= mBlockSize;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NodePool
+
+NodePool::NodePool()
+{
+	for(int i = 0; i < SIZE_CLASSES_NUM; ++i)
+	{
+		mPools[i] = new FixedSizePool(SIZE_CLASS_NAMES[i], SIZE_CLASSES[i]);
+	}
+}
+
+NodePool::~NodePool()
+{
+	for(int i = 0; i < SIZE_CLASSES_NUM; ++i)
+	{
+		DELETE_PTR(mPools[i]);
+	}
+}
+
+NodePool& NodePool::Instance()
+{
+	//never destroyed: containers of static objects may release nodes at exit
+	static NodePool * instance = new NodePool();
+	return *instance;
+}
+
+int NodePool::GetSizeClass(size_t size)
+{
+	for(int i = 0; i < SIZE_CLASSES_NUM; ++i)
+	{
+		if(size <= SIZE_CLASSES[i])
+			return i;
+	}
+	return -1;
+}
+
+void * NodePool::allocate(size_t size)
+{
+	int sizeClass = GetSizeClass(size);
+	if(sizeClass < 0)
+		return ::operator new(size);
+
+	std::unique_lock<std::mutex> lock(mMutexes[sizeClass]);
+	return mPools[sizeClass]->allocate();
+}
+
+void NodePool::deallocate(void * ptr, size_t size)
+{
+	int sizeClass = GetSizeClass(size);
+	if(sizeClass < 0)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutexes[sizeClass]);
+	mPools[sizeClass]->deallocate(ptr);
+}
+
+}//namespace Squirrel {
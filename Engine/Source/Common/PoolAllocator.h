@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Allocator.h"
+#include <mutex>
+
+namespace Squirrel {
+
+//Pool of equal blocks carved from contiguous chunks, freed blocks are reused first.
+//Chunks are released only with pool. Not thread safe.
+class SQCOMMON_API FixedSizePool:
+	public Allocator
+{
+	struct FreeBlock
+	{
+		FreeBlock * next;
+	};
+
+public:
+
+	static const size_t DEFAULT_CHUNK_SIZE = 1 << 16;
+
+public:
+
+	FixedSizePool(const char * name, size_t blockSize, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+	~FixedSizePool();
+
+	void * allocate();
+	void deallocate(void * ptr);
+
+	size_t getBlockSize() const { return mBlockSize; }
+
+private:
+
+	void addChunk();
+
+private:
+
+	std::vector<byte *> mChunks;
+
+	size_t mBlockSize;
+	size_t mBlocksPerChunk;
+
+	FreeBlock * mFreeList;
+};
+
+//Thread safe pools of small blocks by size classes for nodes of containers.
+//Bigger blocks go to heap directly.
+class SQCOMMON_API NodePool
+{
+public:
+
+	static const size_t MAX_BLOCK_SIZE = 256;
+	static const int SIZE_CLASSES_NUM = 8;
+
+private:
+
+	NodePool();
+	~NodePool();
+
+public:
+
+	static NodePool& Instance();
+
+	void * allocate(size_t size);
+	void deallocate(void * ptr, size_t size);
+
+private:
+
+	static int GetSizeClass(size_t size);
+
+private:
+
+	FixedSizePool * mPools[SIZE_CLASSES_NUM];
+	std::mutex mMutexes[SIZE_CLASSES_NUM];
+};
+
+}//namespace Squirrel {
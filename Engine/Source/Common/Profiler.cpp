@@ -0,0 +1,354 @@
+#include "Profiler.h"
+#include <chrono>
+#include <stdio.h>
+
+namespace Squirrel {
+
+namespace {
+
+//buffer of calling thread, registered on first event
+thread_local void * sThreadBuffer = NULL;
+
+const uint64 AVERAGE_INTERVAL = 1000000000;//1 second
+
+void WriteJsonString(FILE * file, const char * str)
+{
+	fputc('"', file);
+	for(; *str != 0; ++str)
+	{
+		if(*str == '"' || *str == '\\')
+			fputc('\\', file);
+		fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+}//namespace {
+
+std::atomic<bool> Profiler::sEnabled(true);
+
+Profiler::Profiler():
+	mHistorySize(DEFAULT_HISTORY_SIZE), mFrameMs(0), mDroppedNum(0), mAverageFramesNum(0)
+{
+	mFrameBegin = mAverageBegin = Now();
+}
+
+Profiler::~Profiler()
+{
+	for(size_t i = 0; i < mBuffers.size(); ++i)
+	{
+		DELETE_PTR(mBuffers[i]);
+	}
+}
+
+Profiler& Profiler::Instance()
+{
+	static Profiler instance;
+	return instance;
+}
+
+uint64 Profiler::Now()
+{
+	return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::setEnabled(bool enabled)
+{
+	sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer * Profiler::getThreadBuffer()
+{
+	ThreadBuffer * buffer = static_cast<ThreadBuffer *>(sThreadBuffer);
+	if(buffer == NULL)
+	{
+		buffer = new ThreadBuffer();
+
+		std::unique_lock<std::mutex> lock(mBuffersMutex);
+
+		char name[32];
+		sprintf(name, "Thread %d", (int)mBuffers.size());
+
+		buffer->threadIndex = (uint32)mBuffers.size();
+		buffer->name = name;
+		mBuffers.push_back(buffer);
+
+		sThreadBuffer = buffer;
+	}
+	return buffer;
+}
+
+void Profiler::BeginZone(const Zone * zone)
+{
+	Instance().push(zone, etBegin);
+}
+
+void Profiler::EndZone(const Zone * zone)
+{
+	Instance().push(zone, etEnd);
+}
+
+void Profiler::SetThreadName(const char * name)
+{
+	Profiler& profiler = Instance();
+	ThreadBuffer * buffer = profiler.getThreadBuffer();
+
+	std::unique_lock<std::mutex> lock(profiler.mBuffersMutex);
+	buffer->name = name;
+}
+
+int Profiler::GetThreadIndex()
+{
+	return (int)Instance().getThreadBuffer()->threadIndex;
+}
+
+void Profiler::push(const Zone * zone, int type)
+{
+	ThreadBuffer * buffer = getThreadBuffer();
+
+	uint32 head = buffer->head.load(std::memory_order_relaxed);
+	uint32 tail = buffer->tail.load(std::memory_order_acquire);
+
+	if(head - tail >= ThreadBuffer::CAPACITY)
+	{
+		buffer->droppedNum.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Event& event = buffer->events[head & (ThreadBuffer::CAPACITY - 1)];
+	event.time	= Now();
+	event.zone	= zone;
+	event.type	= type;
+
+	buffer->head.store(head + 1, std::memory_order_release);
+}
+
+std::string Profiler::getThreadName(int threadIndex) const
+{
+	std::unique_lock<std::mutex> lock(mBuffersMutex);
+	return (threadIndex >= 0 && threadIndex < (int)mBuffers.size()) ? mBuffers[threadIndex]->name : std::string();
+}
+
+int Profiler::findChild(int parent, const Zone * zone, int threadIndex)
+{
+	int last = -1;
+	if(parent >= 0)
+	{
+		for(int child = mNodes[parent].firstChild; child >= 0; child = mNodes[child].nextSibling)
+		{
+			if(mNodes[child].zone == zone)
+				return child;
+			last = child;
+		}
+	}
+
+	Node node;
+	node.zone			= zone;
+	node.parent			= parent;
+	node.firstChild		= -1;
+	node.nextSibling	= -1;
+	node.depth			= parent >= 0 ? mNodes[parent].depth + 1 : 0;
+	node.threadIndex	= threadIndex;
+	node.callsNum		= 0;
+	node.time			= 0;
+	node.childrenTime	= 0;
+	node.accTime		= 0;
+	node.avgMs			= 0;
+
+	int index = (int)mNodes.size();
+	mNodes.push_back(node);
+
+	//keep first seen order among siblings
+	if(last >= 0)
+		mNodes[last].nextSibling = index;
+	else if(parent >= 0)
+		mNodes[parent].firstChild = index;
+
+	return index;
+}
+
+void Profiler::drain(ThreadBuffer * buffer, Frame& frame)
+{
+	if(buffer->rootNode < 0)
+		buffer->rootNode = findChild(-1, NULL, buffer->threadIndex);
+
+	uint32 tail = buffer->tail.load(std::memory_order_relaxed);
+	uint32 head = buffer->head.load(std::memory_order_acquire);
+
+	for(; tail != head; ++tail)
+	{
+		const Event& event = buffer->events[tail & (ThreadBuffer::CAPACITY - 1)];
+
+		FrameEvent frameEvent;
+		frameEvent.time			= event.time;
+		frameEvent.zone			= event.zone;
+		frameEvent.threadIndex	= (uint16)buffer->threadIndex;
+		frameEvent.type			= (uint16)event.type;
+		frame.events.push_back(frameEvent);
+
+		if(event.type == etBegin)
+		{
+			int parent = buffer->openNodes.empty() ? buffer->rootNode : buffer->openNodes.back();
+			buffer->openNodes.push_back(findChild(parent, event.zone, buffer->threadIndex));
+			buffer->openTimes.push_back(event.time);
+		}
+		else
+		{
+			//zones left open by lost end events are closed together with their parent
+			int open = (int)buffer->openNodes.size() - 1;
+			while(open >= 0 && mNodes[buffer->openNodes[open]].zone != event.zone)
+				--open;
+
+			if(open < 0)
+				continue;//begin was lost
+
+			uint64 duration = event.time - buffer->openTimes[open];
+
+			Node& node = mNodes[buffer->openNodes[open]];
+			node.time += duration;
+			++node.callsNum;
+			mNodes[node.parent].childrenTime += duration;
+
+			buffer->openNodes.resize(open);
+			buffer->openTimes.resize(open);
+		}
+	}
+
+	buffer->tail.store(tail, std::memory_order_release);
+
+	mDroppedNum += (int)buffer->droppedNum.exchange(0, std::memory_order_relaxed);
+
+	Node& root = mNodes[buffer->rootNode];
+	root.time = root.childrenTime;
+	root.callsNum = 1;
+}
+
+void Profiler::endFrame()
+{
+	uint64 now = Now();
+
+	for(size_t i = 0; i < mNodes.size(); ++i)
+	{
+		Node& node = mNodes[i];
+		node.callsNum		= 0;
+		node.time			= 0;
+		node.childrenTime	= 0;
+	}
+
+	std::vector<ThreadBuffer *> buffers;
+	{
+		std::unique_lock<std::mutex> lock(mBuffersMutex);
+		buffers = mBuffers;
+	}
+
+	Frame frame;
+	frame.begin	= mFrameBegin;
+	frame.end	= now;
+
+	mDroppedNum = 0;
+
+	for(size_t i = 0; i < buffers.size(); ++i)
+	{
+		drain(buffers[i], frame);
+	}
+
+	mFrameMs = (now - mFrameBegin) / 1000000.0f;
+	mFrameBegin = now;
+
+	//averages
+
+	++mAverageFramesNum;
+	for(size_t i = 0; i < mNodes.size(); ++i)
+	{
+		mNodes[i].accTime += mNodes[i].time;
+	}
+
+	if(now - mAverageBegin >= AVERAGE_INTERVAL)
+	{
+		for(size_t i = 0; i < mNodes.size(); ++i)
+		{
+			Node& node = mNodes[i];
+			node.avgMs = node.accTime / (1000000.0f * mAverageFramesNum);
+			node.accTime = 0;
+		}
+		mAverageBegin = now;
+		mAverageFramesNum = 0;
+	}
+
+	//history
+
+	if(mHistorySize > 0)
+	{
+		mHistory.push_back(Frame());
+		mHistory.back().begin	= frame.begin;
+		mHistory.back().end		= frame.end;
+		mHistory.back().events.swap(frame.events);
+
+		while((int)mHistory.size() > mHistorySize)
+			mHistory.pop_front();
+	}
+}
+
+void Profiler::collectTree(std::vector<const Node *>& outNodes) const
+{
+	for(size_t i = 0; i < mNodes.size(); ++i)
+	{
+		if(mNodes[i].parent < 0)
+			collectTree((int)i, outNodes);
+	}
+}
+
+void Profiler::collectTree(int node, std::vector<const Node *>& outNodes) const
+{
+	outNodes.push_back(&mNodes[node]);
+	for(int child = mNodes[node].firstChild; child >= 0; child = mNodes[child].nextSibling)
+	{
+		collectTree(child, outNodes);
+	}
+}
+
+bool Profiler::exportChromeTrace(const std::string& fileName) const
+{
+	FILE * file = fopen(fileName.c_str(), "w");
+	if(file == NULL)
+		return false;
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	bool first = true;
+
+	{
+		std::unique_lock<std::mutex> lock(mBuffersMutex);
+		for(size_t i = 0; i < mBuffers.size(); ++i)
+		{
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", (int)i);
+			WriteJsonString(file, mBuffers[i]->name.c_str());
+			fprintf(file, "}}");
+			first = false;
+		}
+	}
+
+	uint64 origin = mHistory.empty() ? 0 : mHistory.front().begin;
+
+	for(size_t i = 0; i < mHistory.size(); ++i)
+	{
+		const Frame& frame = mHistory[i];
+		for(size_t j = 0; j < frame.events.size(); ++j)
+		{
+			const FrameEvent& event = frame.events[j];
+			fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+			WriteJsonString(file, event.zone->name);
+			fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":0,\"tid\":%d}",
+				event.type == etBegin ? "B" : "E", (event.time - origin) / 1000.0, (int)event.threadIndex);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	return true;
+}
+
+}//namespace Squirrel {
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "macros.h"
+#include "types.h"
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+//zones are compiled out when set to 0
+#ifndef SQ_PROFILER_ENABLED
+#	define SQ_PROFILER_ENABLED 1
+#endif
+
+namespace Squirrel {
+
+//Hierarchical CPU profiler.
+//Zones write begin/end events to lock-free per-thread ring buffers, endFrame drains them,
+//aggregates zones into a tree and keeps raw events of last frames for trace export.
+class SQCOMMON_API Profiler
+{
+public:
+
+	//static zone description, its address identifies zone
+	struct Zone
+	{
+		const char *	name;
+		const char *	file;
+		int				line;
+	};
+
+	//aggregated zone for its path in calls tree, one tree per thread
+	struct Node
+	{
+		const Zone *	zone;//NULL for thread roots
+		int				parent;
+		int				firstChild;
+		int				nextSibling;
+		int				depth;
+		int				threadIndex;
+
+		int				callsNum;//last frame
+		uint64			time;//last frame, nanoseconds
+		uint64			childrenTime;//last frame, nanoseconds
+
+		uint64			accTime;//accumulated for averaging
+		float			avgMs;//average time per frame over last averaging interval
+	};
+
+	static const int DEFAULT_HISTORY_SIZE = 120;
+
+private:
+
+	enum EventType
+	{
+		etBegin = 0,
+		etEnd
+	};
+
+	struct Event
+	{
+		uint64			time;
+		const Zone *	zone;
+		int				type;
+	};
+
+	//single producer (owner thread), single consumer (endFrame)
+	struct ThreadBuffer
+	{
+		static const uint32 CAPACITY = 1 << 14;
+
+		ThreadBuffer(): head(0), tail(0), droppedNum(0), events(CAPACITY), threadIndex(0), rootNode(-1) {}
+
+		std::atomic<uint32>	head;
+		std::atomic<uint32>	tail;
+		std::atomic<uint32>	droppedNum;//events lost while buffer was full
+		std::vector<Event>	events;
+
+		uint32				threadIndex;
+		std::string			name;
+
+		//consumer side state
+		std::vector<int>	openNodes;
+		std::vector<uint64>	openTimes;
+		int					rootNode;
+	};
+
+	struct FrameEvent
+	{
+		uint64			time;
+		const Zone *	zone;
+		uint16			threadIndex;
+		uint16			type;
+	};
+
+	struct Frame
+	{
+		uint64					begin;
+		uint64					end;
+		std::vector<FrameEvent>	events;
+	};
+
+	Profiler();
+	~Profiler();
+
+public:
+
+	static Profiler& Instance();
+
+	//nanoseconds from arbitrary point
+	static uint64 Now();
+
+	static inline bool IsEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+	static void BeginZone(const Zone * zone);
+	static void EndZone(const Zone * zone);
+
+	//names calling thread in trace and tree
+	static void SetThreadName(const char * name);
+
+	//thread index of calling thread, matches Node::threadIndex
+	static int GetThreadIndex();
+
+	void setEnabled(bool enabled);
+
+	//call once per frame from main thread
+	void endFrame();
+
+	const std::vector<Node>& getNodes() const { return mNodes; }
+
+	//nodes in depth first order
+	void collectTree(std::vector<const Node *>& outNodes) const;
+
+	std::string getThreadName(int threadIndex) const;
+
+	float getFrameMs() const { return mFrameMs; }
+	int getDroppedEventsNum() const { return mDroppedNum; }
+
+	void setHistorySize(int framesNum) { mHistorySize = framesNum; }
+
+	//writes kept frames in Chrome trace event format (chrome://tracing)
+	bool exportChromeTrace(const std::string& fileName) const;
+
+private:
+
+	ThreadBuffer * getThreadBuffer();
+
+	void push(const Zone * zone, int type);
+
+	int findChild(int parent, const Zone * zone, int threadIndex);
+	void drain(ThreadBuffer * buffer, Frame& frame);
+
+	void collectTree(int node, std::vector<const Node *>& outNodes) const;
+
+private:
+
+	static std::atomic<bool>	sEnabled;
+
+	mutable std::mutex			mBuffersMutex;
+	std::vector<ThreadBuffer *>	mBuffers;
+
+	std::vector<Node>			mNodes;
+
+	std::deque<Frame>			mHistory;
+	int							mHistorySize;
+
+	uint64						mFrameBegin;
+	float						mFrameMs;
+	int							mDroppedNum;
+
+	uint64						mAverageBegin;
+	int							mAverageFramesNum;
+};
+
+//Measures zone for lifetime of scope
+class ProfileScope
+{
+	const Profiler::Zone * mZone;
+
+public:
+	inline ProfileScope(const Profiler::Zone * zone):
+		mZone(Profiler::IsEnabled() ? zone : NULL)
+	{
+		if(mZone)
+			Profiler::BeginZone(mZone);
+	}
+
+	inline ~ProfileScope()
+	{
+		if(mZone)
+			Profiler::EndZone(mZone);
+	}
+};
+
+}//namespace Squirrel {
+
+#if SQ_PROFILER_ENABLED
+#	define SQ_PROFILE_ZONE(name) \
+		static const ::Squirrel::Profiler::Zone TOKENPASTE2(sqProfileZone, __LINE__) = { name, __FILE__, __LINE__ }; \
+		::Squirrel::ProfileScope TOKENPASTE2(sqProfileScope, __LINE__)(&TOKENPASTE2(sqProfileZone, __LINE__))
+#else
+#	define SQ_PROFILE_ZONE(name)
+#endif
+
+#define SQ_PROFILE_FUNCTION()	SQ_PROFILE_ZONE(__FUNCTION__)
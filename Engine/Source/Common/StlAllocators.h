@@ -0,0 +1,100 @@
+#pragma once
+
+#include "PoolAllocator.h"
+#include "LinearAllocator.h"
+#include <string>
+#include <limits>
+#include <new>
+
+namespace Squirrel {
+
+//STL allocator taking small blocks (nodes of lists, sets and maps) from NodePool
+template <class T>
+class PoolStlAllocator
+{
+public:
+	typedef T				value_type;
+	typedef T *				pointer;
+	typedef const T *		const_pointer;
+	typedef T &				reference;
+	typedef const T &		const_reference;
+	typedef size_t			size_type;
+	typedef ptrdiff_t		difference_type;
+
+	template <class U>
+	struct rebind { typedef PoolStlAllocator<U> other; };
+
+	PoolStlAllocator() {}
+	template <class U>
+	PoolStlAllocator(const PoolStlAllocator<U>&) {}
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		return static_cast<pointer>( NodePool::Instance().allocate(n * sizeof(T)) );
+	}
+
+	void deallocate(pointer p, size_type n)
+	{
+		NodePool::Instance().deallocate(p, n * sizeof(T));
+	}
+
+	void construct(pointer p, const T& value)	{ new (p) T(value); }
+	void destroy(pointer p)						{ p->~T(); }
+
+	pointer address(reference x) const				{ return &x; }
+	const_pointer address(const_reference x) const	{ return &x; }
+
+	size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	template <class U>
+	bool operator==(const PoolStlAllocator<U>&) const { return true; }
+	template <class U>
+	bool operator!=(const PoolStlAllocator<U>&) const { return false; }
+};
+
+//STL allocator of frame allocator for containers and strings which live only inside of one call,
+//memory is freed by reset of frame allocator only
+template <class T>
+class FrameStlAllocator
+{
+public:
+	typedef T				value_type;
+	typedef T *				pointer;
+	typedef const T *		const_pointer;
+	typedef T &				reference;
+	typedef const T &		const_reference;
+	typedef size_t			size_type;
+	typedef ptrdiff_t		difference_type;
+
+	template <class U>
+	struct rebind { typedef FrameStlAllocator<U> other; };
+
+	FrameStlAllocator() {}
+	template <class U>
+	FrameStlAllocator(const FrameStlAllocator<U>&) {}
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		return static_cast<pointer>( LinearAllocator::Frame().allocate(n * sizeof(T), alignof(T)) );
+	}
+
+	void deallocate(pointer p, size_type n) {}
+
+	void construct(pointer p, const T& value)	{ new (p) T(value); }
+	void destroy(pointer p)						{ p->~T(); }
+
+	pointer address(reference x) const				{ return &x; }
+	const_pointer address(const_reference x) const	{ return &x; }
+
+	size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+	template <class U>
+	bool operator==(const FrameStlAllocator<U>&) const { return true; }
+	template <class U>
+	bool operator!=(const FrameStlAllocator<U>&) const { return false; }
+};
+
+//temporary string of main thread
+typedef std::basic_string<char_t, std::char_traits<char_t>, FrameStlAllocator<char_t> > FrameString;
+
+}//namespace Squirrel {
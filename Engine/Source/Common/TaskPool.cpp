@@ -0,0 +1,175 @@
+#include "TaskPool.h"
+#include "Profiler.h"
+#include "Log.h"
+#include <stdio.h>
+
+namespace Squirrel {
+
+namespace {
+	//set for pool worker threads, nested jobs run inline
+	thread_local bool sIsWorkerThread = false;
+}
+
+TaskPool::TaskPool(int workersNum):
+	mJobId(0), mActiveWorkers(0), mQuit(false), mNextChunk(0), mChunksLeft(0)
+{
+	mJob.func		= NULL;
+	mJob.context	= NULL;
+	mJob.count		= 0;
+	mJob.chunkSize	= 0;
+	mJob.chunksNum	= 0;
+
+	if(workersNum < 0)
+	{
+		int hardwareThreads = (int)std::thread::hardware_concurrency();
+		workersNum = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	for(int i = 0; i < workersNum; ++i)
+	{
+		mWorkers.push_back(std::thread(&TaskPool::workerLoop, this, i));
+	}
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mJobReady.notify_all();
+
+	for(size_t i = 0; i < mWorkers.size(); ++i)
+	{
+		mWorkers[i].join();
+	}
+}
+
+TaskPool * TaskPool::Default()
+{
+	//never destroyed: joining threads while unloading libraries at exit may deadlock
+	static TaskPool * pool = new TaskPool();
+	return pool;
+}
+
+void TaskPool::parallelFor(int count, int minChunkSize, RangeFunc func, void * context)
+{
+	if(count <= 0)
+		return;
+
+	if(minChunkSize < 1)
+		minChunkSize = 1;
+
+	int threadsNum = (int)mWorkers.size() + 1;
+
+	//few chunks per thread to even out unequal chunks
+	int chunkSize = (count + threadsNum * 4 - 1) / (threadsNum * 4);
+	if(chunkSize < minChunkSize)
+		chunkSize = minChunkSize;
+
+	int chunksNum = (count + chunkSize - 1) / chunkSize;
+
+	if(chunksNum <= 1 || mWorkers.empty() || sIsWorkerThread)
+	{
+		func(context, 0, count);
+		return;
+	}
+
+	SQ_PROFILE_ZONE("TaskPool::parallelFor");
+
+	std::unique_lock<std::mutex> submitLock(mSubmitMutex);
+
+	Job job;
+	job.func		= func;
+	job.context		= context;
+	job.count		= count;
+	job.chunkSize	= chunkSize;
+	job.chunksNum	= chunksNum;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		//late workers of previous job must leave before chunk counters are reset
+		while(mActiveWorkers > 0)
+			mJobDone.wait(lock);
+
+		mJob = job;
+		mChunksLeft.store(chunksNum);
+		mNextChunk.store(0);
+		++mJobId;
+	}
+	mJobReady.notify_all();
+
+	runChunks(job);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while(mChunksLeft.load() > 0 || mActiveWorkers > 0)
+		mJobDone.wait(lock);
+}
+
+void TaskPool::runChunks(const Job& job)
+{
+	for(;;)
+	{
+		int chunk = mNextChunk.fetch_add(1);
+		if(chunk >= job.chunksNum)
+			break;
+
+		int begin = chunk * job.chunkSize;
+		int end = begin + job.chunkSize;
+		if(end > job.count)
+			end = job.count;
+
+		job.func(job.context, begin, end);
+
+		mChunksLeft.fetch_sub(1);
+	}
+}
+
+void TaskPool::workerLoop(int workerIndex)
+{
+	sIsWorkerThread = true;
+
+	{
+		char name[32];
+		sprintf(name, "Worker %d", workerIndex);
+		Profiler::SetThreadName(name);
+	}
+
+	uint32 lastJobId = 0;
+
+	for(;;)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			while(!mQuit && mJobId == lastJobId)
+				mJobReady.wait(lock);
+
+			if(mQuit)
+				return;
+
+			lastJobId = mJobId;
+			job = mJob;
+			++mActiveWorkers;
+		}
+
+		{
+			SQ_PROFILE_ZONE("TaskPool::job");
+			runChunks(job);
+		}
+
+		//records of job are written without waiting for next job which logs
+		Log::Instance().flush();
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			--mActiveWorkers;
+		}
+		mJobDone.notify_all();
+	}
+}
+
+}//namespace Squirrel {
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "macros.h"
+#include "types.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace Squirrel {
+
+//Persistent worker threads for data parallel jobs.
+//Work is split into chunks which are picked by workers and the calling thread,
+//so small jobs run inline without waking anybody.
+class SQCOMMON_API TaskPool
+{
+public:
+
+	//processes items [begin, end)
+	typedef void (*RangeFunc)(void * context, int begin, int end);
+
+private:
+
+	struct Job
+	{
+		RangeFunc	func;
+		void *		context;
+		int			count;
+		int			chunkSize;
+		int			chunksNum;
+	};
+
+	TaskPool(const TaskPool&);
+	const TaskPool& operator=(const TaskPool&);
+
+public:
+
+	//negative workers number means hardware threads number minus one,
+	//zero makes every job run on calling thread
+	TaskPool(int workersNum = -1);
+	~TaskPool();
+
+	static TaskPool * Default();
+
+	//splits [0, count) into chunks of at least minChunkSize items and returns when all chunks are processed;
+	//nested calls from worker threads run inline
+	void parallelFor(int count, int minChunkSize, RangeFunc func, void * context);
+
+	int getWorkersNum() const { return (int)mWorkers.size(); }
+
+private:
+
+	void workerLoop(int workerIndex);
+	void runChunks(const Job& job);
+
+private:
+
+	std::vector<std::thread>	mWorkers;
+
+	std::mutex					mSubmitMutex;//one job at a time
+
+	std::mutex					mMutex;
+	std::condition_variable		mJobReady;
+	std::condition_variable		mJobDone;
+
+	Job							mJob;
+	uint32						mJobId;
+	int							mActiveWorkers;//workers holding copy of current job
+	bool						mQuit;
+
+	std::atomic<int>			mNextChunk;
+	std::atomic<int>			mChunksLeft;
+};
+
+}//namespace Squirrel {
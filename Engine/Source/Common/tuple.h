@@ -253,6 +253,17 @@ public:
 	}
 };
 
+class tuple4s: public tuple4<short>
+{
+public:
+	
+	tuple4s(void) {}
+	tuple4s(short _x, short _y, short _z, short _w)
+	{
+		x = _x, y = _y, z = _z, w = _w;
+	}
+};
+
 class tuple3b: public tuple3<int8>
 {
 	public:
@@ -32,6 +32,12 @@ AnimationImporter::~AnimationImporter(void)
 {
 }
 
+void AnimationImporter::warning(const char * message)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	Log::Instance().warning("AnimationImporter::importObject", message);
+}
+
 void AnimationImporter::importObject(pugi::xml_node node)
 {
 	if(std::string(node.name()) != ANIMATION_TAG) return;
@@ -52,6 +58,9 @@ void AnimationImporter::importObject(pugi::xml_node node)
 
 	std::map<UniqueId, SourceNode *> dataArrays;
 
+	//tracks of this animation, merged into mAnimTracksMap before parsing channels
+	std::map<UniqueId, AnimationTrack *> animTracks;
+
 	//parse content
 
 	//parse sources
@@ -94,7 +103,7 @@ void AnimationImporter::importObject(pugi::xml_node node)
 				ASSERT(inputData != NULL);
 				if(sourceNode->name != "TIME")
 				{
-					Log::Instance().warning("AnimationImporter::importObject", (String("Import of other physical dimension then TIME not supported: ") + sourceNode->name).c_str());
+					warning((String("Import of other physical dimension then TIME not supported: ") + sourceNode->name).c_str());
 				}
 			} 
 			else if(semantic == OUTPUT_SEM) {
@@ -124,15 +133,15 @@ void AnimationImporter::importObject(pugi::xml_node node)
 		ASSERT(track);
 
 		//store anim track
-		std::map<UniqueId, AnimationTrack *>::iterator itAnimTrack = mAnimTracksMap.find(samplerId);
-		if(itAnimTrack != mAnimTracksMap.end())
+		std::map<UniqueId, AnimationTrack *>::iterator itAnimTrack = animTracks.find(samplerId);
+		if(itAnimTrack != animTracks.end())
 		{
 			delete track;
 			continue;
 		}
 		else
 		{
-			mAnimTracksMap[samplerId] = track;
+			animTracks[samplerId] = track;
 		}
 
 		//setup interp type
@@ -147,7 +156,7 @@ void AnimationImporter::importObject(pugi::xml_node node)
 			//support ony 
 			if(inTangentData->getStride() != 2 || inTangentData->getCount() != outputData->getCount())
 			{
-				Log::Instance().warning("AnimationImporter::importObject", "Standard cubic bezier interpolation is only supported! Switching to linear interpolation.");
+				warning("Standard cubic bezier interpolation is only supported! Switching to linear interpolation.");
 				track->setInterpolationType(AnimationTrack::LINEAR);
 			}
 		}
@@ -197,6 +206,19 @@ void AnimationImporter::importObject(pugi::xml_node node)
 		}
 	}
 
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	//store anim tracks
+	for(std::map<UniqueId, AnimationTrack *>::iterator itTrack = animTracks.begin(); itTrack != animTracks.end(); ++itTrack)
+	{
+		if(mAnimTracksMap.find(itTrack->first) != mAnimTracksMap.end())
+		{
+			delete itTrack->second;
+			continue;
+		}
+		mAnimTracksMap[itTrack->first] = itTrack->second;
+	}
+
 	//parse channels
 	for(node = animNode.child(CHANNEL_TAG); node; node = node.next_sibling(CHANNEL_TAG))
 	{
@@ -273,6 +295,8 @@ void AnimationImporter::importObject(pugi::xml_node node)
 		mAnimChannelsMap[samplerId] = channel;
 	}
 
+	lock.unlock();
+
 	//cleanup
 	for(std::map<UniqueId, SourceNode *>::iterator itDA = dataArrays.begin(); itDA != dataArrays.end(); ++itDA)
 	{
@@ -5,6 +5,7 @@
 #include <Resource/AnimatableResource.h>
 #include <Resource/Animation.h>
 #include "BaseImporter.h"
+#include <mutex>
 
 namespace Squirrel {
 namespace DAEImport { 
@@ -35,6 +36,11 @@ private:
 
 	std::map<UniqueId, CHANNELS_LIST>		mChannelsByTargetId;
 
+	//guards maps above, animations are imported concurrently
+	std::mutex								mMutex;
+
+	void warning(const char * message);
+
 public:
 
 	AnimationImporter(void);
@@ -42,6 +48,8 @@ public:
 
 	virtual void importObject(pugi::xml_node node);
 
+	virtual bool isConcurrent() const { return true; }
+
 	const std::map<UniqueId, CHANNELS_LIST>& sortChannelsByTargetId();
 
 	const CHANNELS_LIST * getChannelsListForNode(const UniqueId& nodeId) const;
@@ -1,7 +1,167 @@
 #include "Arrays.h"
+#include <stdlib.h>
 
 namespace Squirrel {
-namespace DAEImport { 
+namespace DAEImport {
 
-}//namespace DAEImport { 
-}//namespace Squirrel {
\ No newline at end of file
+namespace {
+
+//powers of ten that are exact in double
+const double POWERS_OF_TEN[] = {
+	1e0,	1e1,	1e2,	1e3,	1e4,	1e5,	1e6,	1e7,	1e8,	1e9,	1e10,	1e11,
+	1e12,	1e13,	1e14,	1e15,	1e16,	1e17,	1e18,	1e19,	1e20,	1e21,	1e22
+};
+
+const int MAX_EXACT_POWER = 22;
+
+//more digits may overflow 64 bit mantissa
+const int MAX_MANTISSA_DIGITS = 19;
+
+const uint64 MAX_EXACT_MANTISSA = (uint64)1 << 53;
+
+inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+inline bool IsWordEnd(char c)
+{
+	return c == 0 || c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+//special values, too long mantissas and exponents out of exact range
+float ParseFloatSlow(const char *& str)
+{
+	const char * end = str;
+	while(!IsWordEnd(*end)) ++end;
+
+	std::string word(str, end);
+	for(size_t i = 0; i < word.size(); ++i)
+	{
+		if(word[i] == ',') word[i] = '.';
+	}
+
+	str = end;
+	return static_cast<float>(atof(word.c_str()));
+}
+
+}//namespace {
+
+float ParseFloat(const char *& str)
+{
+	const char * p = str;
+
+	bool negative = (*p == '-');
+	if(*p == '-' || *p == '+') ++p;
+
+	uint64 mantissa = 0;
+	int digitsNum = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+	bool truncated = false;
+
+	//leading zeros are not significant
+	for(; *p == '0'; ++p) anyDigits = true;
+
+	for(; IsDigit(*p); ++p)
+	{
+		anyDigits = true;
+		if(digitsNum < MAX_MANTISSA_DIGITS)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			++digitsNum;
+		}
+		else
+		{
+			truncated = true;
+		}
+	}
+
+	if(*p == '.' || *p == ',')
+	{
+		++p;
+
+		if(digitsNum == 0)
+		{
+			for(; *p == '0'; ++p)
+			{
+				anyDigits = true;
+				--exponent;
+			}
+		}
+
+		for(; IsDigit(*p); ++p)
+		{
+			anyDigits = true;
+			if(digitsNum < MAX_MANTISSA_DIGITS)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				++digitsNum;
+				--exponent;
+			}
+			else
+			{
+				truncated = true;
+			}
+		}
+	}
+
+	if(anyDigits && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+
+		bool negativeExponent = (*p == '-');
+		if(*p == '-' || *p == '+') ++p;
+
+		int explicitExponent = 0;
+		for(; IsDigit(*p); ++p)
+		{
+			if(explicitExponent < 10000)
+				explicitExponent = explicitExponent * 10 + (*p - '0');
+		}
+
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	if(!anyDigits || truncated || !IsWordEnd(*p))
+	{
+		return ParseFloatSlow(str);
+	}
+
+	double value = 0;
+
+	if(mantissa != 0)
+	{
+		//both mantissa and power of ten are exact so result is correctly rounded
+		if(mantissa > MAX_EXACT_MANTISSA || exponent < -MAX_EXACT_POWER || exponent > MAX_EXACT_POWER)
+		{
+			return ParseFloatSlow(str);
+		}
+
+		value = (double)mantissa;
+		value = exponent < 0 ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+	}
+
+	str = p;
+	return static_cast<float>(negative ? -value : value);
+}
+
+int ParseInt(const char *& str)
+{
+	const char * p = str;
+
+	bool negative = (*p == '-');
+	if(*p == '-' || *p == '+') ++p;
+
+	int value = 0;
+	for(; IsDigit(*p); ++p)
+	{
+		value = value * 10 + (*p - '0');
+	}
+
+	str = p;
+	return negative ? -value : value;
+}
+
+}//namespace DAEImport {
+}//namespace Squirrel {
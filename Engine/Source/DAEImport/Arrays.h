@@ -2,71 +2,58 @@
 
 #include "macros.h"
 #include <Common/common.h>
+#include <vector>
 
 namespace Squirrel {
 namespace DAEImport { 
 
+//In place number parsing, str is moved past parsed characters.
+//Both '.' and ',' are accepted as decimal point.
+SQDAEIMPORTER_API float ParseFloat(const char *& str);
+SQDAEIMPORTER_API int ParseInt(const char *& str);
+
 template <class TElem>
 class DataArray
 {
-	inline bool isSpace(const char& c)
+	static inline bool isSpace(char c)
 	{
 		return (c == ' ' || c == '\r' || c == '\n' || c == '\t');
 	}
 
+	static inline const char * skipSpaces(const char * str)
+	{
+		while(isSpace(*str)) ++str;
+		return str;
+	}
+
+	static inline const char * skipWord(const char * str)
+	{
+		while(*str != 0 && !isSpace(*str)) ++str;
+		return str;
+	}
+
 	inline void initWithData(int size, const char * src)
 	{
 		mArray = NULL;
+		mSize = 0;
 
 		if(size <= 0) return;
 
 		mArray = new TElem[mSize = size];
 
-		//tmp buffer for word
-		char tmpStr[128];
-
-		size_t strLen = strlen(src);
-		int strStart = 0;//word start
-		int strEnd = 0;//word end
-		int strPos = 0;//position in src string
-		int counter = 0;//counter of words
+		//go through string and parse words in place
+		const char * str = skipSpaces(src);
+		int counter = 0;
+		for(; counter < mSize && *str != 0; ++counter)
+		{
+			mArray[counter] = elemFromString(str);
+			str = skipSpaces(skipWord(str));
+		}
 
-		//go through string and parse words
-		while(strPos < strLen)
+		//string is shorter than declared count
+		for(; counter < mSize; ++counter)
 		{
-			//skip spaces before word
-			for(;;++strPos)
-			{
-				if(strPos == strLen || !isSpace(src[strPos]))
-				{
-					strStart = strPos;
-					break;
-				}
-			}
-
-			//find the end of word
-			for(strPos = strStart;; ++strPos)
-			{
-				if(strPos == strLen || isSpace(src[strPos]))
-				{
-					strEnd = strPos - 1;
-					break;
-				}
-			}
-
-			//extract word from src string
-			int tmpStrLen = strEnd - strStart + 1;
-			memcpy(tmpStr, &src[strStart], tmpStrLen);
-			tmpStr[tmpStrLen] = '\0';
-
-			//convert word to element
-			mArray[counter] = elemFromString(tmpStr);
-
-			//skip one space
-			//strStart = strPos + 1;
-
-			//inc counter of words
-			if(++counter == mSize)	break;
+			mArray[counter] = TElem();
 		}
 	}
 
@@ -79,34 +66,35 @@ public:
 	inline DataArray(int size)
 	{
 		mArray = NULL;
+		mSize = 0;
 
 		if(size <= 0) return;
 
 		mArray = new TElem[mSize = size];
 	}
 
+	//size is unknown, parses in one pass into growing storage
 	inline DataArray(const char * src)
 	{
-		//calculate number of spaces to determine size of array
-		size_t strLen = strlen(src);
-		int wordsNum = 0;
-		bool word = false;
-		for(int i = 0; i < strLen; ++i)
+		mArray = NULL;
+		mSize = 0;
+
+		std::vector<TElem> elements;
+
+		const char * str = skipSpaces(src);
+		while(*str != 0)
 		{
-			if(!isSpace(src[i]) && !word)
-			{
-				word = true;
-				++wordsNum;
-			}
-			if(isSpace(src[i]) && word)
-			{
-				word = false;
-			}
+			elements.push_back(elemFromString(str));
+			str = skipSpaces(skipWord(str));
 		}
-		//actual size of array is bigger than number of spaces by one
-		int size = wordsNum;
 
-		initWithData(size, src);
+		if(elements.empty()) return;
+
+		mArray = new TElem[mSize = (int)elements.size()];
+		for(int i = 0; i < mSize; ++i)
+		{
+			mArray[i] = elements[i];
+		}
 	}
 
 	inline DataArray(int size, const char * src)
@@ -151,31 +139,32 @@ public:
 
 protected:
 
-	inline TElem elemFromString(char * src);
+	//parses word starting at str, str may be left anywhere inside the word
+	static inline TElem elemFromString(const char *& str);
 
 	int mSize;
 	TElem * mArray;
 };
 
 template <>
-inline std::string DataArray<std::string>::elemFromString(char * src)
+inline std::string DataArray<std::string>::elemFromString(const char *& str)
 {
-	return std::string(src);
+	const char * end = skipWord(str);
+	std::string result(str, end);
+	str = end;
+	return result;
 }
 
 template <>
-inline float DataArray<float>::elemFromString(char * src)
+inline float DataArray<float>::elemFromString(const char *& str)
 {
-	size_t srclen = strlen(src);
-	for(size_t i = 0; i < srclen; ++i)
-		if(src[i] == ',') src[i] = '.';
-	return static_cast<float>(atof(src));
+	return ParseFloat(str);
 }
 
 template <>
-inline int DataArray<int>::elemFromString(char * src)
+inline int DataArray<int>::elemFromString(const char *& str)
 {
-	return atoi(src);
+	return ParseInt(str);
 }
 
 template <class TElem>
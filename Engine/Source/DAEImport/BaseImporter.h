@@ -79,6 +79,9 @@ public:
 
 	virtual void importObject(pugi::xml_node node) = 0;
 
+	//objects of library may be imported on worker threads at once
+	virtual bool isConcurrent() const { return false; }
+
 protected:
 
 	//UniqueId getUniqueId(pugi::xml_node node);
@@ -5,6 +5,8 @@
 
 #include <Common/Settings.h>
 #include <Common/Log.h>
+#include <Common/TaskPool.h>
+#include <Common/Profiler.h>
 
 #define AllTracksIntoOneAnim	true
 
@@ -24,8 +26,19 @@
 namespace Squirrel {
 namespace DAEImport { 
 
+namespace {
+
+struct ConcurrentImport
+{
+	BaseImporter *						importer;
+	const std::vector<pugi::xml_node> *	nodes;
+	std::atomic<int> *					objectsDone;
+};
+
+}//namespace {
+
 DocumentImporter::DocumentImporter(Render::IRender * render, Resource::TextureStorage * texStorage, Resource::MaterialLibrary * matLib):
-	Resource::IModelImporter(render, texStorage, matLib), mModel(NULL)
+	Resource::IModelImporter(render, texStorage, matLib), mModel(NULL), mObjectsDone(0), mObjectsNum(0)
 {
 
 }
@@ -36,14 +49,36 @@ DocumentImporter::~DocumentImporter(void)
 
 const char_t * DocumentImporter::getImportingStageDesc() const 
 {
-	return mImportingStage.c_str();
+	std::unique_lock<std::mutex> lock(mStageMutex);
+	mImportingStageCopy = mImportingStage;
+	return mImportingStageCopy.c_str();
+}
+
+float DocumentImporter::getImportingProgress() const
+{
+	int objectsNum = mObjectsNum.load();
+	return objectsNum > 0 ? (float)mObjectsDone.load() / objectsNum : -1.0f;
 }
 
 void DocumentImporter::setImportStage(const char_t * str)
 {
+	std::unique_lock<std::mutex> lock(mStageMutex);
 	mImportingStage = str;
 }
 
+void DocumentImporter::ImportObjects(void * context, int begin, int end)
+{
+	SQ_PROFILE_FUNCTION();
+
+	ConcurrentImport * import = static_cast<ConcurrentImport *>(context);
+
+	for(int i = begin; i < end; ++i)
+	{
+		import->importer->importObject((*import->nodes)[i]);
+		++(*import->objectsDone);
+	}
+}
+
 bool DocumentImporter::parseXMLNode(pugi::xml_node node)
 {
 	const char * nodeName = node.name();
@@ -69,18 +104,43 @@ bool DocumentImporter::parseXMLNode(pugi::xml_node node)
 
 		BaseImporter * importer = it->second;
 
+		std::vector<pugi::xml_node> objNodes;
+		for(pugi::xml_node objNode = node.first_child(); objNode; objNode = objNode.next_sibling())
+		{
+			objNodes.push_back(objNode);
+		}
+
+		mObjectsDone = 0;
+		mObjectsNum = (int)objNodes.size();
+
 		char_t str[256];
-		int counter = 0;
 
 		//import library content
-		for(pugi::xml_node objNode = node.first_child(); objNode; objNode = objNode.next_sibling())
+		if(importer->isConcurrent())
 		{
-			sprintf(str, "Importing %s %d...", objNode.name(), counter++);
-
+			sprintf(str, "Importing %s...", nodeName);
 			setImportStage(str);
 
-			importer->importObject(objNode);
+			ConcurrentImport import;
+			import.importer		= importer;
+			import.nodes		= &objNodes;
+			import.objectsDone	= &mObjectsDone;
+
+			TaskPool::Default()->parallelFor((int)objNodes.size(), 1, ImportObjects, &import);
 		}
+		else
+		{
+			for(size_t i = 0; i < objNodes.size(); ++i)
+			{
+				sprintf(str, "Importing %s %d...", objNodes[i].name(), (int)i);
+				setImportStage(str);
+
+				importer->importObject(objNodes[i]);
+				++mObjectsDone;
+			}
+		}
+
+		mObjectsNum = 0;
 	}
 
 	return true;
@@ -529,6 +589,18 @@ void DocumentImporter::finish()
 		applyBindTransform( itSkinnedVB->first, itSkinnedVB->second );
 	}
 
+	setImportStage("Optimizing meshes...");
+
+	Resource::MeshProcessing::OptimizationParams optimizationParams;
+	optimizationParams.readSettings("MeshOptimization");
+	mModel->optimizeMeshes(optimizationParams);
+
+	setImportStage("Packing vertices...");
+
+	Resource::MeshProcessing::PackingParams packingParams;
+	packingParams.readSettings("VertexPacking");
+	mModel->packVertices(packingParams);
+
 	//remove imported VBs from MeshImporter to avoid their destruction
 	mMeshImporter->getSharedVBs()->clear();
 
@@ -15,6 +15,8 @@
 #include <list>
 #include <string>
 #include <map>
+#include <mutex>
+#include <atomic>
 
 namespace Squirrel {
 namespace DAEImport { 
@@ -51,6 +53,14 @@ private:
 
 	String mImportingStage;
 
+	//stage is set by importing thread and read by UI thread
+	mutable std::mutex mStageMutex;
+	mutable String mImportingStageCopy;
+
+	//library objects progress
+	std::atomic<int> mObjectsDone;
+	std::atomic<int> mObjectsNum;
+
 public:
 	DocumentImporter(Render::IRender * render, Resource::TextureStorage * texStorage, Resource::MaterialLibrary * matLib);
 	virtual ~DocumentImporter(void);
@@ -66,9 +76,13 @@ public:
 
 	const char_t * getImportingStageDesc() const;
 
+	virtual float getImportingProgress() const;
+
 private:
 
-	 void setImportStage(const char_t * str);
+	void setImportStage(const char_t * str);
+
+	static void ImportObjects(void * context, int begin, int end);
 
 	void finish();
 
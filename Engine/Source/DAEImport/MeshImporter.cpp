@@ -30,8 +30,7 @@ namespace DAEImport {
 	
 
 MeshImporter::MeshImporter(Render::IRender * render):
-	mRender(render), mSrcPositions(NULL), mSrcNormals(NULL), mSrcTexcoords(NULL),
-	m_bSwapYZ(false)
+	mRender(render), m_bSwapYZ(false)
 {
 }
 
@@ -47,8 +46,9 @@ void MeshImporter::importObject(pugi::xml_node node)
 {
 	if(strcmp(node.name(), GEOMETRY_TAG) != 0) return;
 
-	//
-	mDocumentMeshId = node.attribute(ID_ATTR.c_str()).value();
+	ImportContext ctx;
+
+	ctx.documentMeshId = node.attribute(ID_ATTR.c_str()).value();
 
 	//meshName = node.attribute(NAME_ATTR.c_str()).value();
 
@@ -57,7 +57,7 @@ void MeshImporter::importObject(pugi::xml_node node)
 	//for now only meshes supported
 	if(!meshNode) return;
 
-	importMesh(meshNode);
+	importMesh(meshNode, ctx);
 }
 
 
@@ -101,17 +101,8 @@ std::vector<VertexBuffer *> * MeshImporter::getSharedVBs()
 	return &mSharedVBs; 
 }
 
-bool MeshImporter::importMesh(pugi::xml_node node)
+bool MeshImporter::importMesh(pugi::xml_node node, ImportContext& ctx)
 {
-	mNextTupleIndex = 0;
-	mTupleMap.clear();	
-
-	mSrcPositions = NULL;
-	mSrcNormals = NULL;
-	mSrcTexcoords = NULL;
-	mSrcTangents = NULL;
-	mSrcBinormals = NULL;
-
 	std::map<UniqueId, FloatArray *> vertexDataArrays;
 
 	//parse content
@@ -232,28 +223,28 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 				//map source array
 				if(semantic == VERTEX_SEMANTIC)
 				{
-					mSrcPositions = itSource->second;
+					ctx.srcPositions = itSource->second;
 					primitive.positionsOffset = offset;
 				}
 				else if(semantic == NORMAL_SEMANTIC)
 				{
-					mSrcNormals = itSource->second;
+					ctx.srcNormals = itSource->second;
 					primitive.normalsOffset = offset;
 				}
 				else if(semantic == TEXCOORD_SEMANTIC)// && set == 0)
 				{
 					//for now support only first set
-					mSrcTexcoords = itSource->second;
+					ctx.srcTexcoords = itSource->second;
 					primitive.texcoordsOffset = offset;
 				}
 				else if(semantic == TEXTANGENT_SEMANTIC)// && set == 0)
 				{
-					mSrcTangents = itSource->second;
+					ctx.srcTangents = itSource->second;
 					primitive.tangentsOffset = offset;
 				}
 				else if(semantic == TEXBINORMAL_SEMANTIC)// && set == 0)
 				{
-					mSrcBinormals = itSource->second;
+					ctx.srcBinormals = itSource->second;
 					primitive.binormalsOffset = offset;
 				}
 
@@ -342,28 +333,33 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 
 	ASSERT(primitives.size());
 
-	ASSERT(mSrcPositions != NULL && mSrcPositions->getSize() > 0);
+	ASSERT(ctx.srcPositions != NULL && ctx.srcPositions->getSize() > 0);
 
 	// define target vertex type (vertex components)
 
 	int iVertType = VCI2VT(VertexBuffer::vcPosition);
 
-	if(mSrcNormals != NULL && mSrcNormals->getSize() > 0)
+	if(ctx.srcNormals != NULL && ctx.srcNormals->getSize() > 0)
 	{
 		iVertType |= VCI2VT(VertexBuffer::vcNormal);
 	}
-	if(mSrcTexcoords != NULL && mSrcTexcoords->getSize() > 0)
+	if(ctx.srcTexcoords != NULL && ctx.srcTexcoords->getSize() > 0)
 	{
 		iVertType |= VCI2VT(VertexBuffer::vcTexcoord);
 	}
-	if(mSrcTangents != NULL && mSrcTangents->getSize() > 0)
+	if(ctx.srcTangents != NULL && ctx.srcTangents->getSize() > 0)
 	{
 		iVertType |= VCI2VT(VertexBuffer::vcTangentBinormal);
 	}
 
 	//init original vertex position mapping (TODO: make it per VB)
-	mCurrentVertexMapping = new VERTEX_POSITION_MAP( aproxMaximumVertsNum );
-	mMeshID2VertexMappingMap[ mDocumentMeshId ]	= mCurrentVertexMapping;
+	ctx.tupleMap.reserve( aproxMaximumVertsNum );
+
+	ctx.vertexMapping = new VERTEX_POSITION_MAP( aproxMaximumVertsNum );
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mMeshID2VertexMappingMap[ ctx.documentMeshId ]	= ctx.vertexMapping;
+	}
 
 	//DAE mesh always has only one VB but can have more IBs(primitives)
 
@@ -377,7 +373,7 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 		if(mSharedVBs.size() == 0)
 		{
 			// create vb with solid vertex, size of vb is approximate minimum, then will be extended if needed
-			mSharedVBs.push_back( mRender->createVertexBuffer(iVertType, mSrcPositions->getCount()) );
+			mSharedVBs.push_back( mRender->createVertexBuffer(iVertType, ctx.srcPositions->getCount()) );
 		}
 		else
 		{
@@ -388,7 +384,10 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 	else
 	*/
 
-	pVB = mRender->createVertexBuffer(iVertType, aproxMaximumVertsNum);
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		pVB = mRender->createVertexBuffer(iVertType, aproxMaximumVertsNum);
+	}
 
 	IndexBuffer::IndexSize vertexIndexSize = aproxMaximumVertsNum > 65000 ? IndexBuffer::Index32 : IndexBuffer::Index16;
 
@@ -412,7 +411,10 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 			pMesh->setVertexBuffer(pVB);
 		}
 
-		addMesh(mDocumentMeshId, primitive.id, pMesh);
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			addMesh(ctx.documentMeshId, primitive.id, pMesh);
+		}
 
 		IndexBuffer * pIB = NULL;
 		int iCurrInd = 0;
@@ -432,7 +434,10 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 			}
 
 			//create FS index buffer for mesh
-			pIB = pMesh->createIndexBuffer(iIndNum);
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				pIB = pMesh->createIndexBuffer(iIndNum);
+			}
 			pIB->setPolyType(IndexBuffer::ptTriangles);
 
 			//import indices of polygons and triangulate them
@@ -454,7 +459,7 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 
 						int * tupleArr = primitive.indices->getTuple(index);
 
-						addTupleIndex(primitive, tupleArr, pVB, iCurrVert, pIB, iCurrInd);
+						addTupleIndex(ctx, primitive, tupleArr, pVB, iCurrVert, pIB, iCurrInd);
 					}
 				}
 
@@ -465,7 +470,10 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 		{
 			//create FS index buffer for mesh
 			uint iIndNum = primitive.indices->getCount();
-			pIB = pMesh->createIndexBuffer(iIndNum, vertexIndexSize);
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				pIB = pMesh->createIndexBuffer(iIndNum, vertexIndexSize);
+			}
 			pIB->setPolyType(primitive.polyType);
 
 			//fill indices of current IB and extend global (shared) VB if needed
@@ -473,7 +481,7 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 			{
 				int * tupleArr = primitive.indices->getTuple(index);
 
-				addTupleIndex(primitive, tupleArr, pVB, iCurrVert, pIB, iCurrInd);
+				addTupleIndex(ctx, primitive, tupleArr, pVB, iCurrVert, pIB, iCurrInd);
 			}
 		}
 
@@ -483,7 +491,7 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 		if((uint)iCurrVert < pVB->getVertsNum())
 		{
 			pVB->resize( iCurrVert );
-			mCurrentVertexMapping->resize( iCurrVert );
+			ctx.vertexMapping->resize( iCurrVert );
 		}
 	}
 
@@ -507,69 +515,69 @@ bool MeshImporter::importMesh(pugi::xml_node node)
 	return true;
 }
 
-void MeshImporter::addTupleIndex( const DAEPrimitive& primitive, int * tupleArr, VertexBuffer *pVB, int &iCurrVert, IndexBuffer * pIB, int &iCurrInd )
+void MeshImporter::addTupleIndex( ImportContext& ctx, const DAEPrimitive& primitive, int * tupleArr, VertexBuffer *pVB, int &iCurrVert, IndexBuffer * pIB, int &iCurrInd )
 {
 	int positionIndex = tupleArr[primitive.positionsOffset];
 
 	int normalIndex = 0;
-	if ( mSrcNormals )
+	if ( ctx.srcNormals )
 		normalIndex = tupleArr[primitive.normalsOffset];
 
 	int uvIndex = 0;
-	if ( mSrcTexcoords )
+	if ( ctx.srcTexcoords )
 		uvIndex = tupleArr[primitive.texcoordsOffset];
 
 	int tangentIndex = 0;
-	if ( mSrcTangents )
+	if ( ctx.srcTangents )
 		tangentIndex = tupleArr[primitive.tangentsOffset];
 
 	int binormalIndex = 0;
-	if ( mSrcBinormals )
+	if ( ctx.srcBinormals )
 		binormalIndex = tupleArr[primitive.binormalsOffset];
 
 	Tuple tuple( positionIndex, normalIndex, uvIndex, tangentIndex, binormalIndex);
-	addTupleIndex(tuple, pVB, iCurrVert, pIB, iCurrInd);
+	addTupleIndex(ctx, tuple, pVB, iCurrVert, pIB, iCurrInd);
 }
 
 //------------------------------
-void MeshImporter::addTupleIndex( const Tuple& tuple, VertexBuffer *pVB, int &iCurrVert, IndexBuffer * pIB, int &iCurrInd )
+void MeshImporter::addTupleIndex( ImportContext& ctx, const Tuple& tuple, VertexBuffer *pVB, int &iCurrVert, IndexBuffer * pIB, int &iCurrInd )
 {
-	TupleIndexMap::iterator it = mTupleMap.find(tuple);
-	if ( it == mTupleMap.end() )
+	TupleIndexMap::iterator it = ctx.tupleMap.find(tuple);
+	if ( it == ctx.tupleMap.end() )
 	{
 		//
 		//store vertex index
 		//
-		//mTupleMap.insert(tuple, mNextTupleIndex);
-		mTupleMap[tuple] = mNextTupleIndex;
-		pIB->setIndex(iCurrInd++, mNextTupleIndex);
-		++mNextTupleIndex;
+		//ctx.tupleMap.insert(tuple, ctx.nextTupleIndex);
+		ctx.tupleMap[tuple] = ctx.nextTupleIndex;
+		pIB->setIndex(iCurrInd++, ctx.nextTupleIndex);
+		++ctx.nextTupleIndex;
 
 		if(iCurrVert == pVB->getVertsNum())
 		{
 			pVB->resize(pVB->getVertsNum() + VERTS_TO_INC);
-			mCurrentVertexMapping->resize( pVB->getVertsNum() + VERTS_TO_INC );
+			ctx.vertexMapping->resize( pVB->getVertsNum() + VERTS_TO_INC );
 		}
 
 		//
 		//read vertex position
 		//
 		Math::vec3 pos;
-		float* positionsArray = mSrcPositions->getArray();
+		float* positionsArray = ctx.srcPositions->getArray();
 		positionsArray += 3 * tuple.x;
 		vec3 position(positionsArray[0], positionsArray[1], positionsArray[2]);
 		pos = Math::vec3((float)position.x, (float)position.y, (float)position.z);
 
-		mCurrentVertexMapping->operator []( iCurrVert ) = tuple.x;
+		ctx.vertexMapping->operator []( iCurrVert ) = tuple.x;
 		pVB->setComponent<VertexBuffer::vcPosition>(iCurrVert, pos);//swap UpZ to UpY later, after applying bind shape transformation
 
 		//
 		//read vertex normal
 		//
 		vec3 normal;
-		if ( mSrcNormals )
+		if ( ctx.srcNormals )
 		{
-			float* normalsArray = mSrcNormals->getArray();
+			float* normalsArray = ctx.srcNormals->getArray();
 			normalsArray += 3 * tuple.y;
 			normal = vec3(normalsArray[0], normalsArray[1], normalsArray[2]);
 			//normal = mCurrentRotationMatrix * normal;
@@ -581,29 +589,29 @@ void MeshImporter::addTupleIndex( const Tuple& tuple, VertexBuffer *pVB, int &iC
 		//
 		//read vertex texcoord
 		//
-		if ( mSrcTexcoords )
+		if ( ctx.srcTexcoords )
 		{
-			float* uVCoordinateArray = mSrcTexcoords->getArray();
-			uVCoordinateArray += mSrcTexcoords->getStride() * tuple.z;
+			float* uVCoordinateArray = ctx.srcTexcoords->getArray();
+			uVCoordinateArray += ctx.srcTexcoords->getStride() * tuple.z;
 			pVB->setComponent<VertexBuffer::vcTexcoord>(iCurrVert, Math::vec2((float)uVCoordinateArray[0], (float)uVCoordinateArray[1]));
 		}
 
-		if(mSrcTangents)
+		if(ctx.srcTangents)
 		{
-			float* tangentsArray = mSrcTangents->getArray();
-			tangentsArray += mSrcTangents->getStride() * tuple.w;
+			float* tangentsArray = ctx.srcTangents->getArray();
+			tangentsArray += ctx.srcTangents->getStride() * tuple.w;
 			vec3 tangent(tangentsArray[0], tangentsArray[1], tangentsArray[2]);
 			tangent.normalize();
 
 			float dot = 1.0f;
 
-			if(mSrcTangents->getStride() == 4)
+			if(ctx.srcTangents->getStride() == 4)
 				dot = tangentsArray[3];
 
-			if(mSrcBinormals)
+			if(ctx.srcBinormals)
 			{
-				float* binormalsArray = mSrcBinormals->getArray();
-				binormalsArray += mSrcBinormals->getStride() * tuple.w;
+				float* binormalsArray = ctx.srcBinormals->getArray();
+				binormalsArray += ctx.srcBinormals->getStride() * tuple.w;
 				vec3 binormal(binormalsArray[0], binormalsArray[1], binormalsArray[2]);
 				binormal.normalize();
 
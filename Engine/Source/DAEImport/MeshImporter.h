@@ -6,6 +6,7 @@
 #include "Arrays.h"
 #include "macros.h"
 #include <unordered_map>
+#include <mutex>
 
 namespace Squirrel {
 namespace DAEImport {
@@ -56,13 +57,20 @@ class hash<Squirrel::DAEImport::Tuple> {
 public:
 	size_t operator()(const Squirrel::DAEImport::Tuple &s) const
 	{
+		//equal shifts made different components cancel each other
 		size_t h = std::hash<int>()(s.x);
-		h = h ^ (std::hash<int>()(s.y) << 1);
-		h = h ^ (std::hash<int>()(s.z) << 1);
-		h = h ^ (std::hash<int>()(s.w) << 1);
-		h = h ^ (std::hash<int>()(s.v) << 1);
+		combine(h, s.y);
+		combine(h, s.z);
+		combine(h, s.w);
+		combine(h, s.v);
 		return h;
 	}
+
+private:
+	static inline void combine(size_t& h, int value)
+	{
+		h ^= std::hash<int>()(value) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	}
 };
 
 }
@@ -98,33 +106,55 @@ private:
 public:
 	typedef std::vector<int> VERTEX_POSITION_MAP; 
 
+private:
+
+	//state of one geometry import, geometries are imported concurrently
+	struct ImportContext
+	{
+		ImportContext(): nextTupleIndex(0), srcPositions(NULL), srcNormals(NULL), srcTexcoords(NULL),
+			srcTangents(NULL), srcBinormals(NULL), vertexMapping(NULL) {}
+
+		UniqueId		documentMeshId;
+
+		TupleIndexMap	tupleMap;
+		int				nextTupleIndex;
+
+		FloatArray *	srcPositions;
+		FloatArray *	srcNormals;
+		FloatArray *	srcTexcoords;
+		FloatArray *	srcTangents;
+		FloatArray *	srcBinormals;
+
+		VERTEX_POSITION_MAP * vertexMapping;
+	};
+
 public:
 	MeshImporter(Render::IRender * render);
 	virtual ~MeshImporter(void);
 
 	virtual void importObject(pugi::xml_node node);
 
+	virtual bool isConcurrent() const { return true; }
+
 	Resource::Mesh * getMesh(const UniqueId& meshId, const UniqueId& primId);
 	VERTEX_POSITION_MAP * getVertexMapping(const UniqueId& meshId);
 
 	std::vector<VertexBuffer *> * getSharedVBs();
 
 private:
-	void addTupleIndex( const Tuple& tuple, RenderData::VertexBuffer *pVB, int &iCurrVert, RenderData::IndexBuffer * pIB, int &iCurrInd );
-	void addTupleIndex( const DAEPrimitive& primitive, int * tupleArr, VertexBuffer *pVB, int &iCurrVert, IndexBuffer * pIB, int &iCurrInd );
+	void addTupleIndex( ImportContext& ctx, const Tuple& tuple, RenderData::VertexBuffer *pVB, int &iCurrVert, RenderData::IndexBuffer * pIB, int &iCurrInd );
+	void addTupleIndex( ImportContext& ctx, const DAEPrimitive& primitive, int * tupleArr, VertexBuffer *pVB, int &iCurrVert, IndexBuffer * pIB, int &iCurrInd );
 
 private:
 
 	void addMesh(const UniqueId& meshId, const UniqueId& primId, Resource::Mesh * mesh);
 
-	bool importMesh(pugi::xml_node node);
+	bool importMesh(pugi::xml_node node, ImportContext& ctx);
 
 	Render::IRender * mRender;//for creating VBs and IBs
 
-	TupleIndexMap mTupleMap;
-	int mNextTupleIndex;
-
-	UniqueId mDocumentMeshId;
+	//guards imported meshes maps and buffers creation
+	std::mutex mMutex;
 
 	//parameters of importing
 	bool m_bSwapYZ;
@@ -139,17 +169,6 @@ private:
 	//
 	MESHES_MAP									mMeshesMap;
 	std::map<UniqueId, VERTEX_POSITION_MAP *>	mMeshID2VertexMappingMap;
-
-	FloatArray * mSrcPositions;
-	FloatArray * mSrcNormals;
-	FloatArray * mSrcTexcoords;
-	FloatArray * mSrcTangents;
-	FloatArray * mSrcBinormals;
-
-	Math::mat3 mCurrentRotationMatrix;
-	Math::vec3 mCurrentTranslationVector;
-
-	VERTEX_POSITION_MAP * mCurrentVertexMapping;
 };
 
 }//namespace DAEImport { 
@@ -766,7 +766,7 @@ void Editor::process()
 
 	if(mCurrentModelImporter && mCurrentModelImporter->isRunning())
 	{
-		mProgressPanel->setText(mCurrentModelImporter->getStageDesc());
+		mProgressPanel->setText(mCurrentModelImporter->getStageDesc(), mCurrentModelImporter->getProgress());
 
 		Resource::Model * model = mCurrentModelImporter->getModel();
 		if(model != NULL)
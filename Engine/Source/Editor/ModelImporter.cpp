@@ -106,6 +106,13 @@ const char_t * ModelImporter::getStageDesc()
 	return mModelImporter->getImportingStageDesc();
 }
 
+float ModelImporter::getProgress()
+{
+	ASSERT(mModelImporter);
+
+	return mModelImporter->getImportingProgress();
+}
+
 Resource::Model * ModelImporter::getModel()
 {
 	if(mImportThread && mImportThread->isFinished())
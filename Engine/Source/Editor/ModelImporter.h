@@ -26,6 +26,9 @@ public:
 
 	const char_t * getStageDesc();
 
+	//negative if unknown
+	float getProgress();
+
 	Resource::Model * getModel();
 
 	bool isOk() const		{ return mIsOk; }
@@ -41,10 +41,19 @@ void ProgressPanel::show(const char_t * title)
 	mPanel->setPos(pos);
 }
 
-void ProgressPanel::setText(const char_t * text)
+void ProgressPanel::setText(const char_t * text, float progress)
 {
 	mPanel->setTopmost();
-	mProgress->setText(text);
+
+	if(progress < 0)
+	{
+		mProgress->setText(text);
+		return;
+	}
+
+	char_t str[256];
+	sprintf(str, "%.200s %d%%", text, (int)(Math::clamp(progress, 0.0f, 1.0f) * 100));
+	mProgress->setText(str);
 }
 
 void ProgressPanel::close()
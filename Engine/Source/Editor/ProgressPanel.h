@@ -20,7 +20,8 @@ public://methods
 	void show(const char_t * title);
 	void close();
 
-	void setText(const char_t * text);
+	//progress in [0, 1] is shown as percents after text, negative is not shown
+	void setText(const char_t * text, float progress = -1.0f);
 
 private://members
 
@@ -5,19 +5,56 @@
 #include <World/Skeleton.h>
 #include <Common/Settings.h>
 #include <Audio/IAudio.h>
+#include <Audio/Mixer.h>
+#include <Common/Profiler.h>
+#include <Common/EventBus.h>
+#include <Common/LinearAllocator.h>
+#include <Render/BufferMemory.h>
+#include <GUI/TextLayoutCache.h>
 
 namespace Squirrel {
 namespace Engine { 
 
-int timeNodeUpdate = 0;
-int timeNodeRender = 0;
-int timeNodeRenderUI = 0;
-int timeNodeFinish = 0;
-int timeNodeOther = 0;
+namespace {
+
+template <class TStorage>
+void CleanUpStorage(TStorage * storage)
+{
+	if(storage != NULL)
+	{
+		storage->cleanUp();
+	}
+}
+
+template <class TStorage>
+void CheckStorageModifications(TStorage * storage)
+{
+	if(storage != NULL)
+	{
+		storage->checkModifications();
+	}
+}
+
+template <class TStorage>
+bool FormatCacheStats(char * buffer, TStorage * storage)
+{
+	if(storage == NULL)
+		return false;
+
+	const float MB = 1024.0f * 1024.0f;
+	const typename TStorage::CacheStats& stats = storage->getCacheStats();
+	sprintf(buffer, "%s: %1.1f/%1.1fMB (unused %1.1fMB), hits: %d, misses: %d, evictions: %d", storage->getStorageName().c_str(),
+		stats.memorySize / MB, storage->getMemoryBudget() / MB, stats.unusedMemorySize / MB,
+		stats.hitsNum, stats.missesNum, stats.evictionsNum );
+	return true;
+}
+
+}//namespace {
 
 Resource::Program * mSimleColorProgram = NULL;
 	
-Engine::Engine() 
+Engine::Engine():
+	mHeapAllocationsNum(0), mFrameHeapAllocationsNum(0)
 {
 	bool forceCPUSkinning = Settings::Default()->getInt("Engine", "ForceCPUSkinning", 0) != 0;
 	World::Skeleton::EnableCPUSkinning(forceCPUSkinning);
@@ -29,12 +66,12 @@ Engine::Engine()
 	mRenderManager = new RenderManager;
 	mRenderManager->init();
 	
-	//init tmp benchmark
-	timeNodeUpdate		= TimeCounter::Instance().addNode("update");
-	timeNodeRender		= TimeCounter::Instance().addNode("render");
-	timeNodeRenderUI	= TimeCounter::Instance().addNode("renderUI");
-	timeNodeFinish		= TimeCounter::Instance().addNode("finish");
-	timeNodeOther		= TimeCounter::Instance().addNode("other");
+	//init profiler
+	Profiler::SetThreadName("Main");
+	Profiler::Instance().setEnabled(Settings::Default()->getInt("Engine", "Profiler", 1) != 0);
+	mProfilerTraceFile = Settings::Default()->getString("Engine", "ProfilerTraceFile", "");
+
+	mLoadingBudgetMs = Settings::Default()->getFloat("Engine", "LoadingBudget", 2.0f);
 	
 	mSimleColorProgram = Resource::ProgramStorage::Active()->add("GUI/GUI.glsl");
 		
@@ -43,32 +80,44 @@ Engine::Engine()
 
 Engine::~Engine() 
 {
+	GUI::Manager::Instance().saveFontCaches();
+
+	if(!mProfilerTraceFile.empty())
+	{
+		Profiler::Instance().exportChromeTrace(mProfilerTraceFile);
+	}
 }
 
 void Engine::process(World::World * world)
 {
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeOther);
-
 	//end render previous frame
 
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeFinish);
+	{
+		SQ_PROFILE_ZONE("finish");
 
-	mRenderManager->end();
+		mRenderManager->end();
+	}
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeFinish);
+	//events posted while previous frame was rendered
+	EventBus::Default()->flush(EventBus::qFrameEnd);
 
 	TimeCounter::Instance().calcTime();
 
-	//update world
+	Profiler::Instance().endFrame();
 
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeUpdate);
+	//last record of previous frame is written without waiting for next one
+	Log::Instance().flush();
 
-	float deltaTime = TimeCounter::Instance().getDeltaTime();
+	//temporary data of previous frame is not referenced anymore
+	LinearAllocator::Frame().reset();
+
+	uint64 heapAllocationsNum = Allocator::GetHeapAllocationsNum();
+	mFrameHeapAllocationsNum = (int)(heapAllocationsNum - mHeapAllocationsNum);
+	mHeapAllocationsNum = heapAllocationsNum;
 
-	GUI::Manager::Instance().update();
+	float deltaTime = TimeCounter::Instance().getDeltaTime();
 
-	world->updateRecursively(deltaTime);
-	world->updateTransform();
+	Render::IRender * render = Render::IRender::GetActive();
 
 	//get main camera
 	Render::Camera * cam = Render::Camera::GetMainCamera();
@@ -79,40 +128,93 @@ void Engine::process(World::World * world)
 		cam->setAsMain();
 	}
 
-	Audio::IAudio * audio = Audio::IAudio::GetActive();
-	audio->setListenerPosition( cam->getPosition() );
-	audio->setListenerOrientation( cam->getDirection(), vec3::AxisY() );
+	Resource::AsyncLoader * loader = Resource::AsyncLoader::Active();
 
-	//setup main camera
+	//update world
 
-	Render::IRender * render = Render::IRender::GetActive();
+	{
+		SQ_PROFILE_ZONE("update");
+
+		//reloading of changed files is batched with background loading
+		CheckStorageModifications( Resource::TextureStorage::Active() );
+		CheckStorageModifications( Resource::ModelStorage::Active() );
+		CheckStorageModifications( Resource::ProgramStorage::Active() );
+
+		//finish resources loaded in background before world sees them
+		if(loader != NULL)
+		{
+			loader->setViewPoint( cam->getPosition() );
+			loader->update( mLoadingBudgetMs );
+		}
+
+		//levels of textures rendered last frame
+		Resource::TextureStorage * texStorage = Resource::TextureStorage::Active();
+		Resource::TextureStreamer * streamer = texStorage != NULL ? texStorage->getStreamer() : NULL;
+		if(streamer != NULL)
+		{
+			streamer->update();
+		}
+
+		GUI::Manager::Instance().update();
+
+		//events posted by input, loaders and other threads since last frame
+		EventBus::Default()->flush(EventBus::qUpdate);
+
+		world->updateRecursively(deltaTime);
+		world->updateTransform();
+
+		Audio::Mixer * mixer = Audio::Mixer::Active();
+		if(mixer != NULL)
+		{
+			mixer->setListener( cam->getPosition(), cam->getDirection(), vec3::AxisY() );
+			mixer->update( deltaTime );
+		}
+		else
+		{
+			Audio::IAudio * audio = Audio::IAudio::GetActive();
+			audio->setListenerPosition( cam->getPosition() );
+			audio->setListenerOrientation( cam->getDirection(), vec3::AxisY() );
+		}
+
+		//setup main camera
+
+		tuple2i screen = render->getWindow()->getSize();
+		render->setViewport(0,0,screen.x,screen.y);
+
+		float aspect = (float)screen.x / screen.y;
+		cam->buildProjection(75 * DEG2RAD,aspect, 0.1f, world->getEffectiveViewDistance());
+		render->setProjection(cam->getFinalMatrix());
+	}
 
-	tuple2i screen = render->getWindow()->getSize();
-	render->setViewport(0,0,screen.x,screen.y);
+	//start render new frame
 
-	float aspect = (float)screen.x / screen.y;
-	cam->buildProjection(75 * DEG2RAD,aspect, 0.1f, world->getEffectiveViewDistance());
-	render->setProjection(cam->getFinalMatrix());
+	Render::IProgram * colorProgram = mSimleColorProgram->getRenderProgram("TEXTURE;");
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeUpdate);
+	{
+		SQ_PROFILE_ZONE("render");
 
-	//start render new frame
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeRender);
+		mRenderManager->begin();
+		mRenderManager->render(world);
 
-	mRenderManager->begin();
-	mRenderManager->render(world);
+		colorProgram->bind();
 
-	Render::IProgram * colorProgram = mSimleColorProgram->getRenderProgram("TEXTURE;");
+		mRenderManager->draw3DDebugInfo();
+	}
 
-	colorProgram->bind();
+	//evict resources released this frame if storages are over their memory budgets
 
-	mRenderManager->draw3DDebugInfo();
+	{
+		SQ_PROFILE_ZONE("resources cleanup");
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeRender);
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeRenderUI);
+		CleanUpStorage( Resource::TextureStorage::Active() );
+		CleanUpStorage( Resource::ModelStorage::Active() );
+		CleanUpStorage( Resource::SoundStorage::Active() );
+	}
 
 	//render UI
 
+	SQ_PROFILE_ZONE("renderUI");
+
 	Render::Utils::Begin2D();
 	
 	//if optimized
@@ -153,6 +255,19 @@ void Engine::process(World::World * world)
 		sprintf(strBuffer, "%s: %1.4fms", node->name.c_str(), node->ms );
 		mainFont->drawText(4, yPos += strOffset, strBuffer);
 	}
+
+	//main thread zones
+	std::vector<const Profiler::Node *> profilerNodes;
+	Profiler::Instance().collectTree(profilerNodes);
+	int mainThread = Profiler::GetThreadIndex();
+	for(size_t i = 0; i < profilerNodes.size(); ++i)
+	{
+		const Profiler::Node * node = profilerNodes[i];
+		if(node->zone == NULL || node->threadIndex != mainThread || node->depth > 3)
+			continue;
+		sprintf(strBuffer, "%*s%s: %1.4fms", (node->depth - 1) * 2, "", node->zone->name, node->avgMs );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
 	sprintf(strBuffer, "drawCalls: %d", render->getRenderStatistics().mDrawCallsNum );
 	mainFont->drawText(4, yPos += strOffset, strBuffer);
 	sprintf(strBuffer, "batches: %d", render->getRenderStatistics().mBatchesNum );
@@ -160,9 +275,102 @@ void Engine::process(World::World * world)
 	sprintf(strBuffer, "tris: %d", render->getRenderStatistics().mTrianglesNum );
 	mainFont->drawText(4, yPos += strOffset, strBuffer);
 
+	const World::TransformHierarchy::Stats& transformStats = world->getTransforms()->getStats();
+	sprintf(strBuffer, "transforms: %d/%d, bounds: %d", transformStats.mTransformsRecomputed, transformStats.mNodesNum, transformStats.mBoundsRecomputed );
+	mainFont->drawText(4, yPos += strOffset, strBuffer);
+
+	const World::CollisionWorld::Stats& collisionStats = world->getCollisions()->getStats();
+	sprintf(strBuffer, "collision proxies: %d, pairs: %d, contacts: %d", collisionStats.mProxiesNum, collisionStats.mBroadphasePairsNum, collisionStats.mContactsNum );
+	mainFont->drawText(4, yPos += strOffset, strBuffer);
+
+	std::vector<World::BehaviourScheduler::ClassStats> behaviourStats;
+	world->getBehaviours()->getStats(behaviourStats);
+	for(size_t i = 0; i < behaviourStats.size(); ++i)
+	{
+		const World::BehaviourScheduler::ClassStats& stats = behaviourStats[i];
+		sprintf(strBuffer, "%s%s: %d/%d, %1.4fms", stats.name.c_str(), stats.parallel ? " (parallel)" : "", stats.updatedNum, stats.behavioursNum, stats.avgUpdateMs );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
+
+	if(World::Terrain::GetMain() != NULL)
+	{
+		const World::Terrain::LodStats& terrainStats = World::Terrain::GetMain()->getLodStats();
+		sprintf(strBuffer, "terrain patches: %d, tris: %d", terrainStats.patchesNum, terrainStats.trianglesNum );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
+
+	std::vector<Shadow *> shadows;
+	mRenderManager->getShadowsManager()->getShadows(shadows);
+	for(size_t i = 0; i < shadows.size(); ++i)
+	{
+		const ShadowCasters::Stats& stats = shadows[i]->getCasterStats();
+		Render::Light::EType lightType = shadows[i]->getLight() != NULL ? shadows[i]->getLight()->mLightType : Render::Light::ltUnknown;
+		const char_t * lightName = lightType == Render::Light::ltDirectional ? "dir" : (lightType == Render::Light::ltSpot ? "spot" : "omni");
+		sprintf(strBuffer, "%s shadow %d: casters: %d, binned: %d into %d views, cached: %d%%", lightName, (int)i, stats.candidatesNum, stats.castersNum, stats.viewsNum,
+			stats.framesNum > 0 ? stats.cachedFramesNum * 100 / stats.framesNum : 0 );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+		sprintf(strBuffer, "  dynamic: %d, views updated: %d (static: %d), deferred: %d, drawCalls: %d", stats.dynamicCastersNum, stats.updatedViewsNum,
+			stats.staticViewsNum, stats.deferredViewsNum, stats.drawCallsNum );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
+
 	sprintf(strBuffer, "cam: %1.2f, %1.2f, %1.2f", cam->getPosition().x, cam->getPosition().y, cam->getPosition().z );
 	mainFont->drawText(4, yPos += strOffset, strBuffer);
 
+	for(int i = 0; i < RenderData::BufferMemory::bmNum; ++i)
+	{
+		RenderData::BufferMemory::Category category = (RenderData::BufferMemory::Category)i;
+		sprintf(strBuffer, "%s: %1.2fMB", RenderData::BufferMemory::GetName(category), RenderData::BufferMemory::Get(category) / (1024.0f * 1024.0f) );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
+
+	//allocators should not touch heap in steady state
+	sprintf(strBuffer, "allocators heap allocs/frame: %d", mFrameHeapAllocationsNum );
+	mainFont->drawText(4, yPos += strOffset, strBuffer);
+	std::vector<Allocator::Stats> allocatorStats;
+	Allocator::GetAllStats(allocatorStats);
+	for(size_t i = 0; i < allocatorStats.size(); ++i)
+	{
+		const Allocator::Stats& stats = allocatorStats[i];
+		sprintf(strBuffer, "%s: %1.2f/%1.2fKB", stats.name, stats.peakBytesUsed / 1024.0f, stats.bytesReserved / 1024.0f );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
+
+	if(loader != NULL)
+	{
+		std::vector<Resource::AsyncLoader::QueueStats> loadingStats;
+		loader->getStats(loadingStats);
+		for(size_t i = 0; i < loadingStats.size(); ++i)
+		{
+			const Resource::AsyncLoader::QueueStats& stats = loadingStats[i];
+			sprintf(strBuffer, "%s loading: %d/%d/%d, loaded: %d, failed: %d", stats.name.c_str(), 
+				stats.queuedNum, stats.parsingNum, stats.parsedNum, stats.loadedNum, stats.failedNum );
+			mainFont->drawText(4, yPos += strOffset, strBuffer);
+		}
+	}
+
+	if(FormatCacheStats(strBuffer, Resource::TextureStorage::Active()))
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	Resource::TextureStreamer * streamer = Resource::TextureStorage::Active() != NULL ? Resource::TextureStorage::Active()->getStreamer() : NULL;
+	if(streamer != NULL)
+	{
+		const Resource::TextureStreamer::Stats& stats = streamer->getStats();
+		sprintf(strBuffer, "streamed textures: %d, resident: %1.1f/%1.1fMB (required %1.1fMB), pending: %d, upgrades: %d, evictions: %d",
+			stats.texturesNum, stats.residentBytes / (1024.0f * 1024.0f), streamer->getMemoryBudget() / (1024.0f * 1024.0f),
+			stats.requiredBytes / (1024.0f * 1024.0f), stats.pendingNum, stats.upgradesNum, stats.evictionsNum );
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	}
+	if(FormatCacheStats(strBuffer, Resource::ModelStorage::Active()))
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+	if(FormatCacheStats(strBuffer, Resource::SoundStorage::Active()))
+		mainFont->drawText(4, yPos += strOffset, strBuffer);
+
+	GUI::TextLayoutCache& layoutCache = GUI::TextLayoutCache::Instance();
+	sprintf(strBuffer, "text layouts: %d/%d, hits: %d, misses: %d, glyphs: %d", (int)layoutCache.getSize(), (int)layoutCache.getCapacity(),
+		layoutCache.getHitsNum(), layoutCache.getMissesNum(), mainFont->getBakedGlyphsNum() );
+	layoutCache.resetStats();
+	mainFont->drawText(4, yPos += strOffset, strBuffer);
+
 	/*
 	sprintf(strBuffer, "texture switches: %d", render->getRenderStatistics().mTextureSwitchesNum );
 	mainFont->drawText(4, yPos += strOffset, strBuffer);
@@ -174,10 +382,6 @@ void Engine::process(World::World * world)
 
 	Render::Utils::End2D();
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeRenderUI);
-
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeOther);
-
 	Input::Get()->update();
 
 	render->setProjection(cam->getFinalMatrix());
@@ -23,6 +23,13 @@ class SQENGINE_API Engine
 {
 	RenderManager * mRenderManager;
 
+	std::string mProfilerTraceFile;//profiler history is saved here on exit if set
+
+	uint64 mHeapAllocationsNum;
+	int mFrameHeapAllocationsNum;//heap allocations of engine allocators during last frame
+
+	float mLoadingBudgetMs;//main thread time given to finishing of asynchronously loaded resources per frame
+
 public:
 	Engine();
 	~Engine();
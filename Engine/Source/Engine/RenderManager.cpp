@@ -7,6 +7,7 @@
 #include <Render/VertexBuffer.h>
 #include <Resource/Mesh.h>
 #include <Common/TimeCounter.h>
+#include <Common/Profiler.h>
 #include <Common/Settings.h>
 
 namespace Squirrel {
@@ -38,6 +39,9 @@ UniformString sUniformReflectionMap		("uReflectionMap");
 UniformString sUniformSceneColorMap		("uSceneColorMap");
 UniformString sUniformSceneDepthMap		("uSceneDepthMap");
 UniformString sUniformClipPlane			("uClipPlane");
+UniformString sUniformPositionScale		("uPositionScale");
+UniformString sUniformPositionBias		("uPositionBias");
+UniformString sUniformTexcoordDecode	("uTexcoordDecode");
 
 World::World * sWorld = NULL;
 
@@ -48,16 +52,19 @@ Resource::Program * programRenderShadowMap = 0;
 	
 Render::ITexture * litRampTexture = 0;
 
-int timeNodeCollectBatches = 0;
-int timeNodeBuildShadows = 0;
-int timeNodeRenderWorld = 0;
-int timeNodeRenderTransparent = 0;
-
 const int MAX_DEBUG_FRUSTUMS_NUM = 2;
 Camera * debugFrustums[MAX_DEBUG_FRUSTUMS_NUM] = { NULL, NULL };
 
 ITexture * debugCubemap = NULL;
 ITexture * debugShadowMap = NULL;
+
+//packed vertex components are dequantized in shaders
+static void SetupPackedVertices(VertexBuffer * vb, IProgram * program)
+{
+	program->uniform(sUniformPositionScale, vb->getPositionScale());
+	program->uniform(sUniformPositionBias, vb->getPositionBias());
+	program->uniform(sUniformTexcoordDecode, vb->getTexcoordDecode());
+}
 	
 RenderManager::RenderManager() { mClearColor = true; };
 RenderManager::~RenderManager() {};
@@ -218,6 +225,7 @@ void RenderManager::init()
 	ib->setIndex(5, 3);
 
 	VertexBuffer * vb = mQuadMesh->createVertexBuffer(VT_PT, 4);
+	vb->setPinned(true);//resized by setQuadSize
 	vb->setComponent<VertexBuffer::vcTexcoord>(0, vec2(0, 0));
 	vb->setComponent<VertexBuffer::vcTexcoord>(1, vec2(0, 1));
 	vb->setComponent<VertexBuffer::vcTexcoord>(2, vec2(1, 1));
@@ -232,12 +240,6 @@ void RenderManager::init()
 	mParallaxSteps	= Settings::Default()->getInt(RENDERING_SETTINGS_SECTION, "ParallaxMappingSteps", 16);
 	mParallaxDistance	= Settings::Default()->getFloat(RENDERING_SETTINGS_SECTION, "ParallaxMappingDistance", 16.0f);
 
-	//init tmp benchmark
-	timeNodeCollectBatches		= TimeCounter::Instance().addNode("  collectBatches");
-	timeNodeBuildShadows		= TimeCounter::Instance().addNode("  buildShadows");
-	timeNodeRenderWorld			= TimeCounter::Instance().addNode("  renderWorld");
-	timeNodeRenderTransparent	= TimeCounter::Instance().addNode("  renderFX");
-
 	mMainPassRenderOptions.layersRange			= tuple2i(0, rqMax);
 	mMainPassRenderOptions.level				= World::rilLighting;
 
@@ -278,7 +280,7 @@ void RenderManager::createShadows(Light * light, World::World * world)
 
 void RenderManager::render(World::World * world)
 {
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeCollectBatches);
+	SQ_PROFILE_ZONE("RenderManager::render");
 
 	if(world == NULL)
 		return;
@@ -291,21 +293,24 @@ void RenderManager::render(World::World * world)
 	if(cam == NULL)
 		return;
 
-	mMainRenderQueue.clear();
-	world->renderRecursively(&mMainRenderQueue, cam, mMainPassRenderOptions);
+	{
+		SQ_PROFILE_ZONE("collectBatches");
+
+		mMainRenderQueue.clear();
+		world->renderRecursively(&mMainRenderQueue, cam, mMainPassRenderOptions);
+	}
 
 	Render::IRender * render = Render::IRender::GetActive();
 
 	render->getRenderStatistics().mBatchesNum = 0;
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeCollectBatches);
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeBuildShadows);
-
 	render->setAlphaTestValue(0.5f);
 
 	if(mEnableShadows)
 	{
-		for(std::list<Light*>::iterator itLight = mMainRenderQueue.getLights().begin();
+		SQ_PROFILE_ZONE("buildShadows");
+
+		for(RenderQueue::LIGHTS_LIST::iterator itLight = mMainRenderQueue.getLights().begin();
 			itLight != mMainRenderQueue.getLights().end(); ++itLight)
 		{
 			if((*itLight)->mShadow)
@@ -313,15 +318,14 @@ void RenderManager::render(World::World * world)
 		}
 	}
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeBuildShadows);
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeRenderWorld);
-
 	render->setAlphaTestValue(0.5f);
 
 	//render reflections
 
 	FOREACH(RenderQueue::REFL_DESCS_SET::iterator, itReflDesc, mMainRenderQueue.getRequiredReflections())
 	{
+		SQ_PROFILE_ZONE("renderReflection");
+
 		Reflection * refl = NULL;
 		REFLECTIONS_MAP::iterator itRefl = mReflections.find(*itReflDesc);
 		if(itRefl == mReflections.end())
@@ -376,6 +380,8 @@ void RenderManager::render(World::World * world)
 	
 	//render final scene
 
+	SQ_PROFILE_ZONE("renderWorld");
+
 	if(mPostFXManager.getSceneFrameBuffer() != NULL)
 		mPostFXManager.getSceneFrameBuffer()->bind();
 	else
@@ -389,18 +395,17 @@ void RenderManager::render(World::World * world)
 
 	//render water
 
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeRenderWorld);
-	TimeCounter::Instance().setNodeTimeBegin(timeNodeRenderTransparent);
+	SQ_PROFILE_ZONE("renderFX");
 
 	world->renderCustomRecursively(render, cam, mMainPassRenderOptions);
 
 	renderPostFX(cam);
-
-	TimeCounter::Instance().setNodeTimeEnd(timeNodeRenderTransparent);
 }
 
 void RenderManager::renderPostFX(Camera * cam)
 {
+	SQ_PROFILE_ZONE("RenderManager::renderPostFX");
+
 	Render::IRender * render = Render::IRender::GetActive();
 
 	float time = TimeCounter::Instance().getTime();
@@ -426,6 +431,8 @@ void RenderManager::renderPostFX(Camera * cam)
 	
 void RenderManager::render(Render::RenderQueue& renderQueue, Camera * cam, const World::RenderInfo& info, int flags)
 {
+	SQ_PROFILE_ZONE("RenderManager::renderQueue");
+
 	Render::IRender * render = Render::IRender::GetActive();
 
 	render->setProjection(cam->getFinalMatrix());
@@ -464,7 +471,7 @@ void RenderManager::render(Render::RenderQueue& renderQueue, Camera * cam, const
 
 	render->setAlphaTestValue(0.5f);
 	
-	for(std::list<Light*>::iterator itLight = renderQueue.getLights().begin();
+	for(RenderQueue::LIGHTS_LIST::iterator itLight = renderQueue.getLights().begin();
 		itLight != renderQueue.getLights().end(); ++itLight)
 	{
 		int lightPassFlags = flags;
@@ -501,25 +508,28 @@ void RenderManager::renderLit(RenderQueue * renderQueue, Light * light, const Wo
 	render->enableDepthWrite(true);
 	render->enablePolygonOffset(false);
 
-	std::stringstream passProgramParams;
+	std::string& passProgramParams = mPassProgramParams;
+	passProgramParams.clear();
 
 	if(info.clipPlane)
 	{
-		passProgramParams << "CLIP;";
+		passProgramParams += "CLIP;";
 	}
 
-	passProgramParams << "LIT_PHONG;";
+	passProgramParams += "LIT_PHONG;";
 
 	if(light->mLightType == Light::ltOmni)
-		passProgramParams << "POINT_LIGHT;";
+		passProgramParams += "POINT_LIGHT;";
 	else if(light->mLightType == Light::ltSpot)
-		passProgramParams << "SPOT_LIGHT;";
+		passProgramParams += "SPOT_LIGHT;";
 	else
-		passProgramParams << "DIR_LIGHT;";
+		passProgramParams += "DIR_LIGHT;";
 
 	if(shadow)
 	{
-		passProgramParams << mShadowsType << ";SHADOW_MAP;" << shadow->getProgramParams();
+		passProgramParams += mShadowsType;
+		passProgramParams += ";SHADOW_MAP;";
+		passProgramParams += shadow->getProgramParams();
 	}
 
 	MaterialGroup *		currentMatGroup			= NULL;
@@ -551,10 +561,10 @@ void RenderManager::renderLit(RenderQueue * renderQueue, Light * light, const Wo
 
 			if(prevMatGroup == NULL || !currentMatGroup->sameProgram(*prevMatGroup))
 			{
-				std::stringstream programParams;
+				std::string& programParams = mProgramParams;
 
-				programParams << passProgramParams.str();
-				programParams << currentMatGroup->mProgramParams.str();
+				programParams.assign(passProgramParams);
+				programParams += currentMatGroup->mProgramParams.str();
 
 				//load program
 
@@ -566,13 +576,13 @@ void RenderManager::renderLit(RenderQueue * renderQueue, Light * light, const Wo
 					Resource::Program * programResource	= programStorage->add(currentMatGroup->mProgramName.str());
 					if(programResource)
 					{
-						program = programResource->getRenderProgram(programParams.str());
+						program = programResource->getRenderProgram(programParams);
 					}
 				}
 
 				if(program == NULL)
 				{
-					program = programBumpy->getRenderProgram(programParams.str());
+					program = programBumpy->getRenderProgram(programParams);
 				}
 
 				programSwitched = true;
@@ -748,6 +758,11 @@ void RenderManager::renderLit(RenderQueue * renderQueue, Light * light, const Wo
 			
 			render->setupVertexBuffer( currentVBGroup->mVB );
 
+			if(currentVBGroup->mVB->isPacked())
+			{
+				SetupPackedVertices(currentVBGroup->mVB, program);
+			}
+
 			if(currentVBGroup->mBonesCount > 0)
 			{
 				program->uniformArray(sUniformBones, currentVBGroup->mBonesCount, currentVBGroup->mBonesData);
@@ -767,13 +782,16 @@ void RenderManager::renderLit(RenderQueue * renderQueue, Light * light, const Wo
 	}
 }
 
-void RenderManager::renderDepthOnly(RenderQueue * renderQueue, const std::string& params)
+void RenderManager::renderDepthOnly(RenderQueue * renderQueue, const std::string& params, bool clearDepth)
 {
+	SQ_PROFILE_ZONE("RenderManager::renderDepthOnly");
+
 	Render::IRender * render = Render::IRender::GetActive();
 
 	render->enableColorWrite(false);
 
-	render->clear(false, true);
+	if(clearDepth)
+		render->clear(false, true);
 
 	render->enableDepthTest();
 	render->enablePolygonOffset(true, 8, 800);
@@ -783,7 +801,7 @@ void RenderManager::renderDepthOnly(RenderQueue * renderQueue, const std::string
 	MaterialGroup *		currentMatGroup			= NULL;
 	VBGroup *			currentVBGroup			= NULL;
 
-	std::string passProgramParams = "TEXTURE_ALPHA;";
+	std::string& programParams = mProgramParams;
 
 	RenderQueue::RENDER_OPS_LIST * renderOps = renderQueue->getRenderOpsList();
 	FOREACH(RenderQueue::RENDER_OPS_LIST::iterator, itRenderOp, (*renderOps))
@@ -799,7 +817,10 @@ void RenderManager::renderDepthOnly(RenderQueue * renderQueue, const std::string
 
 			if(prevMatGroup == NULL || !currentMatGroup->sameProgram(*prevMatGroup))
 			{
-				program = programBuildShadow->getRenderProgram(passProgramParams + currentMatGroup->mProgramParams.str());
+				programParams.assign("TEXTURE_ALPHA;");
+				programParams += currentMatGroup->mProgramParams.str();
+
+				program = programBuildShadow->getRenderProgram(programParams);
 
 				programSwitched = true;
 
@@ -838,6 +859,11 @@ void RenderManager::renderDepthOnly(RenderQueue * renderQueue, const std::string
 
 			render->setupVertexBuffer( currentVBGroup->mVB );
 
+			if(currentVBGroup->mVB->isPacked() && program)
+			{
+				SetupPackedVertices(currentVBGroup->mVB, program);
+			}
+
 			if(currentVBGroup->mBonesCount > 0 && program)
 			{
 				program->uniformArray(sUniformBones, currentVBGroup->mBonesCount, currentVBGroup->mBonesData);
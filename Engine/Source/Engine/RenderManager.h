@@ -59,6 +59,10 @@ private:
 
 	UniformContainer mUniformsPool;
 
+	//program params are composed every program switch, strings are reused to keep their capacity
+	std::string mPassProgramParams;
+	std::string mProgramParams;
+
 public:
 	RenderManager();
 	virtual ~RenderManager();
@@ -74,6 +78,8 @@ public:
 	void setClearColor(bool flag) { mClearColor = flag; }
 	bool getClearColor() { return mClearColor; }
 
+	ShadowsManager * getShadowsManager() { return mShadowsManager.get(); }
+
 private:
 
 	enum RenderLightPassFlags {
@@ -97,7 +103,7 @@ private:
 				   int flags = sDefaultLightPassFlags);
 
 	//implement DepthRenderer
-	void renderDepthOnly(Render::RenderQueue * renderQueue, const std::string& params = "" );
+	void renderDepthOnly(Render::RenderQueue * renderQueue, const std::string& params = "", bool clearDepth = true );
 	const World::RenderInfo& getDepthRenderOptions() { return mDepthRenderOptions; }
 };
 
@@ -15,6 +15,12 @@ UniformString sUniformShadowMaps			("shadowMaps");
 UniformString sUniformShadowOffset			("shadowOffset");
 UniformString sUniformShadowSplitDistances	("shadowSplitDistances");
 
+//gathered volume of casters is grown by this part of its size, so that it is reused while light or view moves a bit
+const float sCastersVolumeGrow = 0.1f;
+
+//window of split camera is grown by this part of size of its receivers, so that it is kept while view moves a bit
+const float sSplitWindowMargin = 0.2f;
+
 mat4 shadowBiasMatrix(	0.5f, 0.0f, 0.0f, 0.5f, 
 						0.0f, 0.5f, 0.0f, 0.5f,
 						0.0f, 0.0f, 0.5f, 0.5f,
@@ -31,6 +37,9 @@ ShadowsManager::ShadowsManager(Settings * settings, const char_t * sectionName)
 	mSpotShadowSize	= settings->getInt(sectionName, "Spot Shadow Size", 1024);
 
 	mShadowSplitsNum = Settings::Default()->getInt(sectionName, "Shadow Splits Num", 3);
+	mSplitUpdatePeriod = settings->getInt(sectionName, "Shadow Split Update Period", 2);
+
+	mCacheStatic = settings->getInt(sectionName, "Cache Static Shadows", 1) != 0;
 
 	mSplitDistances.x	= settings->getFloat(sectionName, "First Split Distance", 32.0f);
 	mSplitDistances.y	= settings->getFloat(sectionName, "Second Split Distance", 128.0f);
@@ -76,6 +85,8 @@ Shadow * ShadowsManager::addShadow(Light * light)
 		dirShadow->setMapSize(mDirShadowSize);
 		dirShadow->setSplitsNum(mShadowSplitsNum);
 		dirShadow->setSplitsDistances(mSplitDistances);
+		dirShadow->setSplitUpdatePeriod(mSplitUpdatePeriod);
+		dirShadow->setCacheStatic(mCacheStatic);
 
 		return dirShadow;
 
@@ -92,6 +103,7 @@ Shadow * ShadowsManager::addShadow(Light * light)
 		mOmniShadows[index].reset(omniShadow);
 
 		omniShadow->setMapSize(mOmniShadowSize);
+		omniShadow->setCacheStatic(mCacheStatic);
 
 		return omniShadow;
 
@@ -108,6 +120,7 @@ Shadow * ShadowsManager::addShadow(Light * light)
 		mSpotShadows[index].reset(spotShadow);
 
 		spotShadow->setMapSize(mSpotShadowSize);
+		spotShadow->setCacheStatic(mCacheStatic);
 
 		return spotShadow;
 	case Light::ltUnknown:
@@ -117,6 +130,17 @@ Shadow * ShadowsManager::addShadow(Light * light)
 	return NULL;
 }
 
+void ShadowsManager::getShadows(std::vector<Shadow *>& shadows)
+{
+	int i = 0;
+	for(i = 0; i < mDirShadowsNum; ++i)
+		shadows.push_back(mDirShadows[i].get());
+	for(i = 0; i < mSpotShadowsNum; ++i)
+		shadows.push_back(mSpotShadows[i].get());
+	for(i = 0; i < mOmniShadowsNum; ++i)
+		shadows.push_back(mOmniShadows[i].get());
+}
+
 Shadow * ShadowsManager::getShadow(Light * light)
 {
 	std::map<Light *, int>::iterator it = mShadowsTable.find(light);
@@ -151,6 +175,81 @@ Shadow * ShadowsManager::getShadow(Light * light)
 	return NULL;
 }
 
+bool attachDepthMap(IFrameBuffer * framebuffer, ITexture * map, int face)
+{
+	return face < 0 ? framebuffer->attachDepthTexture(map) : framebuffer->attachDepthTextureFace(map, face);
+}
+
+void Shadow::renderView(int view, bool due, ITexture * map, int face, Camera * camera, DepthRenderer * renderer, const std::string& params)
+{
+	ShadowCasters::ViewUpdate update = mCasters.updateView(view, camera->getFinalMatrix(), due);
+	if(update == ShadowCasters::vuNone)
+		return;
+
+	IRender * render = IRender::GetActive();
+
+	int drawCallsNum = render->getRenderStatistics().mDrawCallsNum;
+
+	render->setProjection( camera->getFinalMatrix() );
+
+	const World::RenderInfo& info = renderer->getDepthRenderOptions();
+
+	if(!mCacheStatic)
+	{
+		framebuffer->bind();
+		attachDepthMap(framebuffer, map, face);
+
+		mRenderQueue.clear();
+		mCasters.renderView(view, ShadowCasters::lStatic, &mRenderQueue, camera, info);
+		mCasters.renderView(view, ShadowCasters::lDynamic, &mRenderQueue, camera, info);
+
+		renderer->renderDepthOnly(&mRenderQueue, params);
+	}
+	else
+	{
+		if(!mStaticFramebuffer)
+		{
+			mStaticFramebuffer = render->createFrameBuffer(mapSize, mapSize, 0);
+			mStaticFramebuffer->generate();
+			mStaticFramebuffer->create();
+		}
+
+		ITexture *& staticMap = mStaticMaps[face < 0 ? view : 0];
+		if(!staticMap)
+		{
+			staticMap = render->createTexture();
+			staticMap->generate();
+			if(face < 0)
+				staticMap->fill(ITexture::pfDepth32, tuple3i(mapSize, mapSize, 1));
+			else
+				staticMap->fillCube(ITexture::pfDepth32, mapSize);
+		}
+
+		mStaticFramebuffer->bind();
+		attachDepthMap(mStaticFramebuffer, staticMap, face);
+
+		if(update == ShadowCasters::vuAll)
+		{
+			mRenderQueue.clear();
+			mCasters.renderView(view, ShadowCasters::lStatic, &mRenderQueue, camera, info);
+
+			renderer->renderDepthOnly(&mRenderQueue, params);
+		}
+
+		framebuffer->bind();
+		attachDepthMap(framebuffer, map, face);
+
+		mStaticFramebuffer->copyDepthTo(framebuffer);
+
+		mRenderQueue.clear();
+		mCasters.renderView(view, ShadowCasters::lDynamic, &mRenderQueue, camera, info);
+
+		renderer->renderDepthOnly(&mRenderQueue, params, false);
+	}
+
+	mCasters.addDrawCalls(render->getRenderStatistics().mDrawCallsNum - drawCallsNum);
+}
+
 bool SpotShadow::build(World::World * world, DepthRenderer * renderer)
 {
 	IRender * render = IRender::GetActive();
@@ -190,17 +289,28 @@ bool SpotShadow::build(World::World * world, DepthRenderer * renderer)
 	camera->setUp(up);
 	camera->buildProjection(light->mOuterSpotAngle, 1.0f, nearPlane, light->mRadius + nearPlane);
 
-	//render into depth map
+	//casters inside light frustum
 
-	framebuffer->bind();
+	AABB volume;
+	for(int i = 0; i < Camera::FRUSTUM_POINTS; ++i)
+	{
+		volume.addVertex( camera->getPoint(i) );
+	}
 
-	mRenderQueue.clear();
+	mCasters.gather(world, mat4::Identity(), volume, volume.getSize() * sCastersVolumeGrow);
 
-	world->renderRecursively(&mRenderQueue, camera, renderer->getDepthRenderOptions());
+	const ShadowCasters::CASTERS_LIST& candidates = mCasters.getCandidates();
 
-	render->setProjection( camera->getFinalMatrix() );
+	mCasters.setViewsNum(1);
+	for(int i = 0; i < (int)candidates.size(); ++i)
+	{
+		if(camera->isAABBIn(candidates[i].bounds))
+			mCasters.addToView(0, i);
+	}
+
+	//render into depth map
 
-	renderer->renderDepthOnly(&mRenderQueue);
+	renderView(0, true, map, -1, camera, renderer);
 
 	framebuffer->unbind();
 
@@ -271,7 +381,50 @@ bool OmniShadow::build(World::World * world, DepthRenderer * renderer)
 		vec3( 0, 1, 0)
 	};
 
-	framebuffer->bind();
+	//casters inside light radius, binned into faces in one pass
+
+	vec3 lightPos = light->getPosition();
+	float lightRadius = light->mRadius + nearPlane;
+
+	AABB volume;
+	volume.setCenterSize(lightPos, vec3(lightRadius, lightRadius, lightRadius) * 2.0f);
+
+	mCasters.gather(world, mat4::Identity(), volume, volume.getSize() * sCastersVolumeGrow);
+
+	const ShadowCasters::CASTERS_LIST& candidates = mCasters.getCandidates();
+
+	mCasters.setViewsNum(ITexture::cmfNum);
+	for(int i = 0; i < (int)candidates.size(); ++i)
+	{
+		const AABB& bounds = candidates[i].bounds;
+		if((bounds.clampPoint(lightPos) - lightPos).lenSquared() > lightRadius * lightRadius)
+			continue;
+
+		vec3 boundsMin = bounds.min - lightPos;
+		vec3 boundsMax = bounds.max - lightPos;
+
+		for(int face = 0; face < ITexture::cmfNum; ++face)
+		{
+			//face pyramid |side| <= forward contains some point of bounds
+			const vec3& dir = cubeMapCameraDirections[face];
+			int axis = dir.x != 0 ? 0 : (dir.y != 0 ? 1 : 2);
+			float forward = dir[axis] > 0 ? boundsMax[axis] : -boundsMin[axis];
+			if(forward <= 0)
+				continue;
+
+			bool inFace = true;
+			for(int side = 0; side < 3 && inFace; ++side)
+			{
+				if(side != axis)
+					inFace = boundsMin[side] <= forward && boundsMax[side] >= -forward;
+			}
+
+			if(inFace)
+				mCasters.addToView(face, i);
+		}
+	}
+
+	renderer->setEyePos(vec4(light->getPosition(), light->mRadius));
 
 	for(int i = 0; i < ITexture::cmfNum; ++i)
 	{
@@ -279,19 +432,9 @@ bool OmniShadow::build(World::World * world, DepthRenderer * renderer)
 		camera->setUp( cubeMapCameraUpVecs[i] );
 		camera->update();
 
-		framebuffer->attachDepthTextureFace(map, i);
-		framebuffer->isOk();
-
 		//render into depth map
 
-		mRenderQueue.clear();
-		
-		world->renderRecursively(&mRenderQueue, camera, renderer->getDepthRenderOptions());
-
-		render->setProjection( camera->getFinalMatrix() );
-
-		renderer->setEyePos(vec4(light->getPosition(), light->mRadius));
-		renderer->renderDepthOnly(&mRenderQueue, "WRITE_DISTANCE;");
+		renderView(i, true, map, i, camera, renderer, "WRITE_DISTANCE;");
 	}
 
 	framebuffer->unbind();
@@ -310,63 +453,68 @@ void OmniShadow::bind(Render::IProgram * program)
 		map->bind(shadowMapUnit);
 }
 
-void setupShadowCameraForViewCamera(Camera * viewCamera, Camera * shadowCamera, World::World * world, vec3 lightDir)
+//bounds of view frustum clamped by world bounds, in light space
+AABB calcReceiversBounds(Camera * viewCamera, const AABB& worldBounds, const mat4& lightSpace)
 {
-	AABB worldBounds = world->getVisibleBounds();
-
-	vec3 right = lightDir ^ vec3(0,1,0);
-	vec3 up = right ^ lightDir;
-
-	//extract frustum points, clamp them with world bounds and find center of the group of points
-
-	vec3 frustumPoints[Camera::FRUSTUM_POINTS];
-	vec3 center(0, 0, 0);
+	AABB bounds;
 
-	int i;
-
-	for(i = 0; i < Camera::FRUSTUM_POINTS; ++i)
+	for(int i = 0; i < Camera::FRUSTUM_POINTS; ++i)
 	{
-		vec3 pt = viewCamera->getPoint(i);
-
-		pt = worldBounds.clampPoint( pt );
+		vec3 pt = worldBounds.clampPoint( viewCamera->getPoint(i) );
 
-		center += pt;
-
-		frustumPoints[i] = pt;
+		bounds.addVertex( lightSpace * pt );
 	}
 
-	center /= Camera::FRUSTUM_POINTS;
+	return bounds;
+}
 
-	//find bounds of shadow in light space
+//fits window of split camera around given bounds in light space; window is kept while it contains them and is not too large,
+//otherwise new one is grown by margin, its size is rounded and its position is snapped to texels of map,
+//so that shadow edges do not shimmer and cached maps stay valid; returns true if window has changed
+bool fitShadowWindow(AABB& window, const AABB& bounds, int mapSize)
+{
+	vec3 size = bounds.getSize();
+	vec3 windowSize = window.getSize();
+
+	if(window.contains(bounds) &&
+		windowSize.x <= size.x * (1.0f + sSplitWindowMargin * 2.0f) &&
+		windowSize.y <= size.y * (1.0f + sSplitWindowMargin * 2.0f))
+		return false;
 
-	mat4 shadowLookAtMatrix = Camera::CalcLookAtMatrix(vec3::Zero(), -lightDir, up);
+	vec3 margin = size * sSplitWindowMargin;
 
-	AABB shadowVolumeBounds;
+	window.min.z = bounds.min.z - margin.z;
+	window.max.z = bounds.max.z + margin.z;
 
-	for(i = 0; i < Camera::FRUSTUM_POINTS; ++i)
+	for(int axis = 0; axis < 2; ++axis)
 	{
-		vec3 pt = frustumPoints[i];
-
-		pt -= center;
+		float newSize = Math::maxValue(size[axis] + margin[axis], 0.01f);
 
-		pt = shadowLookAtMatrix * pt;
+		//eighths of power of two
+		float step = powf(2.0f, floorf(logf(newSize) / logf(2.0f))) / 8.0f;
+		newSize = ceilf(newSize / step) * step;
 
-		shadowVolumeBounds.addVertex(pt);
+		float texelSize = newSize / mapSize;
+		window.min[axis] = floorf((bounds.min[axis] - margin[axis] * 0.5f) / texelSize) * texelSize;
+		window.max[axis] = window.min[axis] + newSize;
 	}
 
-	//calc camera position
-
-	vec3 shadowCamPos = center - lightDir * shadowVolumeBounds.min.z;
-	
-	//setup shadow camera 
+	return true;
+}
 
+//shadow camera looks at -z of light space and covers given bounds in it
+void setupShadowCamera(Camera * shadowCamera, const AABB& bounds, vec3 lightDir, vec3 up)
+{
 	const float nearPlaneDist = 0.1f;
-	float farPlaneDist = shadowVolumeBounds.max.z - shadowVolumeBounds.min.z + nearPlaneDist;
 
-	shadowCamera->setPosition( shadowCamPos );
+	//light space has no translation, so camera placed on its z axis is at xy origin
+	float cameraZ = bounds.max.z + nearPlaneDist;
+	float farPlaneDist = cameraZ - bounds.min.z;
+
+	shadowCamera->setPosition( lightDir * cameraZ );
 	shadowCamera->setDirection( - lightDir );
 	shadowCamera->setUp(up);
-	shadowCamera->buildProjection(shadowVolumeBounds.min.x, shadowVolumeBounds.max.x, shadowVolumeBounds.min.y, shadowVolumeBounds.max.y, nearPlaneDist, farPlaneDist);
+	shadowCamera->buildProjection(bounds.min.x, bounds.max.x, bounds.min.y, bounds.max.y, nearPlaneDist, farPlaneDist);
 }
 
 bool DirectionalShadow::build(World::World * world, DepthRenderer * renderer)
@@ -381,7 +529,27 @@ bool DirectionalShadow::build(World::World * world, DepthRenderer * renderer)
 
 	vec3 lightDir = light->getDirection().normalized();
 
-	std::auto_ptr<Camera> viewCam(new Camera(*mainCam));
+	vec3 right = lightDir ^ (Math::absValue(lightDir.y) < 0.9f ? vec3(0,1,0) : vec3(1,0,0));
+	vec3 up = right ^ lightDir;
+
+	mat4 lightSpace = Camera::CalcLookAtMatrix(vec3::Zero(), -lightDir, up);
+
+	//windows are fitted again in new light space
+	if(lightSpace != mLightSpace)
+	{
+		mLightSpace = lightSpace;
+		for(int i = 0; i < MAX_SHADOW_SPLITS; ++i)
+		{
+			mSplitWindows[i].reset();
+		}
+	}
+
+	++mFramesNum;
+
+	AABB worldBounds = world->getVisibleBounds();
+
+	//copy of main camera lives on stack, it is rebuilt for every split
+	Camera viewCam(*mainCam);
 
 	if(!framebuffer)
 	{
@@ -391,21 +559,23 @@ bool DirectionalShadow::build(World::World * world, DepthRenderer * renderer)
 		//framebuffer->isOk();
 	}
 
-	framebuffer->bind();
-
-	float viewNearPlane	= viewCam->getNear();
-	float viewFarPlane	= viewCam->getFar();
+	float viewNearPlane	= viewCam.getNear();
+	float viewFarPlane	= viewCam.getFar();
 
 	float nearPlane	= viewNearPlane;
 	float farPlane	= viewFarPlane;
 
 	mPCFOffsets[0] = mPCFOffset / mapSize;
 
-	for(int i = 0; i < splitsNum; ++i)
-	{
-		if(!splitCameras[i])
-			splitCameras[i] = new Render::Camera(Camera::Orthographic);
+	//receivers of splits in light space
+
+	AABB splitBounds[MAX_SHADOW_SPLITS];
+	AABB receiversBounds;
 
+	int i;
+
+	for(i = 0; i < splitsNum; ++i)
+	{
 		float prevProjectionSize = farPlane - nearPlane;
 
 		//calc near plane distance
@@ -427,9 +597,60 @@ bool DirectionalShadow::build(World::World * world, DepthRenderer * renderer)
 		}
 
 		//
-		viewCam->buildProjection(viewCam->getFov(), viewCam->getAspect(), nearPlane, farPlane);
+		viewCam.buildProjection(viewCam.getFov(), viewCam.getAspect(), nearPlane, farPlane);
+
+		splitBounds[i] = calcReceiversBounds(&viewCam, worldBounds, lightSpace);
+		receiversBounds.merge(splitBounds[i]);
+	}
+
+	//casters may be anywhere between light and receivers
+
+	AABB volume = receiversBounds;
+	volume.max.z = MAX_COORD;
+
+	vec3 volumeGrow = receiversBounds.getSize() * sCastersVolumeGrow;
+	volumeGrow.z = 0;
+
+	mCasters.gather(world, lightSpace, volume, volumeGrow);
+
+	//bin casters into splits in one pass, camera of split is pulled towards light to keep its casters
+
+	const ShadowCasters::CASTERS_LIST& candidates = mCasters.getCandidates();
+
+	float castersTop[MAX_SHADOW_SPLITS];
+	for(i = 0; i < splitsNum; ++i)
+	{
+		castersTop[i] = splitBounds[i].max.z;
+	}
 
-		setupShadowCameraForViewCamera(viewCam.get(), splitCameras[i], world, lightDir);
+	mCasters.setViewsNum(splitsNum);
+	for(int c = 0; c < (int)candidates.size(); ++c)
+	{
+		const AABB& bounds = candidates[c].bounds;
+		for(i = 0; i < splitsNum; ++i)
+		{
+			const AABB& receivers = splitBounds[i];
+			if(bounds.max.x < receivers.min.x || bounds.min.x > receivers.max.x ||
+				bounds.max.y < receivers.min.y || bounds.min.y > receivers.max.y ||
+				bounds.max.z < receivers.min.z)
+				continue;
+
+			mCasters.addToView(i, c);
+			castersTop[i] = Math::maxValue(castersTop[i], bounds.max.z);
+		}
+	}
+
+	for(i = 0; i < splitsNum; ++i)
+	{
+		if(!splitCameras[i])
+			splitCameras[i] = new Render::Camera(Camera::Orthographic);
+
+		AABB cameraBounds = splitBounds[i];
+		cameraBounds.max.z = castersTop[i];
+
+		fitShadowWindow(mSplitWindows[i], cameraBounds, mapSize);
+
+		setupShadowCamera(splitCameras[i], mSplitWindows[i], lightDir, up);
 
 		if(!splitMaps[i])
 		{
@@ -438,16 +659,11 @@ bool DirectionalShadow::build(World::World * world, DepthRenderer * renderer)
 			splitMaps[i]->fill(ITexture::pfDepth32, tuple3i(mapSize, mapSize, 1));
 			splitMaps[i]->enableShadow(true);
 		}
-	
-		framebuffer->attachDepthTexture(splitMaps[i]);
-		
-		mRenderQueue.clear();
-
-		world->renderRecursively(&mRenderQueue, splitCameras[i], renderer->getDepthRenderOptions());
 
-		render->setProjection( splitCameras[i]->getFinalMatrix() );
+		//first split is updated every frame, others are spread over frames of update period
+		bool due = i == 0 || mFramesNum % mSplitUpdatePeriod == (i - 1) % mSplitUpdatePeriod;
 
-		renderer->renderDepthOnly(&mRenderQueue);
+		renderView(i, due, splitMaps[i], -1, splitCameras[i], renderer);
 	}
 
 	framebuffer->unbind();
@@ -8,6 +8,7 @@
 #include <Render/Camera.h>
 #include <Resource/Program.h>
 #include <Common/Settings.h>
+#include "ShadowCasters.h"
 #include "macros.h"
 
 namespace Squirrel {
@@ -21,7 +22,8 @@ public:
 	virtual ~DepthRenderer() {}
 
 	void setEyePos(vec4 eyePos) { mEyePos = eyePos; }
-	virtual void renderDepthOnly(Render::RenderQueue * renderQueue, const std::string& params = "" ) = 0;
+	//depth is not cleared when it is composited over cached layer
+	virtual void renderDepthOnly(Render::RenderQueue * renderQueue, const std::string& params = "", bool clearDepth = true ) = 0;
 
 	virtual const World::RenderInfo& getDepthRenderOptions() = 0;
 	
@@ -44,6 +46,8 @@ public:
 	Shadow * getShadow(Render::Light * light);
 	Shadow * addShadow(Render::Light * light);
 
+	void getShadows(std::vector<Shadow *>& shadows);
+
 private:
 
 	std::map<Render::Light *, int> mShadowsTable;
@@ -61,6 +65,9 @@ private:
 	int mSpotShadowSize;
 
 	int mShadowSplitsNum;
+	int mSplitUpdatePeriod;
+
+	bool mCacheStatic;
 
 	float mPCFOffset;
 
@@ -70,9 +77,17 @@ private:
 class Shadow
 {
 public:
-	Shadow(): light(NULL), framebuffer(NULL), mapSize(256), mPCFOffset(2.0f) {}
+	Shadow(): light(NULL), framebuffer(NULL), mapSize(256), mPCFOffset(2.0f), mCacheStatic(true), mStaticFramebuffer(NULL)
+	{
+		memset(mStaticMaps, 0, sizeof(void *) * ShadowCasters::MAX_VIEWS);
+	}
 	virtual ~Shadow() { 		
 		DELETE_PTR(framebuffer);
+		DELETE_PTR(mStaticFramebuffer);
+		for(int i = 0; i < ShadowCasters::MAX_VIEWS; ++i)
+		{
+			DELETE_PTR(mStaticMaps[i]);
+		}
 	}
 
 	virtual bool build(World::World * world, DepthRenderer * renderer) = 0; 
@@ -81,8 +96,21 @@ public:
 	void setMapSize(int mapSize_) { mapSize = mapSize_; }
 	void setLight(Render::Light * light_) { light = light_; }
 
+	//static casters are rendered into maps of their own, which are copied into shadow maps
+	void setCacheStatic(bool cacheStatic) { mCacheStatic = cacheStatic; }
+
+	Render::Light * getLight() const { return light; }
+
 	const std::string& getProgramParams() const { return mProgramParams; }
 
+	const ShadowCasters::Stats& getCasterStats() const { return mCasters.getStats(); }
+
+protected:
+
+	//updates map of view as decided by casters, update of view which is not due is deferred while its camera is unchanged;
+	//face is of cube map or -1, static layers of cube map faces are cached in faces of one cube map
+	void renderView(int view, bool due, Render::ITexture * map, int face, Render::Camera * camera, DepthRenderer * renderer, const std::string& params = "");
+
 protected:
 	Render::Light			* light;
 	Render::IFrameBuffer	* framebuffer;
@@ -92,6 +120,12 @@ protected:
 	std::string mProgramParams;
 
 	Render::RenderQueue mRenderQueue;
+
+	ShadowCasters mCasters;
+
+	bool					  mCacheStatic;
+	Render::IFrameBuffer	* mStaticFramebuffer;
+	Render::ITexture		* mStaticMaps[ShadowCasters::MAX_VIEWS];
 };
 
 class OneMapShadow: 
@@ -140,7 +174,7 @@ public:
 	static const int MAX_SHADOW_SPLITS	= 4;
 
 public:
-	DirectionalShadow(): splitsNum(1)
+	DirectionalShadow(): splitsNum(1), mSplitUpdatePeriod(1), mFramesNum(0), mLightSpace(mat4::Identity())
 	{
 		memset(splitCameras, 0, sizeof(void *) * MAX_SHADOW_SPLITS);
 		memset(splitMaps, 0, sizeof(void *) * MAX_SHADOW_SPLITS);
@@ -162,11 +196,22 @@ public:
 	void setSplitsDistances(vec3 splitDistances_) {
 		splitDistances = splitDistances_;
 	}
+	//splits after first one are updated every this number of frames, one by one
+	void setSplitUpdatePeriod(int splitUpdatePeriod) {
+		mSplitUpdatePeriod = Math::maxValue(splitUpdatePeriod, 1);
+	}
 
 protected:
 
 	int						splitsNum;
 
+	int						mSplitUpdatePeriod;
+	int						mFramesNum;
+
+	//light space and projected bounds of split cameras in it
+	mat4					mLightSpace;
+	AABB					mSplitWindows[MAX_SHADOW_SPLITS];
+
 	vec3					splitDistances;
 
 	vec4					mPCFOffsets;
@@ -0,0 +1,250 @@
+#include "ShadowCasters.h"
+#include <Common/Profiler.h>
+#include <algorithm>
+#include <string.h>
+
+namespace Squirrel {
+namespace Engine {
+
+using World::SceneObject;
+
+namespace {
+
+//bounds of box transformed by affine matrix, cheaper than transforming its corners
+AABB TransformBounds(const AABB& bounds, const mat4& space)
+{
+	vec3 center = (bounds.max + bounds.min) * 0.5f;
+	vec3 extent = (bounds.max - bounds.min) * 0.5f;
+
+	vec3 newCenter, newExtent;
+	for(int i = 0; i < 3; ++i)
+	{
+		const vec4& row = space[i];
+		newCenter[i] = row.x * center.x + row.y * center.y + row.z * center.z + row.w;
+		newExtent[i] = Math::absValue(row.x) * extent.x + Math::absValue(row.y) * extent.y + Math::absValue(row.z) * extent.z;
+	}
+
+	return AABB(newCenter + newExtent, newCenter - newExtent);
+}
+
+}//namespace {
+
+ShadowCasters::ShadowCasters():
+	mValid(false), mWorld(NULL), mTopologyRevision(0), mTransformFrame(0)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+bool ShadowCasters::isCached(World::World * world, const mat4& space, const AABB& volume)
+{
+	if(!mValid || mWorld != world || mSpace != space || !mVolume.contains(volume))
+		return false;
+
+	if(world->getTransforms()->getTopologyRevision() != mTopologyRevision)
+		return false;
+
+	uint32 transformFrame = world->getTransformFrame();
+	if(transformFrame == mTransformFrame)
+		return true;
+
+	//moves of skipped frames are not known
+	if(transformFrame != mTransformFrame + 1)
+		return false;
+
+	const std::vector<SceneObject *>& movedRoots = world->getMovedRoots();
+	for(size_t i = 0; i < movedRoots.size(); ++i)
+	{
+		SceneObject * root = movedRoots[i];
+
+		//moved out of volume or within it
+		if(std::binary_search(mRoots.begin(), mRoots.end(), root))
+			return false;
+
+		//moved into volume
+		if(TransformBounds(root->getAllAABB(), mSpace).intersects(mVolume))
+			return false;
+	}
+
+	mTransformFrame = transformFrame;
+
+	return true;
+}
+
+void ShadowCasters::gatherRecursively(const World::SceneObjectsContainer::SCENE_OBJECTS_LIST& objects, SceneObject * root)
+{
+	for(World::SceneObjectsContainer::SCENE_OBJECTS_LIST::const_iterator it = objects.begin(); it != objects.end(); ++it)
+	{
+		SceneObject * obj = *it;
+
+		SceneObject * objRoot = root != NULL ? root : obj;
+
+		//children are inside bounds of subtree
+		AABB allBounds = TransformBounds(obj->getAllAABB(), mSpace);
+		if(!allBounds.intersects(mVolume))
+			continue;
+
+		const World::SceneObjectsContainer::SCENE_OBJECTS_LIST& children = obj->getSceneObjects();
+
+		if(obj->isEnabled())
+		{
+			AABB bounds = children.empty() ? allBounds : TransformBounds(obj->getAABB(), mSpace);
+			if(bounds.intersects(mVolume))
+			{
+				Caster caster = { obj, objRoot, bounds };
+				mCandidates.push_back(caster);
+			}
+		}
+
+		if(!children.empty())
+			gatherRecursively(children, objRoot);
+	}
+}
+
+bool ShadowCasters::gather(World::World * world, const mat4& space, const AABB& volume, const vec3& grow)
+{
+	++mStats.framesNum;
+
+	if(isCached(world, space, volume))
+	{
+		++mStats.cachedFramesNum;
+		return false;
+	}
+
+	SQ_PROFILE_ZONE("ShadowCasters::gather");
+
+	mWorld				= world;
+	mSpace				= space;
+	mVolume				= volume;
+	mVolume.grow(grow);
+	mTopologyRevision	= world->getTransforms()->getTopologyRevision();
+	mTransformFrame		= world->getTransformFrame();
+	mValid				= true;
+
+	mCandidates.clear();
+	gatherRecursively(world->getSceneObjects(), NULL);
+
+	mRoots.resize(mCandidates.size());
+	for(size_t i = 0; i < mCandidates.size(); ++i)
+	{
+		mRoots[i] = mCandidates[i].root;
+	}
+	std::sort(mRoots.begin(), mRoots.end());
+	mRoots.erase(std::unique(mRoots.begin(), mRoots.end()), mRoots.end());
+
+	mStats.candidatesNum = (int)mCandidates.size();
+
+	return true;
+}
+
+void ShadowCasters::setViewsNum(int viewsNum)
+{
+	ASSERT(viewsNum <= MAX_VIEWS);
+
+	for(int i = 0; i < MAX_VIEWS; ++i)
+	{
+		mViews[lStatic][i].clear();
+		mViews[lDynamic][i].clear();
+	}
+
+	mStats.viewsNum				= viewsNum;
+	mStats.castersNum			= 0;
+	mStats.dynamicCastersNum	= 0;
+	mStats.updatedViewsNum		= 0;
+	mStats.staticViewsNum		= 0;
+	mStats.deferredViewsNum		= 0;
+	mStats.drawCallsNum			= 0;
+}
+
+bool ShadowCasters::isDynamic(const Caster& caster) const
+{
+	if(caster.object->getAnimations() != NULL)
+		return true;
+
+	return mWorld->getTransformFrame() - caster.root->getMovedFrame() < STATIC_FRAMES;
+}
+
+void ShadowCasters::addToView(int view, int candidate)
+{
+	++mStats.castersNum;
+
+	if(isDynamic(mCandidates[candidate]))
+	{
+		mViews[lDynamic][view].push_back(candidate);
+		++mStats.dynamicCastersNum;
+	}
+	else
+	{
+		mViews[lStatic][view].push_back(candidate);
+	}
+}
+
+ShadowCasters::ViewUpdate ShadowCasters::updateView(int view, const mat4& cameraMatrix, bool due)
+{
+	ViewState& state = mViewStates[view];
+
+	bool cameraChanged = !state.valid || state.cameraMatrix != cameraMatrix;
+	if(!due && !cameraChanged)
+	{
+		++mStats.deferredViewsNum;
+		return vuNone;
+	}
+
+	//objects which stopped moving or were disabled change static layer too
+	const INDICES_LIST& staticIndices = mViews[lStatic][view];
+	mStaticObjects.clear();
+	for(size_t i = 0; i < staticIndices.size(); ++i)
+	{
+		SceneObject * obj = mCandidates[staticIndices[i]].object;
+		if(obj->isEnabled())
+			mStaticObjects.push_back(obj);
+	}
+	std::sort(mStaticObjects.begin(), mStaticObjects.end());
+
+	//terrain is in static layer too, its tiles are reloaded when it is recentered or edited
+	World::Terrain * terrain = mWorld->getTerrain();
+	uint32 terrainRevision = terrain != NULL ? terrain->getRevision() : 0;
+
+	int dynamicNum = (int)mViews[lDynamic][view].size();
+
+	if(cameraChanged || mStaticObjects != state.staticObjects ||
+		terrain != state.terrain || terrainRevision != state.terrainRevision)
+	{
+		state.valid				= true;
+		state.cameraMatrix		= cameraMatrix;
+		state.terrain			= terrain;
+		state.terrainRevision	= terrainRevision;
+		state.dynamicNum		= dynamicNum;
+		state.staticObjects.swap(mStaticObjects);
+
+		++mStats.updatedViewsNum;
+		++mStats.staticViewsNum;
+		return vuAll;
+	}
+
+	//map of static layer alone is already there
+	if(dynamicNum == 0 && state.dynamicNum == 0)
+		return vuNone;
+
+	state.dynamicNum = dynamicNum;
+
+	++mStats.updatedViewsNum;
+	return vuDynamic;
+}
+
+void ShadowCasters::renderView(int view, Layer layer, Render::RenderQueue * renderQueue, Render::Camera * camera, const World::RenderInfo& info)
+{
+	const INDICES_LIST& indices = mViews[layer][view];
+	for(size_t i = 0; i < indices.size(); ++i)
+	{
+		mCandidates[indices[i]].object->renderUnculled(renderQueue, camera, info);
+	}
+
+	//terrain culls its patches on its own
+	if(layer == lStatic && mWorld != NULL && mWorld->getTerrain() != NULL)
+	{
+		mWorld->getTerrain()->render(renderQueue, camera, info);
+	}
+}
+
+}//namespace Engine {
+}//namespace Squirrel {
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <World/World.h>
+#include <World/SceneObject.h>
+#include <Render/RenderQueue.h>
+#include <Render/Camera.h>
+#include <vector>
+#include "macros.h"
+
+namespace Squirrel {
+namespace Engine {
+
+//Shadow casters of one light, gathered by one world traversal and binned into views of its shadow (splits, cube faces).
+//Objects which bounds overlap culling volume of light are gathered into candidates list, which is reused in next frames
+//while volume stays inside the gathered one and no objects were moved into it, out of it, added or removed.
+//Casters of view are split into static and dynamic layers, static one is rendered again only when it, terrain or camera of view changes.
+class SQENGINE_API ShadowCasters
+{
+public:
+	static const int MAX_VIEWS = 6;
+
+	//caster is static if its root has not moved for this number of transform frames and it is not animated
+	static const uint32 STATIC_FRAMES = 30;
+
+	enum Layer
+	{
+		lStatic = 0,
+		lDynamic,
+		lNum
+	};
+
+	enum ViewUpdate
+	{
+		vuNone = 0,//map of view is up to date or its update is deferred
+		vuDynamic,//cached static layer is copied to map, dynamic casters are rendered over it
+		vuAll//static layer is rendered again
+	};
+
+	struct Caster
+	{
+		World::SceneObject *	object;
+		World::SceneObject *	root;
+		AABB					bounds;//in culling space
+	};
+
+	struct Stats
+	{
+		int		viewsNum;
+		int		candidatesNum;
+		int		castersNum;//binned into views, object rendered into several views is counted several times
+		int		framesNum;
+		int		cachedFramesNum;//reused candidates
+
+		//of last frame
+		int		dynamicCastersNum;
+		int		updatedViewsNum;
+		int		staticViewsNum;//static layer rendered again
+		int		deferredViewsNum;//not due and camera is unchanged
+		int		drawCallsNum;//of depth passes
+	};
+
+	typedef std::vector<Caster>	CASTERS_LIST;
+	typedef std::vector<int>	INDICES_LIST;
+
+private:
+	ShadowCasters(const ShadowCasters&);
+	const ShadowCasters& operator=(const ShadowCasters&);
+
+public:
+	ShadowCasters();
+
+	//space transforms world bounds of objects into space of volume,
+	//volume is gathered grown by given delta, so that it stays cached while it moves a bit (e.g. with camera);
+	//returns false if candidates were reused
+	bool gather(World::World * world, const mat4& space, const AABB& volume, const vec3& grow);
+	void invalidate() { mValid = false; }
+
+	const CASTERS_LIST& getCandidates() const { return mCandidates; }
+
+	//clears views
+	void setViewsNum(int viewsNum);
+	void addToView(int view, int candidate);
+	const INDICES_LIST& getView(int view, Layer layer) const { return mViews[layer][view]; }
+
+	//decides how map of view is updated, camera matrix is final matrix of its camera;
+	//update of view which is not due is deferred while its camera stays the same
+	ViewUpdate updateView(int view, const mat4& cameraMatrix, bool due);
+
+	//terrain is rendered into static layer
+	void renderView(int view, Layer layer, Render::RenderQueue * renderQueue, Render::Camera * camera, const World::RenderInfo& info);
+
+	void addDrawCalls(int drawCallsNum) { mStats.drawCallsNum += drawCallsNum; }
+
+	const Stats& getStats() const { return mStats; }
+
+private:
+
+	struct ViewState
+	{
+		ViewState(): valid(false), terrain(NULL), terrainRevision(0), dynamicNum(0) {}
+
+		bool								valid;
+		mat4								cameraMatrix;
+		std::vector<World::SceneObject *>	staticObjects;//sorted
+		World::Terrain *					terrain;
+		uint32								terrainRevision;
+		int									dynamicNum;
+	};
+
+	bool isCached(World::World * world, const mat4& space, const AABB& volume);
+	bool isDynamic(const Caster& caster) const;
+	void gatherRecursively(const World::SceneObjectsContainer::SCENE_OBJECTS_LIST& objects, World::SceneObject * root);
+
+private:
+
+	CASTERS_LIST	mCandidates;
+	std::vector<World::SceneObject *>	mRoots;//of candidates, sorted
+
+	INDICES_LIST	mViews[lNum][MAX_VIEWS];
+	ViewState		mViewStates[MAX_VIEWS];//of last update
+
+	std::vector<World::SceneObject *>	mStaticObjects;//temporary
+
+	//gathered state
+	bool			mValid;
+	World::World *	mWorld;
+	mat4			mSpace;
+	AABB			mVolume;
+	uint32			mTopologyRevision;
+	uint32			mTransformFrame;
+
+	Stats			mStats;
+};
+
+}//namespace Engine {
+}//namespace Squirrel {
@@ -192,6 +192,14 @@ bool DocumentImporter::importScene(FbxScene * scene)
             importNode(fbxRootNode->GetChild(i), NULL);
     }
 
+	Resource::MeshProcessing::OptimizationParams optimizationParams;
+	optimizationParams.readSettings("MeshOptimization");
+	mModel->optimizeMeshes(optimizationParams);
+
+	Resource::MeshProcessing::PackingParams packingParams;
+	packingParams.readSettings("VertexPacking");
+	mModel->packVertices(packingParams);
+
 	return true;
 }
 
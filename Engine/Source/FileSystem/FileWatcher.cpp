@@ -0,0 +1,268 @@
+#include "FileWatcher.h"
+#include "FileStorage.h"
+#include "Folder.h"
+#include "Path.h"
+#include <Common/Log.h>
+#include <Common/Profiler.h>
+#include <chrono>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#	include <sys/inotify.h>
+#	include <poll.h>
+#	include <dirent.h>
+#	include <unistd.h>
+#endif
+
+namespace Squirrel {
+
+namespace FileSystem {
+
+namespace {
+
+std::string MakeRelativePath(const std::string& folder, const std::string& name)
+{
+	std::string path = folder.empty() ? name : folder + "/" + name;
+	for(size_t i = 0; i < path.length(); ++i)
+	{
+		if(path[i] == '\\')
+			path[i] = '/';
+	}
+	return path;
+}
+
+bool IsFolder(const std::string& path)
+{
+#ifdef _WIN32
+	struct _stat buf;
+	return _stat(path.c_str(), &buf) == 0 && (buf.st_mode & _S_IFDIR) != 0;
+#else
+	struct stat buf;
+	return stat(path.c_str(), &buf) == 0 && S_ISDIR(buf.st_mode);
+#endif
+}
+
+}//namespace {
+
+const uint32 FileWatcher::DEFAULT_POLL_PERIOD_MS;
+
+FileWatcher::FileWatcher(const std::string& folder, uint32 pollPeriodMs):
+	mFolder(folder), mPollPeriodMs(pollPeriodMs), mWatching(false), mQuit(false), mHasChanges(false)
+{
+#ifdef __linux__
+	mINotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(mINotify < 0)
+	{
+		Log::Instance().streamError("FileWatcher::FileWatcher") << "Failed to init inotify for " << mFolder.c_str();
+		return;
+	}
+
+	//subfolders are watched as well, watches of new ones are added by watching thread
+	mWatching = addWatches("");
+#else
+	mWatching = IsFolder(mFolder);
+#endif
+
+	if(mWatching)
+	{
+		mThread = std::thread(&FileWatcher::watchLoop, this);
+	}
+}
+
+FileWatcher::~FileWatcher()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mQuitWake.notify_all();
+
+	if(mThread.joinable())
+	{
+		mThread.join();
+	}
+
+#ifdef __linux__
+	if(mINotify >= 0)
+	{
+		close(mINotify);
+	}
+#endif
+}
+
+void FileWatcher::takeChanges(std::vector<std::string>& outChanges)
+{
+	if(!mHasChanges)
+		return;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	outChanges.insert(outChanges.end(), mChanges.begin(), mChanges.end());
+	mChanges.clear();
+	mHasChanges = false;
+}
+
+void FileWatcher::addChange(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	mChanges.insert(path);
+	mHasChanges = true;
+}
+
+#ifdef __linux__
+
+bool FileWatcher::addWatches(const std::string& relativeFolder)
+{
+	std::string folder = relativeFolder.empty() ? mFolder : Path::Combine(mFolder, relativeFolder);
+
+	//editors usually write files in place or move written temporary files over old ones
+	int watch = inotify_add_watch(mINotify, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+	if(watch < 0)
+		return false;
+
+	mWatches[watch] = relativeFolder;
+
+	DIR * dir = opendir(folder.c_str());
+	if(dir == NULL)
+		return true;
+
+	while(dirent * entry = readdir(dir))
+	{
+		if(entry->d_name[0] == '.')
+			continue;
+
+		bool isFolder = entry->d_type == DT_DIR;
+		if(entry->d_type == DT_UNKNOWN)
+		{
+			isFolder = IsFolder(Path::Combine(folder, entry->d_name));
+		}
+
+		if(isFolder)
+		{
+			addWatches(MakeRelativePath(relativeFolder, entry->d_name));
+		}
+	}
+
+	closedir(dir);
+
+	return true;
+}
+
+void FileWatcher::watchLoop()
+{
+	Profiler::SetThreadName("File watching");
+
+	const size_t BUFFER_SIZE = 4096;
+	char buffer[BUFFER_SIZE] __attribute__ ((aligned(__alignof__(inotify_event))));
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			if(mQuit)
+				break;
+		}
+
+		//wake up every period to check whether watcher is destroyed
+		pollfd fd = { mINotify, POLLIN, 0 };
+		if(poll(&fd, 1, (int)mPollPeriodMs) <= 0)
+			continue;
+
+		ssize_t length = read(mINotify, buffer, BUFFER_SIZE);
+		for(ssize_t offset = 0; offset < length; )
+		{
+			const inotify_event * event = (const inotify_event *)(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			std::map<int, std::string>::iterator it = mWatches.find(event->wd);
+			if(it == mWatches.end() || event->len == 0 || event->name[0] == '.')
+				continue;
+
+			std::string path = MakeRelativePath(it->second, event->name);
+
+			if(event->mask & IN_ISDIR)
+			{
+				if(event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					addWatches(path);
+				}
+			}
+			else if(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+			{
+				addChange(path);
+			}
+		}
+	}
+}
+
+#else
+
+bool FileWatcher::waitPollPeriod()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	if(!mQuit)
+	{
+		mQuitWake.wait_for(lock, std::chrono::milliseconds(mPollPeriodMs));
+	}
+
+	return !mQuit;
+}
+
+void FileWatcher::scan(const std::string& relativeFolder, std::map<std::string, time_t>& outTimestamps)
+{
+	Folder folder(mFolder);
+
+	//content of folder is valid till next call
+	std::list<FileInfo> content = folder.getContent(relativeFolder.empty() ? NULL : relativeFolder.c_str());
+
+	for(std::list<FileInfo>::const_iterator it = content.begin(); it != content.end(); ++it)
+	{
+		if(it->name.empty() || it->name[0] == '.')
+			continue;
+
+		std::string path = MakeRelativePath(relativeFolder, it->name);
+
+		if(it->isFolder)
+		{
+			scan(path, outTimestamps);
+		}
+		else
+		{
+			outTimestamps[path] = FileStorage::GetFileModificationTime(it->absPath.c_str());
+		}
+	}
+}
+
+void FileWatcher::watchLoop()
+{
+	Profiler::SetThreadName("File watching");
+
+	std::map<std::string, time_t> timestamps;
+	scan("", timestamps);
+
+	while(waitPollPeriod())
+	{
+		std::map<std::string, time_t> newTimestamps;
+		scan("", newTimestamps);
+
+		for(std::map<std::string, time_t>::const_iterator it = newTimestamps.begin(); it != newTimestamps.end(); ++it)
+		{
+			std::map<std::string, time_t>::const_iterator itOld = timestamps.find(it->first);
+			if(itOld == timestamps.end() || itOld->second != it->second)
+			{
+				addChange(it->first);
+			}
+		}
+
+		timestamps.swap(newTimestamps);
+	}
+}
+
+#endif
+
+}//namespace FileSystem {
+
+}//namespace Squirrel {
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <Common/types.h>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "macros.h"
+
+namespace Squirrel {
+
+namespace FileSystem {
+
+//Watches folder tree for written files on dedicated thread: inotify on Linux,
+//comparison of modification times every poll period on other platforms.
+//Changed files are collected (each once) till taken by takeChanges.
+class SQFILESYSTEM_API FileWatcher
+{
+public:
+
+	static const uint32 DEFAULT_POLL_PERIOD_MS = 500;
+
+	FileWatcher(const std::string& folder, uint32 pollPeriodMs = DEFAULT_POLL_PERIOD_MS);
+	~FileWatcher();
+
+	//false if folder does not exist (e.g. content is packed) or platform failed to watch it
+	bool isWatching() const { return mWatching; }
+
+	const std::string& getFolder() const { return mFolder; }
+
+	//paths relative to watched folder with '/' separators, cheap when nothing has changed
+	void takeChanges(std::vector<std::string>& outChanges);
+
+private:
+
+	void watchLoop();
+
+	void addChange(const std::string& path);
+
+#ifdef __linux__
+	bool addWatches(const std::string& relativeFolder);
+#else
+	//returns false when watcher is destroyed
+	bool waitPollPeriod();
+
+	void scan(const std::string& relativeFolder, std::map<std::string, time_t>& outTimestamps);
+#endif
+
+private:
+
+	std::string					mFolder;
+	uint32						mPollPeriodMs;
+	bool						mWatching;
+
+	std::thread					mThread;
+	std::mutex					mMutex;
+	std::condition_variable		mQuitWake;
+	bool						mQuit;
+
+	std::set<std::string>		mChanges;
+	std::atomic<bool>			mHasChanges;//checked without lock by takeChanges
+
+#ifdef __linux__
+	int							mINotify;
+	std::map<int, std::string>	mWatches;//watch descriptor - relative folder
+#endif
+};
+
+}//namespace FileSystem {
+
+}//namespace Squirrel {
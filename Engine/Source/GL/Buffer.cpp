@@ -5,6 +5,7 @@
 #include "Buffer.h"
 #include "common/macros.h"
 #include "Utils.h"
+#include <Render/BufferMemory.h>
 #include <map>
 
 namespace Squirrel {
@@ -22,6 +23,9 @@ Buffer::Buffer(uint bufferType): mBufferType(bufferType)
 	mBufferId = 0;
 	mCreated = false;
 	mMapped = NULL;
+	mSize = 0;
+	mMemoryCategory = -1;
+	mDirtyBegin = mDirtyEnd = 0;
 }
 
 Buffer::~Buffer()
@@ -47,6 +51,12 @@ void Buffer :: destroy()
 		glDeleteBuffers(1, &mBufferId);
 		mBufferId = 0;
 	}
+
+	if(mMemoryCategory >= 0)
+	{
+		RenderData::BufferMemory::Add((RenderData::BufferMemory::Category)mMemoryCategory, -(int64)mSize);
+		mMemoryCategory = -1;
+	}
 }
 
 bool	Buffer :: create (uint bufferSize, void * bufferData, bool dynamic)
@@ -65,6 +75,15 @@ bool	Buffer :: create (uint bufferSize, void * bufferData, bool dynamic)
 	if( bufferSizeTest < (int)bufferSize )
 		success = false;
 
+	mSize = bufferSize;
+	mDirtyBegin = mDirtyEnd = 0;
+
+	if(mBufferType == GL_ARRAY_BUFFER)
+		mMemoryCategory = dynamic ? RenderData::BufferMemory::bmGPUDynamicVertices : RenderData::BufferMemory::bmGPUStaticVertices;
+	else
+		mMemoryCategory = dynamic ? RenderData::BufferMemory::bmGPUDynamicIndices : RenderData::BufferMemory::bmGPUStaticIndices;
+	RenderData::BufferMemory::Add((RenderData::BufferMemory::Category)mMemoryCategory, mSize);
+
 	//unbind();
 
 	return success;
@@ -120,6 +139,37 @@ void Buffer :: updateBuffer(int offset, int size, void * data)
 	glBufferSubData(mBufferType, offset, size, data);
 }
 
+void Buffer :: markDirty(int offset, int size)
+{
+	if(size <= 0)
+		return;
+
+	if(!isDirty())
+	{
+		mDirtyBegin	= offset;
+		mDirtyEnd	= offset + size;
+	}
+	else
+	{
+		if(offset < mDirtyBegin)
+			mDirtyBegin = offset;
+		if(offset + size > mDirtyEnd)
+			mDirtyEnd = offset + size;
+	}
+}
+
+void Buffer :: flushDirty(byte * data)
+{
+	if(!isDirty())
+		return;
+
+	if(data != NULL)
+	{
+		updateBuffer(mDirtyBegin, mDirtyEnd - mDirtyBegin, data + mDirtyBegin);
+	}
+	mDirtyBegin = mDirtyEnd = 0;
+}
+
 void Buffer :: Unbind (uint bufferType)
 {
 	std::map<uint, Buffer *>::iterator it = sBoundBuffers.find(bufferType);
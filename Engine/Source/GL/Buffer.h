@@ -22,6 +22,13 @@ class SQOPENGL_API Buffer:
 	uint	mBufferId;					// id of buffer object
 	bool	mCreated;
 	void *	mMapped;
+
+	uint	mSize;
+	int		mMemoryCategory;//BufferMemory category of GPU storage
+
+	//range of buffer changed on CPU and not uploaded yet
+	int		mDirtyBegin;
+	int		mDirtyEnd;
 	
 public:
 	Buffer(uint bufferType);
@@ -45,6 +52,11 @@ public:
 
 	void	updateBuffer(int offset, int size, void * data);
 
+	//updates are accumulated and uploaded with one call before buffer is used
+	void	markDirty(int offset, int size);
+	void	flushDirty(byte * data);
+	bool	isDirty() const { return mDirtyEnd > mDirtyBegin; }
+
 	static void	Unbind(uint bufferType);
 };
 
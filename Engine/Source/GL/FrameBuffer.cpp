@@ -341,6 +341,29 @@ bool FrameBuffer :: attachDepthTexture ( ITexture * tex )
 	return false;
 }
 
+bool FrameBuffer :: copyDepthTo ( IFrameBuffer * target )
+{
+	FrameBuffer * oglTarget = static_cast<FrameBuffer *>(target);
+
+	if ( mFrameBuffer == 0 || oglTarget->mFrameBuffer == 0 )
+		return false;
+
+	if ( !hasDepth() || !oglTarget->hasDepth() || mWidth != oglTarget->mWidth || mHeight != oglTarget->mHeight )
+		return false;
+
+	glBindFramebuffer	( GL_READ_FRAMEBUFFER, mFrameBuffer );
+	glBindFramebuffer	( GL_DRAW_FRAMEBUFFER, oglTarget->mFrameBuffer );
+	glBlitFramebuffer	( 0, 0, mWidth, mHeight, 0, 0, mWidth, mHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST );
+	CHECK_GL_ERROR;
+
+	//restore binding of bound framebuffer for both reading and drawing
+	FrameBuffer * bound = static_cast<FrameBuffer *>(sBoundFramebuffer);
+	glBindFramebuffer	( GL_FRAMEBUFFER, bound != NULL ? bound->mFrameBuffer : 0 );
+	CHECK_GL_ERROR;
+
+	return true;
+}
+
 bool	FrameBuffer :: createDepthBuffer ( int flags )
 {
 	if ( mFrameBuffer == 0 )
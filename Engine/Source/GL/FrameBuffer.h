@@ -57,6 +57,8 @@ public:
 	
 	virtual void setColorAttachmentsNum(int colorAttachmentsNum);
 
+	virtual bool copyDepthTo ( IFrameBuffer * target );
+
 	virtual ITexture * getAttachement(int no = 0);
 
 	bool createDepthBuffer  ( int flags );
@@ -26,9 +26,9 @@ bool	IndexBuffer :: create ()
 {
 	int bufferSize = getIndexSize() * getIndicesNum();
 	bool success = Buffer::create(bufferSize, getIndexBuff(), getStorageType() == RenderData::IBuffer::stGPUDynamicMemory);
-	if(success)
+	if(success && getStorageType() == RenderData::IBuffer::stGPUStaticMemory && !isPinned())
 	{
-		//DELETE_ARR(mIndices);
+		releaseCPUCopy();
 	}
 	return success;
 }
@@ -37,6 +37,7 @@ bool IndexBuffer :: map(bool read, bool write)
 {
 	if(isCreated())
 	{
+		flush();
 		mCPUBuffer = mIndices;
 		mIndices = reinterpret_cast<byte *>( mapBuffer(read, write) );
 	}
@@ -56,9 +57,15 @@ void IndexBuffer :: update(int offset, int size)
 {
 	if(isCreated())
 	{
-		byte * data = &mIndices[offset];
+		markDirty(offset, size);
+	}
+}
 
-		updateBuffer(offset, size, data);
+void IndexBuffer :: flush()
+{
+	if(isDirty())
+	{
+		flushDirty(mIndices);
 	}
 }
 
@@ -24,6 +24,9 @@ public:
 
 	virtual void update(int offset, int size);
 
+	//uploads changes made by update calls since last flush
+	void	flush();
+
 	bool create();
 
 	static void	Unbind();
@@ -326,6 +326,11 @@ void Render::setupVertexBuffer(RenderData::VertexBuffer * pVB)
 {
 	ASSERT(pVB);
 
+	VertexBuffer * glVB = TYPE_CAST<VertexBuffer*>(pVB);
+
+	//pending updates are uploaded even if buffer is set up already
+	glVB->flush();
+
 	if(mLastVB == pVB)
 		return;
 
@@ -335,7 +340,6 @@ void Render::setupVertexBuffer(RenderData::VertexBuffer * pVB)
 	disableClientStates();	
 
 	//create gl buffer if it's not created yet
-	VertexBuffer * glVB = TYPE_CAST<VertexBuffer*>(pVB);
 	if(!glVB->isCreated() && glVB->getStorageType() != RenderData::VertexBuffer::stCPUMemory)
 	{
 		glVB->create();
@@ -365,7 +369,9 @@ void Render::setupVertexBuffer(RenderData::VertexBuffer * pVB)
 #ifdef _DEBUG
 		VertexBuffer::VertexComponent vertexComponent = (VertexBuffer::VertexComponent)vc;//for debugging
 #endif
-		if( !((VCI2VT(vc) & vertexType) || vc == VertexBuffer::vcPosition) )
+		//position is always bound unless it is packed
+		bool floatPosition = vc == VertexBuffer::vcPosition && !pVB->hasComponent(VertexBuffer::vcInt16Position);
+		if( !((VCI2VT(vc) & vertexType) || floatPosition) )
 			continue;
 
 		GLenum dataType = 0;
@@ -457,6 +463,29 @@ void Render::setupVertexBuffer(RenderData::VertexBuffer * pVB)
 			attribChanel	= VertexBuffer::vcColor;
 			size			= 4;
 			break;
+		case VertexBuffer::vcInt16Position:
+			dataType		= GL_SHORT;
+			attribChanel	= VertexBuffer::vcPosition;
+			size			= 3;
+			break;
+		case VertexBuffer::vcOctNormal:
+			dataType		= GL_SHORT;
+			attribChanel	= VertexBuffer::vcNormal;
+			size			= 2;
+			normalized		= GL_TRUE;
+			break;
+		case VertexBuffer::vcOctTangentBinormal:
+			dataType		= GL_BYTE;
+			attribChanel	= VertexBuffer::vcTangentBinormal;
+			size			= 3;
+			normalized		= GL_TRUE;
+			break;
+		case VertexBuffer::vc4Int8BoneWeights:
+			dataType		= GL_UNSIGNED_BYTE;
+			attribChanel	= VertexBuffer::vc4BoneWeights;
+			size			= 4;
+			normalized		= GL_TRUE;
+			break;
 		}
 #ifdef _DEBUG
 		VertexBuffer::VertexComponent vcAttrib = (VertexBuffer::VertexComponent)attribChanel;//for debugging
@@ -502,14 +531,17 @@ void Render::renderIndexBuffer(RenderData::IndexBuffer * pIB, tuple2i range, int
 	}
 
 	//bind gl index buffer
-	void * indsBuffer = pIB->getIndexAddr(range.x);
+	void * indsBuffer = NULL;
 	if(glIB->isCreated())
 	{
-		indsBuffer = 0;
+		//offset in bound buffer, CPU copy may be released
+		indsBuffer = (void *)((uintptr_t)range.x * pIB->getIndexSize());
+		glIB->flush();
 		glIB->bind();
 	}
 	else
 	{
+		indsBuffer = pIB->getIndexAddr(range.x);
 		IndexBuffer::Unbind();
 	}
 
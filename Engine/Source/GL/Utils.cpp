@@ -52,7 +52,9 @@ bool Utils::CheckGLError(const char_t * msg)
 	if(errCode != GL_NO_ERROR)
 	{
 		const char_t * str = Utils::ErrorString(errCode);
-		Log::Instance().streamError("CheckGLError") << msg << " " << str;
+		//same error is usually reported every frame
+		static Log::RateLimit sErrorsLimit(10);
+		Log::Instance().streamError("CheckGLError", sErrorsLimit) << msg << " " << str;
 		Log::Instance().flush();
 		return true;
 	}
@@ -26,9 +26,9 @@ bool	VertexBuffer :: create ()
 {
 	size_t bufferSize = getVertexSize() * getVertsNum();
 	bool success = Buffer::create(bufferSize, getVerts(), getStorageType() == RenderData::VertexBuffer::stGPUDynamicMemory);
-	if(success)
+	if(success && getStorageType() == RenderData::IBuffer::stGPUStaticMemory && !isPinned())
 	{
-		//DELETE_ARR(mVerts);
+		releaseCPUCopy();
 	}
 	return success;
 }
@@ -37,6 +37,7 @@ bool VertexBuffer :: map(bool read, bool write)
 {
 	if(isCreated())
 	{
+		flush();
 		mCPUBuffer = mVerts;
 		void * buffer = mapBuffer(read, write);
 		mVerts = reinterpret_cast<byte *>( buffer );
@@ -57,9 +58,15 @@ void VertexBuffer :: update(int offset, int size)
 {
 	if(isCreated())
 	{
-		byte * data = &mVerts[offset];
+		markDirty(offset, size);
+	}
+}
 
-		updateBuffer(offset, size, data);
+void VertexBuffer :: flush()
+{
+	if(isDirty())
+	{
+		flushDirty(mVerts);
 	}
 }
 
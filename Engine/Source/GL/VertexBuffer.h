@@ -26,6 +26,9 @@ public:
 
 	virtual void update(int offset, int size);
 
+	//uploads changes made by update calls since last flush
+	void	flush();
+
 	static void	Unbind();
 };
 
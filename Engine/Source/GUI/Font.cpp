@@ -21,7 +21,13 @@
 //-----------------------------------------------------------------------------
 
 #include "Font.h"
+#include "TextLayoutCache.h"
 #include <Render/IRender.h>
+#include <FileSystem/FileStorage.h>
+#include <Common/Data.h>
+#include <Common/Log.h>
+#include <Common/Profiler.h>
+#include <algorithm>
 
 namespace Squirrel {
 namespace GUI {
@@ -29,6 +35,18 @@ namespace GUI {
 using namespace RenderData;
 using namespace Math;
 
+namespace {
+
+const int32 ATLAS_CACHE_KEY		= 0x41475153;//SQGA
+const int32 ATLAS_CACHE_VERSION	= 1;
+
+inline bool IsContinuationByte(byte b)
+{
+	return (b & 0xC0) == 0x80;
+}
+
+}//namespace {
+
 FontGenerator * FontGenerator::sFactory = 0;
 
 FontGenerator * FontGenerator::Active()
@@ -56,7 +74,13 @@ Font::Font()
 
 	mDepth = 0;
 
-    memset(mGlyphs, 0, sizeof(mGlyphs));
+    std::fill(mGlyphs, mGlyphs + TOTAL_CHARS, Glyph());
+
+	mRasterizer = NULL;
+	mAtlasVersion = 0;
+	mAtlasDirty = false;
+	mAtlasResetting = false;
+	mSourceStamp = 0;
 
 	mTargetMesh = new Resource::Mesh();
 
@@ -88,11 +112,25 @@ Font::Font()
 
 Font::~Font()
 {
+	TextLayoutCache::Instance().removeFont(this);
+
+	DELETE_PTR(mRasterizer);
 	DELETE_PTR(mFontTexture);
 	DELETE_PTR(mTargetMesh);
 }
 
 void Font::drawChar(char c, float x, float y)
+{
+	const Glyph * glyph = getGlyph((byte)c);
+	if(glyph->size.x > 0)
+	{
+		drawQuad(vec2(x, y) + glyph->offset, vec2(x, y) + glyph->offset + glyph->size, glyph->upperLeft, glyph->lowerRight);
+	}
+
+	updateAtlasTexture();
+}
+
+void Font::drawQuad(const vec2& min, const vec2& max, const vec2& uvMin, const vec2& uvMax)
 {
     //  1------4
     //  |      |            1 = (x, y)
@@ -104,28 +142,24 @@ void Font::drawChar(char c, float x, float y)
     //  2------3
     //
 
-    const Glyph &glyph = getChar(c);
-    float charWidth = glyph.width;
-    float charHeight = mCharHeight;
-
-	VertexBuffer * vb = mTargetMesh->getVertexBuffer();
-
 	vec3 pos[VERTS_PER_CHAR] = {
-		vec3(x, y, mDepth),
-		vec3(x, y + charHeight, mDepth),
-		vec3(x + charWidth, y + charHeight, mDepth),
-		vec3(x + charWidth, y, mDepth),
+		vec3(min.x, min.y, mDepth),
+		vec3(min.x, max.y, mDepth),
+		vec3(max.x, max.y, mDepth),
+		vec3(max.x, min.y, mDepth),
 	};
 
 	vec2 tex[VERTS_PER_CHAR] = {
-		glyph.upperLeft,
-		glyph.lowerLeft,
-		glyph.lowerRight,
-		glyph.upperRight
+		uvMin,
+		vec2(uvMin.x, uvMax.y),
+		uvMax,
+		vec2(uvMax.x, uvMin.y)
 	};
 
 	if(mFontRender == NULL)
 	{
+		VertexBuffer * vb = mTargetMesh->getVertexBuffer();
+
 		for(int i = 0; i < VERTS_PER_CHAR; ++i)
 		{
 			int j = mCurrentVertex + i;
@@ -181,54 +215,176 @@ void Font::drawBatchOfChars()
 
 void Font::drawText(float x, float y, const char *pszText)
 {
-    char prevCh = 0;
-    char ch = 0;
-    float dx = x;
-    float dy = y;
-    float charHeight = getCellHeight();
-    float whitespaceWidth = getChar(' ').width;
-
-    while (*pszText != '\0')
-    {
-        prevCh = ch;
-        ch = *pszText++;
-
-        if (ch == ' ')
-        {
-            if (prevCh != '\r')
-                dx += whitespaceWidth;
-        }
-        else if (ch == '\n' || ch == '\r')
-        {
-            dx = x;
-            dy += charHeight;
-        }
-        else if (ch == '\t')
-        {
-            dx += whitespaceWidth * TAB_SPACES;
-        }
-        else if (ch >= CHAR_FIRST && ch <= CHAR_LAST)
-        {
-            drawChar(ch, dx, dy);
-            dx += getChar(ch).width;
-        }
-    }
+	const TextLayout * layout = getLayout(pszText);
+	if(layout == NULL)
+		return;
+
+	vec2 pos(x, y);
+	for(size_t i = 0; i < layout->quads.size(); ++i)
+	{
+		const TextLayout::Quad& quad = layout->quads[i];
+		drawQuad(pos + quad.min, pos + quad.max, quad.uvMin, quad.uvMax);
+	}
+
+	updateAtlasTexture();
 }
 
-float Font::getStrWidth(const char *pszText) const
+const TextLayout * Font::getLayout(const char *pszText)
 {
     if (!pszText)
-        return 0;
+        return NULL;
 
-    float width = 0;
+	return TextLayoutCache::Instance().get(this, pszText);
+}
 
-    while (*pszText != '\0')
-        width += getCharWidth(*pszText++);
+void Font::buildLayout(const char *pChar, size_t length, TextLayout& outLayout)
+{
+	SQ_PROFILE_ZONE("Font::buildLayout");
 
-    return width;
+	//baking of glyph can reset atlas and invalidate quads of glyphs baked before,
+	//then layout is built again with all its glyphs baked in new atlas
+	for(int attempt = 0; attempt < 2; ++attempt)
+	{
+		int atlasVersion = mAtlasVersion;
+
+		outLayout.quads.clear();
+		outLayout.width = 0;
+		outLayout.height = 0;
+
+		const char * pEnd = pChar + length;
+		const char * p = pChar;
+
+		uint32 prevCode = 0;
+		uint32 code = 0;
+		float dx = 0;
+		float dy = 0;
+		float whitespaceWidth = getGlyph(' ')->width;
+
+		while (p < pEnd)
+		{
+			prevCode = code;
+			code = DecodeUTF8(p, pEnd);
+
+			if (code == ' ')
+			{
+				if (prevCode != '\r')
+					dx += whitespaceWidth;
+			}
+			else if (code == '\n' || code == '\r')
+			{
+				dx = 0;
+				dy += mCellHeight;
+			}
+			else if (code == '\t')
+			{
+				dx += whitespaceWidth * TAB_SPACES;
+			}
+			else if (code > ' ' && code != 0x7F)
+			{
+				const Glyph * glyph = getGlyph(code);
+				if (glyph->size.x > 0)
+				{
+					TextLayout::Quad quad;
+					quad.min	= vec2(dx, dy) + glyph->offset;
+					quad.max	= quad.min + glyph->size;
+					quad.uvMin	= glyph->upperLeft;
+					quad.uvMax	= glyph->lowerRight;
+					outLayout.quads.push_back(quad);
+				}
+				dx += glyph->width;
+			}
+
+			outLayout.width = maxValue(outLayout.width, dx);
+		}
+
+		outLayout.height = dy + mCharHeight;
+
+		//text which does not fit into atlas stays stale
+		outLayout.atlasVersion = atlasVersion;
+
+		if(atlasVersion == mAtlasVersion)
+			break;
+	}
 }
 
-float Font::getStrWidth(const char *pChar, size_t length) const
+const Font::Glyph * Font::getGlyph(uint32 code)
+{
+	if (code >= CHAR_FIRST && code <= CHAR_LAST)
+	{
+		//kept baked by atlas
+		return &mGlyphs[code - CHAR_FIRST];
+	}
+
+	GLYPHS_MAP::iterator it = mExtraGlyphs.find(code);
+	if (it != mExtraGlyphs.end())
+		return &it->second;
+
+	if (mRasterizer != NULL && mMissingGlyphs.find(code) == mMissingGlyphs.end())
+	{
+		Glyph glyph;
+		if (bakeGlyph(code, glyph))
+		{
+			return &(mExtraGlyphs[code] = glyph);
+		}
+
+		mMissingGlyphs.insert(code);
+	}
+
+	if (code != REPLACEMENT_CHAR && mRasterizer != NULL)
+		return getGlyph(REPLACEMENT_CHAR);
+
+	return &mGlyphs['?' - CHAR_FIRST];
+}
+
+float Font::getCodeWidth(uint32 code)
+{
+	//control chars take no space unless laid out
+	if (code < ' ' || code == 0x7F)
+		return 0;
+
+	return getGlyph(code)->width;
+}
+
+uint32 Font::DecodeUTF8(const char *& pChar, const char * pEnd)
+{
+	byte b = (byte)*pChar++;
+
+	if (b < 0x80)
+		return b;
+
+	int tailNum = 0;
+	uint32 code = 0;
+	uint32 minCode = 0;
+
+	if ((b & 0xE0) == 0xC0)			{ tailNum = 1; code = b & 0x1F; minCode = 0x80; }
+	else if ((b & 0xF0) == 0xE0)	{ tailNum = 2; code = b & 0x0F; minCode = 0x800; }
+	else if ((b & 0xF8) == 0xF0)	{ tailNum = 3; code = b & 0x07; minCode = 0x10000; }
+	else
+		return REPLACEMENT_CHAR;
+
+	for (int i = 0; i < tailNum; ++i)
+	{
+		//truncated sequence, following char is decoded on its own
+		if (pChar >= pEnd || !IsContinuationByte((byte)*pChar))
+			return REPLACEMENT_CHAR;
+
+		code = (code << 6) | ((byte)*pChar++ & 0x3F);
+	}
+
+	//overlong encodings and surrogates
+	if (code < minCode || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+		return REPLACEMENT_CHAR;
+
+	return code;
+}
+
+float Font::getStrWidth(const char *pszText)
+{
+	const TextLayout * layout = getLayout(pszText);
+	return layout != NULL ? layout->width : 0;
+}
+
+float Font::getStrWidth(const char *pChar, size_t length)
 {
     if (!pChar || length <= 0)
         return 0;
@@ -237,32 +393,36 @@ float Font::getStrWidth(const char *pChar, size_t length) const
 
     float width = 0;
 
-    for (int i = 0; i < length; ++i)
-        width += getCharWidth(pChar[i]);
+	const char * pEnd = pChar + length;
+	while (pChar < pEnd)
+	{
+		width += getCodeWidth(DecodeUTF8(pChar, pEnd));
+	}
 
     return width;
 }
 
-int Font::getMaxFittingLength(const char *pszText, float bounds) const
+int Font::getMaxFittingLength(const char *pszText, float bounds)
 {
     if (!pszText || bounds <= 0)
         return 0;
 
 	size_t length = strlen( pszText );
+	const char * pEnd = pszText + length;
+	const char * p = pszText;
     float currWidth = 0;
-	int index = 0;
 
-	for(int i = 0; i < length; ++i)
+	//whole chars only
+	while (p < pEnd)
 	{
-		if(currWidth < bounds)
-		{
-		  currWidth += getCharWidth(pszText[i]);
-		  index++;
-		}
-		else break;
+		const char * pNext = p;
+		currWidth += getCodeWidth(DecodeUTF8(pNext, pEnd));
+		if (currWidth >= bounds)
+			break;
+		p = pNext;
 	}
 
-    return (currWidth < bounds) ? index : index - 1;
+    return (int)(p - pszText);
 }
 
 void Font::generateTexCoords(float bmpWidth, float bmpHeight)
@@ -291,8 +451,306 @@ void Font::generateTexCoords(float bmpWidth, float bmpHeight)
 
         pGlyph->upperRight[0] = ((col * mCellWidth) + charWidth) / bmpWidth;
         pGlyph->upperRight[1] = (row * mCellHeight) / bmpHeight;
+
+        pGlyph->offset = vec2(0, 0);
+        pGlyph->size = vec2(charWidth, mCharHeight);
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+// glyphs atlas
+
+bool Font::initAtlas(GlyphRasterizer * rasterizer, const std::string& cacheFile, uint64 sourceStamp)
+{
+	mRasterizer = rasterizer;
+	mAtlasCacheFile = cacheFile;
+	mSourceStamp = sourceStamp;
+
+	float ascent = floorf(mRasterizer->getAscent() + 0.5f);
+	float descent = floorf(mRasterizer->getDescent() + 0.5f);
+	float lineGap = floorf(mRasterizer->getLineGap() + 0.5f);
+
+	mCharHeight = ascent + descent;
+	mCellHeight = mCharHeight + lineGap;
+
+	//atlas is sized to keep ASCII in quarter of it
+	GlyphRasterizer::Bitmap bitmap;
+	int area = 0;
+	mCharMaxWidth = 0;
+	mCharAvgWidth = 0;
+	for (int c = CHAR_FIRST; c <= CHAR_LAST; ++c)
+	{
+		if (!mRasterizer->rasterize(c, bitmap))
+			continue;
+
+		area += (bitmap.width + ATLAS_PADDING) * (bitmap.height + ATLAS_PADDING);
+
+		float width = floorf(bitmap.advance + 0.5f);
+		mCharMaxWidth = maxValue(mCharMaxWidth, width);
+		mCharAvgWidth += width;
+	}
+	mCharAvgWidth /= TOTAL_CHARS;
+	mCellWidth = mCharMaxWidth;
+
+	int atlasSize = ATLAS_MIN_SIZE;
+	while (atlasSize < ATLAS_MAX_SIZE && atlasSize * atlasSize < area * 4)
+	{
+		atlasSize *= 2;
+	}
+
+	Image * image = new Image(atlasSize, atlasSize, 1, Image::Int8, Image::Alpha);
+	memset(image->getData(), 0, atlasSize * atlasSize);
+
+	//texture keeps image as atlas pixels
+	mFontTexture = new Resource::Texture(image, RenderData::Image::Uncompressed, false);
+
+	//glyphs are sampled texel to pixel
+	mFontTexture->getRenderTexture()->setTexParameters(Render::ITexture::Nearest, Render::ITexture::ClampToEdge, 1);
+
+	if (!loadAtlasCache())
+	{
+		resetAtlas();
+	}
+
+	updateAtlasTexture();
+
+	return true;
+}
+
+void Font::resetAtlas()
+{
+	Image * image = mFontTexture->getSrcImage();
+	memset(image->getData(), 0, image->getWidth() * image->getHeight());
+
+	mShelves.clear();
+	mExtraGlyphs.clear();
+	mMissingGlyphs.clear();
+	++mAtlasVersion;
+
+	//ASCII is always baked
+	mAtlasResetting = true;
+	for (int c = CHAR_FIRST; c <= CHAR_LAST; ++c)
+	{
+		if (!bakeGlyph(c, mGlyphs[c - CHAR_FIRST]))
+		{
+			mGlyphs[c - CHAR_FIRST] = Glyph();
+		}
+	}
+	mAtlasResetting = false;
+
+	mAtlasDirty = true;
+}
+
+bool Font::bakeGlyph(uint32 code, Glyph& glyph)
+{
+	GlyphRasterizer::Bitmap bitmap;
+	if (!mRasterizer->rasterize(code, bitmap))
+		return false;
+
+	glyph = Glyph();
+	glyph.width = floorf(bitmap.advance + 0.5f);
+
+	if (bitmap.width <= 0 || bitmap.height <= 0)
+		return true;
+
+	tuple2i pos;
+	if (!allocAtlasRect(bitmap.width + ATLAS_PADDING, bitmap.height + ATLAS_PADDING, pos))
+	{
+		if (mAtlasResetting)
+			return true;//left blank
+
+		//glyphs used recently are baked again on demand
+		resetAtlas();
+
+		if (!allocAtlasRect(bitmap.width + ATLAS_PADDING, bitmap.height + ATLAS_PADDING, pos))
+			return true;
+	}
+
+	Image * image = mFontTexture->getSrcImage();
+	for (int y = 0; y < bitmap.height; ++y)
+	{
+		memcpy(image->getPixel(pos.x, pos.y + y), &bitmap.alpha[y * bitmap.width], bitmap.width);
+	}
+
+	float atlasWidth = (float)image->getWidth();
+	float atlasHeight = (float)image->getHeight();
+
+	glyph.offset = vec2((float)bitmap.left, floorf(mRasterizer->getAscent() + 0.5f) - bitmap.top);
+	glyph.size = vec2((float)bitmap.width, (float)bitmap.height);
+
+	glyph.upperLeft		= vec2(pos.x / atlasWidth, pos.y / atlasHeight);
+	glyph.lowerRight	= vec2((pos.x + bitmap.width) / atlasWidth, (pos.y + bitmap.height) / atlasHeight);
+	glyph.lowerLeft		= vec2(glyph.upperLeft.x, glyph.lowerRight.y);
+	glyph.upperRight	= vec2(glyph.lowerRight.x, glyph.upperLeft.y);
+
+	mAtlasDirty = true;
+
+	return true;
+}
+
+bool Font::allocAtlasRect(int width, int height, tuple2i& outPos)
+{
+	Image * image = mFontTexture->getSrcImage();
+	int atlasWidth = (int)image->getWidth();
+	int atlasHeight = (int)image->getHeight();
+
+	//lowest shelf glyph fits in
+	int bestShelf = -1;
+	for (size_t i = 0; i < mShelves.size(); ++i)
+	{
+		const Shelf& shelf = mShelves[i];
+		if (shelf.height >= height && shelf.width + width <= atlasWidth)
+		{
+			if (bestShelf < 0 || shelf.height < mShelves[bestShelf].height)
+				bestShelf = (int)i;
+		}
+	}
+
+	//new shelf is made if fitting ones waste too much
+	if (bestShelf < 0 || mShelves[bestShelf].height > height + height / 2)
+	{
+		int top = mShelves.empty() ? 0 : mShelves.back().y + mShelves.back().height;
+		if (top + height <= atlasHeight && width <= atlasWidth)
+		{
+			Shelf shelf = { top, height, 0 };
+			mShelves.push_back(shelf);
+			bestShelf = (int)mShelves.size() - 1;
+		}
+	}
+
+	if (bestShelf < 0)
+		return false;
+
+	Shelf& shelf = mShelves[bestShelf];
+	outPos = tuple2i(shelf.width, shelf.y);
+	shelf.width += width;
+
+	return true;
+}
+
+void Font::updateAtlasTexture()
+{
+	if (!mAtlasDirty)
+		return;
+
+	mFontTexture->getRenderTexture()->fill(mFontTexture->getSrcImage());
+	mAtlasDirty = false;
+}
+
+bool Font::saveAtlasCache()
+{
+	if (mRasterizer == NULL || mAtlasCacheFile.empty())
+		return false;
+
+	Image * image = mFontTexture->getSrcImage();
+
+	Data data(NULL, (size_t)1024);
+	data.setCapacityIncrement(image->getWidth() * image->getHeight() + 1024);
+
+	data.putInt32(ATLAS_CACHE_KEY);
+	data.putInt32(ATLAS_CACHE_VERSION);
+	data.putUInt64(mSourceStamp);
+	data.putInt32(image->getWidth());
+	data.putInt32(image->getHeight());
+
+	data.putInt32((int32)mShelves.size());
+	for (size_t i = 0; i < mShelves.size(); ++i)
+	{
+		data.putInt32(mShelves[i].y);
+		data.putInt32(mShelves[i].height);
+		data.putInt32(mShelves[i].width);
+	}
+
+	data.putInt32(TOTAL_CHARS + (int32)mExtraGlyphs.size());
+	for (int c = CHAR_FIRST; c <= CHAR_LAST; ++c)
+	{
+		data.putUInt32(c);
+		data.putData(&mGlyphs[c - CHAR_FIRST], sizeof(Glyph));
+	}
+	for (GLYPHS_MAP::const_iterator it = mExtraGlyphs.begin(); it != mExtraGlyphs.end(); ++it)
+	{
+		data.putUInt32(it->first);
+		data.putData(&it->second, sizeof(Glyph));
+	}
+
+	data.putData(image->getData(), image->getWidth() * image->getHeight());
+
+	if (data.writeToFile(mAtlasCacheFile.c_str()) == (size_t)-1)
+	{
+		Log::Instance().warning("Font::saveAtlasCache", ("Failed to write " + mAtlasCacheFile).c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool Font::loadAtlasCache()
+{
+	if (mAtlasCacheFile.empty() || !FileSystem::FileStorage::IsFileExist(mAtlasCacheFile.c_str()))
+		return false;
+
+	Image * image = mFontTexture->getSrcImage();
+
+	Data data(mAtlasCacheFile.c_str());
+
+	//cache of other font file, size or atlas size is rebuilt
+	bool isOk = data.getLength() >= 5 * sizeof(int32) &&
+		data.readInt32() == ATLAS_CACHE_KEY &&
+		data.readInt32() == ATLAS_CACHE_VERSION &&
+		data.readUInt64() == mSourceStamp &&
+		data.readInt32() == (int32)image->getWidth() &&
+		data.readInt32() == (int32)image->getHeight();
+
+	if (!isOk)
+		return false;
+
+	std::vector<Shelf> shelves(data.readInt32());
+	for (size_t i = 0; i < shelves.size(); ++i)
+	{
+		shelves[i].y		= data.readInt32();
+		shelves[i].height	= data.readInt32();
+		shelves[i].width	= data.readInt32();
+	}
+
+	Glyph asciiGlyphs[TOTAL_CHARS];
+	int asciiNum = 0;
+	GLYPHS_MAP extraGlyphs;
+
+	int32 glyphsNum = data.readInt32();
+	for (int32 i = 0; i < glyphsNum; ++i)
+	{
+		uint32 code = data.readUInt32();
+		Glyph glyph;
+		if (data.readBytes(&glyph, sizeof(Glyph)) != sizeof(Glyph))
+			return false;
+
+		if (code >= CHAR_FIRST && code <= CHAR_LAST)
+		{
+			asciiGlyphs[code - CHAR_FIRST] = glyph;
+			++asciiNum;
+		}
+		else
+		{
+			extraGlyphs[code] = glyph;
+		}
+	}
+
+	size_t pixelsSize = image->getWidth() * image->getHeight();
+	if (asciiNum != TOTAL_CHARS || data.getLength() - data.getPos() != pixelsSize)
+		return false;
+
+	data.readBytes(image->getData(), pixelsSize);
+
+	memcpy(mGlyphs, asciiGlyphs, sizeof(mGlyphs));
+	mExtraGlyphs.swap(extraGlyphs);
+	mMissingGlyphs.clear();
+	mShelves.swap(shelves);
+	++mAtlasVersion;
+
+	mAtlasDirty = true;
+
+	return true;
+}
+
 }//namespace Squirrel {
 }//namespace GUI {
@@ -25,6 +25,10 @@
 
 #include <Resource/Texture.h>
 #include <Resource/Mesh.h>
+#include <Common/tuple.h>
+#include <map>
+#include <set>
+#include <vector>
 #include "macros.h"
 
 //Font class made from GLFont class of dhpoware.
@@ -43,6 +47,10 @@
 //  font.drawTextFormat(1, 1, "%s", "Hello, World!");
 //  font.end();
 //  font.destroy();
+//
+// Fonts made by TrueTypeFontGenerator have no fixed character set: glyphs
+// are baked by rasterizer into atlas texture on first use, so any UTF-8 text
+// is drawn. Text is laid out once and kept in TextLayoutCache.
 //-----------------------------------------------------------------------------
 
 namespace Squirrel {
@@ -57,6 +65,49 @@ public:
 	virtual void drawChar( Math::vec3 vertices[VERTS_PER_CHAR], Math::vec2 texcoords[VERTS_PER_CHAR] )	= 0;
 };
 
+//Renders glyphs of font of one size for atlas of Font.
+class SQGUI_API GlyphRasterizer
+{
+public:
+
+	struct Bitmap
+	{
+		int width;
+		int height;
+		int left;//from pen position to left column of bitmap
+		int top;//from baseline up to top row of bitmap
+		float advance;
+		std::vector<byte> alpha;//rows top down
+	};
+
+	virtual ~GlyphRasterizer() {}
+
+	//in pixels, descent is positive
+	virtual float getAscent() const = 0;
+	virtual float getDescent() const = 0;
+	virtual float getLineGap() const = 0;
+
+	virtual bool hasGlyph(uint32 code) const = 0;
+	virtual bool rasterize(uint32 code, Bitmap& outBitmap) = 0;
+};
+
+//Quads of laid out text relative to its upper left corner.
+struct TextLayout
+{
+	struct Quad
+	{
+		Math::vec2 min;
+		Math::vec2 max;
+		Math::vec2 uvMin;
+		Math::vec2 uvMax;
+	};
+
+	std::vector<Quad> quads;
+	float width;
+	float height;
+	int atlasVersion;//quads are invalid once glyphs are rebaked
+};
+
 class SQGUI_API Font
 {
 
@@ -65,6 +116,7 @@ class SQGUI_API Font
 #elif __APPLE__
 	friend class MacFontGenerator;
 #endif
+	friend class TrueTypeFontGenerator;
 
 public:
     enum Style
@@ -80,16 +132,35 @@ public:
         Math::vec2 lowerLeft;
         Math::vec2 upperRight;
         Math::vec2 lowerRight;
+        Math::vec2 offset;//of quad from pen position at top of line
+        Math::vec2 size;//of quad, zero for blank glyphs
     };
 
+    static const uint32 REPLACEMENT_CHAR = 0xFFFD;
+
     Font();
     ~Font();
 
+    //text is UTF-8
     void drawText(float x, float y, const char *pszText);
 	void drawChar(char c, float x, float y);
 
 	void flush();
 
+	//bakes glyph if it has not been baked yet, returns replacement for missing ones
+	const Glyph * getGlyph(uint32 code);
+
+	//cached layout, valid till next call
+	const TextLayout * getLayout(const char *pszText);
+	void buildLayout(const char *pChar, size_t length, TextLayout& outLayout);
+
+	int getAtlasVersion() const { return mAtlasVersion; }
+	int getBakedGlyphsNum() const { return TOTAL_CHARS + (int)mExtraGlyphs.size(); }
+
+	//glyphs baked by rasterizer are stored for next runs
+	bool loadAtlasCache();
+	bool saveAtlasCache();
+
     float getCellHeight() const;
     float getCellWidth() const;
     const Glyph &getChar(char ch) const;
@@ -99,9 +170,10 @@ public:
     float getCharWidth(char ch) const;
     const char *getName() const;
     float getPointSize() const;
-    float getStrWidth(const char *pszText) const;
-    float getStrWidth(const char *pChar, size_t length) const;
-	int getMaxFittingLength(const char *pszText, float bounds) const;
+    float getStrWidth(const char *pszText);
+    //length and result are in bytes
+    float getStrWidth(const char *pChar, size_t length);
+	int getMaxFittingLength(const char *pszText, float bounds);
 
 	Resource::Texture * getTexture();
 	void setFontRender(FontRender * render);
@@ -119,6 +191,28 @@ private:
 
 	void generateTexCoords(float bmpWidth, float bmpHeight);
 
+	void drawQuad(const Math::vec2& min, const Math::vec2& max, const Math::vec2& uvMin, const Math::vec2& uvMax);
+
+	//takes ownership of rasterizer
+	bool initAtlas(GlyphRasterizer * rasterizer, const std::string& cacheFile, uint64 sourceStamp);
+	void resetAtlas();
+	bool bakeGlyph(uint32 code, Glyph& glyph);
+	bool allocAtlasRect(int width, int height, tuple2i& outPos);
+	void updateAtlasTexture();
+
+	float getCodeWidth(uint32 code);
+
+	static uint32 DecodeUTF8(const char *& pChar, const char * pEnd);
+
+	struct Shelf
+	{
+		int y;
+		int height;
+		int width;//used
+	};
+
+	typedef std::map<uint32, Glyph> GLYPHS_MAP;
+
     static const int CHAR_FIRST = 32;
     static const int CHAR_LAST = 126;
     static const int TAB_SPACES = 4;
@@ -128,6 +222,10 @@ private:
     static const int MAX_STR_SIZE = 1024;
     static const int MAX_VERTICES = MAX_CHARS_PER_BATCH * 4;
 
+    static const int ATLAS_PADDING = 1;
+    static const int ATLAS_MIN_SIZE = 128;
+    static const int ATLAS_MAX_SIZE = 2048;
+
     std::string mName;
     float mPointSize;
     float mCellHeight;
@@ -138,6 +236,19 @@ private:
     int mNumCharsToDraw;
     Glyph mGlyphs[TOTAL_CHARS];
 
+	//glyphs out of ASCII range, baked by rasterizer
+	GLYPHS_MAP mExtraGlyphs;
+	std::set<uint32> mMissingGlyphs;
+
+	GlyphRasterizer * mRasterizer;
+	std::vector<Shelf> mShelves;
+	int mAtlasVersion;
+	bool mAtlasDirty;
+	bool mAtlasResetting;
+
+	std::string mAtlasCacheFile;
+	uint64 mSourceStamp;//font file and size atlas cache has been made for
+
 	float mDepth;
 
 	Resource::Texture * mFontTexture;
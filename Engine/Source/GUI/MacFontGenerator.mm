@@ -158,6 +158,8 @@ Font * MacFontGenerator::create(const char *name, int size, Font::Style style)
 		
         pGlyph->upperRight[0] = float((col * font->mCellWidth) + charWidth) / w;
         pGlyph->upperRight[1] = float(row * font->mCellHeight) / h + vOffset;
+
+        pGlyph->size = Math::vec2(charWidth, font->mCellHeight);
 		
 		//update grid positions
 		
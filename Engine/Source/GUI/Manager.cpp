@@ -3,6 +3,10 @@
 #include "Render.h"
 #include <Common/Input.h>
 #include <Render/IRender.h>
+#include <Common/Profiler.h>
+#include <Common/Settings.h>
+#include <FileSystem/Path.h>
+#include "TrueTypeFontGenerator.h"
 
 #ifdef _WIN32
 # include "WindowsFontGenerator.h"
@@ -36,25 +40,54 @@ Manager& Manager::Instance()
 void Manager::init()
 {
 	//create fonts
-	FontGenerator * fontGenerator = NULL;
-	
+	std::string fontsPath = Settings::Default()->getString("GUI", "Fonts Path", "Fonts");
+	fontsPath = FileSystem::Path::GetAbsPath(fontsPath);
+
+	std::string fontCachePath = Settings::Default()->getString("GUI", "Font Cache Path", "Fonts");
+	fontCachePath = FileSystem::Path::GetAbsPath(fontCachePath);
+
+	TrueTypeFontGenerator trueTypeGenerator;
+	trueTypeGenerator.addFontsFolder(fontsPath);
+	trueTypeGenerator.setCacheFolder(fontCachePath);
+
+	//system fonts
 #ifdef _WIN32
-	fontGenerator = new WindowsFontGenerator;
+	const char * windowsFolder = getenv("WINDIR");
+	if(windowsFolder != NULL)
+		trueTypeGenerator.addFontsFolder(FileSystem::Path::Combine(windowsFolder, "Fonts"));
 #elif __APPLE__
-	fontGenerator = new MacFontGenerator;
+	trueTypeGenerator.addFontsFolder("/Library/Fonts");
+	trueTypeGenerator.addFontsFolder("/System/Library/Fonts");
+#else
+	trueTypeGenerator.addFontsFolder("/usr/share/fonts/truetype/dejavu");
+	trueTypeGenerator.addFontsFolder("/usr/share/fonts/dejavu");
+	trueTypeGenerator.addFontsFolder("/usr/share/fonts/TTF");
+	trueTypeGenerator.addFontsFolder("/usr/share/fonts/truetype/liberation");
 #endif
 
-	Font * smallFont	= fontGenerator->create("Terminus", 6, Font::NORMAL);
-	Font * normalFont	= fontGenerator->create("Terminus", 8, Font::NORMAL);
-	Font * bigFont		= fontGenerator->create("Terminus", 16, Font::NORMAL);
+	//platform fonts are used if no font file is found
+	FontGenerator * platformGenerator = NULL;
+
+#ifdef _WIN32
+	platformGenerator = new WindowsFontGenerator;
+#elif __APPLE__
+	platformGenerator = new MacFontGenerator;
+#endif
+
+	const int fontSizes[Render::sizesNum] = { 6, 8, 16 };
+
+	for(int i = 0; i < Render::sizesNum; ++i)
+	{
+		Font * font = trueTypeGenerator.create("Terminus", fontSizes[i], Font::NORMAL);
+		if(font == NULL && platformGenerator != NULL)
+			font = platformGenerator->create("Terminus", fontSizes[i], Font::NORMAL);
 
-	Render::Instance().setFont(Render::sizeSmall,	smallFont);
-	Render::Instance().setFont(Render::sizeNormal,	normalFont);
-	Render::Instance().setFont(Render::sizeBig,		bigFont);
+		Render::Instance().setFont((Render::Size)i, font);
+	}
 
-	mMainFont = normalFont;
+	mMainFont = Render::Instance().getFont(Render::sizeNormal);
 
-	delete fontGenerator;
+	DELETE_PTR(platformGenerator);
 
 	mRootMenu = new Menu();
 
@@ -68,6 +101,16 @@ void Manager::init()
 	//Reflection::ObjectCreator 
 }
 
+void Manager::saveFontCaches()
+{
+	for(int i = 0; i < Render::sizesNum; ++i)
+	{
+		Font * font = Render::Instance().getFont((Render::Size)i);
+		if(font != NULL)
+			font->saveAtlasCache();
+	}
+}
+
 void Manager::showMenu(MenuContentSource * menuSrc, tuple2i pos)
 {
 	mRootMenu->setContentSource(menuSrc);
@@ -84,6 +127,8 @@ void Manager::showMenu(MenuContentSource * menuSrc)
 
 void Manager::update()
 {
+	SQ_PROFILE_ZONE("GUI::Manager::update");
+
 	mState = stateProcessInput;
 
 	//handle mouse movement
@@ -175,6 +220,8 @@ void Manager::update()
 
 void Manager::render()
 {
+	SQ_PROFILE_ZONE("GUI::Manager::render");
+
 	mState = stateRender;
 
 	mMainPanel->setDrawStyle(0);
@@ -50,6 +50,9 @@ public:
 
 	void init();
 
+	//stores glyphs baked by fonts for next runs
+	void saveFontCaches();
+
 	//static void saveElement(Element *elem, std::string &filename);
 	//static void loadElement(Element *elem, std::string &filename);
 	//static Element *loadElement(std::string &filename);
@@ -0,0 +1,143 @@
+#include "TextLayoutCache.h"
+
+namespace Squirrel {
+namespace GUI { 
+
+namespace {
+
+uint64 HashText(const char * text, size_t& outLength)
+{
+	//FNV-1a
+	uint64 hash = 14695981039346656037ULL;
+	const char * p = text;
+	for(; *p != 0; ++p)
+	{
+		hash ^= (byte)*p;
+		hash *= 1099511628211ULL;
+	}
+	outLength = p - text;
+	return hash;
+}
+
+}//namespace {
+
+TextLayoutCache::TextLayoutCache():
+	mCapacity(DEFAULT_CAPACITY), mHitsNum(0), mMissesNum(0)
+{
+}
+
+TextLayoutCache::~TextLayoutCache()
+{
+}
+
+TextLayoutCache& TextLayoutCache::Instance()
+{
+	//never destroyed to stay valid for fonts released at exit
+	static TextLayoutCache * sInstance = new TextLayoutCache();
+	return *sInstance;
+}
+
+const TextLayout * TextLayoutCache::get(Font * font, const char * text)
+{
+	size_t length = 0;
+
+	Key key;
+	key.font = font;
+	key.hash = HashText(text, length);
+
+	ENTRIES_MAP::iterator it = mEntriesMap.find(key);
+	if(it != mEntriesMap.end())
+	{
+		Entry& entry = *it->second;
+
+		//move to front
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+
+		if(entry.text.length() == length && entry.text.compare(0, length, text, length) == 0)
+		{
+			++mHitsNum;
+
+			if(entry.layout.atlasVersion != font->getAtlasVersion())
+			{
+				font->buildLayout(text, length, entry.layout);
+			}
+
+			return &entry.layout;
+		}
+
+		//other text with same hash is replaced
+		++mMissesNum;
+		entry.text.assign(text, length);
+		font->buildLayout(text, length, entry.layout);
+		return &entry.layout;
+	}
+
+	++mMissesNum;
+
+	if(mCapacity == 0)
+	{
+		font->buildLayout(text, length, mUncachedLayout);
+		return &mUncachedLayout;
+	}
+
+	if(mEntriesMap.size() >= mCapacity)
+	{
+		//reuse least recently used entry with its buffers
+		mEntriesMap.erase(mEntries.back().key);
+		mEntries.splice(mEntries.begin(), mEntries, --mEntries.end());
+	}
+	else
+	{
+		mEntries.push_front(Entry());
+	}
+
+	Entry& entry = mEntries.front();
+	entry.key = key;
+	entry.text.assign(text, length);
+	font->buildLayout(text, length, entry.layout);
+
+	mEntriesMap[key] = mEntries.begin();
+
+	return &entry.layout;
+}
+
+void TextLayoutCache::removeFont(Font * font)
+{
+	ENTRIES_LIST::iterator it = mEntries.begin();
+	while(it != mEntries.end())
+	{
+		if(it->key.font == font)
+		{
+			mEntriesMap.erase(it->key);
+			it = mEntries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void TextLayoutCache::clear()
+{
+	mEntriesMap.clear();
+	mEntries.clear();
+}
+
+void TextLayoutCache::setCapacity(size_t capacity)
+{
+	mCapacity = capacity;
+	evict(mCapacity);
+}
+
+void TextLayoutCache::evict(size_t size)
+{
+	while(mEntriesMap.size() > size)
+	{
+		mEntriesMap.erase(mEntries.back().key);
+		mEntries.pop_back();
+	}
+}
+
+}//namespace GUI { 
+}//namespace Squirrel {
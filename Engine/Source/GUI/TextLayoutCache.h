@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Font.h"
+#include <list>
+#include <map>
+#include <string>
+
+namespace Squirrel {
+namespace GUI { 
+
+//Keeps layouts of recently drawn strings, so unchanged text is not decoded and measured every frame.
+//Layouts are keyed by font (one font is one size) and text and are rebuilt when atlas of font is rebaked.
+//Least recently used layout is replaced when cache is full. Used by GUI thread only.
+class SQGUI_API TextLayoutCache
+{
+public:
+
+	static const size_t DEFAULT_CAPACITY = 1024;
+
+private:
+
+	struct Key
+	{
+		Font *	font;
+		uint64	hash;
+
+		bool operator < (const Key& other) const
+		{
+			return font < other.font || (font == other.font && hash < other.hash);
+		}
+	};
+
+	struct Entry
+	{
+		Key			key;
+		std::string	text;//hashes of different texts can collide
+		TextLayout	layout;
+	};
+
+	typedef std::list<Entry> ENTRIES_LIST;
+	typedef std::map<Key, ENTRIES_LIST::iterator> ENTRIES_MAP;
+
+	TextLayoutCache();
+
+public:
+
+	~TextLayoutCache();
+
+	static TextLayoutCache& Instance();
+
+	//builds layout if it is not cached, pointer is valid till next call
+	const TextLayout * get(Font * font, const char * text);
+
+	void removeFont(Font * font);
+	void clear();
+
+	void	setCapacity(size_t capacity);
+	size_t	getCapacity() const	{ return mCapacity; }
+	size_t	getSize() const		{ return mEntriesMap.size(); }
+
+	uint32	getHitsNum() const		{ return mHitsNum; }
+	uint32	getMissesNum() const	{ return mMissesNum; }
+	void	resetStats()			{ mHitsNum = mMissesNum = 0; }
+
+private:
+
+	void evict(size_t size);
+
+	ENTRIES_LIST	mEntries;//most recently used first
+	ENTRIES_MAP		mEntriesMap;
+
+	size_t mCapacity;
+
+	TextLayout mUncachedLayout;//used if capacity is zero
+
+	uint32 mHitsNum;
+	uint32 mMissesNum;
+};
+
+}//namespace GUI { 
+}//namespace Squirrel {
@@ -0,0 +1,836 @@
+#include "TrueTypeFontGenerator.h"
+#include <FileSystem/Path.h>
+#include <FileSystem/FileStorage.h>
+#include <Common/Log.h>
+#include <math.h>
+#include <string.h>
+
+namespace Squirrel {
+namespace GUI {
+
+using namespace Math;
+
+namespace {
+
+//fonts tried if requested one is not found
+const char * FALLBACK_FONTS[] = {
+	"DejaVuSans",
+	"LiberationSans-Regular",
+	"Arial",
+	"Verdana",
+	"Helvetica",
+};
+
+const char * FONT_EXTENSIONS[] = { ".ttf", ".otf" };
+
+const int SIMPLE_ON_CURVE		= 0x01;
+const int SIMPLE_X_SHORT		= 0x02;
+const int SIMPLE_Y_SHORT		= 0x04;
+const int SIMPLE_REPEAT			= 0x08;
+const int SIMPLE_X_SAME			= 0x10;
+const int SIMPLE_Y_SAME			= 0x20;
+
+const int COMPOSITE_ARGS_WORDS	= 0x0001;
+const int COMPOSITE_ARGS_XY		= 0x0002;
+const int COMPOSITE_SCALE		= 0x0008;
+const int COMPOSITE_MORE		= 0x0020;
+const int COMPOSITE_XY_SCALE	= 0x0040;
+const int COMPOSITE_2X2			= 0x0080;
+
+//font data is big endian, reads past end return zeros and fail reader
+struct Reader
+{
+	const byte * data;
+	uint32 length;
+	uint32 pos;
+	bool ok;
+
+	Reader(const byte * d, uint32 len, uint32 p): data(d), length(len), pos(p), ok(p <= len) {}
+
+	bool has(uint32 bytesNum)
+	{
+		if(!ok || pos + bytesNum > length)
+		{
+			ok = false;
+			return false;
+		}
+		return true;
+	}
+
+	byte u8()
+	{
+		return has(1) ? data[pos++] : 0;
+	}
+
+	uint16 u16()
+	{
+		if(!has(2)) return 0;
+		uint16 v = (uint16)((data[pos] << 8) | data[pos + 1]);
+		pos += 2;
+		return v;
+	}
+
+	int16 s16()		{ return (int16)u16(); }
+	uint32 u32()	{ uint32 hi = u16(); return (hi << 16) | u16(); }
+	float f2dot14()	{ return s16() / 16384.0f; }
+	void skip(uint32 bytesNum) { if(has(bytesNum)) pos += bytesNum; }
+};
+
+inline vec2 Transform(const float m[6], float x, float y)
+{
+	return vec2(m[0] * x + m[2] * y + m[4], m[1] * x + m[3] * y + m[5]);
+}
+
+uint64 HashFontSource(const std::string& fileName, size_t fileSize, time_t fileTime, float pixelSize)
+{
+	//FNV-1a
+	uint64 hash = 14695981039346656037ULL;
+	uint64 values[3] = { (uint64)fileSize, (uint64)fileTime, (uint64)(pixelSize * 64.0f) };
+	const byte * bytes[2] = { (const byte *)fileName.c_str(), (const byte *)values };
+	size_t sizes[2] = { fileName.length(), sizeof(values) };
+	for(int i = 0; i < 2; ++i)
+	{
+		for(size_t j = 0; j < sizes[i]; ++j)
+		{
+			hash ^= bytes[i][j];
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+}//namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// TrueTypeRasterizer
+
+TrueTypeRasterizer::TrueTypeRasterizer():
+	mData(NULL), mFont(NULL), mLength(0),
+	mGlyf(0), mLoca(0), mHmtx(0), mCmap(0), mCmapFormat(0), mLocaFormat(0), mGlyphsNum(0), mHMetricsNum(0),
+	mScale(0), mAscent(0), mDescent(0), mLineGap(0), mWidth(0), mHeight(0)
+{
+}
+
+TrueTypeRasterizer::~TrueTypeRasterizer()
+{
+	DELETE_PTR(mData);
+}
+
+bool TrueTypeRasterizer::init(Data * fontData, float pixelSize)
+{
+	DELETE_PTR(mData);
+	mData = fontData;
+	mFont = (const byte *)mData->getData();
+	mLength = (uint32)mData->getLength();
+
+	//collections and fonts with CFF outlines are not supported
+	Reader header(mFont, mLength, 0);
+	uint32 version = header.u32();
+	if(!header.ok || (version != 0x00010000 && version != 0x74727565))
+		return false;
+
+	uint32 head = findTable("head");
+	uint32 hhea = findTable("hhea");
+	uint32 maxp = findTable("maxp");
+	uint32 cmap = findTable("cmap");
+	mHmtx = findTable("hmtx");
+	mLoca = findTable("loca");
+	mGlyf = findTable("glyf");
+
+	if(!head || !hhea || !maxp || !cmap || !mHmtx || !mLoca || !mGlyf)
+		return false;
+
+	Reader headReader(mFont, mLength, head + 18);
+	uint16 unitsPerEm = headReader.u16();
+	headReader.pos = head + 50;
+	mLocaFormat = headReader.s16();
+
+	Reader hheaReader(mFont, mLength, hhea + 4);
+	int16 ascender = hheaReader.s16();
+	int16 descender = hheaReader.s16();
+	int16 lineGap = hheaReader.s16();
+	hheaReader.pos = hhea + 34;
+	mHMetricsNum = hheaReader.u16();
+
+	Reader maxpReader(mFont, mLength, maxp + 4);
+	mGlyphsNum = maxpReader.u16();
+
+	if(!headReader.ok || !hheaReader.ok || !maxpReader.ok || unitsPerEm == 0 || mHMetricsNum == 0)
+		return false;
+
+	mScale = pixelSize / unitsPerEm;
+	mAscent = ascender * mScale;
+	mDescent = -descender * mScale;
+	mLineGap = lineGap * mScale;
+
+	//unicode subtable, full repertoire preferred over basic plane
+	Reader cmapReader(mFont, mLength, cmap + 2);
+	uint16 tablesNum = cmapReader.u16();
+	int bestScore = 0;
+	for(uint16 i = 0; i < tablesNum && cmapReader.ok; ++i)
+	{
+		uint16 platform = cmapReader.u16();
+		uint16 encoding = cmapReader.u16();
+		uint32 offset = cmap + cmapReader.u32();
+
+		bool isUnicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+		if(!isUnicode)
+			continue;
+
+		Reader subtable(mFont, mLength, offset);
+		uint16 format = subtable.u16();
+		int score = format == 12 ? 2 : (format == 4 ? 1 : 0);
+		if(subtable.ok && score > bestScore)
+		{
+			bestScore = score;
+			mCmap = offset;
+			mCmapFormat = format;
+		}
+	}
+
+	return bestScore > 0;
+}
+
+uint32 TrueTypeRasterizer::findTable(const char * tag) const
+{
+	Reader reader(mFont, mLength, 4);
+	uint16 tablesNum = reader.u16();
+	for(uint16 i = 0; i < tablesNum; ++i)
+	{
+		reader.pos = 12 + i * 16;
+		if(!reader.has(16))
+			return 0;
+
+		if(memcmp(mFont + reader.pos, tag, 4) == 0)
+		{
+			reader.pos += 8;
+			uint32 offset = reader.u32();
+			uint32 length = reader.u32();
+			return (offset + length <= mLength) ? offset : 0;
+		}
+	}
+	return 0;
+}
+
+uint32 TrueTypeRasterizer::getGlyphIndex(uint32 code) const
+{
+	if(mCmapFormat == 12)
+	{
+		Reader reader(mFont, mLength, mCmap + 12);
+		uint32 groupsNum = reader.u32();
+
+		//groups are sorted by start code
+		uint32 low = 0, high = groupsNum;
+		while(low < high && reader.ok)
+		{
+			uint32 mid = (low + high) / 2;
+			reader.pos = mCmap + 16 + mid * 12;
+			uint32 startCode = reader.u32();
+			uint32 endCode = reader.u32();
+			uint32 startGlyph = reader.u32();
+
+			if(code < startCode)
+				high = mid;
+			else if(code > endCode)
+				low = mid + 1;
+			else
+				return reader.ok ? startGlyph + (code - startCode) : 0;
+		}
+		return 0;
+	}
+
+	if(code > 0xFFFF)
+		return 0;
+
+	Reader reader(mFont, mLength, mCmap + 6);
+	uint32 segmentsNum = reader.u16() / 2;
+	uint32 endCodes = mCmap + 14;
+	uint32 startCodes = endCodes + segmentsNum * 2 + 2;
+	uint32 idDeltas = startCodes + segmentsNum * 2;
+	uint32 idRangeOffsets = idDeltas + segmentsNum * 2;
+
+	//first segment which ends after code
+	uint32 low = 0, high = segmentsNum;
+	while(low < high)
+	{
+		uint32 mid = (low + high) / 2;
+		reader.pos = endCodes + mid * 2;
+		if(reader.u16() < code)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if(low >= segmentsNum)
+		return 0;
+
+	reader.pos = startCodes + low * 2;
+	uint16 startCode = reader.u16();
+	if(code < startCode)
+		return 0;
+
+	reader.pos = idDeltas + low * 2;
+	uint16 idDelta = reader.u16();
+	reader.pos = idRangeOffsets + low * 2;
+	uint16 idRangeOffset = reader.u16();
+
+	if(!reader.ok)
+		return 0;
+
+	if(idRangeOffset == 0)
+		return (code + idDelta) & 0xFFFF;
+
+	reader.pos = idRangeOffsets + low * 2 + idRangeOffset + (code - startCode) * 2;
+	uint16 glyph = reader.u16();
+	return (reader.ok && glyph != 0) ? (glyph + idDelta) & 0xFFFF : 0;
+}
+
+float TrueTypeRasterizer::getAdvance(uint32 glyph) const
+{
+	uint32 metric = minValue<uint32>(glyph, mHMetricsNum - 1);
+	Reader reader(mFont, mLength, mHmtx + metric * 4);
+	return reader.u16() * mScale;
+}
+
+bool TrueTypeRasterizer::getGlyphLocation(uint32 glyph, uint32& outOffset, uint32& outLength) const
+{
+	if(glyph >= (uint32)mGlyphsNum)
+		return false;
+
+	uint32 begin, end;
+	if(mLocaFormat == 0)
+	{
+		Reader reader(mFont, mLength, mLoca + glyph * 2);
+		begin = reader.u16() * 2;
+		end = reader.u16() * 2;
+		if(!reader.ok) return false;
+	}
+	else
+	{
+		Reader reader(mFont, mLength, mLoca + glyph * 4);
+		begin = reader.u32();
+		end = reader.u32();
+		if(!reader.ok) return false;
+	}
+
+	if(end < begin || mGlyf + end > mLength)
+		return false;
+
+	outOffset = mGlyf + begin;
+	outLength = end - begin;
+	return true;
+}
+
+bool TrueTypeRasterizer::hasGlyph(uint32 code) const
+{
+	return getGlyphIndex(code) != 0;
+}
+
+bool TrueTypeRasterizer::loadOutline(uint32 glyph, const float transform[6], int depth, Outline& outline) const
+{
+	uint32 offset, length;
+	if(!getGlyphLocation(glyph, offset, length))
+		return false;
+
+	//blank glyph
+	if(length == 0)
+		return true;
+
+	Reader reader(mFont, mLength, offset);
+	int16 contoursNum = reader.s16();
+	if(!reader.ok)
+		return false;
+
+	if(contoursNum >= 0)
+		return loadSimpleOutline(offset, length, transform, outline);
+
+	if(depth >= MAX_COMPOSITE_DEPTH)
+		return false;
+
+	return loadCompositeOutline(offset, length, transform, depth, outline);
+}
+
+bool TrueTypeRasterizer::loadSimpleOutline(uint32 offset, uint32 length, const float transform[6], Outline& outline) const
+{
+	Reader reader(mFont, offset + length, offset);
+	int contoursNum = reader.s16();
+	reader.skip(8);//bounds
+
+	int firstPoint = (int)outline.points.size();
+	int pointsNum = 0;
+	for(int i = 0; i < contoursNum; ++i)
+	{
+		pointsNum = reader.u16() + 1;
+		outline.contourEnds.push_back(firstPoint + pointsNum - 1);
+	}
+
+	reader.skip(reader.u16());//instructions
+
+	if(!reader.ok)
+		return false;
+
+	std::vector<byte> flags(pointsNum);
+	for(int i = 0; i < pointsNum && reader.ok; )
+	{
+		byte flag = reader.u8();
+		int repeatsNum = (flag & SIMPLE_REPEAT) ? reader.u8() : 0;
+		for(int r = 0; r <= repeatsNum && i < pointsNum; ++r)
+		{
+			flags[i++] = flag;
+		}
+	}
+
+	std::vector<int> xs(pointsNum);
+	int x = 0;
+	for(int i = 0; i < pointsNum; ++i)
+	{
+		if(flags[i] & SIMPLE_X_SHORT)
+			x += (flags[i] & SIMPLE_X_SAME) ? reader.u8() : -reader.u8();
+		else if(!(flags[i] & SIMPLE_X_SAME))
+			x += reader.s16();
+		xs[i] = x;
+	}
+
+	int y = 0;
+	for(int i = 0; i < pointsNum; ++i)
+	{
+		if(flags[i] & SIMPLE_Y_SHORT)
+			y += (flags[i] & SIMPLE_Y_SAME) ? reader.u8() : -reader.u8();
+		else if(!(flags[i] & SIMPLE_Y_SAME))
+			y += reader.s16();
+
+		outline.points.push_back(Transform(transform, (float)xs[i], (float)y));
+		outline.onCurve.push_back((flags[i] & SIMPLE_ON_CURVE) != 0);
+	}
+
+	return reader.ok;
+}
+
+bool TrueTypeRasterizer::loadCompositeOutline(uint32 offset, uint32 length, const float transform[6], int depth, Outline& outline) const
+{
+	Reader reader(mFont, offset + length, offset + 10);
+
+	uint16 flags = 0;
+	do
+	{
+		flags = reader.u16();
+		uint16 glyph = reader.u16();
+
+		float dx = 0, dy = 0;
+		if(flags & COMPOSITE_ARGS_WORDS)
+		{
+			dx = reader.s16();
+			dy = reader.s16();
+		}
+		else
+		{
+			dx = (int8)reader.u8();
+			dy = (int8)reader.u8();
+		}
+
+		//components aligned by matching points are placed without offset
+		if(!(flags & COMPOSITE_ARGS_XY))
+		{
+			dx = dy = 0;
+		}
+
+		float a = 1, b = 0, c = 0, d = 1;
+		if(flags & COMPOSITE_SCALE)
+		{
+			a = d = reader.f2dot14();
+		}
+		else if(flags & COMPOSITE_XY_SCALE)
+		{
+			a = reader.f2dot14();
+			d = reader.f2dot14();
+		}
+		else if(flags & COMPOSITE_2X2)
+		{
+			a = reader.f2dot14();
+			b = reader.f2dot14();
+			c = reader.f2dot14();
+			d = reader.f2dot14();
+		}
+
+		if(!reader.ok)
+			return false;
+
+		const float * m = transform;
+		float component[6] = {
+			m[0] * a + m[2] * b,		m[1] * a + m[3] * b,
+			m[0] * c + m[2] * d,		m[1] * c + m[3] * d,
+			m[0] * dx + m[2] * dy + m[4],	m[1] * dx + m[3] * dy + m[5]
+		};
+
+		if(!loadOutline(glyph, component, depth + 1, outline))
+			return false;
+	}
+	while(flags & COMPOSITE_MORE);
+
+	return true;
+}
+
+bool TrueTypeRasterizer::rasterize(uint32 code, Bitmap& outBitmap)
+{
+	uint32 glyph = getGlyphIndex(code);
+	if(glyph == 0)
+		return false;
+
+	outBitmap.advance = getAdvance(glyph);
+	outBitmap.width = outBitmap.height = 0;
+	outBitmap.left = outBitmap.top = 0;
+	outBitmap.alpha.clear();
+
+	//outline is scaled to pixels with y up
+	float transform[6] = { mScale, 0, 0, mScale, 0, 0 };
+
+	Outline outline;
+	if(!loadOutline(glyph, transform, 0, outline))
+		return false;
+
+	if(outline.points.empty())
+		return true;
+
+	//curves are inside of hull of their control points
+	vec2 minPoint = outline.points[0];
+	vec2 maxPoint = outline.points[0];
+	for(size_t i = 1; i < outline.points.size(); ++i)
+	{
+		minPoint.x = minValue(minPoint.x, outline.points[i].x);
+		minPoint.y = minValue(minPoint.y, outline.points[i].y);
+		maxPoint.x = maxValue(maxPoint.x, outline.points[i].x);
+		maxPoint.y = maxValue(maxPoint.y, outline.points[i].y);
+	}
+
+	outBitmap.left = (int)floorf(minPoint.x);
+	outBitmap.top = (int)ceilf(maxPoint.y);
+	outBitmap.width = (int)ceilf(maxPoint.x) - outBitmap.left;
+	outBitmap.height = outBitmap.top - (int)floorf(minPoint.y);
+
+	if(outBitmap.width <= 0 || outBitmap.height <= 0)
+	{
+		outBitmap.width = outBitmap.height = 0;
+		return true;
+	}
+
+	//to bitmap space, y down
+	for(size_t i = 0; i < outline.points.size(); ++i)
+	{
+		outline.points[i].x = outline.points[i].x - outBitmap.left;
+		outline.points[i].y = outBitmap.top - outline.points[i].y;
+	}
+
+	drawOutline(outline, outBitmap.width, outBitmap.height);
+
+	//running sum of area gives coverage, winding direction does not matter
+	int pixelsNum = outBitmap.width * outBitmap.height;
+	outBitmap.alpha.resize(pixelsNum);
+	float coverage = 0;
+	for(int i = 0; i < pixelsNum; ++i)
+	{
+		coverage += mAccumulation[i];
+		float alpha = minValue(fabsf(coverage), 1.0f);
+		outBitmap.alpha[i] = (byte)(alpha * 255.0f + 0.5f);
+	}
+
+	return true;
+}
+
+void TrueTypeRasterizer::drawOutline(const Outline& outline, int width, int height)
+{
+	mWidth = width;
+	mHeight = height;
+
+	//lines may end at right border, their area lands in first pixel of next row
+	mAccumulation.assign(width * height + 4, 0.0f);
+
+	int contourStart = 0;
+	for(size_t c = 0; c < outline.contourEnds.size(); ++c)
+	{
+		int contourEnd = outline.contourEnds[c];
+		int pointsNum = contourEnd - contourStart + 1;
+		if(pointsNum < 2 || contourEnd >= (int)outline.points.size())
+		{
+			contourStart = contourEnd + 1;
+			continue;
+		}
+
+		const vec2 * points = &outline.points[contourStart];
+
+		//contour is started from on-curve point, implied one if both ends are off-curve
+		vec2 start;
+		int first = 0, last = pointsNum - 1;
+		if(outline.onCurve[contourStart])
+		{
+			start = points[0];
+			first = 1;
+		}
+		else if(outline.onCurve[contourEnd])
+		{
+			start = points[pointsNum - 1];
+			last = pointsNum - 2;
+		}
+		else
+		{
+			start = (points[0] + points[pointsNum - 1]) * 0.5f;
+		}
+
+		vec2 current = start;
+		vec2 control;
+		bool hasControl = false;
+
+		for(int i = first; i <= last; ++i)
+		{
+			const vec2& point = points[i];
+
+			if(outline.onCurve[contourStart + i])
+			{
+				if(hasControl)
+					drawQuadratic(current, control, point);
+				else
+					drawLine(current, point);
+
+				current = point;
+				hasControl = false;
+			}
+			else
+			{
+				if(hasControl)
+				{
+					//two off-curve points imply on-curve one between them
+					vec2 middle = (control + point) * 0.5f;
+					drawQuadratic(current, control, middle);
+					current = middle;
+				}
+
+				control = point;
+				hasControl = true;
+			}
+		}
+
+		if(hasControl)
+			drawQuadratic(current, control, start);
+		else
+			drawLine(current, start);
+
+		contourStart = contourEnd + 1;
+	}
+}
+
+void TrueTypeRasterizer::drawQuadratic(const vec2& p0, const vec2& p1, const vec2& p2)
+{
+	vec2 deviation = p0 - p1 * 2.0f + p2;
+	float deviationSq = deviation.lenSquared();
+	if(deviationSq < 0.333f)
+	{
+		drawLine(p0, p2);
+		return;
+	}
+
+	//segments number keeps flattening error under tenth of pixel
+	int segmentsNum = 1 + (int)floorf(sqrtf(sqrtf(3.0f * deviationSq)));
+
+	vec2 prev = p0;
+	for(int i = 1; i <= segmentsNum; ++i)
+	{
+		float t = (float)i / segmentsNum;
+		float it = 1.0f - t;
+		vec2 point = p0 * (it * it) + p1 * (2.0f * it * t) + p2 * (t * t);
+		drawLine(prev, point);
+		prev = point;
+	}
+}
+
+void TrueTypeRasterizer::drawLine(const vec2& from, const vec2& to)
+{
+	if(fabsf(from.y - to.y) <= 1e-6f)
+		return;
+
+	//area is signed by direction of line
+	float dir = 1.0f;
+	vec2 p0 = from, p1 = to;
+	if(p0.y > p1.y)
+	{
+		dir = -1.0f;
+		p0 = to;
+		p1 = from;
+	}
+
+	float dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+	float x = p0.x;
+	if(p0.y < 0)
+		x -= p0.y * dxdy;
+
+	int yEnd = minValue(mHeight, (int)ceilf(p1.y));
+	for(int y = maxValue(0, (int)p0.y); y < yEnd; ++y)
+	{
+		int lineStart = y * mWidth;
+		float dy = minValue((float)(y + 1), p1.y) - maxValue((float)y, p0.y);
+		float xNext = x + dxdy * dy;
+		float d = dy * dir;
+
+		float x0 = minValue(x, xNext);
+		float x1 = maxValue(x, xNext);
+		float x0Floor = floorf(x0);
+		int x0i = (int)x0Floor;
+		float x1Ceil = ceilf(x1);
+		int x1i = (int)x1Ceil;
+
+		if(lineStart + x0i < 0 || lineStart + x1i + 1 >= (int)mAccumulation.size())
+		{
+			x = xNext;
+			continue;
+		}
+
+		float * acc = &mAccumulation[lineStart];
+
+		if(x1i <= x0i + 1)
+		{
+			//line is within one pixel column
+			float xmf = 0.5f * (x + xNext) - x0Floor;
+			acc[x0i] += d - d * xmf;
+			acc[x0i + 1] += d * xmf;
+		}
+		else
+		{
+			float s = 1.0f / (x1 - x0);
+			float x0f = x0 - x0Floor;
+			float a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+			float x1f = x1 - x1Ceil + 1.0f;
+			float am = 0.5f * s * x1f * x1f;
+
+			acc[x0i] += d * a0;
+
+			if(x1i == x0i + 2)
+			{
+				acc[x0i + 1] += d * (1.0f - a0 - am);
+			}
+			else
+			{
+				float a1 = s * (1.5f - x0f);
+				acc[x0i + 1] += d * (a1 - a0);
+				for(int xi = x0i + 2; xi < x1i - 1; ++xi)
+				{
+					acc[xi] += d * s;
+				}
+				float a2 = a1 + (x1i - x0i - 3) * s;
+				acc[x1i - 1] += d * (1.0f - a2 - am);
+			}
+
+			acc[x1i] += d * am;
+		}
+
+		x = xNext;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// TrueTypeFontGenerator
+
+TrueTypeFontGenerator::TrueTypeFontGenerator()
+{
+}
+
+TrueTypeFontGenerator::~TrueTypeFontGenerator()
+{
+}
+
+void TrueTypeFontGenerator::addFontsFolder(const std::string& folder)
+{
+	mFolders.push_back(folder);
+}
+
+std::string TrueTypeFontGenerator::findFontFile(const std::string& name, Font::Style style) const
+{
+	std::vector<std::string> names;
+	if(style == Font::BOLD)
+	{
+		names.push_back(name + "-Bold");
+		names.push_back(name + "bd");
+		names.push_back(name + "Bold");
+	}
+	names.push_back(name);
+	names.push_back(name + "-Regular");
+
+	for(size_t f = 0; f < mFolders.size(); ++f)
+	{
+		for(size_t n = 0; n < names.size(); ++n)
+		{
+			for(size_t e = 0; e < sizeof(FONT_EXTENSIONS) / sizeof(FONT_EXTENSIONS[0]); ++e)
+			{
+				std::string fileName = FileSystem::Path::Combine(mFolders[f], names[n] + FONT_EXTENSIONS[e]);
+				if(FileSystem::FileStorage::IsFileExist(fileName.c_str()))
+					return fileName;
+			}
+		}
+	}
+
+	return "";
+}
+
+Font * TrueTypeFontGenerator::create(const char * name, int size, Font::Style style)
+{
+	std::vector<std::string> fileNames;
+
+	std::string fileName = findFontFile(name, style);
+	bool found = !fileName.empty();
+	if(found)
+		fileNames.push_back(fileName);
+
+	for(size_t i = 0; i < sizeof(FALLBACK_FONTS) / sizeof(FALLBACK_FONTS[0]); ++i)
+	{
+		fileName = findFontFile(FALLBACK_FONTS[i], style);
+		if(!fileName.empty())
+			fileNames.push_back(fileName);
+	}
+
+	float pixelSize = size * (float)DPI / 72.0f;
+
+	for(size_t i = 0; i < fileNames.size(); ++i)
+	{
+		Data * data = new Data(fileNames[i].c_str());
+		if(!data->isOk())
+		{
+			DELETE_PTR(data);
+			continue;
+		}
+
+		size_t fileSize = data->getLength();
+
+		TrueTypeRasterizer * rasterizer = new TrueTypeRasterizer();
+		if(!rasterizer->init(data, pixelSize))
+		{
+			Log::Instance().warning("TrueTypeFontGenerator::create", ("Unsupported font file " + fileNames[i]).c_str());
+			DELETE_PTR(rasterizer);
+			continue;
+		}
+
+		if(i > 0 || !found)
+		{
+			Log::Instance().stream("TrueTypeFontGenerator::create", Log::sevWarning) << "Font " << name << " is not found, " << fileNames[i] << " is used";
+		}
+
+		std::string cacheFile;
+		if(!mCacheFolder.empty())
+		{
+			char suffix[32];
+			sprintf(suffix, "_%d%s.sqglyphs", size, style == Font::BOLD ? "b" : "");
+			cacheFile = FileSystem::Path::Combine(mCacheFolder, FileSystem::Path::GetFileNameWithoutExtension(fileNames[i]) + suffix);
+		}
+
+		time_t fileTime = FileSystem::FileStorage::GetFileModificationTime(fileNames[i].c_str());
+
+		Font * font = new Font();
+		font->mName = name;
+		font->mPointSize = (float)size;
+		font->initAtlas(rasterizer, cacheFile, HashFontSource(fileNames[i], fileSize, fileTime, pixelSize));
+
+		return font;
+	}
+
+	Log::Instance().stream("TrueTypeFontGenerator::create", Log::sevError) << "No font file is found for " << name;
+	return NULL;
+}
+
+}//namespace GUI {
+}//namespace Squirrel {
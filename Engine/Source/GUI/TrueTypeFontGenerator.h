@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Font.h"
+#include <Common/Data.h>
+#include <Math/vec2.h>
+#include <string>
+#include <vector>
+
+namespace Squirrel {
+namespace GUI {
+
+//Rasterizes quadratic outlines of TrueType fonts (glyf table), hinting is not applied.
+//Coverage is computed analytically by accumulating signed area of outline edges per pixel.
+class SQGUI_API TrueTypeRasterizer:
+	public GlyphRasterizer
+{
+	static const int MAX_COMPOSITE_DEPTH = 8;
+
+	struct Outline
+	{
+		std::vector<Math::vec2>	points;
+		std::vector<bool>		onCurve;
+		std::vector<int>		contourEnds;
+	};
+
+public:
+	TrueTypeRasterizer();
+	virtual ~TrueTypeRasterizer();
+
+	//takes ownership of font data, pixel size is size of em square
+	bool init(Data * fontData, float pixelSize);
+
+	virtual float getAscent() const		{ return mAscent; }
+	virtual float getDescent() const	{ return mDescent; }
+	virtual float getLineGap() const	{ return mLineGap; }
+
+	virtual bool hasGlyph(uint32 code) const;
+	virtual bool rasterize(uint32 code, Bitmap& outBitmap);
+
+private:
+
+	uint32 findTable(const char * tag) const;
+	uint32 getGlyphIndex(uint32 code) const;
+	float getAdvance(uint32 glyph) const;
+
+	bool getGlyphLocation(uint32 glyph, uint32& outOffset, uint32& outLength) const;
+	bool loadOutline(uint32 glyph, const float transform[6], int depth, Outline& outline) const;
+	bool loadSimpleOutline(uint32 offset, uint32 length, const float transform[6], Outline& outline) const;
+	bool loadCompositeOutline(uint32 offset, uint32 length, const float transform[6], int depth, Outline& outline) const;
+
+	void drawOutline(const Outline& outline, int width, int height);
+	void drawQuadratic(const Math::vec2& p0, const Math::vec2& p1, const Math::vec2& p2);
+	void drawLine(const Math::vec2& p0, const Math::vec2& p1);
+
+private:
+
+	Data * mData;
+	const byte * mFont;
+	uint32 mLength;
+
+	uint32 mGlyf;
+	uint32 mLoca;
+	uint32 mHmtx;
+	uint32 mCmap;//offset of used subtable
+	int mCmapFormat;
+	int mLocaFormat;
+	int mGlyphsNum;
+	int mHMetricsNum;
+
+	float mScale;//pixels per font unit
+	float mAscent;
+	float mDescent;
+	float mLineGap;
+
+	//signed area accumulated per pixel while drawing outline
+	std::vector<float> mAccumulation;
+	int mWidth;
+	int mHeight;
+};
+
+//Makes fonts from TrueType files found in font folders. Glyphs are baked on demand,
+//baked atlases are stored in cache folder and reused if font file has not changed.
+class SQGUI_API TrueTypeFontGenerator:
+	public FontGenerator
+{
+public:
+
+	static const int DPI = 96;
+
+	TrueTypeFontGenerator();
+	virtual ~TrueTypeFontGenerator();
+
+	virtual Font * create(const char * name, int size, Font::Style style);
+
+	//folders are searched in order of adding, then fallback fonts are tried
+	void addFontsFolder(const std::string& folder);
+	void setCacheFolder(const std::string& folder) { mCacheFolder = folder; }
+
+private:
+
+	std::string findFontFile(const std::string& name, Font::Style style) const;
+
+	std::vector<std::string> mFolders;
+	std::string mCacheFolder;
+};
+
+}//namespace GUI {
+}//namespace Squirrel {
@@ -228,6 +228,12 @@ bool AABB::intersects(const AABB& box) const
 	return true;
 }
 
+bool AABB::contains(const AABB& box) const
+{
+	return	min.x <= box.min.x && min.y <= box.min.y && min.z <= box.min.z &&
+			max.x >= box.max.x && max.y >= box.max.y && max.z >= box.max.z;
+}
+
 bool AABB::intersects(const vec3& pt) const
 {
 	if((pt.x>max.x)||(pt.x<min.x)) return false;
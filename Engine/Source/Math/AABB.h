@@ -58,6 +58,8 @@ public:
 	bool intersects(const AABB& box) const;
 	bool intersects(const vec3& pt) const;
 	bool intersects(const vec3& sphereCenter, float sphereRadius) const;
+
+	bool contains(const AABB& box) const;
 };
 
 } //namespace Math {
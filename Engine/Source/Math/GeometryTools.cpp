@@ -325,6 +325,129 @@ vec3 closestPointOnLine(vec3 a, vec3 b, vec3 p)
 	return ( a + V );
 }
 
+vec3 closestPointOnTriangle(vec3 a, vec3 b, vec3 c, vec3 p)
+{
+	//check voronoi regions of vertices, edges and face (Ericson, Real-Time Collision Detection)
+	vec3 ab = b - a;
+	vec3 ac = c - a;
+	vec3 ap = p - a;
+
+	float d1 = ab * ap;
+	float d2 = ac * ap;
+	if(d1 <= 0.0f && d2 <= 0.0f)
+		return a;
+
+	vec3 bp = p - b;
+	float d3 = ab * bp;
+	float d4 = ac * bp;
+	if(d3 >= 0.0f && d4 <= d3)
+		return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return a + ab * (d1 / (d1 - d3));
+
+	vec3 cp = p - c;
+	float d5 = ab * cp;
+	float d6 = ac * cp;
+	if(d6 >= 0.0f && d5 <= d6)
+		return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+float rayTriangleIntersection(vec3 rO, vec3 rV, vec3 v0, vec3 v1, vec3 v2)
+{
+	vec3 edge1 = v1 - v0;
+	vec3 edge2 = v2 - v0;
+
+	vec3 p = rV ^ edge2;
+	float det = edge1 * p;
+
+	if(det > -EPSILON_SQUARED && det < EPSILON_SQUARED)
+		return -1.0f;
+
+	float invDet = 1.0f / det;
+
+	vec3 s = rO - v0;
+	float u = (s * p) * invDet;
+	if(u < 0.0f || u > 1.0f)
+		return -1.0f;
+
+	vec3 q = s ^ edge1;
+	float v = (rV * q) * invDet;
+	if(v < 0.0f || u + v > 1.0f)
+		return -1.0f;
+
+	return (edge2 * q) * invDet;
+}
+
+void closestPointsOnSegments(vec3 p1, vec3 q1, vec3 p2, vec3 q2, vec3 &c1, vec3 &c2)
+{
+	vec3 d1 = q1 - p1;
+	vec3 d2 = q2 - p2;
+	vec3 r = p1 - p2;
+
+	float a = d1 * d1;
+	float e = d2 * d2;
+	float f = d2 * r;
+
+	float s = 0.0f, t = 0.0f;
+
+	if(a <= EPSILON_SQUARED && e <= EPSILON_SQUARED)
+	{
+		c1 = p1;
+		c2 = p2;
+		return;
+	}
+
+	if(a <= EPSILON_SQUARED)
+	{
+		t = clamp(f / e, 0.0f, 1.0f);
+	}
+	else
+	{
+		float c = d1 * r;
+		if(e <= EPSILON_SQUARED)
+		{
+			s = clamp(-c / a, 0.0f, 1.0f);
+		}
+		else
+		{
+			float b = d1 * d2;
+			float denom = a * e - b * b;
+
+			if(denom != 0.0f)
+				s = clamp((b * f - c * e) / denom, 0.0f, 1.0f);
+
+			t = (b * s + f) / e;
+
+			if(t < 0.0f)
+			{
+				t = 0.0f;
+				s = clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if(t > 1.0f)
+			{
+				t = 1.0f;
+				s = clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+
+	c1 = p1 + d1 * s;
+	c2 = p2 + d2 * t;
+}
+
 ///////////////////////////////// EDGE SPHERE COLLSIION """"""""""\\*
 /////	ÓÔÂ‰ÂÎˇÂÚ, ÔÂÂÒÂÍ‡ÂÚ ÎË ÒÙÂ‡ Í‡ÍÓÂ-ÎË·Ó Â·Ó ÚÂÛ„ÓÎ¸ÌËÍ‡
 bool edgeSphereCollision(vec3 center,
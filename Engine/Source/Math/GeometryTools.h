@@ -34,6 +34,16 @@ SQMATH_API vec3 __cdecl getNormalToTriangle( vec3 poly[] );
 // This returns the point on the line segment vA_vB that is closest to point vPoint
 SQMATH_API vec3 __cdecl closestPointOnLine(vec3 vA, vec3 vB, vec3 point);
 
+// This returns the point of triangle v0_v1_v2 that is closest to point
+SQMATH_API vec3 __cdecl closestPointOnTriangle(vec3 v0, vec3 v1, vec3 v2, vec3 point);
+
+// Moller-Trumbore ray/triangle test, triangle edges are inclusive;
+// returns distance along ray in units of rV length or negative value if there is no intersection
+SQMATH_API float __cdecl rayTriangleIntersection(vec3 rO, vec3 rV, vec3 v0, vec3 v1, vec3 v2);
+
+// This returns closest points of segments p1_q1 and p2_q2
+SQMATH_API void __cdecl closestPointsOnSegments(vec3 p1, vec3 q1, vec3 p2, vec3 q2, vec3 &c1, vec3 &c2);
+
 // Orthogonalization of vectors with Gram-Schmidt method;
 // returns v2 orthogonalized to v1
 SQMATH_API vec3 __cdecl orthogonalize( const vec3& v1, const vec3& v2 );
@@ -0,0 +1,41 @@
+#include "BufferMemory.h"
+#include <atomic>
+
+namespace Squirrel {
+
+namespace RenderData { 
+
+namespace {
+
+std::atomic<int64> sMemory[BufferMemory::bmNum];
+
+const char * sNames[BufferMemory::bmNum] = {
+	"GPU static vertices",
+	"GPU dynamic vertices",
+	"GPU static indices",
+	"GPU dynamic indices",
+	"CPU vertices",
+	"CPU indices",
+	"collision mirrors"
+};
+
+}//namespace {
+
+void BufferMemory::Add(Category category, int64 bytes)
+{
+	sMemory[category].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+int64 BufferMemory::Get(Category category)
+{
+	return sMemory[category].load(std::memory_order_relaxed);
+}
+
+const char * BufferMemory::GetName(Category category)
+{
+	return sNames[category];
+}
+
+}//namespace RenderData { 
+
+}//namespace Squirrel {
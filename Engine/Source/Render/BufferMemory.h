@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Common/types.h>
+#include "macros.h"
+
+namespace Squirrel {
+
+namespace RenderData { 
+
+//Memory taken by vertex and index buffers per category, in bytes
+class SQRENDER_API BufferMemory
+{
+public:
+
+	enum Category
+	{
+		bmGPUStaticVertices = 0,
+		bmGPUDynamicVertices,
+		bmGPUStaticIndices,
+		bmGPUDynamicIndices,
+		bmCPUVertices,//CPU side copies
+		bmCPUIndices,
+		bmCollisionMirrors,//compact positions and indices kept for CPU queries
+		bmNum
+	};
+
+public:
+
+	static void Add(Category category, int64 bytes);
+
+	static int64 Get(Category category);
+
+	static const char * GetName(Category category);
+};
+
+}//namespace RenderData { 
+
+}//namespace Squirrel {
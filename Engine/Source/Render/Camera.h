@@ -56,6 +56,7 @@ public://methods
 	vec3 project(vec3 worldPoint, tuple4i viewport) const;
 
 	//getters
+	inline EType		getType(void)		const	{ return mType;	}
 	inline float		getFov(void)		const	{ return mFov;	}
 	inline float		getAspect(void)		const	{ return mAspect;	}
 	inline float		getViewHeight(void)	const	{ return mSize;	}
@@ -25,7 +25,7 @@ public:
 	};
 
 public:
-	IBuffer() : mStorageType(stGPUStaticMemory), mCPUBuffer(NULL) {};
+	IBuffer() : mStorageType(stGPUStaticMemory), mCPUBuffer(NULL), mPinned(false) {};
 	virtual ~IBuffer () {};
 	
 	virtual bool map(bool read, bool write) = 0;
@@ -36,12 +36,22 @@ public:
 	inline StorageType	getStorageType()				{ return mStorageType; }
 	inline void			setStorageType(StorageType st)	{ mStorageType = st; }
 
+	//CPU copy of static buffer is released once it is uploaded to GPU unless buffer is pinned,
+	//pin buffers which are read or modified on CPU after first render
+	inline bool			isPinned()						{ return mPinned; }
+	inline void			setPinned(bool pinned)			{ mPinned = pinned; }
+
+	//frees CPU copy, buffer content is accessible through map after that
+	virtual void releaseCPUCopy() = 0;
+
 protected:
 
 	StorageType	mStorageType;
 
 	byte* mCPUBuffer;
 
+	bool	mPinned;
+
 };
 
 
@@ -3,6 +3,7 @@
 #include <Common/macros.h>
 #include "macros.h"
 #include <set>
+#include <mutex>
 
 #ifdef	_WIN32
 //	disable warning on extern before template instantiation
@@ -32,16 +33,22 @@ public:
 		//ASSERT(mPool == NULL);
 	}
 
+	//objects may be created by resource loader threads, so pools are guarded;
+	//generate/destroy of such objects must not touch context (e.g. buffers are generated lazily)
 	void setPool(OBJECTS_POOL * pool)
 	{
 		if(mPool != NULL)
 		{
 			destroy();
+			std::unique_lock<std::mutex> lock(sPoolsMutex);
 			mPool->erase(this);
 		}
 		if((mPool = pool) != NULL)
 		{
-			mPool->insert(this);
+			{
+				std::unique_lock<std::mutex> lock(sPoolsMutex);
+				mPool->insert(this);
+			}
 			generate();
 		}
 	}
@@ -51,6 +58,8 @@ public:
 
 private:
 
+	static std::mutex sPoolsMutex;
+
 	OBJECTS_POOL * mPool;
 
 };
@@ -40,6 +40,9 @@ public:
 	
 	virtual void setColorAttachmentsNum(int colorAttachmentsNum) = 0;
 
+	//copies depth attachment into depth attachment of target of the same size
+	virtual bool copyDepthTo ( IFrameBuffer * target ) = 0;
+
 	virtual ITexture * getAttachement(int no = 0) = 0;
 		
 	enum								// flags for depth and stencil buffers
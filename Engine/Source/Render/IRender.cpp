@@ -9,6 +9,8 @@ UniformString IRender::sModelviewMatrixUniformName	("uModelViewMatrix");
 UniformString IRender::sMVPMatrixUniformName		("uMVPMatrix");
 UniformString IRender::sNormalMatrixUniformName		("uNormalMatrix");
 
+std::mutex IContextObject::sPoolsMutex;
+
 IRender * IRender::sActiveRender = NULL;
 tuple2i IRender::sScreenSize = tuple2i(0, 0);
 
@@ -71,6 +71,7 @@ Image::Image(void)
 	mLevels		= 1;
 	mFaces		= 1;
 	mDepthType	= Volume;
+	mSkippedLevels	= 0;
 }
 
 Image::Image(uint32 w, uint32 h, uint32 d, DataType dataType, Format format)
@@ -86,6 +87,8 @@ Image::Image(uint32 w, uint32 h, uint32 d, DataType dataType, Format format)
 	mFaces		= 1;
 	mDepthType	= Volume;
 	mContentType= Colors;
+	mSkippedLevels	= 0;
+	mStoredSize	= tuple3i(w, h, d);
 
 	size_t pixNum	= w * h * d;
 	size_t pixSize	= getComponentsNum() * getComponentSize();
@@ -114,6 +117,8 @@ Image::Image(	uint32 w, uint32 h, uint32 d,
 	mLevels		= 1;
 	mDepthType	= Volume;
 	mContentType= Colors;
+	mSkippedLevels	= 0;
+	mStoredSize	= tuple3i(w, h, d);
 
 	//disable cubemap for depth
 	cubemap = cubemap && d == 1 && w == h;
@@ -648,7 +653,20 @@ bool Image::save(Data * data)
 	return true;
 }
 
+uint32 Image::getStoredLevelSize(uint32 storedLevel)
+{
+	uint32 w = Math::maxValue(mStoredSize.x >> storedLevel, 1);
+	uint32 h = Math::maxValue(mStoredSize.y >> storedLevel, 1);
+	uint32 d = Math::maxValue(mStoredSize.z >> storedLevel, 1);
+	return calcCompressedDataSize(w, h, d) * mFaces;
+}
+
 bool Image::load(Data * data)
+{
+	return load(data, 0, 0);
+}
+
+bool Image::load(Data * data, uint32 firstLevel, uint32 maxSize)
 {
 	uint32 i, j;
 
@@ -677,10 +695,38 @@ bool Image::load(Data * data)
 	mLevels		= static_cast<uint32>(header.levels);
 	mFaces		= static_cast<uint32>(header.faces);
 
+	mStoredSize	= tuple3i(mWidth, mHeight, mDepth);
+
+	//largest levels to skip
+	uint32 lastSkipped = mLevels > 1 ? mLevels - 2 : 0;
+	mSkippedLevels = Math::minValue(firstLevel, lastSkipped);
+	if(maxSize > 0)
+	{
+		while(mSkippedLevels < lastSkipped && (Math::maxValue(mWidth, mHeight) >> mSkippedLevels) > maxSize)
+		{
+			++mSkippedLevels;
+		}
+	}
+
     uint32			w		= getWidth();
     uint32			h		= getHeight();
 	uint32			d		= getDepth();
 
+	//mapped file is not touched by skipped levels
+	for(i = 0; i < mSkippedLevels; ++i)
+	{
+		data->seekCur( calcCompressedDataSize(w, h, d) * mFaces );
+
+		w = ( w > 1) ? w >> 1 : 1;
+		h = ( h > 1) ? h >> 1 : 1;
+	    d = ( d > 1) ? d >> 1 : 1;
+	}
+
+	mWidth	= w;
+	mHeight	= h;
+	mDepth	= d;
+	mLevels	-= mSkippedLevels;
+
 	for(i = 0; i < mLevels; ++i)
 	{
 		size_t dataSize = calcCompressedDataSize(w, h, d);
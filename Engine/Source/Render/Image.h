@@ -150,6 +150,23 @@ public:
 	bool load(Data * data);
 	bool save(Data * data);
 
+	//loads native image without its largest levels: ones before first level and ones larger than max size (if not 0),
+	//at least two levels of mipmapped image are loaded, so it is not taken for image without mipmaps
+	bool load(Data * data, uint32 firstLevel, uint32 maxSize = 0);
+
+	//levels of stored image which were not loaded, see load
+	inline uint32		getSkippedLevelsNum() const
+		{ return mSkippedLevels; }
+
+	inline uint32		getStoredLevelsNum() const
+		{ return mSkippedLevels + mLevels; }
+
+	inline const tuple3i&	getStoredSize() const
+		{ return mStoredSize; }
+
+	//bytes of all faces of stored level (first loaded level is getSkippedLevelsNum)
+	uint32 getStoredLevelSize(uint32 storedLevel);
+
 	void swapYZ();
 
 private:
@@ -185,6 +202,11 @@ private:
 
     uint32		mLevels;
 
+	//partially loaded image
+	uint32		mSkippedLevels;
+
+	tuple3i		mStoredSize;
+
 	LEVELS_VEC	mData;
 
 	static int sDownsampleLimit;
@@ -1,4 +1,5 @@
 #include "IndexBuffer.h"
+#include "BufferMemory.h"
 
 namespace Squirrel {
 
@@ -13,9 +14,16 @@ IndexBuffer::IndexBuffer(uint indNum, IndexSize indexSize)
 
 IndexBuffer::~IndexBuffer()
 {
-	if(mIndices!=0)
+	releaseCPUCopy();
+}
+
+void IndexBuffer::releaseCPUCopy()
+{
+	if(mIndices != NULL)
 	{
-		delete[]mIndices;
+		BufferMemory::Add(BufferMemory::bmCPUIndices, -(int64)(mIndexSize * mIndNum));
+		delete[] mIndices;
+		mIndices = NULL;
 	}
 }
 
@@ -74,6 +82,7 @@ void IndexBuffer::allocate(uint indNum, IndexSize indexSize)
 	mIndexSize = indexSize;
 	mIndNum = indNum;
 	mIndices = new byte[indexSize * indNum];
+	BufferMemory::Add(BufferMemory::bmCPUIndices, indexSize * indNum);
 }
 
 
@@ -55,6 +55,8 @@ public:
 	//otherwise returns index of index which has too big value
 	int checkIndices(uint32 maxIndexValue);
 
+	virtual void releaseCPUCopy();
+
 	inline uint			getIndicesNum()		{ return mIndNum; }
 	inline IndexSize	getIndexSize()		{ return mIndexSize; }
 	inline byte*		getIndexBuff()		{ return mIndices; }
@@ -150,7 +150,10 @@ bool MaterialGroup::sameMaterial(const MaterialGroup& otherMatGroup) const
 }
 	
 RenderQueue::RenderQueue(void):
-	mTempMaterialGroup(NULL)
+	mTempMaterialGroup(NULL),
+	mMaterialGroupsPool("Material groups"),
+	mVBGroupsPool("VB groups"),
+	mIndexPrimitivesPool("Index primitives")
 {
 }
 	
@@ -11,6 +11,7 @@
 #include <list>
 #include <set>
 #include <common/ObjectsPool.h>
+#include <common/StlAllocators.h>
 
 namespace Squirrel {
 
@@ -70,7 +71,7 @@ struct SQRENDER_API VBGroup {
 		clear();
 	}
 
-	typedef std::list<IndexPrimitive*>		INDEX_PRIMS_LIST;
+	typedef std::list<IndexPrimitive*, PoolStlAllocator<IndexPrimitive*> >		INDEX_PRIMS_LIST;
 
 	INDEX_PRIMS_LIST	mIndexPrimitives;
 
@@ -134,9 +135,10 @@ struct ReflectionDesc
 
 struct SQRENDER_API MaterialGroup {
 
-	typedef std::map<HashString, ITexture *> TEXTURES_MAP;
+	typedef std::map<HashString, ITexture *, std::less<HashString>,
+		PoolStlAllocator<std::pair<const HashString, ITexture *> > > TEXTURES_MAP;
 
-	typedef std::list<VBGroup*>		VB_GROUPS_LIST;
+	typedef std::list<VBGroup*, PoolStlAllocator<VBGroup*> >		VB_GROUPS_LIST;
 
 	MaterialGroup():
 		mMaterial(NULL), mRequiresReflection(false),
@@ -168,8 +170,8 @@ struct SQRENDER_API MaterialGroup {
 	{
 		clear();
 
-		mProgramName = "";
-		mProgramParams = "";
+		mProgramName.clear();
+		mProgramParams.clear();
 		mUniformsPool.clear();
 
 		mMaterial = NULL;
@@ -241,9 +243,11 @@ public:
 	RenderQueue(void);
 	~RenderQueue(void);
 
-	typedef std::list<Light*>				LIGHTS_LIST;
-	typedef std::list<RenderOp>				RENDER_OPS_LIST;
-	typedef std::set<ReflectionDesc>		REFL_DESCS_SET;
+	//nodes of queue lists are taken from NodePool as queue is refilled every frame
+	typedef std::list<Light*, PoolStlAllocator<Light*> >					LIGHTS_LIST;
+	typedef std::list<RenderOp, PoolStlAllocator<RenderOp> >				RENDER_OPS_LIST;
+	typedef std::set<ReflectionDesc, std::less<ReflectionDesc>,
+		PoolStlAllocator<ReflectionDesc> >									REFL_DESCS_SET;
 
 	LIGHTS_LIST& getLights() { return mLights; }
 
@@ -264,7 +268,7 @@ public:
 
 private:
 
-	typedef std::list<MaterialGroup*>		MAT_GROUPS_LIST;
+	typedef std::list<MaterialGroup*, PoolStlAllocator<MaterialGroup*> >		MAT_GROUPS_LIST;
 	
 	MAT_GROUPS_LIST				mMaterialGroups;
 
@@ -9,7 +9,7 @@ namespace RenderData {
 //TODO: deprecate m_bAreVertsExternal as external VB realized through Model<->Mesh
 VertexBuffer::VertexBuffer(int vertType, size_t vertNum, byte *pVerts):
 		mVertType(vertType), mVertNum(vertNum), mVertSize(0), mVCNum(0), 
-		mVerts(pVerts)
+		mVerts(pVerts), mPositionScale(1, 1, 1), mPositionBias(0, 0, 0), mTexcoordDecode(1, 1, 0, 0)
 {
 	memset(&mVCSizes, 0, sizeof(mVCSizes));
 	memset(&mVCOffsets, 0, sizeof(mVCOffsets));
@@ -31,9 +31,14 @@ VertexBuffer::VertexBuffer(int vertType, size_t vertNum, byte *pVerts):
 	ADD_VC(vc4BoneWeights);
 	ADD_VC(vc2BoneWeights);
 	ADD_VC(vcColor);
+	ADD_VC(vcInt16Position);
+	ADD_VC(vcOctNormal);
+	ADD_VC(vcOctTangentBinormal);
+	ADD_VC(vc4Int8BoneWeights);
 	
 	size_t szVertsSize = mVertSize*mVertNum;
 	mVerts = new byte[szVertsSize];
+	BufferMemory::Add(BufferMemory::bmCPUVertices, szVertsSize);
 	if(pVerts!=NULL)
 	{
 		memcpy(mVerts, pVerts, szVertsSize);
@@ -42,6 +47,15 @@ VertexBuffer::VertexBuffer(int vertType, size_t vertNum, byte *pVerts):
 
 VertexBuffer::~VertexBuffer(void)
 {
+	releaseCPUCopy();
+}
+
+void VertexBuffer::releaseCPUCopy()
+{
+	if(mVerts != NULL)
+	{
+		BufferMemory::Add(BufferMemory::bmCPUVertices, -(int64)(mVertSize * mVertNum));
+	}
 	DELETE_ARR(mVerts);
 }
 
@@ -75,7 +89,7 @@ size_t VertexBuffer::Copy(VertexBuffer * src, VertexBuffer * dst)
 void VertexBuffer::MoveContent(VertexBuffer * src, VertexBuffer * dst)
 {
 	//move vertex data
-	DELETE_ARR( dst->mVerts );
+	dst->releaseCPUCopy();
 	dst->mVerts = src->mVerts;
 	src->mVerts = 0;
 
@@ -87,6 +101,9 @@ void VertexBuffer::MoveContent(VertexBuffer * src, VertexBuffer * dst)
 	dst->mVCNum		= src->mVCNum;
 	memcpy(&dst->mVCOffsets,	&src->mVCOffsets,	sizeof(src->mVCOffsets));
 	memcpy(&dst->mVCSizes,		&src->mVCSizes,		sizeof(src->mVCSizes));
+	dst->mPositionScale		= src->mPositionScale;
+	dst->mPositionBias		= src->mPositionBias;
+	dst->mTexcoordDecode	= src->mTexcoordDecode;
 	//skip mStorageType
 }
 
@@ -104,6 +121,8 @@ void VertexBuffer::resize(size_t szNewVertNum)
 
 	DELETE_ARR(mVerts);
 
+	BufferMemory::Add(BufferMemory::bmCPUVertices, (int64)szNewBufferSize - (int64)szOldBufferSize);
+
 	mVerts = pNewVerts;
 	mVertNum = szNewVertNum;
 }
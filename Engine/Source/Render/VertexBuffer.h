@@ -7,6 +7,7 @@
 #include <cstring>
 #include "macros.h"
 #include "IBuffer.h"
+#include "BufferMemory.h"
 
 namespace Squirrel {
 
@@ -77,7 +78,7 @@ private:
 //
 
 	//vertex component types
-	typedef	LOKI_TYPELIST_6(Math::vec3, Math::vec2, tuple2i, tuple2s, tuple4b, Math::vec4) TL_VERTEX_COMP_TYPES;
+	typedef	LOKI_TYPELIST_8(Math::vec3, Math::vec2, tuple2i, tuple2s, tuple4b, Math::vec4, tuple4ub, tuple4s) TL_VERTEX_COMP_TYPES;
 
 public:
 
@@ -90,7 +91,9 @@ public:
 		vctVec2i,
 		vctVec2s,
 		vctVec4b,
-		vctVec4
+		vctVec4,
+		vctVec4ub,
+		vctVec4s
 	};
 
 	//vertex component index
@@ -113,6 +116,10 @@ public:
 		vc4BoneWeights,
 		vc2BoneWeights,
 		vcColor,
+		vcInt16Position,//xyz relative to bounds, see getPositionDecode
+		vcOctNormal,//octahedral encoded, snorm16
+		vcOctTangentBinormal,//xy is octahedral encoded tangent, z is binormal sign, snorm8
+		vc4Int8BoneWeights,//unorm8
 		vcNum
 	};
 
@@ -192,6 +199,11 @@ public:
 		return sizeof(typename VCTAccessor<iComponent>::VCType);
 	}
 
+	inline size_t getComponentSize(int iComponent) const
+	{
+		return mVCSizes[iComponent];
+	}
+
 	inline bool	hasComponent(int iComp) const
 	{ 
 		return mVCSizes[iComp] > 0;
@@ -199,6 +211,27 @@ public:
 
 	void resize(size_t szNewVertNum);
 
+	virtual void releaseCPUCopy();
+
+	//packed components are dequantized as stored * scale + bias,
+	//texcoord decode keeps scale in xy and bias in zw
+	inline void setPositionDecode(const Math::vec3& scale, const Math::vec3& bias)	{ mPositionScale = scale; mPositionBias = bias; }
+	inline void setTexcoordDecode(const Math::vec4& decode)	{ mTexcoordDecode = decode; }
+
+	inline const Math::vec3& getPositionScale()	const	{ return mPositionScale; }
+	inline const Math::vec3& getPositionBias()	const	{ return mPositionBias; }
+	inline const Math::vec4& getTexcoordDecode()	const	{ return mTexcoordDecode; }
+
+	//packed vertices have octahedral normals and need decoding in shader,
+	//their positions and texcoords are always dequantized with decode params
+	inline bool isPacked() const
+	{
+		return hasComponent(vcOctNormal);
+	}
+
+	//position of vertex whether it is stored as float or packed
+	inline Math::vec3 getPosition(int index) const;
+
 	inline size_t	getVertexSize()	const	{ return mVertSize; }
 	inline size_t	getVertsNum()	const	{ return mVertNum; }
 	inline int		getVertType()	const	{ return mVertType; }
@@ -232,6 +265,10 @@ private:
 	size_t	mVertSize;
 	int		mVCNum;
 
+	Math::vec3	mPositionScale;
+	Math::vec3	mPositionBias;
+	Math::vec4	mTexcoordDecode;
+
 	size_t	mVCOffsets[vcNum];
 	size_t	mVCSizes[vcNum];
 };
@@ -270,6 +307,25 @@ template <>
 struct VertexBuffer::VC2CTMapper< VertexBuffer::vc2BoneWeights	>		{ enum { type = VertexBuffer::vctVec2 }; };
 template <>
 struct VertexBuffer::VC2CTMapper< VertexBuffer::vcColor	>				{ enum { type = VertexBuffer::vctVec4 }; };
+template <>
+struct VertexBuffer::VC2CTMapper< VertexBuffer::vcInt16Position	>		{ enum { type = VertexBuffer::vctVec4s }; };
+template <>
+struct VertexBuffer::VC2CTMapper< VertexBuffer::vcOctNormal	>			{ enum { type = VertexBuffer::vctVec2s }; };
+template <>
+struct VertexBuffer::VC2CTMapper< VertexBuffer::vcOctTangentBinormal	>	{ enum { type = VertexBuffer::vctVec4b }; };
+template <>
+struct VertexBuffer::VC2CTMapper< VertexBuffer::vc4Int8BoneWeights	>	{ enum { type = VertexBuffer::vctVec4ub }; };
+
+inline Math::vec3 VertexBuffer::getPosition(int index) const
+{
+	if(!hasComponent(vcInt16Position))
+		return getComponent<vcPosition>(index);
+
+	const tuple4s& p = getComponent<vcInt16Position>(index);
+	return Math::vec3(p.x * mPositionScale.x + mPositionBias.x,
+					p.y * mPositionScale.y + mPositionBias.y,
+					p.z * mPositionScale.z + mPositionBias.z);
+}
 
 
 }//namespace RenderData { 
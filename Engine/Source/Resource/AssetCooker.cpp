@@ -0,0 +1,722 @@
+#include "AssetCooker.h"
+#include "Program.h"
+#include "ModelStorage.h"
+#include "TextureStorage.h"
+#include <FileSystem/Path.h>
+#include <Common/TaskPool.h>
+#include <Common/Profiler.h>
+#include <Common/Log.h>
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <stdio.h>
+
+namespace Squirrel {
+
+namespace Resource {
+
+using namespace RenderData;
+
+namespace {
+
+const char_t * MANIFEST_FILE = "cook.manifest";
+
+const int32 MANIFEST_KEY		= 0x4B4F4F43;//"COOK"
+const int32 MANIFEST_VERSION	= 1;
+
+const uint64 HASH_PRIME = 1099511628211ULL;
+
+std::string GetLowerExtension(const std::string& fileName)
+{
+	std::string ext = FileSystem::Path::GetExtension(fileName);
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+	return ext;
+}
+
+std::string HashToString(uint64 hash)
+{
+	char str[17];
+	sprintf(str, "%08x%08x", (uint32)(hash >> 32), (uint32)hash);
+	return str;
+}
+
+uint64 HashString(const std::string& str, uint64 hash)
+{
+	//terminator separates concatenated strings
+	return AssetCooker::HashBytes(str.c_str(), str.length() + 1, hash);
+}
+
+float NanosecondsToMs(uint64 ns)
+{
+	return (float)((double)ns / 1000000.0);
+}
+
+}//namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// AssetCooker build state
+
+struct AssetCooker::Task
+{
+	std::string		sourceFile;
+	CookerEntry *	cooker;
+	ManifestEntry	entry;
+	AssetReport		report;
+};
+
+struct AssetCooker::BuildContext
+{
+	AssetCooker *		owner;
+	std::vector<Task>	tasks;
+
+	std::mutex			mutex;
+	std::map<std::string, uint64> depHashes;
+	std::set<uint64>	cookingHashes;//cooked by other task right now
+};
+
+//////////////////////////////////////////////////////////////////////////
+// AssetCooker::Report
+
+AssetCooker::Report::Report():
+	upToDateNum(0), cacheHitsNum(0), cookedNum(0), failedNum(0), totalMs(0)
+{
+}
+
+float AssetCooker::Report::getHitRate() const
+{
+	if(assets.empty())
+		return 1.0f;
+
+	return (float)(upToDateNum + cacheHitsNum) / (float)assets.size();
+}
+
+void AssetCooker::Report::log() const
+{
+	const char_t * statusNames[] = { "up to date", "cache hit", "cooked", "FAILED" };
+
+	for(size_t i = 0; i < assets.size(); ++i)
+	{
+		const AssetReport& asset = assets[i];
+
+		if(asset.status == asFailed)
+		{
+			Log::Instance().streamError("AssetCooker") << asset.sourceFile << ": " << asset.error;
+			Log::Instance().flush();
+			continue;
+		}
+
+		Log::Instance().stream("AssetCooker", Log::sevInformation) << asset.sourceFile << " -> " << asset.cookedFile
+			<< " (" << statusNames[asset.status] << ", " << asset.ms << " ms)";
+	}
+
+	Log::Instance().stream("AssetCooker", Log::sevImportantMessage) << assets.size() << " assets in " << totalMs << " ms: "
+		<< upToDateNum << " up to date, " << cacheHitsNum << " cache hits, " << cookedNum << " cooked, " << failedNum << " failed; "
+		<< "hit rate " << (getHitRate() * 100.0f) << "%";
+}
+
+//////////////////////////////////////////////////////////////////////////
+// AssetCooker
+
+AssetCooker::AssetCooker(FileStorage * sourceStorage, const std::string& cacheFolder):
+	mSourceStorage(sourceStorage), mManifestLoaded(false), mIncremental(true)
+{
+	mCacheStorage.reset( FileSystem::FileStorageFactory::GetFolderForPath(cacheFolder) );
+}
+
+AssetCooker::~AssetCooker()
+{
+	for(COOKERS_MAP::iterator it = mCookers.begin(); it != mCookers.end(); ++it)
+	{
+		DELETE_PTR(it->second.cooker);
+		DELETE_PTR(it->second.mutex);
+	}
+}
+
+uint64 AssetCooker::HashBytes(const void * data, size_t size, uint64 hash)
+{
+	//FNV-1a
+	const byte * bytes = (const byte *)data;
+	for(size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= HASH_PRIME;
+	}
+	return hash;
+}
+
+void AssetCooker::addCooker(const char_t * sourceExtension, Cooker * cooker)
+{
+	std::string ext = sourceExtension;
+	std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+	COOKERS_MAP::iterator it = mCookers.find(ext);
+	if(it != mCookers.end())
+	{
+		DELETE_PTR(it->second.cooker);
+		it->second.cooker = cooker;
+		return;
+	}
+
+	CookerEntry entry;
+	entry.cooker = cooker;
+	entry.mutex = new std::mutex;
+	mCookers[ext] = entry;
+}
+
+AssetCooker::Cooker * AssetCooker::getCooker(const std::string& sourceFile)
+{
+	COOKERS_MAP::iterator it = mCookers.find( GetLowerExtension(sourceFile) );
+	return it != mCookers.end() ? it->second.cooker : NULL;
+}
+
+void AssetCooker::addSource(const std::string& sourceFile)
+{
+	if(std::find(mSources.begin(), mSources.end(), sourceFile) == mSources.end())
+	{
+		mSources.push_back(sourceFile);
+	}
+}
+
+int AssetCooker::addSources(const char_t * location, bool recursive)
+{
+	std::auto_ptr<FileStorage> tempFolder;
+
+	FileStorage * storage = mSourceStorage;
+	if(storage == NULL)
+	{
+		tempFolder.reset( FileSystem::FileStorageFactory::GetFolderForPath("") );
+		storage = tempFolder.get();
+	}
+
+	//content list is refreshed by nested calls
+	std::list<FileSystem::FileInfo> files = storage->getContent(location);
+
+	int addedNum = 0;
+
+	FOREACH(std::list<FileSystem::FileInfo>::const_iterator, itFile, files)
+	{
+		const FileSystem::FileInfo& fileInfo = *itFile;
+
+		if(fileInfo.name == "." || fileInfo.name == "..")
+			continue;
+
+		if(fileInfo.isFolder)
+		{
+			if(recursive && !fileInfo.isHidden)
+				addedNum += addSources(fileInfo.path.c_str(), recursive);
+			continue;
+		}
+
+		if(getCooker(fileInfo.name) != NULL)
+		{
+			addSource(fileInfo.path);
+			++addedNum;
+		}
+	}
+
+	return addedNum;
+}
+
+std::string AssetCooker::getCookedFile(const std::string& sourceFile) const
+{
+	MANIFEST_MAP::const_iterator it = mManifest.find(sourceFile);
+	return it != mManifest.end() ? it->second.cookedFile : "";
+}
+
+Data * AssetCooker::readSource(const std::string& fileName)
+{
+	Data * data = NULL;
+
+	if(mSourceStorage != NULL)
+	{
+		data = mSourceStorage->supportsMappedFiles() ?
+			mSourceStorage->getMappedFile(fileName) :
+			mSourceStorage->getFile(fileName);
+	}
+	else
+	{
+		data = new Data(fileName.c_str(), true, true);
+	}
+
+	if(data != NULL && !data->isOk())
+	{
+		DELETE_PTR(data);
+	}
+
+	return data;
+}
+
+int64 AssetCooker::getSourceTimestamp(const std::string& fileName)
+{
+	if(mSourceStorage != NULL)
+	{
+		return (int64)mSourceStorage->getFileModificationTime(fileName);
+	}
+
+	return (int64)FileStorage::GetFileModificationTime(fileName.c_str());
+}
+
+bool AssetCooker::isUpToDate(const std::string& sourceFile, const Cooker * cooker)
+{
+	MANIFEST_MAP::const_iterator it = mManifest.find(sourceFile);
+	if(it == mManifest.end())
+		return false;
+
+	const ManifestEntry& entry = it->second;
+
+	//settings or cooker changed
+	if(entry.settingsHash != HashString(cooker->getSettingsKey(), HashString(cooker->getCookedExtension(), HASH_SEED)))
+		return false;
+
+	int64 timestamp = getSourceTimestamp(sourceFile);
+	if(timestamp == 0 || timestamp != entry.timestamp)
+		return false;
+
+	for(size_t i = 0; i < entry.deps.size(); ++i)
+	{
+		if(getSourceTimestamp(entry.deps[i].fileName) != entry.deps[i].timestamp)
+			return false;
+	}
+
+	return mCacheStorage->hasFile(entry.cookedFile);
+}
+
+uint64 AssetCooker::getDependencyHash(BuildContext& ctx, const std::string& fileName)
+{
+	{
+		std::unique_lock<std::mutex> lock(ctx.mutex);
+		std::map<std::string, uint64>::const_iterator it = ctx.depHashes.find(fileName);
+		if(it != ctx.depHashes.end())
+			return it->second;
+	}
+
+	//missing dependency is hashed by name, so its appearance changes hash
+	uint64 hash = HashString(fileName, HASH_SEED);
+
+	Data * data = readSource(fileName);
+	if(data != NULL)
+	{
+		hash = HashBytes(data->getData(), data->getLength(), hash);
+		DELETE_PTR(data);
+	}
+
+	std::unique_lock<std::mutex> lock(ctx.mutex);
+	ctx.depHashes[fileName] = hash;
+	return hash;
+}
+
+void AssetCooker::processSource(BuildContext& ctx, Task& task)
+{
+	SQ_PROFILE_FUNCTION();
+
+	uint64 begin = Profiler::Now();
+
+	AssetReport& report = task.report;
+	report.sourceFile	= task.sourceFile;
+	report.hash			= 0;
+	report.status		= asFailed;
+	report.ms			= 0;
+
+	if(task.cooker == NULL)
+	{
+		report.error = "no cooker for extension";
+		return;
+	}
+
+	Cooker * cooker = task.cooker->cooker;
+
+	if(mIncremental && isUpToDate(task.sourceFile, cooker))
+	{
+		task.entry			= mManifest.find(task.sourceFile)->second;
+		report.cookedFile	= task.entry.cookedFile;
+		report.hash			= task.entry.hash;
+		report.status		= asUpToDate;
+		report.ms			= NanosecondsToMs(Profiler::Now() - begin);
+		return;
+	}
+
+	ManifestEntry& entry = task.entry;
+	entry.timestamp = getSourceTimestamp(task.sourceFile);
+
+	Data * source = readSource(task.sourceFile);
+	if(source == NULL)
+	{
+		report.error = "failed to read source";
+		return;
+	}
+
+	std::unique_lock<std::mutex> cookerLock(*task.cooker->mutex, std::defer_lock);
+	if(!cooker->isThreadSafe())
+		cookerLock.lock();
+
+	std::vector<std::string> deps;
+	cooker->collectDependencies(task.sourceFile, source, deps);
+
+	entry.settingsHash = HashString(cooker->getSettingsKey(), HashString(cooker->getCookedExtension(), HASH_SEED));
+
+	uint64 hash = HashBytes(source->getData(), source->getLength(), entry.settingsHash);
+	for(size_t i = 0; i < deps.size(); ++i)
+	{
+		uint64 depHash = getDependencyHash(ctx, deps[i]);
+		hash = HashBytes(&depHash, sizeof(depHash), hash);
+
+		DependencyState depState;
+		depState.fileName	= deps[i];
+		depState.timestamp	= getSourceTimestamp(deps[i]);
+		entry.deps.push_back(depState);
+	}
+
+	entry.hash			= hash;
+	entry.cookedFile	= HashToString(hash) + "." + cooker->getCookedExtension();
+
+	report.hash			= hash;
+	report.cookedFile	= entry.cookedFile;
+
+	bool cookedByOther = false;
+	{
+		std::unique_lock<std::mutex> lock(ctx.mutex);
+		cookedByOther = !ctx.cookingHashes.insert(hash).second;
+	}
+
+	if(cookedByOther || mCacheStorage->hasFile(entry.cookedFile))
+	{
+		report.status = asCacheHit;
+	}
+	else
+	{
+		Data output(NULL, (size_t)1024);
+
+		if(!cooker->cook(task.sourceFile, source, &output))
+		{
+			report.error = "cooking failed";
+		}
+		else if(!mCacheStorage->putFile(&output, entry.cookedFile))
+		{
+			report.error = "failed to write " + entry.cookedFile;
+		}
+		else
+		{
+			report.status = asCooked;
+		}
+	}
+
+	DELETE_PTR(source);
+
+	report.ms = NanosecondsToMs(Profiler::Now() - begin);
+}
+
+void AssetCooker::ProcessSources(void * context, int begin, int end)
+{
+	BuildContext * ctx = (BuildContext *)context;
+
+	for(int i = begin; i < end; ++i)
+	{
+		ctx->owner->processSource(*ctx, ctx->tasks[i]);
+	}
+}
+
+bool AssetCooker::build(Report& outReport)
+{
+	SQ_PROFILE_FUNCTION();
+
+	uint64 begin = Profiler::Now();
+
+	if(!mManifestLoaded)
+	{
+		loadManifest();
+		mManifestLoaded = true;
+	}
+
+	BuildContext ctx;
+	ctx.owner = this;
+	ctx.tasks.resize(mSources.size());
+
+	for(size_t i = 0; i < mSources.size(); ++i)
+	{
+		Task& task = ctx.tasks[i];
+		task.sourceFile = mSources[i];
+
+		COOKERS_MAP::iterator it = mCookers.find( GetLowerExtension(mSources[i]) );
+		task.cooker = it != mCookers.end() ? &it->second : NULL;
+	}
+
+	//one source per chunk, cooking times differ a lot
+	TaskPool::Default()->parallelFor((int)ctx.tasks.size(), 1, ProcessSources, &ctx);
+
+	outReport = Report();
+	outReport.assets.reserve(ctx.tasks.size());
+
+	for(size_t i = 0; i < ctx.tasks.size(); ++i)
+	{
+		const Task& task = ctx.tasks[i];
+
+		switch(task.report.status)
+		{
+		case asUpToDate:	++outReport.upToDateNum;	break;
+		case asCacheHit:	++outReport.cacheHitsNum;	break;
+		case asCooked:		++outReport.cookedNum;		break;
+		default:			++outReport.failedNum;		break;
+		}
+
+		//failed sources keep their last good state
+		if(task.report.status != asFailed)
+		{
+			mManifest[task.sourceFile] = task.entry;
+		}
+
+		outReport.assets.push_back(task.report);
+	}
+
+	if(!saveManifest())
+	{
+		Log::Instance().warning("AssetCooker::build", "Failed to save cooking manifest, next build will check all sources");
+	}
+
+	outReport.totalMs = NanosecondsToMs(Profiler::Now() - begin);
+
+	return outReport.failedNum == 0;
+}
+
+bool AssetCooker::loadManifest()
+{
+	mManifest.clear();
+
+	Data * data = mCacheStorage->getFile(MANIFEST_FILE);
+	if(data == NULL)
+		return false;
+
+	bool isOk = data->getLength() >= 2 * sizeof(int32) &&
+		data->readInt32() == MANIFEST_KEY &&
+		data->readInt32() == MANIFEST_VERSION;
+
+	if(isOk)
+	{
+		int32 entriesNum = data->readInt32();
+		for(int32 i = 0; i < entriesNum && !data->isEmpty(); ++i)
+		{
+			std::string sourceFile = data->readString();
+
+			ManifestEntry& entry = mManifest[sourceFile];
+			entry.timestamp		= data->readInt64();
+			entry.settingsHash	= data->readUInt64();
+			entry.hash			= data->readUInt64();
+			entry.cookedFile	= data->readString();
+
+			int32 depsNum = data->readInt32();
+			entry.deps.resize(depsNum);
+			for(int32 j = 0; j < depsNum; ++j)
+			{
+				entry.deps[j].fileName	= data->readString();
+				entry.deps[j].timestamp	= data->readInt64();
+			}
+		}
+	}
+
+	DELETE_PTR(data);
+
+	return isOk;
+}
+
+bool AssetCooker::saveManifest()
+{
+	Data data(NULL, (size_t)1024);
+	data.setCapacityIncrement(1024 * 16);
+
+	data.putInt32(MANIFEST_KEY);
+	data.putInt32(MANIFEST_VERSION);
+	data.putInt32((int32)mManifest.size());
+
+	for(MANIFEST_MAP::const_iterator it = mManifest.begin(); it != mManifest.end(); ++it)
+	{
+		const ManifestEntry& entry = it->second;
+
+		data.putString(it->first);
+		data.putInt64(entry.timestamp);
+		data.putUInt64(entry.settingsHash);
+		data.putUInt64(entry.hash);
+		data.putString(entry.cookedFile);
+
+		data.putInt32((int32)entry.deps.size());
+		for(size_t j = 0; j < entry.deps.size(); ++j)
+		{
+			data.putString(entry.deps[j].fileName);
+			data.putInt64(entry.deps[j].timestamp);
+		}
+	}
+
+	return mCacheStorage->putFile(&data, MANIFEST_FILE);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ShaderCooker
+
+namespace {
+
+//reads includes from storage and records their names
+class IncludeLoader:
+	public Program::SourceLoader
+{
+	FileStorage * mStorage;
+	std::vector<std::string> * mIncludes;
+
+public:
+	IncludeLoader(FileStorage * storage, std::vector<std::string> * includes):
+		mStorage(storage), mIncludes(includes) {}
+
+	virtual std::string loadSource(const char_t * sourceFile, StoredObject * relativeTo = NULL)
+	{
+		if(mIncludes)
+			mIncludes->push_back(sourceFile);
+
+		Data * data = mStorage != NULL ? mStorage->getFile(sourceFile) : new Data(sourceFile);
+		if(data != NULL && !data->isOk())
+		{
+			DELETE_PTR(data);
+		}
+
+		if(data == NULL)
+			return "";
+
+		std::string source((const char_t *)data->getData(), data->getLength());
+		DELETE_PTR(data);
+		return source;
+	}
+};
+
+}//namespace {
+
+ShaderCooker::ShaderCooker(FileStorage * includeStorage):
+	mIncludeStorage(includeStorage)
+{
+}
+
+ShaderCooker::~ShaderCooker()
+{
+}
+
+const char_t * ShaderCooker::getCookedExtension() const
+{
+	return "glsl";
+}
+
+bool ShaderCooker::preprocess(Data * source, std::string& outSource, std::vector<std::string> * outIncludes)
+{
+	IncludeLoader loader(mIncludeStorage, outIncludes);
+
+	//program resolves includes the same way as at runtime
+	Program program;
+	program.setSourceLoader(&loader);
+	program.load(source);
+
+	outSource = program.getSource();
+	return true;
+}
+
+void ShaderCooker::collectDependencies(const std::string& sourceFile, Data * source, std::vector<std::string>& outDeps)
+{
+	std::string preprocessed;
+	preprocess(source, preprocessed, &outDeps);
+}
+
+bool ShaderCooker::cook(const std::string& sourceFile, Data * source, Data * output)
+{
+	std::string preprocessed;
+	if(!preprocess(source, preprocessed, NULL))
+		return false;
+
+	output->putData(preprocessed.c_str(), preprocessed.length());
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ImageCooker
+
+namespace {
+	//image library keeps global state, shared by all image cookers
+	std::mutex sImageLoaderMutex;
+}
+
+ImageCooker::ImageCooker(bool buildMipmaps):
+	mBuildMipmaps(buildMipmaps)
+{
+}
+
+ImageCooker::~ImageCooker()
+{
+}
+
+const char_t * ImageCooker::getCookedExtension() const
+{
+	return TextureStorage::NativeTextureExtension();
+}
+
+std::string ImageCooker::getSettingsKey() const
+{
+	return mBuildMipmaps ? "mipmaps" : "";
+}
+
+bool ImageCooker::cook(const std::string& sourceFile, Data * source, Data * output)
+{
+	Image * image = NULL;
+	{
+		std::unique_lock<std::mutex> lock(sImageLoaderMutex);
+		image = mImageLoader.loadImage(source);
+	}
+
+	if(image == NULL)
+		return false;
+
+	if(mBuildMipmaps && image->getLevelsNum() == 1)
+	{
+		image->buildMipMaps();
+	}
+
+	output->setCapacityIncrement(1024 * 64);
+	bool isOk = image->save(output);
+
+	DELETE_PTR(image);
+
+	return isOk;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// ModelCooker
+
+ModelCooker::ModelCooker(IModelImporter * importer, const std::string& settingsKey):
+	mImporter(importer), mSettingsKey(settingsKey)
+{
+}
+
+ModelCooker::~ModelCooker()
+{
+}
+
+const char_t * ModelCooker::getCookedExtension() const
+{
+	return ModelStorage::NativeModelExtension();
+}
+
+std::string ModelCooker::getSettingsKey() const
+{
+	return std::string(mImporter->getImportingExtension()) + ";" + mSettingsKey;
+}
+
+bool ModelCooker::cook(const std::string& sourceFile, Data * source, Data * output)
+{
+	if(!mImporter->load(source))
+		return false;
+
+	Model * model = mImporter->getModel();
+	if(model == NULL)
+		return false;
+
+	bool isOk = ModelStorage::SaveModel(model, output);
+
+	DELETE_PTR(model);
+
+	return isOk;
+}
+
+}//namespace Resource {
+
+}//namespace Squirrel {
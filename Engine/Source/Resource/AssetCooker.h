@@ -0,0 +1,238 @@
+#pragma once
+
+#include "ResourceStorage.h"
+#include "ImageLoader.h"
+#include "ModelImporter.h"
+#include <vector>
+#include <map>
+#include <mutex>
+
+namespace Squirrel {
+
+namespace Resource {
+
+//Offline conversion of source assets to native formats.
+//Cooked outputs are cached by content hash of source, its dependencies and cooker settings,
+//so same content is never cooked twice; incremental build skips sources which files
+//and dependencies did not change since last build without reading them.
+class SQRESOURCE_API AssetCooker
+{
+public://nested types
+
+	//converts sources of one kind, registered by source extension
+	class SQRESOURCE_API Cooker
+	{
+	public:
+		Cooker() {}
+		virtual ~Cooker() {}
+
+		//extension of cooked files
+		virtual const char_t * getCookedExtension() const = 0;
+
+		//settings affecting cooked output, they are part of content hash
+		virtual std::string getSettingsKey() const { return ""; }
+
+		//files which content goes to cooked output of source, their changes re-cook source
+		virtual void collectDependencies(const std::string& sourceFile, Data * source, std::vector<std::string>& outDeps) {}
+
+		virtual bool cook(const std::string& sourceFile, Data * source, Data * output) = 0;
+
+		//cookers which are not thread safe are called by one thread at a time
+		virtual bool isThreadSafe() const { return true; }
+	};
+
+	enum AssetStatus
+	{
+		asUpToDate = 0,//source and dependencies are not modified since last build
+		asCacheHit,//modified but content with same hash is cooked already
+		asCooked,
+		asFailed
+	};
+
+	struct AssetReport
+	{
+		std::string	sourceFile;
+		std::string	cookedFile;//name in cache folder
+		uint64		hash;
+		AssetStatus	status;
+		float		ms;
+		std::string	error;
+	};
+
+	struct SQRESOURCE_API Report
+	{
+		Report();
+
+		//ratio of sources which did not need cooking
+		float getHitRate() const;
+
+		//writes summary and per asset lines to log
+		void log() const;
+
+		std::vector<AssetReport> assets;
+
+		int		upToDateNum;
+		int		cacheHitsNum;
+		int		cookedNum;
+		int		failedNum;
+		float	totalMs;
+	};
+
+	static const uint64 HASH_SEED = 14695981039346656037ULL;
+
+private:
+
+	struct DependencyState
+	{
+		std::string	fileName;
+		int64		timestamp;
+	};
+
+	//state of source after last build, persisted in manifest
+	struct ManifestEntry
+	{
+		int64	timestamp;
+		uint64	settingsHash;//of cooker extension and settings key
+		uint64	hash;
+		std::string	cookedFile;
+		std::vector<DependencyState> deps;
+	};
+
+	typedef std::map<std::string, ManifestEntry> MANIFEST_MAP;
+
+	struct CookerEntry
+	{
+		Cooker *	cooker;
+		std::mutex *	mutex;
+	};
+
+	typedef std::map<std::string, CookerEntry> COOKERS_MAP;
+
+	struct Task;
+	struct BuildContext;
+
+public:
+	//sourceStorage may be NULL then sources are opened by their names, it is not owned;
+	//cacheFolder must exist
+	AssetCooker(FileStorage * sourceStorage, const std::string& cacheFolder);
+	~AssetCooker();
+
+	//takes ownership of cooker
+	void addCooker(const char_t * sourceExtension, Cooker * cooker);
+	Cooker * getCooker(const std::string& sourceFile);
+
+	void addSource(const std::string& sourceFile);
+
+	//adds files of location with registered extensions, returns number of added sources
+	int addSources(const char_t * location, bool recursive = true);
+
+	void clearSources() { mSources.clear(); }
+
+	//not incremental build checks content hash of every source
+	void setIncremental(bool incremental) { mIncremental = incremental; }
+	bool isIncremental() const { return mIncremental; }
+
+	//cooks sources in parallel, returns false if any of them failed
+	bool build(Report& outReport);
+
+	//cooked file in cache folder for source of last build, empty if it is unknown
+	std::string getCookedFile(const std::string& sourceFile) const;
+
+	FileStorage * getCacheStorage() { return mCacheStorage.get(); }
+
+	static uint64 HashBytes(const void * data, size_t size, uint64 hash = HASH_SEED);
+
+private:
+
+	Data * readSource(const std::string& fileName);
+	int64 getSourceTimestamp(const std::string& fileName);
+
+	bool isUpToDate(const std::string& sourceFile, const Cooker * cooker);
+
+	//hash of dependency content, computed once per build
+	uint64 getDependencyHash(BuildContext& ctx, const std::string& fileName);
+
+	//hashes source and cooks it unless it is up to date or cached
+	void processSource(BuildContext& ctx, Task& task);
+
+	static void ProcessSources(void * context, int begin, int end);
+
+	bool loadManifest();
+	bool saveManifest();
+
+private:
+
+	FileStorage * mSourceStorage;
+	std::auto_ptr<FileStorage> mCacheStorage;
+
+	COOKERS_MAP mCookers;
+
+	std::vector<std::string> mSources;
+
+	MANIFEST_MAP mManifest;
+	bool mManifestLoaded;
+
+	bool mIncremental;
+};
+
+//Resolves includes of shader programs, includes are dependencies
+class SQRESOURCE_API ShaderCooker:
+	public AssetCooker::Cooker
+{
+	FileStorage * mIncludeStorage;
+
+public:
+	//includeStorage is storage of ProgramStorage, NULL to open includes by their names
+	ShaderCooker(FileStorage * includeStorage);
+	virtual ~ShaderCooker();
+
+	virtual const char_t * getCookedExtension() const;
+
+	virtual void collectDependencies(const std::string& sourceFile, Data * source, std::vector<std::string>& outDeps);
+	virtual bool cook(const std::string& sourceFile, Data * source, Data * output);
+
+private:
+	bool preprocess(Data * source, std::string& outSource, std::vector<std::string> * outIncludes);
+};
+
+//Converts images of foreign formats to native textures with mipmaps
+class SQRESOURCE_API ImageCooker:
+	public AssetCooker::Cooker
+{
+	ImageLoader mImageLoader;
+	bool mBuildMipmaps;
+
+public:
+	ImageCooker(bool buildMipmaps = true);
+	virtual ~ImageCooker();
+
+	virtual const char_t * getCookedExtension() const;
+	virtual std::string getSettingsKey() const;
+
+	virtual bool cook(const std::string& sourceFile, Data * source, Data * output);
+};
+
+//Imports models with importer module and saves them in native format
+class SQRESOURCE_API ModelCooker:
+	public AssetCooker::Cooker
+{
+	IModelImporter * mImporter;
+	std::string mSettingsKey;
+
+public:
+	//importer is not owned; settingsKey should describe import settings (mesh optimization etc.)
+	ModelCooker(IModelImporter * importer, const std::string& settingsKey = "");
+	virtual ~ModelCooker();
+
+	virtual const char_t * getCookedExtension() const;
+	virtual std::string getSettingsKey() const;
+
+	virtual bool cook(const std::string& sourceFile, Data * source, Data * output);
+
+	//importer creates render resources and keeps import state
+	virtual bool isThreadSafe() const { return false; }
+};
+
+}//namespace Resource {
+
+}//namespace Squirrel {
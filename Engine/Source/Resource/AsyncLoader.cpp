@@ -0,0 +1,329 @@
+#include "AsyncLoader.h"
+#include <Common/Profiler.h>
+#include <Common/Log.h>
+#include <Common/macros.h>
+#include <algorithm>
+
+namespace Squirrel {
+
+namespace Resource {
+
+namespace {
+
+float NanosecondsToMs(uint64 ns)
+{
+	return (float)((double)ns / 1000000.0);
+}
+
+}//namespace {
+
+AsyncLoader * AsyncLoader::sActiveLoader = NULL;
+
+AsyncLoader::AsyncLoader(int threadsNum):
+	mQuit(false), mParsingNum(0), mViewPoint(0, 0, 0)
+{
+	for(int i = 0; i < threadsNum; ++i)
+	{
+		mThreads.push_back(std::thread(&AsyncLoader::loaderLoop, this));
+	}
+}
+
+AsyncLoader::~AsyncLoader()
+{
+	if(this == sActiveLoader)
+	{
+		sActiveLoader = NULL;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mQueuedWake.notify_all();
+
+	for(size_t i = 0; i < mThreads.size(); ++i)
+	{
+		mThreads[i].join();
+	}
+
+	//let owners of unfinished requests know they failed
+	for(size_t i = 0; i < mQueued.size(); ++i)
+	{
+		mQueued[i]->finish(false);
+		delete mQueued[i];
+	}
+
+	for(std::list<Request *>::iterator it = mParsed.begin(); it != mParsed.end(); ++it)
+	{
+		(*it)->finish(false);
+		delete (*it);
+	}
+}
+
+int AsyncLoader::getQueue(const char_t * name)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	for(size_t i = 0; i < mStats.size(); ++i)
+	{
+		if(mStats[i].name == name)
+			return (int)i;
+	}
+
+	QueueStats stats;
+	stats.name			= name;
+	stats.queuedNum		= 0;
+	stats.parsingNum	= 0;
+	stats.parsedNum		= 0;
+	stats.loadedNum		= 0;
+	stats.failedNum		= 0;
+	stats.parseMs		= 0;
+	stats.finishMs		= 0;
+	mStats.push_back(stats);
+
+	return (int)mStats.size() - 1;
+}
+
+void AsyncLoader::submit(Request * request, int queue)
+{
+	ASSERT(request != NULL);
+
+	request->mQueue = queue;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mQueued.push_back(request);
+		++mStats[queue].queuedNum;
+	}
+
+	mQueuedWake.notify_one();
+}
+
+void AsyncLoader::setViewPoint(const Math::vec3& point)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mViewPoint = point;
+}
+
+AsyncLoader::Request * AsyncLoader::takeNext()
+{
+	size_t best = 0;
+	float bestScore = 0;
+
+	for(size_t i = 0; i < mQueued.size(); ++i)
+	{
+		Request * request = mQueued[i];
+
+		float score = request->mPriority;
+		if(request->mHasPosition)
+		{
+			score -= (request->mPosition - mViewPoint).len();
+		}
+
+		if(i == 0 || score > bestScore)
+		{
+			best = i;
+			bestScore = score;
+		}
+	}
+
+	Request * request = mQueued[best];
+	mQueued[best] = mQueued.back();
+	mQueued.pop_back();
+
+	return request;
+}
+
+void AsyncLoader::loaderLoop()
+{
+	Profiler::SetThreadName("Resource loading");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while(true)
+	{
+		while(!mQuit && mQueued.empty())
+		{
+			mQueuedWake.wait(lock);
+		}
+
+		if(mQuit)
+			break;
+
+		Request * request = takeNext();
+
+		QueueStats * stats = &mStats[request->mQueue];
+		--stats->queuedNum;
+		++stats->parsingNum;
+		++mParsingNum;
+
+		lock.unlock();
+
+		uint64 begin = Profiler::Now();
+		bool parsed = false;
+		{
+			SQ_PROFILE_ZONE("AsyncLoader::parse");
+			parsed = request->parse();
+		}
+		float parseMs = NanosecondsToMs(Profiler::Now() - begin);
+
+		Log::Instance().flush();
+
+		lock.lock();
+
+		request->mParsed = parsed;
+		mParsed.push_back(request);
+
+		//stats vector may have grown while parsing
+		stats = &mStats[request->mQueue];
+		--stats->parsingNum;
+		++stats->parsedNum;
+		stats->parseMs += parseMs;
+		--mParsingNum;
+
+		mParsedWake.notify_all();
+	}
+}
+
+int AsyncLoader::update(float budgetMs)
+{
+	SQ_PROFILE_ZONE("AsyncLoader::update");
+
+	uint64 begin = Profiler::Now();
+	uint64 budget = (uint64)(budgetMs * 1000000.0f);
+
+	int finishedNum = 0;
+
+	while(true)
+	{
+		Request * request = NULL;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			if(mParsed.empty())
+				break;
+			request = mParsed.front();
+			mParsed.pop_front();
+		}
+
+		bool loaded = finishParsed(request);
+		uint64 finishEnd = Profiler::Now();
+
+		++finishedNum;
+
+		if(budgetMs >= 0 && finishEnd - begin >= budget)
+			break;
+	}
+
+	return finishedNum;
+}
+
+bool AsyncLoader::finishParsed(Request * request)
+{
+	uint64 finishBegin = Profiler::Now();
+	bool loaded = request->finish(request->mParsed);
+	uint64 finishEnd = Profiler::Now();
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		QueueStats& stats = mStats[request->mQueue];
+		--stats.parsedNum;
+		if(loaded)
+			++stats.loadedNum;
+		else
+			++stats.failedNum;
+		stats.finishMs += NanosecondsToMs(finishEnd - finishBegin);
+	}
+
+	delete request;
+
+	return loaded;
+}
+
+bool AsyncLoader::finishNow(Request * request)
+{
+	SQ_PROFILE_ZONE("AsyncLoader::finishNow");
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while(true)
+	{
+		std::list<Request *>::iterator parsed = std::find(mParsed.begin(), mParsed.end(), request);
+		if(parsed != mParsed.end())
+		{
+			mParsed.erase(parsed);
+			break;
+		}
+
+		std::vector<Request *>::iterator queued = std::find(mQueued.begin(), mQueued.end(), request);
+		if(queued != mQueued.end())
+		{
+			mQueued.erase(queued);
+
+			QueueStats * stats = &mStats[request->mQueue];
+			--stats->queuedNum;
+			++stats->parsingNum;
+			++mParsingNum;
+
+			lock.unlock();
+
+			uint64 begin = Profiler::Now();
+			bool isParsed = request->parse();
+			float parseMs = NanosecondsToMs(Profiler::Now() - begin);
+
+			lock.lock();
+
+			request->mParsed = isParsed;
+
+			stats = &mStats[request->mQueue];
+			--stats->parsingNum;
+			++stats->parsedNum;
+			stats->parseMs += parseMs;
+			--mParsingNum;
+			break;
+		}
+
+		//finished already
+		if(mParsingNum == 0)
+			return false;
+
+		//being parsed by loader thread
+		mParsedWake.wait(lock);
+	}
+
+	lock.unlock();
+
+	return finishParsed(request);
+}
+
+void AsyncLoader::flush()
+{
+	SQ_PROFILE_ZONE("AsyncLoader::flush");
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			while(mParsed.empty() && (!mQueued.empty() || mParsingNum > 0))
+			{
+				mParsedWake.wait(lock);
+			}
+
+			if(mParsed.empty())
+				break;
+		}
+
+		//finishing may submit new requests (e.g. textures of models)
+		update(-1);
+	}
+}
+
+void AsyncLoader::getStats(std::vector<QueueStats>& outStats)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	outStats = mStats;
+}
+
+}//namespace Resource {
+
+}//namespace Squirrel {
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Common/types.h>
+#include <Math/vec3.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "macros.h"
+
+namespace Squirrel {
+
+namespace Resource {
+
+//Background loading of resources.
+//Loader threads read and parse requested resources, most prioritized and nearest to view point first.
+//Parsed requests are finished (e.g. GPU objects are created) on main thread by update
+//which spends not more than given time budget per frame.
+class SQRESOURCE_API AsyncLoader
+{
+	static AsyncLoader * sActiveLoader;
+
+public://nested types
+
+	//requests of one queue (usually one per storage)
+	struct QueueStats
+	{
+		std::string	name;
+		int			queuedNum;//waiting for loader thread
+		int			parsingNum;//being parsed by loader threads
+		int			parsedNum;//waiting for main thread
+		int			loadedNum;//total
+		int			failedNum;//total
+		float		parseMs;//total time spent by loader threads
+		float		finishMs;//total time spent by main thread
+	};
+
+	class SQRESOURCE_API Request
+	{
+		friend class AsyncLoader;
+
+	public:
+		Request(): mPriority(0), mPosition(0, 0, 0), mHasPosition(false), mQueue(0), mParsed(false) {}
+		virtual ~Request() {}
+
+		//loader thread: must not touch GPU and anything main thread may change
+		virtual bool parse() = 0;
+
+		//main thread: parsed is result of parse, returns false if resource failed to load
+		virtual bool finish(bool parsed) = 0;
+
+		//requests with higher priority go first, distance to view point is subtracted from priority of positioned ones
+		float		mPriority;
+		Math::vec3	mPosition;
+		bool		mHasPosition;
+
+	private:
+		int			mQueue;
+		bool		mParsed;
+	};
+
+public:
+	AsyncLoader(int threadsNum);
+	~AsyncLoader();
+
+	static AsyncLoader * Active() { return sActiveLoader; }
+	void setAsActive() { sActiveLoader = this; }
+
+	//finds or adds queue with given name, returns its index
+	int getQueue(const char_t * name);
+
+	//takes ownership of request
+	void submit(Request * request, int queue);
+
+	//usually position of main camera
+	void setViewPoint(const Math::vec3& point);
+
+	//finishes parsed requests on calling (main) thread till budget is spent (negative - unlimited),
+	//at least one is finished; returns number of finished requests
+	int update(float budgetMs);
+
+	//finishes all submitted requests including ones submitted while finishing, e.g. on level load
+	void flush();
+
+	//finishes given submitted request on calling (main) thread: parses it here if no loader thread
+	//has taken it yet, otherwise waits till it is parsed; returns false if it failed or is not pending
+	bool finishNow(Request * request);
+
+	void getStats(std::vector<QueueStats>& outStats);
+
+private:
+
+	void loaderLoop();
+
+	//highest score request, call under lock
+	Request * takeNext();
+
+	//finishes request taken from parsed ones and deletes it, main thread
+	bool finishParsed(Request * request);
+
+private:
+
+	std::vector<std::thread>	mThreads;
+	std::mutex					mMutex;
+	std::condition_variable		mQueuedWake;
+	std::condition_variable		mParsedWake;
+	bool						mQuit;
+
+	//requests are few and view point moves every frame, so best one is searched by plain scan
+	std::vector<Request *>		mQueued;
+	std::list<Request *>		mParsed;
+	int							mParsingNum;
+
+	std::vector<QueueStats>		mStats;
+
+	Math::vec3					mViewPoint;
+};
+
+}//namespace Resource {
+
+}//namespace Squirrel {
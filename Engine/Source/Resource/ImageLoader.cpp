@@ -2,6 +2,7 @@
 #include <Common/Log.h>
 #include <Common/DynamicLibrary.h>
 #include <IL/il.h>
+#include <mutex>
 
 #ifdef __APPLE__
 #include <Render/Mac/MacImageLoader.h>
@@ -33,6 +34,9 @@ LPilGetInteger		_ilGetInteger	= NULL;
 
 DynamicLibrary sOpenILModule;
 
+//DevIL keeps bound image globally, images are decoded one at a time by any thread
+std::mutex sOpenILMutex;
+
 namespace Resource { 
 
 using namespace RenderData;
@@ -130,6 +134,8 @@ Image* ImageLoader::loadImage(Data * data)
 	return MacImageLoader::LoadImage(data);
 #endif
 	
+	std::unique_lock<std::mutex> lock(sOpenILMutex);
+
 	init();//save to call
 
 	if(!mInitialized)
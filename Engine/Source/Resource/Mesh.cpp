@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include "MeshProcessing.h"
 #include <Math/GeometryTools.h>
 #include <Render/IRender.h>
 
@@ -12,10 +13,13 @@ Mesh::Mesh()
 {
 	m_pIndexBuffer	= NULL;
 	m_pVertexBuffer	= NULL;
+	mCollisionMirror = NULL;
 }
 
 Mesh::~Mesh(void)
 {
+	releaseCollisionMirror();
+
 	DELETE_PTR( m_pIndexBuffer );
 	if(!m_bSharedVB)
 	{
@@ -31,6 +35,10 @@ void Mesh::render()
 
 void Mesh::DrawNormals(VertexBuffer * normalsVB, float length, bool mirror)
 {
+	//CPU copy is released after upload for static buffers
+	if(normalsVB->getVerts() == NULL || !normalsVB->hasComponent(VertexBuffer::vcNormal))
+		return;
+
 	IRender * render = IRender::GetActive();
 
 	render->setColor(vec4(0.9f, 0.1f, 0.7f, 1));
@@ -111,7 +119,7 @@ void Mesh::calcBoundingVolume()
 	mAABB.reset();
 	for(int i = 0; i < (int)m_pVertexBuffer->getVertsNum(); ++i)
 	{
-		vec3 pos = m_pVertexBuffer->getComponent<VertexBuffer::vcPosition>( i );
+		vec3 pos = m_pVertexBuffer->getPosition( i );
 		mAABB.addVertex( pos );
 	}
 }
@@ -123,38 +131,7 @@ void Mesh::calcNormals(IndexBuffer  * ib, VertexBuffer * vb)
 	if(ib->getIndicesNum()<=0) return;
 	if(ib->getPolyType() != IndexBuffer::ptTriangles)	return;
 
-	const uint inc = 3;
-	const int vcNorm =  VertexBuffer::vcNormal;
-
-	uint vrt=0;
-
-	uint triNum = ib->getIndicesNum()/inc;
-	vec3 * triNorms = new vec3[triNum];
-
-	for(vrt=0; vrt<vb->getVertsNum(); ++vrt )
-		vb->getComponent<vcNorm>( vrt ).zero();
-
-	for(uint tri=0; tri<triNum; ++tri )
-	{
-		vec3 v0 = vb->getComponent<VertexBuffer::vcPosition>( ib->getIndex(tri*inc+0) );
-		vec3 v1 = vb->getComponent<VertexBuffer::vcPosition>( ib->getIndex(tri*inc+1) );
-		vec3 v2 = vb->getComponent<VertexBuffer::vcPosition>( ib->getIndex(tri*inc+2) );
-		triNorms[tri] = ((v1 - v0) ^ (v2 - v0)).normalized();
-	}
-
-	int index = 0;
-	for(uint ind=0; ind<ib->getIndicesNum(); ++ind )
-	{
-		index = ib->getIndex(ind);
-		vb->setComponent<vcNorm>( index, vb->getComponent<vcNorm>( index ) + triNorms[ (ind - ind%inc)/inc ] );
-	}
-
-	for(vrt=0; vrt<vb->getVertsNum(); ++vrt )
-	{
-		vb->getComponent<vcNorm>( vrt ).normalize();
-	}
-
-	delete[]triNorms;
+	MeshProcessing::CalcNormals(ib, vb, MeshProcessing::nwAngle);
 }
 
 void Mesh::calcTangentBasis(IndexBuffer * ib, VertexBuffer * vb)
@@ -169,62 +146,7 @@ void Mesh::calcTangentBasis(IndexBuffer * ib, VertexBuffer * vb)
 	ASSERT(vb->hasComponent(VertexBuffer::vcTangentBinormal));//must have tangents
 	ASSERT(vb->hasComponent(VertexBuffer::vcTexcoord));//must have texcoords
 
-	int i, j;
-	std::vector<vec3> tangents, binormals;	// касательные вектора к треугольнику
-
-	const int facesNum = ib->getIndicesNum() / 3;
-
-	// проходимся по всем треугольникам, и для каждого считаем базис
-	for (i = 0; i < facesNum; ++i)
-	{
-		uint ind0 = ib->getIndex( i * 3 + 0 );
-		uint ind1 = ib->getIndex( i * 3 + 1 );
-		uint ind2 = ib->getIndex( i * 3 + 2 );
-
-		vec3 v1 = vb->getComponent<VertexBuffer::vcPosition>(ind0);
-		vec3 v2 = vb->getComponent<VertexBuffer::vcPosition>(ind1);
-		vec3 v3 = vb->getComponent<VertexBuffer::vcPosition>(ind2);
-		vec2 t1 = vb->getComponent<VertexBuffer::vcTexcoord>(ind0);
-		vec2 t2 = vb->getComponent<VertexBuffer::vcTexcoord>(ind1);
-		vec2 t3 = vb->getComponent<VertexBuffer::vcTexcoord>(ind2);
-
-		vec3  t, b;
-		calcTriangleTangentBasis( v1, v2, v3, t1, t2, t3, t, b );
-
-		tangents.push_back( t );
-		binormals.push_back( b );
-	}
-
-	for ( i = 0; i < vb->getVertsNum(); ++i )
-	{
-		vec3 tangentRes( 0, 0, 0 );
-		vec3 binormalRes( 0, 0, 0 );
-		int count = 0;
-		
-		for ( j = 0; j < facesNum; ++j )
-		{
-			uint ind0 = ib->getIndex( j * 3 + 0 );
-			uint ind1 = ib->getIndex( j * 3 + 1 );
-			uint ind2 = ib->getIndex( j * 3 + 2 );
-			if (ind0 == i || ind1 == i || ind2 == i )
-			{
-				tangentRes += tangents[ j ];
-				binormalRes += binormals[ j ];
-				++count;
-			}
-		}
-
-		tangentRes.safeNormalize();
-		binormalRes.safeNormalize();
-
-		vec3 normal = vb->getComponent<VertexBuffer::vcNormal>(i);
-
-		tangentRes	= orthogonalize( normal, tangentRes );
-		binormalRes	= orthogonalize( normal, binormalRes );
-
-		float binormalMultiplier = binormalRes * (normal ^ tangentRes);
-		vb->setComponent< VertexBuffer::vcTangentBinormal>(i, vec4(tangentRes, binormalMultiplier));
-	}
+	MeshProcessing::CalcTangents(ib, vb);
 }
 
 IndexBuffer* Mesh::createIndexBuffer( uint iIndNum, IndexBuffer::IndexSize indexSize )
@@ -244,6 +166,7 @@ VertexBuffer* Mesh::createVertexBuffer(int vertType, uint vertNum)
 
 VertexBuffer	* Mesh::setSharedVertexBuffer(VertexBuffer	* pVB)
 {
+	releaseCollisionMirror();
 	m_pVertexBuffer	= pVB;
 	ASSERT( m_pVertexBuffer!=NULL );
 	m_bSharedVB = true;
@@ -252,12 +175,14 @@ VertexBuffer	* Mesh::setSharedVertexBuffer(VertexBuffer	* pVB)
 
 void Mesh::setIndexBuffer(IndexBuffer* ib)	
 {
+	releaseCollisionMirror();
 	DELETE_PTR( m_pIndexBuffer );
 	m_pIndexBuffer = ib; 
 }
 
 void Mesh::setVertexBuffer(VertexBuffer* vb)	
 { 
+	releaseCollisionMirror();
 	if(!m_bSharedVB)
 	{
 		DELETE_PTR( m_pVertexBuffer );
@@ -266,12 +191,74 @@ void Mesh::setVertexBuffer(VertexBuffer* vb)
 	m_pVertexBuffer = vb;
 }
 
+const Mesh::CollisionMirror * Mesh::getCollisionMirror()
+{
+	if(mCollisionMirror != NULL)
+		return mCollisionMirror;
+
+	if(m_pVertexBuffer == NULL || m_pIndexBuffer == NULL)
+		return NULL;
+
+	if(!m_pIndexBuffer->map(true, false))
+		return NULL;
+
+	if(!m_pVertexBuffer->map(true, false))
+	{
+		m_pIndexBuffer->unmap();
+		return NULL;
+	}
+
+	mCollisionMirror = new CollisionMirror();
+	mCollisionMirror->polyType = m_pIndexBuffer->getPolyType();
+
+	uint indicesNum = m_pIndexBuffer->getIndicesNum();
+	mCollisionMirror->indices.resize(indicesNum);
+
+	//shared vertex buffers hold vertices of other meshes too
+	const uint32 unused = 0xFFFFFFFF;
+	std::vector<uint32> remap(m_pVertexBuffer->getVertsNum(), unused);
+
+	for(uint i = 0; i < indicesNum; ++i)
+	{
+		uint32 index = m_pIndexBuffer->getIndex(i);
+		if(remap[index] == unused)
+		{
+			remap[index] = (uint32)mCollisionMirror->positions.size();
+			mCollisionMirror->positions.push_back(m_pVertexBuffer->getPosition((int)index));
+		}
+		mCollisionMirror->indices[i] = remap[index];
+	}
+
+	m_pVertexBuffer->unmap();
+	m_pIndexBuffer->unmap();
+
+	BufferMemory::Add(BufferMemory::bmCollisionMirrors,
+		mCollisionMirror->positions.size() * sizeof(vec3) + mCollisionMirror->indices.size() * sizeof(uint32));
+
+	return mCollisionMirror;
+}
+
+void Mesh::releaseCollisionMirror()
+{
+	if(mCollisionMirror == NULL)
+		return;
+
+	BufferMemory::Add(BufferMemory::bmCollisionMirrors,
+		-(int64)(mCollisionMirror->positions.size() * sizeof(vec3) + mCollisionMirror->indices.size() * sizeof(uint32)));
+
+	DELETE_PTR(mCollisionMirror);
+}
+
 bool Mesh::findIntersection(vec3 lineStart, vec3 lineEnd, Intesection& out, int startTriangleIndex )
 {
-	int trianglesNum = m_pIndexBuffer->getIndicesNum() * 3;
+	const CollisionMirror * mirror = getCollisionMirror();
+	if(mirror == NULL)
+		return false;
+
+	int trianglesNum = (int)mirror->indices.size() / 3;
 
 	//perform some checks
-	ASSERT(m_pIndexBuffer->getPolyType() == IndexBuffer::ptTriangles);
+	ASSERT(mirror->polyType == IndexBuffer::ptTriangles);
 	ASSERT(startTriangleIndex < trianglesNum);
 
 	bool recalculateNormals = false;
@@ -289,13 +276,13 @@ bool Mesh::findIntersection(vec3 lineStart, vec3 lineEnd, Intesection& out, int
 	{
 		index = i * 3;
 
-		triVerts[0] = m_pVertexBuffer->getComponent<VertexBuffer::vcPosition>( m_pIndexBuffer->getIndex( index + 0 ) );
-		triVerts[1] = m_pVertexBuffer->getComponent<VertexBuffer::vcPosition>( m_pIndexBuffer->getIndex( index + 1 ) );
-		triVerts[2] = m_pVertexBuffer->getComponent<VertexBuffer::vcPosition>( m_pIndexBuffer->getIndex( index + 2 ) );
+		triVerts[0] = mirror->positions[ mirror->indices[ index + 0 ] ];
+		triVerts[1] = mirror->positions[ mirror->indices[ index + 1 ] ];
+		triVerts[2] = mirror->positions[ mirror->indices[ index + 2 ] ];
 
 		if(recalculateNormals)
 		{
-			normal = getNormalToTriangle(triVerts);
+			normal = getNormalToTriangle(triVerts[0], triVerts[1], triVerts[2]);
 			mTriangleNormalsCache[i] = normal;
 		}
 		else
@@ -23,6 +23,15 @@ public:
 		int triangleIndex;
 	};
 
+	//compact copy of positions and indices for CPU queries (collisions, raycasts),
+	//holds only vertices used by mesh, indices are remapped accordingly
+	struct CollisionMirror
+	{
+		std::vector<vec3>		positions;
+		std::vector<uint32>		indices;
+		IndexBuffer::PolyType	polyType;
+	};
+
 public:
 
 	Mesh();
@@ -32,6 +41,11 @@ public:
 
 	bool findIntersection(vec3 lineStart, vec3 lineEnd, Intesection& out, int startTriangleIndex = 0 );
 
+	//built on first request, reads buffers through map as their CPU copies may be released;
+	//returns NULL if mesh has no buffers
+	const CollisionMirror * getCollisionMirror();
+	void releaseCollisionMirror();
+
 	void calcTangentBasis(IndexBuffer * ib, VertexBuffer * vb);
 	static void calcNormals(IndexBuffer  * ib, VertexBuffer * vb);
 
@@ -63,6 +77,8 @@ protected:
 	bool					m_bSharedVB;
 
 	std::vector<vec3> mTriangleNormalsCache;
+
+	CollisionMirror *	mCollisionMirror;
 };
 
 class SQRESOURCE_API MeshBuilder
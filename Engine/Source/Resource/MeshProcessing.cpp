@@ -0,0 +1,1202 @@
+#include "MeshProcessing.h"
+#include <Common/TaskPool.h>
+#include <Common/Profiler.h>
+#include <Common/Settings.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+namespace Squirrel {
+
+namespace Resource {
+
+using namespace Math;
+
+namespace {
+
+//squared length of vectors considered zero
+const float DEGENERATE_LEN_SQUARED = 1e-24f;
+
+//number of triangles or vertices processed by one parallel task at least
+const int MIN_CHUNK_SIZE = 4096;
+
+struct Face
+{
+	vec3	normal;//unit, zero for degenerate triangle
+	float	weights[3];//corners weights
+	vec3	tangent;//unit, zero for degenerate mapping
+	vec3	bitangent;
+};
+
+struct Job
+{
+	const uint32 *	indices;
+	int				trianglesNum;
+	int				vertsNum;
+
+	byte *			verts;
+	size_t			stride;
+	size_t			positionOffset;
+	size_t			normalOffset;
+	size_t			texcoordOffset;
+	size_t			tangentOffset;
+
+	int				weighting;
+	bool			tangents;
+
+	Face *			faces;
+
+	//vertex corners are corners[cornersStart[v]..cornersStart[v + 1])
+	const int *		cornersStart;
+	const int *		corners;
+};
+
+template <class T>
+inline T& ComponentAt(const Job& job, uint32 vertex, size_t offset)
+{
+	return *(T *)(job.verts + vertex * job.stride + offset);
+}
+
+inline float Angle(const vec3& a, const vec3& b, float lenProduct)
+{
+	return acosf(clamp((a * b) / lenProduct, -1.0f, 1.0f));
+}
+
+void CalcFace(const Job& job, int triangle)
+{
+	const uint32 * tri = job.indices + triangle * 3;
+	Face& face = job.faces[triangle];
+
+	const vec3& p0 = ComponentAt<vec3>(job, tri[0], job.positionOffset);
+	const vec3& p1 = ComponentAt<vec3>(job, tri[1], job.positionOffset);
+	const vec3& p2 = ComponentAt<vec3>(job, tri[2], job.positionOffset);
+
+	vec3 e01 = p1 - p0;
+	vec3 e02 = p2 - p0;
+
+	vec3 normal = e01 ^ e02;
+	float doubleArea = normal.len();
+
+	if(doubleArea * doubleArea <= DEGENERATE_LEN_SQUARED)
+	{
+		face.normal.zero();
+		face.weights[0] = face.weights[1] = face.weights[2] = 0;
+		face.tangent.zero();
+		face.bitangent.zero();
+		return;
+	}
+
+	face.normal = normal / doubleArea;
+
+	switch(job.weighting)
+	{
+	case MeshProcessing::nwUniform:
+		face.weights[0] = face.weights[1] = face.weights[2] = 1;
+		break;
+	case MeshProcessing::nwArea:
+		face.weights[0] = face.weights[1] = face.weights[2] = doubleArea * 0.5f;
+		break;
+	default:
+		{
+			vec3 e12 = p2 - p1;
+			float len01 = e01.len();
+			float len02 = e02.len();
+			float len12 = e12.len();
+			face.weights[0] = Angle(e01, e02, len01 * len02);
+			face.weights[1] = Angle(-e01, e12, len01 * len12);
+			face.weights[2] = maxValue(PI - face.weights[0] - face.weights[1], 0.0f);
+		}
+		break;
+	}
+
+	if(!job.tangents)
+		return;
+
+	const vec2& uv0 = ComponentAt<vec2>(job, tri[0], job.texcoordOffset);
+	const vec2& uv1 = ComponentAt<vec2>(job, tri[1], job.texcoordOffset);
+	const vec2& uv2 = ComponentAt<vec2>(job, tri[2], job.texcoordOffset);
+
+	vec2 uv01 = uv1 - uv0;
+	vec2 uv02 = uv2 - uv0;
+
+	float signedUVArea = uv01.x * uv02.y - uv01.y * uv02.x;
+
+	face.tangent.zero();
+	face.bitangent.zero();
+
+	if(fabsf(signedUVArea) <= EPSILON_SQUARED)
+		return;
+
+	//position derivatives by u and v scaled by signed texture area, sign restores their direction
+	float sign = signedUVArea < 0 ? -1.0f : 1.0f;
+	vec3 tangent	= (e01 * uv02.y - e02 * uv01.y) * sign;
+	vec3 bitangent	= (e02 * uv01.x - e01 * uv02.x) * sign;
+
+	if(tangent.lenSquared() > DEGENERATE_LEN_SQUARED)
+		face.tangent = tangent.normalized();
+	if(bitangent.lenSquared() > DEGENERATE_LEN_SQUARED)
+		face.bitangent = bitangent.normalized();
+}
+
+inline void AddNormal(const Face& face, int corner, vec3& sum)
+{
+	sum += face.normal * face.weights[corner];
+}
+
+inline vec3 ProjectToPlane(const vec3& v, const vec3& normal)
+{
+	vec3 res = v - normal * (normal * v);
+	float lenSquared = res.lenSquared();
+	return lenSquared > DEGENERATE_LEN_SQUARED ? res / sqrtf(lenSquared) : vec3::Zero();
+}
+
+inline void AddTangent(const Face& face, int corner, const vec3& normal, vec3& tangentSum, vec3& bitangentSum)
+{
+	float weight = face.weights[corner];
+	tangentSum		+= ProjectToPlane(face.tangent, normal) * weight;
+	bitangentSum	+= ProjectToPlane(face.bitangent, normal) * weight;
+}
+
+inline vec3 FinishNormal(const vec3& sum)
+{
+	float lenSquared = sum.lenSquared();
+	return lenSquared > DEGENERATE_LEN_SQUARED ? sum / sqrtf(lenSquared) : vec3::Zero();
+}
+
+inline vec4 FinishTangent(const vec3& normal, const vec3& tangentSum, const vec3& bitangentSum)
+{
+	vec3 tangent = ProjectToPlane(tangentSum, normal);
+
+	if(tangent.isZero())
+	{
+		//no texture mapping around vertex, any direction in normal plane will do
+		vec3 axis = fabsf(normal.x) < 0.9f ? vec3::AxisX() : vec3::AxisY();
+		tangent = ProjectToPlane(axis, normal);
+		if(tangent.isZero())
+			tangent = axis;
+	}
+
+	float sign = ((normal ^ tangent) * bitangentSum) < 0 ? -1.0f : 1.0f;
+	return vec4(tangent, sign);
+}
+
+void FacesRange(void * context, int begin, int end)
+{
+	const Job& job = *static_cast<const Job *>(context);
+	for(int i = begin; i < end; ++i)
+	{
+		CalcFace(job, i);
+	}
+}
+
+void GatherNormalsRange(void * context, int begin, int end)
+{
+	const Job& job = *static_cast<const Job *>(context);
+	for(int v = begin; v < end; ++v)
+	{
+		vec3 sum(0, 0, 0);
+		for(int c = job.cornersStart[v]; c < job.cornersStart[v + 1]; ++c)
+		{
+			int corner = job.corners[c];
+			AddNormal(job.faces[corner / 3], corner % 3, sum);
+		}
+		ComponentAt<vec3>(job, v, job.normalOffset) = FinishNormal(sum);
+	}
+}
+
+void GatherTangentsRange(void * context, int begin, int end)
+{
+	const Job& job = *static_cast<const Job *>(context);
+	for(int v = begin; v < end; ++v)
+	{
+		const vec3& normal = ComponentAt<vec3>(job, v, job.normalOffset);
+
+		vec3 tangentSum(0, 0, 0);
+		vec3 bitangentSum(0, 0, 0);
+		for(int c = job.cornersStart[v]; c < job.cornersStart[v + 1]; ++c)
+		{
+			int corner = job.corners[c];
+			AddTangent(job.faces[corner / 3], corner % 3, normal, tangentSum, bitangentSum);
+		}
+		ComponentAt<vec4>(job, v, job.tangentOffset) = FinishTangent(normal, tangentSum, bitangentSum);
+	}
+}
+
+//counting sort of corners by vertex, keeps triangles order so results match serial scatter;
+//corner is triangle * 3 + vertex in triangle
+void BuildAdjacency(const uint32 * indices, int cornersNum, int vertsNum, std::vector<int>& cornersStart, std::vector<int>& corners)
+{
+	SQ_PROFILE_ZONE("MeshProcessing::BuildAdjacency");
+
+	cornersStart.assign(vertsNum + 1, 0);
+	for(int i = 0; i < cornersNum; ++i)
+	{
+		++cornersStart[indices[i] + 1];
+	}
+	for(int v = 0; v < vertsNum; ++v)
+	{
+		cornersStart[v + 1] += cornersStart[v];
+	}
+
+	std::vector<int> fill(cornersStart.begin(), cornersStart.end() - 1);
+	corners.resize(cornersNum);
+	for(int i = 0; i < cornersNum; ++i)
+	{
+		corners[fill[indices[i]]++] = i;
+	}
+}
+
+//sets up job indices and vertex layout, returns false for unsupported or broken buffers
+bool InitJob(IndexBuffer * ib, VertexBuffer * vb, std::vector<uint32>& wideIndices, Job& job)
+{
+	if(ib == NULL || vb == NULL || vb->getVerts() == NULL || ib->getIndexBuff() == NULL)
+		return false;
+	if(ib->getPolyType() != IndexBuffer::ptTriangles)
+		return false;
+	if(!vb->hasComponent(VertexBuffer::vcPosition) || !vb->hasComponent(VertexBuffer::vcNormal))
+		return false;
+
+	job.trianglesNum	= (int)(ib->getIndicesNum() / 3);
+	job.vertsNum		= (int)vb->getVertsNum();
+
+	int indicesNum = job.trianglesNum * 3;
+	uint32 maxIndex = 0;
+
+	//indices are read once through typed pointer instead of per index size checks
+	if(ib->getIndexSize() == IndexBuffer::Index16)
+	{
+		const uint16 * src = (const uint16 *)ib->getIndexBuff();
+		wideIndices.resize(indicesNum);
+		for(int i = 0; i < indicesNum; ++i)
+		{
+			wideIndices[i] = src[i];
+			maxIndex = maxValue(maxIndex, wideIndices[i]);
+		}
+		job.indices = wideIndices.empty() ? NULL : &wideIndices[0];
+	}
+	else
+	{
+		job.indices = (const uint32 *)ib->getIndexBuff();
+		for(int i = 0; i < indicesNum; ++i)
+		{
+			maxIndex = maxValue(maxIndex, job.indices[i]);
+		}
+	}
+
+	if(indicesNum > 0 && maxIndex >= (uint32)job.vertsNum)
+		return false;
+
+	job.verts			= vb->getVerts();
+	job.stride			= vb->getVertexSize();
+	job.positionOffset	= vb->getComponentOffset(VertexBuffer::vcPosition);
+	job.normalOffset	= vb->getComponentOffset(VertexBuffer::vcNormal);
+	job.texcoordOffset	= 0;
+	job.tangentOffset	= 0;
+	job.weighting		= MeshProcessing::nwAngle;
+	job.tangents		= false;
+	job.faces			= NULL;
+	job.cornersStart	= NULL;
+	job.corners			= NULL;
+
+	return true;
+}
+
+
+const uint32 INVALID_INDEX = 0xffffffff;
+
+//marks 4 bytes words of float vertex component
+template <int iComponent>
+void MarkFloatComponent(const VertexBuffer * vb, std::vector<char>& floatWords)
+{
+	if(!vb->hasComponent(iComponent))
+		return;
+
+	size_t first = vb->getComponentOffset(iComponent) / 4;
+	size_t num = vb->getComponentSize<iComponent>() / 4;
+	for(size_t i = first; i < first + num; ++i)
+	{
+		floatWords[i] = 1;
+	}
+}
+
+//compares float words with tolerance and other words exactly
+bool NearlyEqualVertices(const byte * vertex1, const byte * vertex2, const std::vector<char>& floatWords, float epsilon)
+{
+	const uint32 * words1 = (const uint32 *)vertex1;
+	const uint32 * words2 = (const uint32 *)vertex2;
+	for(size_t i = 0; i < floatWords.size(); ++i)
+	{
+		if(floatWords[i])
+		{
+			if(fabsf(((const float *)words1)[i] - ((const float *)words2)[i]) > epsilon)
+				return false;
+		}
+		else if(words1[i] != words2[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+inline uint64 HashBytes(const byte * data, size_t size)
+{
+	//FNV-1a
+	uint64 hash = 14695981039346656037ULL;
+	for(size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+inline uint64 HashCell(int x, int y, int z)
+{
+	return ((uint64)(uint32)x * 73856093ULL) ^ ((uint64)(uint32)y * 19349663ULL) ^ ((uint64)(uint32)z * 83492791ULL);
+}
+
+inline int CellCoord(float value, float cellSize)
+{
+	return (int)floorf(clamp(value / cellSize, -1e9f, 1e9f));
+}
+
+struct Cluster
+{
+	int		begin;
+	int		end;
+	float	sortKey;
+};
+
+inline bool CompareClusters(const Cluster& cluster1, const Cluster& cluster2)
+{
+	return cluster1.sortKey > cluster2.sortKey;
+}
+
+//steps of 16 bit quantization relative to range minimum
+const float INT16_STEPS = 65535.0f;
+const float INT16_OFFSET = 32768.0f;
+
+//maps unit vector to octahedron unfolded to [-1, 1] square
+vec2 OctEncode(const vec3& v)
+{
+	float length = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+	if(length < EPSILON)
+		return vec2(0, 0);
+
+	vec2 p(v.x / length, v.y / length);
+	if(v.z < 0)
+	{
+		float x = (1.0f - fabsf(p.y)) * (p.x >= 0 ? 1.0f : -1.0f);
+		float y = (1.0f - fabsf(p.x)) * (p.y >= 0 ? 1.0f : -1.0f);
+		p = vec2(x, y);
+	}
+	return p;
+}
+
+vec3 OctDecode(float x, float y)
+{
+	vec3 v(x, y, 1.0f - fabsf(x) - fabsf(y));
+	if(v.z < 0)
+	{
+		v.x = (1.0f - fabsf(y)) * (x >= 0 ? 1.0f : -1.0f);
+		v.y = (1.0f - fabsf(x)) * (y >= 0 ? 1.0f : -1.0f);
+	}
+	v.normalize();
+	return v;
+}
+
+//quantizes octahedral encoding to signed normalized integers in [-maxValue, maxValue],
+//rounding of every coordinate is chosen to minimize angular error
+void OctQuantize(const vec3& v, float maxValue, int& outX, int& outY)
+{
+	vec2 p = OctEncode(v);
+	float floorX = floorf(p.x * maxValue);
+	float floorY = floorf(p.y * maxValue);
+
+	float bestDot = -2.0f;
+	for(int i = 0; i < 4; ++i)
+	{
+		float x = clamp(floorX + (i & 1), -maxValue, maxValue);
+		float y = clamp(floorY + (i >> 1), -maxValue, maxValue);
+		float dot = OctDecode(x / maxValue, y / maxValue) * v;
+		if(dot > bestDot)
+		{
+			bestDot = dot;
+			outX = (int)x;
+			outY = (int)y;
+		}
+	}
+}
+
+inline short QuantizeInt16(float value, float min, float scale)
+{
+	return (short)(clamp(floorf((value - min) / scale + 0.5f), 0.0f, INT16_STEPS) - INT16_OFFSET);
+}
+
+//16 bit quantization step for range, degenerate ranges get unit step
+inline float Int16Scale(float min, float max)
+{
+	return (max - min) > EPSILON ? (max - min) / INT16_STEPS : 1.0f;
+}
+
+void CalcTexcoordRange(const VertexBuffer * vb, vec2& outMin, vec2& outMax)
+{
+	outMin = outMax = vec2(0, 0);
+	for(int i = 0; i < (int)vb->getVertsNum(); ++i)
+	{
+		const vec2& uv = vb->getComponent<VertexBuffer::vcTexcoord>(i);
+		if(i == 0)
+		{
+			outMin = outMax = uv;
+			continue;
+		}
+		outMin.x = minValue(outMin.x, uv.x);
+		outMin.y = minValue(outMin.y, uv.y);
+		outMax.x = maxValue(outMax.x, uv.x);
+		outMax.y = maxValue(outMax.y, uv.y);
+	}
+}
+
+inline int ReplaceComponent(int vertType, int oldComponent, int newComponent)
+{
+	return (vertType & ~VCI2VT(oldComponent)) | VCI2VT(newComponent);
+}
+
+}//namespace {
+
+MeshProcessing::OptimizationParams::OptimizationParams():
+	weld(true), weldEpsilon(0), vertexCache(true), overdraw(true), overdrawThreshold(1.05f),
+	vertexFetch(true), fitIndexSize(true), cacheSize(VERTEX_CACHE_SIZE)
+{
+}
+
+MeshProcessing::PackingParams::PackingParams():
+	enabled(true), texcoords(true), texcoordMaxError(1.0f / 8192.0f), bones(true), positions(false)
+{
+}
+
+void MeshProcessing::PackingParams::readSettings(const char_t * section)
+{
+	Settings * settings = Settings::Default();
+
+	enabled				= settings->getInt(section, "Enabled", enabled ? 1 : 0) != 0;
+	texcoords			= settings->getInt(section, "Texcoords", texcoords ? 1 : 0) != 0;
+	texcoordMaxError	= settings->getFloat(section, "TexcoordMaxError", texcoordMaxError);
+	bones				= settings->getInt(section, "Bones", bones ? 1 : 0) != 0;
+	positions			= settings->getInt(section, "Positions", positions ? 1 : 0) != 0;
+}
+
+void MeshProcessing::OptimizationParams::readSettings(const char_t * section)
+{
+	Settings * settings = Settings::Default();
+
+	weld				= settings->getInt(section, "Weld", weld ? 1 : 0) != 0;
+	weldEpsilon			= settings->getFloat(section, "WeldEpsilon", weldEpsilon);
+	vertexCache			= settings->getInt(section, "VertexCache", vertexCache ? 1 : 0) != 0;
+	overdraw			= settings->getInt(section, "Overdraw", overdraw ? 1 : 0) != 0;
+	overdrawThreshold	= settings->getFloat(section, "OverdrawThreshold", overdrawThreshold);
+	vertexFetch			= settings->getInt(section, "VertexFetch", vertexFetch ? 1 : 0) != 0;
+	fitIndexSize		= settings->getInt(section, "FitIndexSize", fitIndexSize ? 1 : 0) != 0;
+	cacheSize			= settings->getInt(section, "CacheSize", cacheSize);
+}
+
+bool MeshProcessing::CalcNormals(IndexBuffer * ib, VertexBuffer * vb, NormalWeighting weighting, bool allowParallel)
+{
+	SQ_PROFILE_FUNCTION();
+
+	std::vector<uint32> wideIndices;
+	Job job;
+	if(!InitJob(ib, vb, wideIndices, job))
+		return false;
+
+	job.weighting = weighting;
+
+	std::vector<Face> faces(job.trianglesNum);
+	job.faces = faces.empty() ? NULL : &faces[0];
+
+	bool parallel = allowParallel && job.trianglesNum > PARALLEL_THRESHOLD;
+
+	if(!parallel)
+	{
+		//single scatter pass over triangles
+		for(int v = 0; v < job.vertsNum; ++v)
+		{
+			ComponentAt<vec3>(job, v, job.normalOffset).zero();
+		}
+
+		for(int t = 0; t < job.trianglesNum; ++t)
+		{
+			CalcFace(job, t);
+			for(int k = 0; k < 3; ++k)
+			{
+				AddNormal(faces[t], k, ComponentAt<vec3>(job, job.indices[t * 3 + k], job.normalOffset));
+			}
+		}
+
+		for(int v = 0; v < job.vertsNum; ++v)
+		{
+			vec3& normal = ComponentAt<vec3>(job, v, job.normalOffset);
+			normal = FinishNormal(normal);
+		}
+		return true;
+	}
+
+	//scatter would race on shared vertices, so faces are computed in parallel
+	//and every vertex gathers its corners through adjacency
+	TaskPool * pool = TaskPool::Default();
+	pool->parallelFor(job.trianglesNum, MIN_CHUNK_SIZE, FacesRange, &job);
+
+	std::vector<int> cornersStart, corners;
+	BuildAdjacency(job.indices, job.trianglesNum * 3, job.vertsNum, cornersStart, corners);
+	job.cornersStart	= &cornersStart[0];
+	job.corners			= corners.empty() ? NULL : &corners[0];
+
+	pool->parallelFor(job.vertsNum, MIN_CHUNK_SIZE, GatherNormalsRange, &job);
+
+	return true;
+}
+
+bool MeshProcessing::CalcTangents(IndexBuffer * ib, VertexBuffer * vb, bool allowParallel)
+{
+	SQ_PROFILE_FUNCTION();
+
+	if(vb == NULL || !vb->hasComponent(VertexBuffer::vcTexcoord) || !vb->hasComponent(VertexBuffer::vcTangentBinormal))
+		return false;
+
+	std::vector<uint32> wideIndices;
+	Job job;
+	if(!InitJob(ib, vb, wideIndices, job))
+		return false;
+
+	job.tangents		= true;
+	job.texcoordOffset	= vb->getComponentOffset(VertexBuffer::vcTexcoord);
+	job.tangentOffset	= vb->getComponentOffset(VertexBuffer::vcTangentBinormal);
+
+	std::vector<Face> faces(job.trianglesNum);
+	job.faces = faces.empty() ? NULL : &faces[0];
+
+	bool parallel = allowParallel && job.trianglesNum > PARALLEL_THRESHOLD;
+
+	if(!parallel)
+	{
+		std::vector<vec3> tangentSums(job.vertsNum, vec3::Zero());
+		std::vector<vec3> bitangentSums(job.vertsNum, vec3::Zero());
+
+		for(int t = 0; t < job.trianglesNum; ++t)
+		{
+			CalcFace(job, t);
+			for(int k = 0; k < 3; ++k)
+			{
+				uint32 v = job.indices[t * 3 + k];
+				AddTangent(faces[t], k, ComponentAt<vec3>(job, v, job.normalOffset), tangentSums[v], bitangentSums[v]);
+			}
+		}
+
+		for(int v = 0; v < job.vertsNum; ++v)
+		{
+			ComponentAt<vec4>(job, v, job.tangentOffset) =
+				FinishTangent(ComponentAt<vec3>(job, v, job.normalOffset), tangentSums[v], bitangentSums[v]);
+		}
+		return true;
+	}
+
+	TaskPool * pool = TaskPool::Default();
+	pool->parallelFor(job.trianglesNum, MIN_CHUNK_SIZE, FacesRange, &job);
+
+	std::vector<int> cornersStart, corners;
+	BuildAdjacency(job.indices, job.trianglesNum * 3, job.vertsNum, cornersStart, corners);
+	job.cornersStart	= &cornersStart[0];
+	job.corners			= corners.empty() ? NULL : &corners[0];
+
+	pool->parallelFor(job.vertsNum, MIN_CHUNK_SIZE, GatherTangentsRange, &job);
+
+	return true;
+}
+
+void MeshProcessing::ReadIndices(IndexBuffer * ib, std::vector<uint32>& outIndices)
+{
+	int indicesNum = (int)ib->getIndicesNum();
+	outIndices.resize(indicesNum);
+
+	if(ib->getIndexSize() == IndexBuffer::Index16)
+	{
+		const uint16 * src = (const uint16 *)ib->getIndexBuff();
+		for(int i = 0; i < indicesNum; ++i)
+		{
+			outIndices[i] = src[i];
+		}
+	}
+	else if(indicesNum > 0)
+	{
+		memcpy(&outIndices[0], ib->getIndexBuff(), indicesNum * sizeof(uint32));
+	}
+}
+
+float MeshProcessing::CalcACMR(const uint32 * indices, int indicesNum, int vertsNum, int cacheSize)
+{
+	int trianglesNum = indicesNum / 3;
+	if(trianglesNum == 0)
+		return 0;
+
+	//vertex is in FIFO cache while less than cacheSize vertices were added after it
+	std::vector<int> addedAt(vertsNum, -cacheSize - 1);
+	int time = 0;
+	int misses = 0;
+
+	for(int i = 0; i < trianglesNum * 3; ++i)
+	{
+		uint32 v = indices[i];
+		if(time - addedAt[v] > cacheSize)
+		{
+			addedAt[v] = time++;
+			++misses;
+		}
+	}
+
+	return misses / (float)trianglesNum;
+}
+
+int MeshProcessing::WeldVertices(VertexBuffer * vb, std::vector< std::vector<uint32> >& indexLists, float epsilon, std::vector<uint32>& remap)
+{
+	SQ_PROFILE_FUNCTION();
+
+	int vertsNum = (int)vb->getVertsNum();
+	size_t stride = vb->getVertexSize();
+	byte * verts = vb->getVerts();
+
+	remap.resize(vertsNum);
+	if(vertsNum == 0)
+		return 0;
+
+	bool exact = epsilon <= 0;
+
+	std::vector<char> floatWords(stride / 4, 0);
+	if(!exact)
+	{
+		MarkFloatComponent<VertexBuffer::vcPosition>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vcNormal>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vcTangentBinormal>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vcTexcoord>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vcTexcoord2>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vc4FloatBoneIndices>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vc4BoneWeights>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vc2BoneWeights>(vb, floatWords);
+		MarkFloatComponent<VertexBuffer::vcColor>(vb, floatWords);
+	}
+
+	size_t positionOffset = vb->getComponentOffset(VertexBuffer::vcPosition);
+
+	//exact: key is hash of vertex bytes; epsilon: key is position grid cell,
+	//cell size equals epsilon so matches are searched in neighbour cells too
+	std::unordered_map<uint64, int> firstInBucket;
+	std::vector<int> nextInBucket;
+	firstInBucket.reserve(vertsNum);
+	nextInBucket.reserve(vertsNum);
+
+	int uniqueNum = 0;
+
+	for(int v = 0; v < vertsNum; ++v)
+	{
+		const byte * vertex = verts + v * stride;
+		int found = -1;
+		uint64 key;
+
+		if(exact)
+		{
+			key = HashBytes(vertex, stride);
+			std::unordered_map<uint64, int>::const_iterator it = firstInBucket.find(key);
+			for(int u = (it != firstInBucket.end()) ? it->second : -1; u >= 0 && found < 0; u = nextInBucket[u])
+			{
+				if(memcmp(verts + u * stride, vertex, stride) == 0)
+					found = u;
+			}
+		}
+		else
+		{
+			const vec3& pos = *(const vec3 *)(vertex + positionOffset);
+			int x = CellCoord(pos.x, epsilon);
+			int y = CellCoord(pos.y, epsilon);
+			int z = CellCoord(pos.z, epsilon);
+			key = HashCell(x, y, z);
+
+			for(int n = 0; n < 27 && found < 0; ++n)
+			{
+				std::unordered_map<uint64, int>::const_iterator it = firstInBucket.find(HashCell(x + n % 3 - 1, y + (n / 3) % 3 - 1, z + n / 9 - 1));
+				for(int u = (it != firstInBucket.end()) ? it->second : -1; u >= 0 && found < 0; u = nextInBucket[u])
+				{
+					if(NearlyEqualVertices(verts + u * stride, vertex, floatWords, epsilon))
+						found = u;
+				}
+			}
+		}
+
+		if(found < 0)
+		{
+			//slots before v are processed already, so unique vertices are packed in place
+			found = uniqueNum++;
+			if(found != v)
+				memcpy(verts + found * stride, vertex, stride);
+
+			std::unordered_map<uint64, int>::iterator it = firstInBucket.find(key);
+			if(it != firstInBucket.end())
+			{
+				nextInBucket.push_back(it->second);
+				it->second = found;
+			}
+			else
+			{
+				nextInBucket.push_back(-1);
+				firstInBucket[key] = found;
+			}
+		}
+
+		remap[v] = (uint32)found;
+	}
+
+	for(size_t i = 0; i < indexLists.size(); ++i)
+	{
+		std::vector<uint32>& indices = indexLists[i];
+		for(size_t j = 0; j < indices.size(); ++j)
+		{
+			indices[j] = remap[indices[j]];
+		}
+	}
+
+	if(uniqueNum < vertsNum)
+		vb->resize(uniqueNum);
+
+	return uniqueNum;
+}
+
+void MeshProcessing::OptimizeVertexCache(uint32 * indices, int indicesNum, int vertsNum, int cacheSize, std::vector<int> * clusters)
+{
+	SQ_PROFILE_FUNCTION();
+
+	if(clusters != NULL)
+		clusters->clear();
+
+	int trianglesNum = indicesNum / 3;
+	if(trianglesNum == 0)
+		return;
+
+	std::vector<int> cornersStart, corners;
+	BuildAdjacency(indices, trianglesNum * 3, vertsNum, cornersStart, corners);
+
+	std::vector<int> liveTriangles(vertsNum);
+	for(int v = 0; v < vertsNum; ++v)
+	{
+		liveTriangles[v] = cornersStart[v + 1] - cornersStart[v];
+	}
+
+	std::vector<int> cacheTime(vertsNum, 0);
+	std::vector<char> emitted(trianglesNum, 0);
+	std::vector<uint32> deadEnd;
+	std::vector<uint32> candidates;
+	std::vector<uint32> output;
+	deadEnd.reserve(trianglesNum * 3);
+	output.reserve(trianglesNum * 3);
+
+	int time = cacheSize + 1;
+	int cursor = 0;
+	int fanning = -1;
+
+	while(output.size() < (size_t)trianglesNum * 3)
+	{
+		if(fanning < 0)
+		{
+			//dead end: take most recent vertex with live triangles, then next one in input order
+			while(!deadEnd.empty() && fanning < 0)
+			{
+				uint32 v = deadEnd.back();
+				deadEnd.pop_back();
+				if(liveTriangles[v] > 0)
+					fanning = (int)v;
+			}
+			while(fanning < 0 && cursor < vertsNum)
+			{
+				if(liveTriangles[cursor] > 0)
+					fanning = cursor;
+				++cursor;
+			}
+			if(fanning < 0)
+				break;
+
+			if(clusters != NULL)
+				clusters->push_back((int)output.size() / 3);
+		}
+
+		//emit all triangles around fanning vertex
+		candidates.clear();
+		for(int i = cornersStart[fanning]; i < cornersStart[fanning + 1]; ++i)
+		{
+			int triangle = corners[i] / 3;
+			if(emitted[triangle])
+				continue;
+			emitted[triangle] = 1;
+
+			for(int k = 0; k < 3; ++k)
+			{
+				uint32 v = indices[triangle * 3 + k];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				--liveTriangles[v];
+				if(time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+		}
+
+		//next fanning vertex is the oldest candidate which stays in cache after its triangles are emitted
+		int best = -1;
+		int bestPriority = -1;
+		for(size_t i = 0; i < candidates.size(); ++i)
+		{
+			uint32 v = candidates[i];
+			if(liveTriangles[v] <= 0)
+				continue;
+
+			int priority = 0;
+			if(time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = time - cacheTime[v];
+
+			if(priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = (int)v;
+			}
+		}
+		fanning = best;
+	}
+
+	memcpy(indices, &output[0], output.size() * sizeof(uint32));
+}
+
+void MeshProcessing::OptimizeOverdraw(uint32 * indices, int indicesNum, const VertexBuffer * vb, const std::vector<int>& clusters,
+	float threshold, int cacheSize)
+{
+	SQ_PROFILE_FUNCTION();
+
+	int trianglesNum = indicesNum / 3;
+	int vertsNum = (int)vb->getVertsNum();
+	if(trianglesNum == 0 || clusters.empty())
+		return;
+
+	float meshACMR = CalcACMR(indices, indicesNum, vertsNum, cacheSize);
+
+	//soft boundaries: cluster ends as soon as its own ACMR gets close to mesh ACMR,
+	//so reordering clusters costs little cache efficiency
+	std::vector<Cluster> sortClusters;
+	std::vector<int> addedAt(vertsNum, -cacheSize - 1);
+	int time = 0;
+
+	for(size_t c = 0; c < clusters.size(); ++c)
+	{
+		int end = (c + 1 < clusters.size()) ? clusters[c + 1] : trianglesNum;
+
+		Cluster cluster;
+		cluster.begin = clusters[c];
+		cluster.sortKey = 0;
+
+		time += cacheSize + 1;//cold cache
+		int misses = 0;
+
+		for(int t = cluster.begin; t < end; ++t)
+		{
+			for(int k = 0; k < 3; ++k)
+			{
+				uint32 v = indices[t * 3 + k];
+				if(time - addedAt[v] > cacheSize)
+				{
+					addedAt[v] = time++;
+					++misses;
+				}
+			}
+
+			if(t + 1 < end && misses <= threshold * meshACMR * (t + 1 - cluster.begin))
+			{
+				cluster.end = t + 1;
+				sortClusters.push_back(cluster);
+				cluster.begin = t + 1;
+				time += cacheSize + 1;
+				misses = 0;
+			}
+		}
+
+		cluster.end = end;
+		sortClusters.push_back(cluster);
+	}
+
+	//clusters facing away from mesh center occlude others, so they go first
+	size_t positionOffset = vb->getComponentOffset(VertexBuffer::vcPosition);
+	const byte * verts = vb->getVerts();
+	size_t stride = vb->getVertexSize();
+
+	#define _TRIANGLE_POINT(t, k) (*(const vec3 *)(verts + indices[(t) * 3 + (k)] * stride + positionOffset))
+
+	vec3 meshCenter(0, 0, 0);
+	float meshArea = 0;
+	std::vector<vec3> clusterCenters(sortClusters.size());
+	std::vector<vec3> clusterNormals(sortClusters.size());
+
+	for(size_t c = 0; c < sortClusters.size(); ++c)
+	{
+		vec3 center(0, 0, 0);
+		vec3 normal(0, 0, 0);
+		float area = 0;
+
+		for(int t = sortClusters[c].begin; t < sortClusters[c].end; ++t)
+		{
+			const vec3& p0 = _TRIANGLE_POINT(t, 0);
+			const vec3& p1 = _TRIANGLE_POINT(t, 1);
+			const vec3& p2 = _TRIANGLE_POINT(t, 2);
+
+			vec3 triNormal = (p1 - p0) ^ (p2 - p0);
+			float triArea = triNormal.len();
+
+			center += (p0 + p1 + p2) * (triArea / 3.0f);
+			normal += triNormal;
+			area += triArea;
+		}
+
+		meshCenter += center;
+		meshArea += area;
+
+		clusterCenters[c] = area > 0 ? center / area : _TRIANGLE_POINT(sortClusters[c].begin, 0);
+		clusterNormals[c] = normal;
+	}
+
+	#undef _TRIANGLE_POINT
+
+	if(meshArea > 0)
+		meshCenter /= meshArea;
+
+	for(size_t c = 0; c < sortClusters.size(); ++c)
+	{
+		vec3 normal = clusterNormals[c];
+		normal.safeNormalize();
+		sortClusters[c].sortKey = (clusterCenters[c] - meshCenter) * normal;
+	}
+
+	std::stable_sort(sortClusters.begin(), sortClusters.end(), CompareClusters);
+
+	std::vector<uint32> output;
+	output.reserve(trianglesNum * 3);
+	for(size_t c = 0; c < sortClusters.size(); ++c)
+	{
+		output.insert(output.end(), indices + sortClusters[c].begin * 3, indices + sortClusters[c].end * 3);
+	}
+
+	memcpy(indices, &output[0], output.size() * sizeof(uint32));
+}
+
+void MeshProcessing::OptimizeVertexFetch(VertexBuffer * vb, std::vector< std::vector<uint32> >& indexLists, std::vector<uint32>& remap)
+{
+	SQ_PROFILE_FUNCTION();
+
+	int vertsNum = (int)vb->getVertsNum();
+	size_t stride = vb->getVertexSize();
+
+	remap.assign(vertsNum, INVALID_INDEX);
+	uint32 next = 0;
+
+	for(size_t i = 0; i < indexLists.size(); ++i)
+	{
+		std::vector<uint32>& indices = indexLists[i];
+		for(size_t j = 0; j < indices.size(); ++j)
+		{
+			uint32& newIndex = remap[indices[j]];
+			if(newIndex == INVALID_INDEX)
+				newIndex = next++;
+			indices[j] = newIndex;
+		}
+	}
+
+	for(int v = 0; v < vertsNum; ++v)
+	{
+		if(remap[v] == INVALID_INDEX)
+			remap[v] = next++;
+	}
+
+	if(vertsNum == 0)
+		return;
+
+	std::vector<byte> oldVerts(vb->getVerts(), vb->getVerts() + vertsNum * stride);
+	for(int v = 0; v < vertsNum; ++v)
+	{
+		memcpy(vb->getVerts() + remap[v] * stride, &oldVerts[v * stride], stride);
+	}
+}
+
+int MeshProcessing::GetPackedVertexType(const VertexBuffer * vb, const PackingParams& params)
+{
+	if(!params.enabled || vb == NULL || !vb->hasComponent(VertexBuffer::vcNormal))
+		return 0;
+
+	int vertType = ReplaceComponent(vb->getVertType(), VertexBuffer::vcNormal, VertexBuffer::vcOctNormal);
+
+	if(vb->hasComponent(VertexBuffer::vcTangentBinormal))
+	{
+		vertType = ReplaceComponent(vertType, VertexBuffer::vcTangentBinormal, VertexBuffer::vcOctTangentBinormal);
+	}
+
+	if(params.texcoords && vb->hasComponent(VertexBuffer::vcTexcoord) && !vb->hasComponent(VertexBuffer::vcInt16Texcoord))
+	{
+		//tiled mapping may span range too wide for 16 bits
+		vec2 min, max;
+		CalcTexcoordRange(vb, min, max);
+		float maxError = 0.5f * maxValue(max.x - min.x, max.y - min.y) / INT16_STEPS;
+		if(maxError <= params.texcoordMaxError)
+		{
+			vertType = ReplaceComponent(vertType, VertexBuffer::vcTexcoord, VertexBuffer::vcInt16Texcoord);
+		}
+	}
+
+	if(params.bones && vb->hasComponent(VertexBuffer::vc4BoneWeights))
+	{
+		vertType = ReplaceComponent(vertType, VertexBuffer::vc4BoneWeights, VertexBuffer::vc4Int8BoneWeights);
+	}
+
+	if(params.bones && vb->hasComponent(VertexBuffer::vc4FloatBoneIndices))
+	{
+		float maxIndex = 0;
+		for(int i = 0; i < (int)vb->getVertsNum(); ++i)
+		{
+			const vec4& indices = vb->getComponent<VertexBuffer::vc4FloatBoneIndices>(i);
+			maxIndex = maxValue(maxValue(maxValue(maxIndex, indices.x), maxValue(indices.y, indices.z)), indices.w);
+		}
+		if(maxIndex < 128.0f)
+		{
+			vertType = ReplaceComponent(vertType, VertexBuffer::vc4FloatBoneIndices, VertexBuffer::vc4Int8BoneIndices);
+		}
+	}
+
+	if(params.positions && vb->hasComponent(VertexBuffer::vcPosition))
+	{
+		vertType = ReplaceComponent(vertType, VertexBuffer::vcPosition, VertexBuffer::vcInt16Position);
+	}
+
+	return vertType;
+}
+
+void MeshProcessing::PackVertices(const VertexBuffer * src, VertexBuffer * dst)
+{
+	SQ_PROFILE_FUNCTION();
+
+	int vertsNum = (int)minValue(src->getVertsNum(), dst->getVertsNum());
+
+	//components stored the same way are copied as is
+	std::vector<int> copiedComponents;
+	for(int vc = 0; vc < VertexBuffer::vcNum; ++vc)
+	{
+		if(src->hasComponent(vc) && dst->hasComponent(vc))
+			copiedComponents.push_back(vc);
+	}
+
+	//decode params
+
+	vec3 posMin(0, 0, 0), posScale(1, 1, 1);
+	if(dst->hasComponent(VertexBuffer::vcInt16Position))
+	{
+		vec3 posMax(0, 0, 0);
+		for(int i = 0; i < vertsNum; ++i)
+		{
+			const vec3& pos = src->getComponent<VertexBuffer::vcPosition>(i);
+			if(i == 0)
+			{
+				posMin = posMax = pos;
+				continue;
+			}
+			posMin = vec3(minValue(posMin.x, pos.x), minValue(posMin.y, pos.y), minValue(posMin.z, pos.z));
+			posMax = vec3(maxValue(posMax.x, pos.x), maxValue(posMax.y, pos.y), maxValue(posMax.z, pos.z));
+		}
+		posScale = vec3(Int16Scale(posMin.x, posMax.x), Int16Scale(posMin.y, posMax.y), Int16Scale(posMin.z, posMax.z));
+		dst->setPositionDecode(posScale, vec3(posMin.x + posScale.x * INT16_OFFSET,
+			posMin.y + posScale.y * INT16_OFFSET, posMin.z + posScale.z * INT16_OFFSET));
+	}
+
+	vec2 uvMin(0, 0), uvScale(1, 1);
+	bool packTexcoords = dst->hasComponent(VertexBuffer::vcInt16Texcoord) && src->hasComponent(VertexBuffer::vcTexcoord);
+	if(packTexcoords)
+	{
+		vec2 uvMax;
+		CalcTexcoordRange(src, uvMin, uvMax);
+		uvScale = vec2(Int16Scale(uvMin.x, uvMax.x), Int16Scale(uvMin.y, uvMax.y));
+		dst->setTexcoordDecode(vec4(uvScale.x, uvScale.y, uvMin.x + uvScale.x * INT16_OFFSET, uvMin.y + uvScale.y * INT16_OFFSET));
+	}
+
+	//vertices
+
+	for(int i = 0; i < vertsNum; ++i)
+	{
+		for(size_t j = 0; j < copiedComponents.size(); ++j)
+		{
+			int vc = copiedComponents[j];
+			memcpy(dst->getComponentAddr(i, vc), src->getComponentAddr(i, vc), src->getComponentSize(vc));
+		}
+
+		if(dst->hasComponent(VertexBuffer::vcInt16Position))
+		{
+			const vec3& pos = src->getComponent<VertexBuffer::vcPosition>(i);
+			dst->setComponent<VertexBuffer::vcInt16Position>(i, tuple4s(QuantizeInt16(pos.x, posMin.x, posScale.x),
+				QuantizeInt16(pos.y, posMin.y, posScale.y), QuantizeInt16(pos.z, posMin.z, posScale.z), 0));
+		}
+
+		if(dst->hasComponent(VertexBuffer::vcOctNormal))
+		{
+			int x = 0, y = 0;
+			OctQuantize(src->getComponent<VertexBuffer::vcNormal>(i), 32767.0f, x, y);
+			dst->setComponent<VertexBuffer::vcOctNormal>(i, tuple2s((short)x, (short)y));
+		}
+
+		if(dst->hasComponent(VertexBuffer::vcOctTangentBinormal))
+		{
+			const vec4& tangent = src->getComponent<VertexBuffer::vcTangentBinormal>(i);
+			int x = 0, y = 0;
+			OctQuantize(vec3(tangent.x, tangent.y, tangent.z), 127.0f, x, y);
+			dst->setComponent<VertexBuffer::vcOctTangentBinormal>(i, tuple4b((int8)x, (int8)y, tangent.w < 0 ? -127 : 127, 0));
+		}
+
+		if(packTexcoords)
+		{
+			const vec2& uv = src->getComponent<VertexBuffer::vcTexcoord>(i);
+			dst->setComponent<VertexBuffer::vcInt16Texcoord>(i, tuple2s(QuantizeInt16(uv.x, uvMin.x, uvScale.x),
+				QuantizeInt16(uv.y, uvMin.y, uvScale.y)));
+		}
+
+		if(dst->hasComponent(VertexBuffer::vc4Int8BoneIndices) && src->hasComponent(VertexBuffer::vc4FloatBoneIndices))
+		{
+			const vec4& indices = src->getComponent<VertexBuffer::vc4FloatBoneIndices>(i);
+			dst->setComponent<VertexBuffer::vc4Int8BoneIndices>(i, tuple4b((int8)indices.x, (int8)indices.y, (int8)indices.z, (int8)indices.w));
+		}
+
+		if(dst->hasComponent(VertexBuffer::vc4Int8BoneWeights) && src->hasComponent(VertexBuffer::vc4BoneWeights))
+		{
+			const vec4& weights = src->getComponent<VertexBuffer::vc4BoneWeights>(i);
+			float sum = weights.x + weights.y + weights.z + weights.w;
+			float scale = sum > EPSILON ? 255.0f / sum : 0.0f;
+
+			int quantized[4];
+			int quantizedSum = 0, largest = 0;
+			for(int k = 0; k < 4; ++k)
+			{
+				quantized[k] = (int)clamp(floorf(weights[k] * scale + 0.5f), 0.0f, 255.0f);
+				quantizedSum += quantized[k];
+				if(quantized[k] > quantized[largest])
+					largest = k;
+			}
+
+			//weights keep summing to one after rounding
+			if(quantizedSum > 0)
+				quantized[largest] += 255 - quantizedSum;
+
+			dst->setComponent<VertexBuffer::vc4Int8BoneWeights>(i,
+				tuple4ub((uint8)quantized[0], (uint8)quantized[1], (uint8)quantized[2], (uint8)quantized[3]));
+		}
+	}
+}
+
+}//namespace Resource {
+
+}//namespace Squirrel {
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <Render/IndexBuffer.h>
+#include <Render/VertexBuffer.h>
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+
+namespace Resource {
+
+using namespace RenderData;
+
+//Linear time normals and tangent basis generation for indexed triangle lists.
+//Triangles are processed once to get face vectors and corner weights, then vertices
+//accumulate them from their corners; large meshes are split between TaskPool workers.
+//Also offline optimization of index and vertex order and vertex packing, used at model import.
+class SQRESOURCE_API MeshProcessing
+{
+public:
+
+	enum NormalWeighting
+	{
+		nwUniform = 0,//every face counts the same
+		nwArea,//by face area
+		nwAngle//by face angle at vertex, does not depend on tessellation
+	};
+
+	//meshes with triangles number above this are processed in parallel
+	static const int PARALLEL_THRESHOLD = 16384;
+
+	//FIFO post transform cache size assumed by optimization and ACMR reports
+	static const int VERTEX_CACHE_SIZE = 16;
+
+	struct SQRESOURCE_API OptimizationParams
+	{
+		OptimizationParams();
+
+		//reads parameters from settings section
+		void readSettings(const char_t * section);
+
+		bool	weld;
+		float	weldEpsilon;//float attributes closer than this are welded, 0 for exact match only
+		bool	vertexCache;
+		bool	overdraw;
+		float	overdrawThreshold;//cluster may end once its ACMR is within this factor of whole mesh ACMR
+		bool	vertexFetch;
+		bool	fitIndexSize;//use 16 bit indices for meshes with less than 65536 vertices
+		int		cacheSize;
+	};
+
+	struct SQRESOURCE_API PackingParams
+	{
+		PackingParams();
+
+		//reads parameters from settings section
+		void readSettings(const char_t * section);
+
+		bool	enabled;//normals and tangents are packed always
+		bool	texcoords;
+		float	texcoordMaxError;//16 bit texcoords are used if quantization error is below this
+		bool	bones;
+		bool	positions;//16 bit positions relative to bounds, off by default as precision depends on mesh size
+	};
+
+public:
+
+	//replaces normals of vb with averaged normals of faces around vertices
+	static bool CalcNormals(IndexBuffer * ib, VertexBuffer * vb, NormalWeighting weighting = nwAngle, bool allowParallel = true);
+
+	//fills vcTangentBinormal: xyz is tangent orthogonal to vertex normal, w is bitangent sign;
+	//follows MikkTSpace rules: face tangents are projected to vertex normal plane and weighted by angle,
+	//mirrored texture mapping gets negative sign; vertices are not split
+	static bool CalcTangents(IndexBuffer * ib, VertexBuffer * vb, bool allowParallel = true);
+
+	//average cache misses per triangle for FIFO cache of given size
+	static float CalcACMR(const uint32 * indices, int indicesNum, int vertsNum, int cacheSize = VERTEX_CACHE_SIZE);
+
+	//merges equal vertices of vb and remaps indexLists, all of them must index vb;
+	//remap receives new index of every old vertex, returns new vertices number
+	static int WeldVertices(VertexBuffer * vb, std::vector< std::vector<uint32> >& indexLists, float epsilon, std::vector<uint32>& remap);
+
+	//Tipsify triangles reordering (Sander et al. 2007) for triangle list,
+	//clusters receives first triangle of every run which starts with cold cache
+	static void OptimizeVertexCache(uint32 * indices, int indicesNum, int vertsNum, int cacheSize = VERTEX_CACHE_SIZE, std::vector<int> * clusters = NULL);
+
+	//splits cache optimized clusters further and orders them so that outward facing ones are drawn first
+	static void OptimizeOverdraw(uint32 * indices, int indicesNum, const VertexBuffer * vb, const std::vector<int>& clusters,
+		float threshold = 1.05f, int cacheSize = VERTEX_CACHE_SIZE);
+
+	//orders vertices of vb by first use in indexLists, unused vertices go last;
+	//remap receives new index of every old vertex
+	static void OptimizeVertexFetch(VertexBuffer * vb, std::vector< std::vector<uint32> >& indexLists, std::vector<uint32>& remap);
+
+	//vertex type of vb packed with params, 0 if vb can not be packed (has no normals or packed already)
+	static int GetPackedVertexType(const VertexBuffer * vb, const PackingParams& params);
+
+	//fills dst created with GetPackedVertexType of src and sets its decode params
+	static void PackVertices(const VertexBuffer * src, VertexBuffer * dst);
+
+	//copies indices into list of 32 bit indices
+	static void ReadIndices(IndexBuffer * ib, std::vector<uint32>& outIndices);
+};
+
+}//namespace Resource {
+
+}//namespace Squirrel {
@@ -4,8 +4,12 @@
 #include <Render/IRender.h>
 #include <FileSystem/Path.h>
 #include <Common/Settings.h>
+#include <Common/Log.h>
 #include <set>
+#include <map>
 #include <stack>
+#include <algorithm>
+#include <stdio.h>
 
 #define _MESH_NODE_ANIM_FLAGS	AnimatableResource::ANIM_TRANSLATE_XYZ | \
 								AnimatableResource::ANIM_ROTATE_XYZ | \
@@ -21,11 +25,13 @@ using namespace FileSystem;
 Model::Model(void)
 {
 	mLocalMaterials		= NULL;
+	mDeferLinkResources	= false;
 }
 
 Model::Model(Mesh * mesh, _ID matId, std::string textureName)
 {
 	mLocalMaterials		= NULL;
+	mDeferLinkResources	= false;
 
 	mMeshes.push_back(mesh);
 	Node * modelNode = addNode(NULL, false);
@@ -65,6 +71,7 @@ void Model::destroy()
 	mSkins.clear();
 
 	mNodesList.clear();
+	mDeferredLinks.clear();
 
 	DELETE_PTR(mLocalMaterials);
 
@@ -133,6 +140,37 @@ void Model::updateBoundingVolume()
 	setChanged();
 }
 
+size_t Model::getMemorySize()
+{
+	size_t size = 0;
+
+	for(size_t i = 0; i < mSharedVBs.size(); ++i)
+	{
+		size += mSharedVBs[i]->getVertsNum() * mSharedVBs[i]->getVertexSize();
+	}
+
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		Mesh * mesh = mMeshes[i];
+		if(mesh == NULL)
+			continue;
+
+		VertexBuffer * vb = mesh->getVertexBuffer();
+		if(vb != NULL && getSharedVBIndex(vb) < 0)
+		{
+			size += vb->getVertsNum() * vb->getVertexSize();
+		}
+
+		IndexBuffer * ib = mesh->getIndexBuffer();
+		if(ib != NULL)
+		{
+			size += ib->getIndicesNum() * (size_t)ib->getIndexSize();
+		}
+	}
+
+	return size;
+}
+
 int Model::getSharedVBIndex(VertexBuffer * vb)
 {
 	for(size_t i = 0; i < mSharedVBs.size(); ++i)
@@ -385,7 +423,8 @@ bool Model::saveMesh(Data * data, Mesh *mesh)
 
 		//save buffer data
 		long buffSize = ib->getIndexSize() * ib->getIndicesNum();
-		ASSERT(ib->map(true, false));
+		bool mapped = ib->map(true, false);
+		ASSERT(mapped);
 		data->putData( ib->getIndexBuff(), buffSize );
 		ib->unmap();
 	}
@@ -557,9 +596,11 @@ bool Model::saveNode(Data * data, Model::Node *modelNode)
 	return true;
 }
 
-_ID Model::loadTexture(const std::string& texName)
+_ID Model::loadTexture(const std::string& texName, bool async)
 {
-	Texture * texture = TextureStorage::Active()->loadTexture( texName );
+	TextureStorage * texStorage = TextureStorage::Active();
+	//material textures are streamed by on-screen size of bodies
+	Texture * texture = async ? texStorage->loadTextureAsync( texName, 0.0f, NULL, true ) : texStorage->loadTexture( texName, false, false, true );
 
 	if(texture == NULL)
 	{
@@ -576,6 +617,78 @@ _ID Model::loadTexture(const std::string& texName)
 	return textureId;
 }
 
+void Model::loadLinkResources()
+{
+	for(size_t i = 0; i < mDeferredLinks.size(); ++i)
+	{
+		DeferredLink& deferred = mDeferredLinks[i];
+		loadLinkResources(deferred.node->mMatLinks[deferred.linkIndex], deferred.resources, true);
+	}
+
+	mDeferredLinks.clear();
+	mDeferLinkResources = false;
+}
+
+void Model::loadLinkResources(MaterialLink& matLink, const LinkResources& resources, bool async)
+{
+	_ID textureId = -1;
+
+	//diffuse
+	if(resources.diffuse.length() > 0)
+	{
+		textureId = loadTexture( resources.diffuse, async );
+		if(textureId >= 0)
+			matLink.idTexDiffuse = textureId;
+	}
+
+	//specular
+	if(resources.specular.length() > 0)
+	{
+		textureId = loadTexture( resources.specular, async );
+		if(textureId >= 0)
+			matLink.idTexSpecular = textureId;
+	}
+
+	//height/bump
+	textureId = -1;
+	if(resources.heightBump.length() > 0)
+	{
+		textureId = loadTexture( resources.heightBump, async );
+		if(textureId >= 0)
+			matLink.idTexHeightBump = textureId;
+	}
+
+	//TODO: move this functionality to editor code
+	bool forceNHMGen = Settings::Default()->getInt("Resources", "ForceNHMGen", 1) != 0;
+	if(textureId < 0 && forceNHMGen)
+	{
+		matLink.generateBumpHeightMap(resources.diffuse);
+		if(matLink.idTexHeightBump >= 0)
+		{
+			setChanged();
+		}
+	}
+
+	//detail
+	if(resources.detail.length() > 0)
+	{
+		TextureStorage * texStorage = TextureStorage::Active();
+		Texture * texture = async ? texStorage->addAsync( resources.detail ) : texStorage->add( resources.detail );
+		if(texture != NULL)
+			matLink.idTexDetail = texture->getID();
+	}
+
+	//material
+
+	MaterialLibrary * matLib = getLocalMaterials();
+	if(matLib == NULL)
+		matLib = MaterialLibrary::Active();
+
+	matLink.mMaterial = matLib->getByName( resources.material );
+	if(matLink.mMaterial)
+		matLink.idMaterial = matLink.mMaterial->getID();
+}
+
 void Model::MaterialLink::generateBumpHeightMap(const std::string& diffTexName)
 {
 	TextureStorage * texStorage = TextureStorage::Active();
@@ -624,77 +737,28 @@ bool Model::loadNode(Data * data, Node *modelNode)
 			}
 		}
 
-		//load textures
-
-		_ID textureId = -1;
-		std::string objName;
-
-		std::string diffTextName;
-		_ID diffTexId= -1;
-
-		//diffuse
-		data->readString( objName, '\0' );
-		if(objName.length() > 0)
-		{
-			textureId = loadTexture( objName );
-			if(textureId >= 0)
-				matLink.idTexDiffuse = textureId;
-		}
-		diffTextName = objName;
-		diffTexId = textureId;
-
-		//specular
-		textureId = -1;
-		data->readString( objName, '\0' );
-		if(objName.length() > 0)
-		{
-			textureId = loadTexture( objName );
-			if(textureId >= 0)
-				matLink.idTexSpecular = textureId;
-		}
+		//load textures and material
 
-		//height/bump
-		textureId = -1;
-		data->readString( objName, '\0' );
-		if(objName.length() > 0)
-		{
-			textureId = loadTexture( objName );
-			if(textureId >= 0)
-				matLink.idTexHeightBump = textureId;
-		}
+		LinkResources resources;
+		data->readString( resources.diffuse,	'\0' );
+		data->readString( resources.specular,	'\0' );
+		data->readString( resources.heightBump,	'\0' );
+		data->readString( resources.detail,		'\0' );
+		data->readString( resources.material,	'\0' );
 
-		//TODO: move this functionality to editor code
-		bool forceNHMGen = Settings::Default()->getInt("Resources", "ForceNHMGen", 1) != 0;
-		if(textureId < 0 && forceNHMGen)
+		if(mDeferLinkResources)
 		{
-			matLink.generateBumpHeightMap(diffTextName);
-			if(matLink.idTexHeightBump >= 0)
-			{
-				setChanged();
-			}
+			DeferredLink deferred;
+			deferred.node		= modelNode;
+			deferred.linkIndex	= modelNode->mMatLinks.size() - 1;
+			deferred.resources	= resources;
+			mDeferredLinks.push_back(deferred);
 		}
-
-		//detail
-		textureId = -1;
-		data->readString( objName, '\0' );
-		if(objName.length() > 0)
+		else
 		{
-			textureId = TextureStorage::Active()->addRetId( objName );
-			if(textureId >= 0)
-				matLink.idTexDetail = textureId;
+			loadLinkResources(matLink, resources, false);
 		}
 
-		//load material
-
-		MaterialLibrary * matLib = getLocalMaterials();
-		if(matLib == NULL)
-			matLib = MaterialLibrary::Active();
-
-		data->readString( objName, '\0' );
-		matLink.mMaterial = matLib->getByName( objName );
-		if(matLink.mMaterial)
-			matLink.idMaterial = matLink.mMaterial->getID();
-
 		//load index buffer offset
 		if(data->getVersion() >= 101)
 		{
@@ -740,9 +804,15 @@ bool Model::saveVB(Data * data, VertexBuffer *vb)
 		
 	//save buffer data
 	long buffSize = vb->getVertexSize() * vb->getVertsNum();
-	ASSERT(vb->map(true, false));
+	bool mapped = vb->map(true, false);
+	ASSERT(mapped);
 	data->putData( vb->getVerts(), buffSize );
 	vb->unmap();
+
+	//save decode params of packed components
+	data->putVar( vb->getPositionScale() );
+	data->putVar( vb->getPositionBias() );
+	data->putVar( vb->getTexcoordDecode() );
 	
 	return true;
 }
@@ -763,6 +833,15 @@ VertexBuffer * Model::loadVB(Data * data)
 	long buffSize = vb->getVertexSize() * vb->getVertsNum();	
 	data->readBytes( vb->getVerts(), buffSize );
 
+	//load decode params of packed components
+	if(data->getVersion() >= 102)
+	{
+		vec3 positionScale = data->readVar<vec3>();
+		vec3 positionBias = data->readVar<vec3>();
+		vb->setPositionDecode( positionScale, positionBias );
+		vb->setTexcoordDecode( data->readVar<vec4>() );
+	}
+
 	return vb;
 }
 
@@ -798,7 +877,10 @@ void Model::prepareForGPUSkinning(int bonesPerVertex, bool addTangentAndBinormal
 
 		if(skinnedVBs.find( oldVB ) != skinnedVBs.end()) continue;
 
-		if(oldVB->hasComponent(VertexBuffer::vc4FloatBoneIndices)) continue;
+		if(oldVB->hasComponent(VertexBuffer::vc4FloatBoneIndices) || oldVB->hasComponent(VertexBuffer::vc4Int8BoneIndices)) continue;
+
+		//packed buffers are skinned before packing, their normals can't be processed here
+		if(oldVB->isPacked()) continue;
 
 		int newVertexType = oldVB->getVertType();
 		newVertexType |= VCI2VT(VertexBuffer::vc4FloatBoneIndices);//check hardware support
@@ -858,7 +940,11 @@ void Model::generateTangentAndBinormal()
 
 		VertexBuffer * oldVB = mesh->getVertexBuffer();
 
-		if(oldVB->hasComponent(VertexBuffer::vcTangentBinormal))
+		if(oldVB->hasComponent(VertexBuffer::vcTangentBinormal) || oldVB->hasComponent(VertexBuffer::vcOctTangentBinormal))
+			continue;
+
+		//tangent basis is calculated from float normals
+		if(oldVB->isPacked())
 			continue;
 
 		int newVertexType = oldVB->getVertType();
@@ -882,6 +968,246 @@ void Model::generateTangentAndBinormal()
 	}
 }
 
+void Model::optimizeMeshes(const MeshProcessing::OptimizationParams& params)
+{
+	//meshes and skins grouped by vertex buffer, shared VBs are processed with all their meshes at once
+
+	std::vector<VertexBuffer *> vbs;
+	std::map<VertexBuffer *, std::vector<Mesh *> > vbMeshes;
+	std::map<VertexBuffer *, std::set<Skin *> > vbSkins;
+
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		Mesh * mesh = mMeshes[i];
+		if(mesh == NULL || mesh->getVertexBuffer() == NULL || mesh->getIndexBuffer() == NULL)
+			continue;
+
+		VertexBuffer * vb = mesh->getVertexBuffer();
+		if(vb->getVerts() == NULL || !vb->hasComponent(VertexBuffer::vcPosition))
+			continue;
+
+		std::vector<Mesh *>& meshes = vbMeshes[vb];
+		if(meshes.empty())
+			vbs.push_back(vb);
+		meshes.push_back(mesh);
+	}
+
+	std::stack<Node *> processingNodes;
+
+	Node::NODE_LIST::iterator it;
+	for(it = mNodesList.begin(); it != mNodesList.end(); ++it )
+		processingNodes.push(it->get());
+
+	while(processingNodes.size() > 0)
+	{
+		Node * node = processingNodes.top();
+		processingNodes.pop();
+
+		for(it = node->mChildren.begin(); it != node->mChildren.end(); ++it )
+			processingNodes.push(it->get());
+
+		if(node->mSkin == NULL)
+			continue;
+
+		for(size_t i = 0; i < node->mMatLinks.size(); ++i)
+		{
+			if(node->mMatLinks[i].mMesh != NULL)
+				vbSkins[node->mMatLinks[i].mMesh->getVertexBuffer()].insert(node->mSkin);
+		}
+	}
+
+	Render::IRender * render = Render::IRender::GetActive();
+
+	for(size_t vbIndex = 0; vbIndex < vbs.size(); ++vbIndex)
+	{
+		VertexBuffer * vb = vbs[vbIndex];
+		std::vector<Mesh *>& meshes = vbMeshes[vb];
+		std::set<Skin *>& skins = vbSkins[vb];
+
+		int vertsNumBefore = (int)vb->getVertsNum();
+
+		std::vector< std::vector<uint32> > indexLists(meshes.size());
+		std::vector<float> acmrBefore(meshes.size());
+
+		size_t i;
+		for(i = 0; i < meshes.size(); ++i)
+		{
+			MeshProcessing::ReadIndices(meshes[i]->getIndexBuffer(), indexLists[i]);
+			acmrBefore[i] = MeshProcessing::CalcACMR(indexLists[i].empty() ? NULL : &indexLists[i][0],
+				(int)indexLists[i].size(), vertsNumBefore, params.cacheSize);
+		}
+
+		//new index of every original vertex
+		std::vector<uint32> vertexMapping(vertsNumBefore);
+		for(int v = 0; v < vertsNumBefore; ++v)
+		{
+			vertexMapping[v] = (uint32)v;
+		}
+
+		std::vector<uint32> remap;
+
+		//joints are stored per vertex and move with vertices, partial skins stay as they are
+		bool skinsMatch = true;
+		for(std::set<Skin *>::iterator itSkin = skins.begin(); itSkin != skins.end(); ++itSkin)
+		{
+			if((*itSkin)->joints.getCount() != vertsNumBefore)
+				skinsMatch = false;
+		}
+
+		//without GPU skinning data vertices with different joints could look equal
+		bool canWeld = skins.empty() || (skinsMatch && vb->hasComponent(VertexBuffer::vc4BoneWeights));
+
+		if(params.weld && canWeld)
+		{
+			MeshProcessing::WeldVertices(vb, indexLists, params.weldEpsilon, remap);
+			for(int v = 0; v < vertsNumBefore; ++v)
+			{
+				vertexMapping[v] = remap[vertexMapping[v]];
+			}
+		}
+
+		int vertsNum = (int)vb->getVertsNum();
+
+		for(i = 0; i < meshes.size(); ++i)
+		{
+			if(meshes[i]->getIndexBuffer()->getPolyType() != IndexBuffer::ptTriangles || indexLists[i].empty())
+				continue;
+
+			uint32 * indices = &indexLists[i][0];
+			int indicesNum = (int)indexLists[i].size();
+
+			std::vector<int> clusters;
+			if(params.vertexCache)
+				MeshProcessing::OptimizeVertexCache(indices, indicesNum, vertsNum, params.cacheSize, &clusters);
+			if(params.overdraw && !clusters.empty())
+				MeshProcessing::OptimizeOverdraw(indices, indicesNum, vb, clusters, params.overdrawThreshold, params.cacheSize);
+		}
+
+		if(params.vertexFetch && skinsMatch)
+		{
+			MeshProcessing::OptimizeVertexFetch(vb, indexLists, remap);
+			for(int v = 0; v < vertsNumBefore; ++v)
+			{
+				vertexMapping[v] = remap[vertexMapping[v]];
+			}
+		}
+
+		vb->update(0, (int)(vb->getVertsNum() * vb->getVertexSize()));
+
+		//welded vertices take joints of first of them
+		for(std::set<Skin *>::iterator itSkin = skins.begin(); itSkin != skins.end() && skinsMatch; ++itSkin)
+		{
+			Skin * skin = *itSkin;
+
+			Skin::JointsBuffer originalJoints( skin->joints );
+			std::vector<char> assigned(vertsNum, 0);
+
+			skin->joints.setCount( vertsNum );
+			for(int v = 0; v < vertsNumBefore; ++v)
+			{
+				uint32 newIndex = vertexMapping[v];
+				if(!assigned[newIndex])
+				{
+					skin->joints.getData()[ newIndex ] = originalJoints.getData()[ v ];
+					assigned[newIndex] = 1;
+				}
+			}
+		}
+
+		//write indices back, with smaller index size if possible
+
+		for(i = 0; i < meshes.size(); ++i)
+		{
+			Mesh * mesh = meshes[i];
+			IndexBuffer * ib = mesh->getIndexBuffer();
+
+			IndexBuffer::IndexSize indexSizeBefore = ib->getIndexSize();
+			IndexBuffer::IndexSize indexSize = indexSizeBefore;
+			if(params.fitIndexSize)
+				indexSize = vertsNum < POW_2_16 ? IndexBuffer::Index16 : IndexBuffer::Index32;
+
+			if(indexSize != ib->getIndexSize())
+			{
+				IndexBuffer * newIB = render->createIndexBuffer((int)ib->getIndicesNum(), indexSize);
+				newIB->setPolyType( ib->getPolyType() );
+				newIB->setPolyOri( ib->getPolyOri() );
+				newIB->setStorageType( ib->getStorageType() );
+				mesh->setIndexBuffer( newIB );
+				ib = newIB;
+			}
+
+			const std::vector<uint32>& indices = indexLists[i];
+			for(uint j = 0; j < indices.size(); ++j)
+			{
+				ib->setIndex(j, indices[j]);
+			}
+			ib->update(0, (int)(indices.size() * ib->getIndexSize()));
+
+			float acmrAfter = MeshProcessing::CalcACMR(indices.empty() ? NULL : &indices[0], (int)indices.size(), vertsNum, params.cacheSize);
+
+			char msg[256];
+			sprintf(msg, "Mesh %d: triangles %d, vertices %d -> %d, ACMR %.3f -> %.3f, index size %d -> %d",
+				(int)(std::find(mMeshes.begin(), mMeshes.end(), mesh) - mMeshes.begin()), (int)(indices.size() / 3),
+				vertsNumBefore, vertsNum, acmrBefore[i], acmrAfter, (int)indexSizeBefore * 8, (int)indexSize * 8);
+			Log::Instance().report("Resource::Model::optimizeMeshes", msg, Log::sevMessage);
+		}
+
+		setChanged();
+	}
+}
+
+void Model::packVertices(const MeshProcessing::PackingParams& params)
+{
+	Render::IRender * render = Render::IRender::GetActive();
+
+	std::set<VertexBuffer *> packedVBs;
+
+	size_t sizeBefore = 0;
+	size_t sizeAfter = 0;
+
+	for(size_t i = 0; i < mMeshes.size(); ++i)
+	{
+		Mesh * mesh = mMeshes[i];
+		if(mesh == NULL || mesh->getVertexBuffer() == NULL)
+			continue;
+
+		VertexBuffer * vb = mesh->getVertexBuffer();
+		if(vb->getVerts() == NULL || packedVBs.find(vb) != packedVBs.end())
+			continue;
+
+		packedVBs.insert(vb);
+
+		int packedType = MeshProcessing::GetPackedVertexType(vb, params);
+		if(packedType == 0)
+			continue;
+
+		VertexBuffer * packedVB = render->createVertexBuffer(packedType, (int)vb->getVertsNum());
+		MeshProcessing::PackVertices(vb, packedVB);
+
+		sizeBefore	+= vb->getVertexSize() * vb->getVertsNum();
+		sizeAfter	+= packedVB->getVertexSize() * packedVB->getVertsNum();
+
+		char msg[256];
+		sprintf(msg, "Mesh %d: vertices %d, vertex size %d -> %d",
+			(int)i, (int)vb->getVertsNum(), (int)vb->getVertexSize(), (int)packedVB->getVertexSize());
+		Log::Instance().report("Resource::Model::packVertices", msg, Log::sevMessage);
+
+		VertexBuffer::MoveContent(packedVB, vb);
+		vb->setStorageType(VertexBuffer::stGPUStaticMemory);
+
+		DELETE_PTR(packedVB);
+	}
+
+	if(sizeBefore > 0)
+	{
+		char msg[256];
+		sprintf(msg, "Vertex data %d -> %d bytes", (int)sizeBefore, (int)sizeAfter);
+		Log::Instance().report("Resource::Model::packVertices", msg, Log::sevMessage);
+
+		setChanged();
+	}
+}
+
 void Model::merge(VertexBuffer * vb, Skin * skin, int bonesPerVertex)
 {
 	ASSERT(skin->joints.getCount() <= (int)vb->getVertsNum());
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Mesh.h"
+#include "MeshProcessing.h"
 #include "Skin.h"
 #include "MaterialLibrary.h"
 #include "TextureStorage.h"
@@ -102,6 +103,16 @@ public://nested types
 		NODE_LIST mChildren;
 	};
 
+	//names of resources referenced by material link
+	struct LinkResources
+	{
+		std::string diffuse;
+		std::string specular;
+		std::string heightBump;
+		std::string detail;
+		std::string material;
+	};
+
 	typedef std::vector< Mesh* >			MESH_MAP;
 	typedef std::vector< Skin* >			SKIN_MAP;
 	typedef std::vector< VertexBuffer* >	VB_MAP;
@@ -115,6 +126,12 @@ public:
 	bool load(Data * data);
 	bool save(Data * data);
 
+	//while set, load does not touch texture storage and global materials but remembers resources of
+	//material links, so model may be loaded by loader thread; main thread then calls loadLinkResources
+	void setDeferLinkResources(bool defer) { mDeferLinkResources = defer; }
+	//loads textures asynchronously if there is active loader
+	void loadLinkResources();
+
 	void calcBoundingVolume();
 	void updateBoundingVolume();
 
@@ -128,6 +145,9 @@ public:
 
 	VB_MAP *				getSharedVBs()		{ return &mSharedVBs;}
 
+	//vertex and index buffers of meshes
+	virtual size_t getMemorySize();
+
 	MaterialLibrary *		getLocalMaterials()	{ return mLocalMaterials; }
 	void					setLocalMaterials(MaterialLibrary * matLib)	{ 
 		DELETE_PTR(mLocalMaterials); mLocalMaterials = matLib; 
@@ -139,6 +159,14 @@ public:
 	void prepareForGPUSkinning(int bonesPerVertex, bool addTangentAndBinormal);
 	void generateTangentAndBinormal();
 
+	//offline import stage: welds vertices, reorders triangles and vertices, fits index size;
+	//logs vertices number and ACMR of every mesh before and after
+	void optimizeMeshes(const MeshProcessing::OptimizationParams& params);
+
+	//offline import stage: converts vertex buffers to packed formats decoded by shaders,
+	//call after all processing which reads float components
+	void packVertices(const MeshProcessing::PackingParams& params);
+
 	Node * findNode(_ID nodeId);
 
 	template<class _Pred>
@@ -188,7 +216,9 @@ protected:
 
 	void merge(VertexBuffer * vb, Skin * skin, int bonesPerVertex);
 
-	_ID loadTexture(const std::string& texName);
+	_ID loadTexture(const std::string& texName, bool async = false);
+
+	void loadLinkResources(MaterialLink& matLink, const LinkResources& resources, bool async);
 
 	int getSharedVBIndex(VertexBuffer * vb);
 
@@ -204,6 +234,16 @@ protected:
 	Node::NODE_LIST			mNodesList;
 
 	VB_MAP	mSharedVBs;
+
+	struct DeferredLink
+	{
+		Node *			node;
+		size_t			linkIndex;
+		LinkResources	resources;
+	};
+
+	bool						mDeferLinkResources;
+	std::vector<DeferredLink>	mDeferredLinks;
 };
 
 	
@@ -29,6 +29,9 @@ public:
 	virtual const char_t * getImportingExtension() const = 0;
 
 	virtual const char_t * getImportingStageDesc() const = 0;
+
+	//progress of current stage in [0, 1], negative if unknown
+	virtual float getImportingProgress() const { return -1.0f; }
 };
 
 
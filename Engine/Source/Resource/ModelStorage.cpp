@@ -1,5 +1,7 @@
 #include "ModelStorage.h"
 #include <Common/Data.h>
+#include <Common/Settings.h>
+#include <Common/Log.h>
 #include <set>
 
 namespace Squirrel {
@@ -13,9 +15,10 @@ ModelStorage * ModelStorage::Active()
 	return sActiveLibrary;
 }
 
-ModelStorage::ModelStorage()
+ModelStorage::ModelStorage():
+	mPlaceholder(NULL)
 {
-	
+	mStorageName = "Models";
 }
 
 ModelStorage::~ModelStorage()
@@ -24,9 +27,11 @@ ModelStorage::~ModelStorage()
 	{
 		sActiveLibrary = NULL;
 	}
+
+	DELETE_PTR(mPlaceholder);
 }
 
-#define _CURENT_VERSION					101
+#define _CURENT_VERSION					102
 
 #define _COTAINER_KEY					0x2048
 
@@ -34,7 +39,17 @@ ModelStorage::~ModelStorage()
 #define _COTAINER_MATERIAL_PALETTE_TAG	0x0051
 #define _COTAINER_SKELETON_TAG			0x0014
 
+const char * ModelStorage::NativeModelExtension()
+{
+	return "sqmdl";
+}
+
 bool ModelStorage::save(Model* resource, Data * data, std::string& fileName)
+{
+	return SaveModel(resource, data);
+}
+
+bool ModelStorage::SaveModel(Model * model, Data * data)
 {
 	const int32 capacityIncr = 1024 * 16;//16 kBytes for increment
 	data->setCapacityIncrement( capacityIncr );
@@ -44,31 +59,89 @@ bool ModelStorage::save(Model* resource, Data * data, std::string& fileName)
 	data->putInt32( _CURENT_VERSION );
 
 	//save model
-	return resource->save( data );
+	return model->save( data );
 }
 
-Model* ModelStorage::load(Data * data)
+bool ModelStorage::read(Model * model, Data * data)
 {
-	Model * model = new Model;
-	ASSERT( model != NULL );
-
 	ASSERT( data != NULL );
 	ASSERT( data->getLength() > 0 );
 
 	int fileKey = data->readInt32();
-	ASSERT( fileKey == _COTAINER_KEY );
+	if( fileKey != _COTAINER_KEY )
+	{
+		Log::Instance().streamError("ModelStorage::read") << "Wrong file key of model " << data->getFileName();
+		return false;
+	}
 
 	int version = data->readInt32();
 
 	data->setVersion(version);
 
-	model->load(data);
+	return model->load(data);
+}
+
+Model* ModelStorage::load(Data * data)
+{
+	Model * model = new Model;
+	ASSERT( model != NULL );
+
+	bool isOk = read(model, data);
+	ASSERT( isOk );
 
 	DELETE_PTR(data);
 
 	return model;
 }
 
+Model* ModelStorage::createAsync()
+{
+	return new Model;
+}
+
+bool ModelStorage::parseAsync(Model* model, Data * data)
+{
+	//textures and materials are bound on main thread
+	model->setDeferLinkResources(true);
+
+	bool isOk = read(model, data);
+
+	DELETE_PTR(data);
+
+	return isOk;
+}
+
+bool ModelStorage::finishAsync(Model* model)
+{
+	model->loadLinkResources();
+	return true;
+}
+
+Model::Node * ModelStorage::getPlaceholder()
+{
+	if(mPlaceholder == NULL)
+	{
+		float halfSize = Settings::Default()->getFloat("Resources", "PlaceholderModelSize", 1.0f) * 0.5f;
+
+		BoxBuilder builder(vec3(-halfSize, -halfSize, -halfSize), vec3(halfSize, halfSize, halfSize), VT_PNT);
+		Mesh * mesh = builder.buildMesh();
+		mesh->getVertexBuffer()->setStorageType( VertexBuffer::stGPUStaticMemory );
+		mesh->getIndexBuffer()->setStorageType( IndexBuffer::stGPUStaticMemory );
+
+		mPlaceholder = new Model;
+		mPlaceholder->getMeshes()->push_back(mesh);
+
+		Model::Node * node = mPlaceholder->addNode(NULL, false);
+		node->mMatLinks.push_back(Model::MaterialLink());
+		node->mMatLinks.back().mMeshId	= 0;
+		node->mMatLinks.back().mMesh	= mesh;
+
+		mPlaceholder->calcBoundingVolume();
+	}
+
+	return mPlaceholder->getNodes()->front().get();
+}
+
 void ModelStorage::setAsActive()
 {
 	sActiveLibrary = this;
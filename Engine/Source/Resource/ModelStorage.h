@@ -23,9 +23,25 @@ public:
 	void setAsActive();
 	static ModelStorage * Active();
 
+	static const char * NativeModelExtension();
+
+	//writes model in native format
+	static bool SaveModel(Model * model, Data * data);
+
+	//box node rendered in place of models being loaded asynchronously, created on first call (main thread only)
+	Model::Node * getPlaceholder();
+
 protected:
 	virtual bool save(Model* resource, Data * data, std::string& fileName);
 	virtual Model* load(Data * data);
+
+	virtual Model* createAsync();
+	virtual bool parseAsync(Model* resource, Data * data);
+	virtual bool finishAsync(Model* resource);
+
+	bool read(Model * model, Data * data);
+
+	Model * mPlaceholder;
 };
 
 
@@ -288,6 +288,25 @@ bool OGGLoader::load(Audio::IBuffer * targetBuffer, double offset, double durati
 	return targetBuffer->fill(mFrequency, mBitsPerSample, mChannels, bytesWritten, mBuffer);
 }
 
+uint32 OGGLoader::decode(void * dst, uint32 size)
+{
+	if(!isOpened())
+		return 0;
+
+	const uint32 blockAlign = mBitsPerSample / 8 * mChannels;
+	size -= size % blockAlign;
+
+	return decodeOggVorbis(mOVFile, (char *)dst, size, mChannels);
+}
+
+bool OGGLoader::rewind()
+{
+	if(!isOpened() || !mIsSeekable)
+		return false;
+
+	return _ov_time_seek(mOVFile, 0) == 0;
+}
+
 void OGGLoader::close()
 {
 	// Close OggVorbis stream
@@ -26,6 +26,11 @@ public:
 	virtual bool load(Audio::IBuffer * targetBuffer, double offset, double duration);
 	virtual void close();
 
+	virtual uint32 decode(void * dst, uint32 size);
+	virtual bool rewind();
+
+	virtual SoundLoader * createNew() { return new OGGLoader(); }
+
 	virtual bool isSeekable(Data * srcData) { return mIsSeekable; }
 };
 
@@ -24,10 +24,10 @@ Program::~Program(void)
 
 IProgram * Program::buildRenderProgram(const std::string& params)
 {
-	std::string msg("Building program \"");
-	msg += getName() + "\" with parameters \"";
-	msg += params + "\"...";
-	Log::Instance().report("Resource::Program::buildRenderProgram", msg.c_str(), Log::sevMessage);
+	//programs may be built in bursts while new materials appear
+	static Log::RateLimit sBuildLogLimit(20);
+	Log::Instance().stream("Resource::Program::buildRenderProgram", Log::sevMessage, sBuildLogLimit) << 
+		"Building program \"" << getName() << "\" with parameters \"" << params << "\"...";
 
 	//create program
 	IProgram * renderProgram = IRender::GetActive()->createProgram();
@@ -42,6 +42,10 @@ IProgram * Program::buildRenderProgram(const std::string& params)
 
 IProgram *	Program::getRenderProgram(const std::string& params)
 {
+	//source is not loaded yet
+	if(isLoading())
+		return NULL;
+
 	PROGRAMS_MAP::iterator it = mRenderPrograms.find(params);
 
 	//found program
@@ -95,6 +99,8 @@ std::string Program::resolveIncludeInLine(const std::string& inLine)
 	
 	size_t length = closeBracket - openBracket - 1;
 	std::string includeFile = line.substr(openBracket + 1, length);
+
+	mIncludes.push_back(includeFile);
 	
 	return mSourceLoader->loadSource(includeFile.c_str(), relativeInclude ? this : NULL);
 }
@@ -122,9 +128,17 @@ std::string Program::resolveIncludes(std::string source)
 void Program::load(Data * data)
 {
 	mRenderPrograms.clear();
+	mIncludes.clear();
 	mShaderSource = resolveIncludes(std::string((char_t *)data->getData(), data->getLength()));
 }
 
+void Program::replaceSource(Program * other)
+{
+	mRenderPrograms.clear();
+	mShaderSource.swap(other->mShaderSource);
+	mIncludes.swap(other->mIncludes);
+}
+
 }//namespace Resource { 
 
 }//namespace Squirrel {
\ No newline at end of file
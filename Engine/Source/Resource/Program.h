@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 #include <Common/types.h>
 #include <Render/IProgram.h>
 #include "ResourceStorage.h"
@@ -29,6 +30,7 @@ private:
 
 	PROGRAMS_MAP		mRenderPrograms;
 	std::string			mShaderSource;
+	std::vector<std::string>	mIncludes;
 
 	SourceLoader *		mSourceLoader;
 	
@@ -40,6 +42,16 @@ public:
 	
 	void setSourceLoader(SourceLoader * sourceLoader) { mSourceLoader = sourceLoader; }
 
+	//source with resolved includes
+	const std::string& getSource() const { return mShaderSource; }
+
+	//files included by source, names as given to source loader
+	const std::vector<std::string>& getIncludes() const { return mIncludes; }
+
+	//takes source of other program (e.g. reloaded one), render programs are rebuilt on demand
+	void replaceSource(Program * other);
+
+	//NULL while program is loaded asynchronously
 	Render::IProgram *	getRenderProgram(const std::string& params);
 
 private:
@@ -16,7 +16,7 @@ ProgramStorage * ProgramStorage::Active()
 
 ProgramStorage::ProgramStorage()
 {
-	
+	mStorageName = "Programs";
 }
 
 ProgramStorage::~ProgramStorage()
@@ -42,30 +42,48 @@ Program* ProgramStorage::load(Data * data)
 	return program;
 }
 
-void ProgramStorage::checkModifications()
+Program* ProgramStorage::createAsync()
 {
+	Program * program = new Program;
+	program->setSourceLoader(this);
+	return program;
+}
+
+bool ProgramStorage::parseAsync(Program* program, Data * data)
+{
+	//includes are resolved here as well
+	program->load(data);
+
+	DELETE_PTR(data);
+
+	return true;
+}
+
+void ProgramStorage::getDependents(const std::string& fileName, std::vector<Program*>& outResources)
+{
+	ResourceStorage<Program>::getDependents(fileName, outResources);
+
+	//programs including changed file
 	for(_ID i = 0; i < getSize(); ++i)
 	{
 		Program * prg = this->get(i);
-		if(prg && !prg->isChanged())
+		if(prg && !prg->isLoading())
 		{
-			time_t oldTime = prg->getTimestamp();
-			time_t newTime = getTimestamp(prg->getName());
-			if(newTime > oldTime)
+			const std::vector<std::string>& includes = prg->getIncludes();
+			if(std::find(includes.begin(), includes.end(), fileName) != includes.end())
 			{
-				Data * data = getResourceData(prg->getName());
-				if(data)
-				{
-					prg->load(data);
-					prg->setTimestamp(newTime);
-
-					Log::Instance().stream("ProgramStorage::checkModifications") << "Updated shader source for program " << prg->getName() << "";
-				}
+				outResources.push_back(prg);
 			}
 		}
 	}
 }
 
+bool ProgramStorage::replaceContent(Program* program, Program* reloaded)
+{
+	program->replaceSource(reloaded);
+	return true;
+}
+
 void ProgramStorage::setAsActive()
 {
 	sActiveLibrary = this;
@@ -78,7 +96,11 @@ std::string ProgramStorage::loadSource(const char_t * sourceFile, StoredObject *
 	if(data == NULL)
 		return "";
 	
-	return std::string((const char_t *)data->getData(), data->getLength());
+	std::string source((const char_t *)data->getData(), data->getLength());
+
+	DELETE_PTR(data);
+
+	return source;
 }
 
 }//namespace Resource { 
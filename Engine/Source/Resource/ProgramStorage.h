@@ -26,10 +26,15 @@ public:
 	
 	std::string loadSource(const char_t * sourceFile, StoredObject * relativeTo = NULL);
 
-	void checkModifications();
-
 protected:
 	virtual Program* load(Data * data);
+
+	virtual Program* createAsync();
+	virtual bool parseAsync(Program* resource, Data * data);
+
+	virtual void getDependents(const std::string& fileName, std::vector<Program*>& outResources);
+	virtual bool supportsReload() { return true; }
+	virtual bool replaceContent(Program* resource, Program* reloaded);
 };
 
 
@@ -13,7 +13,18 @@ ResourceManager::ResourceManager():
 	mProgramStorage(new ProgramStorage),
 	mSoundStorage(new SoundStorage)
 {
-	
+	//unreferenced resources stay cached till storage exceeds its budget, 0 - release immediately
+	const size_t MB = 1024 * 1024;
+	mTextureStorage->setMemoryBudget( Settings::Default()->getInt("Resources", "TextureMemoryBudget", 256) * MB );
+	mModelStorage->setMemoryBudget( Settings::Default()->getInt("Resources", "ModelMemoryBudget", 128) * MB );
+	mSoundStorage->setMemoryBudget( Settings::Default()->getInt("Resources", "SoundMemoryBudget", 64) * MB );
+
+	//no loader threads - addAsync loads synchronously
+	int loaderThreadsNum = Settings::Default()->getInt("Resources", "LoaderThreads", 1);
+	if(loaderThreadsNum > 0)
+	{
+		mAsyncLoader.reset(new AsyncLoader(loaderThreadsNum));
+	}
 }
 
 ResourceManager::~ResourceManager()
@@ -28,6 +39,11 @@ void ResourceManager::bind()
 	mModelStorage		-> setAsActive();
 	mProgramStorage		-> setAsActive();
 	mSoundStorage		-> setAsActive();
+
+	if(mAsyncLoader.get() != NULL)
+	{
+		mAsyncLoader	-> setAsActive();
+	}
 }
 
 void ResourceManager::initContentSource(const std::string& section)
@@ -47,6 +63,22 @@ void ResourceManager::initContentSource(const std::string& section)
 	std::string soundsPath = Settings::Default()->getString(section.c_str(), "Sounds storage", "Sounds");
 	soundsPath = FileSystem::Path::GetAbsPath(soundsPath);
 	mSoundStorage->initContentSource( soundsPath );
+
+	//changed files are picked up by checkModifications
+	if(Settings::Default()->getInt(section.c_str(), "HotReload", 1) != 0)
+	{
+		uint32 pollPeriod = (uint32)Settings::Default()->getInt(section.c_str(), "HotReloadPollPeriod", FileSystem::FileWatcher::DEFAULT_POLL_PERIOD_MS);
+		mTextureStorage->watchContentSource( pollPeriod );
+		mModelStorage->watchContentSource( pollPeriod );
+		mProgramStorage->watchContentSource( pollPeriod );
+	}
+}
+
+void ResourceManager::checkModifications()
+{
+	mTextureStorage->checkModifications();
+	mModelStorage->checkModifications();
+	mProgramStorage->checkModifications();
 }
 
 }//namespace Resource { 
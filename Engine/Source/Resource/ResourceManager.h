@@ -4,6 +4,7 @@
 #include "TextureStorage.h"
 #include "ProgramStorage.h"
 #include "SoundStorage.h"
+#include "AsyncLoader.h"
 #include <memory>
 
 namespace Squirrel {
@@ -16,6 +17,8 @@ class SQRESOURCE_API ResourceManager
 	std::auto_ptr<ModelStorage>		mModelStorage;
 	std::auto_ptr<ProgramStorage>	mProgramStorage;
 	std::auto_ptr<SoundStorage>		mSoundStorage;
+	//declared last to be destroyed first, while storages are alive
+	std::auto_ptr<AsyncLoader>		mAsyncLoader;
 
 public:
 	ResourceManager();
@@ -24,11 +27,15 @@ public:
 	void bind();
 	void initContentSource(const std::string& section);
 
+	//reloads changed textures, models and programs
+	void checkModifications();
+
 	inline MaterialLibrary *	getMaterialLibrary()	{ return mMaterialLibrary.get(); }
 	inline TextureStorage *		getTextureStorage()		{ return mTextureStorage.get(); }
 	inline ModelStorage *		getModelStorage()		{ return mModelStorage.get(); }
 	inline ProgramStorage *		getProgramStorage()		{ return mProgramStorage.get(); }
 	inline SoundStorage *		getSoundStorage()		{ return mSoundStorage.get(); }
+	inline AsyncLoader *		getAsyncLoader()		{ return mAsyncLoader.get(); }
 
 	inline void	setMaterialLibrary	(MaterialLibrary *	ml)	{ mMaterialLibrary.reset(ml); }
 	inline void	setTextureStorage	(TextureStorage *	ts)	{ mTextureStorage.reset(ts); }
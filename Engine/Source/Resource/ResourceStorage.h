@@ -2,11 +2,19 @@
 
 #include <Common/IDMap.h>
 #include <FileSystem/FileStorageFactory.h>
+#include <FileSystem/FileWatcher.h>
 #include <Common/Data.h>
 #include <Common/Log.h>
 #include <Common/Types.h>
 #include <Common/Macros.h>
+#include <Common/Profiler.h>
 #include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include "AsyncLoader.h"
 #include "macros.h"
 
 namespace Squirrel {
@@ -20,14 +28,27 @@ using namespace FileSystem;
 
 class SQRESOURCE_API StoredObject
 {
+public:
+
+	enum LoadState
+	{
+		lsLoaded = 0,
+		lsLoading,//added asynchronously and not finished yet, content must not be touched
+		lsFailed
+	};
+
+private:
+
 	std::string		mName;
 	_ID				mID;
 	uint			mUse;//reference counting
 	bool			mChanged;
 	time_t			mTimestamp;
+	LoadState		mLoadState;
+	uint64			mReleaseOrder;//when it became unreferenced last time, for LRU eviction
 
 public:
-	StoredObject(): mUse(0), mID(_INVALID_ID), mChanged(false), mTimestamp(0) {}
+	StoredObject(): mUse(0), mID(_INVALID_ID), mChanged(false), mTimestamp(0), mLoadState(lsLoaded), mReleaseOrder(0) {}
 	virtual ~StoredObject() {}
 
 	const std::string&	getName	()	const		{return mName;}
@@ -49,6 +70,16 @@ public:
 		mChanged = flag;
 	}
 
+	uint64	getReleaseOrder() const			{ return mReleaseOrder; }
+	void	setReleaseOrder(uint64 order)	{ mReleaseOrder = order; }
+
+	//memory taken by content (e.g. texture levels, vertex and index buffers), bytes
+	virtual size_t getMemorySize()		{ return 0; }
+
+	LoadState	getLoadState() const			{ return mLoadState; }
+	void		setLoadState(LoadState state)	{ mLoadState = state; }
+	bool		isLoading() const				{ return mLoadState == lsLoading; }
+
 private:
 };
 
@@ -56,20 +87,124 @@ template<class _TResource>
 class /*SQRESOURCE_API*/ ResourceStorage:
 	protected IDMap<_TResource*>
 {
+	//reads and parses resource on loader thread and finishes it by storage on main one
+	class LoadRequest:
+		public AsyncLoader::Request
+	{
+		ResourceStorage *	mStorage;
+		_TResource *		mResource;
+		std::string			mFileName;
+
+	public:
+		LoadRequest(ResourceStorage * storage, _TResource * resource, const std::string& fileName):
+			mStorage(storage), mResource(resource), mFileName(fileName) {}
+
+		virtual bool parse()
+		{
+			Data * resourceData = mStorage->getResourceData(mFileName);
+			if(resourceData == NULL)
+			{
+				Log::Instance().streamError("ResourceStorage::parse") << "Failed to read resource " << mFileName.c_str();
+				return false;
+			}
+			return mStorage->parseAsync(mResource, resourceData);
+		}
+
+		virtual bool finish(bool parsed)
+		{
+			mStorage->mLoadRequests.erase(mResource);
+			bool loaded = parsed && mStorage->finishAsync(mResource);
+			mResource->setLoadState(loaded ? StoredObject::lsLoaded : StoredObject::lsFailed);
+			//memory size is known now
+			mStorage->mDirty = true;
+			return loaded;
+		}
+	};
+
+	//parses changed file into new resource on loader thread, then storage moves its content
+	//to existing resource on main one, so pointers to resource stay valid
+	class ReloadRequest:
+		public AsyncLoader::Request
+	{
+		ResourceStorage *	mStorage;
+		_TResource *		mResource;//referenced till request is finished
+		_TResource *		mReloaded;
+		std::string			mFileName;
+
+	public:
+		ReloadRequest(ResourceStorage * storage, _TResource * resource, _TResource * reloaded):
+			mStorage(storage), mResource(resource), mReloaded(reloaded), mFileName(resource->getName()) {}
+
+		virtual bool parse()
+		{
+			Data * resourceData = mStorage->getResourceData(mFileName);
+			if(resourceData == NULL)
+			{
+				Log::Instance().streamError("ResourceStorage::reload") << "Failed to read resource " << mFileName.c_str();
+				return false;
+			}
+			return mStorage->parseAsync(mReloaded, resourceData);
+		}
+
+		virtual bool finish(bool parsed)
+		{
+			bool reloaded = parsed && mStorage->replaceContent(mResource, mReloaded);
+			if(reloaded)
+			{
+				mResource->setTimestamp( mStorage->getTimestamp(mFileName) );
+				Log::Instance().stream("ResourceStorage::reload") << "Reloaded " << mFileName.c_str();
+			}
+			else
+			{
+				Log::Instance().streamError("ResourceStorage::reload") << "Failed to reload " << mFileName.c_str();
+			}
+
+			DELETE_PTR(mReloaded);
+			mStorage->release(mResource->getID());
+			return reloaded;
+		}
+	};
+
+public:
+
+	struct CacheStats
+	{
+		int		hitsNum;//unreferenced cached resources requested again
+		int		missesNum;//resources loaded
+		int		evictionsNum;
+		size_t	memorySize;//all resources, updated by cleanUp
+		size_t	unusedMemorySize;//unreferenced cached resources
+	};
+
 protected:
 	std::auto_ptr<FileStorage> mContentSource;
+	std::mutex mContentSourceMutex;//content source is read by loader threads as well
 	std::string mExtension;
+	std::string mStorageName;
 	bool mDirty;
+	size_t mMemoryBudget;
+	uint64 mReleaseCounter;
 	bool mAllowOverwriting;
 	bool mMapFiles;
+	int mAsyncQueue;
+	CacheStats mCacheStats;
+	std::string mContentPath;
+	std::auto_ptr<FileWatcher> mWatcher;
+	std::set<_TResource *> mOutdated;//changed while used by storage which does not support reloading
+	std::map<_TResource *, LoadRequest *> mLoadRequests;//submitted by addAsync and not finished yet, owned by loader
 
 protected://abstract class - hide constructor
 	ResourceStorage()
 	{
 		mExtension = "";
+		mStorageName = "Resources";
 		mDirty = false;
+		mMemoryBudget = 0;
+		mReleaseCounter = 0;
+		memset(&mCacheStats, 0, sizeof(mCacheStats));
 		mAllowOverwriting = true;
 		mMapFiles = true;
+		mAsyncQueue = -1;
 	}
 public:
 	virtual ~ResourceStorage()
@@ -86,10 +221,64 @@ public:
 		if(contentSource != NULL)
 		{
 			mContentSource.reset( contentSource );
+			mContentPath = path;
 		}
 	}
 	FileStorage * getContentSource() { return mContentSource.get(); }
 
+	//starts watching of content source folder for checkModifications, false if it is not a folder
+	bool watchContentSource(uint32 pollPeriodMs = FileWatcher::DEFAULT_POLL_PERIOD_MS)
+	{
+		mWatcher.reset();
+
+		if(mContentPath.empty())
+			return false;
+
+		mWatcher.reset( new FileWatcher(mContentPath, pollPeriodMs) );
+		if(!mWatcher->isWatching())
+		{
+			mWatcher.reset();
+			return false;
+		}
+
+		return true;
+	}
+
+	//reloads resources which files have changed since last call and resources depending on them
+	//(e.g. programs including changed file); files are read and parsed by loader threads if there are ones
+	void checkModifications()
+	{
+		if(mWatcher.get() == NULL)
+			return;
+
+		std::vector<std::string> changedFiles;
+		mWatcher->takeChanges(changedFiles);
+		if(changedFiles.empty())
+			return;
+
+		SQ_PROFILE_ZONE("ResourceStorage::checkModifications");
+
+		std::vector<_TResource *> changed;
+		for(size_t i = 0; i < changedFiles.size(); ++i)
+		{
+			//skip files written by storage itself
+			_TResource * obj = getByName( changedFiles[i] );
+			if(obj != NULL && obj->getTimestamp() == getTimestamp(changedFiles[i]))
+				continue;
+
+			getDependents(changedFiles[i], changed);
+		}
+
+		//several changed files may be included by one resource
+		std::sort(changed.begin(), changed.end());
+		changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+		for(size_t i = 0; i < changed.size(); ++i)
+		{
+			reload(changed[i]);
+		}
+	}
+
 	void setExtension(const std::string& extension) { mExtension = extension; }
 	std::string getExtension() { return mExtension; }
 
@@ -98,6 +287,14 @@ public:
 
 public:
 
+	const std::string& getStorageName() const { return mStorageName; }
+
+	//unreferenced resources are cached while memory of storage is within budget, zero budget disables caching
+	void setMemoryBudget(size_t bytes) { mMemoryBudget = bytes; mDirty = true; }
+	size_t getMemoryBudget() const { return mMemoryBudget; }
+
+	const CacheStats& getCacheStats() const { return mCacheStats; }
+
 	_ID	addNew(const std::string& fileName, _TResource * obj)
 	{
 		obj->setChanged();
@@ -107,6 +304,8 @@ public:
 
 	Data * getResourceData(const std::string& fileName)
 	{
+		std::unique_lock<std::mutex> lock(mContentSourceMutex);
+
 		Data * resourceData = NULL;
 		if(mContentSource.get() != NULL)
 		{
@@ -133,9 +332,66 @@ public:
 		return obj != NULL ? obj->getID() : _INVALID_ID;
 	}
 
+	//resource being loaded asynchronously is finished on calling thread first, NULL is returned if it fails
 	_TResource * add(const std::string& fileName)
 	{
-		return add_internal(fileName, this);
+		_TResource * obj = add_internal(fileName, this);
+		if(obj != NULL && obj->isLoading() && !finishLoading(obj))
+		{
+			release(obj->getID());
+			return NULL;
+		}
+		return obj;
+	}
+
+	//returns resource at once while it is read and parsed by loader threads and finished on main thread
+	//by AsyncLoader::update; till then resource is placeholder (isLoading) which content must not be touched
+	//(add of the same resource finishes it at once).
+	//Position is used to load nearest to view point resources first.
+	//Loads synchronously if there is no active loader or storage does not support asynchronous loading.
+	_TResource * addAsync(const std::string& fileName, float priority = 0.0f, const Math::vec3 * position = NULL)
+	{
+		_TResource * obj = findForUse( fileName );
+		if(obj == NULL)
+		{
+			AsyncLoader * loader = AsyncLoader::Active();
+			if(loader == NULL)
+				return add(fileName);
+
+			obj = createAsync();
+			if(obj == NULL)
+				return add(fileName);
+
+			if(mAsyncQueue < 0)
+				mAsyncQueue = loader->getQueue(mStorageName.c_str());
+
+			obj->setLoadState(StoredObject::lsLoading);
+			add_internal( fileName, obj );
+			++mCacheStats.missesNum;
+
+			LoadRequest * request = new LoadRequest(this, obj, fileName);
+			request->mPriority = priority;
+			if(position != NULL)
+			{
+				request->mPosition		= *position;
+				request->mHasPosition	= true;
+			}
+			mLoadRequests[obj] = request;
+			loader->submit(request, mAsyncQueue);
+		}
+		obj->incrUse();
+		return obj;
+	}
+
+	bool hasResourceFile(const std::string& fileName)
+	{
+		std::unique_lock<std::mutex> lock(mContentSourceMutex);
+
+		if(mContentSource.get() != NULL)
+		{
+			return mContentSource.get()->hasFile( fileName );
+		}
+		return FileStorage::IsFileExist( fileName.c_str() );
 	}
 
 	_TResource * getByName(const std::string& name)
@@ -165,28 +421,73 @@ public:
 		if( obj == NULL ) return;
 		if( obj->decrUse() <= 0 )
 		{
+			obj->setReleaseOrder( ++mReleaseCounter );
 			mDirty = true;
 		}
 	}
 
 	//"garbage collection" :)
+	//deletes unreferenced resources, least recently released first, till storage fits memory budget
 	void cleanUp()
 	{
 		if(!mDirty) return;
 
+		SQ_PROFILE_ZONE("ResourceStorage::cleanUp");
+
+		//sizes may change after loading (e.g. when finished asynchronously), so they are summed here
+		size_t memorySize = 0;
+		size_t unusedMemorySize = 0;
+
+		std::vector<_TResource *> unused;
+
 		for(_ID i = 0; i < IDMap<_TResource*>::getSize(); ++i)
 		{
 			_TResource * obj = IDMap<_TResource*>::get(i);
 			if(obj)
 			{
-				if( obj->getUse() <= 0 )
+				size_t size = obj->getMemorySize();
+				memorySize += size;
+
+				//loading resources are referenced by loader
+				if( obj->getUse() <= 0 && !obj->isLoading() )
 				{
-					delete obj;
-					IDMap<_TResource*>::del(i--);
+					//outdated resource is dropped regardless of budget to be loaded from changed file next time
+					if(mOutdated.erase(obj) > 0)
+					{
+						memorySize -= size;
+						IDMap<_TResource*>::del(i);
+						delete obj;
+						continue;
+					}
+
+					unusedMemorySize += size;
+					unused.push_back(obj);
 				}
 			}
 		}
 
+		std::sort(unused.begin(), unused.end(), ReleasedEarlier);
+
+		for(size_t i = 0; i < unused.size(); ++i)
+		{
+			if(mMemoryBudget > 0 && memorySize <= mMemoryBudget)
+				break;
+
+			_TResource * obj = unused[i];
+
+			size_t size = obj->getMemorySize();
+			memorySize -= size;
+			unusedMemorySize -= size;
+
+			IDMap<_TResource*>::del( obj->getID() );
+			delete obj;
+
+			++mCacheStats.evictionsNum;
+		}
+
+		mCacheStats.memorySize = memorySize;
+		mCacheStats.unusedMemorySize = unusedMemorySize;
+
 		mDirty = false;
 	}
 
@@ -196,7 +497,7 @@ public:
 		for(_ID i = 0; i < IDMap<_TResource*>::getSize(); ++i)
 		{
 			_TResource * obj = IDMap<_TResource*>::get(i);
-			if(obj)
+			if(obj && !obj->isLoading())
 			{
 				if( obj->isChanged() )
 				{
@@ -227,8 +528,33 @@ protected:
 	virtual _TResource* load(Data * data) = 0;
 	virtual bool save(_TResource* resource, Data * data, std::string& fileName) { return false; }
 
+	//asynchronous loading, see addAsync:
+	//createAsync makes empty resource (NULL if storage does not support asynchronous loading),
+	//parseAsync fills it with data on loader thread and cares about releasing data memory,
+	//finishAsync completes it on main thread (e.g. creates GPU objects)
+	virtual _TResource* createAsync() { return NULL; }
+	virtual bool parseAsync(_TResource* resource, Data * data) { DELETE_PTR(data); return false; }
+	virtual bool finishAsync(_TResource* resource) { return true; }
+
+	//reloading, see checkModifications:
+	//getDependents adds resources to be reloaded when given file changes,
+	//storages which support reloading of used resources return true from supportsReload
+	//and move content of resource parsed by parseAsync to existing one in replaceContent
+	virtual void getDependents(const std::string& fileName, std::vector<_TResource*>& outResources)
+	{
+		_TResource * obj = getByName( fileName );
+		if(obj != NULL)
+		{
+			outResources.push_back( obj );
+		}
+	}
+	virtual bool supportsReload() { return false; }
+	virtual bool replaceContent(_TResource* resource, _TResource* reloaded) { return false; }
+
 	time_t getTimestamp(const std::string& fileName)
 	{
+		std::unique_lock<std::mutex> lock(mContentSourceMutex);
+
 		if(mContentSource.get() != NULL)
 		{
 			return mContentSource->getFileModificationTime(fileName);
@@ -239,13 +565,31 @@ protected:
 		}
 	}
 
+	//finds resource to be referenced, counts cache hit if it was unreferenced
+	_TResource * findForUse(const std::string& fileName)
+	{
+		_TResource * obj = getByName( fileName );
+		if(obj != NULL && obj->getUse() <= 0)
+		{
+			++mCacheStats.hitsNum;
+		}
+		return obj;
+	}
+
+	static bool ReleasedEarlier(const _TResource * a, const _TResource * b)
+	{
+		return a->getReleaseOrder() < b->getReleaseOrder();
+	}
+
 	template <class TLoader>
 	_TResource * add_internal(const std::string& fileName, TLoader * loader)
 	{
 		//find resource if existed such one
-		_TResource * obj = getByName( fileName );
+		_TResource * obj = findForUse( fileName );
 		if(obj == NULL)
 		{
+			SQ_PROFILE_ZONE("ResourceStorage::load");
+
 			//if inexisted then load it and add to map
 			Data * resourceData = getResourceData(fileName);
 			if(resourceData == NULL)
@@ -260,6 +604,8 @@ protected:
 			if(obj == NULL)
 				return NULL;
 			add_internal( fileName, obj );
+
+			++mCacheStats.missesNum;
 		}
 		obj->incrUse();
 		return obj;
@@ -267,6 +613,8 @@ protected:
 
 	_ID	add_internal(const std::string& fileName, _TResource * obj)
 	{
+		mDirty = true;
+
 		obj->setName(fileName);
 		obj->setID( IDMap<_TResource*>::add(obj) );
 		obj->setTimestamp( getTimestamp(fileName) );
@@ -275,6 +623,64 @@ protected:
 
 private:
 
+	//finishes resource submitted by addAsync on calling thread, so its content can be used at once
+	bool finishLoading(_TResource * resource)
+	{
+		typename std::map<_TResource *, LoadRequest *>::iterator it = mLoadRequests.find(resource);
+		AsyncLoader * loader = AsyncLoader::Active();
+		ASSERT(it != mLoadRequests.end() && loader != NULL);
+		if(it == mLoadRequests.end() || loader == NULL)
+			return false;
+
+		//request is deleted by loader
+		return loader->finishNow(it->second);
+	}
+
+	void reload(_TResource * resource)
+	{
+		if(resource->isLoading())
+			return;
+
+		if(!supportsReload())
+		{
+			//unused resource is dropped from cache to be loaded from changed file when it is needed
+			if(resource->getUse() <= 0)
+			{
+				IDMap<_TResource*>::del( resource->getID() );
+				delete resource;
+				mDirty = true;
+			}
+			else
+			{
+				Log::Instance().stream("ResourceStorage::reload") << "Resource " << resource->getName().c_str() << 
+					" has changed, it is reloaded when it is not used anymore";
+				mOutdated.insert(resource);
+			}
+			return;
+		}
+
+		_TResource * reloaded = createAsync();
+		ASSERT(reloaded != NULL);
+
+		//keep resource while it is reloaded
+		resource->incrUse();
+
+		ReloadRequest * request = new ReloadRequest(this, resource, reloaded);
+
+		AsyncLoader * loader = AsyncLoader::Active();
+		if(loader != NULL)
+		{
+			if(mAsyncQueue < 0)
+				mAsyncQueue = loader->getQueue(mStorageName.c_str());
+			loader->submit(request, mAsyncQueue);
+		}
+		else
+		{
+			request->finish( request->parse() );
+			delete request;
+		}
+	}
+
 	bool save(_TResource * resource) 
 	{ 
 		Data fileData(NULL, (size_t)1024);
@@ -285,15 +691,7 @@ private:
 			return false;
 		}
 
-		bool isExist = false;
-		if(mContentSource.get() != NULL)
-		{
-			isExist = mContentSource.get()->hasFile( fileName );
-		}
-		else
-		{
-			isExist = FileStorage::IsFileExist( fileName.c_str() );
-		}
+		bool isExist = hasResourceFile( fileName );
 
 		if(isExist && !mAllowOverwriting)
 		{
@@ -302,8 +700,12 @@ private:
 
 		if(mContentSource.get() != NULL)
 		{
+			std::unique_lock<std::mutex> lock(mContentSourceMutex);
+
 			if(mContentSource.get()->putFile(&fileData, fileName))
 			{
+				lock.unlock();
+				onSaved(resource, fileName);
 				return true;
 			}
 		}
@@ -311,6 +713,7 @@ private:
 		{
 			if(fileData.writeToFile( fileName.c_str() ) > 0)
 			{
+				onSaved(resource, fileName);
 				return true;
 			}
 		}
@@ -321,6 +724,15 @@ private:
 		return false; 
 	}
 
+	void onSaved(_TResource * resource, const std::string& fileName)
+	{
+		//so checkModifications does not reload what has been just written
+		if(fileName == resource->getName())
+		{
+			resource->setTimestamp( getTimestamp(fileName) );
+		}
+	}
+
 };
 
 }//namespace Resource { 
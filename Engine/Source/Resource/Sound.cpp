@@ -1,5 +1,6 @@
 #include "Sound.h"
 #include <Audio/IAudio.h>
+#include "SoundStream.h"
 #include <Common/Log.h>
 
 namespace Squirrel {
@@ -9,7 +10,7 @@ namespace Resource {
 using namespace Audio;
 
 Sound::Sound(void):
-	mLoader(NULL), mData(NULL), mBuffer(NULL)
+	mLoader(NULL), mData(NULL), mBuffer(NULL), mDuration(0), mBufferSize(0)
 {
 }
 
@@ -25,7 +26,7 @@ Sound::~Sound(void)
 }
 
 Sound::Sound(Data * sndData, SoundLoader * loader):
-	mLoader(loader), mData(sndData), mBuffer(NULL)
+	mLoader(loader), mData(sndData), mBuffer(NULL), mDuration(0), mBufferSize(0)
 {
 }
 
@@ -49,10 +50,17 @@ Audio::IBuffer * Sound::loadAll()
 
 	if(mLoader->isOpened())
 	{
+		mDuration = (float)mLoader->getDuration();
+
 		if(!mLoader->load(mBuffer, 0, 0))
 		{
 			DELETE_PTR(mBuffer);
 		}
+		else
+		{
+			mBufferSize = (size_t)(mLoader->getDuration() * mLoader->getFrequency()) *
+				mLoader->getChannels() * mLoader->getBitsPerSample() / 8;
+		}
 		mLoader->close();
 	}
 
@@ -62,6 +70,11 @@ Audio::IBuffer * Sound::loadAll()
 	return mBuffer;
 }
 
+size_t Sound::getMemorySize()
+{
+	return mBufferSize + (mData != NULL ? mData->getLength() : 0);
+}
+
 Audio::IBuffer *	Sound::loadStreamed(double offset, double duration)
 {
 	Audio::IBuffer * buffer = Audio::IAudio::GetActive()->createBuffer();
@@ -82,6 +95,24 @@ Audio::IBuffer *	Sound::loadStreamed(double offset, double duration)
 	return buffer;
 }
 
+Audio::IStream * Sound::createStream()
+{
+	if(mData == NULL || mLoader == NULL)
+		return NULL;
+
+	//stream is decoded in other thread and may outlive sound, so it gets own data
+	Data * data = new Data(NULL, mData->getLength());
+	memcpy(data->getData(), mData->getData(), mData->getLength());
+
+	SoundStream * stream = new SoundStream(data, mLoader->createNew());
+	if(!stream->open())
+	{
+		DELETE_PTR(stream);
+	}
+
+	return stream;
+}
+
 }//namespace Resource { 
 
 }//namespace Squirrel {
\ No newline at end of file
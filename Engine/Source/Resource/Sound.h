@@ -4,6 +4,7 @@
 #include "ResourceStorage.h"
 #include "SoundLoader.h"
 #include <Audio/IBuffer.h>
+#include <Audio/IStream.h>
 
 namespace Squirrel {
 
@@ -15,6 +16,8 @@ class SQRESOURCE_API Sound:
 	Audio::IBuffer * mBuffer;
 	SoundLoader * mLoader;
 	Data * mData;
+	float mDuration;
+	size_t mBufferSize;//bytes of decoded samples, known after loadAll
 
 public:
 	Sound(void);
@@ -27,6 +30,15 @@ public:
 	Audio::IBuffer *	loadAll();
 
 	Audio::IBuffer *	loadStreamed(double offset, double duration);
+
+	//new stream decoding copy of sound data, NULL if data was already released by loadAll
+	Audio::IStream *	createStream();
+
+	//seconds, known after loadAll, 0 if unknown
+	float				getDuration() const	{ return mDuration; }
+
+	//encoded data kept for streaming and decoded buffer
+	virtual size_t		getMemorySize();
 };
 
 
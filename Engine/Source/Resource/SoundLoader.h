@@ -22,15 +22,27 @@ protected:
 
 public:
 	SoundLoader(): mSrcData(NULL) {}
-	~SoundLoader() {}
+	virtual ~SoundLoader() {}
 
 	double getDuration() { return mDuration; }
 	bool isOpened() { return mSrcData != NULL; }
 
+	uint32 getChannels() const		{ return mChannels; }
+	uint32 getFrequency() const		{ return mFrequency; }
+	uint32 getBitsPerSample() const	{ return mBitsPerSample; }
+
 	virtual bool open(Data * srcData) = 0;
 	virtual bool load(Audio::IBuffer * targetBuffer, double offset, double duration) = 0;
 	virtual void close() = 0;
 
+	//sequential decoding for streams: decodes up to size bytes of PCM data following previously decoded ones,
+	//returns 0 at the end of sound
+	virtual uint32 decode(void * dst, uint32 size) = 0;
+	virtual bool rewind() = 0;
+
+	//new not opened loader of the same format
+	virtual SoundLoader * createNew() = 0;
+
 	virtual bool isSeekable(Data * srcData) { return true; }
 };
 
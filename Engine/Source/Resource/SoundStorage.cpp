@@ -23,6 +23,8 @@ SoundStorage * SoundStorage::Active()
 
 SoundStorage::SoundStorage()
 {
+	mStorageName = "Sounds";
+
 	mLoaderCreators.push_back(new SoundLoaderCreatorImpl<WAVLoader>("RIFF"));
 	mLoaderCreators.push_back(new SoundLoaderCreatorImpl<OGGLoader>("OggS"));
 
@@ -65,7 +67,7 @@ Sound* SoundStorage::load(Data * data)
 	}
 
 	if(loaderCreator == NULL)
-		return false;
+		return NULL;
 
 	SoundLoader * loader = loaderCreator->create();
 
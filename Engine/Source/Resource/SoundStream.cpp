@@ -0,0 +1,39 @@
+#include "SoundStream.h"
+
+namespace Squirrel {
+
+namespace Resource { 
+
+SoundStream::SoundStream(Data * data, SoundLoader * loader):
+	mLoader(loader), mData(data)
+{
+}
+
+SoundStream::~SoundStream()
+{
+	if(mLoader->isOpened())
+	{
+		mLoader->close();
+	}
+	DELETE_PTR(mLoader);
+	DELETE_PTR(mData);
+}
+
+bool SoundStream::open()
+{
+	return mLoader->open(mData);
+}
+
+uint32 SoundStream::read(void * dst, uint32 size)
+{
+	return mLoader->decode(dst, size);
+}
+
+void SoundStream::rewind()
+{
+	mLoader->rewind();
+}
+
+}//namespace Resource { 
+
+}//namespace Squirrel {
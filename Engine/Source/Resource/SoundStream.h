@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Audio/IStream.h>
+#include "SoundLoader.h"
+#include "macros.h"
+
+namespace Squirrel {
+
+namespace Resource { 
+
+//Streamed playback of sound: decodes own copy of sound data, so it outlives the sound it was created from
+class SQRESOURCE_API SoundStream:
+	public Audio::IStream
+{
+	SoundLoader * mLoader;
+	Data * mData;
+
+public:
+	//takes ownership of data and loader
+	SoundStream(Data * data, SoundLoader * loader);
+	virtual ~SoundStream();
+
+	bool open();
+
+	virtual int getFrequency() const		{ return (int)mLoader->getFrequency(); }
+	virtual int getBitsPerSample() const	{ return (int)mLoader->getBitsPerSample(); }
+	virtual int getChannels() const			{ return (int)mLoader->getChannels(); }
+
+	virtual uint32 read(void * dst, uint32 size);
+	virtual void rewind();
+};
+
+
+}//namespace Resource { 
+
+}//namespace Squirrel {
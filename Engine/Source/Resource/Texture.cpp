@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "TextureStreamer.h"
 #include <Render/IRender.h>
 #include <Common/Settings.h>
 #include <Common/Log.h>
@@ -9,43 +10,101 @@ namespace Resource {
 
 using namespace Render;
 
-Texture::Texture(void)
+namespace {
+
+size_t GetImageSize(const RenderData::Image * image)
+{
+	size_t size = 0;
+	for(uint32 face = 0; face < image->getFacesNum(); ++face)
+	{
+		for(uint32 level = 0; level < image->getLevelsNum(); ++level)
+		{
+			size += image->getLevel(level, face).size;
+		}
+	}
+	return size;
+}
+
+}//namespace {
+
+Texture::Texture(void):
+	mRenderTexture(NULL), mPlaceholder(NULL), mSrcImage(NULL), mRenderTextureSize(0), mStreamable(false), mStreamer(NULL)
 {
-	mRenderTexture = NULL;
 }
 
-Texture::Texture(Render::ITexture * renderTexture)
+Texture::Texture(Render::ITexture * renderTexture):
+	mRenderTexture(renderTexture), mPlaceholder(NULL), mSrcImage(NULL), mRenderTextureSize(0), mStreamable(false), mStreamer(NULL)
 {
-	mRenderTexture = renderTexture;
 }
 
-Texture::Texture(RenderData::Image * srcImage)
+Texture::Texture(RenderData::Image * srcImage):
+	mRenderTexture(NULL), mPlaceholder(NULL), mSrcImage(NULL), mRenderTextureSize(0), mStreamable(false), mStreamer(NULL)
 {
 	init(srcImage, RenderData::Image::Uncompressed, true);
 }
 
-Texture::Texture(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress)
+Texture::Texture(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress):
+	mRenderTexture(NULL), mPlaceholder(NULL), mSrcImage(NULL), mRenderTextureSize(0), mStreamable(false), mStreamer(NULL)
 {
 	init(srcImage, forceCompress, true);
 }
 	
-Texture::Texture(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap)
+Texture::Texture(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap):
+	mRenderTexture(NULL), mPlaceholder(NULL), mSrcImage(NULL), mRenderTextureSize(0), mStreamable(false), mStreamer(NULL)
 {
 	init(srcImage, forceCompress, genMipmap);
 }
 
 Texture::~Texture(void)
 {
+	if(mStreamer != NULL)
+		mStreamer->remove(this);
+
 	DELETE_PTR(mRenderTexture);
 	deleteSrcImage();
 }
 
-void Texture::init(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap)
+bool Texture::createRenderTexture(RenderData::Image::Compression forceCompress)
+{
+	ASSERT(mSrcImage != NULL);
+	ASSERT(mRenderTexture == NULL);
+
+	if(!init(mSrcImage, forceCompress, true))
+	{
+		//keep placeholder
+		DELETE_PTR(mRenderTexture);
+		return false;
+	}
+
+	return true;
+}
+
+bool Texture::reload(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress)
+{
+	ASSERT(srcImage != NULL);
+	ASSERT(srcImage != mSrcImage);
+
+	deleteSrcImage();
+	mSrcImage = srcImage;
+
+	if(mRenderTexture == NULL)
+	{
+		//has not been loaded before
+		return createRenderTexture(forceCompress);
+	}
+
+	return init(srcImage, forceCompress, true);
+}
+
+bool Texture::init(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap)
 {
-	//create empty texture
-	ASSERT(IRender::GetActive());
-	mRenderTexture = IRender::GetActive()->createTexture();
-	ASSERT(mRenderTexture != NULL);
+	//create empty texture unless it is refilled
+	if(mRenderTexture == NULL)
+	{
+		ASSERT(IRender::GetActive());
+		mRenderTexture = IRender::GetActive()->createTexture();
+		ASSERT(mRenderTexture != NULL);
+	}
 
 	//build mipmaps if needed
 	bool forceMipmapGen = Settings::Default()->getInt("Resources", "ForceMipmapGen", 1) != 0;
@@ -65,7 +124,7 @@ void Texture::init(RenderData::Image * srcImage, RenderData::Image::Compression
 	if(!mRenderTexture->fill(srcImage, forceCompress))
 	{
 		Log::Instance().error("Resources::Texture::init", "Failed to fill render texture with image data!");
-		return;
+		return false;
 	}
 
 	mSrcImage = srcImage;
@@ -85,6 +144,15 @@ void Texture::init(RenderData::Image * srcImage, RenderData::Image::Compression
 			Log::Instance().warning("Resources::Texture::init", "Failed to obtain compressed image data from GPU!");
 		}
 	}
+
+	mRenderTextureSize = GetImageSize(mSrcImage);
+
+	return true;
+}
+
+size_t Texture::getMemorySize()
+{
+	return mRenderTextureSize + (mSrcImage != NULL ? GetImageSize(mSrcImage) : 0);
 }
 
 void Texture::deleteSrcImage() 
@@ -9,11 +9,19 @@ namespace Squirrel {
 
 namespace Resource { 
 
+class TextureStreamer;
+
 class SQRESOURCE_API Texture:
 	public StoredObject
 {
+	friend class TextureStreamer;
+
 	Render::ITexture * mRenderTexture;
+	Render::ITexture * mPlaceholder;//not owned, used till render texture is created
 	RenderData::Image * mSrcImage;
+	size_t mRenderTextureSize;//bytes, estimated by image texture has been filled with
+	bool mStreamable;//loaded without largest levels which are streamed in when needed
+	TextureStreamer * mStreamer;//not NULL while levels are streamed
 
 public:
 	Texture(void);
@@ -23,14 +31,28 @@ public:
 	Texture(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap);
 	virtual ~Texture(void);
 
-	Render::ITexture *	getRenderTexture(void)	{ return mRenderTexture; }
+	Render::ITexture *	getRenderTexture(void)	{ return mRenderTexture != NULL ? mRenderTexture : mPlaceholder; }
 	RenderData::Image *	getSrcImage(void)		{ return mSrcImage; }
 
 	void deleteSrcImage();
 
+	//render texture and source image if it is kept
+	virtual size_t getMemorySize();
+
+	//asynchronous loading: image is set on loader thread, render texture is created from it on main one
+	void setPlaceholder(Render::ITexture * placeholder)	{ mPlaceholder = placeholder; }
+	void setSrcImage(RenderData::Image * srcImage)		{ mSrcImage = srcImage; }
+	bool createRenderTexture(RenderData::Image::Compression forceCompress);
+
+	//replaces source image and refills render texture with it, so render texture pointer stays valid
+	bool reload(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress);
+
+	void setStreamable(bool flag)	{ mStreamable = flag; }
+	bool isStreamable() const		{ return mStreamable; }
+
 private:
 
-	void init(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap);
+	bool init(RenderData::Image * srcImage, RenderData::Image::Compression forceCompress, bool genMipmap);
 };
 
 
@@ -27,8 +27,25 @@ const char * TextureStorage::NativeTextureExtension()
 
 TextureStorage::TextureStorage()
 {
+	mStorageName = "Textures";
+
 	mDontBuildMipmaps = false;
 	mDontCompress = false;
+	mStreamed = false;
+
+	mPlaceholder = NULL;
+
+	if(Settings::Default()->getInt("Resources", "TextureStreaming", 1) != 0)
+	{
+		const size_t MB = 1024 * 1024;
+		mStreamer.reset( new TextureStreamer(this) );
+		mStreamer->setMemoryBudget( Settings::Default()->getInt("Resources", "TextureStreamingBudget", 128) * MB );
+		mStreamer->setTailSize( Settings::Default()->getInt("Resources", "TextureStreamingTailSize", 64) );
+		mStreamer->setMaxPendingNum( Settings::Default()->getInt("Resources", "TextureStreamingMaxRequests", 4) );
+	}
+
+	//settings are not thread safe, read it once for loader threads
+	mForceMipmapGen = Settings::Default()->getInt("Resources", "ForceMipmapGen", 1) != 0;
 
 	mPreferNativeTextures = Settings::Default()->getInt("Resources", "PreferNativeTextures", 1) != 0;
 	mHeightMapMultiplier = Settings::Default()->getFloat("Resources", "Height2NormalMapScale", 6.4f);
@@ -40,14 +57,17 @@ TextureStorage::~TextureStorage()
 	{
 		sActiveLibrary = NULL;
 	}
+
+	DELETE_PTR(mPlaceholder);
 }
 
-Texture * TextureStorage::loadTexture(const std::string& texName, bool dontBuildMipmaps, bool dontCompress)
+Texture * TextureStorage::loadTexture(const std::string& texName, bool dontBuildMipmaps, bool dontCompress, bool streamed)
 {
 	Texture * tex = NULL;
 
 	mDontBuildMipmaps = dontBuildMipmaps;
 	mDontCompress = dontCompress;
+	mStreamed = streamed;
 	
 	//try to load texture with the same name but native format if format is not native
 	if(mPreferNativeTextures && FileSystem::Path::GetExtension(texName) != TextureStorage::NativeTextureExtension())
@@ -64,10 +84,55 @@ Texture * TextureStorage::loadTexture(const std::string& texName, bool dontBuild
 	
 	mDontBuildMipmaps = false;
 	mDontCompress = false;
+	mStreamed = false;
+
+	return tex;
+}
+
+Texture * TextureStorage::loadTextureAsync(const std::string& texName, float priority, const Math::vec3 * position, bool streamed)
+{
+	std::string resourceName = texName;
+
+	//same preference of native format as loadTexture has
+	if(mPreferNativeTextures && FileSystem::Path::GetExtension(texName) != TextureStorage::NativeTextureExtension())
+	{
+		std::string nativeName = FileSystem::Path::RemoveExtension(texName) + "." + TextureStorage::NativeTextureExtension();
+		if(getByName(nativeName) != NULL || hasResourceFile(nativeName))
+		{
+			resourceName = nativeName;
+		}
+	}
+
+	mStreamed = streamed;
+	Texture * tex = addAsync( resourceName, priority, position );
+	mStreamed = false;
 
 	return tex;
 }
 
+Texture * TextureStorage::getPlaceholder()
+{
+	if(mPlaceholder == NULL)
+	{
+		const int size = 2;
+		Image * image = new Image(size, size, 1, Image::Int8, Image::RGBA);
+
+		Image::Level& level = image->getLevel(0, 0);
+		for(uint32 i = 0; i + 4 <= level.size; i += 4)
+		{
+			level.data[i + 0] = 128;
+			level.data[i + 1] = 128;
+			level.data[i + 2] = 128;
+			level.data[i + 3] = 255;
+		}
+
+		mPlaceholder = new Texture(image, Image::Uncompressed, false);
+		mPlaceholder->deleteSrcImage();
+	}
+
+	return mPlaceholder;
+}
+
 Texture * TextureStorage::makeCubemap(std::string fileNames[Render::ITexture::cmfNum])
 {
 	Image * cubeImage = NULL;
@@ -222,7 +287,7 @@ Texture * TextureStorage::loadNormalMap(const std::string& normalMapFileName, bo
 	return NULL;
 }
 
-Image* TextureStorage::loadImage(Data * data)
+Image* TextureStorage::loadImage(Data * data, bool streamed)
 {
 	bool nativeFormat = true;
 
@@ -245,8 +310,11 @@ Image* TextureStorage::loadImage(Data * data)
 	//load image
 	if(nativeFormat)
 	{
+		//largest levels of streamed image are loaded by streamer
+		uint32 maxSize = (streamed && mStreamer.get() != NULL) ? mStreamer->getTailSize() : 0;
+
 		pImage = new Image();
-		ASSERT(pImage->load(data));
+		ASSERT(pImage->load(data, 0, maxSize));
 	}
 	else
 	{
@@ -284,7 +352,7 @@ Image::Compression TextureStorage::checkForceCompression(const Image * image)
 
 Texture* TextureStorage::load(Data * data)
 {
-	Image * pImage = loadImage(data);
+	Image * pImage = loadImage(data, mStreamed);
 
 	DELETE_PTR(data);
 
@@ -293,6 +361,15 @@ Texture* TextureStorage::load(Data * data)
 
 	Texture * pTex = loadFromImage(pImage, mDontBuildMipmaps, mDontCompress);
 
+	if(mStreamed)
+	{
+		pTex->setStreamable(true);
+		startStreaming(pTex);
+	}
+
+	if(!pTex->isChanged())
+		pTex->deleteSrcImage();
+
 	return pTex;
 }
 
@@ -304,12 +381,82 @@ Texture * TextureStorage::loadFromImage(Image * image, bool dontBuildMipmaps, bo
 	Texture * pTex = new Texture(image, compression, !dontBuildMipmaps);
 	ASSERT(pTex);
 
-	if(!pTex->isChanged())
-		pTex->deleteSrcImage();
-
 	return pTex;
 }
 
+void TextureStorage::startStreaming(Texture * texture)
+{
+	if(mStreamer.get() != NULL && texture->isStreamable())
+	{
+		mStreamer->add(texture, texture->getSrcImage());
+	}
+}
+
+Texture* TextureStorage::createAsync()
+{
+	Texture * texture = new Texture();
+	texture->setPlaceholder( getPlaceholder()->getRenderTexture() );
+	texture->setStreamable( mStreamed );
+	return texture;
+}
+
+bool TextureStorage::parseAsync(Texture* texture, Data * data)
+{
+	Image * image = loadImage(data, texture->isStreamable());
+
+	DELETE_PTR(data);
+
+	if(image == NULL)
+		return false;
+
+	//build mipmaps here so main thread only uploads image
+	if(image->getLevelsNum() == 1 && mForceMipmapGen)
+	{
+		if(image->buildMipMaps())
+		{
+			texture->setChanged();
+		}
+	}
+
+	texture->setSrcImage(image);
+
+	return true;
+}
+
+bool TextureStorage::finishAsync(Texture* texture)
+{
+	if(!texture->createRenderTexture( checkForceCompression(texture->getSrcImage()) ))
+		return false;
+
+	startStreaming(texture);
+
+	if(!texture->isChanged())
+		texture->deleteSrcImage();
+
+	return true;
+}
+
+bool TextureStorage::replaceContent(Texture* texture, Texture* reloaded)
+{
+	//image parsed by loader thread moves to existing texture
+	RenderData::Image * image = reloaded->getSrcImage();
+	reloaded->setSrcImage(NULL);
+
+	if(!texture->reload( image, checkForceCompression(image) ))
+		return false;
+
+	if(reloaded->isChanged())
+		texture->setChanged();
+
+	//changed file is loaded entirely, streamer evicts levels which are not needed
+	startStreaming(texture);
+
+	if(!texture->isChanged())
+		texture->deleteSrcImage();
+
+	return true;
+}
+
 bool TextureStorage::save(Texture* resource, Data * data, std::string& fileName)
 {
 	if(resource == NULL || resource->getSrcImage() == NULL || data == NULL) 
@@ -338,7 +485,7 @@ void TextureStorage::deleteSourceImages(bool keepChanged)
 	for(_ID i = 0; i < getSize(); ++i)
 	{
 		Texture * obj = get(i);
-		if(obj)
+		if(obj && !obj->isLoading())
 		{
 			if( obj->isChanged() && keepChanged ) continue;
 
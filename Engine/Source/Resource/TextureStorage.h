@@ -3,6 +3,8 @@
 #include "ResourceStorage.h"
 #include "ImageLoader.h"
 #include "Texture.h"
+#include "TextureStreamer.h"
+#include <memory>
 
 namespace Squirrel {
 namespace Resource { 
@@ -17,6 +19,8 @@ class SQRESOURCE_API TextureStorage:
 {
 	static TextureStorage * sActiveLibrary;
 
+	friend class TextureStreamer;
+
 public:
 	
 	const static int DEFAULT_ATLAS_SIZE = 2048;
@@ -27,7 +31,10 @@ public:
 
 	void deleteSourceImages(bool keepChanged = true);
 
-	Texture * loadTexture(const std::string& fileName, bool dontBuildMipmaps = false, bool dontCompress = false);
+	//native textures loaded as streamed ones get largest levels from streamer when they are needed, see getStreamer
+	Texture * loadTexture(const std::string& fileName, bool dontBuildMipmaps = false, bool dontCompress = false, bool streamed = false);
+	//placeholder texture is rendered till texture is loaded, see addAsync
+	Texture * loadTextureAsync(const std::string& fileName, float priority = 0.0f, const Math::vec3 * position = NULL, bool streamed = false);
 
 	Texture * makeCubemap(std::string fileNames[Render::ITexture::cmfNum]);
 	Texture * makeGridAtlas(const std::list<std::string>& fileNames,
@@ -45,15 +52,32 @@ public:
 
 	ImageLoader& getImageLoader() { return mImageLoader; }
 
+	//neutral grey texture, creates it on first call (main thread only)
+	Texture * getPlaceholder();
+
+	//NULL if texture streaming is disabled
+	TextureStreamer * getStreamer() { return mStreamer.get(); }
+
 protected:
-	RenderData::Image* loadImage(Data * data);
+	//streamed native image is loaded without levels larger than tail size of streamer
+	RenderData::Image* loadImage(Data * data, bool streamed = false);
 	RenderData::Image::Compression checkForceCompression(const RenderData::Image * image);
 
 	Texture * loadFromImage(RenderData::Image * image, bool dontBuildMipmaps = false, bool dontCompress = false);
 
+	//passes streamable texture to streamer while it has source image
+	void startStreaming(Texture * texture);
+
 	virtual Texture* load(Data * data);
 	virtual bool save(Texture* resource, Data * data, std::string& fileName);
 
+	virtual Texture* createAsync();
+	virtual bool parseAsync(Texture* resource, Data * data);
+	virtual bool finishAsync(Texture* resource);
+
+	virtual bool supportsReload() { return true; }
+	virtual bool replaceContent(Texture* resource, Texture* reloaded);
+
 	ImageLoader mImageLoader;
 	
 	float mHeightMapMultiplier;
@@ -62,6 +86,13 @@ protected:
 
 	bool mDontBuildMipmaps;
 	bool mDontCompress;
+	bool mStreamed;
+
+	bool mForceMipmapGen;
+
+	Texture * mPlaceholder;
+
+	std::auto_ptr<TextureStreamer> mStreamer;
 };
 
 
@@ -0,0 +1,410 @@
+#include "TextureStreamer.h"
+#include "TextureStorage.h"
+#include <Common/Log.h>
+#include <Common/Profiler.h>
+#include <Math/BasicUtils.h>
+#include <algorithm>
+#include <math.h>
+#include <limits.h>
+#include <string.h>
+
+namespace Squirrel {
+
+namespace Resource {
+
+using RenderData::Image;
+
+namespace {
+
+//evictions free memory, so they are loaded before upgrades
+const float EVICTION_PRIORITY = 1000.0f;
+
+}//namespace {
+
+//reads mip chain from mapped file on loader thread
+class TextureStreamer::MipRequest:
+	public AsyncLoader::Request
+{
+public:
+	MipRequest(TextureStreamer * streamer, Texture * texture, int level):
+		mStreamer(streamer), mStorage(streamer->mStorage), mTexture(texture), mFileName(texture->getName()), mLevel(level), mImage(NULL) {}
+
+	virtual ~MipRequest()
+	{
+		DELETE_PTR(mImage);
+	}
+
+	virtual bool parse()
+	{
+		Data * data = mStorage->getResourceData(mFileName);
+		if(data == NULL)
+			return false;
+
+		bool native = data->getLength() > 4 && memcmp(data->getData(), Image::GetNativeFileSign(), 4) == 0;
+		if(native)
+		{
+			mImage = new Image();
+			native = mImage->load(data, mLevel) && (int)mImage->getSkippedLevelsNum() == mLevel;
+		}
+
+		DELETE_PTR(data);
+
+		return native;
+	}
+
+	virtual bool finish(bool parsed)
+	{
+		//texture is released while its levels are loaded
+		if(mTexture == NULL)
+			return parsed;
+
+		return mStreamer->finish(this, parsed ? mImage : NULL);
+	}
+
+	TextureStreamer *	mStreamer;
+	TextureStorage *	mStorage;
+	Texture *			mTexture;//NULL if texture is not streamed anymore
+	std::string			mFileName;
+	int					mLevel;
+	Image *				mImage;
+};
+
+TextureStreamer::TextureStreamer(TextureStorage * storage):
+	mStorage(storage), mMemoryBudget(0), mTailSize(64), mMaxPendingNum(4), mFrame(0), mAsyncQueue(-1)
+{
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	//requests are owned by loader
+	for(ENTRIES_MAP::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		it->first->mStreamer = NULL;
+
+		if(it->second.request != NULL)
+			it->second.request->mTexture = NULL;
+	}
+}
+
+int TextureStreamer::CalcRequiredLevel(uint32 textureSize, float screenSize)
+{
+	float ratio = textureSize / Math::maxValue(screenSize, 1.0f);
+	if(ratio <= 1.0f)
+		return 0;
+
+	return (int)floorf(logf(ratio) / logf(2.0f));
+}
+
+bool TextureStreamer::add(Texture * texture, Image * image)
+{
+	remove(texture);
+
+	//changed images (e.g. with built mipmaps) are not stored in files yet
+	if(image == NULL || !image->isNative() || image->getStoredLevelsNum() < 2 || texture->isChanged())
+		return false;
+
+	int levelsNum = (int)image->getStoredLevelsNum();
+
+	Entry& entry = mEntries[texture];
+	entry.texture = texture;
+
+	entry.chainSizes.resize(levelsNum + 1);
+	entry.chainSizes[levelsNum] = 0;
+	for(int i = levelsNum - 1; i >= 0; --i)
+	{
+		entry.chainSizes[i] = entry.chainSizes[i + 1] + image->getStoredLevelSize(i);
+	}
+
+	entry.topSize = Math::maxValue(image->getStoredSize().x, image->getStoredSize().y);
+
+	//same levels as Image::load skips by tail size
+	entry.tailLevel = 0;
+	while(entry.tailLevel < levelsNum - 2 && (entry.topSize >> entry.tailLevel) > mTailSize)
+	{
+		++entry.tailLevel;
+	}
+
+	entry.residentLevel		= (int)image->getSkippedLevelsNum();
+	entry.requiredLevel		= entry.tailLevel;
+	entry.targetLevel		= entry.residentLevel;
+	entry.lastRequestFrame	= mFrame;//just loaded texture is going to be rendered
+	entry.request			= NULL;
+
+	texture->mStreamer = this;
+
+	return true;
+}
+
+void TextureStreamer::remove(Texture * texture)
+{
+	ENTRIES_MAP::iterator it = mEntries.find(texture);
+	if(it == mEntries.end())
+		return;
+
+	if(it->second.request != NULL)
+	{
+		it->second.request->mTexture = NULL;
+		--mStats.pendingNum;
+	}
+
+	texture->mStreamer = NULL;
+
+	mEntries.erase(it);
+}
+
+void TextureStreamer::requestSize(Texture * texture, float screenSize)
+{
+	ENTRIES_MAP::iterator it = mEntries.find(texture);
+	if(it == mEntries.end())
+		return;
+
+	Entry& entry = it->second;
+
+	int level = Math::minValue(CalcRequiredLevel(entry.topSize, screenSize), entry.tailLevel);
+
+	//texture may be used by several objects
+	if(entry.lastRequestFrame != mFrame)
+	{
+		entry.requiredLevel = level;
+		entry.lastRequestFrame = mFrame;
+	}
+	else
+	{
+		entry.requiredLevel = Math::minValue(entry.requiredLevel, level);
+	}
+}
+
+int TextureStreamer::getResidentLevel(Texture * texture) const
+{
+	ENTRIES_MAP::const_iterator it = mEntries.find(texture);
+	return it != mEntries.end() ? it->second.residentLevel : -1;
+}
+
+int TextureStreamer::getTargetLevel(Texture * texture) const
+{
+	ENTRIES_MAP::const_iterator it = mEntries.find(texture);
+	return it != mEntries.end() ? it->second.targetLevel : -1;
+}
+
+namespace {
+
+struct Candidate
+{
+	size_t	levelSize;
+	uint32	lastRequestFrame;
+	void *	entry;
+
+	//largest levels first, least recently used first among equal ones
+	bool operator < (const Candidate& other) const
+	{
+		if(levelSize != other.levelSize)
+			return levelSize < other.levelSize;
+		return lastRequestFrame > other.lastRequestFrame;
+	}
+};
+
+template <class TEntry>
+bool IsLessRecentlyUsed(const TEntry * a, const TEntry * b)
+{
+	return a->lastRequestFrame < b->lastRequestFrame;
+}
+
+}//namespace {
+
+void TextureStreamer::decideTargets()
+{
+	//levels are not dropped while they fit into budget
+	size_t totalSize = 0;
+
+	std::vector<Entry *> entries;
+	entries.reserve(mEntries.size());
+
+	for(ENTRIES_MAP::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		Entry& entry = it->second;
+
+		if(entry.lastRequestFrame != mFrame)
+			entry.requiredLevel = entry.tailLevel;
+
+		int currentLevel = entry.request != NULL ? entry.request->mLevel : entry.residentLevel;
+
+		entry.targetLevel = Math::minValue(currentLevel, entry.requiredLevel);
+		totalSize += entry.chainSizes[entry.targetLevel];
+
+		entries.push_back(&entry);
+	}
+
+	//zero budget is unlimited
+	if(mMemoryBudget == 0 || totalSize <= mMemoryBudget)
+		return;
+
+	std::sort(entries.begin(), entries.end(), &IsLessRecentlyUsed<Entry>);
+
+	//levels which are not required anymore, of least recently used textures first
+	for(size_t i = 0; i < entries.size() && totalSize > mMemoryBudget; ++i)
+	{
+		Entry& entry = *entries[i];
+		if(entry.targetLevel < entry.requiredLevel)
+		{
+			totalSize -= entry.chainSizes[entry.targetLevel] - entry.chainSizes[entry.requiredLevel];
+			entry.targetLevel = entry.requiredLevel;
+		}
+	}
+
+	//upgrades which do not fit, resident levels are not swapped for required ones of other textures
+	for(size_t i = 0; i < entries.size() && totalSize > mMemoryBudget; ++i)
+	{
+		Entry& entry = *entries[i];
+		int currentLevel = entry.request != NULL ? entry.request->mLevel : entry.residentLevel;
+		while(entry.targetLevel < currentLevel && totalSize > mMemoryBudget)
+		{
+			totalSize -= entry.chainSizes[entry.targetLevel] - entry.chainSizes[entry.targetLevel + 1];
+			++entry.targetLevel;
+		}
+	}
+
+	if(totalSize <= mMemoryBudget)
+		return;
+
+	//resident levels do not fit (e.g. budget is changed), largest ones are evicted
+	std::vector<Candidate> candidates;
+	for(size_t i = 0; i < entries.size(); ++i)
+	{
+		Entry& entry = *entries[i];
+		if(entry.targetLevel < entry.tailLevel)
+		{
+			Candidate candidate = { entry.chainSizes[entry.targetLevel] - entry.chainSizes[entry.targetLevel + 1], entry.lastRequestFrame, &entry };
+			candidates.push_back(candidate);
+		}
+	}
+
+	std::make_heap(candidates.begin(), candidates.end());
+
+	while(totalSize > mMemoryBudget && !candidates.empty())
+	{
+		std::pop_heap(candidates.begin(), candidates.end());
+		Candidate& candidate = candidates.back();
+		Entry& entry = *(Entry *)candidate.entry;
+
+		totalSize -= candidate.levelSize;
+		++entry.targetLevel;
+
+		if(entry.targetLevel < entry.tailLevel)
+		{
+			candidate.levelSize = entry.chainSizes[entry.targetLevel] - entry.chainSizes[entry.targetLevel + 1];
+			std::push_heap(candidates.begin(), candidates.end());
+		}
+		else
+		{
+			candidates.pop_back();
+		}
+	}
+}
+
+void TextureStreamer::update()
+{
+	SQ_PROFILE_ZONE("TextureStreamer::update");
+
+	decideTargets();
+
+	//evictions go first, then most blurred textures
+	std::vector<std::pair<int, Entry *> > changes;
+	for(ENTRIES_MAP::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		Entry& entry = it->second;
+		if(entry.request == NULL && entry.targetLevel != entry.residentLevel)
+		{
+			int order = entry.targetLevel > entry.residentLevel ? INT_MIN : entry.targetLevel - entry.residentLevel;
+			changes.push_back(std::make_pair(order, &entry));
+		}
+	}
+
+	std::sort(changes.begin(), changes.end());
+
+	for(size_t i = 0; i < changes.size() && mStats.pendingNum < mMaxPendingNum; ++i)
+	{
+		submit(*changes[i].second);
+	}
+
+	mStats.texturesNum		= (int)mEntries.size();
+	mStats.residentBytes	= 0;
+	mStats.requiredBytes	= 0;
+	for(ENTRIES_MAP::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		mStats.residentBytes += it->second.chainSizes[it->second.residentLevel];
+		mStats.requiredBytes += it->second.chainSizes[it->second.requiredLevel];
+	}
+
+	++mFrame;
+}
+
+void TextureStreamer::submit(Entry& entry)
+{
+	MipRequest * request = new MipRequest(this, entry.texture, entry.targetLevel);
+	entry.request = request;
+	++mStats.pendingNum;
+
+	AsyncLoader * loader = AsyncLoader::Active();
+	if(loader == NULL)
+	{
+		bool parsed = request->parse();
+		request->finish(parsed);
+		DELETE_PTR(request);
+		return;
+	}
+
+	if(mAsyncQueue < 0)
+		mAsyncQueue = loader->getQueue("Texture mips");
+
+	request->mPriority = entry.targetLevel > entry.residentLevel ? EVICTION_PRIORITY : (float)(entry.residentLevel - entry.targetLevel);
+	loader->submit(request, mAsyncQueue);
+}
+
+bool TextureStreamer::finish(MipRequest * request, Image * image)
+{
+	ENTRIES_MAP::iterator it = mEntries.find(request->mTexture);
+	ASSERT(it != mEntries.end() && it->second.request == request);
+
+	Entry& entry = it->second;
+	Texture * texture = entry.texture;
+
+	entry.request = NULL;
+	--mStats.pendingNum;
+
+	if(image == NULL)
+	{
+		//texture keeps levels it has
+		Log::Instance().streamError("TextureStreamer::finish") << "Failed to read levels of " << texture->getName().c_str();
+		remove(texture);
+		return false;
+	}
+
+	//texture takes image
+	request->mImage = NULL;
+
+	if(!texture->reload(image, Image::Uncompressed))
+	{
+		remove(texture);
+		return false;
+	}
+
+	if(!texture->isChanged())
+		texture->deleteSrcImage();
+
+	if(request->mLevel < entry.residentLevel)
+		++mStats.upgradesNum;
+	else
+		++mStats.evictionsNum;
+
+	entry.residentLevel = request->mLevel;
+
+	//memory size of texture is changed
+	mStorage->mDirty = true;
+
+	return true;
+}
+
+}//namespace Resource {
+
+}//namespace Squirrel {
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Common/types.h>
+#include <vector>
+#include <map>
+#include "AsyncLoader.h"
+#include "macros.h"
+
+namespace Squirrel {
+
+namespace RenderData {
+class Image;
+}//namespace RenderData {
+
+namespace Resource {
+
+class Texture;
+class TextureStorage;
+
+//Keeps only mip levels of streamed textures which are needed to render them.
+//Streamed textures are loaded from native files without largest levels (see TextureStorage::loadTexture),
+//renderers report on-screen size of objects using them and update decides which levels to keep:
+//required levels are streamed in by loader threads while memory of resident levels is within budget,
+//otherwise levels of least recently used and largest textures are evicted.
+//Render texture is refilled with new mip chain, so its pointer stays valid.
+class SQRESOURCE_API TextureStreamer
+{
+public://nested types
+
+	struct Stats
+	{
+		int		texturesNum;
+		int		pendingNum;//level changes being loaded
+		size_t	residentBytes;
+		size_t	requiredBytes;//if all textures had their required levels
+		int		upgradesNum;//total
+		int		evictionsNum;//total
+	};
+
+private:
+
+	class MipRequest;
+
+	struct Entry
+	{
+		Texture *			texture;
+		std::vector<size_t>	chainSizes;//bytes of mip chain starting from level
+		uint32				topSize;//texels of largest dimension of level 0
+		int					tailLevel;//first level loaded initially, lowest residency
+		int					residentLevel;//first resident level
+		int					requiredLevel;//this frame
+		int					targetLevel;//last decision
+		uint32				lastRequestFrame;
+		MipRequest *		request;//level change being loaded
+	};
+
+	typedef std::map<Texture *, Entry> ENTRIES_MAP;
+
+	TextureStreamer(const TextureStreamer&);
+	const TextureStreamer& operator=(const TextureStreamer&);
+
+public:
+	TextureStreamer(TextureStorage * storage);
+	~TextureStreamer();
+
+	//bytes of resident levels of all streamed textures, zero budget is unlimited as in storages
+	void setMemoryBudget(size_t bytes) { mMemoryBudget = bytes; }
+	size_t getMemoryBudget() const { return mMemoryBudget; }
+
+	//largest level of image loaded initially, texels
+	void setTailSize(uint32 texels) { mTailSize = texels; }
+	uint32 getTailSize() const { return mTailSize; }
+
+	//level changes loaded at once
+	void setMaxPendingNum(int num) { mMaxPendingNum = num; }
+
+	//texture is filled with partially loaded image (see Image::load), returns false if image can not be streamed
+	bool add(Texture * texture, RenderData::Image * image);
+	void remove(Texture * texture);
+	bool isStreamed(Texture * texture) const { return mEntries.find(texture) != mEntries.end(); }
+
+	//texture is rendered this frame on object which takes given number of pixels on screen
+	void requestSize(Texture * texture, float screenSize);
+
+	//decides resident levels by sizes requested since last update and starts loading of changed ones, once per frame
+	void update();
+
+	//level of texture of given size which texels are not smaller than pixels of given screen size
+	static int CalcRequiredLevel(uint32 textureSize, float screenSize);
+
+	//first resident level, -1 if texture is not streamed
+	int getResidentLevel(Texture * texture) const;
+	int getTargetLevel(Texture * texture) const;
+
+	const Stats& getStats() const { return mStats; }
+
+private:
+
+	void decideTargets();
+
+	//reads mip chain of texture on loader thread or immediately if there are no ones
+	void submit(Entry& entry);
+
+	//main thread
+	bool finish(MipRequest * request, RenderData::Image * image);
+
+private:
+
+	TextureStorage *	mStorage;
+
+	ENTRIES_MAP			mEntries;
+
+	size_t				mMemoryBudget;
+	uint32				mTailSize;
+	int					mMaxPendingNum;
+
+	uint32				mFrame;
+	int					mAsyncQueue;
+
+	Stats				mStats;
+};
+
+}//namespace Resource {
+
+}//namespace Squirrel {
@@ -44,7 +44,10 @@ typedef struct
 
 #pragma pack(pop)
 
-WAVLoader::WAVLoader() {}
+WAVLoader::WAVLoader():
+	mDataSize(0), mDataOffset(0), mDecodePos(0)
+{
+}
 
 WAVLoader::~WAVLoader() {		
 	if(isOpened())
@@ -64,6 +67,7 @@ bool WAVLoader::open(Data * srcData)
 
 	mDataSize	= 0;
 	mDataOffset	= 0;
+	mDecodePos	= 0;
 
 	// Read Wave file header
 	mSrcData->readBytes(&waveFileHeader, sizeof(WAVEFILEHEADER));
@@ -148,6 +152,30 @@ bool WAVLoader::load(Audio::IBuffer * targetBuffer, double offset, double durati
 		mSrcData->getPtr( bufferOffset ) );
 }
 
+uint32 WAVLoader::decode(void * dst, uint32 size)
+{
+	if(!isOpened())
+		return 0;
+
+	const uint32 blockAlign = mBitsPerSample / 8 * mChannels;
+
+	uint32 bytesLeft = mDataSize - mDecodePos;
+	if(size > bytesLeft)
+		size = bytesLeft;
+	size -= size % blockAlign;
+
+	memcpy(dst, mSrcData->getPtr( mDataOffset + mDecodePos ), size);
+	mDecodePos += size;
+
+	return size;
+}
+
+bool WAVLoader::rewind()
+{
+	mDecodePos = 0;
+	return isOpened();
+}
+
 void WAVLoader::close()
 {
 	mSrcData = NULL;
@@ -11,6 +11,7 @@ class SQRESOURCE_API WAVLoader:
 {
 	uint32 mDataSize;
 	uint32 mDataOffset;
+	uint32 mDecodePos;//offset in data for sequential decoding
 
 public:
 	WAVLoader();
@@ -19,6 +20,11 @@ public:
 	virtual bool open(Data * srcData);
 	virtual bool load(Audio::IBuffer * targetBuffer, double offset, double duration);
 	virtual void close();
+
+	virtual uint32 decode(void * dst, uint32 size);
+	virtual bool rewind();
+
+	virtual SoundLoader * createNew() { return new WAVLoader(); }
 };
 
 
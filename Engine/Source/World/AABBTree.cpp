@@ -0,0 +1,411 @@
+#include "AABBTree.h"
+
+namespace Squirrel {
+namespace World {
+
+const AABBTree::PROXY AABBTree::INVALID_PROXY;
+
+namespace {
+
+inline float SurfaceArea(const AABB& box)
+{
+	vec3 size = box.max - box.min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+inline AABB Merged(const AABB& box1, const AABB& box2)
+{
+	AABB box = box1;
+	box.merge(box2);
+	return box;
+}
+
+}//namespace {
+
+AABBTree::AABBTree(float margin):
+	mRoot(-1), mFreeList(-1), mProxiesNum(0), mMargin(margin)
+{
+}
+
+AABBTree::~AABBTree()
+{
+}
+
+void AABBTree::clear()
+{
+	mNodes.clear();
+	mRoot = -1;
+	mFreeList = -1;
+	mProxiesNum = 0;
+}
+
+int AABBTree::allocateNode()
+{
+	if(mFreeList < 0)
+	{
+		Node node;
+		node.parent = -1;
+		mNodes.push_back(node);
+		mFreeList = (int)mNodes.size() - 1;
+	}
+
+	int index = mFreeList;
+	Node& node = mNodes[index];
+	mFreeList = node.parent;
+
+	node.userData	= NULL;
+	node.parent		= -1;
+	node.child1		= -1;
+	node.child2		= -1;
+	node.height		= 0;
+
+	return index;
+}
+
+void AABBTree::freeNode(int index)
+{
+	Node& node = mNodes[index];
+	node.parent = mFreeList;
+	node.height = -1;
+	mFreeList = index;
+}
+
+AABBTree::PROXY AABBTree::createProxy(const AABB& box, void * userData)
+{
+	int leaf = allocateNode();
+
+	Node& node = mNodes[leaf];
+	node.box = box;
+	node.box.grow(mMargin);
+	node.userData = userData;
+
+	insertLeaf(leaf);
+
+	++mProxiesNum;
+
+	return leaf;
+}
+
+void AABBTree::destroyProxy(PROXY proxy)
+{
+	ASSERT(mNodes[proxy].isLeaf());
+
+	removeLeaf(proxy);
+	freeNode(proxy);
+
+	--mProxiesNum;
+}
+
+bool AABBTree::moveProxy(PROXY proxy, const AABB& box, const vec3& displacement)
+{
+	ASSERT(mNodes[proxy].isLeaf());
+
+	if(mNodes[proxy].box.contains(box))
+		return false;
+
+	removeLeaf(proxy);
+
+	//predict movement to avoid reinsertion next frame
+
+	AABB fatBox = box;
+	fatBox.grow(mMargin);
+
+	vec3 prediction = displacement * 2.0f;
+
+	for(int i = 0; i < 3; ++i)
+	{
+		if(prediction[i] < 0.0f)
+			fatBox.min[i] += prediction[i];
+		else
+			fatBox.max[i] += prediction[i];
+	}
+
+	mNodes[proxy].box = fatBox;
+
+	insertLeaf(proxy);
+
+	return true;
+}
+
+void AABBTree::insertLeaf(int leaf)
+{
+	if(mRoot < 0)
+	{
+		mRoot = leaf;
+		mNodes[mRoot].parent = -1;
+		return;
+	}
+
+	//find best sibling descending by surface area heuristic
+
+	AABB leafBox = mNodes[leaf].box;
+	int index = mRoot;
+
+	while(!mNodes[index].isLeaf())
+	{
+		const Node& node = mNodes[index];
+
+		float area = SurfaceArea(node.box);
+		float combinedArea = SurfaceArea(Merged(node.box, leafBox));
+
+		//cost of making new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+
+		//minimum cost of pushing the leaf further down
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		int children[2] = { node.child1, node.child2 };
+
+		for(int i = 0; i < 2; ++i)
+		{
+			const Node& child = mNodes[children[i]];
+			float newArea = SurfaceArea(Merged(leafBox, child.box));
+
+			childCosts[i] = child.isLeaf() ?
+				newArea + inheritanceCost :
+				(newArea - SurfaceArea(child.box)) + inheritanceCost;
+		}
+
+		if(cost < childCosts[0] && cost < childCosts[1])
+			break;
+
+		index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+
+	//create new parent
+
+	int oldParent = mNodes[sibling].parent;
+	int newParent = allocateNode();
+
+	mNodes[newParent].parent	= oldParent;
+	mNodes[newParent].box		= Merged(leafBox, mNodes[sibling].box);
+	mNodes[newParent].height	= mNodes[sibling].height + 1;
+	mNodes[newParent].child1	= sibling;
+	mNodes[newParent].child2	= leaf;
+
+	mNodes[sibling].parent	= newParent;
+	mNodes[leaf].parent		= newParent;
+
+	if(oldParent >= 0)
+	{
+		if(mNodes[oldParent].child1 == sibling)
+			mNodes[oldParent].child1 = newParent;
+		else
+			mNodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		mRoot = newParent;
+	}
+
+	//refit ancestors
+
+	index = mNodes[leaf].parent;
+	while(index >= 0)
+	{
+		index = balance(index);
+
+		Node& node = mNodes[index];
+		node.height	= 1 + Math::maxValue(mNodes[node.child1].height, mNodes[node.child2].height);
+		node.box	= Merged(mNodes[node.child1].box, mNodes[node.child2].box);
+
+		index = node.parent;
+	}
+}
+
+void AABBTree::removeLeaf(int leaf)
+{
+	if(leaf == mRoot)
+	{
+		mRoot = -1;
+		return;
+	}
+
+	int parent = mNodes[leaf].parent;
+	int grandParent = mNodes[parent].parent;
+	int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+	if(grandParent >= 0)
+	{
+		//replace parent by sibling
+		if(mNodes[grandParent].child1 == parent)
+			mNodes[grandParent].child1 = sibling;
+		else
+			mNodes[grandParent].child2 = sibling;
+
+		mNodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		int index = grandParent;
+		while(index >= 0)
+		{
+			index = balance(index);
+
+			Node& node = mNodes[index];
+			node.height	= 1 + Math::maxValue(mNodes[node.child1].height, mNodes[node.child2].height);
+			node.box	= Merged(mNodes[node.child1].box, mNodes[node.child2].box);
+
+			index = node.parent;
+		}
+	}
+	else
+	{
+		mRoot = sibling;
+		mNodes[sibling].parent = -1;
+		freeNode(parent);
+	}
+}
+
+int AABBTree::balance(int iA)
+{
+	//rotates subtree if children heights differ by more than one, returns new subtree root
+
+	Node& A = mNodes[iA];
+	if(A.isLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+
+	int heightDiff = mNodes[iC].height - mNodes[iB].height;
+
+	if(heightDiff > 1 || heightDiff < -1)
+	{
+		//promote higher child
+		int iUp		= heightDiff > 0 ? iC : iB;
+		int iLow	= heightDiff > 0 ? iB : iC;
+
+		Node& up = mNodes[iUp];
+
+		int iF = up.child1;
+		int iG = up.child2;
+
+		up.child1 = iA;
+		up.parent = A.parent;
+		A.parent = iUp;
+
+		if(up.parent >= 0)
+		{
+			if(mNodes[up.parent].child1 == iA)
+				mNodes[up.parent].child1 = iUp;
+			else
+				mNodes[up.parent].child2 = iUp;
+		}
+		else
+		{
+			mRoot = iUp;
+		}
+
+		//keep higher grandchild under promoted node
+		int iKeep	= mNodes[iF].height > mNodes[iG].height ? iF : iG;
+		int iMove	= iKeep == iF ? iG : iF;
+
+		up.child2 = iKeep;
+
+		if(heightDiff > 0)
+			A.child2 = iMove;
+		else
+			A.child1 = iMove;
+
+		mNodes[iMove].parent = iA;
+
+		A.box		= Merged(mNodes[iLow].box, mNodes[iMove].box);
+		A.height	= 1 + Math::maxValue(mNodes[iLow].height, mNodes[iMove].height);
+
+		up.box		= Merged(A.box, mNodes[iKeep].box);
+		up.height	= 1 + Math::maxValue(A.height, mNodes[iKeep].height);
+
+		return iUp;
+	}
+
+	return iA;
+}
+
+void AABBTree::query(const AABB& box, PROXIES_LIST& outProxies) const
+{
+	if(mRoot < 0)
+		return;
+
+	mStack.clear();
+	mStack.push_back(mRoot);
+
+	while(mStack.size() > 0)
+	{
+		int index = mStack.back();
+		mStack.pop_back();
+
+		const Node& node = mNodes[index];
+
+		if(!node.box.intersects(box))
+			continue;
+
+		if(node.isLeaf())
+		{
+			outProxies.push_back(index);
+		}
+		else
+		{
+			mStack.push_back(node.child1);
+			mStack.push_back(node.child2);
+		}
+	}
+}
+
+void AABBTree::querySegment(const vec3& from, const vec3& to, PROXIES_LIST& outProxies) const
+{
+	if(mRoot < 0)
+		return;
+
+	vec3 dir = to - from;
+
+	mStack.clear();
+	mStack.push_back(mRoot);
+
+	while(mStack.size() > 0)
+	{
+		int index = mStack.back();
+		mStack.pop_back();
+
+		const Node& node = mNodes[index];
+
+		//segment vs box slab test
+		float tMin = 0.0f, tMax = 1.0f;
+		bool hit = true;
+
+		for(int i = 0; i < 3 && hit; ++i)
+		{
+			if(Math::absValue(dir[i]) < EPSILON)
+			{
+				hit = from[i] >= node.box.min[i] && from[i] <= node.box.max[i];
+			}
+			else
+			{
+				float t0 = (node.box.min[i] - from[i]) / dir[i];
+				float t1 = (node.box.max[i] - from[i]) / dir[i];
+				if(t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+				tMin = Math::maxValue(tMin, t0);
+				tMax = Math::minValue(tMax, t1);
+				hit = tMin <= tMax;
+			}
+		}
+
+		if(!hit)
+			continue;
+
+		if(node.isLeaf())
+		{
+			outProxies.push_back(index);
+		}
+		else
+		{
+			mStack.push_back(node.child1);
+			mStack.push_back(node.child2);
+		}
+	}
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <common/common.h>
+#include <Math/AABB.h>
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+namespace World {
+
+using namespace Math;
+
+//Dynamic bounding volume tree used as collision broadphase.
+//Leaves store fattened boxes so small movements do not touch the tree,
+//insertions pick sibling by surface area heuristic and tree is kept balanced by rotations.
+class SQWORLD_API AABBTree
+{
+public:
+
+	typedef int PROXY;
+
+	static const PROXY INVALID_PROXY = -1;
+
+	typedef std::vector<PROXY> PROXIES_LIST;
+
+private:
+
+	struct Node
+	{
+		AABB	box;
+		void *	userData;
+		int		parent;//next free node when node is not used
+		int		child1;
+		int		child2;
+		int		height;//0 for leaves, -1 for free nodes
+
+		inline bool isLeaf() const { return child1 < 0; }
+	};
+
+public:
+	AABBTree(float margin = 0.1f);
+	~AABBTree();
+
+	PROXY	createProxy(const AABB& box, void * userData);
+	void	destroyProxy(PROXY proxy);
+
+	//returns true if proxy was reinserted, displacement extends fat box in movement direction
+	bool	moveProxy(PROXY proxy, const AABB& box, const vec3& displacement = vec3(0, 0, 0));
+
+	inline void *		getUserData(PROXY proxy)	const { return mNodes[proxy].userData; }
+	inline const AABB&	getFatAABB(PROXY proxy)		const { return mNodes[proxy].box; }
+
+	//appends leaves overlapping box
+	void	query(const AABB& box, PROXIES_LIST& outProxies) const;
+
+	//appends leaves which boxes are crossed by segment
+	void	querySegment(const vec3& from, const vec3& to, PROXIES_LIST& outProxies) const;
+
+	int		getHeight() const { return mRoot >= 0 ? mNodes[mRoot].height : 0; }
+	int		getProxiesNum() const { return mProxiesNum; }
+
+	void	clear();
+
+private:
+
+	int		allocateNode();
+	void	freeNode(int node);
+
+	void	insertLeaf(int leaf);
+	void	removeLeaf(int leaf);
+
+	int		balance(int node);
+
+private:
+
+	std::vector<Node> mNodes;
+
+	int		mRoot;
+	int		mFreeList;
+	int		mProxiesNum;
+
+	float	mMargin;
+
+	mutable std::vector<int> mStack;
+};
+
+}//namespace World {
+}//namespace Squirrel {
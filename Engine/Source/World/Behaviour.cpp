@@ -1,4 +1,5 @@
 #include "Behaviour.h"
+#include "BehaviourScheduler.h"
 #include <Reflection/AtomicWrapper.h>
 
 namespace Squirrel {
@@ -36,6 +37,11 @@ Behaviour::Behaviour()
 
 	mEnabled = true;
 
+	mScheduler		= NULL;
+	mBatch			= -1;
+	mSlot			= -1;
+	mDeltaTime		= 0;
+
 	mClassNamesStack.push_back( std::string("World::Behaviour") );
 
 	wrapAtomicField("Enabled", &mEnabled, 1);
@@ -43,6 +49,8 @@ Behaviour::Behaviour()
 
 Behaviour::~Behaviour()
 {
+	if(mScheduler != NULL)
+		mScheduler->remove(this);
 }
 
 }//namespace World { 
@@ -10,15 +10,31 @@ namespace Squirrel {
 namespace World { 
 
 class SceneObject;
+class BehaviourScheduler;
 
 class SQWORLD_API Behaviour : 
 	public Reflection::Object
 {
 public:
 	friend class SceneObject;
+	friend class BehaviourScheduler;
 
 	typedef std::set<std::string> CLASSNAMES_SET;
 
+	//periods are in seconds, zero period means update every frame;
+	//far and invisible periods are used (if they are longer) while object is
+	//farther than far distance from view point or is culled by main camera
+	struct UpdateRate
+	{
+		UpdateRate(float period_ = 0, float farDistance_ = 0, float farPeriod_ = 0, float invisiblePeriod_ = 0):
+			period(period_), farDistance(farDistance_), farPeriod(farPeriod_), invisiblePeriod(invisiblePeriod_) {}
+
+		float period;
+		float farDistance;//zero turns distance tier off
+		float farPeriod;
+		float invisiblePeriod;
+	};
+
 public:
 	Behaviour();
 	virtual ~Behaviour();
@@ -30,11 +46,22 @@ public:
 	virtual void onBecomeInvisible()	{ };
 	virtual void renderDebugInfo()		{ };
 
+	//thread safe behaviours of class are updated in parallel, so their update must not change
+	//anything shared (e.g. transforms of scene objects, behaviours or objects lists);
+	//asked once per class when its first behaviour is started
+	virtual bool isThreadSafe() const	{ return false; }
+
 	inline SceneObject * getSceneObject()	{ return mSceneObject; }
 
 	bool isEnabled()				{ return mEnabled; }
 	void setEnabled(bool enabled)	{ mEnabled = enabled; }
 
+	const UpdateRate& getUpdateRate() const		{ return mUpdateRate; }
+	void setUpdateRate(const UpdateRate& rate)	{ mUpdateRate = rate; }
+
+	//seconds since previous update, use it instead of frame time since updates may be skipped
+	float getDeltaTime() const	{ return mDeltaTime; }
+
 	template <class TBehaviour>
 	static void RegisterBehaviourClass(const std::string& className)
 	{
@@ -48,10 +75,18 @@ protected:
 
 	SceneObject *	mSceneObject;
 
+	UpdateRate		mUpdateRate;
+
 private:
 
 	bool mHasStarted;
 	bool mEnabled;
+
+	//scheduling state
+	BehaviourScheduler *	mScheduler;
+	int						mBatch;
+	int						mSlot;
+	float					mDeltaTime;
 };
 
 template <class TClass>
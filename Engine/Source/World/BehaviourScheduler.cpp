@@ -0,0 +1,372 @@
+#include "BehaviourScheduler.h"
+#include "Behaviour.h"
+#include "SceneObject.h"
+#include <Common/Profiler.h>
+#include <Common/TaskPool.h>
+#include <algorithm>
+#include <math.h>
+
+namespace Squirrel {
+namespace World {
+
+BehaviourScheduler * BehaviourScheduler::sActive = NULL;
+
+namespace {
+
+const int64 NO_TICK = -1;
+
+//golden ratio sequence, evenly spreads phases of behaviours added one by one
+const float PHASE_STEP = 0.618034f;
+
+const float AVG_MS_WEIGHT = 0.05f;
+
+bool IsActive(Behaviour * behaviour)
+{
+	return behaviour->isEnabled() && behaviour->getSceneObject() != NULL && behaviour->getSceneObject()->isEnabled();
+}
+
+}//namespace {
+
+BehaviourScheduler::BehaviourScheduler():
+	mTime(0), mBehavioursNum(0), mAddedNum(0), mUpdating(false)
+{
+}
+
+BehaviourScheduler::~BehaviourScheduler()
+{
+	if(sActive == this)
+		sActive = NULL;
+
+	//behaviours which outlive scheduler are not updated anymore
+
+	for(size_t i = 0; i < mStartQueue.size(); ++i)
+	{
+		if(mStartQueue[i] != NULL)
+			mStartQueue[i]->mScheduler = NULL;
+	}
+
+	for(size_t b = 0; b < mBatches.size(); ++b)
+	{
+		std::vector<Entry>& entries = mBatches[b].entries;
+		for(size_t i = 0; i < entries.size(); ++i)
+		{
+			if(entries[i].behaviour != NULL)
+			{
+				entries[i].behaviour->mScheduler = NULL;
+				entries[i].behaviour->mBatch = -1;
+				entries[i].behaviour->mSlot = -1;
+			}
+		}
+	}
+}
+
+BehaviourScheduler * BehaviourScheduler::Default()
+{
+	//never destroyed to stay valid for behaviours released at exit
+	static BehaviourScheduler * sDefault = new BehaviourScheduler();
+	return sDefault;
+}
+
+BehaviourScheduler * BehaviourScheduler::Active()
+{
+	return sActive != NULL ? sActive : Default();
+}
+
+void BehaviourScheduler::SetActive(BehaviourScheduler * scheduler)
+{
+	sActive = scheduler;
+}
+
+void BehaviourScheduler::add(Behaviour * behaviour)
+{
+	ASSERT(behaviour->mScheduler == NULL);
+
+	behaviour->mScheduler = this;
+	behaviour->mHasStarted = false;
+
+	mStartQueue.push_back(behaviour);
+	++mBehavioursNum;
+
+	behaviour->awake();
+}
+
+void BehaviourScheduler::remove(Behaviour * behaviour)
+{
+	ASSERT(behaviour->mScheduler == this);
+
+	//queues are cleared only when processed, so they stay valid if changed by callbacks
+
+	for(size_t i = 0; i < mVisibilityChanges.size(); ++i)
+	{
+		if(mVisibilityChanges[i].first == behaviour)
+			mVisibilityChanges[i].first = NULL;
+	}
+
+	if(behaviour->mBatch < 0)
+	{
+		std::vector<Behaviour *>::iterator it = std::find(mStartQueue.begin(), mStartQueue.end(), behaviour);
+		if(it != mStartQueue.end())
+			*it = NULL;
+	}
+	else
+	{
+		ClassBatch& batch = mBatches[behaviour->mBatch];
+		batch.entries[behaviour->mSlot].behaviour = NULL;
+		++batch.deadNum;
+
+		if(!mUpdating)
+			compact(batch);
+	}
+
+	behaviour->mScheduler = NULL;
+	behaviour->mBatch = -1;
+	behaviour->mSlot = -1;
+
+	--mBehavioursNum;
+}
+
+void BehaviourScheduler::setVisible(Behaviour * behaviour, bool visible)
+{
+	if(behaviour->mBatch < 0)
+		return;
+
+	Entry& entry = mBatches[behaviour->mBatch].entries[behaviour->mSlot];
+	if(entry.visible != visible)
+	{
+		entry.visible = visible;
+		mVisibilityChanges.push_back(std::make_pair(behaviour, visible));
+	}
+}
+
+void BehaviourScheduler::addStarted(Behaviour * behaviour)
+{
+	const std::string& className = behaviour->getClassName();
+
+	int batchIndex = -1;
+
+	std::map<std::string, int>::iterator it = mBatchIndices.find(className);
+	if(it != mBatchIndices.end())
+	{
+		batchIndex = it->second;
+	}
+	else
+	{
+		batchIndex = (int)mBatches.size();
+		mBatchIndices[className] = batchIndex;
+
+		mBatches.push_back(ClassBatch());
+		ClassBatch& newBatch = mBatches.back();
+		newBatch.name			= className;
+		newBatch.parallel		= behaviour->isThreadSafe();
+		newBatch.deadNum		= 0;
+		newBatch.updatedNum		= 0;
+		newBatch.updateMs		= 0;
+		newBatch.avgUpdateMs	= 0;
+	}
+
+	ClassBatch& batch = mBatches[batchIndex];
+
+	Entry entry;
+	entry.behaviour			= behaviour;
+	entry.phase				= fmodf(mAddedNum++ * PHASE_STEP, 1.0f);
+	entry.lastTick			= NO_TICK;
+	entry.lastUpdateTime	= mTime;
+	entry.visible			= true;//till culling tells otherwise
+
+	behaviour->mBatch	= batchIndex;
+	behaviour->mSlot	= (int)batch.entries.size();
+
+	batch.entries.push_back(entry);
+}
+
+void BehaviourScheduler::startQueued()
+{
+	//started behaviours may add new ones, those are started in the same pass
+	for(size_t i = 0; i < mStartQueue.size(); ++i)
+	{
+		Behaviour * behaviour = mStartQueue[i];
+		if(behaviour == NULL || !IsActive(behaviour))
+			continue;
+
+		behaviour->start();
+
+		//behaviour could be removed by start
+		if(mStartQueue[i] == behaviour)
+		{
+			mStartQueue[i] = NULL;
+			behaviour->mHasStarted = true;
+			addStarted(behaviour);
+		}
+	}
+
+	//disabled behaviours wait for being enabled
+	mStartQueue.erase(std::remove(mStartQueue.begin(), mStartQueue.end(), (Behaviour *)NULL), mStartQueue.end());
+}
+
+void BehaviourScheduler::applyVisibilityChanges()
+{
+	for(size_t i = 0; i < mVisibilityChanges.size(); ++i)
+	{
+		Behaviour * behaviour = mVisibilityChanges[i].first;
+		if(behaviour == NULL || !IsActive(behaviour))
+			continue;
+
+		if(mVisibilityChanges[i].second)
+			behaviour->onBecomeVisible();
+		else
+			behaviour->onBecomeInvisible();
+	}
+
+	mVisibilityChanges.clear();
+}
+
+void BehaviourScheduler::selectDue(ClassBatch& batch, const Math::vec3& viewPoint)
+{
+	batch.due.clear();
+
+	for(size_t i = 0; i < batch.entries.size(); ++i)
+	{
+		Entry& entry = batch.entries[i];
+		Behaviour * behaviour = entry.behaviour;
+		if(behaviour == NULL || !IsActive(behaviour))
+			continue;
+
+		const Behaviour::UpdateRate& rate = behaviour->getUpdateRate();
+
+		float period = rate.period;
+
+		if(rate.farDistance > 0)
+		{
+			Math::vec3 pos = behaviour->getSceneObject()->getTransform().getTranslate();
+			if((pos - viewPoint).lenSquared() > rate.farDistance * rate.farDistance)
+				period = Math::maxValue(period, rate.farPeriod);
+		}
+
+		if(!entry.visible)
+			period = Math::maxValue(period, rate.invisiblePeriod);
+
+		if(period > 0)
+		{
+			//period is split into ticks shifted by phase of entry, behaviour is updated once per tick
+			int64 tick = (int64)floor(mTime / period + entry.phase);
+			if(tick == entry.lastTick)
+				continue;
+			entry.lastTick = tick;
+		}
+		else
+		{
+			entry.lastTick = NO_TICK;
+		}
+
+		behaviour->mDeltaTime = (float)(mTime - entry.lastUpdateTime);
+		entry.lastUpdateTime = mTime;
+
+		batch.due.push_back((int)i);
+	}
+}
+
+void BehaviourScheduler::UpdateEntries(void * context, int begin, int end)
+{
+	ClassBatch * batch = (ClassBatch *)context;
+
+	for(int i = begin; i < end; ++i)
+	{
+		//entry is cleared if its behaviour was removed by update of another one
+		Behaviour * behaviour = batch->entries[ batch->due[i] ].behaviour;
+		if(behaviour != NULL)
+			behaviour->update();
+	}
+}
+
+void BehaviourScheduler::updateBatch(ClassBatch& batch)
+{
+	uint64 begin = Profiler::Now();
+
+	if(batch.parallel)
+	{
+		TaskPool::Default()->parallelFor((int)batch.due.size(), 1, &UpdateEntries, &batch);
+	}
+	else
+	{
+		UpdateEntries(&batch, 0, (int)batch.due.size());
+	}
+
+	batch.updatedNum	= (int)batch.due.size();
+	batch.updateMs		= (Profiler::Now() - begin) / 1000000.0f;
+	batch.avgUpdateMs	= Math::lerp(batch.avgUpdateMs, batch.updateMs, AVG_MS_WEIGHT);
+}
+
+void BehaviourScheduler::compact(ClassBatch& batch)
+{
+	if(batch.deadNum == 0)
+		return;
+
+	size_t i = 0;
+	while(i < batch.entries.size())
+	{
+		if(batch.entries[i].behaviour != NULL)
+		{
+			++i;
+			continue;
+		}
+
+		//move last entry to free slot
+		batch.entries[i] = batch.entries.back();
+		batch.entries.pop_back();
+
+		if(i < batch.entries.size() && batch.entries[i].behaviour != NULL)
+		{
+			batch.entries[i].behaviour->mSlot = (int)i;
+		}
+	}
+
+	batch.deadNum = 0;
+}
+
+void BehaviourScheduler::update(float dtime, const Math::vec3& viewPoint)
+{
+	SQ_PROFILE_ZONE("BehaviourScheduler::update");
+
+	mTime += dtime;
+
+	//behaviours are removed by callbacks and updates but batches are compacted after all of them
+	mUpdating = true;
+
+	startQueued();
+
+	applyVisibilityChanges();
+
+	for(size_t b = 0; b < mBatches.size(); ++b)
+	{
+		selectDue(mBatches[b], viewPoint);
+		updateBatch(mBatches[b]);
+	}
+
+	mUpdating = false;
+
+	for(size_t b = 0; b < mBatches.size(); ++b)
+	{
+		compact(mBatches[b]);
+	}
+}
+
+void BehaviourScheduler::getStats(std::vector<ClassStats>& outStats) const
+{
+	outStats.resize(mBatches.size());
+
+	for(size_t b = 0; b < mBatches.size(); ++b)
+	{
+		const ClassBatch& batch = mBatches[b];
+		ClassStats& stats = outStats[b];
+
+		stats.name			= batch.name;
+		stats.behavioursNum	= (int)batch.entries.size() - batch.deadNum;
+		stats.updatedNum	= batch.updatedNum;
+		stats.updateMs		= batch.updateMs;
+		stats.avgUpdateMs	= batch.avgUpdateMs;
+		stats.parallel		= batch.parallel;
+	}
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Common/types.h>
+#include <Math/vec3.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "macros.h"
+
+namespace Squirrel {
+namespace World {
+
+class Behaviour;
+
+//Updates behaviours of scene objects.
+//Behaviours are kept in contiguous lists per class, so one class is updated at a time and timed separately.
+//Started behaviours wait in separate queue till their first update and visibility changes reported
+//by culling of main camera are delivered before updates of next frame.
+//Classes which behaviours are thread safe are updated by task pool workers.
+class SQWORLD_API BehaviourScheduler
+{
+public:
+
+	struct ClassStats
+	{
+		std::string	name;
+		int			behavioursNum;
+		int			updatedNum;//last frame
+		float		updateMs;//last frame
+		float		avgUpdateMs;
+		bool		parallel;
+	};
+
+private:
+
+	struct Entry
+	{
+		Behaviour *	behaviour;
+		float		phase;//spreads throttled updates of class over frames
+		int64		lastTick;
+		double		lastUpdateTime;
+		bool		visible;
+	};
+
+	struct ClassBatch
+	{
+		std::string			name;
+		std::vector<Entry>	entries;
+		bool				parallel;
+		int					deadNum;//entries of behaviours unregistered while updating
+		int					updatedNum;
+		float				updateMs;
+		float				avgUpdateMs;
+		std::vector<int>	due;//entries to update this frame
+	};
+
+	static BehaviourScheduler * sActive;
+
+	BehaviourScheduler(const BehaviourScheduler&);
+	const BehaviourScheduler& operator=(const BehaviourScheduler&);
+
+public:
+	BehaviourScheduler();
+	~BehaviourScheduler();
+
+	static BehaviourScheduler * Active();
+	static BehaviourScheduler * Default();
+	static void SetActive(BehaviourScheduler * scheduler);
+
+	//calls awake, behaviour is started on next update
+	void add(Behaviour * behaviour);
+	void remove(Behaviour * behaviour);
+
+	//queued till next update, called by culling pass of main camera
+	void setVisible(Behaviour * behaviour, bool visible);
+
+	//view point is used by distance based update periods
+	void update(float dtime, const Math::vec3& viewPoint);
+
+	void getStats(std::vector<ClassStats>& outStats) const;
+
+	int getBehavioursNum() const { return mBehavioursNum; }
+
+private:
+
+	void startQueued();
+	void applyVisibilityChanges();
+
+	void selectDue(ClassBatch& batch, const Math::vec3& viewPoint);
+	void updateBatch(ClassBatch& batch);
+	void compact(ClassBatch& batch);
+
+	void addStarted(Behaviour * behaviour);
+
+	static void UpdateEntries(void * context, int begin, int end);
+
+private:
+
+	std::vector<ClassBatch>		mBatches;
+	std::map<std::string, int>	mBatchIndices;
+
+	std::vector<Behaviour *>	mStartQueue;
+	std::vector<std::pair<Behaviour *, bool> > mVisibilityChanges;
+
+	double						mTime;
+	int							mBehavioursNum;
+	uint32						mAddedNum;
+	bool						mUpdating;
+};
+
+}//namespace World {
+}//namespace Squirrel {
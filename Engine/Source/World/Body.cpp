@@ -4,8 +4,13 @@
 #include <Resource/AnimationRunner.h>
 #include <Reflection/AtomicWrapper.h>
 #include <Common/Log.h>
+#include <Common/StlAllocators.h>
 #include "Skeleton.h"
+#include "CollisionWorld.h"
+#include "MeshCollider.h"
+#include <Render/IRender.h>
 #include <sstream>
+#include <float.h>
 
 namespace Squirrel {
 
@@ -16,6 +21,26 @@ Render::UniformString sUniformNormalHeightMap	("normalHeightMap");
 Render::UniformString sUniformSpecularMap		("specularMap");
 Render::UniformString sUniformDetailMap			("detailMap");
 
+namespace {
+
+//pixels taken on screen by bounding sphere of box, textures of body need not more texels
+float CalcScreenSize(const AABB& box, Render::Camera * camera)
+{
+	float viewportHeight = (float)Render::IRender::GetActive()->getViewport().w;
+	float diameter = box.getSize().len();
+
+	if(camera->getType() == Render::Camera::Orthographic)
+		return diameter * viewportHeight / camera->getViewHeight();
+
+	float distance = (box.getCenter() - camera->getPosition()).len();
+	if(distance <= diameter * 0.5f)
+		return FLT_MAX;
+
+	return diameter * viewportHeight / (2.0f * tanf(camera->getFov() * 0.5f) * distance);
+}
+
+}//namespace {
+
 SQREFL_REGISTER_CLASS_SEED(World::Body, WorldBody);
 
 Body::Body()
@@ -63,6 +88,7 @@ void Body::initMembers()
 	mSkeleton			= NULL;
 
 	mModelRoot			= false;
+	mModelLoading		= false;
 	mMeshId				= _INVALID_ID;
 }
 
@@ -115,6 +141,7 @@ void Body::addChildren(Model::Node::NODE_LIST * sourceMeshNodes, Body * modelRoo
 		newChild->getLocalPosition();
 
 		modelRoot->setupSubordinate(newChild, bodiesWithSkeletons);
+		newChild->attachCollider();
 
 		addSceneObject(newChild);
 
@@ -137,6 +164,9 @@ void Body::setupSubordinate(Body * subordinate, BODIES_LIST& bodiesWithSkeletons
 		animTarget->mChangeFlags = new bool*[ animTarget->mComponentsNum ];
 		for(int i = 0; i < 16;++i) animTarget->mChangeFlags[i] = &subordinate->mTransformChanged;
 		mTargetsMap.set( subordinate->mMesh->mID, animTarget );
+
+		//animation writes local transform directly so hierarchy has to check it every update
+		subordinate->setTransformPolled(true);
 	}
 
 	//setup skeleton
@@ -158,6 +188,40 @@ void Body::initWithMesh(Resource::Mesh * mesh)
 	matLink.mMeshId = -1;
 	matLink.mMesh = mesh;
 	mMeshOwner = true;
+
+	attachCollider();
+
+	invalidateBounds();
+}
+
+void Body::attachCollider()
+{
+	CollisionWorld * collisions = CollisionWorld::Active();
+	if(collisions == NULL || mMesh == NULL)
+		return;
+
+	//skinned meshes are deformed by skeleton, so they take part in broadphase only
+	if(mMesh->mSkin != NULL)
+	{
+		collisions->addObject(this);
+		return;
+	}
+
+	std::vector<Resource::Mesh *> meshes;
+	for(size_t i = 0; i < mMesh->mMatLinks.size(); ++i)
+	{
+		meshes.push_back(mMesh->mMatLinks[i].mMesh);
+	}
+
+	MeshCollider * collider = new MeshCollider();
+	if(collider->build(meshes))
+	{
+		collisions->addObject(this, COLLIDER_PTR(collider));
+	}
+	else
+	{
+		DELETE_PTR(collider);
+	}
 }
 
 void Body::initWithModel(Model * sourceModel)
@@ -195,8 +259,16 @@ void Body::onModelNameChanged()
 		ModelStorage::Active()->release( mModel->getID() );
 	}
 
+	//add finishes model if it is being loaded asynchronously
 	mModel = ModelStorage::Active()->add( mModelName );
 
+	if(mModelLoading)
+	{
+		//placeholder is not needed anymore
+		mModelLoading	= false;
+		mMesh			= NULL;
+	}
+
 	initWithModel(mModel);
 }
 
@@ -254,37 +326,55 @@ void Body::deserialize(Reflection::Deserializer * deserializer)
 
 	if(mModelName.length() > 0 && mModelRoot)
 	{
-		mModel = ModelStorage::Active()->add( mModelName );		
+		vec3 position = getPosition();
+		mModel = ModelStorage::Active()->addAsync( mModelName, 0.0f, &position );
 	}
 
 	if(mModelRoot && mModel != NULL)
 	{
-		BODIES_LIST bodiesWithSkeletons;
+		if(mModel->isLoading())
+		{
+			//subordinates are bound in update when model is loaded
+			mModelLoading	= true;
+			mMesh			= ModelStorage::Active()->getPlaceholder();
+			mMeshOwner		= false;
+		}
+		else
+		{
+			bindModel();
+		}
+	}
+}
 
-		SCENE_OBJECTS_LIST descendants(mSceneObjects);
-		while(descendants.size() > 0)
+void Body::bindModel()
+{
+	BODIES_LIST bodiesWithSkeletons;
+
+	SCENE_OBJECTS_LIST descendants(mSceneObjects);
+	while(descendants.size() > 0)
+	{
+		SceneObject * descendant = descendants.front();
+		descendants.pop_front();
+
+		if(descendant->isKindOfClass("World::Body"))
 		{
-			SceneObject * descendant = descendants.front();
-			descendants.pop_front();
+			Body * body = static_cast<Body *>(descendant);
 
-			if(descendant->isKindOfClass("World::Body"))
+			if(body->mModelName == mModelName)
 			{
-				Body * body = static_cast<Body *>(descendant);
-
-				if(body->mModelName == mModelName)
-				{
-					body->mMesh			= mModel->findNode(body->mMeshId);
-					body->mMeshOwner	= false;
-					body->mMaster		= this;
-					setupSubordinate(body, bodiesWithSkeletons);
-				}
+				body->mMesh			= mModel->findNode(body->mMeshId);
+				body->mMeshOwner	= false;
+				body->mMaster		= this;
+				setupSubordinate(body, bodiesWithSkeletons);
+				body->attachCollider();
+				body->invalidateBounds();
 			}
-
-			descendants.insert(descendants.end(), descendant->getSceneObjects().begin(), descendant->getSceneObjects().end());
 		}
 
-		setupMasterAnimations(bodiesWithSkeletons);
+		descendants.insert(descendants.end(), descendant->getSceneObjects().begin(), descendant->getSceneObjects().end());
 	}
+
+	setupMasterAnimations(bodiesWithSkeletons);
 }
 
 void Body::saveSubAnims()
@@ -320,6 +410,19 @@ void Body::saveSubAnims()
 
 void Body::update(float dtime)
 {
+	if(mModelLoading && !mModel->isLoading())
+	{
+		mModelLoading	= false;
+		mMesh			= NULL;
+
+		if(mModel->getLoadState() == StoredObject::lsLoaded)
+		{
+			bindModel();
+		}
+
+		invalidateBounds();
+	}
+
 	if(mSkeleton != NULL && mMesh != NULL)
 	{
 		//mSkeleton->build( );
@@ -345,6 +448,16 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 
 	float lod = Math::maxValue( 0.0f, info.minLOD );
 
+	//levels of textures are streamed by what main camera sees
+	TextureStreamer * streamer = NULL;
+	float screenSize = 0;
+	if(camera == Render::Camera::GetMainCamera())
+	{
+		streamer = TextureStorage::Active()->getStreamer();
+		if(streamer != NULL)
+			screenSize = CalcScreenSize(getAABB(), camera);
+	}
+
 	for(size_t i = 0; i < mMesh->mMatLinks.size(); ++i)
 	{
 		Model::MaterialLink& matLink = mMesh->mMatLinks[i];
@@ -356,7 +469,7 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 
 		Render::MaterialGroup * matGroup = renderQueue->beginMaterialGroup();
 
-		std::stringstream programParams;
+		FrameString programParams;
 
 		Texture * decalMap = NULL;
 		if(info.level >= rilDecalMaps)
@@ -367,11 +480,13 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 				if(decalMap)
 				{
 					matGroup->mTextures[sUniformDecalMap] = decalMap->getRenderTexture();
+					if(streamer != NULL)
+						streamer->requestSize(decalMap, screenSize);
 				}
 			}
 			if (!decalMap)
 			{
-				programParams << "NOTEXTURES;";
+				programParams += "NOTEXTURES;";
 			}
 		}
 		if(info.level >= rilMaterials)
@@ -386,7 +501,9 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 					if(bumpMap)
 					{
 						matGroup->mTextures[sUniformNormalHeightMap] = bumpMap->getRenderTexture();
-						programParams << "BUMP;";
+						programParams += "BUMP;";
+						if(streamer != NULL)
+							streamer->requestSize(bumpMap, screenSize);
 					}
 				}
 				if(matLink.idTexSpecular >= 0)
@@ -395,7 +512,9 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 					if(specMap)
 					{
 						matGroup->mTextures[sUniformSpecularMap] = specMap->getRenderTexture();
-						programParams << "SPECULAR_MAP;";
+						programParams += "SPECULAR_MAP;";
+						if(streamer != NULL)
+							streamer->requestSize(specMap, screenSize);
 					}
 				}
 			}
@@ -425,14 +544,19 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 				mSkeleton->buildGPUData();
 
 				//GPU skinning
-				programParams		<< "SKINNING;";
+				programParams		+= "SKINNING;";
 				bonesCount			= mSkeleton->getGPUBonesData().getCount();
 				bonesData			= mSkeleton->getGPUBonesData().getData();
 			}
 			vb = matLink.mMesh->getVertexBuffer();
 		}
 
-		matGroup->mProgramParams = programParams.str();
+		if(vb->isPacked())
+		{
+			programParams += "PACKED_VERTICES;";
+		}
+
+		matGroup->mProgramParams.setString(programParams.c_str(), programParams.length());
 
 		matGroup = renderQueue->endMaterialGroup();
 
@@ -443,7 +567,7 @@ void Body::render(Render::RenderQueue * renderQueue, Render::Camera * camera, co
 
 		Render::IndexPrimitive * primitive = vbGroup->getIndexPrimitive(matLink.mMesh->getIndexBuffer());
 
-		mat4 transform = mTransform;
+		mat4 transform = getTransform();
 		if(mSkeleton != NULL)
 		{
 			transform = mat4::Identity();
@@ -462,7 +586,7 @@ void Body::calcAABB()
 		for(size_t i = 0; i < mMesh->mMatLinks.size(); ++i)
 		{
 			AABB meshAABB = mMesh->mMatLinks[i].mMesh->getAABB();
-			meshAABB.transform( mTransform );
+			meshAABB.transform( getTransform() );
 			mAABB.merge(meshAABB);
 		}
 
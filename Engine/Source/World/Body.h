@@ -48,6 +48,12 @@ private:
 
 	void onModelNameChanged();
 
+	//links subordinate bodies to nodes of loaded model
+	void bindModel();
+
+	//registers mesh of subordinate body in active collision world
+	void attachCollider();
+
 protected:
 
 	virtual void calcAABB();
@@ -65,6 +71,7 @@ protected:
 	std::string		  mModelName;
 	_ID				  mMeshId;
 	bool			  mModelRoot;
+	bool			  mModelLoading;//model is loaded asynchronously, placeholder is rendered
 };
 
 }//namespace World { 
@@ -0,0 +1,177 @@
+#include "Collider.h"
+#include <Math/GeometryTools.h>
+
+namespace Squirrel {
+namespace World {
+
+namespace {
+
+inline float MaxScale(const mat4& transform)
+{
+	vec3 scale = transform.extractScale();
+	return Math::maxValue(scale.x, Math::maxValue(scale.y, scale.z));
+}
+
+inline vec3 ClosestPointOnSegment(const vec3& a, const vec3& b, const vec3& point)
+{
+	if((b - a).lenSquared() < EPSILON_SQUARED)
+		return a;
+	return closestPointOnLine(a, b, point);
+}
+
+}//namespace {
+
+CollisionCapsule Collider::getCapsule(const mat4& transform) const
+{
+	vec3 center = transform.getTranslate();
+	return CollisionCapsule(center, center, 0.0f);
+}
+
+bool Collider::CapsuleVsCapsule(const CollisionCapsule& capsule1, const CollisionCapsule& capsule2, CollisionContact& outContact)
+{
+	vec3 point1, point2;
+	closestPointsOnSegments(capsule1.a, capsule1.b, capsule2.a, capsule2.b, point1, point2);
+
+	float radiusSum = capsule1.radius + capsule2.radius;
+
+	vec3 delta = point1 - point2;
+	float distSq = delta.lenSquared();
+
+	if(distSq >= radiusSum * radiusSum)
+		return false;
+
+	float dist = fsqrt(distSq);
+
+	outContact.normal	= dist > EPSILON ? delta / dist : vec3::AxisY();
+	outContact.depth	= radiusSum - dist;
+	outContact.point	= point2 + outContact.normal * capsule2.radius;
+
+	return true;
+}
+
+bool Collider::CapsuleVsTriangle(const CollisionCapsule& capsule, const CollisionTriangle& triangle, CollisionContact& outContact)
+{
+	const vec3& v0 = triangle.v[0];
+	const vec3& v1 = triangle.v[1];
+	const vec3& v2 = triangle.v[2];
+
+	vec3 normal = (v1 - v0) ^ (v2 - v0);
+	float normalLen = normal.len();
+	if(normalLen < EPSILON_SQUARED)
+		return false;
+	normal /= normalLen;
+
+	//pick capsule axis point nearest to triangle: intersection of axis line with triangle plane
+	//is clamped to triangle and then projected back to axis
+
+	vec3 axis = capsule.b - capsule.a;
+	vec3 reference = capsule.a;
+
+	float axisDotN = axis * normal;
+	if(Math::absValue(axisDotN) > EPSILON)
+	{
+		float t = (normal * (v0 - capsule.a)) / axisDotN;
+		reference = capsule.a + axis * t;
+	}
+
+	reference = closestPointOnTriangle(v0, v1, v2, reference);
+
+	vec3 center = ClosestPointOnSegment(capsule.a, capsule.b, reference);
+
+	//sphere vs triangle
+
+	vec3 closest = closestPointOnTriangle(v0, v1, v2, center);
+	vec3 delta = center - closest;
+	float distSq = delta.lenSquared();
+
+	if(distSq >= capsule.radius * capsule.radius)
+		return false;
+
+	float dist = fsqrt(distSq);
+
+	if(dist > EPSILON)
+	{
+		outContact.normal = delta / dist;
+	}
+	else
+	{
+		//center lies on triangle, push out to side where capsule axis goes
+		outContact.normal = (axisDotN < 0.0f) ? -normal : normal;
+	}
+
+	outContact.depth	= capsule.radius - dist;
+	outContact.point	= closest;
+
+	return true;
+}
+
+bool Collider::RaycastCapsule(const CollisionCapsule& capsule, const vec3& from, const vec3& to, float& outFraction, vec3& outNormal)
+{
+	vec3 dir = to - from;
+	float length = dir.len();
+	if(length < EPSILON)
+		return false;
+
+	//test sphere at capsule axis point closest to segment,
+	//exact for spheres and for rays hitting capsule side
+	vec3 onSegment, onAxis;
+	closestPointsOnSegments(from, to, capsule.a, capsule.b, onSegment, onAxis);
+
+	if((from - onAxis).lenSquared() <= capsule.radius * capsule.radius)
+	{
+		//starts inside
+		outFraction = 0.0f;
+		outNormal = (from - onAxis).lenSquared() > EPSILON_SQUARED ? (from - onAxis).normalized() : -dir / length;
+		return true;
+	}
+
+	float distance = raySphereIntersection(from, dir / length, onAxis, capsule.radius);
+	if(distance < 0.0f || distance > length)
+		return false;
+
+	vec3 point = from + dir * (distance / length);
+
+	outFraction = distance / length;
+	outNormal = (point - ClosestPointOnSegment(capsule.a, capsule.b, point)).normalized();
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+AABB SphereCollider::getLocalBounds() const
+{
+	AABB box;
+	box.setCenterSize(mCenter, vec3(mRadius, mRadius, mRadius) * 2.0f);
+	return box;
+}
+
+CollisionCapsule SphereCollider::getCapsule(const mat4& transform) const
+{
+	vec3 center = transform * mCenter;
+	return CollisionCapsule(center, center, mRadius * MaxScale(transform));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+AABB CapsuleCollider::getLocalBounds() const
+{
+	AABB box;
+	box.setCenterSize(mCenter, vec3(mRadius * 2.0f, Math::maxValue(mHeight, mRadius * 2.0f), mRadius * 2.0f));
+	return box;
+}
+
+CollisionCapsule CapsuleCollider::getCapsule(const mat4& transform) const
+{
+	float halfAxis = Math::maxValue(mHeight * 0.5f - mRadius, 0.0f);
+
+	vec3 a = transform * (mCenter - vec3(0, halfAxis, 0));
+	vec3 b = transform * (mCenter + vec3(0, halfAxis, 0));
+
+	vec3 scale = transform.extractScale();
+
+	return CollisionCapsule(a, b, mRadius * Math::maxValue(scale.x, scale.z));
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <Math/AABB.h>
+#include <Math/mat4.h>
+#include "macros.h"
+#include <vector>
+#include <memory>
+
+namespace Squirrel {
+namespace World {
+
+using namespace Math;
+
+struct CollisionTriangle
+{
+	vec3 v[3];
+};
+
+typedef std::vector<CollisionTriangle> COLLISION_TRIANGLES_LIST;
+
+//segment swept sphere, sphere when both ends are equal
+struct CollisionCapsule
+{
+	CollisionCapsule() {}
+	CollisionCapsule(const vec3& a_, const vec3& b_, float radius_): a(a_), b(b_), radius(radius_) {}
+
+	vec3	a;
+	vec3	b;
+	float	radius;
+
+	AABB getBounds() const
+	{
+		AABB box;
+		box.setPoint(a);
+		box.addVertex(b);
+		box.grow(radius);
+		return box;
+	}
+};
+
+struct CollisionContact
+{
+	vec3	point;
+	vec3	normal;//points towards first shape
+	float	depth;
+};
+
+//Collision shape in local space of owning object.
+//Sphere and capsule shapes are convex primitives, mesh and height field shapes are triangle providers.
+class SQWORLD_API Collider
+{
+public:
+
+	enum EType
+	{
+		ctSphere = 0,
+		ctCapsule,
+		ctMesh,
+		ctHeightField,
+		ctNum
+	};
+
+public:
+	Collider(EType type): mType(type) {}
+	virtual ~Collider() {}
+
+	EType getType() const { return mType; }
+
+	inline bool isPrimitive() const { return mType == ctSphere || mType == ctCapsule; }
+
+	virtual AABB getLocalBounds() const = 0;
+
+	//world space capsule of primitive colliders
+	virtual CollisionCapsule getCapsule(const mat4& transform) const;
+
+	//appends local space triangles overlapping local box (triangle providers only)
+	virtual void collectTriangles(const AABB& localBox, COLLISION_TRIANGLES_LIST& outTriangles) const {}
+
+	//nearest local space intersection of segment with triangles, fraction is in [0, 1]
+	virtual bool raycast(const vec3& from, const vec3& to, float& outFraction, vec3& outNormal) const { return false; }
+
+	//narrowphase helpers, contact normal points towards (first) capsule
+	static bool CapsuleVsCapsule(const CollisionCapsule& capsule1, const CollisionCapsule& capsule2, CollisionContact& outContact);
+	static bool CapsuleVsTriangle(const CollisionCapsule& capsule, const CollisionTriangle& triangle, CollisionContact& outContact);
+	static bool RaycastCapsule(const CollisionCapsule& capsule, const vec3& from, const vec3& to, float& outFraction, vec3& outNormal);
+
+private:
+	EType mType;
+};
+
+typedef std::shared_ptr<Collider> COLLIDER_PTR;
+
+class SQWORLD_API SphereCollider:
+	public Collider
+{
+public:
+	SphereCollider(float radius, vec3 center = vec3(0, 0, 0)):
+		Collider(ctSphere), mRadius(radius), mCenter(center) {}
+
+	virtual AABB getLocalBounds() const;
+	virtual CollisionCapsule getCapsule(const mat4& transform) const;
+
+	float	getRadius() const { return mRadius; }
+	vec3	getCenter() const { return mCenter; }
+
+private:
+	float	mRadius;
+	vec3	mCenter;
+};
+
+//capsule along local Y axis
+class SQWORLD_API CapsuleCollider:
+	public Collider
+{
+public:
+	CapsuleCollider(float radius, float height, vec3 center = vec3(0, 0, 0)):
+		Collider(ctCapsule), mRadius(radius), mHeight(height), mCenter(center) {}
+
+	virtual AABB getLocalBounds() const;
+	virtual CollisionCapsule getCapsule(const mat4& transform) const;
+
+	float	getRadius() const { return mRadius; }
+	float	getHeight() const { return mHeight; }//including caps
+	vec3	getCenter() const { return mCenter; }
+
+private:
+	float	mRadius;
+	float	mHeight;
+	vec3	mCenter;
+};
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,651 @@
+#include "CollisionWorld.h"
+#include "HeightFieldCollider.h"
+#include "SceneObject.h"
+#include "Terrain.h"
+#include <algorithm>
+#include <math.h>
+
+namespace Squirrel {
+namespace World {
+
+namespace {
+
+const int MAX_CONTACTS_PER_PAIR		= 4;
+const int MAX_QUERY_CONTACTS		= 16;
+const int MAX_SWEEP_STEPS			= 256;
+const int MAX_DEPENETRATION_STEPS	= 4;
+const int SWEEP_REFINE_STEPS		= 8;
+
+//cos of max slope angle considered to be ground
+const float GROUND_NORMAL_Y = 0.7f;
+
+inline CollisionCapsule Translated(const CollisionCapsule& capsule, const vec3& offset)
+{
+	return CollisionCapsule(capsule.a + offset, capsule.b + offset, capsule.radius);
+}
+
+inline float MaxScale(const mat4& transform)
+{
+	vec3 scale = transform.extractScale();
+	return Math::maxValue(scale.x, Math::maxValue(scale.y, scale.z));
+}
+
+//keeps deepest contacts when buffer is full
+inline int AddContact(const CollisionContact& contact, CollisionContact * contacts, int contactsNum, int maxContacts)
+{
+	if(contactsNum < maxContacts)
+	{
+		contacts[contactsNum] = contact;
+		return contactsNum + 1;
+	}
+
+	int shallowest = 0;
+	for(int i = 1; i < contactsNum; ++i)
+	{
+		if(contacts[i].depth < contacts[shallowest].depth)
+			shallowest = i;
+	}
+
+	if(contacts[shallowest].depth < contact.depth)
+		contacts[shallowest] = contact;
+
+	return contactsNum;
+}
+
+inline int DeepestContact(const CollisionContact * contacts, int contactsNum)
+{
+	int deepest = 0;
+	for(int i = 1; i < contactsNum; ++i)
+	{
+		if(contacts[i].depth > contacts[deepest].depth)
+			deepest = i;
+	}
+	return deepest;
+}
+
+inline int EntryIndex(void * userData)
+{
+	return (int)(intptr_t)userData;
+}
+
+}//namespace {
+
+CollisionWorld * CollisionWorld::sActive = NULL;
+
+CollisionWorld::CollisionWorld():
+	mFreeEntry(-1), mTerrain(NULL)
+{
+}
+
+CollisionWorld::~CollisionWorld()
+{
+	if(sActive == this)
+		sActive = NULL;
+
+	for(size_t i = 0; i < mEntries.size(); ++i)
+	{
+		SceneObject * object = mEntries[i].object;
+		if(object != NULL)
+		{
+			object->mCollisionWorld = NULL;
+			object->mCollisionProxy = -1;
+		}
+	}
+}
+
+CollisionWorld * CollisionWorld::Active()
+{
+	return sActive;
+}
+
+void CollisionWorld::SetActive(CollisionWorld * world)
+{
+	sActive = world;
+}
+
+void CollisionWorld::addObject(SceneObject * object, COLLIDER_PTR collider)
+{
+	if(object->mCollisionWorld != NULL)
+	{
+		object->mCollisionWorld->removeObject(object);
+	}
+
+	int index = mFreeEntry;
+	if(index >= 0)
+	{
+		mFreeEntry = mEntries[index].nextFree;
+	}
+	else
+	{
+		index = (int)mEntries.size();
+		mEntries.push_back(Entry());
+	}
+
+	Entry& entry = mEntries[index];
+	entry.object	= object;
+	entry.collider	= collider;
+	entry.nextFree	= -1;
+	entry.box		= calcEntryBounds(entry);
+	entry.proxy		= mTree.createProxy(entry.box, (void *)(intptr_t)index);
+
+	mMoved.push_back(index);
+
+	object->mCollisionWorld = this;
+	object->mCollisionProxy = index;
+}
+
+void CollisionWorld::removeObject(SceneObject * object)
+{
+	int index = object->mCollisionProxy;
+	if(object->mCollisionWorld != this || index < 0)
+		return;
+
+	Entry& entry = mEntries[index];
+
+	mTree.destroyProxy(entry.proxy);
+
+	//pairs and moved list are cleaned lazily on update
+	entry.object	= NULL;
+	entry.proxy		= AABBTree::INVALID_PROXY;
+	entry.collider.reset();
+	entry.nextFree	= mFreeEntry;
+	mFreeEntry		= index;
+
+	object->mCollisionWorld = NULL;
+	object->mCollisionProxy = -1;
+
+	//drop contacts referencing removed object
+	CONTACTS_LIST::iterator itEnd = mContacts.begin();
+	for(CONTACTS_LIST::iterator it = mContacts.begin(); it != mContacts.end(); ++it)
+	{
+		if(it->objectA != object && it->objectB != object)
+			*itEnd++ = *it;
+	}
+	mContacts.erase(itEnd, mContacts.end());
+}
+
+Collider * CollisionWorld::getCollider(SceneObject * object) const
+{
+	if(object->mCollisionWorld != this || object->mCollisionProxy < 0)
+		return NULL;
+	return mEntries[object->mCollisionProxy].collider.get();
+}
+
+AABB CollisionWorld::calcEntryBounds(const Entry& entry) const
+{
+	if(entry.collider.get() == NULL)
+		return entry.object->getAABB();
+
+	AABB box = entry.collider->getLocalBounds();
+	box.transform(entry.object->getTransform());
+	return box;
+}
+
+void CollisionWorld::update()
+{
+	mStats.reset();
+	mContacts.clear();
+
+	//sync proxies, most of them stay inside their fat boxes
+
+	for(size_t i = 0; i < mEntries.size(); ++i)
+	{
+		Entry& entry = mEntries[i];
+		if(entry.object == NULL)
+			continue;
+
+		AABB box = calcEntryBounds(entry);
+		vec3 displacement = box.getCenter() - entry.box.getCenter();
+		entry.box = box;
+
+		//no prediction for teleports (and objects added before their transforms were updated),
+		//their fat boxes would stay stretched over whole jump
+		vec3 size = box.getSize();
+		if(displacement.lenSquared() > size * size)
+			displacement = vec3(0, 0, 0);
+
+		if(mTree.moveProxy(entry.proxy, box, displacement))
+		{
+			mMoved.push_back((int)i);
+		}
+	}
+
+	mStats.mProxiesNum = mTree.getProxiesNum();
+	mStats.mMovedProxiesNum = (int)mMoved.size();
+
+	updatePairs();
+
+	mStats.mBroadphasePairsNum = (int)mPairs.size();
+
+	for(size_t i = 0; i < mPairs.size(); ++i)
+	{
+		collidePair(mEntries[ mPairs[i].a ], mEntries[ mPairs[i].b ]);
+	}
+
+	//primitives against terrain
+
+	if(mTerrain != NULL)
+	{
+		CollisionContact contacts[MAX_CONTACTS_PER_PAIR];
+
+		for(size_t i = 0; i < mEntries.size(); ++i)
+		{
+			const Entry& entry = mEntries[i];
+			if(entry.object == NULL || entry.collider.get() == NULL || !entry.collider->isPrimitive())
+				continue;
+
+			CollisionCapsule capsule = entry.collider->getCapsule(entry.object->getTransform());
+
+			int contactsNum = collideWithTerrain(capsule, contacts, MAX_CONTACTS_PER_PAIR);
+			for(int j = 0; j < contactsNum; ++j)
+			{
+				ContactPair pair = { entry.object, NULL, contacts[j] };
+				mContacts.push_back(pair);
+			}
+		}
+	}
+
+	mStats.mContactsNum = (int)mContacts.size();
+}
+
+void CollisionWorld::updatePairs()
+{
+	//keep pairs which fat boxes still overlap
+
+	std::vector<Pair>::iterator itEnd = mPairs.begin();
+	for(std::vector<Pair>::iterator it = mPairs.begin(); it != mPairs.end(); ++it)
+	{
+		const Entry& entryA = mEntries[it->a];
+		const Entry& entryB = mEntries[it->b];
+
+		if(entryA.object == NULL || entryB.object == NULL)
+			continue;
+
+		if(mTree.getFatAABB(entryA.proxy).intersects(mTree.getFatAABB(entryB.proxy)))
+			*itEnd++ = *it;
+	}
+	mPairs.erase(itEnd, mPairs.end());
+
+	//find new pairs of moved proxies
+
+	for(size_t i = 0; i < mMoved.size(); ++i)
+	{
+		int index = mMoved[i];
+		const Entry& entry = mEntries[index];
+
+		if(entry.object == NULL)
+			continue;
+
+		mProxiesBuffer.clear();
+		mTree.query(mTree.getFatAABB(entry.proxy), mProxiesBuffer);
+
+		for(size_t j = 0; j < mProxiesBuffer.size(); ++j)
+		{
+			int other = EntryIndex(mTree.getUserData(mProxiesBuffer[j]));
+			if(other == index)
+				continue;
+
+			Pair pair = { Math::minValue(index, other), Math::maxValue(index, other) };
+			mPairs.push_back(pair);
+		}
+	}
+
+	mMoved.clear();
+
+	std::sort(mPairs.begin(), mPairs.end());
+	mPairs.erase(std::unique(mPairs.begin(), mPairs.end()), mPairs.end());
+}
+
+void CollisionWorld::collidePair(const Entry& entryA, const Entry& entryB)
+{
+	Collider * colliderA = entryA.collider.get();
+	Collider * colliderB = entryB.collider.get();
+
+	if(colliderA == NULL || colliderB == NULL)
+		return;
+
+	//at least one primitive is needed, it becomes first object of contact
+
+	const Entry * primitive = &entryA;
+	const Entry * other = &entryB;
+
+	if(!colliderA->isPrimitive())
+	{
+		if(!colliderB->isPrimitive())
+			return;
+
+		primitive = &entryB;
+		other = &entryA;
+	}
+
+	++mStats.mNarrowphaseTestsNum;
+
+	CollisionCapsule capsule = primitive->collider->getCapsule(primitive->object->getTransform());
+
+	CollisionContact contacts[MAX_CONTACTS_PER_PAIR];
+	int contactsNum = collideWithEntry(capsule, *other, contacts, MAX_CONTACTS_PER_PAIR);
+
+	for(int i = 0; i < contactsNum; ++i)
+	{
+		ContactPair pair = { primitive->object, other->object, contacts[i] };
+		mContacts.push_back(pair);
+	}
+}
+
+int CollisionWorld::collideWithEntry(const CollisionCapsule& capsule, const Entry& entry, CollisionContact * outContacts, int maxContacts)
+{
+	const Collider * collider = entry.collider.get();
+	const mat4& transform = entry.object->getTransform();
+
+	if(collider->isPrimitive())
+	{
+		return Collider::CapsuleVsCapsule(capsule, collider->getCapsule(transform), outContacts[0]) ? 1 : 0;
+	}
+
+	//triangles are tested in collider space
+
+	mat4 inverse = transform.inverse();
+	float scale = MaxScale(transform);
+
+	CollisionCapsule localCapsule(inverse * capsule.a, inverse * capsule.b, capsule.radius / scale);
+
+	mTrianglesBuffer.clear();
+	collider->collectTriangles(localCapsule.getBounds(), mTrianglesBuffer);
+
+	int contactsNum = collideWithTriangles(localCapsule, outContacts, maxContacts);
+
+	mat3 rotation = transform.getMat3();
+
+	for(int i = 0; i < contactsNum; ++i)
+	{
+		CollisionContact& contact = outContacts[i];
+		contact.point	= transform * contact.point;
+		contact.normal	= (rotation * contact.normal).normalized();
+		contact.depth	*= scale;
+	}
+
+	return contactsNum;
+}
+
+int CollisionWorld::collideWithTriangles(const CollisionCapsule& capsule, CollisionContact * outContacts, int maxContacts)
+{
+	int contactsNum = 0;
+
+	CollisionContact contact;
+
+	for(size_t i = 0; i < mTrianglesBuffer.size(); ++i)
+	{
+		if(Collider::CapsuleVsTriangle(capsule, mTrianglesBuffer[i], contact))
+		{
+			contactsNum = AddContact(contact, outContacts, contactsNum, maxContacts);
+		}
+	}
+
+	mStats.mTrianglesTestedNum += (int)mTrianglesBuffer.size();
+
+	return contactsNum;
+}
+
+int CollisionWorld::collideWithTerrain(const CollisionCapsule& capsule, CollisionContact * outContacts, int maxContacts)
+{
+	if(mTerrain == NULL || mTerrain->getNodesNum() <= 0)
+		return 0;
+
+	AABB box = capsule.getBounds();
+
+	float nodeSize = mTerrain->getNodeSize();
+	int nodesNum = mTerrain->getNodesNum();
+	vec3 gridOrigin = mTerrain->getGridOrigin();
+
+	int i0 = Math::maxValue((int)floorf((box.min.x - gridOrigin.x) / nodeSize), 0);
+	int j0 = Math::maxValue((int)floorf((box.min.z - gridOrigin.z) / nodeSize), 0);
+	int i1 = Math::minValue((int)floorf((box.max.x - gridOrigin.x) / nodeSize), nodesNum - 1);
+	int j1 = Math::minValue((int)floorf((box.max.z - gridOrigin.z) / nodeSize), nodesNum - 1);
+
+	mTrianglesBuffer.clear();
+
+	for(int i = i0; i <= i1; ++i)
+	{
+		for(int j = j0; j <= j1; ++j)
+		{
+			TerrainNode * node = mTerrain->getNode(i, j);
+			if(node == NULL)
+				continue;
+
+			HeightFieldCollider heightField(node->getHeightMap(), node->getOffset(), node->getScale());
+			heightField.collectTriangles(box, mTrianglesBuffer);
+		}
+	}
+
+	return collideWithTriangles(capsule, outContacts, maxContacts);
+}
+
+void CollisionWorld::queryAABB(const AABB& box, std::vector<SceneObject *>& outObjects) const
+{
+	AABBTree::PROXIES_LIST proxies;
+	mTree.query(box, proxies);
+
+	for(size_t i = 0; i < proxies.size(); ++i)
+	{
+		const Entry& entry = mEntries[ EntryIndex(mTree.getUserData(proxies[i])) ];
+		if(entry.box.intersects(box))
+			outObjects.push_back(entry.object);
+	}
+}
+
+bool CollisionWorld::raycast(const vec3& from, const vec3& to, Hit& outHit, SceneObject * ignore)
+{
+	++mStats.mQueriesNum;
+
+	float bestFraction = 1.0f;
+	bool found = false;
+
+	mProxiesBuffer.clear();
+	mTree.querySegment(from, to, mProxiesBuffer);
+
+	for(size_t i = 0; i < mProxiesBuffer.size(); ++i)
+	{
+		const Entry& entry = mEntries[ EntryIndex(mTree.getUserData(mProxiesBuffer[i])) ];
+
+		const Collider * collider = entry.collider.get();
+		if(collider == NULL || entry.object == ignore)
+			continue;
+
+		const mat4& transform = entry.object->getTransform();
+
+		float fraction;
+		vec3 normal;
+		bool hit = false;
+
+		if(collider->isPrimitive())
+		{
+			hit = Collider::RaycastCapsule(collider->getCapsule(transform), from, to, fraction, normal);
+		}
+		else
+		{
+			//fraction is preserved by affine transform
+			mat4 inverse = transform.inverse();
+			hit = collider->raycast(inverse * from, inverse * to, fraction, normal);
+			if(hit)
+				normal = (transform.getMat3() * normal).normalized();
+		}
+
+		if(hit && fraction <= bestFraction)
+		{
+			bestFraction	= fraction;
+			outHit.object	= entry.object;
+			outHit.normal	= normal;
+			found = true;
+		}
+	}
+
+	if(mTerrain != NULL)
+	{
+		TerrainHit terrainHit;
+		float length = (to - from).len();
+
+		if(mTerrain->getQuery()->segmentCast(from, to, terrainHit) && terrainHit.distance <= bestFraction * length)
+		{
+			bestFraction	= length > 0.0f ? terrainHit.distance / length : 0.0f;
+			outHit.object	= NULL;
+			outHit.normal	= terrainHit.normal;
+			found = true;
+		}
+	}
+
+	if(found)
+	{
+		outHit.fraction = bestFraction;
+		outHit.position = from + (to - from) * bestFraction;
+	}
+
+	return found;
+}
+
+int CollisionWorld::collideCapsule(const CollisionCapsule& capsule, CollisionContact * outContacts, int maxContacts, SceneObject * ignore, SceneObject ** outObjects)
+{
+	++mStats.mQueriesNum;
+
+	int contactsNum = 0;
+
+	mProxiesBuffer.clear();
+	mTree.query(capsule.getBounds(), mProxiesBuffer);
+
+	for(size_t i = 0; i < mProxiesBuffer.size() && contactsNum < maxContacts; ++i)
+	{
+		const Entry& entry = mEntries[ EntryIndex(mTree.getUserData(mProxiesBuffer[i])) ];
+
+		if(entry.collider.get() == NULL || entry.object == ignore)
+			continue;
+
+		int entryContactsNum = collideWithEntry(capsule, entry, outContacts + contactsNum, maxContacts - contactsNum);
+
+		if(outObjects != NULL)
+		{
+			for(int j = 0; j < entryContactsNum; ++j)
+				outObjects[contactsNum + j] = entry.object;
+		}
+
+		contactsNum += entryContactsNum;
+	}
+
+	if(contactsNum < maxContacts)
+	{
+		int terrainContactsNum = collideWithTerrain(capsule, outContacts + contactsNum, maxContacts - contactsNum);
+
+		if(outObjects != NULL)
+		{
+			for(int j = 0; j < terrainContactsNum; ++j)
+				outObjects[contactsNum + j] = NULL;
+		}
+
+		contactsNum += terrainContactsNum;
+	}
+
+	return contactsNum;
+}
+
+bool CollisionWorld::sweepCapsule(const CollisionCapsule& capsule, const vec3& displacement, Hit& outHit, SceneObject * ignore)
+{
+	CollisionContact contacts[MAX_QUERY_CONTACTS];
+	SceneObject * objects[MAX_QUERY_CONTACTS];
+
+	float length = displacement.len();
+	float step = Math::maxValue(capsule.radius * 0.5f, EPSILON);
+	int stepsNum = Math::clamp((int)ceilf(length / step), 1, MAX_SWEEP_STEPS);
+
+	float lo = 0.0f, hi = -1.0f;
+
+	//march with steps smaller than capsule radius so thin obstacles are not skipped
+
+	for(int i = 0; i <= stepsNum; ++i)
+	{
+		float t = (float)i / stepsNum;
+
+		if(collideCapsule(Translated(capsule, displacement * t), contacts, MAX_QUERY_CONTACTS, ignore) > 0)
+		{
+			hi = t;
+			break;
+		}
+
+		lo = t;
+	}
+
+	if(hi < 0.0f)
+		return false;
+
+	//refine time of impact
+
+	if(hi > 0.0f)
+	{
+		for(int i = 0; i < SWEEP_REFINE_STEPS; ++i)
+		{
+			float mid = (lo + hi) * 0.5f;
+			if(collideCapsule(Translated(capsule, displacement * mid), contacts, MAX_QUERY_CONTACTS, ignore) > 0)
+				hi = mid;
+			else
+				lo = mid;
+		}
+	}
+
+	int contactsNum = collideCapsule(Translated(capsule, displacement * hi), contacts, MAX_QUERY_CONTACTS, ignore, objects);
+	if(contactsNum == 0)
+		return false;
+
+	int deepest = DeepestContact(contacts, contactsNum);
+
+	outHit.object	= objects[deepest];
+	outHit.normal	= contacts[deepest].normal;
+	outHit.fraction	= hi;
+	outHit.position	= capsule.a + displacement * hi;
+
+	return true;
+}
+
+vec3 CollisionWorld::moveCapsule(CollisionCapsule& capsule, const vec3& displacement, SceneObject * ignore, bool * outGrounded)
+{
+	CollisionContact contacts[MAX_QUERY_CONTACTS];
+
+	bool grounded = false;
+
+	vec3 start = capsule.a;
+
+	float length = displacement.len();
+	float stepLength = Math::maxValue(capsule.radius * 0.5f, EPSILON);
+	int stepsNum = Math::clamp((int)ceilf(length / stepLength), 1, MAX_SWEEP_STEPS);
+
+	vec3 step = displacement / (float)stepsNum;
+
+	for(int i = 0; i < stepsNum; ++i)
+	{
+		capsule = Translated(capsule, step);
+
+		//push out of deepest penetration and slide remaining movement along contact
+
+		for(int j = 0; j < MAX_DEPENETRATION_STEPS; ++j)
+		{
+			int contactsNum = collideCapsule(capsule, contacts, MAX_QUERY_CONTACTS, ignore);
+			if(contactsNum == 0)
+				break;
+
+			const CollisionContact& contact = contacts[ DeepestContact(contacts, contactsNum) ];
+
+			capsule = Translated(capsule, contact.normal * contact.depth);
+
+			float into = step * contact.normal;
+			if(into < 0.0f)
+				step -= contact.normal * into;
+
+			if(contact.normal.y >= GROUND_NORMAL_Y)
+				grounded = true;
+		}
+	}
+
+	if(outGrounded != NULL)
+		*outGrounded = grounded;
+
+	return capsule.a - start;
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "AABBTree.h"
+#include "Collider.h"
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+namespace World {
+
+class SceneObject;
+class Terrain;
+
+//Collision detection for scene objects.
+//Objects bounds are kept in dynamic AABB tree, pairs are found only for proxies which left their fat boxes,
+//narrowphase handles primitives (spheres/capsules) against primitives and triangle providers (meshes/height fields).
+class SQWORLD_API CollisionWorld
+{
+public:
+
+	struct Stats
+	{
+		Stats() { reset(); }
+
+		void reset()
+		{
+			mProxiesNum				= 0;
+			mMovedProxiesNum		= 0;
+			mBroadphasePairsNum		= 0;
+			mNarrowphaseTestsNum	= 0;
+			mTrianglesTestedNum		= 0;
+			mContactsNum			= 0;
+			mQueriesNum				= 0;
+		}
+
+		int mProxiesNum;
+		int mMovedProxiesNum;//proxies reinserted to tree
+		int mBroadphasePairsNum;
+		int mNarrowphaseTestsNum;
+		int mTrianglesTestedNum;
+		int mContactsNum;
+		int mQueriesNum;//raycasts, sweeps and capsule queries
+	};
+
+	struct ContactPair
+	{
+		SceneObject *		objectA;
+		SceneObject *		objectB;//NULL for terrain
+		CollisionContact	contact;//normal points towards objectA
+	};
+
+	typedef std::vector<ContactPair> CONTACTS_LIST;
+
+	struct Hit
+	{
+		SceneObject *	object;//NULL for terrain
+		vec3			normal;
+		vec3			position;//ray hit point or capsule center (first end) at contact
+		float			fraction;
+	};
+
+private:
+
+	struct Entry
+	{
+		SceneObject *		object;
+		COLLIDER_PTR		collider;
+		AABBTree::PROXY		proxy;
+		AABB				box;
+		int					nextFree;
+	};
+
+	struct Pair
+	{
+		int a;
+		int b;
+
+		bool operator<(const Pair& p) const { return a < p.a || (a == p.a && b < p.b); }
+		bool operator==(const Pair& p) const { return a == p.a && b == p.b; }
+	};
+
+public:
+	CollisionWorld();
+	~CollisionWorld();
+
+	//colliders of new scene objects are registered in active world (if any)
+	static CollisionWorld * Active();
+	static void SetActive(CollisionWorld * world);
+
+	void setTerrain(Terrain * terrain) { mTerrain = terrain; }
+	Terrain * getTerrain() const { return mTerrain; }
+
+	//object without collider takes part in broadphase only
+	void addObject(SceneObject * object, COLLIDER_PTR collider = COLLIDER_PTR());
+	void removeObject(SceneObject * object);
+
+	Collider * getCollider(SceneObject * object) const;
+
+	//syncs proxies with objects transforms and finds contacts
+	void update();
+
+	const CONTACTS_LIST& getContacts() const { return mContacts; }
+
+	//queries, ignored object is usually the one doing query
+
+	void	queryAABB(const AABB& box, std::vector<SceneObject *>& outObjects) const;
+	bool	raycast(const vec3& from, const vec3& to, Hit& outHit, SceneObject * ignore = NULL);
+
+	//returns number of contacts written, contact normals point towards capsule,
+	//objects array (if passed) receives contacted object per contact (NULL for terrain)
+	int		collideCapsule(const CollisionCapsule& capsule, CollisionContact * outContacts, int maxContacts, SceneObject * ignore = NULL, SceneObject ** outObjects = NULL);
+
+	//first contact of capsule moving by displacement
+	bool	sweepCapsule(const CollisionCapsule& capsule, const vec3& displacement, Hit& outHit, SceneObject * ignore = NULL);
+
+	//moves capsule sliding along obstacles and resolving penetrations, returns applied movement
+	vec3	moveCapsule(CollisionCapsule& capsule, const vec3& displacement, SceneObject * ignore = NULL, bool * outGrounded = NULL);
+
+	const Stats& getStats() const { return mStats; }
+
+private:
+
+	AABB	calcEntryBounds(const Entry& entry) const;
+
+	void	updatePairs();
+	void	collidePair(const Entry& entryA, const Entry& entryB);
+
+	//primitive vs entry collider, capsule in world space
+	int		collideWithEntry(const CollisionCapsule& capsule, const Entry& entry, CollisionContact * outContacts, int maxContacts);
+	int		collideWithTerrain(const CollisionCapsule& capsule, CollisionContact * outContacts, int maxContacts);
+	int		collideWithTriangles(const CollisionCapsule& capsule, CollisionContact * outContacts, int maxContacts);
+
+private:
+
+	static CollisionWorld *	sActive;
+
+	AABBTree				mTree;
+
+	std::vector<Entry>		mEntries;
+	int						mFreeEntry;
+
+	std::vector<int>		mMoved;
+	std::vector<Pair>		mPairs;
+
+	CONTACTS_LIST			mContacts;
+
+	Terrain *				mTerrain;
+
+	Stats					mStats;
+
+	//scratch buffers
+	AABBTree::PROXIES_LIST		mProxiesBuffer;
+	COLLISION_TRIANGLES_LIST	mTrianglesBuffer;
+};
+
+}//namespace World {
+}//namespace Squirrel {
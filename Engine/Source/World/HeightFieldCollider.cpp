@@ -0,0 +1,206 @@
+#include "HeightFieldCollider.h"
+#include <Math/GeometryTools.h>
+#include <float.h>
+#include <math.h>
+
+namespace Squirrel {
+namespace World {
+
+HeightFieldCollider::HeightFieldCollider(const HeightMap * heightMap, vec3 offset, vec3 scale):
+	Collider(ctHeightField), mHeightMap(heightMap), mOffset(offset), mScale(scale)
+{
+}
+
+HeightFieldCollider::~HeightFieldCollider()
+{
+}
+
+AABB HeightFieldCollider::getLocalBounds() const
+{
+	const HeightMapPyramid * pyramid = mHeightMap->getPyramid();
+	tuple2i res = mHeightMap->getResolution();
+
+	AABB box;
+	if(pyramid->isEmpty())
+		return box;
+
+	box.min = vec3(mOffset.x, mOffset.y + pyramid->getMin() * mScale.y, mOffset.z);
+	box.max = vec3(mOffset.x + (res.x - 1) * mScale.x, mOffset.y + pyramid->getMax() * mScale.y, mOffset.z + (res.y - 1) * mScale.z);
+	return box;
+}
+
+void HeightFieldCollider::getCellTriangles(int i, int j, CollisionTriangle& triangle1, CollisionTriangle& triangle2) const
+{
+	vec3 v00 = vertex(i, j);
+	vec3 v10 = vertex(i + 1, j);
+	vec3 v01 = vertex(i, j + 1);
+	vec3 v11 = vertex(i + 1, j + 1);
+
+	//counter clockwise when looking from above
+	triangle1.v[0] = v00; triangle1.v[1] = v01; triangle1.v[2] = v10;
+	triangle2.v[0] = v10; triangle2.v[1] = v01; triangle2.v[2] = v11;
+}
+
+void HeightFieldCollider::collectTriangles(const AABB& localBox, COLLISION_TRIANGLES_LIST& outTriangles) const
+{
+	const HeightMapPyramid * pyramid = mHeightMap->getPyramid();
+	if(pyramid->isEmpty())
+		return;
+
+	int x0 = (int)floorf((localBox.min.x - mOffset.x) / mScale.x);
+	int z0 = (int)floorf((localBox.min.z - mOffset.z) / mScale.z);
+	int x1 = (int)floorf((localBox.max.x - mOffset.x) / mScale.x);
+	int z1 = (int)floorf((localBox.max.z - mOffset.z) / mScale.z);
+
+	float minHeight, maxHeight;
+	if(!pyramid->getRange(x0, z0, x1, z1, minHeight, maxHeight))
+		return;
+
+	if(mOffset.y + minHeight * mScale.y > localBox.max.y || mOffset.y + maxHeight * mScale.y < localBox.min.y)
+		return;
+
+	tuple2i cells = pyramid->getLevelSize(0);
+
+	x0 = Math::maxValue(x0, 0);
+	z0 = Math::maxValue(z0, 0);
+	x1 = Math::minValue(x1, cells.x - 1);
+	z1 = Math::minValue(z1, cells.y - 1);
+
+	CollisionTriangle triangle1, triangle2;
+
+	for(int j = z0; j <= z1; ++j)
+	{
+		for(int i = x0; i <= x1; ++i)
+		{
+			float cellMin = mOffset.y + pyramid->getMin(0, i, j) * mScale.y;
+			float cellMax = mOffset.y + pyramid->getMax(0, i, j) * mScale.y;
+
+			if(cellMin > localBox.max.y || cellMax < localBox.min.y)
+				continue;
+
+			getCellTriangles(i, j, triangle1, triangle2);
+			outTriangles.push_back(triangle1);
+			outTriangles.push_back(triangle2);
+		}
+	}
+}
+
+bool HeightFieldCollider::raycast(const vec3& from, const vec3& to, float& outFraction, vec3& outNormal) const
+{
+	const HeightMapPyramid * pyramid = mHeightMap->getPyramid();
+	if(pyramid->isEmpty())
+		return false;
+
+	tuple2i cells = pyramid->getLevelSize(0);
+
+	//cells space segment
+
+	float u0 = (from.x - mOffset.x) / mScale.x;
+	float v0 = (from.z - mOffset.z) / mScale.z;
+	float du = (to.x - from.x) / mScale.x;
+	float dv = (to.z - from.z) / mScale.z;
+
+	//clip by field rect
+
+	float tMin = 0.0f, tMax = 1.0f;
+
+	float bounds[2][2] = { { 0.0f, (float)cells.x }, { 0.0f, (float)cells.y } };
+	float origins[2] = { u0, v0 };
+	float dirs[2] = { du, dv };
+
+	for(int axis = 0; axis < 2; ++axis)
+	{
+		if(Math::absValue(dirs[axis]) < EPSILON)
+		{
+			if(origins[axis] < bounds[axis][0] || origins[axis] > bounds[axis][1])
+				return false;
+			continue;
+		}
+
+		float t0 = (bounds[axis][0] - origins[axis]) / dirs[axis];
+		float t1 = (bounds[axis][1] - origins[axis]) / dirs[axis];
+		if(t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+
+		tMin = Math::maxValue(tMin, t0);
+		tMax = Math::minValue(tMax, t1);
+	}
+
+	if(tMin > tMax)
+		return false;
+
+	//walk cells along segment
+
+	int i = Math::clamp((int)floorf(u0 + du * tMin), 0, cells.x - 1);
+	int j = Math::clamp((int)floorf(v0 + dv * tMin), 0, cells.y - 1);
+
+	int stepI = du > EPSILON ? 1 : (du < -EPSILON ? -1 : 0);
+	int stepJ = dv > EPSILON ? 1 : (dv < -EPSILON ? -1 : 0);
+
+	float tNextI = stepI != 0 ? ((i + (stepI > 0 ? 1 : 0)) - u0) / du : FLT_MAX;
+	float tNextJ = stepJ != 0 ? ((j + (stepJ > 0 ? 1 : 0)) - v0) / dv : FLT_MAX;
+	float tDeltaI = stepI != 0 ? 1.0f / Math::absValue(du) : FLT_MAX;
+	float tDeltaJ = stepJ != 0 ? 1.0f / Math::absValue(dv) : FLT_MAX;
+
+	vec3 dir = to - from;
+
+	float tEnter = tMin;
+
+	CollisionTriangle triangles[2];
+
+	while(i >= 0 && j >= 0 && i < cells.x && j < cells.y)
+	{
+		float tExit = Math::minValue(Math::minValue(tNextI, tNextJ), tMax);
+
+		float y0 = from.y + dir.y * tEnter;
+		float y1 = from.y + dir.y * tExit;
+
+		float cellMin = mOffset.y + pyramid->getMin(0, i, j) * mScale.y;
+		float cellMax = mOffset.y + pyramid->getMax(0, i, j) * mScale.y;
+
+		if(Math::minValue(y0, y1) <= cellMax && Math::maxValue(y0, y1) >= cellMin)
+		{
+			getCellTriangles(i, j, triangles[0], triangles[1]);
+
+			float bestFraction = FLT_MAX;
+
+			for(int k = 0; k < 2; ++k)
+			{
+				const CollisionTriangle& triangle = triangles[k];
+
+				float fraction = rayTriangleIntersection(from, dir, triangle.v[0], triangle.v[1], triangle.v[2]);
+				if(fraction >= 0.0f && fraction < bestFraction)
+				{
+					bestFraction = fraction;
+					outNormal = getNormalToTriangle(triangle.v[0], triangle.v[1], triangle.v[2]);
+				}
+			}
+
+			if(bestFraction <= 1.0f)
+			{
+				outFraction = bestFraction;
+				return true;
+			}
+		}
+
+		if(tExit >= tMax)
+			break;
+
+		if(tNextI < tNextJ)
+		{
+			i += stepI;
+			tNextI += tDeltaI;
+		}
+		else
+		{
+			j += stepJ;
+			tNextJ += tDeltaJ;
+		}
+
+		tEnter = tExit;
+	}
+
+	return false;
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Collider.h"
+#include "HeightMap.h"
+
+namespace Squirrel {
+namespace World {
+
+//Height map collider, texel (i, j) is placed at offset + (i, height, j) * scale.
+//Every cell is split into two triangles, min/max pyramid of height map rejects cells quickly.
+class SQWORLD_API HeightFieldCollider:
+	public Collider
+{
+public:
+	HeightFieldCollider(const HeightMap * heightMap, vec3 offset = vec3(0, 0, 0), vec3 scale = vec3(1, 1, 1));
+	virtual ~HeightFieldCollider();
+
+	virtual AABB getLocalBounds() const;
+	virtual void collectTriangles(const AABB& localBox, COLLISION_TRIANGLES_LIST& outTriangles) const;
+	virtual bool raycast(const vec3& from, const vec3& to, float& outFraction, vec3& outNormal) const;
+
+	const HeightMap * getHeightMap() const { return mHeightMap; }
+
+private:
+
+	inline vec3 vertex(int i, int j) const
+	{
+		return vec3(mOffset.x + i * mScale.x, mOffset.y + mHeightMap->height(i, j) * mScale.y, mOffset.z + j * mScale.z);
+	}
+
+	void getCellTriangles(int i, int j, CollisionTriangle& triangle1, CollisionTriangle& triangle2) const;
+
+private:
+	const HeightMap * mHeightMap;
+	vec3 mOffset;
+	vec3 mScale;
+};
+
+}//namespace World {
+}//namespace Squirrel {
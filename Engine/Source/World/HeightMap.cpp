@@ -12,7 +12,7 @@ namespace World {
 //////////////////////////////////////////////////////////////////////
 
 HeightMap::HeightMap(int xSize, int zSize, int dataBlockSize):
-	mDataToDestroy(NULL)
+	mDataToDestroy(NULL), mRevision(0)
 {
 	size_t memBlockSize = GetBlockSize(xSize, zSize, dataBlockSize);
 	
@@ -30,7 +30,7 @@ HeightMap::HeightMap(int xSize, int zSize, int dataBlockSize):
 }
 	
 HeightMap::HeightMap(HeightMapHeader * header, char * memBlock):
-	mHeader(header), mMemBlock(memBlock), mMemOwner(false), mDataToDestroy(NULL)
+	mHeader(header), mMemBlock(memBlock), mMemOwner(false), mDataToDestroy(NULL), mRevision(0)
 {
 	setupMemory();
 }
@@ -137,6 +137,8 @@ size_t HeightMap::save(Data * data)
 	
 void HeightMap::clear()
 {
+	invalidatePyramid();
+
 	size_t elementsNum = mHeader->resolution.x * mHeader->resolution.y;
 	for(int i = 0; i < elementsNum; ++i)
 	{
@@ -192,19 +194,61 @@ vec3 HeightMap::normalFetch(float x, float z) const
 	return Math::lerp(lerp1, lerp2, zFrac);
 }
 	
+const HeightMapPyramid * HeightMap::getPyramid() const
+{
+	if(mPyramid.get() == NULL)
+	{
+		mPyramid.reset(new HeightMapPyramid());
+		mPyramid->build(this);
+	}
+	return mPyramid.get();
+}
+
 void HeightMap::updateNormals()
 {
-	for(int i = 0; i < getResolution().x; ++i)
+	invalidatePyramid();
+
+	tuple2i res = getResolution();
+
+	//inner texels: sum of 4 cross products of updateNormal reduces to (hLeft - hRight, 2, hUp - hDown)
+	for(int j = 1; j < res.y - 1; ++j)
 	{
-		for(int j = 0; j < getResolution().y; ++j)
+		const float * row		= mHeights + j * res.x;
+		const float * prevRow	= row - res.x;
+		const float * nextRow	= row + res.x;
+
+		tuple4b * normals = mNormals + j * res.x;
+
+		for(int i = 1; i < res.x - 1; ++i)
 		{
-			updateNormal(i, j);
+			Math::vec3 n(row[i - 1] - row[i + 1], 2.0f, prevRow[i] - nextRow[i]);
+			n.normalize();
+
+			tuple4b packedNormal(0,0,0,0);
+			packedNormal.setNormalized(n.x, 0);
+			packedNormal.setNormalized(n.y, 1);
+			packedNormal.setNormalized(n.z, 2);
+			normals[i] = packedNormal;
 		}
 	}
+
+	//border texels
+	for(int i = 0; i < res.x; ++i)
+	{
+		updateNormal(i, 0);
+		updateNormal(i, res.y - 1);
+	}
+	for(int j = 1; j < res.y - 1; ++j)
+	{
+		updateNormal(0, j);
+		updateNormal(res.x - 1, j);
+	}
 }
 	
 void HeightMap::updateNormal(int i, int j)
 {
+	invalidatePyramid();
+
 	float h = height(i, j);
 
 	Math::vec3 n(0,0,0);
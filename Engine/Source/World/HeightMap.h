@@ -3,7 +3,9 @@
 #include <common/common.h>
 #include <Resource/Mesh.h>
 #include <Render/IRender.h>
+#include "HeightMapPyramid.h"
 #include "macros.h"
+#include <memory>
 
 namespace Squirrel {
 namespace World { 
@@ -54,12 +56,21 @@ public://methods
 
 	inline tuple2i	getResolution()	const	{ return mHeader->resolution; }
 
+	inline uint32	getRevision()	const	{ return mRevision; }
+
 	//generating/editing/loading stuff
 	void updateNormal(int i, int j);
 	void updateNormals();
 
 	inline float *		getHeights()	const	{ return mHeights; }
 	inline tuple4b *	getNormals()	const	{ return mNormals; }
+
+	//min/max heights hierarchy, built on demand
+	const HeightMapPyramid * getPyramid() const;
+	//heights are edited before pyramid is invalidated, so it counts edits too
+	inline void invalidatePyramid() { mPyramid.reset(); ++mRevision; }
+	//takes ownership of pyramid built elsewhere (e.g. loaded with compressed map)
+	inline void setPyramid(HeightMapPyramid * pyramid) { mPyramid.reset(pyramid); }
 	
 	static HeightMap * Load(Data * data);
 	static HeightMap * LoadMapped(Data * data, bool takeCareOfData = false);
@@ -88,6 +99,10 @@ private:
 	bool		mMemOwner;
 	
 	Data	*	mDataToDestroy;
+
+	mutable std::auto_ptr<HeightMapPyramid> mPyramid;
+
+	uint32		mRevision;
 };
 
 }//namespace World { 
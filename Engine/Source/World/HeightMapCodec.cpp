@@ -0,0 +1,516 @@
+#include "HeightMapCodec.h"
+#include <vector>
+#include <math.h>
+#include <string.h>
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+namespace Squirrel {
+namespace World {
+
+namespace {
+
+const int		BLOCK_SIZE			= 64;//residuals sharing one Rice parameter
+const int		RICE_PARAM_BITS		= 5;
+const uint32	MAX_RICE_PARAM		= 17;
+const uint32	ESCAPE_LENGTH		= 20;//longer unary prefixes are replaced by raw value
+const int		RAW_VALUE_BITS		= 17;//enough for zigzagged difference of two uint16
+
+typedef std::vector<uint16> QUANTIZED_ARRAY;
+
+//value must not be zero
+inline uint32 CountTrailingZeros(uint64 value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (uint32)index;
+#else
+	return (uint32)__builtin_ctzll(value);
+#endif
+}
+
+class BitWriter
+{
+public:
+	BitWriter(std::vector<byte>& out): mOut(out), mAcc(0), mBitsNum(0) {}
+
+	inline void put(uint32 value, int bitsNum)
+	{
+		mAcc |= (uint64)value << mBitsNum;
+		mBitsNum += bitsNum;
+		while(mBitsNum >= 8)
+		{
+			mOut.push_back((byte)mAcc);
+			mAcc >>= 8;
+			mBitsNum -= 8;
+		}
+	}
+
+	inline void putOnes(uint32 num)
+	{
+		while(num > 0)
+		{
+			uint32 chunk = num < 24 ? num : 24;
+			put((1 << chunk) - 1, chunk);
+			num -= chunk;
+		}
+	}
+
+	void flush()
+	{
+		if(mBitsNum > 0)
+			mOut.push_back((byte)mAcc);
+		mAcc = 0;
+		mBitsNum = 0;
+	}
+
+private:
+	std::vector<byte>& mOut;
+	uint64	mAcc;
+	int		mBitsNum;
+};
+
+class BitReader
+{
+public:
+	BitReader(const byte * data, size_t size): mPtr(data), mEnd(data + size), mAcc(0), mBitsNum(0), mPaddingBitsNum(0) {}
+
+	//makes more than 56 bits available, enough for any single code (at most 38 bits)
+	inline void refill()
+	{
+		if(mBitsNum > 56)
+			return;
+
+		if(mPtr + sizeof(uint64) <= mEnd)
+		{
+			//whole bytes which fit are taken from little endian word,
+			//partially taken byte is read again by next refill
+			uint64 word;
+			memcpy(&word, mPtr, sizeof(word));
+			mAcc |= word << mBitsNum;
+			int bytesNum = (63 - mBitsNum) >> 3;
+			mPtr += bytesNum;
+			mBitsNum += bytesNum << 3;
+			return;
+		}
+
+		while(mBitsNum <= 56)
+		{
+			//zeros are read past the end
+			if(mPtr < mEnd)
+				mAcc |= (uint64)(*mPtr++) << mBitsNum;
+			else
+				mPaddingBitsNum += 8;
+			mBitsNum += 8;
+		}
+	}
+
+	inline uint32 get(int bitsNum)
+	{
+		uint32 value = (uint32)(mAcc & ((1ull << bitsNum) - 1));
+		mAcc >>= bitsNum;
+		mBitsNum -= bitsNum;
+		return value;
+	}
+
+	//counts ones till zero bit (consumed) or till maxNum ones
+	inline uint32 getOnes(uint32 maxNum)
+	{
+		uint32 num = CountTrailingZeros(~mAcc | (1ull << maxNum));
+		uint32 consumed = num < maxNum ? num + 1 : num;
+		mAcc >>= consumed;
+		mBitsNum -= consumed;
+		return num;
+	}
+
+	//true if more bits were read than there were
+	bool isOverrun() const { return mBitsNum < mPaddingBitsNum; }
+
+private:
+	const byte * mPtr;
+	const byte * mEnd;
+	uint64	mAcc;
+	int		mBitsNum;
+	int		mPaddingBitsNum;
+};
+
+//median edge detector of LOCO-I
+inline int Predict(int left, int up, int upLeft)
+{
+	int minValue = left < up ? left : up;
+	int maxValue = left < up ? up : left;
+	if(upLeft >= maxValue)	return minValue;
+	if(upLeft <= minValue)	return maxValue;
+	return left + up - upLeft;
+}
+
+inline int Prediction(const uint16 * row, const uint16 * prevRow, int x)
+{
+	if(prevRow == NULL)
+		return x > 0 ? row[x - 1] : 0;
+	if(x == 0)
+		return prevRow[0];
+	return Predict(row[x - 1], prevRow[x], prevRow[x - 1]);
+}
+
+inline uint32 ZigZag(int value)		{ return value >= 0 ? (uint32)value << 1 : ((uint32)(-value) << 1) - 1; }
+inline int UnZigZag(uint32 value)	{ return (value & 1) ? -(int)((value + 1) >> 1) : (int)(value >> 1); }
+
+void EncodeHeights(const QUANTIZED_ARRAY& quantized, tuple2i res, std::vector<byte>& out)
+{
+	size_t count = quantized.size();
+
+	std::vector<uint32> residuals(count);
+	for(int z = 0; z < res.y; ++z)
+	{
+		const uint16 * row = &quantized[z * res.x];
+		const uint16 * prevRow = z > 0 ? row - res.x : NULL;
+		for(int x = 0; x < res.x; ++x)
+		{
+			residuals[x + z * res.x] = ZigZag((int)row[x] - Prediction(row, prevRow, x));
+		}
+	}
+
+	BitWriter writer(out);
+
+	for(size_t blockStart = 0; blockStart < count; blockStart += BLOCK_SIZE)
+	{
+		size_t blockEnd = blockStart + BLOCK_SIZE < count ? blockStart + BLOCK_SIZE : count;
+
+		uint64 sum = 0;
+		for(size_t i = blockStart; i < blockEnd; ++i)
+			sum += residuals[i];
+
+		//k close to log2 of mean residual
+		uint32 k = 0;
+		uint64 blockLength = blockEnd - blockStart;
+		while(k < MAX_RICE_PARAM && (blockLength << (k + 1)) <= sum)
+			++k;
+
+		writer.put(k, RICE_PARAM_BITS);
+
+		for(size_t i = blockStart; i < blockEnd; ++i)
+		{
+			uint32 value = residuals[i];
+			uint32 prefix = value >> k;
+			if(prefix >= ESCAPE_LENGTH)
+			{
+				writer.putOnes(ESCAPE_LENGTH);
+				writer.put(value, RAW_VALUE_BITS);
+			}
+			else
+			{
+				writer.putOnes(prefix);
+				writer.put(0, 1);
+				writer.put(value & ((1 << k) - 1), k);
+			}
+		}
+	}
+
+	writer.flush();
+}
+
+inline uint32 ReadValue(BitReader& reader, uint32 k)
+{
+	reader.refill();
+
+	uint32 prefix = reader.getOnes(ESCAPE_LENGTH);
+	if(prefix == ESCAPE_LENGTH)
+		return reader.get(RAW_VALUE_BITS);
+
+	return (prefix << k) | reader.get(k);
+}
+
+bool DecodeHeights(const byte * data, size_t size, tuple2i res, QUANTIZED_ARRAY& quantized)
+{
+	quantized.resize((size_t)res.x * res.y);
+
+	BitReader reader(data, size);
+
+	uint32 k = 0;
+	int blockLeft = 0;
+
+	const uint16 * prevRow = NULL;
+
+	for(int z = 0; z < res.y; ++z)
+	{
+		uint16 * row = &quantized[z * res.x];
+
+		for(int x = 0; x < res.x; ++x)
+		{
+			if(blockLeft == 0)
+			{
+				reader.refill();
+				k = reader.get(RICE_PARAM_BITS);
+				if(k > MAX_RICE_PARAM)
+					return false;
+				blockLeft = BLOCK_SIZE;
+			}
+			--blockLeft;
+
+			int residual = UnZigZag(ReadValue(reader, k));
+
+			row[x] = (uint16)(Prediction(row, prevRow, x) + residual);
+		}
+
+		prevRow = row;
+	}
+
+	return !reader.isOverrun();
+}
+
+int GetPyramidLevelsNum(tuple2i res)
+{
+	if(res.x < 2 || res.y < 2)
+		return 0;
+
+	int levelsNum = 1;
+	tuple2i size(res.x - 1, res.y - 1);
+	while(size.x > 1 || size.y > 1)
+	{
+		size = tuple2i((size.x + 1) / 2, (size.y + 1) / 2);
+		++levelsNum;
+	}
+	return levelsNum;
+}
+
+//the same min/max reduction as HeightMapPyramid does, but in quantized heights
+void BuildQuantizedPyramid(const QUANTIZED_ARRAY& quantized, tuple2i res, std::vector<tuple2i>& sizes,
+						   std::vector<QUANTIZED_ARRAY>& mins, std::vector<QUANTIZED_ARRAY>& maxs)
+{
+	int levelsNum = GetPyramidLevelsNum(res);
+	if(levelsNum == 0)
+		return;
+
+	sizes.resize(levelsNum);
+	mins.resize(levelsNum);
+	maxs.resize(levelsNum);
+
+	tuple2i size(res.x - 1, res.y - 1);
+	sizes[0] = size;
+	mins[0].resize(size.x * size.y);
+	maxs[0].resize(size.x * size.y);
+	for(int z = 0; z < size.y; ++z)
+	{
+		const uint16 * row0 = &quantized[z * res.x];
+		const uint16 * row1 = row0 + res.x;
+		for(int x = 0; x < size.x; ++x)
+		{
+			mins[0][x + z * size.x] = Math::minValue(Math::minValue(row0[x], row0[x + 1]), Math::minValue(row1[x], row1[x + 1]));
+			maxs[0][x + z * size.x] = Math::maxValue(Math::maxValue(row0[x], row0[x + 1]), Math::maxValue(row1[x], row1[x + 1]));
+		}
+	}
+
+	for(int level = 1; level < levelsNum; ++level)
+	{
+		tuple2i prevSize = sizes[level - 1];
+		size = tuple2i((prevSize.x + 1) / 2, (prevSize.y + 1) / 2);
+		sizes[level] = size;
+		mins[level].resize(size.x * size.y);
+		maxs[level].resize(size.x * size.y);
+
+		const QUANTIZED_ARRAY& prevMins = mins[level - 1];
+		const QUANTIZED_ARRAY& prevMaxs = maxs[level - 1];
+
+		for(int z = 0; z < size.y; ++z)
+		{
+			int pz0 = z * 2;
+			int pz1 = Math::minValue(pz0 + 1, prevSize.y - 1);
+			for(int x = 0; x < size.x; ++x)
+			{
+				int px0 = x * 2;
+				int px1 = Math::minValue(px0 + 1, prevSize.x - 1);
+
+				int i00 = px0 + pz0 * prevSize.x, i10 = px1 + pz0 * prevSize.x;
+				int i01 = px0 + pz1 * prevSize.x, i11 = px1 + pz1 * prevSize.x;
+
+				mins[level][x + z * size.x] = Math::minValue(Math::minValue(prevMins[i00], prevMins[i10]), Math::minValue(prevMins[i01], prevMins[i11]));
+				maxs[level][x + z * size.x] = Math::maxValue(Math::maxValue(prevMaxs[i00], prevMaxs[i10]), Math::maxValue(prevMaxs[i01], prevMaxs[i11]));
+			}
+		}
+	}
+}
+
+}//namespace {
+
+bool HeightMapCodec::IsCompressed(Data * data)
+{
+	if(data->getLength() - data->getPos() < sizeof(CompressedHeightMapHeader))
+		return false;
+
+	const CompressedHeightMapHeader * header = (const CompressedHeightMapHeader *)data->getPtr();
+	return header->magic == CompressedHeightMapHeader::sMagic;
+}
+
+Data * HeightMapCodec::Save(const HeightMap * hm)
+{
+	Data * data = new Data(NULL, 0);
+	data->setCapacityIncrement(64 * 1024);
+	Save(hm, data);
+	return data;
+}
+
+size_t HeightMapCodec::Save(const HeightMap * hm, Data * data)
+{
+	tuple2i res = hm->getResolution();
+	size_t count = (size_t)res.x * res.y;
+
+	const float * heights = hm->getHeights();
+
+	//quantize
+
+	float minHeight = count > 0 ? heights[0] : 0;
+	float maxHeight = minHeight;
+	for(size_t i = 1; i < count; ++i)
+	{
+		minHeight = Math::minValue(minHeight, heights[i]);
+		maxHeight = Math::maxValue(maxHeight, heights[i]);
+	}
+
+	float step = (maxHeight - minHeight) / 65535.0f;
+	if(step <= 0)
+		step = 1.0f;
+
+	QUANTIZED_ARRAY quantized(count);
+	for(size_t i = 0; i < count; ++i)
+	{
+		float q = floorf((heights[i] - minHeight) / step + 0.5f);
+		quantized[i] = (uint16)Math::clamp(q, 0.0f, 65535.0f);
+	}
+
+	//pyramid
+
+	std::vector<tuple2i> levelSizes;
+	std::vector<QUANTIZED_ARRAY> levelMins, levelMaxs;
+	BuildQuantizedPyramid(quantized, res, levelSizes, levelMins, levelMaxs);
+
+	int storedLevelsNum = Math::maxValue((int)levelSizes.size() - PYRAMID_FIRST_STORED_LEVEL, 0);
+
+	//heights
+
+	std::vector<byte> encoded;
+	encoded.reserve(count);
+	EncodeHeights(quantized, res, encoded);
+
+	CompressedHeightMapHeader header = CompressedHeightMapHeader();
+	header.magic				= CompressedHeightMapHeader::sMagic;
+	header.version				= CompressedHeightMapHeader::sVersion;
+	header.map.resolution		= res;
+	header.map.texScale			= hm->getTexScale();
+	header.heightOffset			= minHeight;
+	header.heightStep			= step;
+	header.pyramidFirstLevel	= PYRAMID_FIRST_STORED_LEVEL;
+	header.pyramidLevelsNum		= storedLevelsNum;
+	header.heightsSize			= (uint32)encoded.size();
+
+	size_t startPos = data->getPos();
+
+	data->putData(&header, sizeof(header));
+
+	for(int i = 0; i < storedLevelsNum; ++i)
+	{
+		const QUANTIZED_ARRAY& mins = levelMins[PYRAMID_FIRST_STORED_LEVEL + i];
+		const QUANTIZED_ARRAY& maxs = levelMaxs[PYRAMID_FIRST_STORED_LEVEL + i];
+		data->putData(&mins[0], mins.size() * sizeof(uint16));
+		data->putData(&maxs[0], maxs.size() * sizeof(uint16));
+	}
+
+	if(!encoded.empty())
+		data->putData(&encoded[0], encoded.size());
+
+	return data->getPos() - startPos;
+}
+
+HeightMap * HeightMapCodec::Load(Data * data)
+{
+	if(!IsCompressed(data))
+		return NULL;
+
+	CompressedHeightMapHeader header;
+	data->readBytes(&header, sizeof(header));
+
+	if(header.version != CompressedHeightMapHeader::sVersion)
+		return NULL;
+
+	tuple2i res = header.map.resolution;
+	if(res.x <= 0 || res.y <= 0)
+		return NULL;
+
+	//stored pyramid levels are located before heights
+
+	int fullLevelsNum = GetPyramidLevelsNum(res);
+	int firstStoredLevel = (int)header.pyramidFirstLevel;
+	if(header.pyramidLevelsNum > 0 && firstStoredLevel + (int)header.pyramidLevelsNum != fullLevelsNum)
+		return NULL;
+
+	std::vector<tuple2i> levelSizes;
+	tuple2i size(res.x - 1, res.y - 1);
+	for(int level = 0; level < fullLevelsNum; ++level)
+	{
+		levelSizes.push_back(size);
+		size = tuple2i((size.x + 1) / 2, (size.y + 1) / 2);
+	}
+
+	const uint16 * storedLevels = (const uint16 *)data->getPtr();
+	size_t storedLevelsSize = 0;
+	for(uint32 i = 0; i < header.pyramidLevelsNum; ++i)
+	{
+		tuple2i levelSize = levelSizes[firstStoredLevel + i];
+		storedLevelsSize += levelSize.x * levelSize.y * 2 * sizeof(uint16);
+	}
+
+	if(data->getLength() - data->getPos() < storedLevelsSize + header.heightsSize)
+		return NULL;
+
+	data->seekCur((int)storedLevelsSize);
+
+	//heights
+
+	QUANTIZED_ARRAY quantized;
+	bool decoded = DecodeHeights((const byte *)data->getPtr(), header.heightsSize, res, quantized);
+	data->seekCur((int)header.heightsSize);
+
+	if(!decoded)
+		return NULL;
+
+	HeightMap * hm = new HeightMap(res.x, res.y);
+	hm->setTexScale(header.map.texScale);
+
+	float * heights = hm->getHeights();
+	size_t count = quantized.size();
+	for(size_t i = 0; i < count; ++i)
+	{
+		heights[i] = header.heightOffset + quantized[i] * header.heightStep;
+	}
+
+	hm->updateNormals();
+
+	//pyramid: finest levels from heights, coarse ones from file
+
+	HeightMapPyramid * pyramid = new HeightMapPyramid();
+	pyramid->build(hm, header.pyramidLevelsNum > 0 ? firstStoredLevel : fullLevelsNum);
+
+	const uint16 * levelData = storedLevels;
+	for(uint32 i = 0; i < header.pyramidLevelsNum; ++i)
+	{
+		tuple2i levelSize = levelSizes[firstStoredLevel + i];
+		int cellsNum = levelSize.x * levelSize.y;
+
+		HeightMapPyramid::Level& level = pyramid->addLevel(levelSize);
+		for(int j = 0; j < cellsNum; ++j)
+		{
+			level.mins[j] = header.heightOffset + levelData[j] * header.heightStep;
+			level.maxs[j] = header.heightOffset + levelData[j + cellsNum] * header.heightStep;
+		}
+		levelData += cellsNum * 2;
+	}
+
+	hm->setPyramid(pyramid);
+
+	return hm;
+}
+
+}//namespace World {
+}//namespace Squirrel {
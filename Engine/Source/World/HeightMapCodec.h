@@ -0,0 +1,49 @@
+#pragma once
+
+#include "HeightMap.h"
+
+namespace Squirrel {
+namespace World {
+
+#pragma pack(push, 1)
+
+struct CompressedHeightMapHeader {
+	static const uint32 sMagic		= 0x5A485153;//"SQHZ"
+	static const uint32 sVersion	= 1;
+
+	uint32			magic;
+	uint32			version;
+	HeightMapHeader	map;
+	float			heightOffset;//height = heightOffset + quantized * heightStep
+	float			heightStep;
+	uint32			pyramidFirstLevel;//finer levels are not stored
+	uint32			pyramidLevelsNum;//stored levels
+	uint32			heightsSize;//bytes of compressed heights
+};
+
+#pragma pack(pop)
+
+//Compressed format of terrain tiles.
+//Heights are quantized to 16 bits with per tile offset and step, every height is predicted
+//from its neighbours and residuals are Rice coded by small blocks. Normals are not stored,
+//they are derived from heights after decoding. Coarse levels of min/max pyramid are stored
+//so only finest ones are rebuilt on load. Per texel user data (dataElemSize) is not stored.
+class SQWORLD_API HeightMapCodec
+{
+public:
+
+	static const int PYRAMID_FIRST_STORED_LEVEL = 2;
+
+	//checks header at current position of data
+	static bool IsCompressed(Data * data);
+
+	static Data * Save(const HeightMap * hm);
+	static size_t Save(const HeightMap * hm, Data * data);
+
+	//decodes map starting at current position of data (which is usually mapped file),
+	//touches nothing but data and new map so it can run on worker threads
+	static HeightMap * Load(Data * data);
+};
+
+}//namespace World {
+}//namespace Squirrel {
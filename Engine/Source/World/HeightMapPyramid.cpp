@@ -0,0 +1,143 @@
+#include "HeightMapPyramid.h"
+#include "HeightMap.h"
+#include <limits.h>
+
+namespace Squirrel {
+namespace World {
+
+HeightMapPyramid::HeightMapPyramid()
+{
+}
+
+HeightMapPyramid::~HeightMapPyramid()
+{
+}
+
+void HeightMapPyramid::build(const HeightMap * hm)
+{
+	build(hm, INT_MAX);
+}
+
+void HeightMapPyramid::build(const HeightMap * hm, int levelsNum)
+{
+	mLevels.clear();
+
+	tuple2i res = hm->getResolution();
+	if(res.x < 2 || res.y < 2 || levelsNum <= 0)
+		return;
+
+	buildFirstLevel(hm);
+
+	while((int)mLevels.size() < levelsNum && (mLevels.back().size.x > 1 || mLevels.back().size.y > 1))
+	{
+		buildNextLevel();
+	}
+}
+
+HeightMapPyramid::Level& HeightMapPyramid::addLevel(tuple2i size)
+{
+	mLevels.push_back(Level());
+	Level& level = mLevels.back();
+	level.size = size;
+	level.mins.resize(size.x * size.y);
+	level.maxs.resize(size.x * size.y);
+	return level;
+}
+
+void HeightMapPyramid::buildFirstLevel(const HeightMap * hm)
+{
+	//level 0: cells bounds
+
+	tuple2i res = hm->getResolution();
+
+	Level& first = addLevel(tuple2i(res.x - 1, res.y - 1));
+
+	const float * heights = hm->getHeights();
+
+	for(int z = 0; z < first.size.y; ++z)
+	{
+		const float * row0 = heights + z * res.x;
+		const float * row1 = row0 + res.x;
+
+		for(int x = 0; x < first.size.x; ++x)
+		{
+			float h00 = row0[x], h10 = row0[x + 1];
+			float h01 = row1[x], h11 = row1[x + 1];
+
+			int index = x + z * first.size.x;
+			first.mins[index] = Math::minValue(Math::minValue(h00, h10), Math::minValue(h01, h11));
+			first.maxs[index] = Math::maxValue(Math::maxValue(h00, h10), Math::maxValue(h01, h11));
+		}
+	}
+}
+
+void HeightMapPyramid::buildNextLevel()
+{
+	//merge 2x2 cells
+
+	tuple2i prevSize = mLevels.back().size;
+
+	Level& level = addLevel(tuple2i((prevSize.x + 1) / 2, (prevSize.y + 1) / 2));
+
+	const Level& prev = mLevels[mLevels.size() - 2];
+
+	for(int z = 0; z < level.size.y; ++z)
+	{
+		int pz0 = z * 2;
+		int pz1 = Math::minValue(pz0 + 1, prevSize.y - 1);
+
+		for(int x = 0; x < level.size.x; ++x)
+		{
+			int px0 = x * 2;
+			int px1 = Math::minValue(px0 + 1, prevSize.x - 1);
+
+			int i00 = px0 + pz0 * prevSize.x, i10 = px1 + pz0 * prevSize.x;
+			int i01 = px0 + pz1 * prevSize.x, i11 = px1 + pz1 * prevSize.x;
+
+			int index = x + z * level.size.x;
+			level.mins[index] = Math::minValue(Math::minValue(prev.mins[i00], prev.mins[i10]), Math::minValue(prev.mins[i01], prev.mins[i11]));
+			level.maxs[index] = Math::maxValue(Math::maxValue(prev.maxs[i00], prev.maxs[i10]), Math::maxValue(prev.maxs[i01], prev.maxs[i11]));
+		}
+	}
+}
+
+bool HeightMapPyramid::getRange(int x0, int z0, int x1, int z1, float& outMin, float& outMax) const
+{
+	if(isEmpty())
+		return false;
+
+	tuple2i size = mLevels[0].size;
+
+	x0 = Math::clamp(x0, 0, size.x - 1);
+	z0 = Math::clamp(z0, 0, size.y - 1);
+	x1 = Math::clamp(x1, 0, size.x - 1);
+	z1 = Math::clamp(z1, 0, size.y - 1);
+
+	if(x0 > x1 || z0 > z1)
+		return false;
+
+	//pick level where rectangle is covered by at most 2x2 cells
+
+	int level = 0;
+	while(level + 1 < getLevelsNum() && ((x1 >> level) - (x0 >> level) > 1 || (z1 >> level) - (z0 >> level) > 1))
+	{
+		++level;
+	}
+
+	outMin = FLT_MAX;
+	outMax = -FLT_MAX;
+
+	for(int z = z0 >> level; z <= (z1 >> level); ++z)
+	{
+		for(int x = x0 >> level; x <= (x1 >> level); ++x)
+		{
+			outMin = Math::minValue(outMin, getMin(level, x, z));
+			outMax = Math::maxValue(outMax, getMax(level, x, z));
+		}
+	}
+
+	return true;
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <common/common.h>
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+namespace World { 
+
+class HeightMap;
+
+//Hierarchical min/max heights of height map cells.
+//Level 0 holds bounds of every cell (quad between 4 neighbour texels),
+//every next level merges 2x2 cells of previous one until single cell is left.
+class SQWORLD_API HeightMapPyramid
+{
+public:
+
+	struct Level
+	{
+		tuple2i				size;
+		std::vector<float>	mins;
+		std::vector<float>	maxs;
+	};
+
+public://ctor/dtor
+	HeightMapPyramid();
+	~HeightMapPyramid();
+
+public://methods
+
+	void build(const HeightMap * hm);
+	//builds only levelsNum finest levels, coarser ones can be added with addLevel (e.g. loaded from file)
+	void build(const HeightMap * hm, int levelsNum);
+	void clear() { mLevels.clear(); }
+
+	//appends next coarser level, its size has to be half (rounded up) of previous one
+	Level& addLevel(tuple2i size);
+
+	inline bool		isEmpty()		const	{ return mLevels.empty(); }
+	inline int		getLevelsNum()	const	{ return (int)mLevels.size(); }
+	inline tuple2i	getLevelSize(int level) const { return mLevels[level].size; }
+
+	inline float	getMin(int level, int x, int z) const { const Level& l = mLevels[level]; return l.mins[x + z * l.size.x]; }
+	inline float	getMax(int level, int x, int z) const { const Level& l = mLevels[level]; return l.maxs[x + z * l.size.x]; }
+
+	inline float	getMin() const { return mLevels.back().mins[0]; }
+	inline float	getMax() const { return mLevels.back().maxs[0]; }
+
+	//min/max heights inside of cells rectangle (inclusive, in level 0 cells)
+	bool getRange(int x0, int z0, int x1, int z1, float& outMin, float& outMax) const;
+
+private:
+	void buildFirstLevel(const HeightMap * hm);
+	void buildNextLevel();
+
+private:
+	std::vector<Level> mLevels;
+};
+
+}//namespace World { 
+}//namespace Squirrel {
@@ -33,7 +33,8 @@ Light::Light()
 	wrapAtomicField("Diffuse",			&mLight.mDiffuse.x,		4);
 	wrapAtomicField("Specular",			&mLight.mSpecular.x,	4);
 	wrapAtomicField("Ambient",			&mLight.mAmbient.x,		4);
-	wrapAtomicField("Radius",			&mLight.mRadius);
+	Reflection::Object::Field * field = wrapAtomicField("Radius", &mLight.mRadius);
+	field->setChangeHandler<SceneObject>(this, &Light::invalidateBounds);
 	wrapAtomicField("OuterSpotAngle",	&mLight.mOuterSpotAngle);
 	wrapAtomicField("InnerSpotAngle",	&mLight.mInnerSpotAngle);
 	wrapAtomicField("Shadow",			&mLight.mShadow);
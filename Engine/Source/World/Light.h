@@ -51,7 +51,7 @@ public:
 	void		setDiffuse	(tuple4ub v)		{ mLight.mDiffuse			= v;}
 	void		setSpecular	(tuple4ub v)		{ mLight.mSpecular			= v;}
 	void		setAmbient	(tuple4ub v)		{ mLight.mAmbient			= v;}
-	void		setRadius	(float r)			{ mLight.mRadius			= r;}
+	void		setRadius	(float r)			{ mLight.mRadius			= r; invalidateBounds(); }
 	void		setInnerSpotRadius(float a)		{ mLight.mInnerSpotAngle	= a;}
 	void		setOuterSpotRadius(float a)		{ mLight.mOuterSpotAngle	= a;}
 	void		setShadow(bool sh)				{ mLight.mShadow		= sh;}
@@ -0,0 +1,350 @@
+#include "MeshCollider.h"
+#include <Math/GeometryTools.h>
+#include <algorithm>
+
+namespace Squirrel {
+namespace World {
+
+using namespace RenderData;
+
+namespace {
+
+const int MAX_TRIANGLES_PER_LEAF = 4;
+
+struct CenterAxisPredicate
+{
+	const std::vector<vec3>& mCenters;
+	int mAxis;
+
+	CenterAxisPredicate(const std::vector<vec3>& centers, int axis): mCenters(centers), mAxis(axis) {}
+
+	bool operator()(int a, int b) const { return mCenters[a][mAxis] < mCenters[b][mAxis]; }
+};
+
+inline bool SegmentIntersectsBox(const vec3& from, const vec3& dir, float maxFraction, const AABB& box)
+{
+	float tMin = 0.0f, tMax = maxFraction;
+
+	for(int i = 0; i < 3; ++i)
+	{
+		if(Math::absValue(dir[i]) < EPSILON)
+		{
+			if(from[i] < box.min[i] || from[i] > box.max[i])
+				return false;
+		}
+		else
+		{
+			float t0 = (box.min[i] - from[i]) / dir[i];
+			float t1 = (box.max[i] - from[i]) / dir[i];
+			if(t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+			tMin = Math::maxValue(tMin, t0);
+			tMax = Math::minValue(tMax, t1);
+			if(tMin > tMax)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//appends mesh triangles unrolled to triangle list
+bool AppendMeshTriangles(Resource::Mesh * mesh, const mat4& transform, std::vector<vec3>& positions, std::vector<uint32>& indices)
+{
+	const Resource::Mesh::CollisionMirror * mirror = mesh->getCollisionMirror();
+
+	if(mirror == NULL)
+		return false;
+
+	uint32 base = (uint32)positions.size();
+
+	for(size_t i = 0; i < mirror->positions.size(); ++i)
+	{
+		positions.push_back(transform * mirror->positions[i]);
+	}
+
+	const std::vector<uint32>& src = mirror->indices;
+	uint indicesNum = (uint)src.size();
+
+	switch(mirror->polyType)
+	{
+	case IndexBuffer::ptTriangles:
+		indices.reserve(indices.size() + indicesNum);
+		for(uint i = 0; i + 2 < indicesNum; i += 3)
+		{
+			indices.push_back(base + src[i + 0]);
+			indices.push_back(base + src[i + 1]);
+			indices.push_back(base + src[i + 2]);
+		}
+		break;
+	case IndexBuffer::ptTriStrip:
+		indices.reserve(indices.size() + indicesNum * 3);
+		for(uint i = 0; i + 2 < indicesNum; ++i)
+		{
+			uint32 i0 = base + src[i + 0];
+			uint32 i1 = base + src[i + 1];
+			uint32 i2 = base + src[i + 2];
+
+			//skip degenerates used to join strips
+			if(i0 == i1 || i1 == i2 || i0 == i2)
+				continue;
+
+			if(i % 2 == 0)
+			{
+				indices.push_back(i0); indices.push_back(i1); indices.push_back(i2);
+			}
+			else
+			{
+				indices.push_back(i1); indices.push_back(i0); indices.push_back(i2);
+			}
+		}
+		break;
+	case IndexBuffer::ptTriFan:
+		indices.reserve(indices.size() + indicesNum * 3);
+		for(uint i = 1; i + 1 < indicesNum; ++i)
+		{
+			indices.push_back(base + src[0]);
+			indices.push_back(base + src[i + 0]);
+			indices.push_back(base + src[i + 1]);
+		}
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+}//namespace {
+
+MeshCollider::MeshCollider():
+	Collider(ctMesh)
+{
+}
+
+MeshCollider::~MeshCollider()
+{
+}
+
+bool MeshCollider::build(Resource::Mesh * mesh, const mat4& transform)
+{
+	std::vector<vec3> positions;
+	std::vector<uint32> indices;
+
+	if(!AppendMeshTriangles(mesh, transform, positions, indices))
+		return false;
+
+	if(positions.empty() || indices.empty())
+		return false;
+
+	build(&positions[0], (int)positions.size(), &indices[0], (int)indices.size());
+
+	return true;
+}
+
+bool MeshCollider::build(const std::vector<Resource::Mesh *>& meshes)
+{
+	std::vector<vec3> positions;
+	std::vector<uint32> indices;
+
+	for(size_t i = 0; i < meshes.size(); ++i)
+	{
+		if(meshes[i] != NULL)
+			AppendMeshTriangles(meshes[i], mat4::Identity(), positions, indices);
+	}
+
+	if(positions.empty() || indices.empty())
+		return false;
+
+	build(&positions[0], (int)positions.size(), &indices[0], (int)indices.size());
+
+	return true;
+}
+
+void MeshCollider::build(const vec3 * positions, int positionsNum, const uint32 * indices, int indicesNum)
+{
+	mTriangles.clear();
+	mTriangles.reserve(indicesNum / 3);
+
+	for(int i = 0; i + 2 < indicesNum; i += 3)
+	{
+		if(indices[i + 0] >= (uint32)positionsNum || indices[i + 1] >= (uint32)positionsNum || indices[i + 2] >= (uint32)positionsNum)
+			continue;
+
+		CollisionTriangle triangle;
+		triangle.v[0] = positions[ indices[i + 0] ];
+		triangle.v[1] = positions[ indices[i + 1] ];
+		triangle.v[2] = positions[ indices[i + 2] ];
+
+		mTriangles.push_back(triangle);
+	}
+
+	buildBVH();
+}
+
+void MeshCollider::buildBVH()
+{
+	mNodes.clear();
+
+	int trianglesNum = (int)mTriangles.size();
+	if(trianglesNum == 0)
+		return;
+
+	std::vector<vec3> centers(trianglesNum);
+	for(int i = 0; i < trianglesNum; ++i)
+	{
+		const CollisionTriangle& triangle = mTriangles[i];
+		centers[i] = (triangle.v[0] + triangle.v[1] + triangle.v[2]) / 3.0f;
+	}
+
+	mNodes.reserve(2 * trianglesNum / MAX_TRIANGLES_PER_LEAF + 1);
+
+	//sort triangles through permutation and reorder them once at the end
+
+	std::vector<int> order(trianglesNum);
+	for(int i = 0; i < trianglesNum; ++i)
+		order[i] = i;
+
+	buildNode(0, trianglesNum, centers, order);
+
+	std::vector<CollisionTriangle> sorted(trianglesNum);
+	for(int i = 0; i < trianglesNum; ++i)
+		sorted[i] = mTriangles[ order[i] ];
+	mTriangles.swap(sorted);
+}
+
+int MeshCollider::buildNode(int first, int count, const std::vector<vec3>& centers, std::vector<int>& order)
+{
+	int index = (int)mNodes.size();
+	mNodes.push_back(BVHNode());
+
+	AABB box, centersBox;
+	for(int i = first; i < first + count; ++i)
+	{
+		const CollisionTriangle& triangle = mTriangles[ order[i] ];
+		box.addVertex(triangle.v[0]);
+		box.addVertex(triangle.v[1]);
+		box.addVertex(triangle.v[2]);
+		centersBox.addVertex(centers[ order[i] ]);
+	}
+
+	mNodes[index].box = box;
+
+	if(count <= MAX_TRIANGLES_PER_LEAF)
+	{
+		mNodes[index].first = first;
+		mNodes[index].count = count;
+		return index;
+	}
+
+	//split at median of longest centers extent
+
+	vec3 extent = centersBox.getSize();
+	int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+
+	int half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count, CenterAxisPredicate(centers, axis));
+
+	buildNode(first, half, centers, order);
+	int right = buildNode(first + half, count - half, centers, order);
+
+	mNodes[index].first = right;
+	mNodes[index].count = 0;
+
+	return index;
+}
+
+AABB MeshCollider::getLocalBounds() const
+{
+	return mNodes.empty() ? AABB() : mNodes[0].box;
+}
+
+void MeshCollider::collectTriangles(const AABB& localBox, COLLISION_TRIANGLES_LIST& outTriangles) const
+{
+	if(mNodes.empty())
+		return;
+
+	mStack.clear();
+	mStack.push_back(0);
+
+	while(mStack.size() > 0)
+	{
+		int index = mStack.back();
+		mStack.pop_back();
+
+		const BVHNode& node = mNodes[index];
+
+		if(!node.box.intersects(localBox))
+			continue;
+
+		if(node.count > 0)
+		{
+			for(int i = node.first; i < node.first + node.count; ++i)
+				outTriangles.push_back(mTriangles[i]);
+		}
+		else
+		{
+			mStack.push_back(node.first);
+			mStack.push_back(index + 1);
+		}
+	}
+}
+
+bool MeshCollider::raycast(const vec3& from, const vec3& to, float& outFraction, vec3& outNormal) const
+{
+	if(mNodes.empty())
+		return false;
+
+	vec3 dir = to - from;
+	float length = dir.len();
+	if(length < EPSILON)
+		return false;
+
+	float bestFraction = 1.0f;
+	bool found = false;
+
+	mStack.clear();
+	mStack.push_back(0);
+
+	while(mStack.size() > 0)
+	{
+		int index = mStack.back();
+		mStack.pop_back();
+
+		const BVHNode& node = mNodes[index];
+
+		if(!SegmentIntersectsBox(from, dir, bestFraction, node.box))
+			continue;
+
+		if(node.count > 0)
+		{
+			for(int i = node.first; i < node.first + node.count; ++i)
+			{
+				const CollisionTriangle& triangle = mTriangles[i];
+
+				//fraction of segment, only nearer triangles pass
+				float fraction = rayTriangleIntersection(from, dir, triangle.v[0], triangle.v[1], triangle.v[2]);
+				if(fraction >= 0.0f && fraction <= bestFraction)
+				{
+					bestFraction = fraction;
+					outNormal = getNormalToTriangle(triangle.v[0], triangle.v[1], triangle.v[2]);
+					if(outNormal * dir > 0.0f)
+						outNormal = -outNormal;
+					found = true;
+				}
+			}
+		}
+		else
+		{
+			mStack.push_back(node.first);
+			mStack.push_back(index + 1);
+		}
+	}
+
+	if(found)
+		outFraction = bestFraction;
+
+	return found;
+}
+
+}//namespace World {
+}//namespace Squirrel {
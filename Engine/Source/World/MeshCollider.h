@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Collider.h"
+#include <Resource/Mesh.h>
+
+namespace Squirrel {
+namespace World {
+
+//Static triangle mesh collider with bounding volume hierarchy over triangles.
+class SQWORLD_API MeshCollider:
+	public Collider
+{
+	struct BVHNode
+	{
+		AABB	box;
+		int		first;//first triangle for leaves, right child for inner nodes (left child follows node)
+		int		count;//0 for inner nodes
+	};
+
+public:
+	MeshCollider();
+	virtual ~MeshCollider();
+
+	//copies positions of mesh triangles (triangle lists and strips are supported)
+	bool build(Resource::Mesh * mesh, const mat4& transform = mat4::Identity());
+	//triangles of all meshes (e.g. of every material of model node) in one hierarchy
+	bool build(const std::vector<Resource::Mesh *>& meshes);
+	void build(const vec3 * positions, int positionsNum, const uint32 * indices, int indicesNum);
+
+	virtual AABB getLocalBounds() const;
+	virtual void collectTriangles(const AABB& localBox, COLLISION_TRIANGLES_LIST& outTriangles) const;
+	virtual bool raycast(const vec3& from, const vec3& to, float& outFraction, vec3& outNormal) const;
+
+	int getTrianglesNum() const { return (int)mTriangles.size(); }
+	int getBVHNodesNum() const { return (int)mNodes.size(); }
+
+private:
+
+	void buildBVH();
+	int buildNode(int first, int count, const std::vector<vec3>& centers, std::vector<int>& order);
+
+private:
+
+	std::vector<CollisionTriangle>	mTriangles;
+	std::vector<BVHNode>			mNodes;
+
+	mutable std::vector<int> mStack;
+};
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,470 @@
+#include "ParticlePool.h"
+#include <Common/TaskPool.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define SQ_PARTICLES_SSE2
+# include <emmintrin.h>
+#endif
+
+namespace Squirrel {
+namespace World {
+
+namespace {
+
+const int LANES = 4;
+
+//quads per parallel chunk
+const int MIN_UPDATE_CHUNK = 256;
+
+inline uint32 HashSeed(uint32 x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return x != 0 ? x : 1;
+}
+
+inline uint32 FloatToSortable(float f)
+{
+	uint32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+#ifndef SQ_PARTICLES_SSE2
+
+//xorshift, returns value in [-1, 1)
+inline float NextRandom(uint32& state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	uint32 bits = (state >> 9) | 0x3f800000;
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f * 2.0f - 3.0f;
+}
+
+#endif
+
+}//namespace {
+
+ParticlePool::ParticlePool():
+	mCount(0), mCapacity(0)
+{
+	for(int i = 0; i < sNum; ++i)
+		mStreams[i] = NULL;
+}
+
+ParticlePool::~ParticlePool()
+{
+}
+
+void ParticlePool::reserve(int capacity)
+{
+	capacity = (capacity + LANES - 1) & ~(LANES - 1);
+	if(capacity <= mCapacity)
+		return;
+
+	std::vector<float> storage(sNum * capacity + LANES, 0.0f);
+
+	//align streams by 16 bytes
+	float * base = &storage[0];
+	while((reinterpret_cast<size_t>(base) & 15) != 0)
+		++base;
+
+	for(int i = 0; i < sNum; ++i)
+	{
+		float * stream = base + i * capacity;
+		if(mCount > 0)
+			memcpy(stream, mStreams[i], mCount * sizeof(float));
+		mStreams[i] = stream;
+	}
+
+	mStorage.swap(storage);
+	mCapacity = capacity;
+}
+
+int ParticlePool::add()
+{
+	if(mCount >= mCapacity)
+		return -1;
+
+	return mCount++;
+}
+
+void ParticlePool::remove(int index)
+{
+	ASSERT(index >= 0 && index < mCount);
+
+	int last = --mCount;
+	if(index != last)
+	{
+		for(int i = 0; i < sNum; ++i)
+			mStreams[i][index] = mStreams[i][last];
+	}
+}
+
+int ParticlePool::update(float dtime, const UpdateParams& params, bool allowParallel)
+{
+	int quadsNum = (mCount + LANES - 1) / LANES;
+
+	if(allowParallel && mCount >= PARALLEL_UPDATE_THRESHOLD)
+	{
+		UpdateJob job;
+		job.pool	= this;
+		job.params	= &params;
+		job.dtime	= dtime;
+		TaskPool::Default()->parallelFor(quadsNum, MIN_UPDATE_CHUNK, &ParticlePool::UpdateRange, &job);
+	}
+	else
+	{
+		integrate(0, quadsNum, dtime, params);
+	}
+
+	return removeDead();
+}
+
+void ParticlePool::UpdateRange(void * context, int beginQuad, int endQuad)
+{
+	UpdateJob * job = static_cast<UpdateJob *>(context);
+	job->pool->integrate(beginQuad, endQuad, job->dtime, *job->params);
+}
+
+void ParticlePool::integrate(int beginQuad, int endQuad, float dtime, const UpdateParams& params)
+{
+	const float damping			= params.damping < 1.0f ? powf(Math::maxValue(params.damping, 0.0f), dtime) : 1.0f;
+	const float moveScale		= params.scale * dtime;
+	const float sizeGrow		= params.sizeGrow * params.scale * dtime;
+	const bool randomForce		= params.randomForce.x != 0.0f || params.randomForce.y != 0.0f || params.randomForce.z != 0.0f;
+	const int colorsNum			= Math::minValue(params.animColorsNum, (int)MAX_ANIM_COLORS);
+	const float lastColorIndex	= (float)(colorsNum - 1);
+
+	float * posX			= mStreams[sPosX];
+	float * posY			= mStreams[sPosY];
+	float * posZ			= mStreams[sPosZ];
+	float * velocityX		= mStreams[sVelocityX];
+	float * velocityY		= mStreams[sVelocityY];
+	float * velocityZ		= mStreams[sVelocityZ];
+	float * colorR			= mStreams[sColorR];
+	float * colorG			= mStreams[sColorG];
+	float * colorB			= mStreams[sColorB];
+	float * colorA			= mStreams[sColorA];
+	float * size			= mStreams[sSize];
+	float * angle			= mStreams[sAngle];
+	float * angularVelocity	= mStreams[sAngularVelocity];
+	float * energy			= mStreams[sEnergy];
+	float * invInitialEnergy= mStreams[sInvInitialEnergy];
+
+	uint32 seeds[LANES];
+	for(int lane = 0; lane < LANES; ++lane)
+		seeds[lane] = HashSeed(params.seed ^ ((beginQuad * LANES + lane) * 0x9e3779b9));
+
+#ifdef SQ_PARTICLES_SSE2
+
+	const __m128 vDtime			= _mm_set1_ps(dtime);
+	const __m128 vDamping		= _mm_set1_ps(damping);
+	const __m128 vMoveScale		= _mm_set1_ps(moveScale);
+	const __m128 vSizeGrow		= _mm_set1_ps(sizeGrow);
+	const __m128 vForceX		= _mm_set1_ps(params.force.x * dtime);
+	const __m128 vForceY		= _mm_set1_ps(params.force.y * dtime);
+	const __m128 vForceZ		= _mm_set1_ps(params.force.z * dtime);
+	const __m128 vRandomForceX	= _mm_set1_ps(params.randomForce.x * dtime);
+	const __m128 vRandomForceY	= _mm_set1_ps(params.randomForce.y * dtime);
+	const __m128 vRandomForceZ	= _mm_set1_ps(params.randomForce.z * dtime);
+	const __m128 vZero			= _mm_setzero_ps();
+	const __m128 vOne			= _mm_set1_ps(1.0f);
+	const __m128 vColorsNum		= _mm_set1_ps((float)colorsNum);
+	const __m128 vLastColor		= _mm_set1_ps(lastColorIndex);
+	const __m128 vSignMask		= _mm_set1_ps(-0.0f);
+	const __m128 vTwo			= _mm_set1_ps(2.0f);
+	const __m128 vThree			= _mm_set1_ps(3.0f);
+	const __m128i vOneBits		= _mm_set1_epi32(0x3f800000);
+
+	__m128i state = _mm_setr_epi32((int)seeds[0], (int)seeds[1], (int)seeds[2], (int)seeds[3]);
+
+	#define SQ_NEXT_RANDOM(out) \
+		state = _mm_xor_si128(state, _mm_slli_epi32(state, 13)); \
+		state = _mm_xor_si128(state, _mm_srli_epi32(state, 17)); \
+		state = _mm_xor_si128(state, _mm_slli_epi32(state, 5)); \
+		out = _mm_sub_ps(_mm_mul_ps(_mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(state, 9), vOneBits)), vTwo), vThree);
+
+	for(int quad = beginQuad; quad < endQuad; ++quad)
+	{
+		const int i = quad * LANES;
+
+		//velocity and position
+
+		__m128 accelX = vForceX, accelY = vForceY, accelZ = vForceZ;
+		if(randomForce)
+		{
+			__m128 rnd;
+			SQ_NEXT_RANDOM(rnd); accelX = _mm_add_ps(accelX, _mm_mul_ps(vRandomForceX, rnd));
+			SQ_NEXT_RANDOM(rnd); accelY = _mm_add_ps(accelY, _mm_mul_ps(vRandomForceY, rnd));
+			SQ_NEXT_RANDOM(rnd); accelZ = _mm_add_ps(accelZ, _mm_mul_ps(vRandomForceZ, rnd));
+		}
+
+		__m128 vx = _mm_mul_ps(_mm_add_ps(_mm_load_ps(velocityX + i), accelX), vDamping);
+		__m128 vy = _mm_mul_ps(_mm_add_ps(_mm_load_ps(velocityY + i), accelY), vDamping);
+		__m128 vz = _mm_mul_ps(_mm_add_ps(_mm_load_ps(velocityZ + i), accelZ), vDamping);
+		_mm_store_ps(velocityX + i, vx);
+		_mm_store_ps(velocityY + i, vy);
+		_mm_store_ps(velocityZ + i, vz);
+
+		_mm_store_ps(posX + i, _mm_add_ps(_mm_load_ps(posX + i), _mm_mul_ps(vx, vMoveScale)));
+		_mm_store_ps(posY + i, _mm_add_ps(_mm_load_ps(posY + i), _mm_mul_ps(vy, vMoveScale)));
+		_mm_store_ps(posZ + i, _mm_add_ps(_mm_load_ps(posZ + i), _mm_mul_ps(vz, vMoveScale)));
+
+		//life
+
+		__m128 e = _mm_sub_ps(_mm_load_ps(energy + i), vDtime);
+		_mm_store_ps(energy + i, e);
+
+		_mm_store_ps(size + i, _mm_add_ps(_mm_load_ps(size + i), vSizeGrow));
+
+		if(params.rotation)
+			_mm_store_ps(angle + i, _mm_add_ps(_mm_load_ps(angle + i), _mm_mul_ps(_mm_load_ps(angularVelocity + i), vDtime)));
+
+		//colors are blended by tent weights of keys, weights of neighbour keys sum up to one
+
+		if(colorsNum > 0)
+		{
+			__m128 lifeElapsed = _mm_sub_ps(vOne, _mm_mul_ps(e, _mm_load_ps(invInitialEnergy + i)));
+			lifeElapsed = _mm_min_ps(_mm_max_ps(lifeElapsed, vZero), vOne);
+			__m128 factor = _mm_min_ps(_mm_mul_ps(lifeElapsed, vColorsNum), vLastColor);
+
+			__m128 r = vZero, g = vZero, b = vZero, a = vZero;
+			for(int k = 0; k < colorsNum; ++k)
+			{
+				__m128 distance = _mm_andnot_ps(vSignMask, _mm_sub_ps(factor, _mm_set1_ps((float)k)));
+				__m128 weight = _mm_max_ps(_mm_sub_ps(vOne, distance), vZero);
+				const vec4& key = params.animColors[k];
+				r = _mm_add_ps(r, _mm_mul_ps(weight, _mm_set1_ps(key.x)));
+				g = _mm_add_ps(g, _mm_mul_ps(weight, _mm_set1_ps(key.y)));
+				b = _mm_add_ps(b, _mm_mul_ps(weight, _mm_set1_ps(key.z)));
+				a = _mm_add_ps(a, _mm_mul_ps(weight, _mm_set1_ps(key.w)));
+			}
+
+			_mm_store_ps(colorR + i, r);
+			_mm_store_ps(colorG + i, g);
+			_mm_store_ps(colorB + i, b);
+			_mm_store_ps(colorA + i, a);
+		}
+	}
+
+	#undef SQ_NEXT_RANDOM
+
+#else//portable path, plain loops over lanes are left for compiler to vectorize
+
+	const float forceX = params.force.x * dtime;
+	const float forceY = params.force.y * dtime;
+	const float forceZ = params.force.z * dtime;
+	const vec3 randomForceScale = params.randomForce * dtime;
+
+	for(int quad = beginQuad; quad < endQuad; ++quad)
+	{
+		const int begin = quad * LANES;
+		const int end = begin + LANES;
+
+		if(randomForce)
+		{
+			for(int i = begin; i < end; ++i)
+			{
+				uint32& state = seeds[i - begin];
+				velocityX[i] += randomForceScale.x * NextRandom(state);
+				velocityY[i] += randomForceScale.y * NextRandom(state);
+				velocityZ[i] += randomForceScale.z * NextRandom(state);
+			}
+		}
+
+		for(int i = begin; i < end; ++i)
+		{
+			velocityX[i] = (velocityX[i] + forceX) * damping;
+			velocityY[i] = (velocityY[i] + forceY) * damping;
+			velocityZ[i] = (velocityZ[i] + forceZ) * damping;
+
+			posX[i] += velocityX[i] * moveScale;
+			posY[i] += velocityY[i] * moveScale;
+			posZ[i] += velocityZ[i] * moveScale;
+
+			energy[i] -= dtime;
+			size[i] += sizeGrow;
+		}
+
+		if(params.rotation)
+		{
+			for(int i = begin; i < end; ++i)
+				angle[i] += angularVelocity[i] * dtime;
+		}
+
+		if(colorsNum > 0)
+		{
+			for(int i = begin; i < end; ++i)
+			{
+				float lifeElapsed = Math::clamp(1.0f - energy[i] * invInitialEnergy[i], 0.0f, 1.0f);
+				float factor = Math::minValue(lifeElapsed * colorsNum, lastColorIndex);
+
+				float r = 0, g = 0, b = 0, a = 0;
+				for(int k = 0; k < colorsNum; ++k)
+				{
+					float weight = Math::maxValue(1.0f - fabsf(factor - k), 0.0f);
+					const vec4& key = params.animColors[k];
+					r += weight * key.x;
+					g += weight * key.y;
+					b += weight * key.z;
+					a += weight * key.w;
+				}
+
+				colorR[i] = r;
+				colorG[i] = g;
+				colorB[i] = b;
+				colorA[i] = a;
+			}
+		}
+	}
+
+#endif
+}
+
+int ParticlePool::removeDead()
+{
+	const float * energy = mStreams[sEnergy];
+
+	int diedNum = 0;
+
+	int i = 0;
+	while(i < mCount)
+	{
+		if(energy[i] <= 0.0f)
+		{
+			remove(i);
+			++diedNum;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	return diedNum;
+}
+
+AABB ParticlePool::calcBounds() const
+{
+	AABB box;
+	if(mCount == 0)
+		return box;
+
+	const float * posX = mStreams[sPosX];
+	const float * posY = mStreams[sPosY];
+	const float * posZ = mStreams[sPosZ];
+
+	int i = 0;
+
+#ifdef SQ_PARTICLES_SSE2
+
+	if(mCount >= LANES)
+	{
+		__m128 minX = _mm_load_ps(posX), maxX = minX;
+		__m128 minY = _mm_load_ps(posY), maxY = minY;
+		__m128 minZ = _mm_load_ps(posZ), maxZ = minZ;
+
+		for(i = LANES; i + LANES <= mCount; i += LANES)
+		{
+			__m128 x = _mm_load_ps(posX + i);
+			__m128 y = _mm_load_ps(posY + i);
+			__m128 z = _mm_load_ps(posZ + i);
+			minX = _mm_min_ps(minX, x); maxX = _mm_max_ps(maxX, x);
+			minY = _mm_min_ps(minY, y); maxY = _mm_max_ps(maxY, y);
+			minZ = _mm_min_ps(minZ, z); maxZ = _mm_max_ps(maxZ, z);
+		}
+
+		float lanes[6][LANES];
+		_mm_storeu_ps(lanes[0], minX); _mm_storeu_ps(lanes[1], minY); _mm_storeu_ps(lanes[2], minZ);
+		_mm_storeu_ps(lanes[3], maxX); _mm_storeu_ps(lanes[4], maxY); _mm_storeu_ps(lanes[5], maxZ);
+
+		for(int lane = 0; lane < LANES; ++lane)
+		{
+			box.addVertex(vec3(lanes[0][lane], lanes[1][lane], lanes[2][lane]));
+			box.addVertex(vec3(lanes[3][lane], lanes[4][lane], lanes[5][lane]));
+		}
+	}
+
+#endif
+
+	for(; i < mCount; ++i)
+		box.addVertex(vec3(posX[i], posY[i], posZ[i]));
+
+	return box;
+}
+
+const std::vector<uint32>& ParticlePool::sortBackToFront(const vec3& eye, const vec3& viewDir)
+{
+	for(int i = 0; i < 2; ++i)
+	{
+		mSortKeys[i].resize(mCount);
+		mSortOrder[i].resize(mCount);
+	}
+
+	if(mCount == 0)
+		return mSortOrder[0];
+
+	const float * posX = mStreams[sPosX];
+	const float * posY = mStreams[sPosY];
+	const float * posZ = mStreams[sPosZ];
+
+	uint32 * keys = &mSortKeys[0][0];
+	uint32 * order = &mSortOrder[0][0];
+
+	//inverted keys make ascending sort put farthest particles first
+	for(int i = 0; i < mCount; ++i)
+	{
+		float depth = (posX[i] - eye.x) * viewDir.x + (posY[i] - eye.y) * viewDir.y + (posZ[i] - eye.z) * viewDir.z;
+		keys[i] = ~FloatToSortable(depth);
+		order[i] = i;
+	}
+
+	//LSD radix sort by bytes, passes where all keys share the same byte are skipped
+
+	uint32 * keysTemp = &mSortKeys[1][0];
+	uint32 * orderTemp = &mSortOrder[1][0];
+
+	for(int shift = 0; shift < 32; shift += 8)
+	{
+		uint32 offsets[256];
+		memset(offsets, 0, sizeof(offsets));
+
+		for(int i = 0; i < mCount; ++i)
+			++offsets[(keys[i] >> shift) & 0xFF];
+
+		if(offsets[(keys[0] >> shift) & 0xFF] == (uint32)mCount)
+			continue;
+
+		uint32 sum = 0;
+		for(int bucket = 0; bucket < 256; ++bucket)
+		{
+			uint32 bucketSize = offsets[bucket];
+			offsets[bucket] = sum;
+			sum += bucketSize;
+		}
+
+		for(int i = 0; i < mCount; ++i)
+		{
+			uint32 dst = offsets[(keys[i] >> shift) & 0xFF]++;
+			keysTemp[dst] = keys[i];
+			orderTemp[dst] = order[i];
+		}
+
+		uint32 * swapKeys = keys; keys = keysTemp; keysTemp = swapKeys;
+		uint32 * swapOrder = order; order = orderTemp; orderTemp = swapOrder;
+	}
+
+	return order == &mSortOrder[0][0] ? mSortOrder[0] : mSortOrder[1];
+}
+
+}//namespace World {
+}//namespace Squirrel {
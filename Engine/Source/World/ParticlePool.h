@@ -0,0 +1,118 @@
+#pragma once
+
+#include <common/common.h>
+#include <Math/AABB.h>
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+namespace World {
+
+using namespace Math;
+
+//Particles storage as structure of arrays.
+//Every attribute lives in its own 16 bytes aligned stream padded to multiple of 4,
+//so update kernels process 4 particles at once; dead particles are swap-removed.
+class SQWORLD_API ParticlePool
+{
+public:
+
+	static const int MAX_ANIM_COLORS = 5;
+
+	enum Stream
+	{
+		sPosX = 0,
+		sPosY,
+		sPosZ,
+		sVelocityX,
+		sVelocityY,
+		sVelocityZ,
+		sColorR,
+		sColorG,
+		sColorB,
+		sColorA,
+		sSize,
+		sAngle,
+		sAngularVelocity,
+		sEnergy,
+		sInvInitialEnergy,
+		sNum
+	};
+
+	struct UpdateParams
+	{
+		vec3	force;
+		vec3	randomForce;//random force in [-randomForce, randomForce] is added for each particle
+		float	damping;//part of velocity left after one second
+		float	sizeGrow;//per second
+		float	scale;//emitter scale, applied to movement and size growth
+		bool	rotation;
+		int		animColorsNum;//0 to keep colors
+		vec4	animColors[MAX_ANIM_COLORS];//evenly distributed over particle life
+		uint32	seed;//random force seed, change it every update
+	};
+
+	//particles with energy above this number are updated in parallel
+	static const int PARALLEL_UPDATE_THRESHOLD = 8192;
+
+public:
+	ParticlePool();
+	~ParticlePool();
+
+	void	reserve(int capacity);
+	void	clear() { mCount = 0; }
+
+	//returns index of new particle with uninitialized attributes or -1 if pool is full
+	int		add();
+
+	//moves last particle to index
+	void	remove(int index);
+
+	//integrates particles and removes dead ones, returns number of died particles
+	int		update(float dtime, const UpdateParams& params, bool allowParallel = true);
+
+	AABB	calcBounds() const;
+
+	//returns particles indices sorted by distance along view direction, farthest first
+	const std::vector<uint32>& sortBackToFront(const vec3& eye, const vec3& viewDir);
+
+	inline int		getCount()		const { return mCount; }
+	inline int		getCapacity()	const { return mCapacity; }
+
+	inline float *			getStream(Stream stream)		{ return mStreams[stream]; }
+	inline const float *	getStream(Stream stream) const	{ return mStreams[stream]; }
+
+	inline vec3 getPosition(int index) const
+	{
+		return vec3(mStreams[sPosX][index], mStreams[sPosY][index], mStreams[sPosZ][index]);
+	}
+
+private:
+
+	struct UpdateJob
+	{
+		ParticlePool *			pool;
+		const UpdateParams *	params;
+		float					dtime;
+	};
+
+	static void UpdateRange(void * context, int beginQuad, int endQuad);
+
+	void	integrate(int beginQuad, int endQuad, float dtime, const UpdateParams& params);
+	int		removeDead();
+
+private:
+
+	std::vector<float>	mStorage;
+	float *				mStreams[sNum];
+
+	int					mCount;
+	int					mCapacity;
+
+	//sort buffers
+	std::vector<uint32>	mSortKeys[2];
+	std::vector<uint32>	mSortOrder[2];
+};
+
+}//namespace World {
+}//namespace Squirrel {
@@ -8,12 +8,100 @@
 #include <Reflection/AtomicWrapper.h>
 #include <Reflection/CollectionWrapper.h>
 #include <Reflection/EnumWrapper.h>
+#include <Common/TaskPool.h>
 
 namespace Squirrel {
 namespace World { 
 
 #define MAX_PARTICLES_NUM	8192
 
+//vertices of particles above this number are written in parallel
+#define PARALLEL_WRITE_THRESHOLD	8192
+
+namespace {
+
+struct VerticesJob
+{
+	const ParticlePool *	particles;
+	const uint32 *			order;//NULL to keep pool order
+
+	byte *	verts;
+	size_t	vertexSize;
+	size_t	positionOffset;
+	size_t	colorOffset;
+	size_t	paramsOffset;//size and angle of hardware billboards, 0 for software ones
+
+	bool	software;
+	vec3	up;
+	vec3	right;
+};
+
+inline void WriteVec3(byte * dst, float x, float y, float z)
+{
+	float * f = reinterpret_cast<float *>(dst);
+	f[0] = x; f[1] = y; f[2] = z;
+}
+
+inline void WriteVec4(byte * dst, float x, float y, float z, float w)
+{
+	float * f = reinterpret_cast<float *>(dst);
+	f[0] = x; f[1] = y; f[2] = z; f[3] = w;
+}
+
+//writes 4 vertices per particle straight into vertex buffer storage
+void WriteVertices(void * context, int begin, int end)
+{
+	const VerticesJob& job = *static_cast<VerticesJob *>(context);
+
+	const float * posX	= job.particles->getStream(ParticlePool::sPosX);
+	const float * posY	= job.particles->getStream(ParticlePool::sPosY);
+	const float * posZ	= job.particles->getStream(ParticlePool::sPosZ);
+	const float * r		= job.particles->getStream(ParticlePool::sColorR);
+	const float * g		= job.particles->getStream(ParticlePool::sColorG);
+	const float * b		= job.particles->getStream(ParticlePool::sColorB);
+	const float * a		= job.particles->getStream(ParticlePool::sColorA);
+	const float * size	= job.particles->getStream(ParticlePool::sSize);
+	const float * angle	= job.particles->getStream(ParticlePool::sAngle);
+
+	byte * vertex = job.verts + begin * 4 * job.vertexSize;
+
+	for(int i = begin; i < end; ++i)
+	{
+		int p = job.order ? (int)job.order[i] : i;
+
+		if(job.software)
+		{
+			//TODO: add support of rotation if needed
+			vec3 up		= job.up * size[p] * 0.5f;
+			vec3 right	= job.right * size[p] * 0.5f;
+
+			for(int corner = 0; corner < 4; ++corner)
+			{
+				vec3 offset = (corner & 1 ? -up : up) + (corner & 2 ? -right : right);
+				WriteVec3(vertex + job.positionOffset, posX[p] + offset.x, posY[p] + offset.y, posZ[p] + offset.z);
+				WriteVec4(vertex + job.colorOffset, r[p], g[p], b[p], a[p]);
+				vertex += job.vertexSize;
+			}
+		}
+		else
+		{
+			float rotation = angle[p] * DEG2RAD;
+
+			for(int corner = 0; corner < 4; ++corner)
+			{
+				WriteVec3(vertex + job.positionOffset, posX[p], posY[p], posZ[p]);
+				WriteVec4(vertex + job.colorOffset, r[p], g[p], b[p], a[p]);
+				float * params = reinterpret_cast<float *>(vertex + job.paramsOffset);
+				params[0] = size[p];
+				params[1] = rotation;
+				vertex += job.vertexSize;
+			}
+		}
+	}
+}
+
+}//namespace {
+
 SQREFL_REGISTER_CLASS_SEED(World::ParticleSystem, WorldParticleSystem);
 
 //////////////////////////////////////////////////////////////////////
@@ -21,7 +109,7 @@ SQREFL_REGISTER_CLASS_SEED(World::ParticleSystem, WorldParticleSystem);
 //////////////////////////////////////////////////////////////////////
 
 ParticleSystem::ParticleSystem():
-	mProgram(NULL), mMesh(NULL), mTexture(NULL), mMaxParticlesNum(MAX_PARTICLES_NUM)
+	mProgram(NULL), mMesh(NULL), mTexture(NULL), mMaxParticlesNum(MAX_PARTICLES_NUM), mRandomSeed(0), mAlphaBlending(false)
 {
 	//init emission params
 
@@ -92,6 +180,8 @@ ParticleSystem::ParticleSystem():
 	Reflection::Object::Field * field = wrapAtomicField<int>("RenderWay",	reinterpret_cast<int*>(&mRenderWay));
 	field->attributes.push_back("Read-only");
 
+	wrapAtomicField("AlphaBlending",	&mAlphaBlending);
+
 	field = wrapAtomicField("MaxParticlesNum",	&mMaxParticlesNum);
 	field->attributes.push_back("Read-only");
 
@@ -133,11 +223,13 @@ void ParticleSystem::init(const std::string& textureName, int maxParticlesNum, R
 	//init buffer
 
 	mMaxParticlesNum = maxParticlesNum;
+	mParticles.reserve(maxParticlesNum);
 
 	//render members
 
 	mRenderWay = renderWay;
 
+	DELETE_PTR(mMesh);
 	mMesh = new Resource::Mesh();
 
 	const int vertsPerParticle = 4;
@@ -200,55 +292,28 @@ void ParticleSystem::update(float dtime)
 	if(dtime > 1.0f)
 		dtime = 1.0f;
 
-	float scale = getScale().x;
+	mStats.reset();
 
-	mAABB.reset();
+	ParticlePool::UpdateParams params;
+	params.force			= mForce;
+	params.randomForce		= mRandomForce;
+	params.damping			= mDumping;
+	params.sizeGrow			= mSizeGrow;
+	params.scale			= getScale().x;
+	params.rotation			= mRotation;
+	params.animColorsNum	= mAnimateColors ? mAnimColorsNum : 0;
+	params.seed				= ++mRandomSeed;
+	for(int i = 0; i < params.animColorsNum; ++i)
+		params.animColors[i] = colorBytesToVec4(mAnimColors[i]);
 
 	//update particles
 
-	std::list<Particle>::iterator it = mParticles.begin();
-	while(it != mParticles.end())
-	{
-		Particle& particle = (*it);
-
-		particle.velocity.x += (mForce.x + getRandomMinMax(-mRandomForce.x, mRandomForce.x)) * dtime;
-		particle.velocity.y += (mForce.y + getRandomMinMax(-mRandomForce.y, mRandomForce.y)) * dtime;
-		particle.velocity.z += (mForce.z + getRandomMinMax(-mRandomForce.z, mRandomForce.z)) * dtime;
-
-		particle.pos += particle.velocity * scale * dtime;
-		
-		particle.energy -= dtime;//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
-		if(particle.energy <= 0)
-		{
-			it = mParticles.erase(it);
-			continue;
-		}
-		
-		float lifeElapsed = (particle.initialEnergy - particle.energy) / particle.initialEnergy;
-
-		particle.size += mSizeGrow * scale * dtime;
+	mStats.mDiedNum = mParticles.update(dtime, params);
 
-		float colorFactor = lifeElapsed * mAnimColorsNum;
-
-		int colorIndex = (int)floor(colorFactor);
-		int nextColorIndex = colorIndex + 1;
-		float colorFrac = colorFactor - colorIndex;
-
-		if((nextColorIndex) < mAnimColorsNum)
-			particle.color = lerp(	colorBytesToVec4(mAnimColors[colorIndex]), 
-									colorBytesToVec4(mAnimColors[nextColorIndex]), colorFrac);
-		else
-			particle.color = colorBytesToVec4(mAnimColors[mAnimColorsNum - 1]);
-			
-		if(mRotation)
-		{
-			particle.angle += particle.angularVelocity * dtime;
-		}
+	mAABB = mParticles.calcBounds();
 
-		mAABB.addVertex(particle.pos);
-
-		++it;
-	}
+	//particles bounds are finished in calcAABB
+	invalidateBounds();
 
 	//emit particles
 
@@ -271,6 +336,8 @@ void ParticleSystem::update(float dtime)
 			emitParticle();
 		}
 	}
+
+	mStats.mParticlesNum = mParticles.getCount();
 }
 
 void ParticleSystem::renderCustom(Render::IRender * render, Render::Camera * camera, const RenderInfo& info)
@@ -290,64 +357,21 @@ void ParticleSystem::renderCustom(Render::IRender * render, Render::Camera * cam
 
 	VertexBuffer * vb = mMesh->getVertexBuffer();
 
-	int vertex = 0;
-	std::list<Particle>::iterator it;
-	
-	switch(mRenderWay)
+	int particlesNum = Math::minValue(mParticles.getCount(), (int)vb->getVertsNum() / 4);
+	if(particlesNum == 0)
+		return;
+
+	//additive blending does not depend on order
+	const uint32 * order = NULL;
+	if(mAlphaBlending)
 	{
-	case rwSoftwareBillboards:
-		{
-			vec3 eye = camera->getPosition() - getPosition();
-			vec3 right = (eye ^ vec3(0, 1, 0)).normalized();
-			vec3 up = (right ^ eye).normalized();
+		order = &mParticles.sortBackToFront(camera->getPosition(), camera->getDirection())[0];
+		mStats.mSortedNum = mParticles.getCount();
+	}
 
-			for(it = mParticles.begin(); it != mParticles.end(); ++it)
-			{
-				//TODO: add support of rotation if needed
-				//TODO: calc right and up vectors for each particle separatelly
-				Particle& particle = (*it);
-
-				vec3 particleUp		= up * particle.size * 0.5;
-				vec3 particleRight	= right * particle.size * 0.5;
-
-				vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-				vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos + particleUp + particleRight);
-				vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-				vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos - particleUp + particleRight);
-				vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-				vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos + particleUp - particleRight);
-				vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-				vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos - particleUp - particleRight);
-			}
-		}
-		break;
-	case rwBillboards:
+	writeVertices(camera, order);
 
-		for(it = mParticles.begin(); it != mParticles.end(); ++it)
-		{
-			Particle& particle = (*it);
-			float angle = particle.angle * DEG2RAD;
-			vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-			vb->setComponent<VertexBuffer::vcTexcoord2>(vertex, vec2(particle.size, angle));
-			vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos);
-			vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-			vb->setComponent<VertexBuffer::vcTexcoord2>(vertex, vec2(particle.size, angle));
-			vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos);
-			vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-			vb->setComponent<VertexBuffer::vcTexcoord2>(vertex, vec2(particle.size, angle));
-			vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos);
-			vb->setComponent<VertexBuffer::vcColor>(	vertex, particle.color);
-			vb->setComponent<VertexBuffer::vcTexcoord2>(vertex, vec2(particle.size, angle));
-			vb->setComponent<VertexBuffer::vcPosition>(	vertex++, particle.pos);
-		}
-		break;
-	case rwSoftBillboards:
-	case rwPointSprites:
-	default:
-		ASSERT(false);//not implemented
-	}
-	
-	vb->update(0, mParticles.size() * 4 * vb->getVertexSize());
+	vb->update(0, particlesNum * 4 * vb->getVertexSize());
 
 	if(mTexture != NULL)
 	{
@@ -360,7 +384,7 @@ void ParticleSystem::renderCustom(Render::IRender * render, Render::Camera * cam
 	program->uniform("cameraPos", camera->getPosition());
 	program->uniform("cameraUp", vec3(0,1,0));
 
-	render->setBlendMode(Render::IRender::blendSprites);
+	render->setBlendMode(mAlphaBlending ? Render::IRender::blendOneMinusAlpha : Render::IRender::blendSprites);
 	render->setAlphaTestValue(0);
 	render->enableDepthWrite(false);
 	render->setColor(vec4(1,1,1,1));
@@ -371,42 +395,99 @@ void ParticleSystem::renderCustom(Render::IRender * render, Render::Camera * cam
 
 	render->getUniformsPool().fetchUniforms(program);
 
-	render->renderIndexBuffer(mMesh->getIndexBuffer(), tuple2i(0, mParticles.size() * 6));
+	render->renderIndexBuffer(mMesh->getIndexBuffer(), tuple2i(0, particlesNum * 6));
 
 	render->enableDepthWrite(true);
 	//render->enableDepthTest(true);
 }
 
-void ParticleSystem::emitParticle()
+void ParticleSystem::writeVertices(Render::Camera * camera, const uint32 * order)
 {
-	if(mParticles.size() >= mMaxParticlesNum) return;
+	VertexBuffer * vb = mMesh->getVertexBuffer();
 
-	float scale = getScale().x;
+	int particlesNum = Math::minValue(mParticles.getCount(), (int)vb->getVertsNum() / 4);
 
-	mParticles.push_back(Particle());
-	Particle& particle = mParticles.back();
+	VerticesJob job;
+	job.particles		= &mParticles;
+	job.order			= order;
+	job.verts			= vb->getVerts();
+	job.vertexSize		= vb->getVertexSize();
+	job.positionOffset	= vb->getComponentOffset(VertexBuffer::vcPosition);
+	job.colorOffset		= vb->getComponentOffset(VertexBuffer::vcColor);
+	job.paramsOffset	= 0;
+	job.software		= false;
 
-	particle.pos.x = getRandomMinMax(-mEmissionElipsoid.x, mEmissionElipsoid.x) * scale;
-	particle.pos.y = getRandomMinMax(-mEmissionElipsoid.y, mEmissionElipsoid.y) * scale;
-	particle.pos.z = getRandomMinMax(-mEmissionElipsoid.z, mEmissionElipsoid.z) * scale;
+	switch(mRenderWay)
+	{
+	case rwSoftwareBillboards:
+		{
+			//TODO: calc right and up vectors for each particle separatelly
+			vec3 eye = camera->getPosition() - getPosition();
+			job.right	= (eye ^ vec3(0, 1, 0)).normalized();
+			job.up		= (job.right ^ eye).normalized();
+			job.software = true;
+		}
+		break;
+	case rwBillboards:
+		job.paramsOffset = vb->getComponentOffset(VertexBuffer::vcTexcoord2);
+		break;
+	case rwSoftBillboards:
+	case rwPointSprites:
+	default:
+		ASSERT(false);//not implemented
+		return;
+	}
 
-	particle.pos += getPosition();
+	if(particlesNum >= PARALLEL_WRITE_THRESHOLD)
+		TaskPool::Default()->parallelFor(particlesNum, 1024, &WriteVertices, &job);
+	else
+		WriteVertices(&job, 0, particlesNum);
 
-	particle.angle = getRandomMinMax(0, mStartRndRotation);
+	mStats.mVerticesWritten = particlesNum * 4;
+}
 
-	particle.color = colorBytesToVec4(mAnimColors[0]);
+void ParticleSystem::emitParticle()
+{
+	if(mParticles.getCount() >= mMaxParticlesNum) return;
 
-	particle.energy = getRandomMinMax(mEnergyRange.x, mEnergyRange.y);
-	particle.initialEnergy = particle.energy;
-	particle.size = getRandomMinMax(mSizeRange.x, mSizeRange.y) * scale;
+	if(mParticles.getCapacity() < mMaxParticlesNum)
+		mParticles.reserve(mMaxParticlesNum);
 
-	particle.velocity = mStartVelocity;
-	particle.velocity.x += getRandomMinMax(0, mStartRndVelocity.x);
-	particle.velocity.y += getRandomMinMax(0, mStartRndVelocity.y);
-	particle.velocity.z += getRandomMinMax(0, mStartRndVelocity.z);
+	int index = mParticles.add();
+
+	float scale = getScale().x;
 
-	if(mRotation)
-		particle.angularVelocity = mStartRotation + getRandomMinMax(0, mStartRndRotation);
+	vec3 pos = getPosition();
+	pos.x += getRandomMinMax(-mEmissionElipsoid.x, mEmissionElipsoid.x) * scale;
+	pos.y += getRandomMinMax(-mEmissionElipsoid.y, mEmissionElipsoid.y) * scale;
+	pos.z += getRandomMinMax(-mEmissionElipsoid.z, mEmissionElipsoid.z) * scale;
+
+	vec3 velocity = mStartVelocity;
+	velocity.x += getRandomMinMax(0, mStartRndVelocity.x);
+	velocity.y += getRandomMinMax(0, mStartRndVelocity.y);
+	velocity.z += getRandomMinMax(0, mStartRndVelocity.z);
+
+	vec4 color = colorBytesToVec4(mAnimColors[0]);
+
+	float energy = getRandomMinMax(mEnergyRange.x, mEnergyRange.y);
+
+	mParticles.getStream(ParticlePool::sPosX)[index]				= pos.x;
+	mParticles.getStream(ParticlePool::sPosY)[index]				= pos.y;
+	mParticles.getStream(ParticlePool::sPosZ)[index]				= pos.z;
+	mParticles.getStream(ParticlePool::sVelocityX)[index]			= velocity.x;
+	mParticles.getStream(ParticlePool::sVelocityY)[index]			= velocity.y;
+	mParticles.getStream(ParticlePool::sVelocityZ)[index]			= velocity.z;
+	mParticles.getStream(ParticlePool::sColorR)[index]				= color.x;
+	mParticles.getStream(ParticlePool::sColorG)[index]				= color.y;
+	mParticles.getStream(ParticlePool::sColorB)[index]				= color.z;
+	mParticles.getStream(ParticlePool::sColorA)[index]				= color.w;
+	mParticles.getStream(ParticlePool::sSize)[index]				= getRandomMinMax(mSizeRange.x, mSizeRange.y) * scale;
+	mParticles.getStream(ParticlePool::sAngle)[index]				= getRandomMinMax(0, mStartRndRotation);
+	mParticles.getStream(ParticlePool::sAngularVelocity)[index]		= mRotation ? mStartRotation + getRandomMinMax(0, mStartRndRotation) : 0.0f;
+	mParticles.getStream(ParticlePool::sEnergy)[index]				= energy;
+	mParticles.getStream(ParticlePool::sInvInitialEnergy)[index]	= energy > 0.0f ? 1.0f / energy : 0.0f;
+
+	++mStats.mEmittedNum;
 }
 
 void ParticleSystem::calcAABB()
@@ -5,7 +5,7 @@
 #include <Resource/Mesh.h>
 #include <Resource/ResourceManager.h>
 #include "SceneObject.h"
-#include <list>
+#include "ParticlePool.h"
 
 namespace Squirrel {
 namespace World { 
@@ -17,7 +17,7 @@ class SQWORLD_API ParticleSystem:
 {
 public:
 
-	static const int MAX_ANIM_COLORS = 5;
+	static const int MAX_ANIM_COLORS = ParticlePool::MAX_ANIM_COLORS;
 
 	enum RenderWay
 	{
@@ -28,16 +28,24 @@ public:
 		//rwGPUBuffer
 	};
 
-	struct Particle
+	struct Stats
 	{
-		vec3 pos;
-		vec3 velocity;
-		vec4 color;
-		float size;
-		float angularVelocity;
-		float angle;
-		float energy;
-		float initialEnergy;
+		Stats() { reset(); }
+
+		void reset()
+		{
+			mParticlesNum		= 0;
+			mEmittedNum			= 0;
+			mDiedNum			= 0;
+			mSortedNum			= 0;
+			mVerticesWritten	= 0;
+		}
+
+		int mParticlesNum;
+		int mEmittedNum;
+		int mDiedNum;
+		int mSortedNum;//particles sorted back to front for blending
+		int mVerticesWritten;
 	};
 
 	ParticleSystem();
@@ -68,10 +76,17 @@ public:
 
 	void setAnimColor(int index, tuple4ub color) { mAnimColors[index] = color; }
 
+	//alpha blended particles are sorted back to front, additive ones are not
+	void setAlphaBlending(bool flag) { mAlphaBlending = flag; }
+
 	void setRotation(bool flag) { mRotation = flag; }
 	void setStartRotation(float degreesPerSecond) { mStartRotation = degreesPerSecond; }
 	void setStartRndRotation(float degreesPerSecond) { mStartRndRotation = degreesPerSecond; }
 
+	int getParticlesNum() const { return mParticles.getCount(); }
+
+	const Stats& getStats() const { return mStats; }
+
 protected:
 
 	virtual void calcAABB();
@@ -80,14 +95,18 @@ private:
 
 	void emitParticle();
 
+	void writeVertices(Render::Camera * camera, const uint32 * order);
+
 	void onTextureNameChaned();
 
 private:
 	//particles buffer
 
-	std::list<Particle> mParticles;
+	ParticlePool mParticles;
 	int mMaxParticlesNum;
 
+	uint32 mRandomSeed;
+
 	//emission params
 
 	bool mEmit;
@@ -121,6 +140,7 @@ private:
 	//render params
 
 	RenderWay mRenderWay;
+	bool mAlphaBlending;
 	Resource::Mesh * mMesh;
 	Resource::Texture * mTexture;
 	Resource::Program * mProgram;
@@ -129,6 +149,8 @@ private:
 
 	std::string mTextureName;
 
+	Stats mStats;
+
 };
 
 
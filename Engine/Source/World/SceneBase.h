@@ -4,6 +4,7 @@
 #include <Math/vec3.h>
 #include <Math/Ray.h>
 #include <Reflection/Object.h>
+#include <Common/StlAllocators.h>
 #include <list>
 
 namespace Squirrel {
@@ -35,14 +36,14 @@ struct RaycastHit
 	int triangleIndex;
 };
 
-typedef std::list<RaycastHit> RAYCASTHITS_LIST;
+typedef std::list<RaycastHit, PoolStlAllocator<RaycastHit> > RAYCASTHITS_LIST;
 
 class SQWORLD_API SceneObjectsContainer: 
 	public Reflection::Object
 {
 public:
 
-	typedef std::list<SceneObject *> SCENE_OBJECTS_LIST;
+	typedef std::list<SceneObject *, PoolStlAllocator<SceneObject *> > SCENE_OBJECTS_LIST;
 
 public:
 	SceneObjectsContainer(void);
@@ -85,8 +85,6 @@ void SceneNode::updateTransform()
 	{
 		SceneObject * obj = (*it);
 		
-		obj->updateTransform();
-		
 		if(!mStaticBounds.intersects(obj->getAllAABB()) || obj->isGlobal())
 		{
 			objsToAdopt.push_back(it);
@@ -1,5 +1,7 @@
 #include "SceneObject.h"
 #include "SceneNode.h"
+#include "CollisionWorld.h"
+#include "BehaviourScheduler.h"
 #include <Resource/TextureStorage.h>
 #include <Resource/ModelStorage.h>
 #include <Resource/AnimationRunner.h>
@@ -29,10 +31,13 @@ SceneObject::SceneObject()
 
 	field = wrapAtomicField("Position", &mLocalPosition.x, 3);
 	field->changeFlag = &mPositionChanged;
+	field->setChangeHandler(this, &SceneObject::markTransformDirty);
 	field = wrapAtomicField("Rotation", &mLocalRotation.x, 4);
 	field->changeFlag = &mRotationChanged;
+	field->setChangeHandler(this, &SceneObject::markTransformDirty);
 	field = wrapAtomicField("Scale",	&mLocalScale.x, 3);
 	field->changeFlag = &mScaleChanged;
+	field->setChangeHandler(this, &SceneObject::markTransformDirty);
 
 	wrapCollectionField<BEHAVIOUR_LIST, Behaviour>("Behaviours", &mBehaviours);
 }
@@ -43,6 +48,11 @@ SceneObject::~SceneObject(void)
 	{
 		DELETE_PTR( (*it) );
 	}
+
+	if(mCollisionWorld != NULL)
+		mCollisionWorld->removeObject(this);
+
+	mTransforms->destroy(mTransformHandle);
 }
 
 void SceneObject::initMembers()
@@ -53,8 +63,16 @@ void SceneObject::initMembers()
 
 	//transform members
 
+	mTransforms			= TransformHierarchy::Active();
+	mTransformHandle	= mTransforms->create(this);
+
 	mTransformChanged	= false;
 
+	mMovedFrame			= 0;
+
+	mCollisionWorld		= NULL;
+	mCollisionProxy		= -1;
+
 	mPositionChanged	= false;
 	mRotationChanged	= false;
 	mScaleChanged		= false;
@@ -67,9 +85,7 @@ void SceneObject::initMembers()
 	mLocalScale			= vec3(1,1,1);
 	//mLocalRotation;
 
-	mTransform.identity();
 	mLocalTransform.identity();
-	mLocalRotationMatrix.identity();
 
 	//hierarchy members
 
@@ -85,10 +101,23 @@ void SceneObject::deserialize(Reflection::Deserializer * deserializer)
 {
 	Object::deserialize(deserializer);
 
+	markTransformDirty();
+
+	//deserialized behaviours are scheduled like added ones
+	for(BEHAVIOUR_LIST::iterator it = mBehaviours.begin(); it != mBehaviours.end(); ++it)
+	{
+		Behaviour * behaviour = (*it);
+		if(behaviour->mScheduler == NULL)
+		{
+			behaviour->mSceneObject = this;
+			BehaviourScheduler::Active()->add(behaviour);
+		}
+	}
+
 	SCENE_OBJECTS_LIST::iterator itChild = mSceneObjects.begin();
 	while(itChild != mSceneObjects.end())
 	{
-		(*itChild)->mParent = this;
+		(*itChild)->attachTransform(mTransforms, this);
 		++itChild;
 	}
 }
@@ -105,26 +134,14 @@ void SceneObject::addBehaviour(Behaviour * behaviour)
 {
 	mBehaviours.push_back(behaviour); 
 	behaviour->mSceneObject = this;
-	behaviour->awake();
+	BehaviourScheduler::Active()->add(behaviour);
 }
 
 void SceneObject::updateRecursively(float dtime)
 {
+	//behaviours are updated by scheduler
 	if(mEnabled)
 	{
-		for(BEHAVIOUR_LIST::iterator it = mBehaviours.begin(); it != mBehaviours.end(); ++it)
-		{
-			Behaviour * behaviour = (*it);
-			if(behaviour->isEnabled())
-			{
-				if(!behaviour->mHasStarted)
-				{
-					behaviour->start();
-					behaviour->mHasStarted = true;
-				}
-				behaviour->update();
-			}
-		}
 		if(mAnimations.get() != NULL)
 		{
 			mAnimations->update(dtime);
@@ -140,6 +157,7 @@ void SceneObject::setLocalPosition(vec3 pos)
 {
 	mLocalPosition = pos;
 	mPositionChanged = true;
+	markTransformDirty();
 }
 
 vec3	SceneObject::getLocalPosition()
@@ -158,6 +176,7 @@ void SceneObject::setPosition(vec3 pos)
 	}
 	mLocalPosition = pos;
 	mPositionChanged = true;
+	markTransformDirty();
 }
 
 vec3	SceneObject::getPosition()		
@@ -192,10 +211,11 @@ void SceneObject::extractLocalTransforms()
 {
 	if(mExtractLocals)
 	{
+		mat3 localRotationMatrix = mLocalTransform.getMat3();
+		localRotationMatrix.orthonormalize();
+
 		mLocalPosition			= mLocalTransform.getTranslate();
-		mLocalRotationMatrix	= mLocalTransform.getMat3();
-		mLocalRotationMatrix.orthonormalize();
-		mLocalRotation			= quat().fromRotationMatrix( mLocalRotationMatrix );
+		mLocalRotation			= quat().fromRotationMatrix( localRotationMatrix );
 		mLocalScale				= mLocalTransform.extractScale();
 
 		mExtractLocals			= false;
@@ -204,90 +224,86 @@ void SceneObject::extractLocalTransforms()
 
 bool SceneObject::updateTransform()
 {
-	//update node transform
-
-	if(mRotationChanged)
-	{
-		mLocalRotationMatrix = mLocalRotation.toRotationMatrix();
-	}
+	//transforms are stored and propagated by hierarchy,
+	//this just brings whole hierarchy up to date immediately
+	return mTransforms->update();
+}
 
-	bool needToUpdateLocalTransform = mRotationChanged || mPositionChanged || mScaleChanged;
+bool SceneObject::fetchLocalTransform(mat4& local)
+{
+	bool trsChanged = mRotationChanged || mPositionChanged || mScaleChanged;
 
-	if(needToUpdateLocalTransform)
+	if(trsChanged)
 	{
-		mLocalTransform = mat4::Transform(mLocalPosition, mLocalRotationMatrix, mLocalScale);
+		mLocalTransform = mat4::Transform(mLocalPosition, mLocalRotation.toRotationMatrix(), mLocalScale);
+		mExtractLocals	= false;
 	}
 
-	bool needToUpdateTransform = needToUpdateLocalTransform || mTransformChanged;
+	bool changed = trsChanged || mTransformChanged;
 
-	if(needToUpdateTransform)
-	{
-		mTransform = mLocalTransform;
-		if(mParent)
-		{
-			mTransform = mParent->mTransform * mTransform;
-		}
-		invalidateChildren();
-	}
+	//reset flags
+	mPositionChanged	= false;
+	mScaleChanged		= false;
+	mRotationChanged	= false;
+	mTransformChanged	= false;
 
-	//update bounding volume
-	calcAABB();
+	local = mLocalTransform;
 
-	bool childTransformChanged = false;
+	return changed;
+}
 
-	//update children as well
+void SceneObject::mergeChildrenBounds()
+{
+	//update AllAABB by combining children AABBs
+	mAllAABB = mAABB;
 	SCENE_OBJECTS_LIST::iterator itChild = mSceneObjects.begin();
 	while(itChild != mSceneObjects.end())
 	{
-		if((*itChild)->updateTransform()) childTransformChanged = true;
+		mAllAABB.merge( (*itChild)->getAllAABB() );
 		++itChild;
 	}
+}
+
+void SceneObject::setTransformPolled(bool polled)
+{
+	mTransforms->setPolled(mTransformHandle, polled);
+}
 
-	//backward recursion logic
+void SceneObject::attachTransform(TransformHierarchy * hierarchy, SceneObject * parent)
+{
+	mParent = parent;
 
-	//if(childTransformChanged)
+	if(hierarchy != mTransforms)
 	{
-		//update AllAABB by combining children AABBs
-		mAllAABB = mAABB;
-		itChild = mSceneObjects.begin();
+		//move to another hierarchy with all children
+		bool polled = mTransforms->isPolled(mTransformHandle);
+
+		mTransforms->destroy(mTransformHandle);
+
+		mTransforms			= hierarchy;
+		mTransformHandle	= mTransforms->create(this);
+		mTransforms->setPolled(mTransformHandle, polled);
+
+		SCENE_OBJECTS_LIST::iterator itChild = mSceneObjects.begin();
 		while(itChild != mSceneObjects.end())
 		{
-			mAllAABB.merge( (*itChild)->getAllAABB() );
+			(*itChild)->attachTransform(hierarchy, this);
 			++itChild;
 		}
 	}
 
-	//reset flags
-	mPositionChanged	= false;
-	mScaleChanged		= false;
-	mRotationChanged	= false;
-	mTransformChanged	= false;
-
-	return needToUpdateTransform || childTransformChanged;
-}
-
-void SceneObject::invalidateChildren()
-{
-	//update children as well
-	SCENE_OBJECTS_LIST::iterator itChild = mSceneObjects.begin();
-	while(itChild != mSceneObjects.end())
-	{
-		(*itChild)->mTransformChanged = true;
-		++itChild;
-	}
+	mTransforms->setParent(mTransformHandle, parent != NULL ? parent->mTransformHandle : TransformHierarchy::INVALID_HANDLE);
 }
 	
 void SceneObject::calcAABB()
 {
-	mAABB.setPoint(getPosition());
+	mAABB.setPoint(getTransform().getTranslate());
 }
 
 void SceneObject::addSceneObject(SceneObject * child)
 {
 	ASSERT( child != NULL );
-	child->mParent		= this;
-
-	child->mTransformChanged	= true;
+	child->attachTransform(mTransforms, this);
 
 	mSceneObjects.push_back(child);
 }
@@ -331,6 +347,17 @@ void SceneObject::renderRecursively(Render::RenderQueue * renderQueue, Render::C
 		render(renderQueue, camera, info);
 	}
 
+	//culling of main camera drives visibility callbacks of behaviours
+	if(camera != NULL && camera == Render::Camera::GetMainCamera())
+	{
+		for(BEHAVIOUR_LIST::iterator it = mBehaviours.begin(); it != mBehaviours.end(); ++it)
+		{
+			BehaviourScheduler * scheduler = (*it)->mScheduler;
+			if(scheduler != NULL)
+				scheduler->setVisible(*it, visible);
+		}
+	}
+
 	SceneObjectsContainer::renderRecursively(renderQueue, camera, info);
 }
 
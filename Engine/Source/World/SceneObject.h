@@ -5,6 +5,7 @@
 #include <Render/IRenderable.h>
 #include "Behaviour.h"
 #include "SceneBase.h"
+#include "TransformHierarchy.h"
 #include "macros.h"
 #include <list>
 #include <memory>
@@ -13,6 +14,7 @@ namespace Squirrel {
 namespace World { 
 
 class SceneNode;
+class CollisionWorld;
 
 using namespace Resource;
 	
@@ -29,6 +31,12 @@ public:
 
 	bool updateTransform();
 
+	void invalidateBounds();
+	void markTransformDirty();
+	void setTransformPolled(bool polled);
+
+	CollisionWorld * getCollisionWorld() { return mCollisionWorld; }
+
 	virtual void addSceneObject(SceneObject * child);
 	virtual bool delSceneObject(SCENE_OBJECTS_LIST::const_iterator it);
 	virtual bool moveSceneObject(SCENE_OBJECTS_LIST::const_iterator it, SceneObjectsContainer * dstParent);
@@ -44,6 +52,13 @@ public:
 
 	virtual bool isInCamera(Render::Camera * camera);
 
+	//renders object itself without culling, for passes which select objects on their own (e.g. shadow casters)
+	void renderUnculled(Render::RenderQueue * renderQueue, Render::Camera * camera, const RenderInfo& info)
+	{
+		if(mEnabled)
+			render(renderQueue, camera, info);
+	}
+
 	virtual void saveSubAnims() {}
 
 	//accessors
@@ -65,9 +80,15 @@ public:
 	quat	getLocalRotation();
 
 	mat4&		getLocalTransform()			{ return mLocalTransform; }
-	const mat4&	getTransform()		const	{ return mTransform; }
+	const mat4&	getTransform()		const	{ return mTransforms->getWorld(mTransformHandle); }
 	const mat4&	getLocalTransform()	const	{ return mLocalTransform; }
 
+	TransformHierarchy *		getTransformHierarchy() const	{ return mTransforms; }
+	TransformHierarchy::HANDLE	getTransformHandle() const		{ return mTransformHandle; }
+
+	//transform frame of world in which subtree of root object was moved last time
+	uint32						getMovedFrame() const			{ return mMovedFrame; }
+
 	BEHAVIOUR_LIST *	getBehaviours()	{ return &mBehaviours; }
 	AnimationRunner *	getAnimations()	{ return mAnimations.get(); }
 
@@ -92,7 +113,10 @@ protected:
 
 	void extractLocalTransforms();
 
-	void invalidateChildren();
+	void attachTransform(TransformHierarchy * hierarchy, SceneObject * parent);
+	bool fetchLocalTransform(mat4& local);
+	void mergeChildrenBounds();
+
 	void initMembers();
 
 	virtual void calcAABB();
@@ -107,6 +131,9 @@ private:
 
 	friend class SceneObjectsContainer;
 	friend class SceneNode;
+	friend class World;
+	friend class TransformHierarchy;
+	friend class CollisionWorld;
 
 	virtual void renderRecursively(Render::RenderQueue * renderQueue, Render::Camera * camera, const RenderInfo& info);
 	virtual void renderCustomRecursively(Render::IRender * render, Render::Camera * camera, const RenderInfo& info);
@@ -134,6 +161,16 @@ protected:
 
 	//transform members
 
+	TransformHierarchy *		mTransforms;
+	TransformHierarchy::HANDLE	mTransformHandle;
+
+	uint32						mMovedFrame;
+
+	//collision members
+
+	CollisionWorld *	mCollisionWorld;
+	int					mCollisionProxy;
+
 	bool				mPositionChanged;
 	bool				mRotationChanged;
 	bool				mScaleChanged;
@@ -144,13 +181,10 @@ protected:
 	vec3				mLocalScale;
 	quat				mLocalRotation;
 
-	mat3				mLocalRotationMatrix;
-
 	vec3				mPosition;
 	vec3				mScale;
 	quat				mRotation;
 
-	mat4				mTransform;
 	mat4				mLocalTransform;
 
 	//hierarchy members
@@ -163,23 +197,36 @@ protected:
 	SceneNode *			mParentNode;
 };
 
+inline void SceneObject::markTransformDirty()
+{
+	mTransforms->markDirty(mTransformHandle);
+}
+
+inline void SceneObject::invalidateBounds()
+{
+	mTransforms->invalidateBounds(mTransformHandle);
+}
+
 inline void SceneObject::setLocalTransform(mat4 tform)
 {
 	mLocalTransform		= tform;
 	mTransformChanged	= true;
 	mExtractLocals		= true;
+	markTransformDirty();
 }
 
 inline void SceneObject::setLocalRotation(quat rot)			
 { 
 	mLocalRotation = rot; 
 	mRotationChanged = true; 
+	markTransformDirty();
 }
 
 inline void SceneObject::setLocalScale(vec3 scale)		
 { 
 	mLocalScale = scale;  
 	mScaleChanged = true; 
+	markTransformDirty();
 }
 
 inline vec3	SceneObject::getLocalScale()		
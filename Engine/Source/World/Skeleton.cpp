@@ -128,7 +128,9 @@ void Skeleton::fetchBones(Resource::Skin * srcSkin, SceneObject * root)
 
 		if(bone == NULL)
 		{
-			Log::Instance().error("Skeleton::fetchBones", (std::string("Can't find bone with name ") + boneName).c_str());
+			//repeats for every instance of broken model
+			static Log::RateLimit sMissingBoneLimit(5);
+			Log::Instance().streamError("Skeleton::fetchBones", sMissingBoneLimit) << "Can't find bone with name " << boneName;
 			continue;
 		}
 	}
@@ -136,12 +138,16 @@ void Skeleton::fetchBones(Resource::Skin * srcSkin, SceneObject * root)
 
 void Skeleton::initVB(VertexBuffer * srcVB)
 {
-	if(sCPUSkinning)
+	//packed vertices are decoded only in shaders so they are always skinned on GPU
+	if(sCPUSkinning && !srcVB->isPacked())
 	{
 		//target vertex buffer
 		Render::IRender * render = Render::IRender::GetActive();
 		mVertexBuffer = render->createVertexBuffer(srcVB->getVertType(), srcVB->getVertsNum()); 
 		mVertexBuffer->setStorageType(VertexBuffer::stGPUDynamicMemory);
+
+		//source vertices are read every frame
+		srcVB->setPinned(true);
 	}
 	else
 	{
@@ -182,7 +188,8 @@ void Skeleton::applyCPUSkinning(VertexBuffer * vb, Resource::Skin * skin)
 		mVertexBuffer->setComponent<VertexBuffer::vcTexcoord>( i,	srcTex );
 	}
 
-	mVertexBuffer->update( 0, mVertexBuffer->getVertsNum() * mVertexBuffer->getVertexSize() );
+	//only skinned vertices are uploaded
+	mVertexBuffer->update( 0, skin->joints.getCount() * mVertexBuffer->getVertexSize() );
 }
 
 }//namespace World { 
@@ -16,9 +16,10 @@ namespace World {
 SQREFL_REGISTER_CLASS_SEED(World::SoundSource, WorldSoundSource);
 
 SoundSource::SoundSource():
-	mSound(NULL), mEmitter(NULL), mPrevPosition(0, 0, 0), mPlayAutomatically(false),
+	mSound(NULL), mEmitter(NULL), mVoice(NULL), mPrevPosition(0, 0, 0), mPlayAutomatically(false),
 	mPitch(1.0f), mGain(1.0f), mLoop(false), mMaxRadius(100), mRefRadius(1), 
-	mConeOuterAngle(360), mConeInnerAngle(360), mConeOuterGain(1), mDirection(0, 0, 0)
+	mConeOuterAngle(360), mConeInnerAngle(360), mConeOuterGain(1), mDirection(0, 0, 0),
+	mPriority(0), mStreamed(false)
 {
 	SQREFL_SET_CLASS(World::SoundSource);
 
@@ -26,21 +27,32 @@ SoundSource::SoundSource():
 	wrapAtomicField("Pitch",			&mPitch);
 	wrapAtomicField("Gain",				&mGain);
 	wrapAtomicField("Loop",				&mLoop);
-	wrapAtomicField("MaxRadius",		&mMaxRadius);
+	Reflection::Object::Field * field = wrapAtomicField("MaxRadius", &mMaxRadius);
+	field->setChangeHandler<SceneObject>(this, &SoundSource::invalidateBounds);
 	wrapAtomicField("RefRadius",		&mRefRadius);
 	wrapAtomicField("ConeOuterAngle",	&mConeOuterAngle);
 	wrapAtomicField("ConeInnerAngle",	&mConeInnerAngle);
 	wrapAtomicField("ConeOuterGain",	&mConeOuterGain);
 	wrapAtomicField("ConeDirection",	&mDirection.x, 3);
+	wrapAtomicField("Priority",			&mPriority);
+	wrapAtomicField("Streamed",			&mStreamed);
 
-	Reflection::Object::Field * field = wrapAtomicField("SoundName",		&mSoundName);
+	field = wrapAtomicField("SoundName",		&mSoundName);
 	field->setChangeHandler(this, &SoundSource::onSoundNameChanged);
 
-	mEmitter = Audio::IAudio::GetActive()->createSource();
+	//mixer shares its sources between all sound sources
+	if(Audio::Mixer::Active() != NULL)
+		mVoice = Audio::Mixer::Active()->createVoice();
+	else
+		mEmitter = Audio::IAudio::GetActive()->createSource();
 }
 
 SoundSource::~SoundSource()
 {
+	if(mVoice != NULL && Audio::Mixer::Active() != NULL)
+	{
+		Audio::Mixer::Active()->destroyVoice(mVoice);
+	}
 	if(mEmitter != NULL)
 	{
 		DELETE_PTR(mEmitter);
@@ -60,7 +72,33 @@ bool SoundSource::setSound(Resource::Sound * sound)
 
 	mSound = sound;
 
-	if(mSound != NULL)
+	if(mSound != NULL && mVoice != NULL)
+	{
+		//sound keeps its data until it is loaded whole, so stream is created first
+		Audio::IStream * stream = mStreamed ? mSound->createStream() : NULL;
+
+		if(stream != NULL)
+		{
+			mVoice->setStream(stream);
+		}
+		else
+		{
+			Audio::IBuffer * buffer = mSound->loadAll();
+
+			if(buffer == NULL)
+				return false;
+
+			mVoice->setBuffer(buffer, mSound->getDuration());
+		}
+
+		mSoundName = mSound->getName();
+
+		if(mPlayAutomatically)
+		{
+			mVoice->play();
+		}
+	}
+	else if(mSound != NULL)
 	{
 		Audio::IBuffer * buffer = mSound->loadAll();
 
@@ -101,6 +139,31 @@ bool SoundSource::isCone() const
 	return mConeInnerAngle < 360.0f && mConeOuterGain < 1.0f;
 }
 
+void SoundSource::play()
+{
+	if(mVoice != NULL)
+		mVoice->play();
+	else if(mEmitter != NULL)
+		mEmitter->play();
+}
+
+void SoundSource::stop()
+{
+	if(mVoice != NULL)
+		mVoice->stop();
+	else if(mEmitter != NULL)
+		mEmitter->stop();
+}
+
+bool SoundSource::isPlaying()
+{
+	if(mVoice != NULL)
+		return mVoice->isPlaying();
+	if(mEmitter != NULL)
+		return mEmitter->getState() == Audio::ISource::PLAYING;
+	return false;
+}
+
 void SoundSource::deserialize(Reflection::Deserializer * deserializer)
 {
 	SceneObject::deserialize(deserializer);
@@ -113,7 +176,31 @@ void SoundSource::deserialize(Reflection::Deserializer * deserializer)
 
 void SoundSource::update(float dtime)
 {
-	if(mEmitter != NULL)
+	if(mVoice != NULL)
+	{
+		//voice keeps parameters and passes only changed ones to source at mixer update
+		vec3 pos = getPosition();
+		vec3 vel = pos - mPrevPosition;
+		mPrevPosition = pos;
+
+		mVoice->setPosition( pos );
+		mVoice->setVelocity( vel );
+
+		mVoice->setPitch(mPitch);
+		mVoice->setGain(mGain);
+		mVoice->setLoop(mLoop);
+		mVoice->setRadius(mMaxRadius, mRefRadius);
+		mVoice->setPriority(mPriority);
+
+		mVoice->setCone(mConeOuterAngle, mConeInnerAngle, mConeOuterGain);
+
+		if(isCone())
+		{
+			vec3 dir = getRotation().apply(mDirection);
+			mVoice->setDirection(dir);
+		}
+	}
+	else if(mEmitter != NULL)
 	{
 		vec3 pos = getPosition();
 		vec3 vel = pos - mPrevPosition;
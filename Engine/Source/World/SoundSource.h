@@ -6,6 +6,7 @@
 #include "SceneObject.h"
 #include <Resource/Sound.h>
 #include <Audio/ISource.h>
+#include <Audio/Mixer.h>
 
 namespace Squirrel {
 namespace World { 
@@ -26,19 +27,29 @@ public:
 
 	bool isCone() const;
 
+	//playback through voice or own source
+	void play();
+	void stop();
+	bool isPlaying();
+
 	//getters
+	//NULL when sound is played by mixer voice
 	const Audio::ISource * getSource	(void) const	{return mEmitter;}
 	Audio::ISource * getSource	(void)	{return mEmitter;}
+	Audio::Mixer::Voice * getVoice	(void)	{return mVoice;}
 
 	//setters
 	bool		setSound(Resource::Sound * sound);
 	bool		setSound(const std::string& snd);
-	void		setMaxRadius(float a)		{ mMaxRadius	= a;}
+	void		setMaxRadius(float a)		{ mMaxRadius	= a; invalidateBounds(); }
 	void		setRefRadius(float a)		{ mRefRadius	= a;}
 	void		setLoop(bool a)				{ mLoop			= a;}
 	void		setDirection(vec3 dir)		{ mDirection	= dir;}
 	void		setPlayAutomatically(bool f){ mPlayAutomatically= f;}
 	void		setPitch(float a)			{ mPitch	= a;}
+	void		setPriority(int a)			{ mPriority	= a;}
+	//streamed sounds are decoded while playing, takes effect with next setSound
+	void		setStreamed(bool f)			{ mStreamed	= f;}
 
 	virtual void deserialize(Reflection::Deserializer * deserializer);
 
@@ -60,6 +71,8 @@ private:
 
 	Audio::ISource * mEmitter;
 
+	Audio::Mixer::Voice * mVoice;
+
 	vec3 mPrevPosition;
 
 	float mPitch;
@@ -75,6 +88,10 @@ private:
 	float mConeInnerAngle;
 	float mConeOuterGain;
 
+	int mPriority;
+
+	bool mStreamed;
+
 	std::string mSoundName;
 };
 
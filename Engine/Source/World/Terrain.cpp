@@ -6,6 +6,10 @@
 #include <Resource/TextureStorage.h>
 #include <Resource/ProgramStorage.h>
 #include <FileSystem/Path.h>
+#include <Common/Profiler.h>
+#include <Common/StlAllocators.h>
+#include <Common/TaskPool.h>
+#include "HeightMapCodec.h"
 #include <iomanip>
 
 #define TERRAIN_SETTINGS_SECTION "Terrain"
@@ -13,6 +17,8 @@
 
 namespace Squirrel {
 namespace World {
+
+static const char_t sProgramName[] = "forward/terrain.glsl";
 	
 HeightGenerator::HeightGenerator():
 	mHMSize(4000, 400, 4000), mHMOffset(-2000, -200, -2000), mNoise(true), mNoiseScale(7, 166, 7)
@@ -129,11 +135,22 @@ Terrain::Terrain()
 		setAsMain();
 	}
 
-	mLodStep = 2;
-	mMaxLod = 4;
+	mLodPatchCells = 16;
+	mLodPixelError = 2.0f;
+	mLodGridSize = 0;
+	memset(&mLodStats, 0, sizeof(mLodStats));
 
 	mProgram = NULL;
 
+	mGenerateMissingNodes = false;
+	mCompressTiles = true;
+
+	mNodesNum = 0;
+	mRevision = 0;
+	memset(&mHMRevisions, 0, sizeof(mHMRevisions));
+
+	mQuery.reset(new TerrainQuery(this));
+
 	memset(&mTextures, 0, sizeof(mTextures));
 	memset(&mBumps, 0, sizeof(mBumps));
 }
@@ -197,10 +214,9 @@ void Terrain::init(Settings * settings, bool autoGenerate)
 	mNodesNum		= settings->getInt(TERRAIN_SETTINGS_SECTION, "Nodes Num", 3);
 	mNodeSize		= settings->getFloat(TERRAIN_SETTINGS_SECTION, "Node Size", 100.0f);
 	mCellsPerNode	= settings->getInt(TERRAIN_SETTINGS_SECTION, "Cells Per Node", 128);
-	mLodStep		= settings->getInt(TERRAIN_SETTINGS_SECTION, "LOD Step", 1);
-	mFirstLodStep	= settings->getInt(TERRAIN_SETTINGS_SECTION, "First LOD Step", 2);
-	mMaxLod			= settings->getInt(TERRAIN_SETTINGS_SECTION, "Max LOD", 4);
-	mStartLod		= settings->getInt(TERRAIN_SETTINGS_SECTION, "Start LOD", 0);
+	mLodPatchCells	= settings->getInt(TERRAIN_SETTINGS_SECTION, "LOD Patch Cells", 16);
+	mLodPixelError	= settings->getFloat(TERRAIN_SETTINGS_SECTION, "LOD Pixel Error", 2.0f);
+	mCompressTiles	= settings->getInt(TERRAIN_SETTINGS_SECTION, "Compress Tiles", 1) != 0;
 
 	if((mGenerateMissingNodes = autoGenerate))
 	{
@@ -227,6 +243,24 @@ void Terrain::init(Settings * settings, bool autoGenerate)
 	setCenter(tuple2i(0, 0));
 }
 
+void Terrain::initGenerated(int nodesNum, float nodeSize, int cellsPerNode, vec3 noiseScale, uint noiseSeed)
+{
+	ASSERT(nodesNum <= MAX_NODES_NUM);
+
+	mContentSource.reset();
+
+	mNodesNum		= nodesNum;
+	mNodeSize		= nodeSize;
+	mCellsPerNode	= cellsPerNode;
+
+	mGenerateMissingNodes		= true;
+	mHeightGen.mNoise			= true;
+	mHeightGen.mNoiseScale		= noiseScale;
+	mHeightGen.mNoiseSeed		= noiseSeed;
+
+	setCenter(tuple2i(0, 0));
+}
+
 void Terrain::render(Render::RenderQueue * renderQueue, Render::Camera * camera, const RenderInfo& info)
 {
 	bool mOneTexture = mTextures[1] == NULL;
@@ -237,16 +271,16 @@ void Terrain::render(Render::RenderQueue * renderQueue, Render::Camera * camera,
 
 	if(info.level >= rilMaterials)
 	{
-		std::stringstream programParams;
+		FrameString programParams;
 
 		if(!mOneTexture)
-			programParams << "FOUR_TEXTURES;";
+			programParams += "FOUR_TEXTURES;";
 
 		matGroup->mTextures["decalMap"]		= mTextures[0]->getRenderTexture();
 		if(lod < sLODGoodForReflections)
 		{
 			matGroup->mTextures["normalHeightMap"]	= mBumps[0]->getRenderTexture();
-			programParams << "BUMP;";
+			programParams += "BUMP;";
 		}
 
 		if(!mOneTexture)
@@ -275,9 +309,9 @@ void Terrain::render(Render::RenderQueue * renderQueue, Render::Camera * camera,
 		float texCoordMult = 1.0f/16;
 		matGroup->mUniformsPool.uniformArray("texCoordMult", 1, &texCoordMult);
 
-		matGroup->mProgramName		= "forward/terrain.glsl";
+		matGroup->mProgramName.setString(sProgramName, sizeof(sProgramName) - 1);
 
-		matGroup->mProgramParams	= programParams.str();
+		matGroup->mProgramParams.setString(programParams.c_str(), programParams.length());
 		
 		//matGroup->mReliefScale	= 0.003f;
 
@@ -303,28 +337,219 @@ void Terrain::render(Render::RenderQueue * renderQueue, Render::Camera * camera,
 
 	matGroup = renderQueue->endMaterialGroup();
 
-	int centerIndex = (mNodesNum - 1) / 2;
+	float viewportHeight = (float)Render::IRender::GetActive()->getViewport().w;
+
+	LodStats stats;
+	selectLod(camera, viewportHeight, mLodPatches, stats);
+
+	if(camera == Render::Camera::GetMainCamera())
+	{
+		mLodStats = stats;
+	}
+
+	for(size_t p = 0; p < mLodPatches.size(); ++p)
+	{
+		const LodPatch& patch = mLodPatches[p];
+		mNodes[patch.nodeI][patch.nodeJ]->renderPatch(matGroup, patch.depth, patch.x, patch.z, getPatchIndexBuffer(patch.stitchMask));
+	}
+}
+
+uint32 Terrain::getRevision()
+{
+	for(int i = 0; i < mNodesNum; ++i)
+	{
+		for(int j = 0; j < mNodesNum; ++j)
+		{
+			HeightMap * hm = mHMs[i][j].get();
+			if(hm != NULL && hm->getRevision() != mHMRevisions[i][j])
+			{
+				mHMRevisions[i][j] = hm->getRevision();
+				++mRevision;
+			}
+		}
+	}
+
+	return mRevision;
+}
+
+TerrainNode * Terrain::getLodNode()
+{
+	TerrainNode * centerNode = getCenterNode();
+	if(centerNode != NULL)
+		return centerNode;
+
+	for(int i = 0; i < mNodesNum; ++i)
+	{
+		for(int j = 0; j < mNodesNum; ++j)
+		{
+			if(mNodes[i][j].get() != NULL)
+				return mNodes[i][j].get();
+		}
+	}
+
+	return NULL;
+}
+
+void Terrain::selectLod(Render::Camera * camera, float viewportHeight, std::vector<LodPatch>& outPatches, LodStats& outStats)
+{
+	SQ_PROFILE_ZONE("Terrain::selectLod");
+
+	outPatches.clear();
+	outStats.patchesNum = 0;
+	outStats.trianglesNum = 0;
+
+	TerrainNode * lodNode = getLodNode();
+	if(lodNode == NULL)
+		return;
 
-	if(mNodes[centerIndex][centerIndex].get() != NULL)
-		mNodes[centerIndex][centerIndex]->render(camera, matGroup);
+	int depthsNum = lodNode->getLodTree()->getDepthsNum();
 
-	for(int i = 0; i <= centerIndex; ++i)
+	//pixels per unit of height error at unit distance
+	float errorToPixels = viewportHeight / (2.0f * tanf(camera->getFov() * 0.5f));
+	if(camera->getType() == Render::Camera::Orthographic)
 	{
-		for(int j = 0; j <= centerIndex; ++j)
+		//distance is ignored, see selectLodNode
+		errorToPixels = viewportHeight / camera->getViewHeight();
+	}
+
+	//grid of finest patches to find depths of neighbours
+
+	mLodGridSize = mNodesNum << (depthsNum - 1);
+	mLodGrid.assign(mLodGridSize * mLodGridSize, -1);
+
+	for(int i = 0; i < mNodesNum; ++i)
+	{
+		for(int j = 0; j < mNodesNum; ++j)
+		{
+			TerrainNode * node = mNodes[i][j].get();
+			if(node != NULL && node->getLodTree()->getDepthsNum() == depthsNum)
+			{
+				selectLodNode(camera, errorToPixels, i, j, 0, 0, 0, outPatches);
+			}
+		}
+	}
+
+	//stitch finer patches to coarser neighbours, every selected node covers whole edge of finer one
+
+	for(size_t p = 0; p < outPatches.size(); ++p)
+	{
+		LodPatch& patch = outPatches[p];
+
+		int cellsNum = 1 << (depthsNum - 1 - patch.depth);
+		int x0 = (patch.nodeI << (depthsNum - 1)) + patch.x * cellsNum;
+		int z0 = (patch.nodeJ << (depthsNum - 1)) + patch.z * cellsNum;
+
+		//first finest patch outside of every edge
+		tuple2i neighbours[TerrainNode::peNum] = {
+			tuple2i(x0 - 1, z0),
+			tuple2i(x0 + cellsNum, z0),
+			tuple2i(x0, z0 - 1),
+			tuple2i(x0, z0 + cellsNum)
+		};
+
+		patch.stitchMask = 0;
+
+		for(int edge = 0; edge < TerrainNode::peNum; ++edge)
 		{
-			if(i == 0 && j == 0)
+			tuple2i cell = neighbours[edge];
+			if(cell.x < 0 || cell.y < 0 || cell.x >= mLodGridSize || cell.y >= mLodGridSize)
 				continue;
 
-			if(mNodes[centerIndex + i][centerIndex + j].get() != NULL && i != 0 && j != 0)
-				mNodes[centerIndex + i][centerIndex + j]->render(camera, matGroup);
-			if(mNodes[centerIndex - i][centerIndex + j].get() != NULL)
-				mNodes[centerIndex - i][centerIndex + j]->render(camera, matGroup);
-			if(mNodes[centerIndex + i][centerIndex - j].get() != NULL)
-				mNodes[centerIndex + i][centerIndex - j]->render(camera, matGroup);
-			if(mNodes[centerIndex - i][centerIndex - j].get() != NULL && i != 0 && j != 0)
-				mNodes[centerIndex - i][centerIndex - j]->render(camera, matGroup);
+			int neighbourDepth = lodGridCell(cell.x, cell.y);
+			if(neighbourDepth >= 0 && neighbourDepth < patch.depth)
+			{
+				patch.stitchMask |= TerrainNode::MakeEdgeStitch(patch.depth - neighbourDepth, (TerrainNode::EPatchEdge)edge);
+			}
 		}
+
+		outStats.trianglesNum += getPatchTrianglesNum(patch.stitchMask);
 	}
+
+	outStats.patchesNum = (int)outPatches.size();
+}
+
+void Terrain::selectLodNode(Render::Camera * camera, float errorToPixels, int i, int j, int depth, int x, int z, std::vector<LodPatch>& outPatches)
+{
+	TerrainNode * node = mNodes[i][j].get();
+	TerrainLodTree * lodTree = node->getLodTree();
+
+	AABB bounds = node->getPatchAABB(depth, x, z);
+
+	bool visible = camera->isAABBIn(bounds);
+
+	//invisible nodes are not split but still get into grid, so visible neighbours may stitch to them
+	bool split = false;
+	if(visible && depth + 1 < lodTree->getDepthsNum())
+	{
+		float error = lodTree->getNode(depth, x, z).error * node->getScale().y;
+
+		float distance = 1.0f;
+		if(camera->getType() != Render::Camera::Orthographic)
+		{
+			vec3 pos = camera->getPosition();
+			distance = (bounds.clampPoint(pos) - pos).len();
+		}
+
+		split = error * errorToPixels > mLodPixelError * distance;
+	}
+
+	if(split)
+	{
+		for(int child = 0; child < 4; ++child)
+		{
+			selectLodNode(camera, errorToPixels, i, j, depth + 1, x * 2 + (child & 1), z * 2 + (child >> 1), outPatches);
+		}
+		return;
+	}
+
+	int depthsNum = lodTree->getDepthsNum();
+	int cellsNum = 1 << (depthsNum - 1 - depth);
+	int x0 = (i << (depthsNum - 1)) + x * cellsNum;
+	int z0 = (j << (depthsNum - 1)) + z * cellsNum;
+
+	for(int cz = z0; cz < z0 + cellsNum; ++cz)
+	{
+		for(int cx = x0; cx < x0 + cellsNum; ++cx)
+		{
+			lodGridCell(cx, cz) = depth;
+		}
+	}
+
+	if(visible)
+	{
+		LodPatch patch;
+		patch.nodeI = i;
+		patch.nodeJ = j;
+		patch.depth = depth;
+		patch.x = x;
+		patch.z = z;
+		patch.stitchMask = 0;
+		outPatches.push_back(patch);
+	}
+}
+
+int Terrain::getPatchTrianglesNum(uint32 stitchMask)
+{
+	std::map<uint32, int>::iterator it = mPatchTrianglesNum.find(stitchMask);
+	if(it != mPatchTrianglesNum.end())
+		return it->second;
+
+	std::vector<uint32> indices;
+	TerrainNode::GenPatchIndices(getLodNode()->getLodTree()->getPatchCells(), stitchMask, indices);
+
+	int trianglesNum = (int)indices.size() / 3;
+	mPatchTrianglesNum[stitchMask] = trianglesNum;
+	return trianglesNum;
+}
+
+RenderData::IndexBuffer * Terrain::getPatchIndexBuffer(uint32 stitchMask)
+{
+	IB_PTR& ib = mPatchIndexBuffers[stitchMask];
+	if(ib.get() == NULL)
+	{
+		ib.reset( TerrainNode::GenPatchIndexBuffer(getLodNode()->getLodTree()->getPatchCells(), stitchMask) );
+	}
+	return ib.get();
 }
 	
 std::string Terrain::createHMFileName(tuple2i nodePos)
@@ -349,20 +574,16 @@ std::string Terrain::createHMFileName(tuple2i nodePos)
 	return fileNameStr.str();
 }	
 
-HeightMap * Terrain::loadHM(tuple2i gridPos)
+HeightMap * Terrain::decodeHM(tuple2i gridPos, Data * data)
 {
-	std::string fileName = createHMFileName(gridPos);
-	
-	vec3 scale = vec3(getCellSize(), 1.0f, getCellSize());
-	
-	Data * data = mContentSource->getMappedFile(fileName);
-	
 	HeightMap * hm = NULL;
 	
 	if(data == NULL)
 	{
 		if(mGenerateMissingNodes)
 		{
+			vec3 scale = vec3(getCellSize(), 1.0f, getCellSize());
+
 			hm = new HeightMap(mCellsPerNode + 1, mCellsPerNode + 1);
 			
 			hm->clear();
@@ -374,6 +595,12 @@ HeightMap * Terrain::loadHM(tuple2i gridPos)
 			hm->updateNormals();
 		}
 	}
+	else if(HeightMapCodec::IsCompressed(data))
+	{
+		//decoded straight from mapped file
+		hm = HeightMapCodec::Load(data);
+		delete data;
+	}
 	else
 	{
 		bool mapped = false;
@@ -388,32 +615,56 @@ HeightMap * Terrain::loadHM(tuple2i gridPos)
 		}
 	}
 	
+	//pyramid (unless it was loaded) is built here too, so it is done by workers
+	if(hm != NULL)
+		hm->getPyramid();
+
 	return hm;
 }
 
-RenderData::IndexBuffer * Terrain::getIndexBuffer(int size, tuple2i glue)
+TerrainLodTree * Terrain::buildLodTree(const HeightMap * hm)
 {
-	RenderData::IndexBuffer * ib = NULL;
+	TerrainLodTree * lodTree = new TerrainLodTree();
+	if(!lodTree->build(hm, mLodPatchCells))
+	{
+		DELETE_PTR(lodTree);
+	}
+	return lodTree;
+}
 
-	int key = log((double)size - 1) / log( 2.0 );
+void Terrain::DecodeHMs(void * context, int begin, int end)
+{
+	SQ_PROFILE_ZONE("Terrain::DecodeHMs");
 
-	int xGlueIndex = glue.x + 1;
-	int yGlueIndex = glue.y + 1;
+	std::pair<Terrain *, std::vector<TileLoad> *> * job = (std::pair<Terrain *, std::vector<TileLoad> *> *)context;
 
-	if(mIndexBuffers[key][xGlueIndex][yGlueIndex].get())
+	for(int i = begin; i < end; ++i)
 	{
-		ib = mIndexBuffers[key][xGlueIndex][yGlueIndex].get();
+		TileLoad& tile = (*job->second)[i];
+		tile.hm = job->first->decodeHM(tile.gridPos, tile.data);
+		if(tile.hm != NULL)
+			tile.lodTree = job->first->buildLodTree(tile.hm);
 	}
-	else
+}
+
+void Terrain::loadHMs(std::vector<TileLoad>& tiles)
+{
+	SQ_PROFILE_ZONE("Terrain::loadHMs");
+
+	//files are mapped here, decoding and generation run on workers
+
+	for(size_t i = 0; i < tiles.size(); ++i)
 	{
-		ib = TerrainNode::GenIndexBuffer(tuple2i(size, size), glue);
-		mIndexBuffers[key][xGlueIndex][yGlueIndex].reset(ib);
+		tiles[i].data = mContentSource.get() != NULL ? mContentSource->getMappedFile(createHMFileName(tiles[i].gridPos)) : NULL;
+		tiles[i].hm = NULL;
+		tiles[i].lodTree = NULL;
 	}
 
-	return ib;
+	std::pair<Terrain *, std::vector<TileLoad> *> job(this, &tiles);
+	TaskPool::Default()->parallelFor((int)tiles.size(), 1, &DecodeHMs, &job);
 }
 
-TerrainNode * Terrain::makeNode(HeightMap * hm, tuple2i gridPos, int lod)
+TerrainNode * Terrain::makeNode(HeightMap * hm, TerrainLodTree * lodTree, tuple2i gridPos)
 {
 	TerrainNode * node = NULL;
 
@@ -423,7 +674,7 @@ TerrainNode * Terrain::makeNode(HeightMap * hm, tuple2i gridPos, int lod)
 	{
 		node = new TerrainNode();
 		node->setScale(scale);
-		node->init(NULL, hm, lod);
+		node->init(hm, lodTree, mLodPatchCells);
 		node->setGridPos(gridPos);
 	}
 	
@@ -432,6 +683,9 @@ TerrainNode * Terrain::makeNode(HeightMap * hm, tuple2i gridPos, int lod)
 	
 void Terrain::saveUnsavedNodes()
 {
+	if(mContentSource.get() == NULL)
+		return;
+
 	int i, j;//indices
 	
 	for(i = 0; i < mNodesNum; ++i)
@@ -445,8 +699,11 @@ void Terrain::saveUnsavedNodes()
 				
 				if(!mContentSource->hasFile(fileName))
 				{
-					Data * data = node->getHeightMap()->save();
+					Data * data = mCompressTiles ? 
+						HeightMapCodec::Save(node->getHeightMap()) : 
+						node->getHeightMap()->save();
 					mContentSource->putFile(data, fileName);
+					delete data;
 				}
 			}
 		}
@@ -462,6 +719,15 @@ vec3 Terrain::getOffsetForNodeIndex(int x, int z)
 	return offset;
 }
 
+vec3 Terrain::getGridOrigin() const
+{
+	int centerIndex = (mNodesNum - 1) / 2;
+	vec3 offset(mCenterNodePos.x - centerIndex, 0, mCenterNodePos.y - centerIndex);
+	offset -= vec3(0.5f, 0, 0.5f);
+	offset *= mNodeSize;
+	return offset;
+}
+
 vec3 Terrain::getGlobalOffsetForNodePos(int x, int z)
 {
 	vec3 offset(x, 0, z);
@@ -470,19 +736,10 @@ vec3 Terrain::getGlobalOffsetForNodePos(int x, int z)
 	return offset;
 }
 	
-int Terrain::lodForIndex(int i, int j)
-{
-	i = Math::clamp(i, 0, mNodesNum - 1);
-	j = Math::clamp(j, 0, mNodesNum - 1);
-
-	int centerIndex = (mNodesNum - 1) / 2;
-	int distanceFromCenter = Math::maxValue( Math::absValue(centerIndex - i), Math::absValue(centerIndex - j) );
-	int lod = Math::maxValue( Math::minValue( (distanceFromCenter - mFirstLodStep) / mLodStep + 1, mMaxLod ), 0 ) + mStartLod;
-	return lod;
-}
-
 void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 {
+	SQ_PROFILE_ZONE("Terrain::setCenter");
+
 	mCenterNodePos = newCenterNodePos;
 	
 	mBoundVolume.reset();
@@ -491,10 +748,12 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 	
 	//store existing nodes
 	
-	typedef std::map<tuple3i, TerrainNode *> NODES_MAP;
+	typedef std::map<tuple2i, TerrainNode *> NODES_MAP;
 	typedef std::map<tuple2i, HeightMap *> HMS_MAP;
+	typedef std::map<tuple2i, TerrainLodTree *> LOD_TREES_MAP;
 	NODES_MAP loadedNodes;
 	HMS_MAP loadedHMs;
+	LOD_TREES_MAP loadedLodTrees;
 	
 	int x, z;//gridPos
 	int i, j;//indices
@@ -506,7 +765,7 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 			TerrainNode * node = mNodes[i][j].release();
 			if(node != NULL)
 			{
-				loadedNodes[tuple3i(node->getGridPos(), node->getLOD())] = node;
+				loadedNodes[node->getGridPos()] = node;
 
 				HeightMap * hm = mHMs[i][j].release();
 				if(hm != NULL)
@@ -522,34 +781,42 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 	int centerIndex = (mNodesNum - 1) / 2;
 	
 	tuple2i startNodePos = tuple2i(newCenterNodePos.x - centerIndex, newCenterNodePos.y - centerIndex);
-	
+
+	//load all missing hms at once so they are decoded (and their lod trees are built) in parallel
+
+	std::vector<TileLoad> tiles;
 	for(x = startNodePos.x, i = 0; i < mNodesNum; ++x, ++i)
 	{
 		for(z = startNodePos.y, j = 0; j < mNodesNum; ++z, ++j)
 		{
-			int lod = lodForIndex(i, j);
+			if(loadedHMs.find(tuple2i(x, z)) == loadedHMs.end())
+			{
+				TileLoad tile;
+				tile.gridPos = tuple2i(x, z);
+				tiles.push_back(tile);
+			}
+		}
+	}
 
-			tuple2i glue(0, 0);
+	loadHMs(tiles);
 
-			int lod_ip1j0 = lodForIndex(i + 1, j);
-			int lod_im1j0 = lodForIndex(i - 1, j);
-			int lod_i0jp1 = lodForIndex(i, j + 1);
-			int lod_i0jm1 = lodForIndex(i, j - 1);
-			
-			if(lod_ip1j0 > lod)
-				glue.x = 1;
-			if(lod_im1j0 > lod)
-				glue.x = -1;
-			if(lod_i0jp1 > lod)
-				glue.y = 1;
-			if(lod_i0jm1 > lod)
-				glue.y = -1;
-			
+	for(size_t t = 0; t < tiles.size(); ++t)
+	{
+		if(tiles[t].hm != NULL)
+			loadedHMs[tiles[t].gridPos] = tiles[t].hm;
+		if(tiles[t].lodTree != NULL)
+			loadedLodTrees[tiles[t].gridPos] = tiles[t].lodTree;
+	}
+	
+	for(x = startNodePos.x, i = 0; i < mNodesNum; ++x, ++i)
+	{
+		for(z = startNodePos.y, j = 0; j < mNodesNum; ++z, ++j)
+		{
 			tuple2i hmPos(x, z);
-			tuple3i nodePos(hmPos, lod);
 			
 			TerrainNode * node = NULL;
 			HeightMap * hm = NULL;
+			TerrainLodTree * lodTree = NULL;
 
 			HMS_MAP::iterator itHM = loadedHMs.find(hmPos);
 			if(itHM != loadedHMs.end())
@@ -557,15 +824,18 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 				hm = itHM->second;
 				loadedHMs.erase(itHM);
 			}
-			
-			if(hm == NULL)
-			{
-				hm = loadHM(hmPos);
-			}
 
 			mHMs[i][j].reset(hm);
+			mHMRevisions[i][j] = hm != NULL ? hm->getRevision() : 0;
+
+			LOD_TREES_MAP::iterator itLodTree = loadedLodTrees.find(hmPos);
+			if(itLodTree != loadedLodTrees.end())
+			{
+				lodTree = itLodTree->second;
+				loadedLodTrees.erase(itLodTree);
+			}
 
-			NODES_MAP::iterator itLoaded = loadedNodes.find(nodePos);
+			NODES_MAP::iterator itLoaded = loadedNodes.find(hmPos);
 			if(itLoaded != loadedNodes.end())
 			{
 				node = itLoaded->second;
@@ -574,16 +844,14 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 			
 			if(node == NULL && hm != NULL)
 			{
-				node = makeNode(hm, hmPos, lod);
+				node = makeNode(hm, lodTree, hmPos);
+				lodTree = NULL;
 			}
+
+			DELETE_PTR(lodTree);
 			
 			if(node != NULL)
 			{
-				int lodPow2 = 1 << lod;
-				int ibSize = mCellsPerNode / lodPow2 + 1;
-				RenderData::IndexBuffer * ib = getIndexBuffer(ibSize, glue);
-				node->setIndexBuffer(ib);
-
 				vec3 offset = getGlobalOffsetForNodePos(x, z);
 				node->setOffset( offset );
 				
@@ -594,7 +862,9 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 		}
 	}
 	
-	//remove unused nodes and hms
+	++mRevision;
+
+	//remove unused nodes, hms and lod trees
 	
 	FOREACH(NODES_MAP::iterator, itNode, loadedNodes)
 	{
@@ -604,6 +874,10 @@ void Terrain::setCenter(Squirrel::tuple2i newCenterNodePos)
 	{
 		DELETE_PTR(itHM->second);
 	}
+	FOREACH(LOD_TREES_MAP::iterator, itLodTree, loadedLodTrees)
+	{
+		DELETE_PTR(itLodTree->second);
+	}
 }
 	
 tuple2i Terrain::getNextNodePos(vec3 beholderPos)
@@ -628,32 +902,9 @@ tuple2i Terrain::getNextNodePos(vec3 beholderPos)
 
 float Terrain::height(float x, float z)
 {
-	const float correctionOffset = 0.1f;
-	
-	int centerIndex = (mNodesNum - 1) / 2;
-
-	vec3 startPos = getGlobalOffsetForNodePos(mCenterNodePos.x, mCenterNodePos.y);
-	
-	float relX = x - startPos.x;
-	float relZ = z - startPos.z;
-	
-	int i = centerIndex + (int)(relX / mNodeSize);
-	int j = centerIndex + (int)(relZ / mNodeSize);
-	
-	i = Math::clamp(i, 0, mNodesNum);
-	j = Math::clamp(j, 0, mNodesNum);
-	
-	TerrainNode * node = mNodes[i][j].get();
-	
-	if(node == NULL)
-		return 0.0f;
-	
-	AABB aabb = node->getTransformedAABB();
-	
-	x = Math::clamp(x, aabb.min.x + correctionOffset, aabb.max.x - correctionOffset);
-	z = Math::clamp(z, aabb.min.z + correctionOffset, aabb.max.z - correctionOffset);	
-		
-	return node->height(x, z);
+	float h = 0.0f;
+	mQuery->height(x, z, h);
+	return h;
 }
 
 }//namespace World {
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "TerrainNode.h"
+#include "TerrainQuery.h"
 #include <FileSystem/FileStorageFactory.h>
 #include <Common/DataMap.h>
 #include <Math/PerlinNoise.h>
 #include <Common/Settings.h>
 #include <Resource/Program.h>
 #include <memory>
+#include <vector>
+#include <map>
 #include "Renderable.h"
 
 namespace Squirrel {
@@ -58,6 +61,23 @@ public:
 		dirNum
 	};
 
+	//LOD tree node of tile selected for rendering
+	struct LodPatch
+	{
+		int		nodeI;//tile index
+		int		nodeJ;
+		int		depth;
+		int		x;
+		int		z;
+		uint32	stitchMask;//see TerrainNode::GetEdgeStitch
+	};
+
+	struct LodStats
+	{
+		int		patchesNum;
+		int		trianglesNum;
+	};
+
 public://ctor/dtor
 	
 	Terrain();
@@ -69,7 +89,21 @@ public://methods
 
 	void initTextures(const char_t * texture1Name, const char_t * texture2Name = NULL, const char_t * texture3Name = NULL, const char_t * texture4Name = NULL);
 	void init(Settings * settings, bool autoGenerate = false);
+
+	//nodesNum x nodesNum tiles of Perlin noise which are neither loaded nor saved, without render resources
+	//(for tools and benchmarks)
+	void initGenerated(int nodesNum, float nodeSize, int cellsPerNode, vec3 noiseScale, uint noiseSeed);
 	void render(Render::RenderQueue * renderQueue, Render::Camera * camera, const RenderInfo& info);
+
+	//CPU part of rendering: selects LOD tree nodes of visible tiles which geometric error
+	//projected to screen is below LOD pixel error, and stitches edges of finer ones to coarser neighbours
+	void selectLod(Render::Camera * camera, float viewportHeight, std::vector<LodPatch>& outPatches, LodStats& outStats);
+
+	//of last rendering with main camera
+	const LodStats& getLodStats() const { return mLodStats; }
+
+	float getLodPixelError() const { return mLodPixelError; }
+	void setLodPixelError(float pixels) { mLodPixelError = pixels; }
 	
 	tuple2i getNextNodePos(vec3 beholderPos);
 	
@@ -86,6 +120,14 @@ public://methods
 	size_t getCellsPerNode()	const { return mCellsPerNode; }
 	tuple2i getCenterNodePos()	const { return mCenterNodePos; }
 
+	//changes when tiles are loaded or unloaded and when heights of loaded tiles are edited
+	uint32 getRevision();
+
+	//min corner of node [0][0]
+	vec3 getGridOrigin() const;
+
+	TerrainQuery * getQuery() { return mQuery.get(); }
+
 	AABB getBounds() 
 	{ 
 		AABB bounds;
@@ -110,35 +152,60 @@ private://methods
 		int centerIndex = (mNodesNum - 1) / 2;
 		return mNodes[centerIndex][centerIndex].get();
 	}
+
+	//node which LOD tree gives depths and patch cells of all nodes, central one unless it is missing
+	TerrainNode* getLodNode();
 	
-	HeightMap * loadHM(tuple2i gridPos);
-	TerrainNode * makeNode(HeightMap * hm, tuple2i gridPos, int lod);
+	struct TileLoad
+	{
+		tuple2i		gridPos;
+		Data *		data;//mapped file, NULL if tile is missing
+		HeightMap *	hm;
+		TerrainLodTree * lodTree;
+	};
+
+	//decodes (or generates missing) tile, called by worker threads
+	HeightMap * decodeHM(tuple2i gridPos, Data * data);
+	TerrainLodTree * buildLodTree(const HeightMap * hm);
+	void loadHMs(std::vector<TileLoad>& tiles);
+	static void DecodeHMs(void * context, int begin, int end);
+	TerrainNode * makeNode(HeightMap * hm, TerrainLodTree * lodTree, tuple2i gridPos);
 	
 	std::string createHMFileName(tuple2i gridPos);
 	
 	vec3 getOffsetForNodeIndex(int x, int z);
 	vec3 getGlobalOffsetForNodePos(int x, int z);
 
-	int lodForIndex(int i, int j);
+	void selectLodNode(Render::Camera * camera, float errorToPixels, int i, int j, int depth, int x, int z, std::vector<LodPatch>& outPatches);
+
+	//depth of selected node of every finest patch of grid, -1 where there is no tile
+	inline int & lodGridCell(int x, int z) { return mLodGrid[x + z * mLodGridSize]; }
 
-	RenderData::IndexBuffer * getIndexBuffer(int size, tuple2i glue = tuple2i(0,0));
+	int getPatchTrianglesNum(uint32 stitchMask);
+	RenderData::IndexBuffer * getPatchIndexBuffer(uint32 stitchMask);
 	
 private://members
 
 	typedef std::shared_ptr<RenderData::IndexBuffer> IB_PTR;
 
-	int mStartLod;
-	int mFirstLodStep;
-	int mLodStep;
-	int mMaxLod;
+	int mLodPatchCells;
+	float mLodPixelError;
+	LodStats mLodStats;
+
+	std::vector<int> mLodGrid;
+	int mLodGridSize;
+	std::vector<LodPatch> mLodPatches;
 	
 	static const int MAX_NODES_NUM = 41;
 	std::auto_ptr<TerrainNode>	mNodes[MAX_NODES_NUM][MAX_NODES_NUM];
 	std::auto_ptr<HeightMap>	mHMs[MAX_NODES_NUM][MAX_NODES_NUM];
+	uint32						mHMRevisions[MAX_NODES_NUM][MAX_NODES_NUM];//last seen by getRevision
+	uint32						mRevision;
 	
 	tuple2i mCenterNodePos;
 	
 	bool mGenerateMissingNodes;
+	bool mCompressTiles;//new tiles are saved in compressed format
 
 	static const int MAX_TEXTURES_PER_NODE = TerrainNode::MAX_TEXTURES_PER_NODE;
 	Resource::Texture * mTextures[MAX_TEXTURES_PER_NODE];
@@ -149,9 +216,9 @@ private://members
 	
 	std::auto_ptr<FileSystem::FileStorage> mContentSource;
 	
-	static const int MAX_HM_SIZE_LOG2 = 10;
-	static const int GLUE_AMPLITUDE = 3;
-	IB_PTR mIndexBuffers[MAX_HM_SIZE_LOG2][GLUE_AMPLITUDE][GLUE_AMPLITUDE];
+	//by stitch mask
+	std::map<uint32, IB_PTR> mPatchIndexBuffers;
+	std::map<uint32, int> mPatchTrianglesNum;
 	
 	AABB mBoundVolume;
 	
@@ -161,6 +228,8 @@ private://members
 
 	Resource::Program * mProgram;
 
+	std::auto_ptr<TerrainQuery> mQuery;
+
 	static Terrain * sMain;
 };
 
@@ -0,0 +1,185 @@
+#include "TerrainLodTree.h"
+#include "HeightMap.h"
+#include <Render/IRender.h>
+#include <float.h>
+
+namespace Squirrel {
+namespace World {
+
+using RenderData::VertexBuffer;
+
+TerrainLodTree::TerrainLodTree():
+	mPatchCells(0)
+{
+}
+
+TerrainLodTree::~TerrainLodTree()
+{
+	clear();
+}
+
+void TerrainLodTree::clear()
+{
+	for(size_t depth = 0; depth < mLevels.size(); ++depth)
+	{
+		for(size_t i = 0; i < mLevels[depth].size(); ++i)
+		{
+			DELETE_PTR(mLevels[depth][i].vb);
+		}
+	}
+	mLevels.clear();
+}
+
+bool TerrainLodTree::build(const HeightMap * hm, int patchCells)
+{
+	clear();
+
+	tuple2i res = hm->getResolution();
+	int tileCells = res.x - 1;
+	if(tileCells < 1 || res.x != res.y || patchCells < 1)
+		return false;
+
+	//tile has to be split to patches by halving
+	int depthsNum = 1;
+	if(tileCells % patchCells == 0)
+	{
+		int patchesNum = tileCells / patchCells;
+		while((1 << (depthsNum - 1)) < patchesNum)
+		{
+			++depthsNum;
+		}
+		if((1 << (depthsNum - 1)) != patchesNum)
+			depthsNum = 1;
+	}
+
+	if(depthsNum == 1)
+	{
+		patchCells = tileCells;
+	}
+
+	//finer neighbour snaps its edge to coarser one, so one coarse step has to fit into half of patch
+	while(depthsNum > 1 && (1 << depthsNum) > patchCells)
+	{
+		patchCells *= 2;
+		--depthsNum;
+	}
+
+	mPatchCells = patchCells;
+
+	mLevels.resize(depthsNum);
+	for(int depth = depthsNum - 1; depth >= 0; --depth)
+	{
+		int nodesNum = getNodesNum(depth);
+		mLevels[depth].resize(nodesNum * nodesNum);
+
+		for(int z = 0; z < nodesNum; ++z)
+		{
+			for(int x = 0; x < nodesNum; ++x)
+			{
+				buildNode(hm, depth, x, z);
+			}
+		}
+	}
+
+	return true;
+}
+
+void TerrainLodTree::buildNode(const HeightMap * hm, int depth, int x, int z)
+{
+	Node& node = mLevels[depth][x + z * getNodesNum(depth)];
+	node.vb = NULL;
+
+	int step = getNodeStep(depth);
+	int cells = getNodeCells(depth);
+	int x0 = x * cells;
+	int z0 = z * cells;
+
+	float error = 0;
+	float minHeight = FLT_MAX;
+	float maxHeight = -FLT_MAX;
+
+	for(int tz = 0; tz <= cells; ++tz)
+	{
+		int gz = tz / step;
+		float fz = (float)(tz - gz * step) / step;
+		int gz1 = Math::minValue(gz + 1, mPatchCells);
+
+		for(int tx = 0; tx <= cells; ++tx)
+		{
+			int gx = tx / step;
+			float fx = (float)(tx - gx * step) / step;
+			int gx1 = Math::minValue(gx + 1, mPatchCells);
+
+			float h = hm->height(x0 + tx, z0 + tz);
+			minHeight = Math::minValue(minHeight, h);
+			maxHeight = Math::maxValue(maxHeight, h);
+
+			if(step == 1)
+				continue;
+
+			//height of node grid
+			float h00 = hm->height(x0 + gx * step, z0 + gz * step);
+			float h10 = hm->height(x0 + gx1 * step, z0 + gz * step);
+			float h01 = hm->height(x0 + gx * step, z0 + gz1 * step);
+			float h11 = hm->height(x0 + gx1 * step, z0 + gz1 * step);
+			float gridHeight = Math::lerp(Math::lerp(h00, h10, fx), Math::lerp(h01, h11, fx), fz);
+
+			error = Math::maxValue(error, Math::absValue(h - gridHeight));
+		}
+	}
+
+	//children are built before parents
+	if(depth + 1 < getDepthsNum())
+	{
+		for(int i = 0; i < 4; ++i)
+		{
+			error = Math::maxValue(error, getNode(depth + 1, x * 2 + (i & 1), z * 2 + (i >> 1)).error);
+		}
+	}
+
+	node.error = error;
+	node.minHeight = minHeight;
+	node.maxHeight = maxHeight;
+}
+
+VertexBuffer * TerrainLodTree::getVertexBuffer(const HeightMap * hm, int depth, int x, int z)
+{
+	Node& node = mLevels[depth][x + z * getNodesNum(depth)];
+	if(node.vb != NULL)
+		return node.vb;
+
+	int step = getNodeStep(depth);
+	int cells = getNodeCells(depth);
+	int x0 = x * cells;
+	int z0 = z * cells;
+
+	int vertsPerSide = mPatchCells + 1;
+
+	//position, packedNormal...
+	int terrainVertexType =	(VCI2VT(VertexBuffer::vcPosition) |
+							 VCI2VT(VertexBuffer::vcInt8Normal));
+
+	node.vb = Render::IRender::GetActive()->createVertexBuffer(terrainVertexType, vertsPerSide * vertsPerSide);
+	node.vb->setStorageType(VertexBuffer::stGPUStaticMemory);
+
+	int vertexIndex = 0;
+	for(int i = 0; i < vertsPerSide; ++i)
+	{
+		for(int j = 0; j < vertsPerSide; ++j)
+		{
+			int tx = x0 + i * step;
+			int tz = z0 + j * step;
+
+			Math::vec3 vertPos((float)tx, hm->height(tx, tz), (float)tz);
+			node.vb->setComponent<VertexBuffer::vcPosition>(vertexIndex, vertPos);
+			node.vb->setComponent<VertexBuffer::vcInt8Normal>(vertexIndex, hm->normal(tx, tz));
+
+			++vertexIndex;
+		}
+	}
+
+	return node.vb;
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <common/common.h>
+#include <Render/VertexBuffer.h>
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+namespace World {
+
+class HeightMap;
+
+//Quadtree of patches of terrain tile for screen space error driven LOD.
+//Every node covers square of tile cells and is drawn as grid of patchCells x patchCells quads
+//sampling height map with step of node size / patchCells, so depth 0 (whole tile) is coarsest
+//and deepest nodes sample every texel. Geometric error of node is max height difference between
+//height map and node grid, it never is less than errors of node children.
+class SQWORLD_API TerrainLodTree
+{
+public:
+
+	struct Node
+	{
+		float	error;
+		float	minHeight;
+		float	maxHeight;
+		RenderData::VertexBuffer * vb;//created on first render
+	};
+
+public://ctor/dtor
+	TerrainLodTree();
+	~TerrainLodTree();
+
+public://methods
+
+	//touches only height map and tree, so it can run on worker threads;
+	//patch cells are raised if needed so neighbour depths never differ more than patch can stitch
+	bool build(const HeightMap * hm, int patchCells);
+
+	inline bool	isEmpty()			const	{ return mLevels.empty(); }
+	inline int	getDepthsNum()		const	{ return (int)mLevels.size(); }
+	inline int	getPatchCells()		const	{ return mPatchCells; }
+	inline int	getNodesNum(int depth)	const	{ return 1 << depth; }//along one side
+	inline int	getNodeCells(int depth)	const	{ return mPatchCells << (getDepthsNum() - 1 - depth); }
+	inline int	getNodeStep(int depth)	const	{ return 1 << (getDepthsNum() - 1 - depth); }
+
+	inline const Node& getNode(int depth, int x, int z) const { return mLevels[depth][x + z * getNodesNum(depth)]; }
+
+	//grid of node in tile space, main thread only
+	RenderData::VertexBuffer * getVertexBuffer(const HeightMap * hm, int depth, int x, int z);
+
+	void clear();
+
+private:
+
+	void buildNode(const HeightMap * hm, int depth, int x, int z);
+
+private:
+
+	int mPatchCells;
+
+	std::vector< std::vector<Node> > mLevels;
+};
+
+}//namespace World {
+}//namespace Squirrel {
@@ -16,178 +16,147 @@ TerrainNode::TerrainNode()
 	mOffset = vec3::Zero();
 	mScale = vec3::One();
 	mHeightMap = NULL;
-
-	mVB = NULL;
-	mIB = NULL;
-	mIBOwner = false;
 	
 	mGridPos = tuple2i(0, 0);
 }
 
 TerrainNode::~TerrainNode()
 {
-	DELETE_PTR( mVB );
-	if(mIBOwner)
-		DELETE_PTR( mIB );
 }
 
 using RenderData::VertexBuffer;
 using RenderData::IndexBuffer;
 
-void TerrainNode::init(RenderData::IndexBuffer * ib, HeightMap *	heightMap, int lod)
+namespace {
+
+//edge vertices go to nearest corner side, so cells at both ends of edge keep their orientation;
+//middle of patch edge is vertex of any neighbour stitch allows
+inline int SnapEdgeVertex(int index, uint32 stitch, int patchCells)
 {
-	mLod = lod;
+	if(index * 2 < patchCells)
+		return (index >> stitch) << stitch;
+	return ((index + (1 << stitch) - 1) >> stitch) << stitch;
+}
 
-	tuple2i hmSize = heightMap->getResolution();
+}//namespace {
 
-	int lodPow2 = 1 << lod;
-	hmSize = (hmSize - 1) / lodPow2 + 1;
-	
-	//gen vertex buffer
-	
-	mVB = GenVertexBuffer(hmSize);
-	mVB->setStorageType(VertexBuffer::stGPUStaticMemory);
-	
-	applyHeightMap(heightMap, lod);
+void TerrainNode::init(HeightMap * heightMap, TerrainLodTree * lodTree, int patchCells)
+{
+	mHeightMap = heightMap;
 
-	if(ib == NULL)
+	if(lodTree == NULL)
 	{
-		mIB = NULL;
-		mIBOwner = false;
+		lodTree = new TerrainLodTree();
+		lodTree->build(heightMap, patchCells);
 	}
-	else
+	mLodTree.reset(lodTree);
+
+	mBoundVolume.reset();
+
+	//bounds of full resolution map contain every patch
+	tuple2i hmSize = heightMap->getResolution();
+	const HeightMapPyramid * pyramid = heightMap->getPyramid();
+	if(!pyramid->isEmpty())
 	{
-		mIB = ib;
-		mIBOwner = false;
+		mBoundVolume.addVertex( vec3(0, pyramid->getMin(), 0) );
+		mBoundVolume.addVertex( vec3((float)(hmSize.x - 1), pyramid->getMax(), (float)(hmSize.y - 1)) );
 	}
-}
 	
-RenderData::IndexBuffer * TerrainNode::GenIndexBuffer(tuple2i size, tuple2i glue)
+	mUpdateBoundVolume = true;
+}
+
+void TerrainNode::GenPatchIndices(int patchCells, uint32 stitchMask, std::vector<uint32>& outIndices)
 {
-	Render::IRender * render = Render::IRender::GetActive();
-	
-	uint indsNum = (size.x - 1) * (size.y * 2) + (size.x - 2) * 2;
-	RenderData::IndexBuffer * ib = render->createIndexBuffer(indsNum);
-	ib->setStorageType(RenderData::IBuffer::stGPUStaticMemory);
-	ib->setPolyType(IndexBuffer::ptTriStrip);
-	
-	int indexIndex = 0;
-	for(int i = 0; i < size.x - 1; ++i)
+	int vertsPerSide = patchCells + 1;
+
+	uint32 stitchNegX = GetEdgeStitch(stitchMask, peNegativeX);
+	uint32 stitchPosX = GetEdgeStitch(stitchMask, pePositiveX);
+	uint32 stitchNegZ = GetEdgeStitch(stitchMask, peNegativeZ);
+	uint32 stitchPosZ = GetEdgeStitch(stitchMask, pePositiveZ);
+
+	//vertex index of grid point with edge vertices snapped to coarser neighbours
+	std::vector<uint32> remap(vertsPerSide * vertsPerSide);
+	for(int i = 0; i < vertsPerSide; ++i)
 	{
-		if(i > 0)
+		for(int j = 0; j < vertsPerSide; ++j)
 		{
-			int left = ((i + 0) * size.x);
-			if(glue.y < 0 && (i % 2) != 0)
-			{
-				left = ((i - 1) * size.x);
-			}
+			int si = i, sj = j;
 
-			ib->setIndex(indexIndex++, left);
-		}
-		
-		for(int j = 0; j < size.y; ++j)
-		{
-			int left = ((i + 0) * size.x) + j;
+			if(i == 0)
+				sj = SnapEdgeVertex(j, stitchNegX, patchCells);
+			else if(i == patchCells)
+				sj = SnapEdgeVertex(j, stitchPosX, patchCells);
 
-			if(glue.y < 0 && j == 0 && (i % 2) != 0)
-			{
-				left = ((i - 1) * size.x);
-			}
-			if(glue.y > 0 && j == (size.y - 1) && (i % 2) != 0)
-			{
-				left = ((i - 1) * size.x) + j;
-			}
+			if(j == 0)
+				si = SnapEdgeVertex(i, stitchNegZ, patchCells);
+			else if(j == patchCells)
+				si = SnapEdgeVertex(i, stitchPosZ, patchCells);
 
-			if(glue.x < 0 && (j % 2) != 0 && i == 0)
-			{
-				left = ((i + 0) * size.x) + (j - 1);
-			}
+			remap[i * vertsPerSide + j] = si * vertsPerSide + sj;
+		}
+	}
 
-			int right = ((i + 1) * size.x) + j;
+	outIndices.clear();
+	outIndices.reserve(patchCells * patchCells * 6);
 
-			if(glue.y < 0 && j == 0 && ((i + 1) % 2) != 0)
-			{
-				right = ((i + 0) * size.x);
-			}
-			if(glue.y > 0 && j == (size.y - 1) && ((i + 1) % 2) != 0)
-			{
-				right = ((i + 0) * size.x) + j;
-			}
-
-			if(glue.x > 0 && (j % 2) != 0 && i == (size.x - 2))
+	for(int i = 0; i < patchCells; ++i)
+	{
+		for(int j = 0; j < patchCells; ++j)
+		{
+			//same winding as triangle strips of rows had
+			uint32 a = remap[(i + 0) * vertsPerSide + (j + 0)];
+			uint32 b = remap[(i + 1) * vertsPerSide + (j + 0)];
+			uint32 c = remap[(i + 0) * vertsPerSide + (j + 1)];
+			uint32 d = remap[(i + 1) * vertsPerSide + (j + 1)];
+
+			//triangles collapsed by snapping are skipped
+			if(a != b && b != c && c != a)
 			{
-				right = ((i + 1) * size.x) + (j - 1);
+				outIndices.push_back(a);
+				outIndices.push_back(b);
+				outIndices.push_back(c);
 			}
-			
-			ib->setIndex(indexIndex++, left);
-			ib->setIndex(indexIndex++, right);
-		}
-		
-		if(i < size.x - 2)
-		{
-			int right = ((i + 1) * size.x) + (size.y - 1);
-			if(glue.y > 0 && ((i + 1) % 2) != 0)
+			if(c != b && b != d && d != c)
 			{
-				right = ((i + 0) * size.x) + (size.y - 1);
+				outIndices.push_back(c);
+				outIndices.push_back(b);
+				outIndices.push_back(d);
 			}
-
-			ib->setIndex(indexIndex++, right);
 		}
 	}
-	
-	return ib;
 }
-	
-RenderData::VertexBuffer * TerrainNode::GenVertexBuffer(tuple2i size)
-{
-	//gen vertex buffer
-	
-	uint vertsNum = size.x * size.y;
-	
-	//position, packedNormal...
-	int terrainVertexType =	(VCI2VT(VertexBuffer::vcPosition) |
-							 VCI2VT(VertexBuffer::vcInt8Normal));
-	
-	Render::IRender * render = Render::IRender::GetActive();
-	return render->createVertexBuffer(terrainVertexType, vertsNum);
-}
-	
-void TerrainNode::applyHeightMap(HeightMap * heightMap, int lod)
+
+RenderData::IndexBuffer * TerrainNode::GenPatchIndexBuffer(int patchCells, uint32 stitchMask)
 {
-	mHeightMap = heightMap;
+	std::vector<uint32> indices;
+	GenPatchIndices(patchCells, stitchMask, indices);
 
-	mBoundVolume.reset();
-	
-	int i, j, x, y;
-	
-	tuple2i hmSize = heightMap->getResolution();
+	Render::IRender * render = Render::IRender::GetActive();
 
-	int lodPow2 = 1 << lod;
-	tuple2i lodSize = (hmSize - 1) / lodPow2 + 1;
+	IndexBuffer::IndexSize indexSize = (patchCells + 1) * (patchCells + 1) <= 0xFFFF ? IndexBuffer::Index16 : IndexBuffer::Index32;
+	IndexBuffer * ib = render->createIndexBuffer((int)indices.size(), indexSize);
+	ib->setStorageType(RenderData::IBuffer::stGPUStaticMemory);
+	ib->setPolyType(IndexBuffer::ptTriangles);
 
-	//gen vertex buffer
-	
-	int vertexIndex = 0;
-	for(i = 0, x = 0; i < lodSize.x; ++i, x += lodPow2)
+	for(size_t i = 0; i < indices.size(); ++i)
 	{
-		for(j = 0, y = 0; j < lodSize.y; ++j, y += lodPow2)
-		{
-			//position
-			float h = heightMap->height(x, y);
-			Math::vec3 vertPos((float)x, h, (float)y);
-			mVB->setComponent<VertexBuffer::vcPosition>(vertexIndex, vertPos);
-			
-			//normal
-			mVB->setComponent<VertexBuffer::vcInt8Normal>(vertexIndex, heightMap->normal(x, y));
-			
-			//update BV
-			mBoundVolume.addVertex( vertPos );
-			
-			++vertexIndex;
-		}
+		ib->setIndex((uint)i, indices[i]);
 	}
-	
-	mUpdateBoundVolume = true;
+
+	return ib;
+}
+
+AABB TerrainNode::getPatchAABB(int depth, int x, int z) const
+{
+	const TerrainLodTree::Node& node = mLodTree->getNode(depth, x, z);
+	float cells = (float)mLodTree->getNodeCells(depth);
+
+	AABB bounds;
+	bounds.addVertex( vec3(x * cells, node.minHeight, z * cells) );
+	bounds.addVertex( vec3((x + 1) * cells, node.maxHeight, (z + 1) * cells) );
+	bounds.scale(mScale);
+	bounds.move(mOffset);
+	return bounds;
 }
 	
 float TerrainNode::height(float x, float z) const
@@ -199,25 +168,18 @@ float TerrainNode::height(float x, float z) const
 	return mHeightMap->heightFetch(x,z) * mScale.y + mOffset.y;
 }
 
-bool TerrainNode::render(Render::Camera * camera, Render::MaterialGroup * matGroup)
+void TerrainNode::renderPatch(Render::MaterialGroup * matGroup, int depth, int x, int z, RenderData::IndexBuffer * ib)
 {
-	const AABB& bounds = getTransformedAABB();
+	VertexBuffer * vb = mLodTree->getVertexBuffer(mHeightMap, depth, x, z);
 
-	if(!camera->isAABBIn(bounds))
-	{
-		return false;
-	}
+	Render::VBGroup * vbGroup = matGroup->getVBGroup(vb, 0);
 
-	Render::VBGroup * vbGroup = matGroup->getVBGroup(mVB, 0);
-
-	Render::IndexPrimitive * primitive = vbGroup->getIndexPrimitive(mIB);
+	Render::IndexPrimitive * primitive = vbGroup->getIndexPrimitive(ib);
 
 	Math::mat4 transform = Math::mat4::Scale(mScale);
 	transform.setTranslate(mOffset);
 
-	primitive->addInstance(transform, bounds);
-
-	return true;
+	primitive->addInstance(transform, getPatchAABB(depth, x, z));
 }
 
 }//namespace World {
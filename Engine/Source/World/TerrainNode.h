@@ -1,10 +1,13 @@
 #pragma once
 
 #include "HeightMap.h"
+#include "TerrainLodTree.h"
 #include <Render/RenderQueue.h>
 #include <Render/Camera.h>
 #include <Resource/TextureStorage.h>
 #include "macros.h"
+#include <memory>
+#include <vector>
 
 namespace Squirrel {
 namespace World { 
@@ -16,17 +19,32 @@ class SQWORLD_API TerrainNode
 public:
 	static const int MAX_TEXTURES_PER_NODE = 4;
 
+	//patch edges, stitching of every edge takes 4 bits of mask
+	enum EPatchEdge
+	{
+		peNegativeX = 0,
+		pePositiveX,
+		peNegativeZ,
+		pePositiveZ,
+		peNum
+	};
+
 public://ctor/dtor
 	TerrainNode();
 	virtual ~TerrainNode();
 
 public://methods
 
-	void init(RenderData::IndexBuffer * ib, HeightMap *	heightMap, int lod = 0);
+	//takes ownership of LOD tree, builds it if it is NULL
+	void init(HeightMap * heightMap, TerrainLodTree * lodTree, int patchCells);
 
 	float height(float x, float z) const;
 
-	bool render(Render::Camera * camera, Render::MaterialGroup * matGroup);
+	//bounds of LOD tree node in world space
+	AABB getPatchAABB(int depth, int x, int z) const;
+
+	//adds LOD tree node drawn with given patch index buffer
+	void renderPatch(Render::MaterialGroup * matGroup, int depth, int x, int z, RenderData::IndexBuffer * ib);
 
 	inline void setOffset(vec3 offset) { mOffset = offset; mUpdateBoundVolume = true; }
 	inline void setScale(vec3 scale) { mScale = scale; mUpdateBoundVolume = true; }
@@ -34,7 +52,7 @@ public://methods
 	inline vec3 getOffset() const { return mOffset; }
 	inline vec3 getScale() const { return mScale; }
 
-	inline int getLOD() const { return mLod; }
+	inline TerrainLodTree * getLodTree() const { return mLodTree.get(); }
 
 	inline const AABB& getTransformedAABB()
 	{
@@ -47,28 +65,23 @@ public://methods
 		return mTransformedBoundVolume;
 	}
 
-	inline void setIndexBuffer(RenderData::IndexBuffer * ib, bool own = false) { 
-		if(mIBOwner) 
-			DELETE_PTR(mIB); 
-		mIB = ib; 
-		mIBOwner = own;
-	}
-	
 	inline void setGridPos(tuple2i pos) { mGridPos = pos; }
 	inline tuple2i getGridPos() const { return mGridPos; }
 
 	inline HeightMap * getHeightMap() const { return mHeightMap; }
 	
-	static RenderData::IndexBuffer * GenIndexBuffer(tuple2i size, tuple2i glue = tuple2i(0, 0));
-	static RenderData::VertexBuffer * GenVertexBuffer(tuple2i size);
+	//triangles of patch grid; edge vertices are snapped to every (1 << stitch)-th one of edge
+	//where stitch is log2 of how many times neighbour step is bigger, so edges match coarser neighbours;
+	//(1 << stitch) has to be not more than half of patch cells
+	static void GenPatchIndices(int patchCells, uint32 stitchMask, std::vector<uint32>& outIndices);
+	static RenderData::IndexBuffer * GenPatchIndexBuffer(int patchCells, uint32 stitchMask);
+
+	static inline uint32 GetEdgeStitch(uint32 stitchMask, EPatchEdge edge) { return (stitchMask >> (edge * 4)) & 0xF; }
+	static inline uint32 MakeEdgeStitch(uint32 stitch, EPatchEdge edge) { return (stitch & 0xF) << (edge * 4); }
 
 	Resource::Texture * mTextures[MAX_TEXTURES_PER_NODE];
 	Resource::Texture * mBumps[MAX_TEXTURES_PER_NODE];
 	
-private://methods
-
-	void applyHeightMap(HeightMap *	heightMap, int lod);
-	
 private://members
 	
 	tuple2i		mGridPos;
@@ -77,16 +90,11 @@ private://members
 	vec3		mScale;
 	HeightMap *	mHeightMap;
 
-	int			mLod;
+	std::auto_ptr<TerrainLodTree> mLodTree;
 
 	AABB		mBoundVolume;
 	AABB		mTransformedBoundVolume;
 	bool		mUpdateBoundVolume;
-
-	RenderData::VertexBuffer * mVB;
-	RenderData::IndexBuffer * mIB;
-	
-	bool mIBOwner;
 };
 
 }//namespace World {
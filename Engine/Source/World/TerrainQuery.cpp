@@ -0,0 +1,770 @@
+#include "TerrainQuery.h"
+#include "Terrain.h"
+#include <Math/GeometryTools.h>
+#include <float.h>
+#include <math.h>
+
+namespace Squirrel {
+namespace World {
+
+namespace {
+
+const float RAY_EPSILON = 1e-6f;
+
+//clips ray parameter range by slab [lo, hi] of one axis
+inline bool ClipSlab(float origin, float dir, float lo, float hi, float& tMin, float& tMax)
+{
+	if(Math::absValue(dir) < RAY_EPSILON)
+	{
+		return origin >= lo && origin <= hi;
+	}
+
+	float invDir = 1.0f / dir;
+	float t0 = (lo - origin) * invDir;
+	float t1 = (hi - origin) * invDir;
+
+	if(t0 > t1)
+	{
+		float t = t0; t0 = t1; t1 = t;
+	}
+
+	tMin = Math::maxValue(tMin, t0);
+	tMax = Math::minValue(tMax, t1);
+
+	return tMin <= tMax;
+}
+
+//ray height range on [tMin, tMax] overlaps [lo, hi]
+inline bool OverlapsHeights(const vec3& origin, const vec3& dir, float tMin, float tMax, float lo, float hi)
+{
+	float y0 = origin.y + dir.y * tMin;
+	float y1 = origin.y + dir.y * tMax;
+	return Math::minValue(y0, y1) <= hi && Math::maxValue(y0, y1) >= lo;
+}
+
+struct ChildCell
+{
+	int		x;
+	int		z;
+	float	tMin;
+	float	tMax;
+};
+
+//closest point of bilinear cell which corners are p1 (min x, min z), p2 (max x), p3 (max z) and p4,
+//point closest to one of its two triangles is refined by few Gauss-Newton steps
+vec3 ClosestPointOnCell(const vec3& p1, const vec3& p2, const vec3& p3, const vec3& p4, const vec3& point)
+{
+	vec3 onTriangle1 = closestPointOnTriangle(p1, p3, p2, point);
+	vec3 onTriangle2 = closestPointOnTriangle(p2, p3, p4, point);
+	vec3 start = (point - onTriangle1).len() < (point - onTriangle2).len() ? onTriangle1 : onTriangle2;
+
+	float sizeX = p2.x - p1.x;
+	float sizeZ = p3.z - p1.z;
+
+	float u = Math::clamp((start.x - p1.x) / sizeX, 0.0f, 1.0f);
+	float v = Math::clamp((start.z - p1.z) / sizeZ, 0.0f, 1.0f);
+
+	for(int i = 0; i < 3; ++i)
+	{
+		float height = Math::lerp(Math::lerp(p1.y, p2.y, u), Math::lerp(p3.y, p4.y, u), v);
+		vec3 toPoint = point - vec3(p1.x + u * sizeX, height, p1.z + v * sizeZ);
+
+		//surface derivatives are (sizeX, dhdu, 0) and (0, dhdv, sizeZ)
+		float dhdu = Math::lerp(p2.y - p1.y, p4.y - p3.y, v);
+		float dhdv = Math::lerp(p3.y - p1.y, p4.y - p2.y, u);
+
+		float a = sizeX * sizeX + dhdu * dhdu;
+		float b = dhdu * dhdv;
+		float c = sizeZ * sizeZ + dhdv * dhdv;
+		float ru = sizeX * toPoint.x + dhdu * toPoint.y;
+		float rv = sizeZ * toPoint.z + dhdv * toPoint.y;
+		float invDet = 1.0f / (a * c - b * b);
+
+		u = Math::clamp(u + (c * ru - b * rv) * invDet, 0.0f, 1.0f);
+		v = Math::clamp(v + (a * rv - b * ru) * invDet, 0.0f, 1.0f);
+	}
+
+	float height = Math::lerp(Math::lerp(p1.y, p2.y, u), Math::lerp(p3.y, p4.y, u), v);
+	return vec3(p1.x + u * sizeX, height, p1.z + v * sizeZ);
+}
+
+}//namespace {
+
+TerrainQuery::TerrainQuery(Terrain * terrain):
+	mTerrain(terrain)
+{
+}
+
+TerrainQuery::~TerrainQuery()
+{
+}
+
+bool TerrainQuery::locate(float x, float z, NodeLocation& location)
+{
+	float nodeSize = mTerrain->getNodeSize();
+	int nodesNum = mTerrain->getNodesNum();
+	vec3 gridOrigin = mTerrain->getGridOrigin();
+
+	int i = (int)floorf((x - gridOrigin.x) / nodeSize);
+	int j = (int)floorf((z - gridOrigin.z) / nodeSize);
+
+	if(i < 0 || j < 0 || i >= nodesNum || j >= nodesNum)
+	{
+		location.node = NULL;
+		return false;
+	}
+
+	if(location.node == NULL || location.index.x != i || location.index.y != j)
+	{
+		location.node = mTerrain->getNode(i, j);
+		location.index = tuple2i(i, j);
+	}
+
+	TerrainNode * node = location.node;
+
+	if(node == NULL)
+		return false;
+
+	tuple2i res = node->getHeightMap()->getResolution();
+	vec3 offset = node->getOffset();
+	vec3 scale = node->getScale();
+
+	location.u = Math::clamp((x - offset.x) / scale.x, 0.0f, (float)(res.x - 1));
+	location.v = Math::clamp((z - offset.z) / scale.z, 0.0f, (float)(res.y - 1));
+
+	return true;
+}
+
+float TerrainQuery::sampleHeight(const NodeLocation& location) const
+{
+	const HeightMap * hm = location.node->getHeightMap();
+	tuple2i res = hm->getResolution();
+
+	int xNdx = Math::minValue((int)location.u, res.x - 2);
+	int zNdx = Math::minValue((int)location.v, res.y - 2);
+
+	float xFrac = location.u - xNdx;
+	float zFrac = location.v - zNdx;
+
+	float h1 = hm->height(xNdx + 0, zNdx + 0);
+	float h2 = hm->height(xNdx + 1, zNdx + 0);
+	float h3 = hm->height(xNdx + 0, zNdx + 1);
+	float h4 = hm->height(xNdx + 1, zNdx + 1);
+
+	float lerp1 = Math::lerp(h1, h2, xFrac);
+	float lerp2 = Math::lerp(h3, h4, xFrac);
+
+	vec3 offset = location.node->getOffset();
+	vec3 scale = location.node->getScale();
+
+	return Math::lerp(lerp1, lerp2, zFrac) * scale.y + offset.y;
+}
+
+vec3 TerrainQuery::sampleNormal(const NodeLocation& location) const
+{
+	const HeightMap * hm = location.node->getHeightMap();
+	tuple2i res = hm->getResolution();
+
+	int xNdx = Math::minValue((int)location.u, res.x - 2);
+	int zNdx = Math::minValue((int)location.v, res.y - 2);
+
+	float xFrac = location.u - xNdx;
+	float zFrac = location.v - zNdx;
+
+	float h1 = hm->height(xNdx + 0, zNdx + 0);
+	float h2 = hm->height(xNdx + 1, zNdx + 0);
+	float h3 = hm->height(xNdx + 0, zNdx + 1);
+	float h4 = hm->height(xNdx + 1, zNdx + 1);
+
+	vec3 scale = location.node->getScale();
+
+	//gradient of bilinear patch in world units
+	float dhdx = Math::lerp(h2 - h1, h4 - h3, zFrac) * scale.y / scale.x;
+	float dhdz = Math::lerp(h3 - h1, h4 - h2, xFrac) * scale.y / scale.z;
+
+	return vec3(-dhdx, 1.0f, -dhdz).normalized();
+}
+
+bool TerrainQuery::height(float x, float z, float& outHeight)
+{
+	++mStats.mQueriesNum;
+	++mStats.mSamplesNum;
+
+	NodeLocation location;
+	if(!locate(x, z, location))
+		return false;
+
+	outHeight = sampleHeight(location);
+	return true;
+}
+
+bool TerrainQuery::normal(float x, float z, vec3& outNormal)
+{
+	++mStats.mQueriesNum;
+	++mStats.mSamplesNum;
+
+	NodeLocation location;
+	if(!locate(x, z, location))
+		return false;
+
+	outNormal = sampleNormal(location);
+	return true;
+}
+
+int TerrainQuery::sampleHeights(const vec2 * points, int count, float * outHeights)
+{
+	++mStats.mQueriesNum;
+	mStats.mSamplesNum += count;
+
+	int hitsNum = 0;
+
+	NodeLocation location;
+	for(int i = 0; i < count; ++i)
+	{
+		if(locate(points[i].x, points[i].y, location))
+		{
+			outHeights[i] = sampleHeight(location);
+			++hitsNum;
+		}
+		else
+		{
+			outHeights[i] = 0.0f;
+		}
+	}
+
+	return hitsNum;
+}
+
+int TerrainQuery::sampleNormals(const vec2 * points, int count, vec3 * outNormals)
+{
+	++mStats.mQueriesNum;
+	mStats.mSamplesNum += count;
+
+	int hitsNum = 0;
+
+	NodeLocation location;
+	for(int i = 0; i < count; ++i)
+	{
+		if(locate(points[i].x, points[i].y, location))
+		{
+			outNormals[i] = sampleNormal(location);
+			++hitsNum;
+		}
+		else
+		{
+			outNormals[i] = vec3::AxisY();
+		}
+	}
+
+	return hitsNum;
+}
+
+bool TerrainQuery::raycast(const Ray& ray, float maxDistance, TerrainHit& outHit)
+{
+	++mStats.mQueriesNum;
+
+	const vec3& origin = ray.mOrigin;
+	const vec3& dir = ray.mDirection;
+
+	float nodeSize = mTerrain->getNodeSize();
+	int nodesNum = mTerrain->getNodesNum();
+	vec3 gridOrigin = mTerrain->getGridOrigin();
+
+	if(nodesNum <= 0)
+		return false;
+
+	float gridSize = nodeSize * nodesNum;
+
+	//clip ray by nodes grid
+
+	float tMin = 0.0f;
+	float tMax = maxDistance;
+
+	if(!ClipSlab(origin.x, dir.x, gridOrigin.x, gridOrigin.x + gridSize, tMin, tMax))
+		return false;
+	if(!ClipSlab(origin.z, dir.z, gridOrigin.z, gridOrigin.z + gridSize, tMin, tMax))
+		return false;
+
+	//walk nodes grid from entry point
+
+	vec3 entry = origin + dir * tMin;
+
+	int i = Math::clamp((int)floorf((entry.x - gridOrigin.x) / nodeSize), 0, nodesNum - 1);
+	int j = Math::clamp((int)floorf((entry.z - gridOrigin.z) / nodeSize), 0, nodesNum - 1);
+
+	int stepI = dir.x > RAY_EPSILON ? 1 : (dir.x < -RAY_EPSILON ? -1 : 0);
+	int stepJ = dir.z > RAY_EPSILON ? 1 : (dir.z < -RAY_EPSILON ? -1 : 0);
+
+	float tNextI = FLT_MAX, tDeltaI = FLT_MAX;
+	float tNextJ = FLT_MAX, tDeltaJ = FLT_MAX;
+
+	if(stepI != 0)
+	{
+		tNextI = (gridOrigin.x + (i + (stepI > 0 ? 1 : 0)) * nodeSize - origin.x) / dir.x;
+		tDeltaI = nodeSize / Math::absValue(dir.x);
+	}
+	if(stepJ != 0)
+	{
+		tNextJ = (gridOrigin.z + (j + (stepJ > 0 ? 1 : 0)) * nodeSize - origin.z) / dir.z;
+		tDeltaJ = nodeSize / Math::absValue(dir.z);
+	}
+
+	float tEnter = tMin;
+
+	while(i >= 0 && j >= 0 && i < nodesNum && j < nodesNum)
+	{
+		float tExit = Math::minValue(Math::minValue(tNextI, tNextJ), tMax);
+
+		TerrainNode * node = mTerrain->getNode(i, j);
+		if(node != NULL && raycastNode(node, origin, dir, tEnter, tExit, outHit))
+			return true;
+
+		if(tExit >= tMax)
+			break;
+
+		if(tNextI < tNextJ)
+		{
+			i += stepI;
+			tNextI += tDeltaI;
+		}
+		else
+		{
+			j += stepJ;
+			tNextJ += tDeltaJ;
+		}
+
+		tEnter = tExit;
+	}
+
+	return false;
+}
+
+bool TerrainQuery::segmentCast(const vec3& from, const vec3& to, TerrainHit& outHit)
+{
+	Ray ray;
+	ray.mOrigin = from;
+	ray.mDirection = to - from;
+
+	float length = ray.mDirection.len();
+	if(length < RAY_EPSILON)
+		return false;
+
+	ray.mDirection /= length;
+
+	return raycast(ray, length, outHit);
+}
+
+bool TerrainQuery::raycastNode(TerrainNode * node, const vec3& origin, const vec3& dir, float tMin, float tMax, TerrainHit& outHit)
+{
+	++mStats.mNodesVisited;
+
+	const HeightMapPyramid * pyramid = node->getHeightMap()->getPyramid();
+	if(pyramid->isEmpty())
+		return false;
+
+	int topLevel = pyramid->getLevelsNum() - 1;
+
+	return raycastPyramid(node, topLevel, 0, 0, origin, dir, tMin, tMax, outHit);
+}
+
+bool TerrainQuery::raycastPyramid(TerrainNode * node, int level, int cellX, int cellZ, const vec3& origin, const vec3& dir, float tMin, float tMax, TerrainHit& outHit)
+{
+	++mStats.mBoxesTested;
+
+	const HeightMapPyramid * pyramid = node->getHeightMap()->getPyramid();
+
+	vec3 offset = node->getOffset();
+	vec3 scale = node->getScale();
+
+	//cell rect in level 0 cells
+
+	tuple2i baseSize = pyramid->getLevelSize(0);
+
+	int x0 = cellX << level;
+	int z0 = cellZ << level;
+	int x1 = Math::minValue((cellX + 1) << level, baseSize.x);
+	int z1 = Math::minValue((cellZ + 1) << level, baseSize.y);
+
+	if(!ClipSlab(origin.x, dir.x, offset.x + x0 * scale.x, offset.x + x1 * scale.x, tMin, tMax))
+		return false;
+	if(!ClipSlab(origin.z, dir.z, offset.z + z0 * scale.z, offset.z + z1 * scale.z, tMin, tMax))
+		return false;
+
+	float minHeight = pyramid->getMin(level, cellX, cellZ) * scale.y + offset.y;
+	float maxHeight = pyramid->getMax(level, cellX, cellZ) * scale.y + offset.y;
+
+	if(!OverlapsHeights(origin, dir, tMin, tMax, minHeight, maxHeight))
+		return false;
+
+	if(level == 0)
+		return raycastCell(node, cellX, cellZ, origin, dir, tMin, tMax, outHit);
+
+	//visit children in order of ray entry, they do not overlap so first hit is the nearest one
+
+	tuple2i childSize = pyramid->getLevelSize(level - 1);
+
+	ChildCell children[4];
+	int childrenNum = 0;
+
+	for(int dz = 0; dz < 2; ++dz)
+	{
+		for(int dx = 0; dx < 2; ++dx)
+		{
+			int childX = cellX * 2 + dx;
+			int childZ = cellZ * 2 + dz;
+
+			if(childX >= childSize.x || childZ >= childSize.y)
+				continue;
+
+			int childX0 = childX << (level - 1);
+			int childZ0 = childZ << (level - 1);
+			int childX1 = Math::minValue((childX + 1) << (level - 1), baseSize.x);
+			int childZ1 = Math::minValue((childZ + 1) << (level - 1), baseSize.y);
+
+			ChildCell child = { childX, childZ, tMin, tMax };
+
+			if(!ClipSlab(origin.x, dir.x, offset.x + childX0 * scale.x, offset.x + childX1 * scale.x, child.tMin, child.tMax))
+				continue;
+			if(!ClipSlab(origin.z, dir.z, offset.z + childZ0 * scale.z, offset.z + childZ1 * scale.z, child.tMin, child.tMax))
+				continue;
+
+			int index = childrenNum++;
+			while(index > 0 && children[index - 1].tMin > child.tMin)
+			{
+				children[index] = children[index - 1];
+				--index;
+			}
+			children[index] = child;
+		}
+	}
+
+	for(int i = 0; i < childrenNum; ++i)
+	{
+		const ChildCell& child = children[i];
+		if(raycastPyramid(node, level - 1, child.x, child.z, origin, dir, child.tMin, child.tMax, outHit))
+			return true;
+	}
+
+	return false;
+}
+
+bool TerrainQuery::raycastCell(TerrainNode * node, int cellX, int cellZ, const vec3& origin, const vec3& dir, float tMin, float tMax, TerrainHit& outHit)
+{
+	++mStats.mCellsTested;
+
+	const HeightMap * hm = node->getHeightMap();
+
+	vec3 offset = node->getOffset();
+	vec3 scale = node->getScale();
+
+	//bilinear patch h(u,v) = a + b*u + c*v + d*u*v in world units, u,v in [0,1] over the cell
+
+	double a = hm->height(cellX, cellZ) * scale.y + offset.y;
+	double b = (hm->height(cellX + 1, cellZ) - hm->height(cellX, cellZ)) * scale.y;
+	double c = (hm->height(cellX, cellZ + 1) - hm->height(cellX, cellZ)) * scale.y;
+	double d = (hm->height(cellX, cellZ) - hm->height(cellX + 1, cellZ) - hm->height(cellX, cellZ + 1) + hm->height(cellX + 1, cellZ + 1)) * scale.y;
+
+	double u0 = (origin.x - offset.x) / scale.x - cellX;
+	double v0 = (origin.z - offset.z) / scale.z - cellZ;
+	double du = dir.x / scale.x;
+	double dv = dir.z / scale.z;
+
+	//f(t) = ray height - surface height = qa*t^2 + qb*t + qc
+
+	double qa = -d * du * dv;
+	double qb = dir.y - (b * du + c * dv + d * (u0 * dv + v0 * du));
+	double qc = origin.y - (a + b * u0 + c * v0 + d * u0 * v0);
+
+	double roots[2];
+	int rootsNum = 0;
+
+	if(Math::absValue(qa) < 1e-12)
+	{
+		if(Math::absValue(qb) > 1e-12)
+			roots[rootsNum++] = -qc / qb;
+	}
+	else
+	{
+		double disc = qb * qb - 4.0 * qa * qc;
+		if(disc < 0.0)
+			return false;
+
+		double q = -0.5 * (qb + (qb >= 0.0 ? sqrt(disc) : -sqrt(disc)));
+		roots[rootsNum++] = q / qa;
+		if(Math::absValue(q) > 1e-12)
+			roots[rootsNum++] = qc / q;
+
+		if(rootsNum == 2 && roots[1] < roots[0])
+		{
+			double t = roots[0]; roots[0] = roots[1]; roots[1] = t;
+		}
+	}
+
+	//neighbour cells share borders, small tolerance keeps hits on them from slipping through
+
+	double tolerance = (tMax - tMin) * 1e-4 + 1e-6;
+
+	for(int i = 0; i < rootsNum; ++i)
+	{
+		double t = roots[i];
+
+		if(t < tMin - tolerance || t > tMax + tolerance)
+			continue;
+
+		//only crossings from above count, surface is one sided
+		if(2.0 * qa * t + qb > 0.0)
+			continue;
+
+		t = Math::clamp(t, (double)tMin, (double)tMax);
+
+		double u = Math::clamp(u0 + du * t, 0.0, 1.0);
+		double v = Math::clamp(v0 + dv * t, 0.0, 1.0);
+
+		float dhdx = (float)((b + d * v) / scale.x);
+		float dhdz = (float)((c + d * u) / scale.z);
+
+		outHit.distance	= (float)t;
+		outHit.position	= origin + dir * (float)t;
+		outHit.normal	= vec3(-dhdx, 1.0f, -dhdz).normalized();
+		outHit.node		= node;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool TerrainQuery::getRangeUnder(const vec3& boundsMin, const vec3& boundsMax, float& outMin, float& outMax)
+{
+	float nodeSize = mTerrain->getNodeSize();
+	int nodesNum = mTerrain->getNodesNum();
+	vec3 gridOrigin = mTerrain->getGridOrigin();
+
+	int i0 = Math::maxValue((int)floorf((boundsMin.x - gridOrigin.x) / nodeSize), 0);
+	int j0 = Math::maxValue((int)floorf((boundsMin.z - gridOrigin.z) / nodeSize), 0);
+	int i1 = Math::minValue((int)floorf((boundsMax.x - gridOrigin.x) / nodeSize), nodesNum - 1);
+	int j1 = Math::minValue((int)floorf((boundsMax.z - gridOrigin.z) / nodeSize), nodesNum - 1);
+
+	bool found = false;
+
+	outMin = FLT_MAX;
+	outMax = -FLT_MAX;
+
+	for(int i = i0; i <= i1; ++i)
+	{
+		for(int j = j0; j <= j1; ++j)
+		{
+			TerrainNode * node = mTerrain->getNode(i, j);
+			if(node == NULL)
+				continue;
+
+			vec3 offset = node->getOffset();
+			vec3 scale = node->getScale();
+
+			int x0 = (int)floorf((boundsMin.x - offset.x) / scale.x);
+			int z0 = (int)floorf((boundsMin.z - offset.z) / scale.z);
+			int x1 = (int)floorf((boundsMax.x - offset.x) / scale.x);
+			int z1 = (int)floorf((boundsMax.z - offset.z) / scale.z);
+
+			float minHeight, maxHeight;
+			if(node->getHeightMap()->getPyramid()->getRange(x0, z0, x1, z1, minHeight, maxHeight))
+			{
+				outMin = Math::minValue(outMin, minHeight * scale.y + offset.y);
+				outMax = Math::maxValue(outMax, maxHeight * scale.y + offset.y);
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+
+float TerrainQuery::sphereDepth(const vec3& center, float radius, vec3& outNormal)
+{
+	NodeLocation location;
+	if(!locate(center.x, center.z, location))
+		return -FLT_MAX;
+
+	++mStats.mSamplesNum;
+
+	float surfaceHeight = sampleHeight(location);
+	outNormal = sampleNormal(location);
+
+	//center under surface, distance to tangent plane of surface point under it
+	if(center.y <= surfaceHeight)
+	{
+		return radius - (center - vec3(center.x, surfaceHeight, center.z)) * outNormal;
+	}
+
+	//otherwise closest point of cells in sphere footprint, slopes next to center are closer than surface under it
+
+	float minDistance = center.y - surfaceHeight;
+	outNormal = vec3(0, 1, 0);
+
+	vec3 boundsMin = center - vec3(radius, radius, radius);
+	vec3 boundsMax = center + vec3(radius, radius, radius);
+
+	float minHeight, maxHeight;
+	if(!getRangeUnder(boundsMin, boundsMax, minHeight, maxHeight) || boundsMin.y > maxHeight)
+		return radius - minDistance;
+
+	float nodeSize = mTerrain->getNodeSize();
+	int nodesNum = mTerrain->getNodesNum();
+	vec3 gridOrigin = mTerrain->getGridOrigin();
+
+	int i0 = Math::maxValue((int)floorf((boundsMin.x - gridOrigin.x) / nodeSize), 0);
+	int j0 = Math::maxValue((int)floorf((boundsMin.z - gridOrigin.z) / nodeSize), 0);
+	int i1 = Math::minValue((int)floorf((boundsMax.x - gridOrigin.x) / nodeSize), nodesNum - 1);
+	int j1 = Math::minValue((int)floorf((boundsMax.z - gridOrigin.z) / nodeSize), nodesNum - 1);
+
+	for(int i = i0; i <= i1; ++i)
+	{
+		for(int j = j0; j <= j1; ++j)
+		{
+			TerrainNode * node = mTerrain->getNode(i, j);
+			if(node == NULL)
+				continue;
+
+			const HeightMap * hm = node->getHeightMap();
+			tuple2i res = hm->getResolution();
+			vec3 offset = node->getOffset();
+			vec3 scale = node->getScale();
+
+			int x0 = Math::maxValue((int)floorf((boundsMin.x - offset.x) / scale.x), 0);
+			int z0 = Math::maxValue((int)floorf((boundsMin.z - offset.z) / scale.z), 0);
+			int x1 = Math::minValue((int)floorf((boundsMax.x - offset.x) / scale.x), res.x - 2);
+			int z1 = Math::minValue((int)floorf((boundsMax.z - offset.z) / scale.z), res.y - 2);
+
+			for(int z = z0; z <= z1; ++z)
+			{
+				for(int x = x0; x <= x1; ++x)
+				{
+					vec3 p1(offset.x + x * scale.x,			hm->height(x + 0, z + 0) * scale.y + offset.y, offset.z + z * scale.z);
+					vec3 p2(offset.x + (x + 1) * scale.x,	hm->height(x + 1, z + 0) * scale.y + offset.y, offset.z + z * scale.z);
+					vec3 p3(offset.x + x * scale.x,			hm->height(x + 0, z + 1) * scale.y + offset.y, offset.z + (z + 1) * scale.z);
+					vec3 p4(offset.x + (x + 1) * scale.x,	hm->height(x + 1, z + 1) * scale.y + offset.y, offset.z + (z + 1) * scale.z);
+
+					//cell which is entirely below or aside of closest point found so far can not be closer
+					if(Math::maxValue(Math::maxValue(p1.y, p2.y), Math::maxValue(p3.y, p4.y)) < center.y - minDistance)
+						continue;
+
+					float dx = Math::maxValue(Math::maxValue(p1.x - center.x, center.x - p2.x), 0.0f);
+					float dz = Math::maxValue(Math::maxValue(p1.z - center.z, center.z - p3.z), 0.0f);
+					if(dx * dx + dz * dz >= minDistance * minDistance)
+						continue;
+
+					++mStats.mCellsTested;
+
+					vec3 toCenter = center - ClosestPointOnCell(p1, p2, p3, p4, center);
+					float distance = toCenter.len();
+					if(distance < minDistance && distance > RAY_EPSILON)
+					{
+						minDistance = distance;
+						outNormal = toCenter / distance;
+					}
+				}
+			}
+		}
+	}
+
+	return radius - minDistance;
+}
+
+bool TerrainQuery::sweepSphere(const vec3& from, const vec3& to, float radius, TerrainHit& outHit)
+{
+	++mStats.mQueriesNum;
+
+	vec3 path = to - from;
+	float length = path.len();
+
+	//coarse rejection by min/max pyramids of swept volume
+
+	vec3 boundsMin(Math::minValue(from.x, to.x), Math::minValue(from.y, to.y), Math::minValue(from.z, to.z));
+	vec3 boundsMax(Math::maxValue(from.x, to.x), Math::maxValue(from.y, to.y), Math::maxValue(from.z, to.z));
+
+	boundsMin -= vec3(radius, radius, radius);
+	boundsMax += vec3(radius, radius, radius);
+
+	float minHeight, maxHeight;
+	if(!getRangeUnder(boundsMin, boundsMax, minHeight, maxHeight))
+		return false;
+
+	if(boundsMin.y > maxHeight)
+		return false;
+
+	//march along path with steps smaller than sphere and cell, then refine contact by bisection
+
+	float step = Math::maxValue(Math::minValue(radius, mTerrain->getCellSize()) * 0.5f, RAY_EPSILON);
+	int stepsNum = Math::maxValue((int)ceilf(length / step), 1);
+
+	vec3 normal;
+	float prevT = 0.0f;
+
+	if(sphereDepth(from, radius, normal) >= 0.0f)
+	{
+		NodeLocation location;
+		locate(from.x, from.z, location);
+
+		outHit.distance	= 0.0f;
+		outHit.normal	= normal;
+		outHit.position	= from - normal * radius;
+		outHit.node		= location.node;
+		return true;
+	}
+
+	for(int i = 1; i <= stepsNum; ++i)
+	{
+		float t = (float)i / stepsNum;
+
+		if(sphereDepth(from + path * t, radius, normal) < 0.0f)
+		{
+			prevT = t;
+			continue;
+		}
+
+		float lo = prevT, hi = t;
+		for(int j = 0; j < 8; ++j)
+		{
+			float mid = (lo + hi) * 0.5f;
+			if(sphereDepth(from + path * mid, radius, normal) >= 0.0f)
+				hi = mid;
+			else
+				lo = mid;
+		}
+
+		vec3 center = from + path * hi;
+		sphereDepth(center, radius, normal);
+
+		NodeLocation location;
+		locate(center.x, center.z, location);
+
+		outHit.distance	= length * hi;
+		outHit.normal	= normal;
+		outHit.position	= center - normal * radius;
+		outHit.node		= location.node;
+		return true;
+	}
+
+	return false;
+}
+
+bool TerrainQuery::resolveSphere(vec3& center, float radius, vec3 * outNormal)
+{
+	++mStats.mQueriesNum;
+
+	vec3 normal;
+	float depth = sphereDepth(center, radius, normal);
+
+	if(depth <= 0.0f)
+		return false;
+
+	center += normal * depth;
+
+	if(outNormal != NULL)
+		*outNormal = normal;
+
+	return true;
+}
+
+}//namespace World {
+}//namespace Squirrel {
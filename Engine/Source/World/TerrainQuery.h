@@ -0,0 +1,115 @@
+#pragma once
+
+#include <Math/vec2.h>
+#include <Math/vec3.h>
+#include <Math/Ray.h>
+#include <Common/tuple.h>
+#include "macros.h"
+
+namespace Squirrel {
+namespace World {
+
+class Terrain;
+class TerrainNode;
+
+using namespace Math;
+
+struct TerrainHit
+{
+	vec3			position;
+	vec3			normal;
+	float			distance;
+	TerrainNode *	node;
+};
+
+//Collision and sampling queries against loaded terrain nodes.
+//Heights are bilinear like in HeightMap::heightFetch so ray hits agree with sampled heights,
+//rays walk nodes grid and descend min/max pyramid of every node they cross.
+class SQWORLD_API TerrainQuery
+{
+public:
+
+	struct Stats
+	{
+		Stats() { reset(); }
+
+		void reset()
+		{
+			mQueriesNum		= 0;
+			mSamplesNum		= 0;
+			mNodesVisited	= 0;
+			mBoxesTested	= 0;
+			mCellsTested	= 0;
+		}
+
+		int mQueriesNum;
+		int mSamplesNum;
+		int mNodesVisited;
+		int mBoxesTested;//pyramid boxes tested against ray
+		int mCellsTested;//height map cells tested against ray or sphere
+	};
+
+public://ctor/dtor
+	TerrainQuery(Terrain * terrain);
+	~TerrainQuery();
+
+public://methods
+
+	//returns false if point is outside of loaded nodes
+	bool	height(float x, float z, float& outHeight);
+	bool	normal(float x, float z, vec3& outNormal);
+
+	//batched versions, points outside of loaded nodes get 0 height and up normal;
+	//return number of points which hit loaded nodes
+	int		sampleHeights(const vec2 * points, int count, float * outHeights);
+	int		sampleNormals(const vec2 * points, int count, vec3 * outNormals);
+
+	//ray direction does not need to be normalized, distances are measured in its units
+	bool	raycast(const Ray& ray, float maxDistance, TerrainHit& outHit);
+	bool	segmentCast(const vec3& from, const vec3& to, TerrainHit& outHit);
+
+	//first contact of sphere moving from "from" to "to"
+	bool	sweepSphere(const vec3& from, const vec3& to, float radius, TerrainHit& outHit);
+
+	//pushes sphere out of terrain along local surface normal, returns true if it was penetrating
+	bool	resolveSphere(vec3& center, float radius, vec3 * outNormal = NULL);
+
+	const Stats& getStats() const { return mStats; }
+	void	resetStats() { mStats.reset(); }
+
+private:
+
+	struct NodeLocation
+	{
+		NodeLocation(): node(NULL) {}
+
+		TerrainNode *	node;
+		tuple2i			index;
+		float			u;//height map space coords
+		float			v;
+	};
+
+	//previous location is reused while point stays in its node
+	bool	locate(float x, float z, NodeLocation& location);
+	float	sampleHeight(const NodeLocation& location) const;
+	vec3	sampleNormal(const NodeLocation& location) const;
+
+	bool	raycastNode(TerrainNode * node, const vec3& origin, const vec3& dir, float tMin, float tMax, TerrainHit& outHit);
+	bool	raycastPyramid(TerrainNode * node, int level, int cellX, int cellZ, const vec3& origin, const vec3& dir, float tMin, float tMax, TerrainHit& outHit);
+	bool	raycastCell(TerrainNode * node, int cellX, int cellZ, const vec3& origin, const vec3& dir, float tMin, float tMax, TerrainHit& outHit);
+
+	bool	getRangeUnder(const vec3& boundsMin, const vec3& boundsMax, float& outMin, float& outMax);
+
+	//sphere penetration depth into closest cell of its footprint (negative if sphere is above surface),
+	//normal points from closest surface point to center
+	float	sphereDepth(const vec3& center, float radius, vec3& outNormal);
+
+private:
+
+	Terrain * mTerrain;
+
+	Stats mStats;
+};
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,451 @@
+#include "TransformHierarchy.h"
+#include "SceneObject.h"
+#include <algorithm>
+
+namespace Squirrel {
+namespace World {
+
+const TransformHierarchy::HANDLE TransformHierarchy::INVALID_HANDLE;
+const uint8 TransformHierarchy::FRAME_FLAGS;
+
+TransformHierarchy * TransformHierarchy::sActive = NULL;
+
+namespace {
+
+struct DepthOrderPredicate
+{
+	const std::vector<int>& mDepths;
+
+	DepthOrderPredicate(const std::vector<int>& depths): mDepths(depths) {}
+
+	bool operator()(int a, int b) const { return mDepths[a] < mDepths[b]; }
+};
+
+}//namespace {
+
+TransformHierarchy::TransformHierarchy():
+	mFirstDirtySlot(0), mDeadNum(0), mOrderDirty(false), mTopologyRevision(0)
+{
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+	if(sActive == this)
+		sActive = NULL;
+
+	//move objects which outlive their hierarchy to default one
+
+	if(mOrderDirty)
+		rebuildOrder();
+
+	TransformHierarchy * defaultHierarchy = Default();
+
+	std::vector<HANDLE> newHandles(mOwners.size(), INVALID_HANDLE);
+
+	for(size_t slot = 0; slot < mOwners.size(); ++slot)
+	{
+		SceneObject * owner = mOwners[slot];
+
+		HANDLE handle = defaultHierarchy->create(owner);
+		defaultHierarchy->setParent(handle, mParents[slot] >= 0 ? newHandles[mParents[slot]] : INVALID_HANDLE);
+		defaultHierarchy->setPolled(handle, (mFlags[slot] & nfPolled) != 0);
+
+		owner->mTransforms		= defaultHierarchy;
+		owner->mTransformHandle	= handle;
+
+		newHandles[slot] = handle;
+	}
+}
+
+TransformHierarchy * TransformHierarchy::Default()
+{
+	//never destroyed to stay valid for objects released at exit
+	static TransformHierarchy * sDefault = new TransformHierarchy();
+	return sDefault;
+}
+
+TransformHierarchy * TransformHierarchy::Active()
+{
+	return sActive != NULL ? sActive : Default();
+}
+
+void TransformHierarchy::SetActive(TransformHierarchy * hierarchy)
+{
+	sActive = hierarchy;
+}
+
+TransformHierarchy::HANDLE TransformHierarchy::create(SceneObject * owner)
+{
+	HANDLE handle = INVALID_HANDLE;
+
+	if(mFreeHandles.size() > 0)
+	{
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else
+	{
+		handle = (HANDLE)mSlots.size();
+		mSlots.push_back(-1);
+	}
+
+	int slot = (int)mOwners.size();
+
+	mOwners.push_back(owner);
+	mHandles.push_back(handle);
+	mParents.push_back(-1);
+	mFlags.push_back(0);
+	mLocals.push_back(mat4::Identity());
+	mWorlds.push_back(mat4::Identity());
+
+	mSlots[handle] = slot;
+
+	++mTopologyRevision;
+
+	//root node appended to the end keeps depth order valid
+	markSlotDirty(slot, nfLocalDirty | nfBoundsDirty);
+	markDirty(handle);
+
+	return handle;
+}
+
+void TransformHierarchy::destroy(HANDLE handle)
+{
+	int slot = mSlots[handle];
+	ASSERT(slot >= 0);
+
+	if(mFlags[slot] & nfPolled)
+	{
+		mPolled.erase(std::find(mPolled.begin(), mPolled.end(), handle));
+	}
+
+	//parent bounds lost a child
+	if(mParents[slot] >= 0)
+	{
+		markSlotDirty(mParents[slot], nfAllBoundsDirty);
+	}
+
+	//slot is compacted on next update
+	mOwners[slot]	= NULL;
+	mFlags[slot]	= nfDead;
+
+	++mDeadNum;
+	mOrderDirty = true;
+
+	++mTopologyRevision;
+}
+
+void TransformHierarchy::setParent(HANDLE handle, HANDLE parent)
+{
+	int slot = mSlots[handle];
+	int parentSlot = (parent != INVALID_HANDLE) ? mSlots[parent] : -1;
+
+	int prevParentSlot = mParents[slot];
+	if(prevParentSlot == parentSlot)
+		return;
+
+	if(prevParentSlot >= 0)
+	{
+		markSlotDirty(prevParentSlot, nfAllBoundsDirty);
+	}
+
+	mParents[slot] = parentSlot;
+
+	++mTopologyRevision;
+
+	//parent must precede child
+	if(parentSlot > slot)
+	{
+		mOrderDirty = true;
+	}
+
+	markSlotDirty(slot, nfLocalDirty);
+}
+
+TransformHierarchy::HANDLE TransformHierarchy::getParent(HANDLE handle) const
+{
+	int parentSlot = mParents[ mSlots[handle] ];
+	return parentSlot >= 0 ? mHandles[parentSlot] : INVALID_HANDLE;
+}
+
+SceneObject * TransformHierarchy::getOwner(HANDLE handle) const
+{
+	if(handle < 0 || handle >= (HANDLE)mSlots.size() || mSlots[handle] < 0)
+		return NULL;
+	return mOwners[ mSlots[handle] ];
+}
+
+void TransformHierarchy::markSlotDirty(int slot, uint8 flags)
+{
+	mFlags[slot] |= flags;
+
+	if(slot < mFirstDirtySlot)
+		mFirstDirtySlot = slot;
+}
+
+void TransformHierarchy::markDirty(HANDLE handle)
+{
+	uint8& flags = mFlags[ mSlots[handle] ];
+
+	if((flags & nfPending) == 0)
+	{
+		flags |= nfPending;
+		mPending.push_back(handle);
+	}
+}
+
+void TransformHierarchy::invalidateBounds(HANDLE handle)
+{
+	markSlotDirty(mSlots[handle], nfBoundsDirty);
+}
+
+void TransformHierarchy::setPolled(HANDLE handle, bool polled)
+{
+	uint8& flags = mFlags[ mSlots[handle] ];
+
+	if(polled == ((flags & nfPolled) != 0))
+		return;
+
+	if(polled)
+	{
+		flags |= nfPolled;
+		mPolled.push_back(handle);
+	}
+	else
+	{
+		flags &= ~nfPolled;
+		mPolled.erase(std::find(mPolled.begin(), mPolled.end(), handle));
+	}
+}
+
+bool TransformHierarchy::isPolled(HANDLE handle) const
+{
+	return (mFlags[ mSlots[handle] ] & nfPolled) != 0;
+}
+
+void TransformHierarchy::fetchLocals(HANDLES_LIST& handles, bool keepList)
+{
+	for(size_t i = 0; i < handles.size(); ++i)
+	{
+		int slot = mSlots[ handles[i] ];
+		uint8& flags = mFlags[slot];
+
+		if(!keepList)
+			flags &= ~nfPending;
+
+		if(mOwners[slot]->fetchLocalTransform(mLocals[slot]) || (flags & nfLocalDirty))
+		{
+			markSlotDirty(slot, nfLocalDirty);
+			++mStats.mDirtyNodesNum;
+		}
+	}
+
+	if(!keepList)
+		handles.clear();
+}
+
+void TransformHierarchy::rebuildOrder()
+{
+	int count = (int)mOwners.size();
+
+	//orphan children of destroyed nodes
+
+	for(int slot = 0; slot < count; ++slot)
+	{
+		if(mParents[slot] >= 0 && (mFlags[ mParents[slot] ] & nfDead))
+		{
+			mParents[slot] = -1;
+			mFlags[slot] |= nfLocalDirty;
+		}
+	}
+
+	//calc depths
+
+	std::vector<int> depths(count, -1);
+	std::vector<int> chain;
+
+	for(int slot = 0; slot < count; ++slot)
+	{
+		int node = slot;
+		while(node >= 0 && depths[node] < 0)
+		{
+			chain.push_back(node);
+			node = mParents[node];
+		}
+
+		int depth = node >= 0 ? depths[node] : -1;
+		while(chain.size() > 0)
+		{
+			depths[chain.back()] = ++depth;
+			chain.pop_back();
+		}
+	}
+
+	//sort alive slots by depth
+
+	std::vector<int> order;
+	order.reserve(count - mDeadNum);
+
+	for(int slot = 0; slot < count; ++slot)
+	{
+		if(mFlags[slot] & nfDead)
+		{
+			mSlots[ mHandles[slot] ] = -1;
+			mFreeHandles.push_back( mHandles[slot] );
+		}
+		else
+		{
+			order.push_back(slot);
+		}
+	}
+
+	std::stable_sort(order.begin(), order.end(), DepthOrderPredicate(depths));
+
+	//permute storage
+
+	std::vector<int> newSlots(count, -1);
+	for(size_t i = 0; i < order.size(); ++i)
+		newSlots[ order[i] ] = (int)i;
+
+	std::vector<SceneObject *>	owners(order.size());
+	std::vector<HANDLE>			handles(order.size());
+	std::vector<int>			parents(order.size());
+	std::vector<uint8>			flags(order.size());
+	std::vector<mat4>			locals(order.size());
+	std::vector<mat4>			worlds(order.size());
+
+	for(size_t i = 0; i < order.size(); ++i)
+	{
+		int slot = order[i];
+		owners[i]	= mOwners[slot];
+		handles[i]	= mHandles[slot];
+		parents[i]	= mParents[slot] >= 0 ? newSlots[ mParents[slot] ] : -1;
+		flags[i]	= mFlags[slot];
+		locals[i]	= mLocals[slot];
+		worlds[i]	= mWorlds[slot];
+
+		mSlots[ handles[i] ] = (int)i;
+	}
+
+	mOwners.swap(owners);
+	mHandles.swap(handles);
+	mParents.swap(parents);
+	mFlags.swap(flags);
+	mLocals.swap(locals);
+	mWorlds.swap(worlds);
+
+	//forget destroyed nodes
+
+	HANDLES_LIST::iterator itEnd = mPending.begin();
+	for(HANDLES_LIST::iterator it = mPending.begin(); it != mPending.end(); ++it)
+	{
+		if(mSlots[*it] >= 0)
+			*itEnd++ = *it;
+	}
+	mPending.erase(itEnd, mPending.end());
+
+	itEnd = mChangedRoots.begin();
+	for(HANDLES_LIST::iterator it = mChangedRoots.begin(); it != mChangedRoots.end(); ++it)
+	{
+		if(*it < (HANDLE)mSlots.size() && mSlots[*it] >= 0)
+			*itEnd++ = *it;
+	}
+	mChangedRoots.erase(itEnd, mChangedRoots.end());
+
+	mDeadNum = 0;
+	mFirstDirtySlot = 0;
+	mOrderDirty = false;
+
+	++mStats.mReordersNum;
+}
+
+bool TransformHierarchy::update()
+{
+	mStats.reset();
+
+	if(mOrderDirty)
+	{
+		rebuildOrder();
+	}
+
+	fetchLocals(mPending, false);
+	fetchLocals(mPolled, true);
+
+	int count = (int)mOwners.size();
+
+	mStats.mNodesNum = count;
+
+	if(mFirstDirtySlot >= count)
+	{
+		//nothing changed
+		return false;
+	}
+
+	//propagate transforms downwards, parents are always updated before children
+
+	for(int slot = mFirstDirtySlot; slot < count; ++slot)
+	{
+		uint8& flags = mFlags[slot];
+		int parent = mParents[slot];
+
+		if((flags & nfLocalDirty) || (parent >= 0 && (mFlags[parent] & nfWorldChanged)))
+		{
+			if(parent >= 0)
+				mWorlds[slot] = mWorlds[parent] * mLocals[slot];
+			else
+				mWorlds[slot] = mLocals[slot];
+
+			flags |= nfWorldChanged | nfBoundsDirty;
+
+			++mStats.mTransformsRecomputed;
+		}
+	}
+
+	//propagate bounds upwards, children are always processed before parents
+
+	int lowestSlot = mFirstDirtySlot;
+
+	for(int slot = count - 1; slot >= lowestSlot; --slot)
+	{
+		uint8& flags = mFlags[slot];
+
+		if((flags & FRAME_FLAGS) == 0)
+			continue;
+
+		SceneObject * owner = mOwners[slot];
+
+		if(flags & nfBoundsDirty)
+		{
+			owner->calcAABB();
+			flags |= nfAllBoundsDirty;
+
+			++mStats.mBoundsRecomputed;
+		}
+
+		if(flags & nfAllBoundsDirty)
+		{
+			owner->mergeChildrenBounds();
+
+			int parent = mParents[slot];
+			if(parent >= 0)
+			{
+				mFlags[parent] |= nfAllBoundsDirty;
+				if(parent < lowestSlot)
+					lowestSlot = parent;
+			}
+			else
+			{
+				mChangedRoots.push_back(mHandles[slot]);
+			}
+		}
+
+		flags &= ~FRAME_FLAGS;
+	}
+
+	mFirstDirtySlot = count;
+
+	return true;
+}
+
+}//namespace World {
+}//namespace Squirrel {
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <Math/mat4.h>
+#include <Common/types.h>
+#include "macros.h"
+#include <vector>
+
+namespace Squirrel {
+namespace World {
+
+class SceneObject;
+
+using namespace Math;
+
+//Contiguous storage of scene objects transform hierarchy.
+//Nodes are kept sorted by depth so parents always precede their children,
+//which allows to propagate transforms of dirty subtrees in one linear pass.
+class SQWORLD_API TransformHierarchy
+{
+public:
+
+	typedef int HANDLE;
+
+	static const HANDLE INVALID_HANDLE = -1;
+
+	struct Stats
+	{
+		Stats() { reset(); }
+
+		void reset()
+		{
+			mNodesNum				= 0;
+			mDirtyNodesNum			= 0;
+			mTransformsRecomputed	= 0;
+			mBoundsRecomputed		= 0;
+			mReordersNum			= 0;
+		}
+
+		int mNodesNum;
+		int mDirtyNodesNum;//nodes with changed local transform
+		int mTransformsRecomputed;
+		int mBoundsRecomputed;
+		int mReordersNum;
+	};
+
+	typedef std::vector<HANDLE> HANDLES_LIST;
+
+private:
+
+	enum NodeFlags
+	{
+		nfLocalDirty	= 1 << 0,
+		nfWorldChanged	= 1 << 1,
+		nfBoundsDirty	= 1 << 2,
+		nfAllBoundsDirty= 1 << 3,
+		nfPending		= 1 << 4,
+		nfPolled		= 1 << 5,
+		nfDead			= 1 << 6,
+	};
+
+	static const uint8 FRAME_FLAGS = nfLocalDirty | nfWorldChanged | nfBoundsDirty | nfAllBoundsDirty;
+
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	static TransformHierarchy * Active();
+	static TransformHierarchy * Default();
+	static void SetActive(TransformHierarchy * hierarchy);
+
+	HANDLE	create(SceneObject * owner);
+	void	destroy(HANDLE handle);
+
+	void	setParent(HANDLE handle, HANDLE parent);
+	HANDLE	getParent(HANDLE handle) const;
+
+	//schedules local transform fetch from owner on next update
+	void	markDirty(HANDLE handle);
+	//schedules bounds recalculation on next update
+	void	invalidateBounds(HANDLE handle);
+	//polled nodes fetch local transform from owner every update (used for animation targets)
+	void	setPolled(HANDLE handle, bool polled);
+	bool	isPolled(HANDLE handle) const;
+
+	const mat4& getWorld(HANDLE handle) const	{ return mWorlds[ mSlots[handle] ]; }
+	const mat4& getLocal(HANDLE handle) const	{ return mLocals[ mSlots[handle] ]; }
+
+	//returns true if any transform or bounds were recomputed
+	bool	update();
+
+	//root nodes which bounds changed since last clearChangedRoots call
+	const HANDLES_LIST& getChangedRoots() const { return mChangedRoots; }
+	void	clearChangedRoots() { mChangedRoots.clear(); }
+
+	SceneObject * getOwner(HANDLE handle) const;
+
+	const Stats& getStats() const { return mStats; }
+
+	int		getNodesNum() const { return (int)mOwners.size() - mDeadNum; }
+
+	//changed when nodes are created, destroyed or reparented
+	uint32	getTopologyRevision() const { return mTopologyRevision; }
+
+private:
+
+	void	rebuildOrder();
+	void	fetchLocals(HANDLES_LIST& handles, bool keepList);
+	void	markSlotDirty(int slot, uint8 flags);
+
+private:
+
+	//slot indexed data, sorted by depth
+	std::vector<SceneObject *>	mOwners;
+	std::vector<HANDLE>			mHandles;
+	std::vector<int>			mParents;
+	std::vector<uint8>			mFlags;
+	std::vector<mat4>			mLocals;
+	std::vector<mat4>			mWorlds;
+
+	//handle indexed data
+	std::vector<int>			mSlots;
+	HANDLES_LIST				mFreeHandles;
+
+	HANDLES_LIST				mPending;
+	HANDLES_LIST				mPolled;
+	HANDLES_LIST				mChangedRoots;
+
+	int		mFirstDirtySlot;
+	int		mDeadNum;
+	bool	mOrderDirty;
+
+	uint32	mTopologyRevision;
+
+	Stats	mStats;
+
+	static TransformHierarchy * sActive;
+};
+
+}//namespace World {
+}//namespace Squirrel {
@@ -33,6 +33,8 @@ void Water::init(const std::string& texFileName)
 
 	mMesh->calcBoundingVolume();
 
+	invalidateBounds();
+
 	size_t maskPos = texFileName.find_first_of('*');
 	if(maskPos == std::string::npos)
 	{
@@ -5,7 +5,9 @@
 #include <Reflection/XMLSerializer.h>
 #include <Reflection/XMLDeserializer.h>
 #include <FileSystem/Path.h>
+#include <Common/Profiler.h>
 #include <iomanip>
+#include <set>
 
 #define WORLD_SETTINGS_SECTION "World"
 
@@ -13,10 +15,19 @@ namespace Squirrel {
 namespace World { 
 
 World::World():
-	mUnitsInMeter(1.0f), mTerrain(NULL), mSky(NULL), mOwnsSky(false), mCenterNodePos(0, 0, 0), mCreateMissingNodes(true), mSaveNewNodes(false)
+	mUnitsInMeter(1.0f), mTerrain(NULL), mSky(NULL), mOwnsSky(false), mSceneNodesNum(0, 0, 0), mCenterNodePos(0, 0, 0), mCreateMissingNodes(true), mSaveNewNodes(false), mTransformFrame(0)
 {
 	mObjectsOwner = true;
 
+	mTransforms.reset( new TransformHierarchy() );
+	TransformHierarchy::SetActive( mTransforms.get() );
+
+	mCollisions.reset( new CollisionWorld() );
+	CollisionWorld::SetActive( mCollisions.get() );
+
+	mBehaviours.reset( new BehaviourScheduler() );
+	BehaviourScheduler::SetActive( mBehaviours.get() );
+
 	SQREFL_SET_CLASS(World::World);
 
 	wrapAtomicField("UnitsInMeter", &mUnitsInMeter);
@@ -28,6 +39,9 @@ World::~World(void)
 {
 	if(mOwnsSky)
 		DELETE_PTR(mSky);
+
+	//objects must be released before their transform hierarchy and behaviour scheduler
+	clearSceneObjects();
 }
 
 void World::init(Settings * settings)
@@ -56,28 +70,42 @@ void World::init(Settings * settings)
 	
 void World::updateTransform()
 {
-	int i, j, k;//indices
-	
-	for(i = 0; i < mSceneNodesNum.x; ++i)
+	SQ_PROFILE_ZONE("World::updateTransform");
+
+	mTransforms->update();
+
+	//only nodes containing objects with changed bounds need to be updated
+
+	std::set<SceneNode *> changedNodes;
+
+	mMovedRoots.clear();
+	++mTransformFrame;
+
+	const TransformHierarchy::HANDLES_LIST& changedRoots = mTransforms->getChangedRoots();
+	for(size_t i = 0; i < changedRoots.size(); ++i)
 	{
-		for(j = 0; j < mSceneNodesNum.y; ++j)
+		SceneObject * obj = mTransforms->getOwner(changedRoots[i]);
+		if(obj != NULL)
 		{
-			for(k = 0; k < mSceneNodesNum.z; ++k)
-			{
-				SceneNode * node = mSceneNodes[i][j][k].get();
-				if(node != NULL)
-				{
-					node->updateTransform();
-				}
-			}
+			obj->mMovedFrame = mTransformFrame;
+			mMovedRoots.push_back(obj);
+		}
+		if(obj != NULL && obj->getParentNode() != NULL)
+		{
+			changedNodes.insert(obj->getParentNode());
 		}
 	}
+
+	mTransforms->clearChangedRoots();
+
+	FOREACH(std::set<SceneNode *>::iterator, itNode, changedNodes)
+	{
+		(*itNode)->updateTransform();
+	}
 	
 	SCENE_OBJECTS_LIST::iterator itOrphan = mOrphans.begin();
 	while(itOrphan != mOrphans.end())
 	{
-		(*itOrphan)->updateTransform();
-		
 		SceneNode * newParent = (*itOrphan)->isGlobal() ? NULL : findNewParent(*itOrphan);
 		if(newParent)
 		{
@@ -89,6 +117,9 @@ void World::updateTransform()
 			++itOrphan;
 		}
 	}
+
+	//collisions use world transforms and bounds computed above
+	mCollisions->update();
 }
 
 tuple3i World::getNextNodePos(vec3 beholderPos)
@@ -117,6 +148,8 @@ tuple3i World::getNextNodePos(vec3 beholderPos)
 	
 void World::updateRecursively(float dtime)
 {
+	SQ_PROFILE_ZONE("World::updateRecursively");
+
 	Render::Camera * camera = Render::Camera::GetMainCamera();
 
 	if(mTerrain)
@@ -136,6 +169,8 @@ void World::updateRecursively(float dtime)
 		setCenter(newNodePos);
 	}
 
+	mBehaviours->update(dtime, camera->getPosition());
+
 	SceneObjectsContainer::updateRecursively(dtime);
 }
 
@@ -253,6 +288,7 @@ SceneNode * World::loadNode(tuple3i gridPos)
 		{
 			FOREACH(SCENE_OBJECTS_LIST::const_iterator, itObj, node->getSceneObjects())
 			{
+				(*itObj)->attachTransform(mTransforms.get(), NULL);
 				mSceneObjects.push_back(*itObj);
 			}
 		}
@@ -327,6 +363,8 @@ bool World::delSceneObject(SCENE_OBJECTS_LIST::const_iterator it)
 	
 void World::addSceneObject(SceneObject * sceneObj)
 {
+	sceneObj->attachTransform(mTransforms.get(), NULL);
+
 	SceneNode * newParent = sceneObj->isGlobal() ? NULL : findNewParent(sceneObj);
 	
 	if(newParent != NULL)
@@ -3,6 +3,9 @@
 #include "SceneBase.h"
 #include "SceneNode.h"
 #include "Terrain.h"
+#include "TransformHierarchy.h"
+#include "CollisionWorld.h"
+#include "BehaviourScheduler.h"
 #include <Render/IRenderable.h>
 
 namespace Squirrel {
@@ -43,8 +46,16 @@ class SQWORLD_API World:
 	bool mCreateMissingNodes;
 
 	std::auto_ptr<FileSystem::FileStorage> mContentSource;
+
+	std::auto_ptr<TransformHierarchy> mTransforms;
+	std::auto_ptr<CollisionWorld> mCollisions;
+	std::auto_ptr<BehaviourScheduler> mBehaviours;
 	
 	SCENE_OBJECTS_LIST mOrphans;
+
+	//roots which bounds were changed by last updateTransform
+	std::vector<SceneObject *> mMovedRoots;
+	uint32 mTransformFrame;
 	
 private:
 
@@ -100,7 +111,16 @@ public:
 	void setUnitsInMeter(float u) { mUnitsInMeter = u; }
 
 	Terrain * getTerrain() { return mTerrain; }
-	void setTerrain(Terrain * terra) { mTerrain = terra; }
+	void setTerrain(Terrain * terra) { mTerrain = terra; mCollisions->setTerrain(terra); }
+
+	TransformHierarchy * getTransforms() { return mTransforms.get(); }
+
+	//lets data cached across frames (e.g. shadow casters) check whether objects around it were moved,
+	//roots are valid until next updateTransform unless topology revision of transforms is changed
+	const std::vector<SceneObject *>& getMovedRoots() const { return mMovedRoots; }
+	uint32 getTransformFrame() const { return mTransformFrame; }
+	CollisionWorld * getCollisions() { return mCollisions.get(); }
+	BehaviourScheduler * getBehaviours() { return mBehaviours.get(); }
 
 	Sky * getSky() { return mSky; }
 	void setSky(Sky * sky, bool own = true) { mSky = sky; mOwnsSky = own; }
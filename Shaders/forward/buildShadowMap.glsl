@@ -9,6 +9,15 @@ attribute vec4 inPosition;
 	varying	vec2 texCoord;
 #endif
 
+#ifdef PACKED_VERTICES
+
+//dequantization of packed attributes
+uniform vec3 uPositionScale;
+uniform vec3 uPositionBias;
+uniform vec4 uTexcoordDecode;
+
+#endif
+
 uniform mat4 uMVPMatrix;
 
 #ifdef WRITE_DISTANCE
@@ -43,9 +52,15 @@ mat4 getBoneTransform ( float index )
   
 void main(void)
 {
+#ifdef PACKED_VERTICES
+	vec4 vertexPos = vec4( inPosition.xyz * uPositionScale + uPositionBias, 1.0 );
+#else
+	vec4 vertexPos = inPosition;
+#endif
+
 #ifndef SKINNING
 
-	vec3 pos = inPosition.xyz;
+	vec3 pos = vertexPos.xyz;
 
 #else
 
@@ -58,25 +73,25 @@ void main(void)
 	if ( weights.x > EPS )                      // process 1st bone
     {
         boneTransform	= getBoneTransform( indices.x );
-		pos  += ((inPosition * boneTransform) * weights.x).xyz;
+		pos  += ((vertexPos * boneTransform) * weights.x).xyz;
     }
 
 	if ( weights.y > EPS )                      // process 2nd bone
     {
         boneTransform	= getBoneTransform( indices.y );
-		pos  += ((inPosition * boneTransform) * weights.y).xyz;
+		pos  += ((vertexPos * boneTransform) * weights.y).xyz;
     }
 
 	if ( weights.z > EPS )                      // process 3rd bone
     {
         boneTransform	= getBoneTransform( indices.z );
-		pos  += ((inPosition * boneTransform) * weights.z).xyz;
+		pos  += ((vertexPos * boneTransform) * weights.z).xyz;
     }	
 
 	if ( weights.w > EPS )                      // process 4th bone
     {
 		boneTransform	= getBoneTransform( indices.w );
-		pos  += ((inPosition * boneTransform) * weights.w).xyz;
+		pos  += ((vertexPos * boneTransform) * weights.w).xyz;
     }	
 		
 #endif
@@ -88,7 +103,11 @@ void main(void)
 #endif
 
 #ifdef TEXTURE_ALPHA
+#ifdef PACKED_VERTICES
+	texCoord		= inTexcoord * uTexcoordDecode.xy + uTexcoordDecode.zw;
+#else
 	texCoord		= inTexcoord;
+#endif
 #endif
 
 	gl_Position     = uMVPMatrix * vec4 ( pos, 1.0 );
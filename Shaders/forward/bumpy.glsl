@@ -32,6 +32,23 @@ attribute vec3 inNormal;
 attribute vec2 inTexcoord;
 attribute vec4 inTangentBinormal;
 
+#ifdef PACKED_VERTICES
+
+//dequantization of packed attributes
+uniform vec3 uPositionScale;
+uniform vec3 uPositionBias;
+uniform vec4 uTexcoordDecode;
+
+vec3 octDecode ( vec2 e )
+{
+	vec3 v = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );
+	if ( v.z < 0.0 )
+		v.xy = ( 1.0 - abs( v.yx ) ) * vec2( v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0 );
+	return normalize( v );
+}
+
+#endif
+
 #ifdef SKINNING
 
 // 3x4 matrix, passed as vec4's for compatibility with GL 2.0
@@ -56,13 +73,24 @@ mat4 getBoneTransform ( float index )
 
 void main(void)
 {
+#ifdef PACKED_VERTICES
+	vec4 vertexPos = vec4( inPosition.xyz * uPositionScale + uPositionBias, 1.0 );
+	vec3 vertexNor = octDecode( inNormal.xy );
+	vec3 inTangent = octDecode( inTangentBinormal.xy );
+	float binormalMultiplier = inTangentBinormal.z < 0.0 ? -1.0 : 1.0;
+	vec2 vertexTex = inTexcoord * uTexcoordDecode.xy + uTexcoordDecode.zw;
+#else
+	vec4 vertexPos = inPosition;
+	vec3 vertexNor = inNormal;
 	vec3 inTangent = inTangentBinormal.xyz;
 	float binormalMultiplier = inTangentBinormal.w;
+	vec2 vertexTex = inTexcoord;
+#endif
 
 #ifndef SKINNING
 
-	vec3 pos = inPosition.xyz;
-	vec3 nor = inNormal;
+	vec3 pos = vertexPos.xyz;
+	vec3 nor = vertexNor;
 	vec3 tan = inTangent;
 
 #else
@@ -80,8 +108,8 @@ void main(void)
     {
         boneTransform	= getBoneTransform( indices.x );
 		boneRotation	= mat3(boneTransform[0].xyz, boneTransform[1].xyz, boneTransform[2].xyz);
-		pos  += ((inPosition * boneTransform) * weights.x).xyz;
-		nor  += (inNormal * boneRotation) * weights.x;
+		pos  += ((vertexPos * boneTransform) * weights.x).xyz;
+		nor  += (vertexNor * boneRotation) * weights.x;
 		tan  += (inTangent * boneRotation) * weights.x;
     }
 
@@ -89,8 +117,8 @@ void main(void)
     {
         boneTransform	= getBoneTransform( indices.y );
 		boneRotation	= mat3(boneTransform[0].xyz, boneTransform[1].xyz, boneTransform[2].xyz);
-		pos  += ((inPosition * boneTransform) * weights.y).xyz;
-		nor  += (inNormal * boneRotation) * weights.y;
+		pos  += ((vertexPos * boneTransform) * weights.y).xyz;
+		nor  += (vertexNor * boneRotation) * weights.y;
 		tan  += (inTangent * boneRotation) * weights.y;
     }
 
@@ -98,8 +126,8 @@ void main(void)
     {
         boneTransform	= getBoneTransform( indices.z );
 		boneRotation	= mat3(boneTransform[0].xyz, boneTransform[1].xyz, boneTransform[2].xyz);
-		pos  += ((inPosition * boneTransform) * weights.z).xyz;
-		nor  += (inNormal * boneRotation) * weights.z;
+		pos  += ((vertexPos * boneTransform) * weights.z).xyz;
+		nor  += (vertexNor * boneRotation) * weights.z;
 		tan  += (inTangent * boneRotation) * weights.z;
     }	
 
@@ -107,8 +135,8 @@ void main(void)
     {
 		boneTransform	= getBoneTransform( indices.w );
 		boneRotation	= mat3(boneTransform[0].xyz, boneTransform[1].xyz, boneTransform[2].xyz);
-		pos  += ((inPosition * boneTransform) * weights.w).xyz;
-		nor  += (inNormal * boneRotation) * weights.w;
+		pos  += ((vertexPos * boneTransform) * weights.w).xyz;
+		nor  += (vertexNor * boneRotation) * weights.w;
 		tan  += (inTangent * boneRotation) * weights.w;
     }	
 	
@@ -132,7 +160,7 @@ void main(void)
 	tangentBasis[2] = normal;
 	
 	gl_Position     = uMVPMatrix * posOS;
-	texCoord		= inTexcoord;
+	texCoord		= vertexTex;
 }
 
 #endif